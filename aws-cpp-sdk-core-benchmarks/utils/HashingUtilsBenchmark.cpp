@@ -0,0 +1,83 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#if ENABLE_OPENSSL_ENCRYPTION
+
+#include <aws/testing/Benchmark.h>
+
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/core/utils/Outcome.h>
+#include <aws/core/utils/crypto/Factories.h>
+#include <aws/core/utils/crypto/Sha256.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+using namespace Aws::Utils;
+using namespace Aws::Utils::Crypto;
+
+/**
+ * SHA256 with a provider and contexts made for every hash, as before the context pools, and through HashingUtils with pooled contexts.
+ */
+AWS_BENCHMARK(HashingContextPools)
+{
+    static const size_t HASHES = 100000;
+    const size_t messageSizes[] = { 64, 1024, 16 * 1024 };
+
+    for (size_t messageSize : messageSizes)
+    {
+        Aws::String message(messageSize, 'x');
+        double hashesPerSecond[2] = { 0, 0 };
+        double contextsPerHash[2] = { 0, 0 };
+        // best of a few runs
+        for (size_t run = 0; run < 6; ++run)
+        {
+            size_t pooled = run % 2;
+            SetCryptoContextPoolSize(pooled ? 8 : 0);
+            auto hashOnce = [&]()
+            {
+                if (pooled)
+                {
+                    HashingUtils::CalculateSHA256(message);
+                }
+                else
+                {
+                    Sha256 hash;
+                    hash.Calculate(message);
+                }
+            };
+            // the unpooled runs leave the pools empty, so the first hash of a pooled run fills them
+            hashOnce();
+            CryptoContextPoolStats before = GetThreadCryptoContextPoolStats();
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < HASHES; ++i)
+            {
+                hashOnce();
+            }
+            auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            CryptoContextPoolStats after = GetThreadCryptoContextPoolStats();
+            hashesPerSecond[pooled] = (std::max)(hashesPerSecond[pooled], HASHES / seconds);
+            contextsPerHash[pooled] = static_cast<double>(after.contextsCreated - before.contextsCreated) / HASHES;
+        }
+        SetCryptoContextPoolSize(8);
+
+        std::cout << "SHA256 of " << messageSize << " bytes: fresh providers and contexts " << static_cast<int64_t>(hashesPerSecond[0]) << " hashes/s, "
+                  << contextsPerHash[0] << " contexts created a hash; pooled " << static_cast<int64_t>(hashesPerSecond[1]) << " hashes/s, "
+                  << contextsPerHash[1] << " contexts created a hash" << std::endl;
+    }
+}
+
+#endif // ENABLE_OPENSSL_ENCRYPTION
@@ -0,0 +1,136 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/testing/Benchmark.h>
+
+#include <aws/core/utils/event/EventStreamDecoder.h>
+#include <aws/core/utils/event/EventStreamHandler.h>
+#include <aws/core/utils/event/EventHeader.h>
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+using namespace Aws::Utils;
+using namespace Aws::Utils::Event;
+
+static void AppendUInt32(Aws::Vector<unsigned char>& bytes, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        bytes.push_back(static_cast<unsigned char>(value >> shift));
+    }
+}
+
+static void AppendStringHeader(Aws::Vector<unsigned char>& headers, const Aws::String& name, const Aws::String& value)
+{
+    headers.push_back(static_cast<unsigned char>(name.size()));
+    headers.insert(headers.end(), name.begin(), name.end());
+    headers.push_back(static_cast<unsigned char>(EventHeaderValue::EventHeaderType::STRING));
+    headers.push_back(static_cast<unsigned char>(value.size() >> 8));
+    headers.push_back(static_cast<unsigned char>(value.size()));
+    headers.insert(headers.end(), value.begin(), value.end());
+}
+
+/**
+ * Appends an S3 Select records message, encoded as the service encodes it.
+ */
+static void AppendRecordsMessage(Aws::Vector<unsigned char>& stream, const Aws::String& payload)
+{
+    Aws::Vector<unsigned char> headers;
+    AppendStringHeader(headers, ":message-type", "event");
+    AppendStringHeader(headers, ":event-type", "Records");
+    AppendStringHeader(headers, ":content-type", "application/octet-stream");
+
+    size_t start = stream.size();
+    AppendUInt32(stream, static_cast<uint32_t>(12 + headers.size() + payload.size() + 4));
+    AppendUInt32(stream, static_cast<uint32_t>(headers.size()));
+    AppendUInt32(stream, HashingUtils::CalculateCRC32(stream.data() + start, 8));
+    stream.insert(stream.end(), headers.begin(), headers.end());
+    stream.insert(stream.end(), payload.begin(), payload.end());
+    AppendUInt32(stream, HashingUtils::CalculateCRC32(stream.data() + start, stream.size() - start));
+}
+
+/**
+ * Counts records bytes, taking them in place or, like the S3 Select records event, out of the message copied into it.
+ */
+class RecordsCountingHandler : public EventStreamHandler
+{
+public:
+    RecordsCountingHandler(bool inPlace) : m_inPlace(inPlace), m_recordsBytes(0) {}
+
+    bool OnMessageView(const EventMessageView& message) override
+    {
+        if (m_inPlace)
+        {
+            m_recordsBytes += message.GetPayloadLength();
+        }
+        return m_inPlace;
+    }
+
+    void OnEvent() override
+    {
+        Aws::Vector<unsigned char> records(GetEventPayloadWithOwnership());
+        m_recordsBytes += records.size();
+    }
+
+    bool m_inPlace;
+    size_t m_recordsBytes;
+};
+
+/**
+ * Decoding records messages in VIEWS mode, with the payloads copied out of the messages and taken in place.
+ */
+AWS_BENCHMARK(EventStreamDecoderViewsMode)
+{
+    static const size_t MESSAGES = 64;
+    static const size_t ROUNDS = 300;
+    const size_t payloadLengths[] = { 256, 16 * 1024 };
+    for (size_t payloadLength : payloadLengths)
+    {
+        Aws::Vector<unsigned char> stream;
+        for (size_t i = 0; i < MESSAGES; ++i)
+        {
+            AppendRecordsMessage(stream, Aws::String(payloadLength, 'r'));
+        }
+
+        double megabytesPerSecond[2] = { 0, 0 };
+        for (size_t inPlace = 0; inPlace < 2; ++inPlace)
+        {
+            RecordsCountingHandler handler(inPlace == 1);
+            EventStreamDecoder decoder(&handler, EventStreamDecodingMode::VIEWS);
+            auto start = std::chrono::steady_clock::now();
+            for (size_t round = 0; round < ROUNDS; ++round)
+            {
+                // as curl hands the response over, 16KB at a time
+                for (size_t offset = 0; offset < stream.size(); offset += 16 * 1024)
+                {
+                    decoder.Pump(stream.data() + offset, (std::min)(static_cast<size_t>(16 * 1024), stream.size() - offset));
+                }
+            }
+            auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!decoder || handler.m_recordsBytes != payloadLength * MESSAGES * ROUNDS)
+            {
+                std::cout << "Decoding failed." << std::endl;
+                return;
+            }
+            megabytesPerSecond[inPlace] = stream.size() * ROUNDS / seconds / (1024 * 1024);
+        }
+        std::cout << "Decoding records of " << payloadLength << " bytes: copied out " << static_cast<int64_t>(megabytesPerSecond[0]) << "MB/s, in place "
+                  << static_cast<int64_t>(megabytesPerSecond[1]) << "MB/s" << std::endl;
+    }
+}
@@ -0,0 +1,97 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  * 
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  * 
+  *  http://aws.amazon.com/apache2.0
+  * 
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/testing/Benchmark.h>
+
+#include <aws/core/utils/ratelimiter/DefaultRateLimiter.h>
+#include <aws/core/utils/ratelimiter/ConcurrentRateLimiter.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace Aws::Utils::RateLimits;
+
+/**
+ * Runs callsPerThread calls of call on threadCount threads and returns the elapsed seconds.
+ */
+template<typename CALL>
+static double TimeCalls(size_t threadCount, int64_t callsPerThread, const CALL& call)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    Aws::Vector<std::thread> threads;
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (int64_t n = 0; n < callsPerThread; ++n)
+            {
+                call();
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * What the limiters themselves cost when threads contend for them: the rate is high enough that they never delay.
+ */
+AWS_BENCHMARK(RateLimiterContendedCalls)
+{
+    static const int64_t RATE = static_cast<int64_t>(1) << 40;
+    static const int64_t CALLS_PER_THREAD = 20000;
+
+    for (size_t threadCount : {1, 8, 32})
+    {
+        DefaultRateLimiter<> defaultLimiter(RATE);
+        ConcurrentRateLimiter<> concurrentLimiter(RATE);
+        double calls = static_cast<double>(CALLS_PER_THREAD) * static_cast<double>(threadCount);
+
+        double defaultSeconds = TimeCalls(threadCount, CALLS_PER_THREAD, [&]() { defaultLimiter.ApplyCost(1); });
+        double concurrentSeconds = TimeCalls(threadCount, CALLS_PER_THREAD, [&]() { concurrentLimiter.ApplyCost(1); });
+
+        std::cout << threadCount << " threads: DefaultRateLimiter " << static_cast<int64_t>(calls / defaultSeconds) << " calls/s, ConcurrentRateLimiter "
+                  << static_cast<int64_t>(calls / concurrentSeconds) << " calls/s" << std::endl;
+    }
+}
+
+/**
+ * How closely a ConcurrentRateLimiter shared by many sleeping threads holds its rate, with 16KB per call as with curl callbacks.
+ */
+AWS_BENCHMARK(RateLimiterPacedThroughput)
+{
+    static const int64_t CHUNK_SIZE = 16 * 1024;
+    static const int64_t RATE = 64 * CHUNK_SIZE * 16;
+
+    for (size_t threadCount : {32, 64})
+    {
+        // two periods' worth of cost; the bucket starts full, so the first period's worth goes through at once and the rest is paced
+        const int64_t callsPerThread = 2 * RATE / CHUNK_SIZE / static_cast<int64_t>(threadCount);
+        ConcurrentRateLimiter<> limiter(RATE);
+
+        double seconds = TimeCalls(threadCount, callsPerThread, [&]() { limiter.ApplyAndPayForCost(CHUNK_SIZE); });
+        int64_t paced = callsPerThread * CHUNK_SIZE * static_cast<int64_t>(threadCount) - RATE;
+
+        std::cout << threadCount << " threads: " << static_cast<int64_t>(static_cast<double>(paced) / seconds) << " bytes/s paced against a rate of "
+                  << RATE << " bytes/s" << std::endl;
+    }
+}
@@ -24,9 +24,17 @@
 #include <aws/testing/mocks/http/MockHttpClient.h>
 #include <aws/core/utils/EnumParseOverflowContainer.h>
 #include <aws/testing/mocks/aws/client/MockAWSClient.h>
+#include <aws/core/client/DefaultHedgingStrategy.h>
+#include <aws/core/utils/threading/Executor.h>
+#include <aws/core/utils/threading/CancellationToken.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+
+#include <atomic>
+#include <thread>
 
 using Aws::Utils::DateTime;
 using Aws::Utils::DateFormat;
+using Aws::Utils::Threading::CancellationToken;
 
 static const char ALLOCATION_TAG[] = "AWSClientTest";
 
@@ -327,3 +335,426 @@ TEST(AWSClientTest, TestOverflowContainer)
     ASSERT_STREQ(enumValue, container->RetrieveOverflow(hashcode).c_str());
 }
 
+
+class AWSClientHedgingTestSuite : public ::testing::Test
+{
+protected:
+    std::shared_ptr<LatencyInjectingHttpClient> mockHttpClient;
+    std::shared_ptr<LatencyInjectingHttpClientFactory> mockHttpClientFactory;
+    Aws::UniquePtr<MockAWSClient> client;
+
+    void SetUp()
+    {
+        mockHttpClient = Aws::MakeShared<LatencyInjectingHttpClient>(ALLOCATION_TAG);
+        mockHttpClientFactory = Aws::MakeShared<LatencyInjectingHttpClientFactory>(ALLOCATION_TAG, mockHttpClient);
+        SetHttpClientFactory(mockHttpClientFactory);
+    }
+
+    void TearDown()
+    {
+        client = nullptr;
+        mockHttpClient = nullptr;
+        mockHttpClientFactory = nullptr;
+
+        CleanupHttp();
+        InitHttp();
+    }
+
+    void CreateClient(const Aws::Vector<Aws::String>& hedgedOperations, const std::shared_ptr<HedgingStrategy>& hedgingStrategy = nullptr,
+                      const std::shared_ptr<Aws::Utils::Threading::Executor>& executor = nullptr)
+    {
+        ClientConfiguration config;
+        config.scheme = Scheme::HTTP;
+        auto countedRetryStrategy = Aws::MakeShared<CountedRetryStrategy>(ALLOCATION_TAG);
+        config.retryStrategy = std::static_pointer_cast<DefaultRetryStrategy>(countedRetryStrategy);
+        config.hedgingStrategy = hedgingStrategy ? hedgingStrategy : Aws::MakeShared<DefaultHedgingStrategy>(ALLOCATION_TAG, hedgedOperations, 50, 0.0);
+        if (executor)
+        {
+            config.executor = executor;
+        }
+        client = Aws::MakeUnique<MockAWSClient>(ALLOCATION_TAG, config);
+    }
+};
+
+// counts the tasks submitted to it before running them as the DefaultExecutor would
+class CountingExecutor : public Aws::Utils::Threading::DefaultExecutor
+{
+public:
+    CountingExecutor() : m_submitted(0) {}
+
+    std::atomic<size_t> m_submitted;
+
+protected:
+    bool SubmitToThread(std::function<void()>&& task) override
+    {
+        ++m_submitted;
+        return DefaultExecutor::SubmitToThread(std::move(task));
+    }
+};
+
+// keeps the latencies the client reports
+class LatencyRecordingHedgingStrategy : public DefaultHedgingStrategy
+{
+public:
+    LatencyRecordingHedgingStrategy(const Aws::Vector<Aws::String>& operations) : DefaultHedgingStrategy(operations, 50, 0.0) {}
+
+    void RequestCompleted(const AmazonWebServiceRequest& request, long latencyMs, bool succeeded) override
+    {
+        m_latencies.push_back(latencyMs);
+        DefaultHedgingStrategy::RequestCompleted(request, latencyMs, succeeded);
+    }
+
+    Aws::Vector<long> m_latencies;
+};
+
+TEST_F(AWSClientHedgingTestSuite, TestHedgeWinsOverSlowPrimary)
+{
+    CreateClient({"AmazonWebServiceRequestMock"});
+    mockHttpClient->AddResponse(std::chrono::milliseconds(2000));
+    mockHttpClient->AddResponse(std::chrono::milliseconds(0));
+
+    AmazonWebServiceRequestMock request;
+    auto start = std::chrono::steady_clock::now();
+    auto outcome = client->MakeRequest(request);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(outcome.IsSuccess());
+    ASSERT_EQ("1", outcome.GetResult()->GetHeader("x-mock-request-index"));
+    ASSERT_EQ(2u, mockHttpClient->GetRequestsMade());
+    ASSERT_TRUE(elapsed < std::chrono::milliseconds(1000));
+    ASSERT_EQ(0, client->GetRequestAttemptedRetries());
+}
+
+TEST_F(AWSClientHedgingTestSuite, TestHedgeBodyLandsInCallerStream)
+{
+    static const char BODY[] = "0123456789abcdefghij";
+    CreateClient({"AmazonWebServiceRequestMock"});
+    // the primary gets the first half of its body out before it stalls; the hedge answers at once
+    mockHttpClient->AddResponse(std::chrono::milliseconds(2000), HttpResponseCode::OK, BODY);
+    mockHttpClient->AddResponse(std::chrono::milliseconds(0), HttpResponseCode::OK, BODY);
+
+    // every stream the factory makes writes into the one stream the caller supplied
+    Aws::StringStream callerStream;
+    std::atomic<size_t> streamsMade(0);
+    long long bytesReceived = 0;
+    size_t retries = 0;
+    AmazonWebServiceRequestMock request;
+    request.SetResponseStreamFactory([&]()
+    {
+        ++streamsMade;
+        return Aws::New<Aws::IOStream>(ALLOCATION_TAG, callerStream.rdbuf());
+    });
+    request.SetDataReceivedEventHandler([&](const HttpRequest*, HttpResponse*, long long amount) { bytesReceived += amount; });
+    request.SetRequestRetryHandler([&](const AmazonWebServiceRequest&)
+    {
+        bytesReceived = 0;
+        ++retries;
+    });
+
+    auto outcome = client->MakeRequest(request);
+    ASSERT_TRUE(outcome.IsSuccess());
+    ASSERT_EQ("1", outcome.GetResult()->GetHeader("x-mock-request-index"));
+    ASSERT_EQ(2u, mockHttpClient->GetRequestsMade());
+
+    // the hedge read into a stream of its own, and its body replaced the half the primary had written
+    ASSERT_EQ(2u, streamsMade.load());
+    ASSERT_EQ(BODY, callerStream.str());
+
+    // the primary's data was discarded as for a failed attempt, then the hedge's was reported
+    ASSERT_EQ(1u, retries);
+    ASSERT_EQ(static_cast<long long>(sizeof(BODY) - 1), bytesReceived);
+}
+
+TEST_F(AWSClientHedgingTestSuite, TestFastPrimaryIsNotHedged)
+{
+    CreateClient({"AmazonWebServiceRequestMock"});
+    mockHttpClient->AddResponse(std::chrono::milliseconds(0));
+    mockHttpClient->AddResponse(std::chrono::milliseconds(0));
+
+    AmazonWebServiceRequestMock request;
+    auto outcome = client->MakeRequest(request);
+    ASSERT_TRUE(outcome.IsSuccess());
+    ASSERT_EQ("0", outcome.GetResult()->GetHeader("x-mock-request-index"));
+
+    // the hedge would have been sent after 50ms; give it plenty of time to (not) show up
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_EQ(1u, mockHttpClient->GetRequestsMade());
+}
+
+TEST_F(AWSClientHedgingTestSuite, TestExecutorOnlyRunsDueHedges)
+{
+    auto executor = Aws::MakeShared<CountingExecutor>(ALLOCATION_TAG);
+    CreateClient({"AmazonWebServiceRequestMock"}, nullptr, executor);
+    for (int i = 0; i < 10; ++i)
+    {
+        mockHttpClient->AddResponse(std::chrono::milliseconds(0));
+    }
+    mockHttpClient->AddResponse(std::chrono::milliseconds(500));
+    mockHttpClient->AddResponse(std::chrono::milliseconds(0));
+
+    AmazonWebServiceRequestMock request;
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(client->MakeRequest(request).IsSuccess());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // fast requests leave their hedges to the timer, which drops them once they are due
+    ASSERT_EQ(0u, executor->m_submitted.load());
+
+    ASSERT_TRUE(client->MakeRequest(request).IsSuccess());
+    ASSERT_EQ(1u, executor->m_submitted.load());
+}
+
+TEST_F(AWSClientHedgingTestSuite, TestHedgeLatencyCountsFromOriginalRequest)
+{
+    auto hedgingStrategy = Aws::MakeShared<LatencyRecordingHedgingStrategy>(ALLOCATION_TAG, Aws::Vector<Aws::String>({"AmazonWebServiceRequestMock"}));
+    CreateClient({}, hedgingStrategy);
+    mockHttpClient->AddResponse(std::chrono::milliseconds(2000));
+    mockHttpClient->AddResponse(std::chrono::milliseconds(0));
+
+    AmazonWebServiceRequestMock request;
+    auto outcome = client->MakeRequest(request);
+    ASSERT_TRUE(outcome.IsSuccess());
+    ASSERT_EQ("1", outcome.GetResult()->GetHeader("x-mock-request-index"));
+
+    // the hedge answered at once, but only after the 50ms hedge delay
+    ASSERT_EQ(1u, hedgingStrategy->m_latencies.size());
+    ASSERT_TRUE(hedgingStrategy->m_latencies[0] >= 50);
+    ASSERT_TRUE(hedgingStrategy->m_latencies[0] < 1000);
+}
+
+TEST_F(AWSClientHedgingTestSuite, TestOperationNotListedIsNotHedged)
+{
+    CreateClient({"SomeOtherOperation"});
+    mockHttpClient->AddResponse(std::chrono::milliseconds(200));
+    mockHttpClient->AddResponse(std::chrono::milliseconds(0));
+
+    AmazonWebServiceRequestMock request;
+    auto outcome = client->MakeRequest(request);
+    ASSERT_TRUE(outcome.IsSuccess());
+    ASSERT_EQ("0", outcome.GetResult()->GetHeader("x-mock-request-index"));
+    ASSERT_EQ(1u, mockHttpClient->GetRequestsMade());
+}
+
+TEST(DefaultHedgingStrategyTest, TestHedgeBudget)
+{
+    DefaultHedgingStrategy strategy({"AmazonWebServiceRequestMock"}, 50, 0.0, 0.05);
+    AmazonWebServiceRequestMock request;
+
+    // the budget starts with room for a burst of 10 hedges
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(strategy.AcquireHedge());
+    }
+    ASSERT_FALSE(strategy.AcquireHedge());
+
+    // at 5%, every 20 requests earn one more hedge
+    for (int i = 0; i < 19; ++i)
+    {
+        strategy.RequestCompleted(request, 10, true);
+    }
+    ASSERT_FALSE(strategy.AcquireHedge());
+    strategy.RequestCompleted(request, 10, true);
+    ASSERT_TRUE(strategy.AcquireHedge());
+    ASSERT_FALSE(strategy.AcquireHedge());
+}
+
+TEST(DefaultHedgingStrategyTest, TestHedgeDelayFollowsLatencyPercentile)
+{
+    DefaultHedgingStrategy strategy({"AmazonWebServiceRequestMock"}, 50, 0.9, 0.05);
+    AmazonWebServiceRequestMock request;
+
+    ASSERT_TRUE(strategy.ShouldHedge(request, HttpMethod::HTTP_GET));
+    ASSERT_TRUE(strategy.ShouldHedge(request, HttpMethod::HTTP_HEAD));
+    // writes are never hedged, even for a listed operation
+    ASSERT_FALSE(strategy.ShouldHedge(request, HttpMethod::HTTP_POST));
+    ASSERT_FALSE(strategy.ShouldHedge(request, HttpMethod::HTTP_PUT));
+    ASSERT_EQ(50, strategy.CalculateHedgeDelay(request));
+
+    // latencies of 1..100ms put the 90th percentile around 91ms
+    for (long latency = 1; latency <= 100; ++latency)
+    {
+        strategy.RequestCompleted(request, latency, true);
+    }
+    long delay = strategy.CalculateHedgeDelay(request);
+    ASSERT_TRUE(delay >= 85 && delay <= 95);
+
+    // failures are not sampled
+    for (int i = 0; i < 100; ++i)
+    {
+        strategy.RequestCompleted(request, 1000, false);
+    }
+    ASSERT_EQ(delay, strategy.CalculateHedgeDelay(request));
+
+    // the fixed delay is a floor for the percentile
+    DefaultHedgingStrategy fastStrategy({"AmazonWebServiceRequestMock"}, 50, 0.9, 0.05);
+    for (int i = 0; i < 100; ++i)
+    {
+        fastStrategy.RequestCompleted(request, 5, true);
+    }
+    ASSERT_EQ(50, fastStrategy.CalculateHedgeDelay(request));
+}
+
+// retries everything after a fixed delay, so only the cancellation token can end the request
+class AlwaysRetryStrategy : public CountedRetryStrategy
+{
+public:
+    AlwaysRetryStrategy(long delayMs) : m_delayMs(delayMs) {}
+
+    bool ShouldRetry(const AWSError<CoreErrors>& error, long attemptedRetries) const override
+    {
+        AWS_UNREFERENCED_PARAM(error);
+        return CountedRetryStrategy::ShouldRetry(AWSError<CoreErrors>(CoreErrors::SERVICE_UNAVAILABLE, true), attemptedRetries);
+    }
+
+    long CalculateDelayBeforeNextRetry(const AWSError<CoreErrors>& error, long attemptedRetries) const override
+    {
+        AWS_UNREFERENCED_PARAM(error);
+        AWS_UNREFERENCED_PARAM(attemptedRetries);
+        return m_delayMs;
+    }
+
+private:
+    long m_delayMs;
+};
+
+class AWSClientCancellationTestSuite : public ::testing::Test
+{
+protected:
+    std::shared_ptr<LatencyInjectingHttpClient> mockHttpClient;
+    std::shared_ptr<LatencyInjectingHttpClientFactory> mockHttpClientFactory;
+    Aws::UniquePtr<MockAWSClient> client;
+
+    void SetUp()
+    {
+        mockHttpClient = Aws::MakeShared<LatencyInjectingHttpClient>(ALLOCATION_TAG);
+        mockHttpClientFactory = Aws::MakeShared<LatencyInjectingHttpClientFactory>(ALLOCATION_TAG, mockHttpClient);
+        SetHttpClientFactory(mockHttpClientFactory);
+    }
+
+    void TearDown()
+    {
+        client = nullptr;
+        mockHttpClient = nullptr;
+        mockHttpClientFactory = nullptr;
+
+        CleanupHttp();
+        InitHttp();
+    }
+
+    void CreateClient(long retryDelayMs)
+    {
+        ClientConfiguration config;
+        config.scheme = Scheme::HTTP;
+        auto retryStrategy = Aws::MakeShared<AlwaysRetryStrategy>(ALLOCATION_TAG, retryDelayMs);
+        config.retryStrategy = std::static_pointer_cast<DefaultRetryStrategy>(retryStrategy);
+        client = Aws::MakeUnique<MockAWSClient>(ALLOCATION_TAG, config);
+    }
+};
+
+TEST_F(AWSClientCancellationTestSuite, TestCancelledRequestIsNotSent)
+{
+    CreateClient(10);
+    AmazonWebServiceRequestMock request;
+    auto token = Aws::MakeShared<CancellationToken>(ALLOCATION_TAG);
+    token->Cancel();
+    request.SetCancellationToken(token);
+
+    auto outcome = client->MakeRequest(request);
+    ASSERT_FALSE(outcome.IsSuccess());
+    ASSERT_EQ(CoreErrors::REQUEST_CANCELLED, outcome.GetError().GetErrorType());
+    ASSERT_EQ(0u, mockHttpClient->GetRequestsMade());
+}
+
+TEST_F(AWSClientCancellationTestSuite, TestDeadlineBoundsRetries)
+{
+    CreateClient(100);
+    for (int i = 0; i < 20; ++i)
+    {
+        mockHttpClient->AddResponse(std::chrono::milliseconds(50), HttpResponseCode::SERVICE_UNAVAILABLE);
+    }
+
+    AmazonWebServiceRequestMock request;
+    request.SetCancellationToken(Aws::MakeShared<CancellationToken>(ALLOCATION_TAG, std::chrono::milliseconds(400)));
+    auto start = std::chrono::steady_clock::now();
+    auto outcome = client->MakeRequest(request);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_FALSE(outcome.IsSuccess());
+    ASSERT_TRUE(elapsed < std::chrono::milliseconds(1000));
+    ASSERT_TRUE(mockHttpClient->GetRequestsMade() >= 2u);
+    ASSERT_TRUE(mockHttpClient->GetRequestsMade() <= 4u);
+}
+
+TEST_F(AWSClientCancellationTestSuite, TestCancelInFlightRequest)
+{
+    CreateClient(10);
+    mockHttpClient->AddResponse(std::chrono::milliseconds(10000));
+
+    AmazonWebServiceRequestMock request;
+    auto token = Aws::MakeShared<CancellationToken>(ALLOCATION_TAG);
+    request.SetCancellationToken(token);
+    std::thread canceller([token]
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        token->Cancel();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    auto outcome = client->MakeRequest(request);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    canceller.join();
+
+    ASSERT_FALSE(outcome.IsSuccess());
+    ASSERT_EQ(CoreErrors::REQUEST_CANCELLED, outcome.GetError().GetErrorType());
+    ASSERT_TRUE(elapsed < std::chrono::milliseconds(5000));
+    ASSERT_EQ(1u, mockHttpClient->GetRequestsMade());
+}
+
+TEST_F(AWSClientCancellationTestSuite, TestCancelDuringRetrySleep)
+{
+    CreateClient(10000);
+    mockHttpClient->AddResponse(std::chrono::milliseconds(0), HttpResponseCode::SERVICE_UNAVAILABLE);
+
+    AmazonWebServiceRequestMock request;
+    auto token = Aws::MakeShared<CancellationToken>(ALLOCATION_TAG);
+    request.SetCancellationToken(token);
+    std::thread canceller([token]
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        token->Cancel();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    auto outcome = client->MakeRequest(request);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    canceller.join();
+
+    ASSERT_FALSE(outcome.IsSuccess());
+    ASSERT_EQ(CoreErrors::REQUEST_CANCELLED, outcome.GetError().GetErrorType());
+    ASSERT_TRUE(elapsed < std::chrono::milliseconds(5000));
+    ASSERT_EQ(1u, mockHttpClient->GetRequestsMade());
+}
+
+TEST_F(AWSClientCancellationTestSuite, TestDisableRequestProcessingWakesRetrySleep)
+{
+    CreateClient(10000);
+    mockHttpClient->AddResponse(std::chrono::milliseconds(0), HttpResponseCode::SERVICE_UNAVAILABLE);
+
+    AmazonWebServiceRequestMock request;
+    request.SetCancellationToken(Aws::MakeShared<CancellationToken>(ALLOCATION_TAG));
+    std::thread disabler([this]
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        mockHttpClient->DisableRequestProcessing();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    client->MakeRequest(request);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    disabler.join();
+
+    // the 10s retry sleep was cut short
+    ASSERT_TRUE(elapsed < std::chrono::milliseconds(5000));
+    ASSERT_TRUE(mockHttpClient->GetRequestsMade() >= 2u);
+}
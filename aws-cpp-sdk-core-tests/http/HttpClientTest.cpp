@@ -19,6 +19,17 @@
 #include <aws/core/http/HttpClientFactory.h>
 #include <aws/core/http/HttpClient.h>
 #include <aws/core/client/ClientConfiguration.h>
+#include <aws/core/platform/Environment.h>
+#include <aws/core/platform/FileSystem.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+#include <aws/core/utils/ratelimiter/DefaultRateLimiter.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
 
 using namespace Aws::Http;
 TEST(HttpClientTest, TestNullResponse)
@@ -29,3 +40,249 @@ TEST(HttpClientTest, TestNullResponse)
 	auto response = httpClient->MakeRequest(request);
 	ASSERT_EQ(nullptr, response);
 }
+
+TEST(HttpClientTest, TestNullResponseWithHttp2Multiplexing)
+{
+    Aws::Client::ClientConfiguration config;
+    config.enableHttp2Multiplexing = true;
+    config.maxConnections = 2;
+    config.maxConcurrentStreams = 4;
+    auto httpClient = CreateHttpClient(config);
+
+    // more requests than the connections and streams allow, so some have to wait their turn
+    const size_t requestCount = 12;
+    Aws::Vector<std::shared_ptr<HttpResponse>> responses(requestCount);
+    Aws::Vector<std::thread> threads;
+    for (size_t i = 0; i < requestCount; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            auto request = CreateHttpRequest(Aws::String("http://some.unknown1234xxx.test.aws"),
+                HttpMethod::HTTP_GET, Aws::Utils::Stream::DefaultResponseStreamFactoryMethod);
+            responses[i] = httpClient->MakeRequest(request);
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (const auto& response : responses)
+    {
+        ASSERT_EQ(nullptr, response);
+    }
+}
+
+namespace
+{
+// These tests need an HTTP/2 server that serves the files of a directory, such as `nghttpd -d <directory> <port> <key file> <cert file>`.
+// Set AWS_TEST_HTTP2_ENDPOINT to its address (https://localhost:<port>) and AWS_TEST_HTTP2_DOCROOT to the directory, otherwise they do nothing.
+// The server's certificate isn't verified. Cleartext HTTP/2 works as well, but some libcurl versions can't reuse its connections.
+static const char HTTP2_ENDPOINT_ENV_VAR[] = "AWS_TEST_HTTP2_ENDPOINT";
+static const char HTTP2_DOCROOT_ENV_VAR[] = "AWS_TEST_HTTP2_DOCROOT";
+static const char HTTP2_FILE_NAME[] = "HttpClientTestHttp2Object";
+static const size_t HTTP2_FILE_SIZE = 1024 * 1024;
+
+class Http2MultiplexingTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_endpoint = Aws::Environment::GetEnv(HTTP2_ENDPOINT_ENV_VAR);
+        m_docRoot = Aws::Environment::GetEnv(HTTP2_DOCROOT_ENV_VAR);
+        if (!IsEnabled())
+        {
+            return;
+        }
+
+        m_fileContent.resize(HTTP2_FILE_SIZE);
+        for (size_t i = 0; i < m_fileContent.size(); ++i)
+        {
+            m_fileContent[i] = static_cast<char>('a' + (i * 31) % 26);
+        }
+        Aws::OFStream file(GetFilePath().c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        file.write(m_fileContent.data(), static_cast<std::streamsize>(m_fileContent.size()));
+    }
+
+    void TearDown() override
+    {
+        if (IsEnabled())
+        {
+            Aws::FileSystem::RemoveFileIfExists(GetFilePath().c_str());
+        }
+    }
+
+    bool IsEnabled() const
+    {
+        return !m_endpoint.empty() && !m_docRoot.empty();
+    }
+
+    Aws::String GetFilePath() const
+    {
+        return m_docRoot + Aws::FileSystem::PATH_DELIM + HTTP2_FILE_NAME;
+    }
+
+    std::shared_ptr<HttpClient> CreateClient(unsigned maxConnections) const
+    {
+        Aws::Client::ClientConfiguration config;
+        config.verifySSL = false;
+        config.enableHttp2Multiplexing = true;
+        config.maxConnections = maxConnections;
+        config.maxConcurrentStreams = 16;
+        config.requestTimeoutMs = 30000;
+        return CreateHttpClient(config);
+    }
+
+    std::shared_ptr<HttpRequest> CreateRequest(HttpMethod method) const
+    {
+        return CreateHttpRequest(m_endpoint + "/" + HTTP2_FILE_NAME, method, Aws::Utils::Stream::DefaultResponseStreamFactoryMethod);
+    }
+
+    static Aws::String GetBody(HttpResponse& response)
+    {
+        Aws::StringStream body;
+        body << response.GetResponseBody().rdbuf();
+        return body.str();
+    }
+
+    void ExpectDownloaded(const std::shared_ptr<HttpResponse>& response) const
+    {
+        ASSERT_NE(nullptr, response);
+        ASSERT_EQ(HttpResponseCode::OK, response->GetResponseCode());
+        ASSERT_TRUE(GetBody(*response) == m_fileContent);
+    }
+
+    Aws::String m_endpoint;
+    Aws::String m_docRoot;
+    Aws::String m_fileContent;
+};
+
+TEST_F(Http2MultiplexingTest, TestDownloadAndUpload)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+    auto httpClient = CreateClient(1);
+
+    auto request = CreateRequest(HttpMethod::HTTP_GET);
+    auto response = httpClient->MakeRequest(request);
+    ExpectDownloaded(response);
+    const auto& metrics = request->GetRequestMetrics();
+    auto version = metrics.find(Aws::Monitoring::GetHttpClientMetricNameByType(Aws::Monitoring::HttpClientMetricsType::HttpVersion));
+    ASSERT_NE(metrics.end(), version);
+    ASSERT_EQ(20, version->second);
+    ASSERT_NE(metrics.end(), metrics.find(Aws::Monitoring::GetHttpClientMetricNameByType(Aws::Monitoring::HttpClientMetricsType::MultiplexedRequestsInFlight)));
+
+    // the server answers a POST with the file as well, but has to take the whole body first
+    auto upload = CreateRequest(HttpMethod::HTTP_POST);
+    auto body = Aws::MakeShared<Aws::StringStream>("HttpClientTest", m_fileContent);
+    upload->AddContentBody(body);
+    upload->SetContentLength(Aws::Utils::StringUtils::to_string(m_fileContent.size()));
+    long long bytesSent = 0;
+    upload->SetDataSentEventHandler([&bytesSent](const HttpRequest*, long long amount) { bytesSent += amount; });
+    ExpectDownloaded(httpClient->MakeRequest(upload));
+    ASSERT_EQ(static_cast<long long>(m_fileContent.size()), bytesSent);
+}
+
+TEST_F(Http2MultiplexingTest, TestThrottledStreamDoesNotHoldUpOthers)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+    // a single connection, so every request is a stream on it
+    auto httpClient = CreateClient(1);
+
+    // the throttled download takes about 4 seconds
+    Aws::Utils::RateLimits::DefaultRateLimiter<> readLimiter(HTTP2_FILE_SIZE / 4);
+    std::atomic<long long> throttledBytes(0);
+    std::atomic<bool> throttledDone(false);
+    std::shared_ptr<HttpResponse> throttledResponse;
+    auto throttledRequest = CreateRequest(HttpMethod::HTTP_GET);
+    throttledRequest->SetDataReceivedEventHandler([&throttledBytes](const HttpRequest*, HttpResponse*, long long amount) { throttledBytes += amount; });
+    std::thread throttled([&]()
+    {
+        throttledResponse = httpClient->MakeRequest(throttledRequest, &readLimiter);
+        throttledDone = true;
+    });
+    while (throttledBytes == 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    const size_t requestCount = 8;
+    Aws::Vector<std::shared_ptr<HttpResponse>> responses(requestCount);
+    Aws::Vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requestCount; ++i)
+    {
+        threads.emplace_back([&, i]() { responses[i] = httpClient->MakeRequest(CreateRequest(HttpMethod::HTTP_GET)); });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    bool throttledDoneFirst = throttledDone;
+    throttled.join();
+
+    ASSERT_FALSE(throttledDoneFirst);
+    ASSERT_TRUE(elapsed < std::chrono::seconds(2));
+    for (const auto& response : responses)
+    {
+        ExpectDownloaded(response);
+    }
+    ExpectDownloaded(throttledResponse);
+}
+
+TEST_F(Http2MultiplexingTest, TestContinueRequestHandlerRunsOnRequestingThread)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+    auto httpClient = CreateClient(1);
+
+    // slow enough that the handler is also asked while no data flows
+    Aws::Utils::RateLimits::DefaultRateLimiter<> readLimiter(HTTP2_FILE_SIZE * 2);
+    size_t calls = 0;
+    bool otherThreadCalled = false;
+    const std::thread::id requestingThread = std::this_thread::get_id();
+    auto request = CreateRequest(HttpMethod::HTTP_GET);
+    request->SetContinueRequestHandle([&](const HttpRequest*)
+    {
+        ++calls;
+        otherThreadCalled = otherThreadCalled || std::this_thread::get_id() != requestingThread;
+        return true;
+    });
+
+    ExpectDownloaded(httpClient->MakeRequest(request, &readLimiter));
+    ASSERT_LT(0u, calls);
+    ASSERT_FALSE(otherThreadCalled);
+}
+
+TEST_F(Http2MultiplexingTest, TestCancelMultiplexedRequest)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+    auto httpClient = CreateClient(1);
+
+    Aws::Utils::RateLimits::DefaultRateLimiter<> readLimiter(HTTP2_FILE_SIZE / 4);
+    std::atomic<bool> cancelled(false);
+    auto request = CreateRequest(HttpMethod::HTTP_GET);
+    request->SetDataReceivedEventHandler([&cancelled](const HttpRequest*, HttpResponse*, long long) { cancelled = true; });
+    request->SetContinueRequestHandle([&cancelled](const HttpRequest*) { return !cancelled; });
+
+    auto start = std::chrono::steady_clock::now();
+    auto response = httpClient->MakeRequest(request, &readLimiter);
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+    ASSERT_NE(nullptr, response);
+    ASSERT_EQ(HttpResponseCode::REQUEST_NOT_MADE, response->GetResponseCode());
+
+    // the connection is still good for the next request
+    ExpectDownloaded(httpClient->MakeRequest(CreateRequest(HttpMethod::HTTP_GET)));
+}
+}
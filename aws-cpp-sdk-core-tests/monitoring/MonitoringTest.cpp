@@ -322,6 +322,8 @@ TEST_F(MonitoringTestSuite, TestHttpClientMetrics)
     ASSERT_EQ(HttpClientMetricsType::DnsLatency, GetHttpClientMetricTypeByName("DnsLatency"));
     ASSERT_EQ(HttpClientMetricsType::TcpLatency, GetHttpClientMetricTypeByName("TcpLatency"));
     ASSERT_EQ(HttpClientMetricsType::SslLatency, GetHttpClientMetricTypeByName("SslLatency"));
+    ASSERT_EQ(HttpClientMetricsType::HttpVersion, GetHttpClientMetricTypeByName("HttpVersion"));
+    ASSERT_EQ(HttpClientMetricsType::MultiplexedRequestsInFlight, GetHttpClientMetricTypeByName("MultiplexedRequestsInFlight"));
     ASSERT_EQ(HttpClientMetricsType::Unknown, GetHttpClientMetricTypeByName("Unknown"));
     ASSERT_EQ(HttpClientMetricsType::Unknown, GetHttpClientMetricTypeByName("RandomMetricsUnknown"));
 
@@ -333,5 +335,7 @@ TEST_F(MonitoringTestSuite, TestHttpClientMetrics)
     ASSERT_STREQ("DnsLatency", GetHttpClientMetricNameByType(HttpClientMetricsType::DnsLatency).c_str());
     ASSERT_STREQ("TcpLatency", GetHttpClientMetricNameByType(HttpClientMetricsType::TcpLatency).c_str());
     ASSERT_STREQ("SslLatency", GetHttpClientMetricNameByType(HttpClientMetricsType::SslLatency).c_str());
+    ASSERT_STREQ("HttpVersion", GetHttpClientMetricNameByType(HttpClientMetricsType::HttpVersion).c_str());
+    ASSERT_STREQ("MultiplexedRequestsInFlight", GetHttpClientMetricNameByType(HttpClientMetricsType::MultiplexedRequestsInFlight).c_str());
     ASSERT_STREQ("Unknown", GetHttpClientMetricNameByType(HttpClientMetricsType::Unknown).c_str());
 }
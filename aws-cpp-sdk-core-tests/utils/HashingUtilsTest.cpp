@@ -17,9 +17,16 @@
 
 #include <aws/core/utils/HashingUtils.h>
 #include <aws/core/utils/memory/stl/AWSStringStream.h>
+#include <aws/core/utils/crypto/Factories.h>
+#include <aws/core/utils/crypto/Cipher.h>
+#include <aws/core/utils/crypto/Sha256.h>
+#include <aws/core/utils/crypto/Sha256HMAC.h>
+#include <aws/core/utils/crypto/MD5.h>
+#include <thread>
 
 
 using namespace Aws::Utils;
+using namespace Aws::Utils::Crypto;
 
 TEST(HashingUtilsTest, TestBase64Encoding)
 {
@@ -321,3 +328,126 @@ TEST(HashingUtilsTest, TestMD5FromStream)
     TestMD5FromStream( "12345678901234567890123456789012345678901234567890123456789012345678901234567890", "V+30oivjyVWsSdouIQe2eg==" );
 }
 
+TEST(HashingUtilsTest, TestCRC32)
+{
+    const unsigned char check[] = "123456789";
+    ASSERT_EQ(0xCBF43926u, HashingUtils::CalculateCRC32(check, 9));
+    ASSERT_EQ(0u, HashingUtils::CalculateCRC32(check, 0));
+
+    // bit at a time, to check the table and carry-less multiply versions against, at every alignment and past their block sizes
+    auto reference = [](const unsigned char* data, size_t length)
+    {
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < length; ++i)
+        {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    };
+
+    Aws::Vector<unsigned char> data(1024 + 16);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<unsigned char>(i * 131 + (i >> 3));
+    }
+    for (size_t length = 0; length <= 1024; length += (length < 160 ? 1 : 37))
+    {
+        for (size_t offset = 0; offset < 16; offset += 5)
+        {
+            uint32_t expected = reference(data.data() + offset, length);
+            ASSERT_EQ(expected, HashingUtils::CalculateCRC32(data.data() + offset, length));
+            uint32_t head = HashingUtils::CalculateCRC32(data.data() + offset, length / 3);
+            ASSERT_EQ(expected, HashingUtils::CalculateCRC32(data.data() + offset + length / 3, length - length / 3, head));
+        }
+    }
+}
+
+
+TEST(HashingUtilsTest, TestThreadProvidersMatchFreshOnes)
+{
+    Aws::String message = "The quick brown fox jumps over the lazy dog";
+    ByteBuffer secret((unsigned char*)"key", 3);
+
+    Sha256 sha256;
+    MD5 md5;
+    Sha256HMAC sha256HMAC;
+    ByteBuffer expectedSha256 = sha256.Calculate(message).GetResult();
+    ByteBuffer expectedMD5 = md5.Calculate(message).GetResult();
+    ByteBuffer expectedHMAC = sha256HMAC.Calculate(ByteBuffer((unsigned char*)message.c_str(), message.size()), secret).GetResult();
+
+    // twice on this thread, so the second round runs on the thread's providers and pooled contexts, then on a thread of its own
+    for (size_t round = 0; round < 2; ++round)
+    {
+        ASSERT_EQ(expectedSha256, HashingUtils::CalculateSHA256(message));
+        ASSERT_EQ(expectedMD5, HashingUtils::CalculateMD5(message));
+        ASSERT_EQ(expectedHMAC, HashingUtils::CalculateSHA256HMAC(ByteBuffer((unsigned char*)message.c_str(), message.size()), secret));
+    }
+
+    bool otherThreadMatches = false;
+    std::thread otherThread([&]()
+    {
+        otherThreadMatches = expectedSha256 == HashingUtils::CalculateSHA256(message) && expectedMD5 == HashingUtils::CalculateMD5(message);
+    });
+    otherThread.join();
+    ASSERT_TRUE(otherThreadMatches);
+}
+
+#if ENABLE_OPENSSL_ENCRYPTION
+TEST(HashingUtilsTest, TestHashesAndCiphersReusePooledContexts)
+{
+    Aws::String message = "The quick brown fox jumps over the lazy dog";
+    ByteBuffer secret((unsigned char*)"key", 3);
+    CryptoBuffer key = SymmetricCipher::GenerateKey();
+    static const size_t ROUNDS = 1000;
+
+    auto runRound = [&]()
+    {
+        HashingUtils::CalculateSHA256(message);
+        HashingUtils::CalculateMD5(message);
+        HashingUtils::CalculateSHA256HMAC(ByteBuffer((unsigned char*)message.c_str(), message.size()), secret);
+        auto cipher = CreateAES_CTRImplementation(key);
+        cipher->EncryptBuffer(CryptoBuffer((unsigned char*)message.c_str(), message.size()));
+    };
+
+    runRound();
+    CryptoContextPoolStats before = GetThreadCryptoContextPoolStats();
+    for (size_t round = 0; round < ROUNDS; ++round)
+    {
+        runRound();
+    }
+    CryptoContextPoolStats after = GetThreadCryptoContextPoolStats();
+    ASSERT_EQ(before.contextsCreated, after.contextsCreated);
+    // a digest, an HMAC and the cipher's encryptor and decryptor contexts a round
+    ASSERT_EQ(before.contextsReused + 5 * ROUNDS, after.contextsReused);
+
+    SetCryptoContextPoolSize(0);
+    for (size_t round = 0; round < ROUNDS; ++round)
+    {
+        runRound();
+    }
+    SetCryptoContextPoolSize(8);
+    CryptoContextPoolStats unpooled = GetThreadCryptoContextPoolStats();
+    // the pools still hand out what they held, then every context is a new one
+    ASSERT_GE(unpooled.contextsCreated, after.contextsCreated + 5 * (ROUNDS - 1));
+}
+
+TEST(HashingUtilsTest, TestCleanupCryptoFreesTheCallingThreadsPools)
+{
+    Aws::String message = "The quick brown fox jumps over the lazy dog";
+    HashingUtils::CalculateSHA256(message);
+    HashingUtils::CalculateSHA256(message);
+    CryptoContextPoolStats pooled = GetThreadCryptoContextPoolStats();
+
+    CleanupCrypto();
+    InitCrypto();
+    HashingUtils::CalculateSHA256(message);
+    CryptoContextPoolStats reinitialized = GetThreadCryptoContextPoolStats();
+    // the digest context pooled before the cleanup is gone, so the first hash after it creates one
+    ASSERT_EQ(pooled.contextsCreated + 1, reinitialized.contextsCreated);
+    ASSERT_EQ(pooled.contextsReused, reinitialized.contextsReused);
+}
+#endif // ENABLE_OPENSSL_ENCRYPTION
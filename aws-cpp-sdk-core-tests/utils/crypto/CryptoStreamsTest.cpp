@@ -21,6 +21,7 @@
 #include <aws/core/utils/memory/stl/AWSString.h>
 #include <aws/core/utils/HashingUtils.h>
 #include <aws/core/utils/crypto/Factories.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
 
 using namespace Aws::Utils::Crypto;
 using namespace Aws::Utils;
@@ -727,4 +728,89 @@ TEST(CryptoStreamsTest, TestLiveSymmetricCipher)
 }
 #endif
 
+static CryptoBuffer ReadThroughCryptoStream(const CryptoBuffer& input, SymmetricCipher& cipher, CipherMode mode, size_t bufferSize)
+{
+    Aws::StringStream is;
+    is.write(reinterpret_cast<const char*>(input.GetUnderlyingData()), input.GetLength());
+    SymmetricCryptoStream stream(static_cast<Aws::IStream&>(is), mode, cipher, bufferSize);
+
+    // room for a padding block
+    CryptoBuffer output(input.GetLength() + MAX_SYMMETRIC_BLOCK_SIZE);
+    stream.read(reinterpret_cast<char*>(output.GetUnderlyingData()), output.GetLength());
+    return CryptoBuffer(output.GetUnderlyingData(), static_cast<size_t>(stream.gcount()));
+}
+
+static CryptoBuffer WriteThroughCryptoStream(const CryptoBuffer& input, SymmetricCipher& cipher, CipherMode mode, size_t bufferSize)
+{
+    Aws::StringStream os;
+    {
+        SymmetricCryptoStream stream(static_cast<Aws::OStream&>(os), mode, cipher, bufferSize);
+        stream.write(reinterpret_cast<const char*>(input.GetUnderlyingData()), input.GetLength());
+        stream.Finalize();
+    }
+    Aws::String output = os.str();
+    return CryptoBuffer(reinterpret_cast<const unsigned char*>(output.c_str()), output.length());
+}
+
+TEST(CryptoStreamsTest, TestHighThroughputBuffersMatchSingleShotCipher)
+{
+    auto key = SymmetricCipher::GenerateKey();
+    // sizes around the buffer size, so the streams see partial blocks and partial buffers
+    const size_t sizes[] = { 1, 4097, HIGH_THROUGHPUT_BUF_SIZE - 1, HIGH_THROUGHPUT_BUF_SIZE, 3 * HIGH_THROUGHPUT_BUF_SIZE + 17 };
+
+    for (size_t size : sizes)
+    {
+        CryptoBuffer plainText(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            plainText[i] = static_cast<unsigned char>(i * 31 + 7);
+        }
+
+        auto cbc = CreateAES_CBCImplementation(key);
+        CryptoBuffer cbcUpdate = cbc->EncryptBuffer(plainText);
+        CryptoBuffer cbcFinal = cbc->FinalizeEncryption();
+        CryptoBuffer expected({ &cbcUpdate, &cbcFinal });
+
+        auto srcCipher = CreateAES_CBCImplementation(key, cbc->GetIV());
+        ASSERT_EQ(expected, ReadThroughCryptoStream(plainText, *srcCipher, CipherMode::Encrypt, HIGH_THROUGHPUT_BUF_SIZE));
+        auto sinkCipher = CreateAES_CBCImplementation(key, cbc->GetIV());
+        ASSERT_EQ(expected, WriteThroughCryptoStream(plainText, *sinkCipher, CipherMode::Encrypt, HIGH_THROUGHPUT_BUF_SIZE));
+        auto decryptCipher = CreateAES_CBCImplementation(key, cbc->GetIV());
+        ASSERT_EQ(plainText, ReadThroughCryptoStream(expected, *decryptCipher, CipherMode::Decrypt, HIGH_THROUGHPUT_BUF_SIZE));
+
+        auto gcm = CreateAES_GCMImplementation(key);
+        CryptoBuffer cipherText = ReadThroughCryptoStream(plainText, *gcm, CipherMode::Encrypt, HIGH_THROUGHPUT_BUF_SIZE);
+        ASSERT_EQ(size, cipherText.GetLength());
+        auto gcmDecrypt = CreateAES_GCMImplementation(key, gcm->GetIV(), gcm->GetTag());
+        ASSERT_EQ(plainText, WriteThroughCryptoStream(cipherText, *gcmDecrypt, CipherMode::Decrypt, HIGH_THROUGHPUT_BUF_SIZE));
+        ASSERT_TRUE(*gcmDecrypt);
+    }
+}
+
+TEST(CryptoStreamsTest, TestSpanCipherCallsWriteInPlace)
+{
+    auto key = SymmetricCipher::GenerateKey();
+    CryptoBuffer plainText(64 * 1024);
+    for (size_t i = 0; i < plainText.GetLength(); ++i)
+    {
+        plainText[i] = static_cast<unsigned char>(i);
+    }
+
+    auto ctr = CreateAES_CTRImplementation(key);
+    CryptoBuffer expected = ctr->EncryptBuffer(plainText);
+
+    CryptoBuffer inPlace(plainText.GetLength() + MAX_SYMMETRIC_BLOCK_SIZE);
+    memcpy(inPlace.GetUnderlyingData(), plainText.GetUnderlyingData(), plainText.GetLength());
+    auto spanCipher = CreateAES_CTRImplementation(key, ctr->GetIV());
+    size_t written = spanCipher->EncryptBufferInto(inPlace.GetUnderlyingData(), plainText.GetLength(), inPlace.GetUnderlyingData(), inPlace.GetLength());
+    ASSERT_EQ(plainText.GetLength(), written);
+    ASSERT_EQ(expected, CryptoBuffer(inPlace.GetUnderlyingData(), written));
+
+    // too small an output buffer fails the cipher rather than overrunning
+    auto smallOutput = CreateAES_CBCImplementation(key);
+    CryptoBuffer tooSmall(plainText.GetLength());
+    ASSERT_EQ(0u, smallOutput->EncryptBufferInto(plainText.GetUnderlyingData(), plainText.GetLength(), tooSmall.GetUnderlyingData(), tooSmall.GetLength()));
+    ASSERT_FALSE(*smallOutput);
+}
+
 #endif // NO_SYMMETRIC_ENCRYPTION
@@ -15,9 +15,20 @@
 
 #include <aws/external/gtest.h>
 #include <aws/event-stream/event_stream.h>
+#include <aws/core/utils/event/EventStream.h>
 #include <aws/core/utils/event/EventStreamDecoder.h>
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/threading/Executor.h>
 #include <aws/testing/mocks/event/MockEventStreamHandler.h>
 #include <aws/testing/mocks/event/MockEventStreamDecoder.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 namespace
 {
@@ -488,4 +499,450 @@ namespace
         ASSERT_EQ(EventStreamErrors::EVENT_STREAM_PRELUDE_CHECKSUM_FAILURE, handler.m_error);
         ASSERT_TRUE(handler.m_errorMessage.find("CRC Mismatch.") == 0);
     }
-}
\ No newline at end of file
+
+    void AppendUInt32(Aws::Vector<unsigned char>& bytes, uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            bytes.push_back(static_cast<unsigned char>(value >> shift));
+        }
+    }
+
+    void AppendStringHeader(Aws::Vector<unsigned char>& headers, const Aws::String& name, const Aws::String& value)
+    {
+        headers.push_back(static_cast<unsigned char>(name.size()));
+        headers.insert(headers.end(), name.begin(), name.end());
+        headers.push_back(static_cast<unsigned char>(EventHeaderValue::EventHeaderType::STRING));
+        headers.push_back(static_cast<unsigned char>(value.size() >> 8));
+        headers.push_back(static_cast<unsigned char>(value.size()));
+        headers.insert(headers.end(), value.begin(), value.end());
+    }
+
+    void AppendInt32Header(Aws::Vector<unsigned char>& headers, const Aws::String& name, int32_t value)
+    {
+        headers.push_back(static_cast<unsigned char>(name.size()));
+        headers.insert(headers.end(), name.begin(), name.end());
+        headers.push_back(static_cast<unsigned char>(EventHeaderValue::EventHeaderType::INT32));
+        AppendUInt32(headers, static_cast<uint32_t>(value));
+    }
+
+    // Encodes a message the way the service does, without aws-c-event-stream.
+    void AppendMessage(Aws::Vector<unsigned char>& stream, const Aws::Vector<unsigned char>& headers, const Aws::String& payload)
+    {
+        size_t start = stream.size();
+        AppendUInt32(stream, static_cast<uint32_t>(12 + headers.size() + payload.size() + 4));
+        AppendUInt32(stream, static_cast<uint32_t>(headers.size()));
+        AppendUInt32(stream, HashingUtils::CalculateCRC32(stream.data() + start, 8));
+        stream.insert(stream.end(), headers.begin(), headers.end());
+        stream.insert(stream.end(), payload.begin(), payload.end());
+        AppendUInt32(stream, HashingUtils::CalculateCRC32(stream.data() + start, stream.size() - start));
+    }
+
+    void AppendRecordsMessage(Aws::Vector<unsigned char>& stream, const Aws::String& payload)
+    {
+        Aws::Vector<unsigned char> headers;
+        AppendStringHeader(headers, ":message-type", "event");
+        AppendStringHeader(headers, ":event-type", "Records");
+        AppendStringHeader(headers, ":content-type", "application/octet-stream");
+        AppendMessage(stream, headers, payload);
+    }
+
+    // Takes messages as views, and keeps copies of what it was shown.
+    class ViewHandler : public EventStreamHandler
+    {
+    public:
+        ViewHandler() : m_receiveBegin(nullptr), m_receiveEnd(nullptr), m_viewsInReceiveBuffer(0), m_onEventCount(0) {}
+
+        bool OnMessageView(const EventMessageView& message) override
+        {
+            Aws::Map<Aws::String, Aws::String> headers;
+            for (size_t i = 0; i < message.GetHeaderCount(); ++i)
+            {
+                const EventHeaderView& header = message.GetHeaders()[i];
+                headers[Aws::String(header.GetName(), header.GetNameLength())] =
+                    Aws::String(reinterpret_cast<const char*>(header.GetValue()), header.GetValueLength());
+            }
+            m_headers.push_back(headers);
+            m_payloads.push_back(Aws::String(reinterpret_cast<const char*>(message.GetPayload()), message.GetPayloadLength()));
+            if (message.GetPayload() >= m_receiveBegin && message.GetPayload() + message.GetPayloadLength() <= m_receiveEnd)
+            {
+                ++m_viewsInReceiveBuffer;
+            }
+            return true;
+        }
+
+        void OnEvent() override
+        {
+            ++m_onEventCount;
+        }
+
+        const unsigned char* m_receiveBegin;
+        const unsigned char* m_receiveEnd;
+        size_t m_viewsInReceiveBuffer;
+        size_t m_onEventCount;
+        Aws::Vector<Aws::Map<Aws::String, Aws::String>> m_headers;
+        Aws::Vector<Aws::String> m_payloads;
+    };
+
+    // Leaves messages to be copied into it, as handlers written for aws-c-event-stream decoding expect.
+    class CopyingHandler : public EventStreamHandler
+    {
+    public:
+        CopyingHandler() : m_error(EventStreamErrors::EVENT_STREAM_NO_ERROR) {}
+
+        void OnEvent() override
+        {
+            if (!*this)
+            {
+                m_error = GetInternalError();
+                m_errorMessage = GetEventPayloadAsString();
+                return;
+            }
+            m_headers.push_back(GetEventHeaders());
+            m_payloads.push_back(GetEventPayloadAsString());
+        }
+
+        EventStreamErrors m_error;
+        Aws::String m_errorMessage;
+        Aws::Vector<EventHeaderValueCollection> m_headers;
+        Aws::Vector<Aws::String> m_payloads;
+    };
+
+    TEST(EventStreamDecoderTest, TestViewsModeHandsOutMessagesInPlace)
+    {
+        Aws::Vector<unsigned char> stream;
+        AppendRecordsMessage(stream, "1,Alice\n2,Bob\n");
+        AppendRecordsMessage(stream, "3,Carol\n");
+        Aws::Vector<unsigned char> endHeaders;
+        AppendStringHeader(endHeaders, ":message-type", "event");
+        AppendStringHeader(endHeaders, ":event-type", "End");
+        AppendMessage(stream, endHeaders, "");
+
+        ViewHandler handler;
+        handler.m_receiveBegin = stream.data();
+        handler.m_receiveEnd = stream.data() + stream.size();
+        EventStreamDecoder decoder(&handler, EventStreamDecodingMode::VIEWS);
+        decoder.Pump(stream.data(), stream.size());
+
+        ASSERT_TRUE(decoder);
+        ASSERT_EQ(0u, handler.m_onEventCount);
+        ASSERT_EQ(3u, handler.m_payloads.size());
+        ASSERT_EQ(3u, handler.m_viewsInReceiveBuffer);
+        ASSERT_EQ("1,Alice\n2,Bob\n", handler.m_payloads[0]);
+        ASSERT_EQ("3,Carol\n", handler.m_payloads[1]);
+        ASSERT_EQ("", handler.m_payloads[2]);
+        ASSERT_EQ(3u, handler.m_headers[0].size());
+        ASSERT_EQ("event", handler.m_headers[0][":message-type"]);
+        ASSERT_EQ("Records", handler.m_headers[1][":event-type"]);
+        ASSERT_EQ("application/octet-stream", handler.m_headers[1][":content-type"]);
+        ASSERT_EQ("End", handler.m_headers[2][":event-type"]);
+    }
+
+    TEST(EventStreamDecoderTest, TestViewsModeReassemblesSplitMessages)
+    {
+        Aws::Vector<unsigned char> stream;
+        for (int i = 0; i < 20; ++i)
+        {
+            AppendRecordsMessage(stream, Aws::String(static_cast<size_t>(i * 13), static_cast<char>('a' + i)));
+        }
+
+        // from a byte at a time to several messages at once, so messages break in the prelude, headers, payload and checksum
+        const size_t chunkLengths[] = { 1, 5, 11, 64, 1000 };
+        for (size_t chunkLength : chunkLengths)
+        {
+            ViewHandler handler;
+            EventStreamDecoder decoder(&handler, EventStreamDecodingMode::VIEWS);
+            for (size_t offset = 0; offset < stream.size(); offset += chunkLength)
+            {
+                decoder.Pump(stream.data() + offset, (std::min)(chunkLength, stream.size() - offset));
+            }
+
+            ASSERT_TRUE(decoder);
+            ASSERT_EQ(20u, handler.m_payloads.size());
+            for (int i = 0; i < 20; ++i)
+            {
+                ASSERT_EQ(Aws::String(static_cast<size_t>(i * 13), static_cast<char>('a' + i)), handler.m_payloads[i]);
+                ASSERT_EQ("Records", handler.m_headers[i][":event-type"]);
+            }
+        }
+    }
+
+    TEST(EventStreamDecoderTest, TestViewsModeCopiesMessagesForOtherHandlers)
+    {
+        Aws::Vector<unsigned char> headers;
+        AppendStringHeader(headers, ":message-type", "event");
+        AppendInt32Header(headers, "count", -42);
+        Aws::Vector<unsigned char> stream;
+        AppendMessage(stream, headers, "payload");
+        AppendMessage(stream, Aws::Vector<unsigned char>(), "");
+
+        CopyingHandler handler;
+        EventStreamDecoder decoder(&handler, EventStreamDecodingMode::VIEWS);
+        ByteBuffer data(stream.data(), stream.size());
+        decoder.Pump(data);
+
+        ASSERT_TRUE(decoder);
+        ASSERT_EQ(2u, handler.m_payloads.size());
+        ASSERT_EQ("payload", handler.m_payloads[0]);
+        ASSERT_EQ("event", handler.m_headers[0].at(":message-type").GetEventHeaderValueAsString());
+        ASSERT_EQ(-42, handler.m_headers[0].at("count").GetEventHeaderValueAsInt32());
+        ASSERT_EQ("", handler.m_payloads[1]);
+        ASSERT_TRUE(handler.m_headers[1].empty());
+    }
+
+    TEST(EventStreamDecoderTest, TestViewsModeDetectsCorruptMessages)
+    {
+        Aws::Vector<unsigned char> stream;
+        AppendRecordsMessage(stream, "1,Alice\n");
+
+        {
+            Aws::Vector<unsigned char> corrupt(stream);
+            corrupt[2] ^= 0x01;
+            CopyingHandler handler;
+            EventStreamDecoder decoder(&handler, EventStreamDecodingMode::VIEWS);
+            decoder.Pump(corrupt.data(), corrupt.size());
+            ASSERT_FALSE(decoder);
+            ASSERT_EQ(EventStreamErrors::EVENT_STREAM_PRELUDE_CHECKSUM_FAILURE, handler.m_error);
+            ASSERT_TRUE(handler.m_errorMessage.find("CRC Mismatch.") == 0);
+        }
+        {
+            Aws::Vector<unsigned char> corrupt(stream);
+            corrupt[corrupt.size() - 6] ^= 0x80;
+            CopyingHandler handler;
+            EventStreamDecoder decoder(&handler, EventStreamDecodingMode::VIEWS);
+            decoder.Pump(corrupt.data(), corrupt.size());
+            ASSERT_FALSE(decoder);
+            ASSERT_EQ(EventStreamErrors::EVENT_STREAM_MESSAGE_CHECKSUM_FAILURE, handler.m_error);
+            ASSERT_TRUE(handler.m_payloads.empty());
+
+            // after a reset the decoder starts over on a fresh message
+            decoder.Reset();
+            decoder.Pump(stream.data(), stream.size());
+            ASSERT_TRUE(decoder);
+            ASSERT_EQ(1u, handler.m_payloads.size());
+        }
+        {
+            Aws::Vector<unsigned char> headers;
+            AppendStringHeader(headers, ":message-type", "event");
+            headers[headers.size() - 8] = 42; // the header's value type
+            Aws::Vector<unsigned char> unknownType;
+            AppendMessage(unknownType, headers, "");
+            CopyingHandler handler;
+            EventStreamDecoder decoder(&handler, EventStreamDecodingMode::VIEWS);
+            decoder.Pump(unknownType.data(), unknownType.size());
+            ASSERT_EQ(EventStreamErrors::EVENT_STREAM_MESSAGE_UNKNOWN_HEADER_TYPE, handler.m_error);
+        }
+        {
+            const char xmlError[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><Error><Code>Exception</Code></Error>";
+            CopyingHandler handler;
+            EventStreamDecoder decoder(&handler, EventStreamDecodingMode::VIEWS);
+            decoder.Pump(reinterpret_cast<const unsigned char*>(xmlError), sizeof(xmlError));
+            ASSERT_EQ(EventStreamErrors::EVENT_STREAM_PRELUDE_CHECKSUM_FAILURE, handler.m_error);
+        }
+    }
+
+    // Takes messages as views on the dispatch executor, each only once the test lets it through.
+    class GatedHandler : public EventStreamHandler
+    {
+    public:
+        GatedHandler() : m_allowed((std::numeric_limits<size_t>::max)()), m_failAt((std::numeric_limits<size_t>::max)()),
+            m_error(EventStreamErrors::EVENT_STREAM_NO_ERROR) {}
+
+        bool OnMessageView(const EventMessageView& message) override
+        {
+            std::unique_lock<std::mutex> locker(m_lock);
+            m_signal.wait(locker, [this]() { return m_payloads.size() < m_allowed; });
+            m_threads.push_back(std::this_thread::get_id());
+            m_payloads.push_back(Aws::String(reinterpret_cast<const char*>(message.GetPayload()), message.GetPayloadLength()));
+            if (m_payloads.size() == m_failAt)
+            {
+                SetFailure();
+            }
+            m_signal.notify_all();
+            return true;
+        }
+
+        void OnEvent() override
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_error = GetInternalError();
+        }
+
+        void Allow(size_t messages)
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_allowed = messages;
+            m_signal.notify_all();
+        }
+
+        void WaitForPayloads(size_t messages)
+        {
+            std::unique_lock<std::mutex> locker(m_lock);
+            m_signal.wait(locker, [this, messages]() { return m_payloads.size() >= messages; });
+        }
+
+        std::mutex m_lock;
+        std::condition_variable m_signal;
+        size_t m_allowed;
+        size_t m_failAt;
+        EventStreamErrors m_error;
+        Aws::Vector<std::thread::id> m_threads;
+        Aws::Vector<Aws::String> m_payloads;
+    };
+
+    TEST(EventStreamDecoderTest, TestDispatchedMessagesKeepTheirOrder)
+    {
+        Aws::Vector<unsigned char> stream;
+        for (int i = 0; i < 200; ++i)
+        {
+            AppendRecordsMessage(stream, Aws::String(static_cast<size_t>(i % 50), static_cast<char>('a' + i % 26)));
+        }
+
+        auto executor = Aws::MakeShared<Aws::Utils::Threading::PooledThreadExecutor>("EventStreamDecoderTest", 4);
+        GatedHandler handler;
+        EventStreamDecoder decoder(&handler);
+        decoder.SetDispatchExecutor(executor);
+        // split so some messages are queued from the pending buffer and some straight from the pumped data
+        for (size_t offset = 0; offset < stream.size(); offset += 100)
+        {
+            decoder.Pump(stream.data() + offset, (std::min)(static_cast<size_t>(100), stream.size() - offset));
+        }
+        decoder.WaitForDispatchedMessages();
+
+        ASSERT_TRUE(decoder);
+        ASSERT_EQ(200u, handler.m_payloads.size());
+        for (int i = 0; i < 200; ++i)
+        {
+            ASSERT_EQ(Aws::String(static_cast<size_t>(i % 50), static_cast<char>('a' + i % 26)), handler.m_payloads[i]);
+            ASSERT_NE(std::this_thread::get_id(), handler.m_threads[i]);
+        }
+    }
+
+    TEST(EventStreamDecoderTest, TestDispatchWatermarksHoldOffData)
+    {
+        Aws::Vector<unsigned char> message;
+        AppendRecordsMessage(message, Aws::String(1000, 'r'));
+        const size_t messageLength = message.size();
+
+        auto executor = Aws::MakeShared<Aws::Utils::Threading::DefaultExecutor>("EventStreamDecoderTest");
+        GatedHandler handler;
+        handler.Allow(0);
+        EventStreamDecoder decoder(&handler);
+        decoder.SetDispatchExecutor(executor, 4 * messageLength, 2 * messageLength);
+        auto flowControl = decoder.GetResponseFlowControlHandler();
+        ASSERT_TRUE(static_cast<bool>(flowControl));
+
+        for (int i = 0; i < 3; ++i)
+        {
+            decoder.Pump(message.data(), message.size());
+        }
+        ASSERT_TRUE(decoder.IsReadyForData());
+        decoder.Pump(message.data(), message.size());
+        ASSERT_FALSE(decoder.IsReadyForData());
+        ASSERT_FALSE(flowControl(nullptr, std::chrono::milliseconds(0)));
+
+        // back under the high watermark, but not yet down to the low one
+        handler.Allow(1);
+        handler.WaitForPayloads(1);
+        ASSERT_FALSE(flowControl(nullptr, std::chrono::milliseconds(100)));
+
+        handler.Allow(2);
+        ASSERT_TRUE(flowControl(nullptr, std::chrono::seconds(10)));
+        ASSERT_TRUE(decoder.IsReadyForData());
+
+        handler.Allow(4);
+        decoder.WaitForDispatchedMessages();
+        ASSERT_EQ(4u, handler.m_payloads.size());
+        ASSERT_TRUE(decoder);
+    }
+
+    TEST(EventStreamDecoderTest, TestDispatchedErrorsFollowEarlierMessages)
+    {
+        Aws::Vector<unsigned char> stream;
+        AppendRecordsMessage(stream, "1,Alice\n");
+        const size_t firstLength = stream.size();
+        AppendRecordsMessage(stream, "2,Bob\n");
+        auto executor = Aws::MakeShared<Aws::Utils::Threading::DefaultExecutor>("EventStreamDecoderTest");
+
+        {
+            // a corrupt prelude is found while pumping, but reported after the message ahead of it
+            Aws::Vector<unsigned char> corrupt(stream);
+            corrupt[firstLength + 2] ^= 0x01;
+            GatedHandler handler;
+            EventStreamDecoder decoder(&handler);
+            decoder.SetDispatchExecutor(executor);
+            decoder.Pump(corrupt.data(), corrupt.size());
+            ASSERT_FALSE(decoder);
+            decoder.WaitForDispatchedMessages();
+            ASSERT_EQ(1u, handler.m_payloads.size());
+            ASSERT_EQ(EventStreamErrors::EVENT_STREAM_PRELUDE_CHECKSUM_FAILURE, handler.m_error);
+        }
+        {
+            // a corrupt message is found by the dispatched decoding
+            Aws::Vector<unsigned char> corrupt(stream);
+            corrupt[corrupt.size() - 6] ^= 0x80;
+            GatedHandler handler;
+            EventStreamDecoder decoder(&handler);
+            decoder.SetDispatchExecutor(executor);
+            decoder.Pump(corrupt.data(), corrupt.size());
+            decoder.WaitForDispatchedMessages();
+            ASSERT_FALSE(decoder);
+            ASSERT_EQ(1u, handler.m_payloads.size());
+            ASSERT_EQ(EventStreamErrors::EVENT_STREAM_MESSAGE_CHECKSUM_FAILURE, handler.m_error);
+
+            // after a reset the decoder starts over
+            decoder.Reset();
+            ASSERT_TRUE(decoder);
+            decoder.Pump(stream.data(), stream.size());
+            decoder.WaitForDispatchedMessages();
+            ASSERT_TRUE(decoder);
+            ASSERT_EQ(3u, handler.m_payloads.size());
+        }
+        {
+            // once the handler fails, the messages queued behind it are dropped
+            GatedHandler handler;
+            handler.m_failAt = 1;
+            EventStreamDecoder decoder(&handler);
+            decoder.SetDispatchExecutor(executor);
+            decoder.Pump(stream.data(), stream.size());
+            decoder.WaitForDispatchedMessages();
+            ASSERT_FALSE(decoder);
+            ASSERT_EQ(1u, handler.m_payloads.size());
+            ASSERT_TRUE(decoder.IsReadyForData());
+        }
+    }
+
+    TEST(EventStreamDecoderTest, TestEventStreamWaitsForDispatchedMessagesWhenDestroyed)
+    {
+        Aws::Vector<unsigned char> stream;
+        for (int i = 0; i < 10; ++i)
+        {
+            AppendRecordsMessage(stream, "record-" + StringUtils::to_string(i));
+        }
+
+        auto executor = Aws::MakeShared<Aws::Utils::Threading::DefaultExecutor>("EventStreamDecoderTest");
+        GatedHandler handler;
+        handler.Allow(0);
+        EventStreamDecoder decoder(&handler);
+        decoder.SetDispatchExecutor(executor);
+        std::atomic<bool> destroyed(false);
+        std::thread responseThread([&]()
+        {
+            // what a client does with the response body of an event stream operation
+            auto eventStream = Aws::New<EventStream>("EventStreamDecoderTest", decoder);
+            eventStream->write(reinterpret_cast<const char*>(stream.data()), static_cast<std::streamsize>(stream.size()));
+            Aws::Delete(eventStream);
+            destroyed = true;
+        });
+
+        handler.Allow(9);
+        handler.WaitForPayloads(9);
+        ASSERT_FALSE(destroyed.load());
+
+        handler.Allow(10);
+        responseThread.join();
+        ASSERT_EQ(10u, handler.m_payloads.size());
+        ASSERT_EQ("record-9", handler.m_payloads[9]);
+        ASSERT_TRUE(decoder);
+    }
+}
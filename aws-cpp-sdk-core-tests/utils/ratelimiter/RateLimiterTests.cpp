@@ -16,6 +16,12 @@
 #include <aws/external/gtest.h>
 
 #include <aws/core/utils/ratelimiter/DefaultRateLimiter.h>
+#include <aws/core/utils/ratelimiter/ConcurrentRateLimiter.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <atomic>
+#include <limits>
+#include <thread>
 
 using namespace Aws::Utils::RateLimits;
 
@@ -276,4 +282,178 @@ TEST_F(DefaultRateLimitTest, fractionalLimitTest)
     SetMillisecondsElapsed(10);
     delay = limiter.ApplyCost(0);
     ASSERT_TRUE(delay.count() == 0);    
-}
\ No newline at end of file
+}
+
+using TestConcurrentRateLimiter = ConcurrentRateLimiter<>;
+
+class CountingRateLimiter : public RateLimiterInterface
+{
+public:
+    CountingRateLimiter() : m_calls(0), m_cost(0) {}
+
+    DelayType ApplyCost(int64_t cost) override
+    {
+        ++m_calls;
+        m_cost += cost;
+        return DelayType(0);
+    }
+
+    void ApplyAndPayForCost(int64_t cost) override { ApplyCost(cost); }
+
+    void SetRate(int64_t, bool) override {}
+
+    std::atomic<int64_t> m_calls;
+    std::atomic<int64_t> m_cost;
+};
+
+TEST_F(DefaultRateLimitTest, concurrentNopTest)
+{
+    TestConcurrentRateLimiter limiter(10, 1, nullptr, DefaultRateLimitTest::GetTestTime);
+    auto delay = limiter.ApplyCost(0);
+
+    ASSERT_EQ(0, delay.count());
+}
+
+TEST_F(DefaultRateLimitTest, concurrentDoubleLimitTest)
+{
+    TestConcurrentRateLimiter limiter(10, 1, nullptr, DefaultRateLimitTest::GetTestTime);
+
+    auto delay = limiter.ApplyCost(20);
+    ASSERT_EQ(0, delay.count());
+
+    delay = limiter.ApplyCost(0);
+    ASSERT_EQ(1000, delay.count());
+}
+
+TEST_F(DefaultRateLimitTest, concurrentDelayedOverLimitTest)
+{
+    TestConcurrentRateLimiter limiter(10, 1, nullptr, DefaultRateLimitTest::GetTestTime);
+    limiter.ApplyCost(10);
+
+    SetMillisecondsElapsed(500);
+
+    auto delay = limiter.ApplyCost(6);
+    ASSERT_EQ(0, delay.count());
+
+    delay = limiter.ApplyCost(0);
+    ASSERT_EQ(100, delay.count());
+}
+
+TEST_F(DefaultRateLimitTest, concurrentLongDelayLimitTest)
+{
+    TestConcurrentRateLimiter limiter(100, 1, nullptr, DefaultRateLimitTest::GetTestTime);
+    limiter.ApplyCost(150);
+
+    auto delay = limiter.ApplyCost(0);
+    ASSERT_EQ(500, delay.count());
+
+    // long wait, the bucket refills up to the rate and no further
+    SetMillisecondsElapsed(100000);
+
+    delay = limiter.ApplyCost(110);
+    ASSERT_EQ(0, delay.count());
+
+    delay = limiter.ApplyCost(0);
+    ASSERT_EQ(100, delay.count());
+}
+
+TEST_F(DefaultRateLimitTest, concurrentCreditBatchTest)
+{
+    auto parent = Aws::MakeShared<CountingRateLimiter>("RateLimiterTest");
+    TestConcurrentRateLimiter limiter(1000, 100, parent, DefaultRateLimitTest::GetTestTime);
+
+    // the first call draws a batch of 100, the next nine are paid out of this thread's credit
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(0, limiter.ApplyCost(10).count());
+    }
+    ASSERT_EQ(1, parent->m_calls.load());
+    ASSERT_EQ(100, parent->m_cost.load());
+
+    ASSERT_EQ(0, limiter.ApplyCost(10).count());
+    ASSERT_EQ(2, parent->m_calls.load());
+    ASSERT_EQ(200, parent->m_cost.load());
+
+    // costs larger than a batch are drawn as-is
+    ASSERT_EQ(0, limiter.ApplyCost(250).count());
+    ASSERT_EQ(3, parent->m_calls.load());
+    ASSERT_EQ(450, parent->m_cost.load());
+}
+
+TEST_F(DefaultRateLimitTest, concurrentResetDiscardsCreditTest)
+{
+    auto parent = Aws::MakeShared<CountingRateLimiter>("RateLimiterTest");
+    TestConcurrentRateLimiter limiter(1000, 100, parent, DefaultRateLimitTest::GetTestTime);
+
+    limiter.ApplyCost(10);
+    ASSERT_EQ(1, parent->m_calls.load());
+
+    limiter.SetRate(1000, true);
+    limiter.ApplyCost(10);
+    ASSERT_EQ(2, parent->m_calls.load());
+}
+
+TEST_F(DefaultRateLimitTest, concurrentHierarchicalLimitTest)
+{
+    auto parent = Aws::MakeShared<TestDefaultRateLimiter>("RateLimiterTest", 10, DefaultRateLimitTest::GetTestTime);
+    TestConcurrentRateLimiter limiter(1000, 1, parent, DefaultRateLimitTest::GetTestTime);
+
+    auto delay = limiter.ApplyCost(20);
+    ASSERT_EQ(0, delay.count());
+
+    // the child has plenty of budget left, the parent doesn't
+    delay = limiter.ApplyCost(0);
+    ASSERT_EQ(1000, delay.count());
+}
+
+TEST_F(DefaultRateLimitTest, concurrentThreadsShareTheBucketTest)
+{
+    static const size_t THREAD_COUNT = 8;
+    static const int64_t CALLS_PER_THREAD = 1000;
+
+    // the clock doesn't move, so whatever the threads draw beyond the initial budget of 1000 is left as debt
+    TestConcurrentRateLimiter limiter(1000, 1, nullptr, DefaultRateLimitTest::GetTestTime);
+
+    Aws::Vector<std::thread> threads;
+    for (size_t i = 0; i < THREAD_COUNT; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (int64_t call = 0; call < CALLS_PER_THREAD; ++call)
+            {
+                limiter.ApplyCost(1);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto delay = limiter.ApplyCost(0);
+    ASSERT_EQ(7000, delay.count());
+}
+
+TEST_F(DefaultRateLimitTest, concurrentCoarseDurationTest)
+{
+    // a bucket of 1e10 per hour doesn't fit in an int64_t of microseconds, so the rate is capped at about 2.56e9 per hour
+    ConcurrentRateLimiter<TestDefaultRateLimiter::InternalTimePointType::clock, std::chrono::hours> limiter(10000000000LL, 1, nullptr,
+        DefaultRateLimitTest::GetTestTime);
+
+    ASSERT_EQ(0, limiter.ApplyCost(2000000000LL).count());
+    ASSERT_EQ(0, limiter.ApplyCost(2000000000LL).count());
+
+    // 1.44e9 over the capped rate is about 34 minutes
+    auto delay = std::chrono::duration_cast<std::chrono::minutes>(limiter.ApplyCost(0));
+    ASSERT_EQ(33, delay.count());
+
+    // a long idle period refills the bucket without overflowing
+    SetMillisecondsElapsed(2 * 3600 * 1000);
+    ASSERT_EQ(0, limiter.ApplyCost(0).count());
+
+    // costs too large to count in ticks saturate the debt instead of wrapping it around
+    limiter.ApplyCost((std::numeric_limits<int64_t>::max)());
+    limiter.ApplyCost((std::numeric_limits<int64_t>::max)());
+    limiter.ApplyCost((std::numeric_limits<int64_t>::max)());
+    ASSERT_GT(limiter.ApplyCost(0).count(), 0);
+}
@@ -0,0 +1,92 @@
+/*
+* Copyright 2010-2018 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include <aws/external/gtest.h>
+#include <aws/core/utils/threading/CancellationToken.h>
+#include <thread>
+
+using namespace Aws::Utils::Threading;
+
+TEST(CancellationToken, CancelIsSticky)
+{
+    CancellationToken token;
+    ASSERT_FALSE(token.IsCancelled());
+    ASSERT_EQ((std::chrono::milliseconds::max)(), token.GetRemainingTime());
+
+    token.Cancel();
+    ASSERT_TRUE(token.IsCancelled());
+    ASSERT_EQ(std::chrono::milliseconds(0), token.GetRemainingTime());
+    token.SetDeadline(std::chrono::steady_clock::now() + std::chrono::hours(1));
+    ASSERT_TRUE(token.IsCancelled());
+}
+
+TEST(CancellationToken, DeadlineExpires)
+{
+    CancellationToken token(std::chrono::milliseconds(50));
+    ASSERT_FALSE(token.IsCancelled());
+    ASSERT_TRUE(token.GetRemainingTime() <= std::chrono::milliseconds(50));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    ASSERT_TRUE(token.IsCancelled());
+    ASSERT_EQ(std::chrono::milliseconds(0), token.GetRemainingTime());
+}
+
+TEST(CancellationToken, WaitForTimesOut)
+{
+    CancellationToken token;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_FALSE(token.WaitFor(std::chrono::milliseconds(50)));
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+}
+
+TEST(CancellationToken, WaitForWakesUpOnCancel)
+{
+    CancellationToken token;
+    std::thread canceller([&token]
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        token.Cancel();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(token.WaitFor(std::chrono::seconds(10)));
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    canceller.join();
+}
+
+TEST(CancellationToken, WaitForStopsAtDeadline)
+{
+    CancellationToken token(std::chrono::milliseconds(50));
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(token.WaitFor(std::chrono::seconds(10)));
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
+
+TEST(CancellationToken, CancelCallbacks)
+{
+    CancellationToken token;
+    int calls = 0;
+    auto removed = token.AddCancelCallback([&calls] { calls += 10; });
+    token.AddCancelCallback([&calls] { ++calls; });
+    token.RemoveCancelCallback(removed);
+
+    token.Cancel();
+    ASSERT_EQ(1, calls);
+    // callbacks run once, and right away once the token is cancelled
+    token.Cancel();
+    ASSERT_EQ(1, calls);
+    token.AddCancelCallback([&calls] { ++calls; });
+    ASSERT_EQ(2, calls);
+}
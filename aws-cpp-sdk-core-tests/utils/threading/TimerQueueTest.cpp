@@ -0,0 +1,59 @@
+/*
+* Copyright 2010-2018 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+#include <aws/external/gtest.h>
+#include <aws/core/utils/threading/TimerQueue.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+#include <atomic>
+#include <thread>
+
+using namespace Aws::Utils::Threading;
+
+TEST(TimerQueue, RunsTasksInDeadlineOrder)
+{
+    TimerQueue timerQueue;
+    std::mutex lock;
+    Aws::Vector<int> order;
+    std::atomic<int> done(0);
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration firstElapsed(0);
+
+    // scheduled out of order; the 20ms task must wake the thread already waiting for the 80ms one
+    timerQueue.Schedule(std::chrono::milliseconds(80), [&]() { std::lock_guard<std::mutex> locker(lock); order.push_back(3); ++done; });
+    timerQueue.Schedule(std::chrono::milliseconds(20), [&]() { std::lock_guard<std::mutex> locker(lock); firstElapsed = std::chrono::steady_clock::now() - start; order.push_back(1); ++done; });
+    timerQueue.Schedule(std::chrono::milliseconds(50), [&]() { std::lock_guard<std::mutex> locker(lock); order.push_back(2); ++done; });
+
+    while (done < 3)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    std::lock_guard<std::mutex> locker(lock);
+    ASSERT_EQ(3u, order.size());
+    ASSERT_EQ(1, order[0]);
+    ASSERT_EQ(2, order[1]);
+    ASSERT_EQ(3, order[2]);
+    ASSERT_TRUE(firstElapsed >= std::chrono::milliseconds(20));
+    ASSERT_TRUE(firstElapsed < std::chrono::milliseconds(70));
+}
+
+TEST(TimerQueue, DropsPendingTasksOnDestruction)
+{
+    std::atomic<bool> ran(false);
+    {
+        TimerQueue timerQueue;
+        timerQueue.Schedule(std::chrono::hours(1), [&ran]() { ran = true; });
+    }
+    ASSERT_FALSE(ran);
+}
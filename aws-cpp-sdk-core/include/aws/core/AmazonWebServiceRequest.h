@@ -32,6 +32,14 @@ namespace Aws
         class URI;
     } // namespace Http
 
+    namespace Utils
+    {
+        namespace Threading
+        {
+            class CancellationToken;
+        } // namespace Threading
+    } // namespace Utils
+
     class AmazonWebServiceRequest;
 
     /**
@@ -107,6 +115,10 @@ namespace Aws
          * Register closure for handling whether or not to cancel a request.
          */
         inline virtual void SetContinueRequestHandler(Aws::Http::ContinueRequestHandler&& continueRequestHandler) { m_continueRequest = std::move(continueRequestHandler); }
+        /**
+         * Register closure for holding off the response while its consumer catches up.
+         */
+        inline virtual void SetResponseFlowControlHandler(const Aws::Http::ResponseFlowControlHandler& responseFlowControlHandler) { m_responseFlowControl = responseFlowControlHandler; }
         /**
         * Register closure for notification that a request is being retried
         */
@@ -127,10 +139,22 @@ namespace Aws
          * get closure for handling whether or not to cancel a request.
          */
         inline virtual const Aws::Http::ContinueRequestHandler& GetContinueRequestHandler() const { return m_continueRequest; }
+        /**
+         * get closure for holding off the response while its consumer catches up.
+         */
+        inline virtual const Aws::Http::ResponseFlowControlHandler& GetResponseFlowControlHandler() const { return m_responseFlowControl; }
         /**
          * get closure for notification that a request is being retried
          */
         inline virtual const RequestRetryHandler& GetRequestRetryHandler() const { return m_requestRetryHandler; }
+        /**
+         * Set a token to cancel this request, or bound it with a deadline. Covers every attempt, the sleeps between retries, and in-flight transfers.
+         */
+        inline virtual void SetCancellationToken(const std::shared_ptr<Aws::Utils::Threading::CancellationToken>& cancellationToken) { m_cancellationToken = cancellationToken; }
+        /**
+         * get the token that cancels this request, nullptr if there is none
+         */
+        inline virtual const std::shared_ptr<Aws::Utils::Threading::CancellationToken>& GetCancellationToken() const { return m_cancellationToken; }
         /**
          * If this is set to true, content-md5 needs to be computed and set on the request
          */
@@ -151,7 +175,9 @@ namespace Aws
         Aws::Http::DataReceivedEventHandler m_onDataReceived;
         Aws::Http::DataSentEventHandler m_onDataSent;
         Aws::Http::ContinueRequestHandler m_continueRequest;
+        Aws::Http::ResponseFlowControlHandler m_responseFlowControl;
         RequestRetryHandler m_requestRetryHandler;
+        std::shared_ptr<Aws::Utils::Threading::CancellationToken> m_cancellationToken;
     };
 
 } // namespace Aws
@@ -51,6 +51,12 @@ namespace Aws
         {
             class MD5;
         } // namespace Crypto
+
+        namespace Threading
+        {
+            class Executor;
+            class TimerQueue;
+        } // namespace Threading
     } // namespace Utils
 
     namespace Http
@@ -83,6 +89,7 @@ namespace Aws
         class AWSAuthSigner;
         struct ClientConfiguration;
         class RetryStrategy;
+        class HedgingStrategy;
 
         typedef Utils::Outcome<std::shared_ptr<Aws::Http::HttpResponse>, AWSError<CoreErrors>> HttpResponseOutcome;
         typedef Utils::Outcome<AmazonWebServiceResult<Utils::Stream::ResponseStream>, AWSError<CoreErrors>> StreamOutcome;
@@ -242,6 +249,19 @@ namespace Aws
              * return true if signer's clock is adjusted, false otherwise.
              */
             bool AdjustClockSkew(HttpResponseOutcome& outcome, const char* signerName) const;
+            /**
+             * Signs an Http Request that has already been built from an AmazonWebServiceRequest, sends it accross the wire
+             * then reports the http response.
+             */
+            HttpResponseOutcome AttemptBuiltRequest(const std::shared_ptr<Http::HttpRequest>& httpRequest, bool signBody, const char* signerName) const;
+            /**
+             * Same as AttemptOneRequest, but sends a hedged copy of the request from the executor if it hasn't completed after the hedge delay,
+             * and returns whichever succeeds first. httpRequest is replaced by the hedged copy if that one is used. The hedged copy reads its body
+             * into a stream of its own, which is copied to a stream of the request's response stream factory if it wins; only the winner's
+             * data received is reported, and the request's retry handler is called first if the primary had reported some.
+             */
+            HttpResponseOutcome AttemptHedgedRequest(const Aws::Http::URI& uri, Http::HttpMethod method,
+                std::shared_ptr<Http::HttpRequest>& httpRequest, const Aws::AmazonWebServiceRequest& request, const char* signerName) const;
             void AddHeadersToRequest(const std::shared_ptr<Aws::Http::HttpRequest>& httpRequest, const Http::HeaderValueCollection& headerValues) const;
             void AddContentBodyToRequest(const std::shared_ptr<Aws::Http::HttpRequest>& httpRequest,
                                          const std::shared_ptr<Aws::IOStream>& body, bool needsContentMd5 = false) const;
@@ -254,6 +274,10 @@ namespace Aws
             std::shared_ptr<Aws::Auth::AWSAuthSignerProvider> m_signerProvider;
             std::shared_ptr<AWSErrorMarshaller> m_errorMarshaller;
             std::shared_ptr<RetryStrategy> m_retryStrategy;
+            std::shared_ptr<HedgingStrategy> m_hedgingStrategy;
+            std::shared_ptr<Aws::Utils::Threading::Executor> m_executor;
+            /// Decides when hedges are due, so that the executor only sees the hedges that are actually sent
+            std::shared_ptr<Aws::Utils::Threading::TimerQueue> m_hedgeTimer;
             std::shared_ptr<Aws::Utils::RateLimits::RateLimiterInterface> m_writeRateLimiter;
             std::shared_ptr<Aws::Utils::RateLimits::RateLimiterInterface> m_readRateLimiter;
             Aws::String m_userAgent;
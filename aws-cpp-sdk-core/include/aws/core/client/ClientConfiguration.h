@@ -40,6 +40,7 @@ namespace Aws
     namespace Client
     {
         class RetryStrategy; // forward declare
+        class HedgingStrategy;
 
         /**
           * This mutable structure is used to configure any of the AWS clients.
@@ -93,10 +94,33 @@ namespace Aws
              * Default 1 byte/second. Only for CURL client currently.
              */
             unsigned long lowSpeedLimit;
+            /**
+             * HTTP protocol version to use. Default HTTP_VERSION_NONE, the http client's own default.
+             * Only for CURL client currently.
+             */
+            Aws::Http::Version version;
+            /**
+             * Multiplex concurrent requests as HTTP/2 streams over at most maxConnections connections per host, instead of using one connection per request.
+             * Requires an endpoint that speaks HTTP/2; if version isn't an HTTP/2 version, HTTP_VERSION_2TLS is used.
+             * Body streams, data callbacks, continue request and response flow control handlers, and read/write rate limiters still run on the
+             * thread making the request; a request that falls behind has its stream paused, without holding up the other streams on the connection.
+             * Only seeking the request body back for a retry on a new connection happens on the one thread that drives all streams.
+             * Default false. Only for CURL client currently.
+             */
+            bool enableHttp2Multiplexing;
+            /**
+             * Max concurrent streams on one connection when enableHttp2Multiplexing is set. The server may advertise a lower limit. Default 100.
+             */
+            unsigned maxConcurrentStreams;
             /**
              * Strategy to use in case of failed requests. Default is DefaultRetryStrategy (e.g. exponential backoff)
              */
             std::shared_ptr<RetryStrategy> retryStrategy;
+            /**
+             * Strategy for sending hedged (duplicate) copies of slow idempotent requests and taking the first success. Hedged copies are sent from the executor.
+             * Default is nullptr, no hedging. See DefaultHedgingStrategy.
+             */
+            std::shared_ptr<HedgingStrategy> hedgingStrategy;
             /**
              * Override the http endpoint used to talk to a service.
              */
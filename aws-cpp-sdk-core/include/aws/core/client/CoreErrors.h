@@ -60,6 +60,7 @@ namespace Aws
             // These are needed for logical reasons
             UNKNOWN = 100, // Unknown to the SDK
             CLIENT_SIGNING_FAILURE = 101, // Client failed to sign the request
+            REQUEST_CANCELLED = 102, // Request was cancelled through its cancellation token or ran past its deadline
             SERVICE_EXTENSION_START_RANGE = 128
         };
 
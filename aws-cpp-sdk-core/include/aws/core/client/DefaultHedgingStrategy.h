@@ -0,0 +1,80 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#pragma once
+
+#include <aws/core/Core_EXPORTS.h>
+#include <aws/core/client/HedgingStrategy.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSSet.h>
+#include <aws/core/utils/memory/stl/AWSString.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace Aws
+{
+namespace Client
+{
+
+/**
+ * Hedges the operations it was given by name (e.g. "GetObject", "HeadObject"), as long as they are sent as GET or HEAD requests;
+ * operations sent with any other method are never hedged, even if listed.
+ * Until enough latencies have been observed for an operation, the hedge is sent after hedgeDelayMs; afterwards it is sent after latencyPercentile
+ * of the observed latencies (never sooner than hedgeDelayMs). Pass a latencyPercentile of 0 to always use the fixed delay.
+ * Hedges are paid for out of a budget credited with maxHedgeRatio of a hedge for every completed request, so hedging can't add more than that
+ * fraction of load on top of a small initial burst.
+ */
+class AWS_CORE_API DefaultHedgingStrategy : public HedgingStrategy
+{
+public:
+
+    DefaultHedgingStrategy(const Aws::Vector<Aws::String>& operations, long hedgeDelayMs = 50, double latencyPercentile = 0.95, double maxHedgeRatio = 0.05);
+
+    bool ShouldHedge(const AmazonWebServiceRequest& request, Http::HttpMethod method) const override;
+
+    long CalculateHedgeDelay(const AmazonWebServiceRequest& request) const override;
+
+    bool AcquireHedge() override;
+
+    void RequestCompleted(const AmazonWebServiceRequest& request, long latencyMs, bool succeeded) override;
+
+private:
+    /**
+     * Ring of the most recent latencies for one operation; the percentile is recomputed every few samples rather than on every request.
+     */
+    struct LatencyWindow
+    {
+        LatencyWindow() : m_next(0), m_samplesSinceUpdate(0), m_percentileMs(-1) {}
+
+        Aws::Vector<long> m_samples;
+        size_t m_next;
+        size_t m_samplesSinceUpdate;
+        long m_percentileMs;
+    };
+
+    Aws::Set<Aws::String> m_operations;
+    long m_hedgeDelayMs;
+    double m_latencyPercentile;
+    int64_t m_creditPerRequest;
+    std::atomic<int64_t> m_budget;
+
+    mutable std::mutex m_latencyLock;
+    Aws::Map<Aws::String, LatencyWindow> m_latencies;
+};
+
+} // namespace Client
+} // namespace Aws
@@ -0,0 +1,61 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#pragma once
+
+#include <aws/core/Core_EXPORTS.h>
+#include <aws/core/http/HttpTypes.h>
+
+namespace Aws
+{
+    class AmazonWebServiceRequest;
+
+    namespace Client
+    {
+        /**
+         * Interface for defining a Hedging Strategy. While a request is in flight, the client may send a duplicate (hedged) copy of it
+         * on another connection and take whichever response succeeds first. Only idempotent requests may be hedged.
+         * Override this class to provide your own hedging behavior.
+         */
+        class AWS_CORE_API HedgingStrategy
+        {
+        public:
+            virtual ~HedgingStrategy() = default;
+
+            /**
+             * Returns true if the request is idempotent and may have a duplicate in flight at the same time.
+             * The request must be able to produce its body and response stream more than once.
+             */
+            virtual bool ShouldHedge(const AmazonWebServiceRequest& request, Http::HttpMethod method) const = 0;
+
+            /**
+             * Calculates the time in milliseconds to wait on an attempt before sending a hedged copy of it. Negative values disable hedging for this attempt.
+             */
+            virtual long CalculateHedgeDelay(const AmazonWebServiceRequest& request) const = 0;
+
+            /**
+             * Called right before a hedged copy is sent. Returns false if the hedge budget doesn't allow another request.
+             */
+            virtual bool AcquireHedge() = 0;
+
+            /**
+             * Called once per hedgeable attempt with the latency of the response that was used, whether it succeeded or not. The latency is
+             * measured from when the original request was sent, also when the hedged copy answered first.
+             */
+            virtual void RequestCompleted(const AmazonWebServiceRequest& request, long latencyMs, bool succeeded) = 0;
+        };
+
+    } // namespace Client
+} // namespace Aws
@@ -31,6 +31,11 @@ namespace Aws
         {
             class RateLimiterInterface;
         } // namespace RateLimits
+
+        namespace Threading
+        {
+            class CancellationToken;
+        } // namespace Threading
     } // namespace Utils
 
     namespace Http
@@ -85,6 +90,10 @@ namespace Aws
              * Sleeps current thread for sleepTime.
              */
             void RetryRequestSleep(std::chrono::milliseconds sleepTime);
+            /**
+             * Sleeps current thread for sleepTime, waking up early if request processing is disabled or cancellationToken is cancelled or reaches its deadline.
+             */
+            void RetryRequestSleep(std::chrono::milliseconds sleepTime, Aws::Utils::Threading::CancellationToken& cancellationToken);
 
             bool ContinueRequest(const Aws::Http::HttpRequest&) const;
 
@@ -25,6 +25,7 @@
 #include <aws/core/monitoring/HttpClientMetrics.h>
 #include <memory>
 #include <functional>
+#include <chrono>
 
 using namespace Aws::Monitoring;
 
@@ -66,6 +67,11 @@ namespace Aws
          * Closure type for handling whether or not a request should be canceled.
          */
         typedef std::function<bool(const HttpRequest*)> ContinueRequestHandler;
+        /**
+         * Closure type for holding off a response until whatever consumes its body can take more. Returns whether more of the body
+         * may be written now, waiting up to the given time for that.
+         */
+        typedef std::function<bool(const HttpRequest*, std::chrono::milliseconds)> ResponseFlowControlHandler;
 
         /**
           * Abstract class for representing an HttpRequest.
@@ -456,6 +462,11 @@ namespace Aws
              * Sets the closure for handling whether or not to cancel a request.
              */
             inline void SetContinueRequestHandle(ContinueRequestHandler&& continueRequestHandler) { m_continueRequest = std::move(continueRequestHandler); }
+            /**
+             * Sets the closure the http client asks before writing more of the response body. While it returns false, the client stops
+             * reading the response, if it can, so the sender is held off too.
+             */
+            inline void SetResponseFlowControlHandler(const ResponseFlowControlHandler& responseFlowControlHandler) { m_responseFlowControl = responseFlowControlHandler; }
 
             /**
              * Gets the closure for receiving events when data is received from the server.
@@ -467,6 +478,10 @@ namespace Aws
             inline const DataSentEventHandler& GetDataSentEventHandler() const { return m_onDataSent; }
 
             inline const ContinueRequestHandler& GetContinueRequestHandler() const { return m_continueRequest; }
+            /**
+             * Gets the closure for holding off the response, which is empty if the response body can always take more.
+             */
+            inline const ResponseFlowControlHandler& GetResponseFlowControlHandler() const { return m_responseFlowControl; }
 
             /**
              * Gets the AWS Access Key if this HttpRequest is signed with Aws Access Key
@@ -509,6 +524,7 @@ namespace Aws
             DataReceivedEventHandler m_onDataReceived;
             DataSentEventHandler m_onDataSent;
             ContinueRequestHandler m_continueRequest;
+            ResponseFlowControlHandler m_responseFlowControl;
             Aws::String m_signingRegion;
             Aws::String m_signingAccessKey;
             HttpClientMetricsCollection m_httpRequestMetrics;
@@ -40,6 +40,19 @@ namespace Aws
             HTTP_PATCH
         };
 
+        /**
+         * HTTP protocol version to ask the http client for.
+         */
+        enum class Version
+        {
+            HTTP_VERSION_NONE, // let the http client pick its default
+            HTTP_VERSION_1_0,
+            HTTP_VERSION_1_1,
+            HTTP_VERSION_2_0, // HTTP/2, upgrading from HTTP/1.1 on plain text connections
+            HTTP_VERSION_2TLS, // HTTP/2 over TLS only, HTTP/1.1 on plain text connections
+            HTTP_VERSION_2_PRIOR_KNOWLEDGE // HTTP/2 without upgrade, the server must accept HTTP/2 right away
+        };
+
         /**
          * Possible default http factory vended http client implementations.
          */
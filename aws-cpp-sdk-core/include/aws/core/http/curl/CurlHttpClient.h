@@ -19,6 +19,7 @@
 #include <aws/core/Core_EXPORTS.h>
 #include <aws/core/http/HttpClient.h>
 #include <aws/core/http/curl/CurlHandleContainer.h>
+#include <aws/core/http/curl/CurlMultiplexer.h>
 #include <aws/core/client/ClientConfiguration.h>
 #include <aws/core/utils/memory/stl/AWSString.h>
 #include <atomic>
@@ -66,6 +67,9 @@ private:
     Aws::String m_caFile;
     bool m_disableExpectHeader;
     bool m_allowRedirects;
+    Aws::Http::Version m_version;
+    // set when requests are multiplexed over shared HTTP/2 connections instead of performed one connection per request
+    std::shared_ptr<CurlMultiplexer> m_multiplexer;
     static std::atomic<bool> isInit;
 
     void MakeRequestInternal(HttpRequest& request, std::shared_ptr<Standard::StandardHttpResponse>& response,
@@ -80,6 +84,8 @@ private:
     static size_t WriteData(char* ptr, size_t size, size_t nmemb, void* userdata);
     //callback to write the headers from the response to the response
     static size_t WriteHeader(char* ptr, size_t size, size_t nmemb, void* userdata);
+    //callback curl invokes periodically, even while no data flows, so the request can be aborted while waiting on the network
+    static int CurlProgressCallback(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
 
 };
 
@@ -0,0 +1,129 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  * 
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  * 
+  *  http://aws.amazon.com/apache2.0
+  * 
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#pragma once
+
+#include <aws/core/utils/memory/stl/AWSVector.h>
+#include <aws/core/utils/memory/stl/AWSSet.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <curl/curl.h>
+
+namespace Aws
+{
+namespace Http
+{
+
+/**
+  * Drives curl easy handles from many threads over one shared curl multi handle, so that concurrent requests to the same host
+  * are multiplexed as HTTP/2 streams over a few connections instead of each holding a connection of its own.
+  * Callers block in Perform() while a single background thread runs all transfers. Body data is handed between that thread and the caller
+  * through small per-transfer buffers, so stream I/O, data event handlers, rate limiting and the checks for cancellation run on the caller's
+  * thread; a transfer whose caller falls behind is paused on its own without holding up the others.
+  */
+class CurlMultiplexer
+{
+public:
+    /**
+      * Moves the body data of one transfer. Called on the thread waiting in Perform(), except for OnSeek.
+      */
+    class BodyHandler
+    {
+    public:
+        virtual ~BodyHandler() = default;
+
+        /**
+          * Consumes length bytes of response body. Returns false to abort the transfer.
+          */
+        virtual bool OnReceived(char* data, size_t length) = 0;
+
+        /**
+          * Whether the request has a body, and OnSend and OnSeek will be called.
+          */
+        virtual bool HasRequestBody() const = 0;
+
+        /**
+          * Fills buffer with up to length bytes of request body, like a CURLOPT_READFUNCTION: 0 ends the body and CURL_READFUNC_ABORT aborts the transfer.
+          */
+        virtual size_t OnSend(char* buffer, size_t length) = 0;
+
+        /**
+          * Repositions the request body, like a CURLOPT_SEEKFUNCTION. Runs on the multiplexer thread, never while OnSend runs, so it must be quick.
+          */
+        virtual int OnSeek(curl_off_t offset, int origin) = 0;
+
+        /**
+          * Whether the transfer should go on. Called whenever the waiting thread wakes up, and at least every 100ms; false aborts the transfer.
+          * Replaces the handle's progress function.
+          */
+        virtual bool ShouldContinue() = 0;
+    };
+
+    /**
+      * maxConnections caps connections per host, maxConcurrentStreams caps streams per connection (if libcurl supports the limit).
+      * Transfers beyond that wait in curl until a stream frees up.
+      */
+    CurlMultiplexer(unsigned maxConnections, unsigned maxConcurrentStreams);
+    ~CurlMultiplexer();
+
+    /**
+      * Runs the transfer configured on handle and blocks until it completes. Returns what curl_easy_perform would have returned.
+      * If body is set, it replaces the handle's write, read, seek and progress functions and is called on this thread.
+      * The handle must not be used by the caller until this returns.
+      */
+    CURLcode Perform(CURL* handle, BodyHandler* body = nullptr);
+
+    /**
+      * Number of transfers currently handed to the multiplexer, over all hosts and connections.
+      */
+    size_t GetActiveTransfers() const { return m_activeTransfers.load(); }
+
+private:
+    CurlMultiplexer(const CurlMultiplexer&) = delete;
+    const CurlMultiplexer& operator = (const CurlMultiplexer&) = delete;
+    CurlMultiplexer(const CurlMultiplexer&&) = delete;
+    const CurlMultiplexer& operator = (const CurlMultiplexer&&) = delete;
+
+    struct Transfer;
+
+    static size_t WriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static size_t ReadCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static int SeekCallback(void* userdata, curl_off_t offset, int origin);
+    static int ProgressCallback(void* userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t);
+
+    void Run();
+    void AddPendingTransfers();
+    void ResumeTransfers();
+    void CompleteFinishedTransfers();
+    void CompleteTransfer(Transfer* transfer, CURLcode result);
+    void RequestResume(Transfer* transfer);
+    void WakeUp();
+
+    CURLM* m_multiHandle;
+    std::mutex m_lock;
+    Aws::Vector<Transfer*> m_pendingTransfers;
+    /// paused transfers whose caller has made room for them to go on
+    Aws::Vector<Transfer*> m_resumingTransfers;
+    /// transfers added to the multi handle, only touched by m_thread
+    Aws::Set<Transfer*> m_runningTransfers;
+    std::atomic<size_t> m_activeTransfers;
+    std::atomic<bool> m_shutdown;
+    std::thread m_thread;
+};
+
+} // namespace Http
+} // namespace Aws
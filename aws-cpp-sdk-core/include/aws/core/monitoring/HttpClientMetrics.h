@@ -79,6 +79,19 @@ namespace Aws
              */
             SslLatency,
 
+            /**
+             * Requires the SDK to know which HTTP version the response was received over,
+             * contains 10, 11 or 20 for HTTP/1.0, HTTP/1.1 and HTTP/2.
+             */
+            HttpVersion,
+
+            /**
+             * Requires the http client to multiplex requests over shared connections,
+             * contains the number of requests in flight on the client, this one included, when the request was started.
+             * This counts requests over all hosts and connections, not the streams on the request's own connection.
+             */
+            MultiplexedRequestsInFlight,
+
             /**
              * Unknow Metrics Type
              */
@@ -87,6 +87,12 @@ namespace Aws
             */
             static ByteBuffer CalculateMD5(Aws::IOStream& stream);
 
+            /**
+            * Calculates a CRC32 checksum (the IEEE polynomial, as used by event stream messages and zlib). Pass the checksum of the
+            * preceding data as crc to continue it. Uses the CPU's carry-less multiply or CRC32 instructions where there are any.
+            */
+            static uint32_t CalculateCRC32(const unsigned char* data, size_t length, uint32_t crc = 0);
+
             static int HashString(const char* strToHash);
 
         };
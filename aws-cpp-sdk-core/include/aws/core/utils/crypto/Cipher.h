@@ -27,6 +27,11 @@ namespace Aws
         {
             static const size_t SYMMETRIC_KEY_LENGTH = 32;
             static const size_t MIN_IV_LENGTH = 12;
+            /**
+             * Largest block size of the symmetric ciphers we ship. The span based EncryptBufferInto() and DecryptBufferInto() calls need this
+             * much room on top of the input, since a block mode cipher may flush data held back by the previous call.
+             */
+            static const size_t MAX_SYMMETRIC_BLOCK_SIZE = 16;
 
             AWS_CORE_API CryptoBuffer IncrementCTRCounter(const CryptoBuffer& counter, uint32_t numberOfBlocks);
 
@@ -139,6 +144,21 @@ namespace Aws
                  */
                 virtual CryptoBuffer FinalizeDecryption () = 0;
 
+                /**
+                 * Same as EncryptBuffer(), but reads from and writes to caller owned memory instead of allocating a CryptoBuffer per call.
+                 * output must have room for at least length + MAX_SYMMETRIC_BLOCK_SIZE bytes. For the stream modes (CTR and GCM) output
+                 * may be the same memory as the input. Returns the number of bytes written; on failure returns 0 and the cipher goes bad.
+                 *
+                 * The default implementation goes through EncryptBuffer(), implementations backed by a library that can write into the caller's
+                 * memory should override it.
+                 */
+                virtual size_t EncryptBufferInto(const unsigned char* unEncryptedData, size_t length, unsigned char* output, size_t outputCapacity);
+
+                /**
+                 * Same as DecryptBuffer(), but reads from and writes to caller owned memory. Same contract as EncryptBufferInto().
+                 */
+                virtual size_t DecryptBufferInto(const unsigned char* encryptedData, size_t length, unsigned char* output, size_t outputCapacity);
+
                 virtual void Reset() = 0;
 
                 /**
@@ -170,6 +190,11 @@ namespace Aws
             protected:
                 SymmetricCipher() : m_failure(false) {}
 
+                /**
+                 * Copies the output of a CryptoBuffer based call into caller owned memory for the span based calls. Fails the cipher if it doesn't fit.
+                 */
+                size_t CopyToOutput(const CryptoBuffer& result, unsigned char* output, size_t outputCapacity);
+
                 CryptoBuffer m_key;
                 CryptoBuffer m_initializationVector;
                 CryptoBuffer m_tag;
@@ -109,6 +109,14 @@ namespace Aws
                     return m_contentCryptoScheme;
                 }
 
+                /**
+                * Gets the length of the content the key encrypts, or -1 if it isn't known, as for a multipart upload.
+                */
+                inline int64_t GetUnencryptedContentLength() const
+                {
+                    return m_unencryptedContentLength;
+                }
+
                 /**
                 * Sets the underlying content encryption key. Copies from parameter content encryption key.
                 */
@@ -173,6 +181,14 @@ namespace Aws
                     m_contentCryptoScheme = contentCryptoScheme;
                 }
 
+                /**
+                * Sets the length of the content the key encrypts, for encryption materials that limit how much one key encrypts.
+                */
+                inline void SetUnencryptedContentLength(int64_t unencryptedContentLength)
+                {
+                    m_unencryptedContentLength = unencryptedContentLength;
+                }
+
             private:
                 Aws::Utils::CryptoBuffer m_contentEncryptionKey;
                 Aws::Utils::CryptoBuffer m_encryptedContentEncryptionKey;
@@ -181,6 +197,7 @@ namespace Aws
                 Aws::Map<Aws::String, Aws::String> m_materialsDescription;
                 KeyWrapAlgorithm m_keyWrapAlgorithm;
                 ContentCryptoScheme m_contentCryptoScheme;
+                int64_t m_unencryptedContentLength;
             };
         }
     }
@@ -26,7 +26,16 @@ namespace Aws
         {
             typedef std::mbstate_t FPOS_TYPE;
             static const size_t DEFAULT_BUF_SIZE = 1024;
+            /**
+             * Buffer size for bulk encryption and decryption. With AES-NI the cipher itself runs at several GB/s, so at DEFAULT_BUF_SIZE the
+             * per call overhead dominates; pass this (or larger) as bufferSize when moving a lot of data through the streambufs.
+             */
+            static const size_t HIGH_THROUGHPUT_BUF_SIZE = 1024 * 1024;
             static const size_t PUT_BACK_SIZE = 1;
+            /**
+             * The streambufs hand the cipher buffers aligned to this, so the vectorized cipher code never starts on a split cache line.
+             */
+            static const size_t CRYPTO_BUF_ALIGNMENT = 64;
 
             /**
              * Which mode a cipher is being used for. Encryption or Decryption
@@ -68,7 +77,8 @@ namespace Aws
                  * stream to src from
                  * cipher to encrypt or decrypt the src stream with
                  * mode to use cipher in. Encryption or Decyption
-                 * buffersize, the size of the src buffers to read at a time. Defaults to 1kb
+                 * buffersize, the size of the src buffers to read at a time. Defaults to 1kb, use HIGH_THROUGHPUT_BUF_SIZE for bulk data.
+                 *  The read and cipher buffers are allocated once, up front, and the cipher writes straight into the get area.
                  */
                 SymmetricCryptoBufSrc(Aws::IStream& stream, SymmetricCipher& cipher, CipherMode cipherMode, size_t bufferSize = DEFAULT_BUF_SIZE);
 
@@ -78,7 +88,7 @@ namespace Aws
                 SymmetricCryptoBufSrc& operator=(const SymmetricCryptoBufSrc&) = delete;
                 SymmetricCryptoBufSrc& operator=(SymmetricCryptoBufSrc&&) = delete;
 
-                virtual ~SymmetricCryptoBufSrc() { FinalizeCipher(); }
+                virtual ~SymmetricCryptoBufSrc();
 
                 /**
                  * This call isn't necessary if you loop over the stream.read until you reach EOF, if you happen to read the exact
@@ -95,14 +105,19 @@ namespace Aws
                 int_type underflow() override;
                 off_type ComputeAbsSeekPosition(off_type, std::ios_base::seekdir,  std::fpos<FPOS_TYPE>);
                 void FinalizeCipher();
+                size_t TransformNextChunk(size_t maxRead);
 
-                CryptoBuffer m_isBuf;
+                ByteBuffer m_isBuf;
+                ByteBuffer m_readBuf;
                 SymmetricCipher& m_cipher;
                 Aws::IStream& m_stream;
                 CipherMode m_cipherMode;
                 bool m_isFinalized;
                 size_t m_bufferSize;
                 size_t m_putBack;
+                unsigned char* m_dataStart;
+                unsigned char* m_readStart;
+                size_t m_bytesUsed;
             };
 
             /**
@@ -119,7 +134,7 @@ namespace Aws
                  * stream, sink to push the encrypted or decrypted data to.
                  * cipher, symmetric cipher to use to transform the input before sending it to the sink.
                  * cipherMode, encrypt or decrypt
-                 * bufferSize, amount of data to encrypt/decrypt at a time.
+                 * bufferSize, amount of data to encrypt/decrypt at a time. Use HIGH_THROUGHPUT_BUF_SIZE for bulk data.
                  */
                 SymmetricCryptoBufSink(Aws::OStream& stream, SymmetricCipher& cipher, CipherMode cipherMode, size_t bufferSize = DEFAULT_BUF_SIZE, int16_t blockOffset = 0);
                 SymmetricCryptoBufSink(const SymmetricCryptoBufSink&) = delete;
@@ -147,12 +162,16 @@ namespace Aws
                 int sync() override;
                 bool writeOutput(bool finalize);
 
-                CryptoBuffer m_osBuf;
+                ByteBuffer m_osBuf;
+                ByteBuffer m_cipherOutBuf;
                 SymmetricCipher& m_cipher;
                 Aws::OStream& m_stream;
                 CipherMode m_cipherMode;
                 bool m_isFinalized;
                 int16_t m_blockOffset;
+                unsigned char* m_cipherOut;
+                size_t m_cipherOutCapacity;
+                size_t m_bytesUsed;
             };
         }
     }
@@ -42,6 +42,7 @@ namespace Aws
 
                 /*
                 * Override this method to control how to encrypt the content encryption key (CEK). This occurs in place.
+                * The CEK may also be replaced, with one encrypted earlier say; the content is encrypted with whichever CEK this leaves.
                 */
                 virtual CryptoOutcome EncryptCEK(ContentCryptoMaterial& contentCryptoMaterial) = 0;
 
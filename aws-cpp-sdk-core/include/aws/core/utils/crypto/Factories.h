@@ -62,6 +62,43 @@ namespace Aws
              */
             AWS_CORE_API std::shared_ptr<HMAC> CreateSha256HMACImplementation();
 
+            /**
+             * Get the calling thread's MD5 Hash provider. It is created on first use, and again after the factory changes, so one-shot
+             * hashes don't create a provider each. Use it on the calling thread only.
+             */
+            AWS_CORE_API std::shared_ptr<Hash> GetThreadMD5Implementation();
+            /**
+             * Get the calling thread's Sha256 Hash provider. It is created on first use, and again after the factory changes, so one-shot
+             * hashes don't create a provider each. Use it on the calling thread only.
+             */
+            AWS_CORE_API std::shared_ptr<Hash> GetThreadSha256Implementation();
+            /**
+             * Get the calling thread's Sha256 HMACHash provider. It is created on first use, and again after the factory changes, so
+             * one-shot HMACs don't create a provider each. Use it on the calling thread only.
+             */
+            AWS_CORE_API std::shared_ptr<HMAC> GetThreadSha256HMACImplementation();
+
+            /**
+             * Contexts the calling thread's hash, HMAC and cipher providers have created, and reused from the thread's pools, so far.
+             */
+            struct CryptoContextPoolStats
+            {
+                size_t contextsCreated;
+                size_t contextsReused;
+            };
+
+            /**
+             * With OpenSSL, each thread keeps a few idle digest, HMAC and cipher contexts, and the default providers borrow them
+             * rather than creating and freeing contexts for each hash or cipher. Sets how many contexts of each kind a thread keeps,
+             * 8 by default and at most 16; 0 turns the pools off. Other crypto implementations have no pools.
+             */
+            AWS_CORE_API void SetCryptoContextPoolSize(size_t contextsPerThread);
+            /**
+             * Get the calling thread's context pool counters; other threads' contexts are not counted. Both are 0 for crypto
+             * implementations without pools.
+             */
+            AWS_CORE_API CryptoContextPoolStats GetThreadCryptoContextPoolStats();
+
             /**
              * Create AES in CBC mode off of a 256 bit key. Auto Generates a 16 byte secure random IV
              */
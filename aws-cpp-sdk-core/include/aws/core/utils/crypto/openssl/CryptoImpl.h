@@ -43,6 +43,36 @@ namespace Aws
                 void locking_fn(int mode, int n, const char* file, int line);
 
                 unsigned long id_fn();
+
+                /**
+                 * Per thread pools of OpenSSL contexts. Acquire hands out one of the calling thread's idle contexts, or a new one.
+                 * Release keeps the context for reuse on the calling thread, up to the pool size, and frees it otherwise.
+                 * Digest contexts may be released as they are; HMAC and cipher contexts are to be cleaned up first, so that no
+                 * key material is kept in the pools.
+                 */
+                EVP_MD_CTX* AcquireMDContext();
+                void ReleaseMDContext(EVP_MD_CTX* ctx);
+                HMAC_CTX* AcquireHMACContext();
+                void ReleaseHMACContext(HMAC_CTX* ctx);
+                EVP_CIPHER_CTX* AcquireCipherContext();
+                void ReleaseCipherContext(EVP_CIPHER_CTX* ctx);
+
+                /**
+                 * Number of idle contexts of each kind a thread keeps, at most MAX_POOLED_CONTEXTS.
+                 */
+                void SetContextPoolSize(size_t contextsPerThread);
+
+                /**
+                 * Contexts the calling thread has created, and reused from its pools, so far.
+                 */
+                void GetContextPoolStats(size_t& created, size_t& reused);
+
+                /**
+                 * Frees the calling thread's idle contexts now, rather than when the thread exits.
+                 */
+                void FreeThreadContextPools();
+
+                static const size_t MAX_POOLED_CONTEXTS = 16;
             }
 
             /**
@@ -171,6 +201,16 @@ namespace Aws
                  */
                 CryptoBuffer FinalizeDecryption() override;
 
+                /**
+                 * Runs EVP_EncryptUpdate straight into output, no intermediate buffers.
+                 */
+                size_t EncryptBufferInto(const unsigned char* unEncryptedData, size_t length, unsigned char* output, size_t outputCapacity) override;
+
+                /**
+                 * Runs EVP_DecryptUpdate straight into output, no intermediate buffers.
+                 */
+                size_t DecryptBufferInto(const unsigned char* encryptedData, size_t length, unsigned char* output, size_t outputCapacity) override;
+
                 void Reset() override;
 
             protected:
@@ -350,6 +390,12 @@ namespace Aws
                 CryptoBuffer DecryptBuffer(const CryptoBuffer&) override;
                 CryptoBuffer FinalizeDecryption() override;
 
+                /**
+                 * Key wrap doesn't stream, so these go through EncryptBuffer() and DecryptBuffer() like the base class does.
+                 */
+                size_t EncryptBufferInto(const unsigned char* unEncryptedData, size_t length, unsigned char* output, size_t outputCapacity) override;
+                size_t DecryptBufferInto(const unsigned char* encryptedData, size_t length, unsigned char* output, size_t outputCapacity) override;
+
                 void Reset() override;
 
             protected:
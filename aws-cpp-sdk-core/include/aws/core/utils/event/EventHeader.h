@@ -97,6 +97,12 @@ namespace Aws
                     }
                 };
 
+                /**
+                 * Build a header value from its encoding in a message: big-endian for the integer and timestamp types, the bytes
+                 * themselves for BYTE_BUF, STRING and UUID, and nothing for the booleans.
+                 */
+                EventHeaderValue(EventHeaderType type, const unsigned char* value, size_t valueLength);
+
                 static EventHeaderType GetEventHeaderTypeForName(const Aws::String& name);
                 static Aws::String GetNameForEventHeaderType(EventHeaderType value);
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2010-2018 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <aws/core/Core_EXPORTS.h>
+#include <aws/core/utils/event/EventHeader.h>
+#include <cstring>
+
+namespace Aws
+{
+    namespace Utils
+    {
+        namespace Event
+        {
+            /**
+             * A header of a message decoded in place. Its name and value point into the buffer the message was received in,
+             * so they are only valid while that message is being handled.
+             */
+            class AWS_CORE_API EventHeaderView
+            {
+            public:
+                EventHeaderView() :
+                    m_name(nullptr), m_nameLength(0), m_type(EventHeaderValue::EventHeaderType::UNKNOWN), m_value(nullptr), m_valueLength(0)
+                {}
+
+                EventHeaderView(const char* name, size_t nameLength, EventHeaderValue::EventHeaderType type, const unsigned char* value, size_t valueLength) :
+                    m_name(name), m_nameLength(nameLength), m_type(type), m_value(value), m_valueLength(valueLength)
+                {}
+
+                /**
+                 * Header name, not null terminated.
+                 */
+                inline const char* GetName() const { return m_name; }
+                inline size_t GetNameLength() const { return m_nameLength; }
+
+                /**
+                 * Whether the header is named name.
+                 */
+                inline bool NameEquals(const char* name) const
+                {
+                    return strlen(name) == m_nameLength && memcmp(m_name, name, m_nameLength) == 0;
+                }
+
+                inline EventHeaderValue::EventHeaderType GetType() const { return m_type; }
+
+                /**
+                 * Header value as it is on the wire: big-endian for the integer and timestamp types, the bytes themselves for
+                 * BYTE_BUF, STRING and UUID, and empty for the booleans.
+                 */
+                inline const unsigned char* GetValue() const { return m_value; }
+                inline size_t GetValueLength() const { return m_valueLength; }
+
+                /**
+                 * Whether this is a STRING header with the value str.
+                 */
+                inline bool ValueEquals(const char* str) const
+                {
+                    return m_type == EventHeaderValue::EventHeaderType::STRING && strlen(str) == m_valueLength && memcmp(m_value, str, m_valueLength) == 0;
+                }
+
+                /**
+                 * Copy the value out of the receive buffer.
+                 */
+                inline EventHeaderValue ToEventHeaderValue() const { return EventHeaderValue(m_type, m_value, m_valueLength); }
+
+            private:
+                const char* m_name;
+                size_t m_nameLength;
+                EventHeaderValue::EventHeaderType m_type;
+                const unsigned char* m_value;
+                size_t m_valueLength;
+            };
+
+            /**
+             * A message decoded in place, with its checksums verified. Its headers and payload point into the buffer the message was
+             * received in, so they are only valid while the message is being handled; copy out whatever has to outlive that.
+             */
+            class AWS_CORE_API EventMessageView
+            {
+            public:
+                EventMessageView(const EventHeaderView* headers, size_t headerCount, const unsigned char* payload, size_t payloadLength,
+                    size_t totalLength, size_t headersLength) :
+                    m_headers(headers), m_headerCount(headerCount), m_payload(payload), m_payloadLength(payloadLength),
+                    m_totalLength(totalLength), m_headersLength(headersLength)
+                {}
+
+                inline const EventHeaderView* GetHeaders() const { return m_headers; }
+                inline size_t GetHeaderCount() const { return m_headerCount; }
+
+                /**
+                 * Find the header named name, or return nullptr if the message has none.
+                 */
+                inline const EventHeaderView* FindHeader(const char* name) const
+                {
+                    for (size_t i = 0; i < m_headerCount; ++i)
+                    {
+                        if (m_headers[i].NameEquals(name))
+                        {
+                            return &m_headers[i];
+                        }
+                    }
+                    return nullptr;
+                }
+
+                inline const unsigned char* GetPayload() const { return m_payload; }
+                inline size_t GetPayloadLength() const { return m_payloadLength; }
+                inline size_t GetTotalLength() const { return m_totalLength; }
+                inline size_t GetHeadersLength() const { return m_headersLength; }
+
+            private:
+                const EventHeaderView* m_headers;
+                size_t m_headerCount;
+                const unsigned char* m_payload;
+                size_t m_payloadLength;
+                size_t m_totalLength;
+                size_t m_headersLength;
+            };
+        }
+    }
+}
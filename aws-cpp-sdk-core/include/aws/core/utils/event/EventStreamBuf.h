@@ -39,6 +39,11 @@ namespace Aws
                  * @param bufferSize The length of buffer, wiil be 1024 bytes by default.
                  */
                 EventStreamBuf(EventStreamDecoder& decoder, size_t bufferLength = DEFAULT_BUF_SIZE);
+
+                /**
+                 * Pumps what is left in the buffer to the decoder, and waits for the messages the decoder dispatched to an executor to be
+                 * handled.
+                 */
                 virtual ~EventStreamBuf();
 
             protected:
@@ -47,6 +52,11 @@ namespace Aws
 
                 int underflow() override;
                 int overflow(int ch) override;
+                /**
+                 * Writes of a buffer's length or more are pumped to the decoder straight from the caller's data, without being
+                 * copied into the buffer first.
+                 */
+                std::streamsize xsputn(const char* s, std::streamsize n) override;
                 int sync() override;
 
             private:
@@ -16,26 +16,84 @@
 #pragma once
 
 #include <aws/core/Core_EXPORTS.h>
+#include <aws/core/http/HttpRequest.h>
 #include <aws/core/utils/Array.h>
 #include <aws/core/utils/event/EventStreamHandler.h>
+#include <aws/core/utils/event/EventMessageView.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
 #include <aws/event-stream/event_stream.h>
+#include <memory>
 
 namespace Aws
 {
     namespace Utils
     {
+        namespace Threading
+        {
+            class Executor;
+        }
+
         namespace Event
         {
+            /**
+             * How a decoder hands messages to its handler.
+             */
+            enum class EventStreamDecodingMode
+            {
+                /**
+                 * aws-c-event-stream decodes the stream; each message's headers and payload are copied into the handler,
+                 * then its OnEvent is called.
+                 */
+                MESSAGES,
+                /**
+                 * Messages are decoded in place and their checksums verified with hardware CRC32 where the CPU has it.
+                 * Each is offered to the handler's OnMessageView as views into the receive buffer; messages the handler
+                 * doesn't take there are copied into it and handed to OnEvent as in MESSAGES mode.
+                 */
+                VIEWS
+            };
+
+            // how many bytes of decoded messages may wait for their handler before the decoder stops taking data, and how few
+            // must be left before it takes data again
+            static const size_t DEFAULT_DISPATCH_HIGH_WATERMARK = 8 * 1024 * 1024;
+            static const size_t DEFAULT_DISPATCH_LOW_WATERMARK = 2 * 1024 * 1024;
+
             class AWS_CORE_API EventStreamDecoder
             {
             public:
-                EventStreamDecoder(EventStreamHandler* handler);
+                EventStreamDecoder(EventStreamHandler* handler, EventStreamDecodingMode mode = EventStreamDecodingMode::MESSAGES);
                 ~EventStreamDecoder();
 
                 /**
                  * Whether or not the decoder is in good state. Return false if the decoder encounters errors.
                  */
-                inline operator bool() const { return *m_eventStreamHandler; }
+                operator bool() const;
+
+                /**
+                 * Run the handler on the executor rather than on the thread pumping data, so a slow handler doesn't hold up receiving.
+                 * Messages are queued for the handler in the order they arrive and handled one at a time. Once highWatermark bytes are
+                 * queued, IsReadyForData returns false, and Pump waits, until the handler has brought them down to lowWatermark.
+                 * The executor must not be the one pumping data. Switches the decoder to VIEWS mode; pass nullptr to run the handler on
+                 * the pumping thread again.
+                 */
+                void SetDispatchExecutor(const std::shared_ptr<Aws::Utils::Threading::Executor>& executor,
+                    size_t highWatermark = DEFAULT_DISPATCH_HIGH_WATERMARK, size_t lowWatermark = DEFAULT_DISPATCH_LOW_WATERMARK);
+
+                /**
+                 * Whether the decoder can take more data without going over its dispatch high watermark. Always true without an executor.
+                 */
+                bool IsReadyForData() const;
+
+                /**
+                 * A response flow control handler that holds off the response while the dispatched messages are over the watermarks,
+                 * or an empty one without an executor. It keeps what it needs alive, so it may outlive the decoder.
+                 */
+                Aws::Http::ResponseFlowControlHandler GetResponseFlowControlHandler() const;
+
+                /**
+                 * Wait until the handler has handled every message pumped so far. Returns at once without an executor.
+                 */
+                void WaitForDispatchedMessages();
 
                 /**
                  * A wrapper of aws_event_stream_streaming_decoder_pump in aws-c-event-stream.
@@ -43,9 +101,11 @@ namespace Aws
                  */
                 void Pump(const ByteBuffer& data);
                 void Pump(const ByteBuffer& data, size_t length);
+                void Pump(const unsigned char* data, size_t length);
 
                 /**
-                 * Reset decoder and it's handler.
+                 * Reset decoder and it's handler. In VIEWS mode, this drops any partially received message. With an executor, this
+                 * waits for the dispatched messages first.
                  */
                 void Reset();
 
@@ -113,6 +173,32 @@ namespace Aws
                  */
                 aws_event_stream_streaming_decoder m_decoder;
                 EventStreamHandler* m_eventStreamHandler;
+
+            private:
+                struct DispatchQueue;
+
+                /**
+                 * Decode whole messages in place from data, and keep any trailing partial message in m_pendingMessage.
+                 */
+                void PumpViews(const unsigned char* data, size_t length);
+                /**
+                 * Check a message's prelude and get its total and headers lengths, or report it to the handler and return false.
+                 */
+                bool ReadPrelude(const unsigned char* prelude, uint32_t& totalLength, uint32_t& headersLength);
+                /**
+                 * Hand a complete message whose prelude has been checked to the handler, or queue a copy of it for the handler.
+                 */
+                void OnMessage(const unsigned char* message, uint32_t totalLength, uint32_t headersLength);
+                void OnDecodingError(EventStreamErrors error, const char* message);
+
+                EventStreamDecodingMode m_mode;
+                // a message split across pumps is gathered here; reused, so it allocates only when messages grow
+                Aws::Vector<unsigned char> m_pendingMessage;
+                uint32_t m_pendingMessageLength;
+                // headers of the message being handled, reused from message to message
+                Aws::Vector<EventHeaderView> m_headerViews;
+                // messages waiting for the handler on the dispatch executor, shared with the tasks draining them
+                std::shared_ptr<DispatchQueue> m_dispatchQueue;
             };
         }
     }
@@ -19,10 +19,12 @@
 #include <aws/core/http/HttpTypes.h>
 #include <aws/core/utils/event/EventHeader.h>
 #include <aws/core/utils/event/EventMessage.h>
+#include <aws/core/utils/event/EventMessageView.h>
 #include <aws/core/utils/event/EventStreamErrors.h>
 #include <aws/core/utils/memory/stl/AWSString.h>
 #include <aws/core/utils/memory/stl/AWSStreamFwd.h>
 #include <aws/core/utils/memory/stl/AWSStringStream.h>
+#include <aws/core/utils/UnreferencedParam.h>
 #include <cassert>
 
 namespace Aws
@@ -145,6 +147,17 @@ namespace Aws
                  */ 
                 virtual void OnEvent() = 0;
 
+                /**
+                 * Offered each message by a decoder in EventStreamDecodingMode::VIEWS, before anything is copied out of it.
+                 * The views are only valid during the call. Return true if the message has been handled; return false, as by
+                 * default, to have it copied into the handler and passed to OnEvent.
+                 */
+                virtual bool OnMessageView(const EventMessageView& message)
+                {
+                    AWS_UNREFERENCED_PARAM(message);
+                    return false;
+                }
+
             private:
                 bool m_failure;
                 EventStreamErrors m_internalError;
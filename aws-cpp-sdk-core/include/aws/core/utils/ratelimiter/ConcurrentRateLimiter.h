@@ -0,0 +1,302 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#pragma once
+
+#include <aws/core/Core_EXPORTS.h>
+
+#include <aws/core/utils/ratelimiter/RateLimiterInterface.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <functional>
+
+namespace Aws
+{
+    namespace Utils
+    {
+        namespace RateLimits
+        {
+            /**
+             * Token bucket rate limiter meant to be shared by many threads (e.g. the readRateLimiter of a client driving a parallel TransferManager download).
+             * The bucket is maintained with atomics instead of a mutex, and each thread draws credit from the bucket in batches of creditBatchSize,
+             * so most calls to ApplyCost only touch a per-thread credit slot. A thread claims a slot of its own the first time it calls ApplyCost and keeps it
+             * for the limiter's lifetime; once 64 threads have done so, further threads share the slots they hash to, so they contend on
+             * those slots and draw on each other's credit (which only affects speed, not the rate).
+             * If a parent limiter is supplied, every batch drawn from this limiter is also charged against the parent, which allows hierarchical limits
+             * (for example a process-wide limiter shared as the parent of per-client limiters).
+             *
+             * Unlike DefaultRateLimiter, rate changes are not renormalized: outstanding debt is preserved as-is.
+             * The bucket is kept in microseconds, so with a coarse DUR the rate is capped at what fits in it (about 2.5e9 per hour), and the debt
+             * saturates rather than overflowing.
+             */
+            template<typename CLOCK = std::chrono::high_resolution_clock, typename DUR = std::chrono::seconds>
+            class ConcurrentRateLimiter : public RateLimiterInterface
+            {
+            public:
+                using Base = RateLimiterInterface;
+
+                using InternalTimePointType = std::chrono::time_point<CLOCK>;
+                using ElapsedTimeFunctionType = std::function< InternalTimePointType() >;
+
+                /**
+                 * maxRate is the allowed cost per DUR.
+                 * creditBatchSize is the amount of credit a thread draws from the shared bucket at once; 0 derives it from maxRate.
+                 * parent, if set, is charged for every batch drawn from this limiter.
+                 */
+                ConcurrentRateLimiter(int64_t maxRate, int64_t creditBatchSize = 0, const std::shared_ptr<RateLimiterInterface>& parent = nullptr,
+                                      ElapsedTimeFunctionType elapsedTimeFunction = CLOCK::now) :
+                    m_elapsedTimeFunction(elapsedTimeFunction),
+                    m_parent(parent),
+                    m_maxRate(0),
+                    m_requestedCreditBatchSize(creditBatchSize),
+                    m_creditBatchSize(0),
+                    m_bucket(0),
+                    m_lastReplenished(0)
+                {
+                    static_assert(TICKS_PER_DURATION > 0, "Rate duration must be at least one microsecond");
+
+                    ConcurrentRateLimiter::SetRate(maxRate, true);
+                }
+
+                virtual ~ConcurrentRateLimiter() = default;
+
+                /**
+                 * Calculates time in milliseconds that should be delayed before letting anymore data through.
+                 */
+                virtual DelayType ApplyCost(int64_t cost) override
+                {
+                    CreditSlot& slot = GetCreditSlot();
+
+                    // fast path: pay out of the credit this thread already drew from the bucket
+                    if (cost > 0)
+                    {
+                        int64_t credit = slot.m_credit.load(std::memory_order_relaxed);
+                        while (credit >= cost)
+                        {
+                            if (slot.m_credit.compare_exchange_weak(credit, credit - cost, std::memory_order_relaxed))
+                            {
+                                return DelayType(0);
+                            }
+                        }
+                    }
+
+                    Replenish();
+
+                    // draw a whole batch from the shared bucket and keep whatever this call doesn't need as credit
+                    int64_t grant = cost > 0 ? (std::max)(cost, m_creditBatchSize.load(std::memory_order_relaxed)) : 0;
+                    int64_t charge = ToTicks(grant);
+                    int64_t previous = m_bucket.load(std::memory_order_relaxed);
+                    while (!m_bucket.compare_exchange_weak(previous, SaturatingSubtract(previous, charge), std::memory_order_acq_rel))
+                    {
+                    }
+                    if (grant > cost)
+                    {
+                        slot.m_credit.fetch_add(grant - cost, std::memory_order_relaxed);
+                    }
+
+                    // same semantics as DefaultRateLimiter: the delay is based on the debt before this cost, the next caller pays for it
+                    DelayType delay(0);
+                    if (previous < 0)
+                    {
+                        int64_t debt = previous == INT64_MIN_VALUE ? INT64_MAX_VALUE : -previous;
+                        delay = std::chrono::duration_cast<DelayType>(TickType(debt / m_maxRate.load(std::memory_order_relaxed)));
+                    }
+
+                    if (m_parent)
+                    {
+                        delay = (std::max)(delay, m_parent->ApplyCost(grant));
+                    }
+
+                    return delay;
+                }
+
+                /**
+                 * Same as ApplyCost() but then goes ahead and sleeps the current thread.
+                 */
+                virtual void ApplyAndPayForCost(int64_t cost) override
+                {
+                    auto costInMilliseconds = ApplyCost(cost);
+                    if(costInMilliseconds.count() > 0)
+                    {
+                        std::this_thread::sleep_for(costInMilliseconds);
+                    }
+                }
+
+                /**
+                 * Update the bandwidth rate to allow. Resetting the accumulator also discards the credit held by threads.
+                 */
+                virtual void SetRate(int64_t rate, bool resetAccumulator = false) override
+                {
+                    // rate must always be positive, and a full bucket must fit in the tick count
+                    rate = (std::max)(static_cast<int64_t>(1), rate);
+                    rate = rate > MAX_RATE ? MAX_RATE : rate;
+
+                    if (resetAccumulator)
+                    {
+                        for (auto& slot : m_creditSlots)
+                        {
+                            slot.m_credit.store(0, std::memory_order_relaxed);
+                        }
+                        m_lastReplenished.store(GetCurrentTicks(), std::memory_order_relaxed);
+                        m_bucket.store(ToTicks(rate), std::memory_order_relaxed);
+                    }
+                    else
+                    {
+                        // sync the bucket to current time using the old rate
+                        Replenish();
+                    }
+
+                    m_maxRate.store(rate, std::memory_order_relaxed);
+
+                    // by default a batch is a small fraction of the rate so credit parked on idle threads stays well below one period's budget
+                    int64_t batchSize = m_requestedCreditBatchSize > 0 ? m_requestedCreditBatchSize : rate / DEFAULT_BATCHES_PER_RATE;
+                    m_creditBatchSize.store((std::max)(static_cast<int64_t>(1), batchSize), std::memory_order_relaxed);
+                }
+
+            private:
+                /// The bucket is kept in microseconds of replenishment: one unit of cost is worth TICKS_PER_DURATION and each tick adds m_maxRate
+                using TickType = std::chrono::microseconds;
+                static const int64_t TICKS_PER_DURATION = std::chrono::duration_cast<TickType>(DUR(1)).count();
+
+                static const int64_t INT64_MAX_VALUE = (std::numeric_limits<int64_t>::max)();
+                static const int64_t INT64_MIN_VALUE = (std::numeric_limits<int64_t>::min)();
+                /// Highest rate whose full bucket fits in an int64_t of ticks
+                static const int64_t MAX_RATE = INT64_MAX_VALUE / TICKS_PER_DURATION;
+
+                static const size_t CREDIT_SLOT_COUNT = 64;
+                static const size_t CREDIT_SLOT_SHIFT = 58; // 64 - log2(CREDIT_SLOT_COUNT)
+                static const int64_t DEFAULT_BATCHES_PER_RATE = 256;
+                static const size_t CACHE_LINE_SIZE = 64;
+
+                /// Credit handed out to the thread owning this slot; padded so that slots don't share cache lines
+                struct CreditSlot
+                {
+                    CreditSlot() : m_owner(0), m_credit(0) {}
+
+                    /// Hash of the owning thread's id, 0 while the slot is free
+                    std::atomic<size_t> m_owner;
+                    std::atomic<int64_t> m_credit;
+                    char m_padding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(std::atomic<int64_t>)];
+                };
+
+                /**
+                 * Finds the slot owned by the calling thread, or claims a free one. Probing starts where the thread id hashes to,
+                 * so a thread usually finds its slot at the first try.
+                 */
+                CreditSlot& GetCreditSlot()
+                {
+                    size_t owner = std::hash<std::thread::id>()(std::this_thread::get_id());
+                    owner = owner != 0 ? owner : 1;
+                    // thread ids are often aligned addresses, so mix the hash before picking a slot
+                    size_t start = static_cast<size_t>((static_cast<uint64_t>(owner) * 0x9E3779B97F4A7C15ULL) >> CREDIT_SLOT_SHIFT);
+
+                    for (size_t probe = 0; probe < CREDIT_SLOT_COUNT; ++probe)
+                    {
+                        CreditSlot& slot = m_creditSlots[(start + probe) % CREDIT_SLOT_COUNT];
+                        size_t current = slot.m_owner.load(std::memory_order_relaxed);
+                        if (current == owner || (current == 0 && slot.m_owner.compare_exchange_strong(current, owner, std::memory_order_relaxed)))
+                        {
+                            return slot;
+                        }
+                    }
+
+                    // every slot is owned by another thread
+                    return m_creditSlots[start];
+                }
+
+                /**
+                 * Converts a non-negative cost to ticks, saturating at the largest tick count.
+                 */
+                static int64_t ToTicks(int64_t cost)
+                {
+                    return cost > MAX_RATE ? INT64_MAX_VALUE : cost * TICKS_PER_DURATION;
+                }
+
+                /**
+                 * Subtracts a non-negative amount of ticks from the bucket, saturating at the largest debt.
+                 */
+                static int64_t SaturatingSubtract(int64_t ticks, int64_t amount)
+                {
+                    return ticks < INT64_MIN_VALUE + amount ? INT64_MIN_VALUE : ticks - amount;
+                }
+
+                int64_t GetCurrentTicks() const
+                {
+                    return std::chrono::duration_cast<TickType>(m_elapsedTimeFunction().time_since_epoch()).count();
+                }
+
+                /**
+                 * Adds the replenishment accrued since the last update to the bucket. Only the thread that advances m_lastReplenished adds the elapsed time.
+                 */
+                void Replenish()
+                {
+                    int64_t now = GetCurrentTicks();
+                    int64_t last = m_lastReplenished.load(std::memory_order_relaxed);
+                    while (now > last)
+                    {
+                        if (m_lastReplenished.compare_exchange_weak(last, now, std::memory_order_acq_rel))
+                        {
+                            int64_t elapsed = now - last;
+                            int64_t rate = m_maxRate.load(std::memory_order_relaxed);
+                            int64_t capacity = ToTicks(rate);
+                            int64_t current = m_bucket.load(std::memory_order_relaxed);
+                            int64_t replenished = 0;
+                            do
+                            {
+                                // with a saturated debt the room itself doesn't fit in an int64_t
+                                int64_t room = current < capacity - INT64_MAX_VALUE ? INT64_MAX_VALUE : capacity - current;
+                                if (room <= 0)
+                                {
+                                    break;
+                                }
+                                // compare before multiplying so long idle periods can't overflow
+                                replenished = elapsed > room / rate ? capacity : current + elapsed * rate;
+                            } while (!m_bucket.compare_exchange_weak(current, replenished, std::memory_order_acq_rel));
+                            return;
+                        }
+                    }
+                }
+
+                /// Function that returns the current time
+                ElapsedTimeFunctionType m_elapsedTimeFunction;
+
+                /// Optional limiter charged for every batch drawn from this one
+                std::shared_ptr<RateLimiterInterface> m_parent;
+
+                /// The rate we want to limit to
+                std::atomic<int64_t> m_maxRate;
+
+                /// Batch size requested at construction, 0 if it should be derived from the rate
+                int64_t m_requestedCreditBatchSize;
+
+                /// Amount of credit drawn from the bucket at once
+                std::atomic<int64_t> m_creditBatchSize;
+
+                /// Shared bucket in ticks; goes negative when more has been handed out than has been replenished
+                std::atomic<int64_t> m_bucket;
+
+                /// Tick count of the last replenishment
+                std::atomic<int64_t> m_lastReplenished;
+
+                CreditSlot m_creditSlots[CREDIT_SLOT_COUNT];
+            };
+
+        } // namespace RateLimits
+    } // namespace Utils
+} // namespace Aws
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <aws/core/Core_EXPORTS.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+namespace Aws
+{
+    namespace Utils
+    {
+        namespace Threading
+        {
+            /**
+             * Lets a caller cancel a request, including all of its retries, from another thread, or bound the total time it may take with a deadline.
+             * Once cancelled, or once the deadline has passed, the token stays cancelled. A token may be shared by several requests.
+             */
+            class AWS_CORE_API CancellationToken
+            {
+            public:
+                /**
+                 * Initializes a token with no deadline that is cancelled only through Cancel().
+                 */
+                CancellationToken();
+                /**
+                 * Initializes a token that cancels itself once timeout has elapsed from now.
+                 */
+                explicit CancellationToken(std::chrono::milliseconds timeout);
+
+                /**
+                 * Cancels the token and wakes up anyone waiting on it.
+                 */
+                void Cancel();
+                /**
+                 * Sets the point in time after which the token is considered cancelled.
+                 */
+                void SetDeadline(std::chrono::steady_clock::time_point deadline);
+                /**
+                 * Returns true if Cancel() was called or the deadline has passed. Cheap enough to be polled from transfer callbacks.
+                 */
+                bool IsCancelled() const;
+                /**
+                 * Time left before the deadline, zero if the token is cancelled, and milliseconds::max() if there is no deadline.
+                 */
+                std::chrono::milliseconds GetRemainingTime() const;
+                /**
+                 * Blocks the current thread for up to duration, waking up early if the token is cancelled. Returns true if the token is cancelled.
+                 */
+                bool WaitFor(std::chrono::milliseconds duration) const;
+                /**
+                 * Registers callback to be called, on the cancelling thread, when Cancel() is called; it is called right away if that already happened.
+                 * Passing deadlines signal nobody, so anyone waiting for the token must also wait no longer than GetRemainingTime().
+                 * Returns an id for RemoveCancelCallback().
+                 */
+                size_t AddCancelCallback(std::function<void()>&& callback);
+                /**
+                 * Unregisters a callback added by AddCancelCallback(). A callback may still be running on the cancelling thread when this returns.
+                 */
+                void RemoveCancelCallback(size_t callbackId);
+
+            private:
+                std::atomic<bool> m_cancelled;
+                /// steady_clock ticks since its epoch, or max() if there is no deadline
+                std::atomic<std::chrono::steady_clock::rep> m_deadline;
+                mutable std::mutex m_mutex;
+                mutable std::condition_variable m_syncPoint;
+                Aws::Map<size_t, std::function<void()>> m_cancelCallbacks;
+                size_t m_nextCancelCallbackId;
+            };
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <aws/core/Core_EXPORTS.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Aws
+{
+    namespace Utils
+    {
+        namespace Threading
+        {
+            /**
+             * Runs tasks once their delay has elapsed, all of them from a single thread that is started with the first task.
+             * Tasks run on that thread one after another, so they should only decide what to do and hand any real work to an Executor.
+             * Tasks that are still pending when the queue is destroyed are dropped without running.
+             */
+            class AWS_CORE_API TimerQueue
+            {
+            public:
+                TimerQueue();
+                ~TimerQueue();
+
+                TimerQueue(const TimerQueue&) = delete;
+                TimerQueue& operator=(const TimerQueue&) = delete;
+
+                /**
+                 * Runs task once delay has elapsed from now.
+                 */
+                void Schedule(std::chrono::milliseconds delay, std::function<void()>&& task);
+
+            private:
+                void Run();
+
+                std::mutex m_lock;
+                std::condition_variable m_signal;
+                Aws::MultiMap<std::chrono::steady_clock::time_point, std::function<void()>> m_tasks;
+                std::thread m_thread;
+                bool m_running;
+            };
+        }
+    }
+}
@@ -22,6 +22,7 @@
 #include <aws/core/client/ClientConfiguration.h>
 #include <aws/core/client/CoreErrors.h>
 #include <aws/core/client/RetryStrategy.h>
+#include <aws/core/client/HedgingStrategy.h>
 #include <aws/core/http/HttpClient.h>
 #include <aws/core/http/HttpClientFactory.h>
 #include <aws/core/http/HttpResponse.h>
@@ -36,7 +37,13 @@
 #include <aws/core/Globals.h>
 #include <aws/core/utils/EnumParseOverflowContainer.h>
 #include <aws/core/utils/crypto/MD5.h>
+#include <aws/core/utils/threading/Executor.h>
+#include <aws/core/utils/threading/TimerQueue.h>
+#include <aws/core/utils/threading/CancellationToken.h>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <iterator>
 #include <aws/core/utils/HashingUtils.h>
 #include <aws/core/utils/crypto/Factories.h>
 #include <aws/core/http/URI.h>
@@ -79,6 +86,9 @@ AWSClient::AWSClient(const Aws::Client::ClientConfiguration& configuration,
     m_signerProvider(Aws::MakeUnique<Aws::Auth::DefaultAuthSignerProvider>(AWS_CLIENT_LOG_TAG, signer)),
     m_errorMarshaller(errorMarshaller),
     m_retryStrategy(configuration.retryStrategy),
+    m_hedgingStrategy(configuration.hedgingStrategy),
+    m_executor(configuration.executor),
+    m_hedgeTimer(configuration.hedgingStrategy && configuration.executor ? Aws::MakeShared<Aws::Utils::Threading::TimerQueue>(AWS_CLIENT_LOG_TAG) : nullptr),
     m_writeRateLimiter(configuration.writeRateLimiter),
     m_readRateLimiter(configuration.readRateLimiter),
     m_userAgent(configuration.userAgent),
@@ -94,6 +104,9 @@ AWSClient::AWSClient(const Aws::Client::ClientConfiguration& configuration,
     m_signerProvider(signerProvider),
     m_errorMarshaller(errorMarshaller),
     m_retryStrategy(configuration.retryStrategy),
+    m_hedgingStrategy(configuration.hedgingStrategy),
+    m_executor(configuration.executor),
+    m_hedgeTimer(configuration.hedgingStrategy && configuration.executor ? Aws::MakeShared<Aws::Utils::Threading::TimerQueue>(AWS_CLIENT_LOG_TAG) : nullptr),
     m_writeRateLimiter(configuration.writeRateLimiter),
     m_readRateLimiter(configuration.readRateLimiter),
     m_userAgent(configuration.userAgent),
@@ -174,10 +187,19 @@ HttpResponseOutcome AWSClient::AttemptExhaustively(const Aws::Http::URI& uri,
     HttpResponseOutcome outcome;
     Aws::Monitoring::CoreMetricsCollection coreMetrics;
     auto contexts = Aws::Monitoring::OnRequestStarted(this->GetServiceClientName(), request.GetServiceRequestName(), httpRequest);
+    const bool shouldHedge = m_hedgeTimer && m_hedgingStrategy->ShouldHedge(request, method);
+    const auto& cancellationToken = request.GetCancellationToken();
 
     for (long retries = 0;; retries++)
     {
-        outcome = AttemptOneRequest(httpRequest, request, signerName);
+        if (cancellationToken && cancellationToken->IsCancelled())
+        {
+            AWS_LOGSTREAM_DEBUG(AWS_CLIENT_LOG_TAG, "Request was cancelled or its deadline passed.");
+            outcome = HttpResponseOutcome(AWSError<CoreErrors>(CoreErrors::REQUEST_CANCELLED, "", "Request was cancelled or its deadline passed", false/*retryable*/));
+            break;
+        }
+
+        outcome = shouldHedge ? AttemptHedgedRequest(uri, method, httpRequest, request, signerName) : AttemptOneRequest(httpRequest, request, signerName);
         coreMetrics.httpClientMetrics = httpRequest->GetRequestMetrics();
         if (outcome.IsSuccess())
         {
@@ -194,6 +216,17 @@ HttpResponseOutcome AWSClient::AttemptExhaustively(const Aws::Http::URI& uri,
             break;
         }
 
+        if (cancellationToken && cancellationToken->IsCancelled())
+        {
+            AWS_LOGSTREAM_DEBUG(AWS_CLIENT_LOG_TAG, "Request was cancelled or its deadline passed.");
+            // keep a genuine service error, but an aborted transfer says nothing useful
+            if (outcome.GetError().GetResponseCode() == HttpResponseCode::REQUEST_NOT_MADE)
+            {
+                outcome = HttpResponseOutcome(AWSError<CoreErrors>(CoreErrors::REQUEST_CANCELLED, "", "Request was cancelled or its deadline passed", false/*retryable*/));
+            }
+            break;
+        }
+
         long sleepMillis = m_retryStrategy->CalculateDelayBeforeNextRetry(outcome.GetError(), retries);
         //AdjustClockSkew returns true means clock skew was the problem and skew was adjusted, false otherwise.
         //sleep if clock skew was NOT the problem. AdjustClockSkew may update error inside outcome.
@@ -204,6 +237,13 @@ HttpResponseOutcome AWSClient::AttemptExhaustively(const Aws::Http::URI& uri,
             break;
         }
 
+        // no point in waiting for a retry that would start after the deadline, return the error we have
+        if (cancellationToken && shouldSleep && cancellationToken->GetRemainingTime() <= std::chrono::milliseconds(sleepMillis))
+        {
+            AWS_LOGSTREAM_DEBUG(AWS_CLIENT_LOG_TAG, "Request deadline would pass before the next retry, giving up.");
+            break;
+        }
+
         AWS_LOGSTREAM_WARN(AWS_CLIENT_LOG_TAG, "Request failed, now waiting " << sleepMillis << " ms before attempting again.");
         if(request.GetBody())
         {
@@ -218,7 +258,15 @@ HttpResponseOutcome AWSClient::AttemptExhaustively(const Aws::Http::URI& uri,
 
         if (shouldSleep)
         {
-            m_httpClient->RetryRequestSleep(std::chrono::milliseconds(sleepMillis));
+            if (cancellationToken)
+            {
+                // also wakes up as soon as the token is cancelled; the check at the top of the loop then ends the request
+                m_httpClient->RetryRequestSleep(std::chrono::milliseconds(sleepMillis), *cancellationToken);
+            }
+            else
+            {
+                m_httpClient->RetryRequestSleep(std::chrono::milliseconds(sleepMillis));
+            }
         }
         httpRequest = CreateHttpRequest(uri, method, request.GetResponseStreamFactory());
         Aws::Monitoring::OnRequestRetry(this->GetServiceClientName(), request.GetServiceRequestName(), httpRequest, contexts);
@@ -289,8 +337,13 @@ HttpResponseOutcome AWSClient::AttemptOneRequest(const std::shared_ptr<HttpReque
     const Aws::AmazonWebServiceRequest& request, const char* signerName) const
 {
     BuildHttpRequest(request, httpRequest);
+    return AttemptBuiltRequest(httpRequest, request.SignBody(), signerName);
+}
+
+HttpResponseOutcome AWSClient::AttemptBuiltRequest(const std::shared_ptr<HttpRequest>& httpRequest, bool signBody, const char* signerName) const
+{
     auto signer = GetSignerByName(signerName);
-    if (!signer->SignRequest(*httpRequest, request.SignBody()))
+    if (!signer->SignRequest(*httpRequest, signBody))
     {
         AWS_LOGSTREAM_ERROR(AWS_CLIENT_LOG_TAG, "Request signing failed. Returning error.");
         return HttpResponseOutcome(AWSError<CoreErrors>(CoreErrors::CLIENT_SIGNING_FAILURE, "", "SDK failed to sign the request", false/*retryable*/));
@@ -340,6 +393,204 @@ HttpResponseOutcome AWSClient::AttemptOneRequest(const std::shared_ptr<HttpReque
     return HttpResponseOutcome(httpResponse);
 }
 
+namespace
+{
+    /**
+     * State shared between an attempt and its hedged copy. The hedged copy runs on the executor and may outlive the attempt when it loses,
+     * so it only holds on to this state and shared pointers, never to the client itself.
+     */
+    struct HedgedAttemptState
+    {
+        HedgedAttemptState() : primaryDone(false), hedgeLaunched(false), hedgeDone(false), primaryWon(false), hedgeWon(false),
+            primaryStreamStart(-1), primaryReportedData(false), hedgeBytesReceived(0) {}
+
+        std::mutex lock;
+        std::condition_variable signal;
+        bool primaryDone;
+        bool hedgeLaunched;
+        bool hedgeDone;
+        // read from the continue handlers of the requests without holding the lock; only set while holding it
+        std::atomic<bool> primaryWon;
+        std::atomic<bool> hedgeWon;
+        std::shared_ptr<HttpResponse> hedgeResponse;
+        // when the hedge completed; the latency of either attempt counts from when the primary was sent
+        DateTime hedgeCompletedTime;
+        // only used by the primary's thread: where its response stream started, so that a winning hedge's body is written there instead
+        std::streampos primaryStreamStart;
+        bool primaryReportedData;
+        // the hedge reports the data it receives once it has won; only used by the hedge's thread until hedgeDone is set
+        long long hedgeBytesReceived;
+    };
+
+    /**
+     * Makes a copy of a response that was read into a scratch stream, with its body written to a stream of the request's response stream factory.
+     * The body is written from streamStart if that is known, over whatever a losing attempt left in a stream the factory shares.
+     */
+    std::shared_ptr<HttpResponse> CopyToResponseStream(const std::shared_ptr<HttpRequest>& httpRequest, const HttpResponse& scratchResponse,
+        const Aws::IOStreamFactory& responseStreamFactory, std::streampos streamStart)
+    {
+        httpRequest->SetResponseStreamFactory(responseStreamFactory);
+        auto response = Aws::MakeShared<Standard::StandardHttpResponse>(AWS_CLIENT_LOG_TAG, httpRequest);
+        response->SetResponseCode(scratchResponse.GetResponseCode());
+        for (const auto& header : scratchResponse.GetHeaders())
+        {
+            response->AddHeader(header.first, header.second);
+        }
+
+        Aws::IOStream& body = response->GetResponseBody();
+        if (streamStart != std::streampos(-1))
+        {
+            body.seekp(streamStart);
+        }
+        Aws::IOStream& scratchBody = scratchResponse.GetResponseBody();
+        std::copy(std::istreambuf_iterator<char>(scratchBody), std::istreambuf_iterator<char>(), std::ostreambuf_iterator<char>(body));
+        body.flush();
+        return response;
+    }
+}
+
+HttpResponseOutcome AWSClient::AttemptHedgedRequest(const Aws::Http::URI& uri, HttpMethod method,
+    std::shared_ptr<HttpRequest>& httpRequest, const Aws::AmazonWebServiceRequest& request, const char* signerName) const
+{
+    long hedgeDelay = m_hedgingStrategy->CalculateHedgeDelay(request);
+    auto state = Aws::MakeShared<HedgedAttemptState>(AWS_CLIENT_LOG_TAG);
+
+    std::shared_ptr<HttpRequest> hedgeRequest;
+    if (hedgeDelay >= 0)
+    {
+        // build the copy here, the executor only signs and sends it. It reads into a scratch stream of its own, so that only the winner's body
+        // reaches the caller's stream, and keeps the data it receives to itself until it wins.
+        hedgeRequest = CreateHttpRequest(uri, method, Aws::Utils::Stream::DefaultResponseStreamFactoryMethod);
+        BuildHttpRequest(request, hedgeRequest);
+        auto continueRequest = hedgeRequest->GetContinueRequestHandler();
+        hedgeRequest->SetContinueRequestHandle([state, continueRequest](const HttpRequest* req)
+        {
+            return !state->primaryWon && (!continueRequest || continueRequest(req));
+        });
+        hedgeRequest->SetDataReceivedEventHandler([state](const HttpRequest*, HttpResponse*, long long amount)
+        {
+            state->hedgeBytesReceived += amount;
+        });
+
+        auto httpClient = m_httpClient;
+        auto signer = m_signerProvider->GetSigner(signerName);
+        auto readLimiter = m_readRateLimiter;
+        auto writeLimiter = m_writeRateLimiter;
+        bool signBody = request.SignBody();
+        auto sendHedge = [=]()
+        {
+            AWS_LOGSTREAM_DEBUG(AWS_CLIENT_LOG_TAG, "Request didn't complete in " << hedgeDelay << " ms, sending hedged request.");
+            std::shared_ptr<HttpResponse> hedgeResponse;
+            if (signer && signer->SignRequest(*hedgeRequest, signBody))
+            {
+                hedgeResponse = httpClient->MakeRequest(hedgeRequest, readLimiter.get(), writeLimiter.get());
+            }
+
+            std::lock_guard<std::mutex> locker(state->lock);
+            state->hedgeCompletedTime = DateTime::Now();
+            state->hedgeDone = true;
+            // only a winning response is kept: it refers to the hedged request, whose handlers refer to the state
+            if (!DoesResponseGenerateError(hedgeResponse) && !state->primaryWon)
+            {
+                state->hedgeResponse = hedgeResponse;
+                state->hedgeWon = true;
+            }
+            state->signal.notify_all();
+        };
+
+        // the timer only decides whether the hedge is still needed; nothing reaches the executor before it is due
+        auto hedgingStrategy = m_hedgingStrategy;
+        auto executor = m_executor;
+        m_hedgeTimer->Schedule(std::chrono::milliseconds(hedgeDelay), [state, hedgingStrategy, executor, sendHedge]()
+        {
+            std::lock_guard<std::mutex> locker(state->lock);
+            if (state->primaryDone || !hedgingStrategy->AcquireHedge())
+            {
+                return;
+            }
+            state->hedgeLaunched = executor->Submit(sendHedge);
+        });
+    }
+
+    BuildHttpRequest(request, httpRequest);
+    if (hedgeRequest)
+    {
+        auto continueRequest = httpRequest->GetContinueRequestHandler();
+        httpRequest->SetContinueRequestHandle([state, continueRequest](const HttpRequest* req)
+        {
+            return !state->hedgeWon && (!continueRequest || continueRequest(req));
+        });
+
+        const auto& responseStreamFactory = request.GetResponseStreamFactory();
+        httpRequest->SetResponseStreamFactory([state, responseStreamFactory]()
+        {
+            Aws::IOStream* stream = responseStreamFactory();
+            state->primaryStreamStart = stream->tellp();
+            return stream;
+        });
+
+        const auto& onDataReceived = request.GetDataReceivedEventHandler();
+        if (onDataReceived)
+        {
+            httpRequest->SetDataReceivedEventHandler([state, onDataReceived](const HttpRequest* req, HttpResponse* resp, long long amount)
+            {
+                if (!state->hedgeWon)
+                {
+                    state->primaryReportedData = true;
+                    onDataReceived(req, resp, amount);
+                }
+            });
+        }
+    }
+
+    auto startTime = DateTime::Now();
+    HttpResponseOutcome outcome = AttemptBuiltRequest(httpRequest, request.SignBody(), signerName);
+    long latencyMs = static_cast<long>((DateTime::Now() - startTime).count());
+
+    std::unique_lock<std::mutex> locker(state->lock);
+    state->primaryDone = true;
+    if (outcome.IsSuccess() && !state->hedgeWon)
+    {
+        state->primaryWon = true;
+    }
+    state->signal.notify_all();
+
+    // a hedge still in flight can still succeed where this attempt failed
+    bool hedgeWon = false;
+    if (!state->primaryWon && state->hedgeLaunched)
+    {
+        state->signal.wait(locker, [&state]() { return state->hedgeDone; });
+        hedgeWon = state->hedgeWon;
+    }
+    locker.unlock();
+
+    if (hedgeWon)
+    {
+        AWS_LOGSTREAM_DEBUG(AWS_CLIENT_LOG_TAG, "Hedged request completed first, using its response.");
+        // release the primary's response, and its stream, before the caller's stream is written again
+        outcome = HttpResponseOutcome();
+        httpRequest = hedgeRequest;
+        auto scratchResponse = std::move(state->hedgeResponse);
+        auto hedgeResponse = CopyToResponseStream(hedgeRequest, *scratchResponse, request.GetResponseStreamFactory(), state->primaryStreamStart);
+        outcome = HttpResponseOutcome(hedgeResponse);
+        latencyMs = static_cast<long>((state->hedgeCompletedTime - startTime).count());
+
+        // the data the primary reported is discarded as for a failed attempt, and replaced by the hedge's
+        if (state->primaryReportedData && request.GetRequestRetryHandler())
+        {
+            request.GetRequestRetryHandler()(request);
+        }
+        const auto& onDataReceived = request.GetDataReceivedEventHandler();
+        if (onDataReceived && state->hedgeBytesReceived > 0)
+        {
+            onDataReceived(hedgeRequest.get(), hedgeResponse.get(), state->hedgeBytesReceived);
+        }
+    }
+
+    m_hedgingStrategy->RequestCompleted(request, latencyMs, outcome.IsSuccess());
+    return outcome;
+}
+
 StreamOutcome AWSClient::MakeRequestWithUnparsedResponse(const Aws::Http::URI& uri,
     const Aws::AmazonWebServiceRequest& request,
     Http::HttpMethod method,
@@ -471,7 +722,20 @@ void AWSClient::BuildHttpRequest(const Aws::AmazonWebServiceRequest& request,
     // Pass along handlers for processing data sent/received in bytes
     httpRequest->SetDataReceivedEventHandler(request.GetDataReceivedEventHandler());
     httpRequest->SetDataSentEventHandler(request.GetDataSentEventHandler());
-    httpRequest->SetContinueRequestHandle(request.GetContinueRequestHandler());
+    httpRequest->SetResponseFlowControlHandler(request.GetResponseFlowControlHandler());
+    const auto& cancellationToken = request.GetCancellationToken();
+    if (cancellationToken)
+    {
+        auto continueRequest = request.GetContinueRequestHandler();
+        httpRequest->SetContinueRequestHandle([cancellationToken, continueRequest](const HttpRequest* req)
+        {
+            return !cancellationToken->IsCancelled() && (!continueRequest || continueRequest(req));
+        });
+    }
+    else
+    {
+        httpRequest->SetContinueRequestHandle(request.GetContinueRequestHandler());
+    }
 
     request.AddQueryStringParameters(httpRequest->GetUri());
 }
@@ -48,7 +48,11 @@ ClientConfiguration::ClientConfiguration() :
     enableTcpKeepAlive(true),
     tcpKeepAliveIntervalMs(30000),
     lowSpeedLimit(1),
+    version(Aws::Http::Version::HTTP_VERSION_NONE),
+    enableHttp2Multiplexing(false),
+    maxConcurrentStreams(100),
     retryStrategy(Aws::MakeShared<DefaultRetryStrategy>(CLIENT_CONFIGURATION_ALLOCATION_TAG)),
+    hedgingStrategy(nullptr),
     proxyScheme(Aws::Http::Scheme::HTTP),
     proxyPort(0),
     executor(Aws::MakeShared<Aws::Utils::Threading::DefaultExecutor>(CLIENT_CONFIGURATION_ALLOCATION_TAG)),
@@ -0,0 +1,123 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  * 
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  * 
+  *  http://aws.amazon.com/apache2.0
+  * 
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/core/client/DefaultHedgingStrategy.h>
+
+#include <aws/core/AmazonWebServiceRequest.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Aws;
+using namespace Aws::Client;
+
+// latencies kept per operation, and how many are needed before the percentile replaces the fixed delay
+static const size_t LATENCY_WINDOW_SIZE = 128;
+static const size_t MIN_LATENCY_SAMPLES = 16;
+static const size_t PERCENTILE_UPDATE_INTERVAL = 8;
+
+// the budget is kept in thousandths of a hedge; it starts full with room for a small burst of hedges
+static const int64_t HEDGE_COST = 1000;
+static const int64_t MAX_HEDGE_BUDGET = 10 * HEDGE_COST;
+
+DefaultHedgingStrategy::DefaultHedgingStrategy(const Aws::Vector<Aws::String>& operations, long hedgeDelayMs, double latencyPercentile, double maxHedgeRatio) :
+    m_operations(operations.begin(), operations.end()),
+    m_hedgeDelayMs((std::max)(0L, hedgeDelayMs)),
+    m_latencyPercentile((std::min)(1.0, (std::max)(0.0, latencyPercentile))),
+    m_creditPerRequest(static_cast<int64_t>(std::llround((std::max)(0.0, maxHedgeRatio) * HEDGE_COST))),
+    m_budget(MAX_HEDGE_BUDGET)
+{
+}
+
+bool DefaultHedgingStrategy::ShouldHedge(const AmazonWebServiceRequest& request, Http::HttpMethod method) const
+{
+    // only reads are safe to have in flight twice, whatever operations were listed
+    if (method != Http::HttpMethod::HTTP_GET && method != Http::HttpMethod::HTTP_HEAD)
+    {
+        return false;
+    }
+
+    return m_operations.find(request.GetServiceRequestName()) != m_operations.end();
+}
+
+long DefaultHedgingStrategy::CalculateHedgeDelay(const AmazonWebServiceRequest& request) const
+{
+    if (m_latencyPercentile <= 0.0)
+    {
+        return m_hedgeDelayMs;
+    }
+
+    std::lock_guard<std::mutex> locker(m_latencyLock);
+    auto window = m_latencies.find(request.GetServiceRequestName());
+    if (window == m_latencies.end() || window->second.m_percentileMs < 0)
+    {
+        return m_hedgeDelayMs;
+    }
+
+    return (std::max)(m_hedgeDelayMs, window->second.m_percentileMs);
+}
+
+bool DefaultHedgingStrategy::AcquireHedge()
+{
+    int64_t budget = m_budget.load();
+    while (budget >= HEDGE_COST)
+    {
+        if (m_budget.compare_exchange_weak(budget, budget - HEDGE_COST))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DefaultHedgingStrategy::RequestCompleted(const AmazonWebServiceRequest& request, long latencyMs, bool succeeded)
+{
+    int64_t budget = m_budget.load();
+    while (budget < MAX_HEDGE_BUDGET)
+    {
+        if (m_budget.compare_exchange_weak(budget, (std::min)(MAX_HEDGE_BUDGET, budget + m_creditPerRequest)))
+        {
+            break;
+        }
+    }
+
+    // failures tend to return quickly and would drag the percentile down
+    if (!succeeded || m_latencyPercentile <= 0.0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> locker(m_latencyLock);
+    LatencyWindow& window = m_latencies[request.GetServiceRequestName()];
+    if (window.m_samples.size() < LATENCY_WINDOW_SIZE)
+    {
+        window.m_samples.push_back(latencyMs);
+    }
+    else
+    {
+        window.m_samples[window.m_next] = latencyMs;
+    }
+    window.m_next = (window.m_next + 1) % LATENCY_WINDOW_SIZE;
+
+    if (window.m_samples.size() >= MIN_LATENCY_SAMPLES && ++window.m_samplesSinceUpdate >= PERCENTILE_UPDATE_INTERVAL)
+    {
+        window.m_samplesSinceUpdate = 0;
+        Aws::Vector<long> sorted(window.m_samples);
+        size_t rank = (std::min)(sorted.size() - 1, static_cast<size_t>(m_latencyPercentile * static_cast<double>(sorted.size())));
+        std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(rank), sorted.end());
+        window.m_percentileMs = sorted[rank];
+    }
+}
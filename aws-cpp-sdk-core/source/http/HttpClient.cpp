@@ -15,6 +15,8 @@
 
 #include <aws/core/http/HttpClient.h>
 #include <aws/core/http/HttpRequest.h>
+#include <aws/core/utils/threading/CancellationToken.h>
+#include <algorithm>
 
 using namespace Aws;
 using namespace Aws::Http;
@@ -48,6 +50,27 @@ void HttpClient::RetryRequestSleep(std::chrono::milliseconds sleepTime)
     m_requestProcessingSignal.wait_for(signalLocker, sleepTime, [this](){ return m_disableRequestProcessing.load() == true; });
 }
 
+void HttpClient::RetryRequestSleep(std::chrono::milliseconds sleepTime, Aws::Utils::Threading::CancellationToken& cancellationToken)
+{
+    // registered before taking the lock: Cancel() calls back without holding the token's lock, so the two locks are never held in opposite order
+    auto callbackId = cancellationToken.AddCancelCallback([this]()
+    {
+        std::lock_guard< std::mutex > signalLocker(m_requestProcessingSignalLock);
+        m_requestProcessingSignal.notify_all();
+    });
+
+    {
+        std::unique_lock< std::mutex > signalLocker(m_requestProcessingSignalLock);
+        // a deadline signals nobody, so never sleep past it
+        m_requestProcessingSignal.wait_for(signalLocker, (std::min)(sleepTime, cancellationToken.GetRemainingTime()), [this, &cancellationToken]()
+        {
+            return m_disableRequestProcessing.load() == true || cancellationToken.IsCancelled();
+        });
+    }
+
+    cancellationToken.RemoveCancelCallback(callbackId);
+}
+
 bool HttpClient::ContinueRequest(const Aws::Http::HttpRequest& request) const
 {
     if (request.GetContinueRequestHandler())
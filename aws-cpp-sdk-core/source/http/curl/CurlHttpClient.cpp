@@ -135,12 +135,17 @@ struct CurlWriteCallbackContext
     CurlWriteCallbackContext(const CurlHttpClient* client,
                              HttpRequest* request, 
                              HttpResponse* response, 
-                             Aws::Utils::RateLimits::RateLimiterInterface* rateLimiter) :
+                             Aws::Utils::RateLimits::RateLimiterInterface* rateLimiter,
+                             CURL* handle,
+                             bool multiplexed) :
         m_client(client),
         m_request(request),
         m_response(response),
         m_rateLimiter(rateLimiter),
-        m_numBytesResponseReceived(0)
+        m_numBytesResponseReceived(0),
+        m_handle(handle),
+        m_multiplexed(multiplexed),
+        m_paused(false)
     {}
 
     const CurlHttpClient* m_client;
@@ -148,6 +153,10 @@ struct CurlWriteCallbackContext
     HttpResponse* m_response;
     Aws::Utils::RateLimits::RateLimiterInterface* m_rateLimiter;
     int64_t m_numBytesResponseReceived;
+    CURL* m_handle;
+    bool m_multiplexed;
+    // set while the response is held off by its flow control handler; the progress callback resumes it
+    bool m_paused;
 };
 
 struct CurlReadCallbackContext
@@ -163,7 +172,71 @@ struct CurlReadCallbackContext
     HttpRequest* m_request;
 };
 
+// Repositions the request body without consulting the request's handlers, so that it can run on the multiplexer thread
+static size_t SeekRequestBody(void* userdata, curl_off_t offset, int origin)
+{
+    CurlReadCallbackContext* context = reinterpret_cast<CurlReadCallbackContext*>(userdata);
+    HttpRequest* request = context->m_request;
+    const std::shared_ptr<Aws::IOStream>& ioStream = request->GetContentBody();
+
+    std::ios_base::seekdir dir;
+    switch(origin)
+    {
+        case SEEK_SET:
+            dir = std::ios_base::beg;
+            break;
+        case SEEK_CUR:
+            dir = std::ios_base::cur;
+            break;
+        case SEEK_END:
+            dir = std::ios_base::end;
+            break;
+        default:
+            return CURL_SEEKFUNC_FAIL;
+    }
+
+    ioStream->clear();
+    ioStream->seekg(offset, dir);
+    if (ioStream->fail()) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+
+    return CURL_SEEKFUNC_OK;
+}
+
 static const char* CURL_HTTP_CLIENT_TAG = "CurlHttpClient";
+// how long a held off response waits for its flow control handler at a time before checking whether the request was cancelled
+static const std::chrono::milliseconds FLOW_CONTROL_WAIT_SLICE(100);
+
+// Hands multiplexed body data to the same callbacks curl_easy_perform would call, and asks the request whether to go on, on the thread
+// that made the request
+class CurlCallbackBodyHandler : public CurlMultiplexer::BodyHandler
+{
+public:
+    typedef size_t (*SeekFunction)(void* userdata, curl_off_t offset, int origin);
+
+    CurlCallbackBodyHandler(const HttpClient* client, const HttpRequest* request, curl_write_callback writeFunction, void* writeData,
+                            curl_read_callback readFunction, void* readData, SeekFunction seekFunction, void* seekData) :
+        m_client(client), m_request(request), m_writeFunction(writeFunction), m_writeData(writeData), m_readFunction(readFunction),
+        m_readData(readData), m_seekFunction(seekFunction), m_seekData(seekData)
+    {}
+
+    bool OnReceived(char* data, size_t length) override { return m_writeFunction(data, 1, length, m_writeData) == length; }
+    bool HasRequestBody() const override { return m_readFunction != nullptr; }
+    size_t OnSend(char* buffer, size_t length) override { return m_readFunction(buffer, 1, length, m_readData); }
+    int OnSeek(curl_off_t offset, int origin) override { return static_cast<int>(m_seekFunction(m_seekData, offset, origin)); }
+    bool ShouldContinue() override { return m_client->ContinueRequest(*m_request) && m_client->IsRequestProcessingEnabled(); }
+
+private:
+    const HttpClient* m_client;
+    const HttpRequest* m_request;
+    curl_write_callback m_writeFunction;
+    void* m_writeData;
+    curl_read_callback m_readFunction;
+    void* m_readData;
+    SeekFunction m_seekFunction;
+    void* m_seekData;
+};
 
 void SetOptCodeForHttpMethod(CURL* requestHandle, const HttpRequest& request)
 {
@@ -291,17 +364,65 @@ int CurlDebugCallback(CURL *handle, curl_infotype type, char *data, size_t size,
 }
 
 
+static Aws::Http::Version GetVersionToUse(const ClientConfiguration& clientConfig)
+{
+    if (!clientConfig.enableHttp2Multiplexing)
+    {
+        return clientConfig.version;
+    }
+
+    switch (clientConfig.version)
+    {
+        case Aws::Http::Version::HTTP_VERSION_2_0:
+        case Aws::Http::Version::HTTP_VERSION_2TLS:
+        case Aws::Http::Version::HTTP_VERSION_2_PRIOR_KNOWLEDGE:
+            return clientConfig.version;
+        default:
+            return Aws::Http::Version::HTTP_VERSION_2TLS;
+    }
+}
+
+static long GetCurlHttpVersion(Aws::Http::Version version)
+{
+    switch (version)
+    {
+        case Aws::Http::Version::HTTP_VERSION_1_0:
+            return CURL_HTTP_VERSION_1_0;
+        case Aws::Http::Version::HTTP_VERSION_1_1:
+            return CURL_HTTP_VERSION_1_1;
+        case Aws::Http::Version::HTTP_VERSION_2_0:
+            return CURL_HTTP_VERSION_2_0;
+#if LIBCURL_VERSION_NUM >= 0x072F00 // 7.47.0
+        case Aws::Http::Version::HTTP_VERSION_2TLS:
+            return CURL_HTTP_VERSION_2TLS;
+#endif
+#if LIBCURL_VERSION_NUM >= 0x073100 // 7.49.0
+        case Aws::Http::Version::HTTP_VERSION_2_PRIOR_KNOWLEDGE:
+            return CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+#endif
+        default:
+            return CURL_HTTP_VERSION_NONE;
+    }
+}
+
 CurlHttpClient::CurlHttpClient(const ClientConfiguration& clientConfig) :
     Base(),   
-    m_curlHandleContainer(clientConfig.maxConnections, clientConfig.requestTimeoutMs, clientConfig.connectTimeoutMs,
+    // when multiplexing, a handle is a stream rather than a connection, so allow one per possible stream
+    m_curlHandleContainer(clientConfig.enableHttp2Multiplexing ? clientConfig.maxConnections * (std::max)(1u, clientConfig.maxConcurrentStreams) : clientConfig.maxConnections,
+                          clientConfig.requestTimeoutMs, clientConfig.connectTimeoutMs,
                           clientConfig.enableTcpKeepAlive, clientConfig.tcpKeepAliveIntervalMs, clientConfig.lowSpeedLimit),
     m_isUsingProxy(!clientConfig.proxyHost.empty()), m_proxyUserName(clientConfig.proxyUserName),
     m_proxyPassword(clientConfig.proxyPassword), m_proxyScheme(SchemeMapper::ToString(clientConfig.proxyScheme)), m_proxyHost(clientConfig.proxyHost),
     m_proxyPort(clientConfig.proxyPort), m_verifySSL(clientConfig.verifySSL), m_caPath(clientConfig.caPath),
     m_caFile(clientConfig.caFile), 
     m_disableExpectHeader(clientConfig.disableExpectHeader),
-    m_allowRedirects(clientConfig.followRedirects)
+    m_allowRedirects(clientConfig.followRedirects),
+    m_version(GetVersionToUse(clientConfig))
 {
+    if (clientConfig.enableHttp2Multiplexing)
+    {
+        m_multiplexer = Aws::MakeShared<CurlMultiplexer>(CURL_HTTP_CLIENT_TAG, clientConfig.maxConnections, (std::max)(1u, clientConfig.maxConcurrentStreams));
+    }
 }
 
 
@@ -362,16 +483,28 @@ void CurlHttpClient::MakeRequestInternal(HttpRequest& request,
             curl_easy_setopt(connectionHandle, CURLOPT_HTTPHEADER, headers);
         }
 
-        CurlWriteCallbackContext writeContext(this, &request, response.get(), readLimiter);
+        CurlWriteCallbackContext writeContext(this, &request, response.get(), readLimiter, connectionHandle, m_multiplexer != nullptr);
         CurlReadCallbackContext readContext(this, &request, writeLimiter);
 
         SetOptCodeForHttpMethod(connectionHandle, request);
 
         curl_easy_setopt(connectionHandle, CURLOPT_URL, url.c_str());
+        if (m_version != Aws::Http::Version::HTTP_VERSION_NONE)
+        {
+            curl_easy_setopt(connectionHandle, CURLOPT_HTTP_VERSION, GetCurlHttpVersion(m_version));
+        }
+        if (m_multiplexer)
+        {
+            // wait for a stream on an existing connection rather than opening a new one while under the connection limit
+            curl_easy_setopt(connectionHandle, CURLOPT_PIPEWAIT, 1L);
+        }
         curl_easy_setopt(connectionHandle, CURLOPT_WRITEFUNCTION, &CurlHttpClient::WriteData);
         curl_easy_setopt(connectionHandle, CURLOPT_WRITEDATA, &writeContext);
         curl_easy_setopt(connectionHandle, CURLOPT_HEADERFUNCTION, &CurlHttpClient::WriteHeader);
         curl_easy_setopt(connectionHandle, CURLOPT_HEADERDATA, response.get());
+        curl_easy_setopt(connectionHandle, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(connectionHandle, CURLOPT_XFERINFOFUNCTION, &CurlHttpClient::CurlProgressCallback);
+        curl_easy_setopt(connectionHandle, CURLOPT_XFERINFODATA, &writeContext);
 
         //we only want to override the default path if someone has explicitly told us to.
         if(!m_caPath.empty())
@@ -441,7 +574,21 @@ void CurlHttpClient::MakeRequestInternal(HttpRequest& request,
             curl_easy_setopt(connectionHandle, CURLOPT_SEEKDATA, &readContext);
         }
         Aws::Utils::DateTime startTransmissionTime = Aws::Utils::DateTime::Now();
-        CURLcode curlResponseCode = curl_easy_perform(connectionHandle);
+        CURLcode curlResponseCode;
+        if (m_multiplexer)
+        {
+            request.AddRequestMetric(GetHttpClientMetricNameByType(HttpClientMetricsType::MultiplexedRequestsInFlight), static_cast<int64_t>(m_multiplexer->GetActiveTransfers() + 1));
+            bool hasRequestBody = request.GetContentBody() != nullptr;
+            // the seek runs on the multiplexer thread, and ShouldContinue checks the request's handlers on this one instead
+            CurlCallbackBodyHandler body(this, &request, &CurlHttpClient::WriteData, &writeContext,
+                    hasRequestBody ? &CurlHttpClient::ReadBody : nullptr, &readContext,
+                    &SeekRequestBody, &readContext);
+            curlResponseCode = m_multiplexer->Perform(connectionHandle, &body);
+        }
+        else
+        {
+            curlResponseCode = curl_easy_perform(connectionHandle);
+        }
         bool shouldContinueRequest = ContinueRequest(request);
         if (curlResponseCode != CURLE_OK && shouldContinueRequest)
         {
@@ -505,6 +652,23 @@ void CurlHttpClient::MakeRequestInternal(HttpRequest& request,
             request.AddRequestMetric(GetHttpClientMetricNameByType(HttpClientMetricsType::SslLatency), static_cast<int64_t>(timep * 1000));
         }
 
+        long numConnects = 0;
+        ret = curl_easy_getinfo(connectionHandle, CURLINFO_NUM_CONNECTS, &numConnects);
+        if (ret == CURLE_OK)
+        {
+            request.AddRequestMetric(GetHttpClientMetricNameByType(HttpClientMetricsType::ConnectionReused), numConnects == 0 ? 1 : 0);
+        }
+
+#if LIBCURL_VERSION_NUM >= 0x073200 // 7.50.0
+        long httpVersion = 0;
+        ret = curl_easy_getinfo(connectionHandle, CURLINFO_HTTP_VERSION, &httpVersion);
+        if (ret == CURLE_OK && (httpVersion == CURL_HTTP_VERSION_1_0 || httpVersion == CURL_HTTP_VERSION_1_1 || httpVersion == CURL_HTTP_VERSION_2_0))
+        {
+            int64_t version = httpVersion == CURL_HTTP_VERSION_1_0 ? 10 : httpVersion == CURL_HTTP_VERSION_1_1 ? 11 : 20;
+            request.AddRequestMetric(GetHttpClientMetricNameByType(HttpClientMetricsType::HttpVersion), version);
+        }
+#endif
+
         m_curlHandleContainer.ReleaseCurlHandle(connectionHandle);
         //go ahead and flush the response body stream
         if(response)
@@ -549,6 +713,26 @@ size_t CurlHttpClient::WriteData(char* ptr, size_t size, size_t nmemb, void* use
             return 0;
         }
 
+        auto& flowControlHandler = context->m_request->GetResponseFlowControlHandler();
+        if (flowControlHandler && !flowControlHandler(context->m_request, std::chrono::milliseconds(0)))
+        {
+            if (!context->m_multiplexed)
+            {
+                // curl keeps this data and hands it over again once the progress callback resumes the transfer
+                AWS_LOGSTREAM_TRACE(CURL_HTTP_CLIENT_TAG, "Pausing response until its consumer catches up.");
+                context->m_paused = true;
+                return CURL_WRITEFUNC_PAUSE;
+            }
+            // this runs on the thread that made the request, and the multiplexer pauses the stream itself while it waits here
+            while (!flowControlHandler(context->m_request, FLOW_CONTROL_WAIT_SLICE))
+            {
+                if(!client->ContinueRequest(*context->m_request) || !client->IsRequestProcessingEnabled())
+                {
+                    return 0;
+                }
+            }
+        }
+
         HttpResponse* response = context->m_response;
         size_t sizeToWrite = size * nmemb;
         if (context->m_rateLimiter)
@@ -570,6 +754,36 @@ size_t CurlHttpClient::WriteData(char* ptr, size_t size, size_t nmemb, void* use
     return 0;
 }
 
+int CurlHttpClient::CurlProgressCallback(void* userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+{
+    CurlWriteCallbackContext* context = reinterpret_cast<CurlWriteCallbackContext*>(userdata);
+
+    const CurlHttpClient* client = context->m_client;
+    if(!client->ContinueRequest(*context->m_request) || !client->IsRequestProcessingEnabled())
+    {
+        // any non-zero value aborts the transfer with CURLE_ABORTED_BY_CALLBACK
+        return 1;
+    }
+
+    if (context->m_paused)
+    {
+        // nothing is read off the connection while paused, so the sender is held off until the response can be written again
+        auto& flowControlHandler = context->m_request->GetResponseFlowControlHandler();
+        while (!flowControlHandler(context->m_request, FLOW_CONTROL_WAIT_SLICE))
+        {
+            if(!client->ContinueRequest(*context->m_request) || !client->IsRequestProcessingEnabled())
+            {
+                return 1;
+            }
+        }
+        AWS_LOGSTREAM_TRACE(CURL_HTTP_CLIENT_TAG, "Resuming paused response.");
+        context->m_paused = false;
+        curl_easy_pause(context->m_handle, CURLPAUSE_CONT);
+    }
+
+    return 0;
+}
+
 size_t CurlHttpClient::WriteHeader(char* ptr, size_t size, size_t nmemb, void* userdata)
 {
     if (ptr)
@@ -643,30 +857,5 @@ size_t CurlHttpClient::SeekBody(void* userdata, curl_off_t offset, int origin)
         return CURL_SEEKFUNC_FAIL;
     }
 
-    HttpRequest* request = context->m_request;
-    const std::shared_ptr<Aws::IOStream>& ioStream = request->GetContentBody();
-
-    std::ios_base::seekdir dir;
-    switch(origin)
-    {
-        case SEEK_SET:
-            dir = std::ios_base::beg;
-            break;
-        case SEEK_CUR:
-            dir = std::ios_base::cur;
-            break;
-        case SEEK_END:
-            dir = std::ios_base::end;
-            break;
-        default:
-            return CURL_SEEKFUNC_FAIL;
-    }
-
-    ioStream->clear();
-    ioStream->seekg(offset, dir);
-    if (ioStream->fail()) {
-        return CURL_SEEKFUNC_CANTSEEK;
-    }
-
-    return CURL_SEEKFUNC_OK;
+    return SeekRequestBody(context, offset, origin);
 }
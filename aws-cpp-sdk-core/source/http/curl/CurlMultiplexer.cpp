@@ -0,0 +1,430 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  * 
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  * 
+  *  http://aws.amazon.com/apache2.0
+  * 
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/core/http/curl/CurlMultiplexer.h>
+#include <aws/core/utils/logging/LogMacros.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+
+using namespace Aws::Utils::Logging;
+using namespace Aws::Http;
+
+static const char* CURL_MULTIPLEXER_TAG = "CurlMultiplexer";
+// with curl_multi_poll the thread is woken up for new transfers; without it, new transfers wait at most this long to be picked up
+#if LIBCURL_VERSION_NUM >= 0x074400 // 7.68.0
+static const int POLL_TIMEOUT_MS = 1000;
+#else
+static const int POLL_TIMEOUT_MS = 5;
+#endif
+
+// how much body data a transfer buffers between the multiplexer thread and its caller before it is paused
+static const size_t MAX_BUFFERED_BYTES = 256 * 1024;
+static const size_t SEND_CHUNK_BYTES = 64 * 1024;
+// how often a caller with nothing to move checks whether its transfer should go on
+static const std::chrono::milliseconds CONTINUE_CHECK_INTERVAL(100);
+
+struct CurlMultiplexer::Transfer
+{
+    Transfer(CurlMultiplexer* multiplexer, CURL* handle, BodyHandler* body) :
+        m_multiplexer(multiplexer), m_handle(handle), m_body(body), m_result(CURLE_OK), m_done(false), m_aborted(false), m_resuming(false),
+        m_receivePaused(false), m_sent(0), m_sendEnded(false), m_sending(false), m_sendPaused(false)
+    {}
+
+    CurlMultiplexer* m_multiplexer;
+    CURL* m_handle;
+    BodyHandler* m_body;
+    CURLcode m_result;
+    bool m_done;
+    bool m_aborted;
+    /// queued in m_resumingTransfers
+    bool m_resuming;
+    /// response body received on the multiplexer thread that the caller hasn't consumed yet
+    Aws::Vector<char> m_received;
+    bool m_receivePaused;
+    /// request body read ahead by the caller, of which curl has taken the first m_sent bytes
+    Aws::Vector<char> m_toSend;
+    size_t m_sent;
+    bool m_sendEnded;
+    /// the caller is in OnSend, so the body can't be repositioned
+    bool m_sending;
+    bool m_sendPaused;
+    std::condition_variable m_signal;
+};
+
+CurlMultiplexer::CurlMultiplexer(unsigned maxConnections, unsigned maxConcurrentStreams) :
+    m_multiHandle(curl_multi_init()), m_activeTransfers(0), m_shutdown(false)
+{
+    AWS_LOGSTREAM_INFO(CURL_MULTIPLEXER_TAG, "Initializing CurlMultiplexer with " << maxConnections << " connections per host and "
+            << maxConcurrentStreams << " streams per connection");
+
+    curl_multi_setopt(m_multiHandle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(m_multiHandle, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(maxConnections));
+#if LIBCURL_VERSION_NUM >= 0x074300 // 7.67.0
+    curl_multi_setopt(m_multiHandle, CURLMOPT_MAX_CONCURRENT_STREAMS, static_cast<long>(maxConcurrentStreams));
+#endif
+
+    m_thread = std::thread(&CurlMultiplexer::Run, this);
+}
+
+CurlMultiplexer::~CurlMultiplexer()
+{
+    AWS_LOGSTREAM_INFO(CURL_MULTIPLEXER_TAG, "Cleaning up CurlMultiplexer.");
+    m_shutdown = true;
+    WakeUp();
+    m_thread.join();
+    curl_multi_cleanup(m_multiHandle);
+}
+
+CURLcode CurlMultiplexer::Perform(CURL* handle, BodyHandler* body)
+{
+    Transfer transfer(this, handle, body);
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, &transfer);
+    bool hasRequestBody = body && body->HasRequestBody();
+    if (body)
+    {
+        curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &CurlMultiplexer::WriteCallback);
+        curl_easy_setopt(handle, CURLOPT_WRITEDATA, &transfer);
+        // the body handler decides on the caller's thread whether to go on; this only aborts what it has given up on
+        curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, &CurlMultiplexer::ProgressCallback);
+        curl_easy_setopt(handle, CURLOPT_XFERINFODATA, &transfer);
+    }
+    if (hasRequestBody)
+    {
+        curl_easy_setopt(handle, CURLOPT_READFUNCTION, &CurlMultiplexer::ReadCallback);
+        curl_easy_setopt(handle, CURLOPT_READDATA, &transfer);
+        curl_easy_setopt(handle, CURLOPT_SEEKFUNCTION, &CurlMultiplexer::SeekCallback);
+        curl_easy_setopt(handle, CURLOPT_SEEKDATA, &transfer);
+    }
+
+    std::unique_lock<std::mutex> locker(m_lock);
+    if (m_shutdown)
+    {
+        return CURLE_FAILED_INIT;
+    }
+    m_pendingTransfers.push_back(&transfer);
+    ++m_activeTransfers;
+    WakeUp();
+
+    // the body is moved here, with m_lock released, so that a slow stream or rate limiter only holds up this transfer
+    Aws::Vector<char> received;
+    Aws::Vector<char> toSend(hasRequestBody ? SEND_CHUNK_BYTES : 0);
+    bool checkedContinue = false;
+    while (true)
+    {
+        if (!transfer.m_received.empty())
+        {
+            received.swap(transfer.m_received);
+            locker.unlock();
+            bool keepGoing = body->OnReceived(received.data(), received.size());
+            received.clear();
+            locker.lock();
+
+            transfer.m_aborted = transfer.m_aborted || !keepGoing;
+            if (transfer.m_receivePaused || transfer.m_aborted)
+            {
+                transfer.m_receivePaused = false;
+                RequestResume(&transfer);
+            }
+            continue;
+        }
+
+        if (hasRequestBody && !transfer.m_done && !transfer.m_aborted && !transfer.m_sendEnded &&
+                transfer.m_toSend.size() - transfer.m_sent < MAX_BUFFERED_BYTES)
+        {
+            transfer.m_sending = true;
+            locker.unlock();
+            size_t amountRead = body->OnSend(toSend.data(), toSend.size());
+            locker.lock();
+            transfer.m_sending = false;
+
+            if (amountRead == CURL_READFUNC_ABORT)
+            {
+                transfer.m_aborted = true;
+            }
+            else if (amountRead == 0)
+            {
+                transfer.m_sendEnded = true;
+            }
+            else
+            {
+                transfer.m_toSend.erase(transfer.m_toSend.begin(), transfer.m_toSend.begin() + transfer.m_sent);
+                transfer.m_sent = 0;
+                transfer.m_toSend.insert(transfer.m_toSend.end(), toSend.begin(), toSend.begin() + amountRead);
+            }
+            if (transfer.m_sendPaused || transfer.m_aborted)
+            {
+                transfer.m_sendPaused = false;
+                RequestResume(&transfer);
+            }
+            continue;
+        }
+
+        if (transfer.m_done)
+        {
+            break;
+        }
+        if (body && !transfer.m_aborted && !checkedContinue)
+        {
+            locker.unlock();
+            bool keepGoing = body->ShouldContinue();
+            locker.lock();
+
+            checkedContinue = true;
+            if (!keepGoing)
+            {
+                transfer.m_aborted = true;
+                // a paused transfer only sees that it is aborted once it is resumed
+                RequestResume(&transfer);
+            }
+            // anything may have come in while m_lock was released
+            continue;
+        }
+        transfer.m_signal.wait_for(locker, CONTINUE_CHECK_INTERVAL);
+        checkedContinue = false;
+    }
+    return transfer.m_result;
+}
+
+size_t CurlMultiplexer::WriteCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
+{
+    Transfer* transfer = reinterpret_cast<Transfer*>(userdata);
+    size_t length = size * nmemb;
+
+    std::lock_guard<std::mutex> locker(transfer->m_multiplexer->m_lock);
+    if (transfer->m_aborted)
+    {
+        return 0;
+    }
+    // curl holds on to the data of a paused transfer and hands it over again, together with anything received since, once it is resumed
+    if (!transfer->m_received.empty() && transfer->m_received.size() + length > MAX_BUFFERED_BYTES)
+    {
+        transfer->m_receivePaused = true;
+        return CURL_WRITEFUNC_PAUSE;
+    }
+    transfer->m_received.insert(transfer->m_received.end(), ptr, ptr + length);
+    transfer->m_signal.notify_one();
+    return length;
+}
+
+size_t CurlMultiplexer::ReadCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
+{
+    Transfer* transfer = reinterpret_cast<Transfer*>(userdata);
+
+    std::lock_guard<std::mutex> locker(transfer->m_multiplexer->m_lock);
+    if (transfer->m_aborted)
+    {
+        return CURL_READFUNC_ABORT;
+    }
+    size_t available = transfer->m_toSend.size() - transfer->m_sent;
+    if (available == 0)
+    {
+        if (transfer->m_sendEnded)
+        {
+            return 0;
+        }
+        transfer->m_sendPaused = true;
+        return CURL_READFUNC_PAUSE;
+    }
+    size_t length = (std::min)(available, size * nmemb);
+    memcpy(ptr, transfer->m_toSend.data() + transfer->m_sent, length);
+    transfer->m_sent += length;
+    transfer->m_signal.notify_one();
+    return length;
+}
+
+int CurlMultiplexer::SeekCallback(void* userdata, curl_off_t offset, int origin)
+{
+    Transfer* transfer = reinterpret_cast<Transfer*>(userdata);
+
+    std::lock_guard<std::mutex> locker(transfer->m_multiplexer->m_lock);
+    if (transfer->m_aborted)
+    {
+        return CURL_SEEKFUNC_FAIL;
+    }
+    if (transfer->m_sending)
+    {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    if (origin == SEEK_CUR)
+    {
+        // the body has been read ahead of what curl has taken
+        offset -= static_cast<curl_off_t>(transfer->m_toSend.size() - transfer->m_sent);
+    }
+    int result = transfer->m_body->OnSeek(offset, origin);
+    if (result == CURL_SEEKFUNC_OK)
+    {
+        transfer->m_toSend.clear();
+        transfer->m_sent = 0;
+        transfer->m_sendEnded = false;
+        transfer->m_signal.notify_one();
+    }
+    return result;
+}
+
+int CurlMultiplexer::ProgressCallback(void* userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+{
+    Transfer* transfer = reinterpret_cast<Transfer*>(userdata);
+
+    std::lock_guard<std::mutex> locker(transfer->m_multiplexer->m_lock);
+    // any non-zero value aborts the transfer with CURLE_ABORTED_BY_CALLBACK
+    return transfer->m_aborted ? 1 : 0;
+}
+
+void CurlMultiplexer::WakeUp()
+{
+#if LIBCURL_VERSION_NUM >= 0x074400 // 7.68.0
+    curl_multi_wakeup(m_multiHandle);
+#endif
+}
+
+void CurlMultiplexer::AddPendingTransfers()
+{
+    std::lock_guard<std::mutex> locker(m_lock);
+    for (Transfer* transfer : m_pendingTransfers)
+    {
+        CURLMcode code = curl_multi_add_handle(m_multiHandle, transfer->m_handle);
+        if (code == CURLM_OK)
+        {
+            m_runningTransfers.insert(transfer);
+        }
+        else
+        {
+            AWS_LOGSTREAM_ERROR(CURL_MULTIPLEXER_TAG, "Failed to add transfer: " << curl_multi_strerror(code));
+            CompleteTransfer(transfer, CURLE_FAILED_INIT);
+        }
+    }
+    m_pendingTransfers.clear();
+}
+
+void CurlMultiplexer::RequestResume(Transfer* transfer)
+{
+    // m_lock must be held
+    if (!transfer->m_resuming && !transfer->m_done)
+    {
+        transfer->m_resuming = true;
+        m_resumingTransfers.push_back(transfer);
+        WakeUp();
+    }
+}
+
+void CurlMultiplexer::ResumeTransfers()
+{
+    Aws::Vector<Transfer*> resumingTransfers;
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        resumingTransfers.swap(m_resumingTransfers);
+        for (Transfer* transfer : resumingTransfers)
+        {
+            transfer->m_resuming = false;
+        }
+    }
+
+    // transfers only complete on this thread, so none of these is gone yet; unpausing calls back into the paused callbacks, which take m_lock
+    for (Transfer* transfer : resumingTransfers)
+    {
+        if (m_runningTransfers.find(transfer) != m_runningTransfers.end())
+        {
+            curl_easy_pause(transfer->m_handle, CURLPAUSE_CONT);
+        }
+    }
+}
+
+void CurlMultiplexer::CompleteTransfer(Transfer* transfer, CURLcode result)
+{
+    // m_lock must be held; the transfer lives on the stack of the thread waiting in Perform() and is gone once it is signaled
+    transfer->m_result = result;
+    transfer->m_done = true;
+    if (transfer->m_resuming)
+    {
+        m_resumingTransfers.erase(std::find(m_resumingTransfers.begin(), m_resumingTransfers.end(), transfer));
+        transfer->m_resuming = false;
+    }
+    --m_activeTransfers;
+    transfer->m_signal.notify_one();
+}
+
+void CurlMultiplexer::CompleteFinishedTransfers()
+{
+    int messagesLeft = 0;
+    while (CURLMsg* message = curl_multi_info_read(m_multiHandle, &messagesLeft))
+    {
+        if (message->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+
+        CURL* handle = message->easy_handle;
+        CURLcode result = message->data.result;
+        Transfer* transfer = nullptr;
+        curl_easy_getinfo(handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&transfer));
+        curl_multi_remove_handle(m_multiHandle, handle);
+        m_runningTransfers.erase(transfer);
+
+        std::lock_guard<std::mutex> locker(m_lock);
+        CompleteTransfer(transfer, result);
+    }
+}
+
+void CurlMultiplexer::Run()
+{
+    while (!m_shutdown)
+    {
+        AddPendingTransfers();
+        ResumeTransfers();
+
+        int runningTransfers = 0;
+        CURLMcode code = curl_multi_perform(m_multiHandle, &runningTransfers);
+        if (code != CURLM_OK)
+        {
+            AWS_LOGSTREAM_ERROR(CURL_MULTIPLEXER_TAG, "curl_multi_perform failed: " << curl_multi_strerror(code));
+        }
+
+        CompleteFinishedTransfers();
+
+#if LIBCURL_VERSION_NUM >= 0x074400 // 7.68.0
+        curl_multi_poll(m_multiHandle, nullptr, 0, POLL_TIMEOUT_MS, nullptr);
+#else
+        int numFds = 0;
+        curl_multi_wait(m_multiHandle, nullptr, 0, POLL_TIMEOUT_MS, &numFds);
+        if (numFds == 0)
+        {
+            // curl_multi_wait returns right away when there is nothing to wait on
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT_MS));
+        }
+#endif
+    }
+
+    // the owning client is going away; nobody should still be waiting, but don't leave anyone hanging
+    for (Transfer* transfer : m_runningTransfers)
+    {
+        curl_multi_remove_handle(m_multiHandle, transfer->m_handle);
+    }
+
+    std::lock_guard<std::mutex> locker(m_lock);
+    for (Transfer* transfer : m_runningTransfers)
+    {
+        CompleteTransfer(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+    m_runningTransfers.clear();
+    for (Transfer* transfer : m_pendingTransfers)
+    {
+        CompleteTransfer(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+    m_pendingTransfers.clear();
+}
@@ -17,14 +17,29 @@
 #include <aws/core/utils/HashingUtils.h>
 #include <aws/core/utils/StringUtils.h>
 #include <aws/core/utils/base64/Base64.h>
-#include <aws/core/utils/crypto/Sha256.h>
-#include <aws/core/utils/crypto/Sha256HMAC.h>
-#include <aws/core/utils/crypto/MD5.h>
+#include <aws/core/utils/crypto/Factories.h>
+#include <aws/core/utils/crypto/Hash.h>
+#include <aws/core/utils/crypto/HMAC.h>
 #include <aws/core/utils/Outcome.h>
 #include <aws/core/utils/memory/stl/AWSStringStream.h>
 #include <aws/core/utils/memory/stl/AWSList.h>
 
 #include <iomanip>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define AWS_CRC32_PCLMUL
+#define AWS_CRC32_PCLMUL_TARGET
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <immintrin.h>
+#define AWS_CRC32_PCLMUL
+#define AWS_CRC32_PCLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_acle.h>
+#define AWS_CRC32_ARM
+#endif
 
 using namespace Aws::Utils;
 using namespace Aws::Utils::Base64;
@@ -36,6 +51,182 @@ static Aws::Utils::Base64::Base64 s_base64;
 // Aws Glacier Tree Hash calculates hash value for each 1MB data
 const static size_t TREE_HASH_ONE_MB = 1024 * 1024;
 
+// reversed IEEE 802.3 polynomial
+const static uint32_t CRC32_POLYNOMIAL = 0xEDB88320;
+
+/**
+ * Lookup tables for computing CRC32 eight bytes at a time; table[k][b] is the CRC of byte b followed by k zero bytes.
+ */
+struct Crc32Tables
+{
+    Crc32Tables()
+    {
+        for (uint32_t byte = 0; byte < 256; ++byte)
+        {
+            uint32_t crc = byte;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1) ^ (CRC32_POLYNOMIAL & (0 - (crc & 1)));
+            }
+            table[0][byte] = crc;
+        }
+        for (uint32_t byte = 0; byte < 256; ++byte)
+        {
+            for (int k = 1; k < 8; ++k)
+            {
+                table[k][byte] = (table[k - 1][byte] >> 8) ^ table[0][table[k - 1][byte] & 0xff];
+            }
+        }
+    }
+
+    uint32_t table[8][256];
+};
+
+static const Crc32Tables& GetCrc32Tables()
+{
+    static const Crc32Tables tables;
+    return tables;
+}
+
+// crc is the running (inverted) register here and in the hardware versions below
+static uint32_t Crc32Software(const unsigned char* data, size_t length, uint32_t crc)
+{
+    const Crc32Tables& tables = GetCrc32Tables();
+    while (length >= 8)
+    {
+        uint32_t low = crc ^ (static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+            static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24);
+        crc = tables.table[7][low & 0xff] ^ tables.table[6][(low >> 8) & 0xff] ^ tables.table[5][(low >> 16) & 0xff] ^ tables.table[4][low >> 24] ^
+            tables.table[3][data[4]] ^ tables.table[2][data[5]] ^ tables.table[1][data[6]] ^ tables.table[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+    while (length--)
+    {
+        crc = tables.table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef AWS_CRC32_PCLMUL
+// blocks shorter than this aren't worth setting up the folding for
+const static size_t CRC32_PCLMUL_MIN_LENGTH = 64;
+
+static bool CpuSupportsPclmul()
+{
+    unsigned ecx = 0;
+#ifdef _MSC_VER
+    int registers[4];
+    __cpuid(registers, 1);
+    ecx = static_cast<unsigned>(registers[2]);
+#else
+    unsigned eax = 0, ebx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return false;
+    }
+#endif
+    // PCLMULQDQ and SSE4.1
+    return (ecx & (1u << 1)) && (ecx & (1u << 19));
+}
+
+/**
+ * Folds 64 bytes at a time with carry-less multiplies, then Barrett reduces to 32 bits ("Fast CRC Computation for Generic Polynomials
+ * Using PCLMULQDQ Instruction", Intel, 2009). length must be at least 64 and a multiple of 16.
+ */
+AWS_CRC32_PCLMUL_TARGET
+static uint32_t Crc32Pclmul(const unsigned char* data, size_t length, uint32_t crc)
+{
+    alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+    alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+    alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+    alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32));
+    __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    __m128i x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+    data += 64;
+    length -= 64;
+
+    while (length >= 64)
+    {
+        __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)));
+        data += 64;
+        length -= 64;
+    }
+
+    // fold the four lanes into one, then any remaining 16 byte blocks into that
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+    __m128i lanes[] = { x2, x3, x4 };
+    for (const __m128i& lane : lanes)
+    {
+        __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, lane), x5);
+    }
+    while (length >= 16)
+    {
+        __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data))), x5);
+        data += 16;
+        length -= 16;
+    }
+
+    // fold 128 bits to 64
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduce to 32 bits
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+#endif
+
+#ifdef AWS_CRC32_ARM
+static uint32_t Crc32Arm(const unsigned char* data, size_t length, uint32_t crc)
+{
+    while (length >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32d(crc, word);
+        data += 8;
+        length -= 8;
+    }
+    while (length--)
+    {
+        crc = __crc32b(crc, *data++);
+    }
+    return crc;
+}
+#endif
+
 Aws::String HashingUtils::Base64Encode(const ByteBuffer& message)
 {
     return s_base64.Encode(message);
@@ -48,20 +239,17 @@ ByteBuffer HashingUtils::Base64Decode(const Aws::String& encodedMessage)
 
 ByteBuffer HashingUtils::CalculateSHA256HMAC(const ByteBuffer& toSign, const ByteBuffer& secret)
 {
-    Sha256HMAC hash;
-    return hash.Calculate(toSign, secret).GetResult();
+    return GetThreadSha256HMACImplementation()->Calculate(toSign, secret).GetResult();
 }
 
 ByteBuffer HashingUtils::CalculateSHA256(const Aws::String& str)
 {
-    Sha256 hash;
-    return hash.Calculate(str).GetResult();
+    return GetThreadSha256Implementation()->Calculate(str).GetResult();
 }
 
 ByteBuffer HashingUtils::CalculateSHA256(Aws::IOStream& stream)
 {
-    Sha256 hash;
-    return hash.Calculate(stream).GetResult();
+    return GetThreadSha256Implementation()->Calculate(stream).GetResult();
 }
 
 /**
@@ -71,7 +259,7 @@ ByteBuffer HashingUtils::CalculateSHA256(Aws::IOStream& stream)
  */
 static ByteBuffer TreeHashFinalCompute(Aws::List<ByteBuffer>& input)
 {
-    Sha256 hash;
+    auto hash = GetThreadSha256Implementation();
     assert(input.size() != 0);
 
     // O(n) time complexity of merging (n + n/2 + n/4 + n/8 +...+ 1)
@@ -88,7 +276,7 @@ static ByteBuffer TreeHashFinalCompute(Aws::List<ByteBuffer>& input)
             iter = input.erase(iter);
             str.append(reinterpret_cast<char*>(iter->GetUnderlyingData()), iter->GetLength());
             iter = input.erase(iter);
-            input.insert(iter, hash.Calculate(str).GetResult());
+            input.insert(iter, hash->Calculate(str).GetResult());
 
             if (iter == input.end()) break;
         } // while process to the last element
@@ -99,17 +287,17 @@ static ByteBuffer TreeHashFinalCompute(Aws::List<ByteBuffer>& input)
 
 ByteBuffer HashingUtils::CalculateSHA256TreeHash(const Aws::String& str)
 {
-    Sha256 hash;
+    auto hash = GetThreadSha256Implementation();
     if (str.size() == 0)
     {
-        return hash.Calculate(str).GetResult();
+        return hash->Calculate(str).GetResult();
     }
 
     Aws::List<ByteBuffer> input;
     size_t pos = 0;
     while (pos < str.size())
     {
-        input.push_back(hash.Calculate(Aws::String(str, pos, TREE_HASH_ONE_MB)).GetResult());
+        input.push_back(hash->Calculate(Aws::String(str, pos, TREE_HASH_ONE_MB)).GetResult());
         pos += TREE_HASH_ONE_MB;
     }
 
@@ -118,7 +306,7 @@ ByteBuffer HashingUtils::CalculateSHA256TreeHash(const Aws::String& str)
 
 ByteBuffer HashingUtils::CalculateSHA256TreeHash(Aws::IOStream& stream)
 {
-    Sha256 hash;
+    auto hash = GetThreadSha256Implementation();
     Aws::List<ByteBuffer> input;
     auto currentPos = stream.tellg();
     if (currentPos == std::ios::pos_type(-1))
@@ -134,7 +322,7 @@ ByteBuffer HashingUtils::CalculateSHA256TreeHash(Aws::IOStream& stream)
         auto bytesRead = stream.gcount();
         if (bytesRead > 0)
         {
-            input.push_back(hash.Calculate(Aws::String(reinterpret_cast<char*>(streamBuffer.GetUnderlyingData()), static_cast<size_t>(bytesRead))).GetResult());
+            input.push_back(hash->Calculate(Aws::String(reinterpret_cast<char*>(streamBuffer.GetUnderlyingData()), static_cast<size_t>(bytesRead))).GetResult());
         }
     }
     stream.clear();
@@ -142,7 +330,7 @@ ByteBuffer HashingUtils::CalculateSHA256TreeHash(Aws::IOStream& stream)
 
     if (input.size() == 0)
     {
-        return hash.Calculate("").GetResult();
+        return hash->Calculate("").GetResult();
     }
     return TreeHashFinalCompute(input);
 }
@@ -221,14 +409,33 @@ ByteBuffer HashingUtils::HexDecode(const Aws::String& str)
 
 ByteBuffer HashingUtils::CalculateMD5(const Aws::String& str)
 {
-    MD5 hash;
-    return hash.Calculate(str).GetResult();
+    return GetThreadMD5Implementation()->Calculate(str).GetResult();
 }
 
 ByteBuffer HashingUtils::CalculateMD5(Aws::IOStream& stream)
 {
-    MD5 hash;
-    return hash.Calculate(stream).GetResult();
+    return GetThreadMD5Implementation()->Calculate(stream).GetResult();
+}
+
+uint32_t HashingUtils::CalculateCRC32(const unsigned char* data, size_t length, uint32_t crc)
+{
+    crc = ~crc;
+#if defined(AWS_CRC32_PCLMUL)
+    static const bool hasPclmul = CpuSupportsPclmul();
+    if (hasPclmul && length >= CRC32_PCLMUL_MIN_LENGTH)
+    {
+        size_t blocksLength = length & ~static_cast<size_t>(15);
+        crc = Crc32Pclmul(data, blocksLength, crc);
+        data += blocksLength;
+        length -= blocksLength;
+    }
+    crc = Crc32Software(data, length, crc);
+#elif defined(AWS_CRC32_ARM)
+    crc = Crc32Arm(data, length, crc);
+#else
+    crc = Crc32Software(data, length, crc);
+#endif
+    return ~crc;
 }
 
 int HashingUtils::HashString(const char* strToHash)
@@ -19,6 +19,7 @@
 #include <aws/core/utils/logging/LogMacros.h>
 #include <cstdlib>
 #include <climits>
+#include <cstring>
 
 //if you are reading this, you are witnessing pure brilliance.
 #define IS_BIG_ENDIAN (*(uint16_t*)"\0\xff" < 0x100)
@@ -102,6 +103,32 @@ namespace Aws
                 }
             }
 
+            size_t SymmetricCipher::EncryptBufferInto(const unsigned char* unEncryptedData, size_t length, unsigned char* output, size_t outputCapacity)
+            {
+                return CopyToOutput(EncryptBuffer(CryptoBuffer(unEncryptedData, length)), output, outputCapacity);
+            }
+
+            size_t SymmetricCipher::DecryptBufferInto(const unsigned char* encryptedData, size_t length, unsigned char* output, size_t outputCapacity)
+            {
+                return CopyToOutput(DecryptBuffer(CryptoBuffer(encryptedData, length)), output, outputCapacity);
+            }
+
+            size_t SymmetricCipher::CopyToOutput(const CryptoBuffer& result, unsigned char* output, size_t outputCapacity)
+            {
+                if(result.GetLength() > outputCapacity)
+                {
+                    m_failure = true;
+                    AWS_LOGSTREAM_ERROR(LOG_TAG, "Cipher output of " << result.GetLength() << " bytes doesn't fit in an output buffer of " << outputCapacity << " bytes");
+                    return 0;
+                }
+
+                if(result.GetLength())
+                {
+                    memcpy(output, result.GetUnderlyingData(), result.GetLength());
+                }
+                return result.GetLength();
+            }
+
             /**
              * Generate random number per 4 bytes and use each byte for the byte in the iv
              */
@@ -14,6 +14,10 @@
   */
 
 #include <aws/core/utils/crypto/CryptoBuf.h>
+#include <aws/core/platform/Security.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
 
 namespace Aws
 {
@@ -21,15 +25,66 @@ namespace Aws
     {
         namespace Crypto
         {
+            static unsigned char* AlignUp(unsigned char* ptr, size_t alignment)
+            {
+                uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+                return ptr + (alignment - address % alignment) % alignment;
+            }
+
             SymmetricCryptoBufSrc::SymmetricCryptoBufSrc(Aws::IStream& stream, SymmetricCipher& cipher, CipherMode cipherMode, size_t bufferSize)
                     :
-                    m_isBuf(PUT_BACK_SIZE), m_cipher(cipher), m_stream(stream), m_cipherMode(cipherMode), m_isFinalized(false),
-                    m_bufferSize(bufferSize), m_putBack(PUT_BACK_SIZE)
+                    m_isBuf(PUT_BACK_SIZE + bufferSize + 2 * MAX_SYMMETRIC_BLOCK_SIZE + CRYPTO_BUF_ALIGNMENT), m_readBuf(bufferSize + CRYPTO_BUF_ALIGNMENT),
+                    m_cipher(cipher), m_stream(stream), m_cipherMode(cipherMode), m_isFinalized(false),
+                    m_bufferSize(bufferSize), m_putBack(PUT_BACK_SIZE), m_dataStart(nullptr), m_readStart(nullptr), m_bytesUsed(0)
             {
-                char* end = reinterpret_cast<char*>(m_isBuf.GetUnderlyingData() + m_isBuf.GetLength());
+                //the cipher writes to m_dataStart, the put back area sits right in front of it.
+                m_dataStart = AlignUp(m_isBuf.GetUnderlyingData() + m_putBack, CRYPTO_BUF_ALIGNMENT);
+                m_readStart = AlignUp(m_readBuf.GetUnderlyingData(), CRYPTO_BUF_ALIGNMENT);
+                char* end = reinterpret_cast<char*>(m_dataStart);
                 setg(end, end, end);
             }
 
+            SymmetricCryptoBufSrc::~SymmetricCryptoBufSrc()
+            {
+                FinalizeCipher();
+                //the buffers hold plain text. Wipe only as far as we ever wrote, so a large buffer used for a small stream doesn't fault in pages it never touched.
+                Aws::Security::SecureMemClear(m_dataStart - m_putBack, m_putBack + m_bytesUsed);
+                Aws::Security::SecureMemClear(m_readStart, std::min(m_bytesUsed, m_bufferSize));
+            }
+
+            size_t SymmetricCryptoBufSrc::TransformNextChunk(size_t maxRead)
+            {
+                size_t outputCapacity = static_cast<size_t>(m_isBuf.GetUnderlyingData() + m_isBuf.GetLength() - m_dataStart);
+                size_t readSize(0);
+                if(m_stream)
+                {
+                    m_stream.read(reinterpret_cast<char*>(m_readStart), maxRead);
+                    readSize = static_cast<size_t>(m_stream.gcount());
+                }
+
+                if (readSize > 0)
+                {
+                    size_t written = m_cipherMode == CipherMode::Encrypt ?
+                        m_cipher.EncryptBufferInto(m_readStart, readSize, m_dataStart, outputCapacity) :
+                        m_cipher.DecryptBufferInto(m_readStart, readSize, m_dataStart, outputCapacity);
+                    m_bytesUsed = std::max(m_bytesUsed, std::max(readSize, written));
+                    return written;
+                }
+
+                CryptoBuffer finalBlock = m_cipherMode == CipherMode::Encrypt ? m_cipher.FinalizeEncryption() : m_cipher.FinalizeDecryption();
+                m_isFinalized = true;
+
+                //the final block is at most one cipher block, which always fits in the slack behind the data.
+                assert(finalBlock.GetLength() <= outputCapacity);
+                size_t finalLength = std::min(finalBlock.GetLength(), outputCapacity);
+                if (finalLength)
+                {
+                    memcpy(m_dataStart, finalBlock.GetUnderlyingData(), finalLength);
+                }
+                m_bytesUsed = std::max(m_bytesUsed, finalLength);
+                return finalLength;
+            }
+
             SymmetricCryptoBufSrc::pos_type SymmetricCryptoBufSrc::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
             {
                 if(which == std::ios_base::in)
@@ -60,64 +115,27 @@ namespace Aws
                         index = 0;
                     }
 
-                    CryptoBuffer cryptoBuffer;
+                    size_t chunkLength = 0;
                     while (m_cipher && index < seekTo && !m_isFinalized)
                     {
-                        size_t max_read = std::min<size_t>(static_cast<size_t>(seekTo - index), m_bufferSize);
-
-                        Aws::Utils::Array<char> buf(max_read);
-                        size_t readSize(0);
-                        if(m_stream)
-                        {
-                            m_stream.read(buf.GetUnderlyingData(), max_read);
-                            readSize = static_cast<size_t>(m_stream.gcount());
-                        }
-
-                        if (readSize > 0)
-                        {
-                            if (m_cipherMode == CipherMode::Encrypt)
-                            {
-                                cryptoBuffer = m_cipher.EncryptBuffer(CryptoBuffer(reinterpret_cast<unsigned char*>(buf.GetUnderlyingData()), readSize));
-                            }
-                            else
-                            {
-                                cryptoBuffer = m_cipher.DecryptBuffer(CryptoBuffer(reinterpret_cast<unsigned char*>(buf.GetUnderlyingData()), readSize));
-                            }
-                        }
-                        else
-                        {
-                            if (m_cipherMode == CipherMode::Encrypt)
-                            {
-                                cryptoBuffer = m_cipher.FinalizeEncryption();
-                            }
-                            else
-                            {
-                                cryptoBuffer = m_cipher.FinalizeDecryption();
-                            }
-
-                            m_isFinalized = true;
-                        }
-
-                        index += cryptoBuffer.GetLength();
+                        chunkLength = TransformNextChunk(std::min<size_t>(static_cast<size_t>(seekTo - index), m_bufferSize));
+                        index += chunkLength;
                     }
 
-                    if (cryptoBuffer.GetLength() && m_cipher)
+                    if (chunkLength && m_cipher)
                     {
-                        CryptoBuffer putBackArea(m_putBack);
-                                                
-                        m_isBuf = CryptoBuffer({&putBackArea, &cryptoBuffer});
                         //in the very unlikely case that the cipher had less output than the source stream.
                         assert(seekTo <= index);
-                        size_t newBufferPos = index > seekTo ? cryptoBuffer.GetLength() - (index - seekTo) : cryptoBuffer.GetLength();
-                        char* baseBufPtr = reinterpret_cast<char*>(m_isBuf.GetUnderlyingData());
-                        setg(baseBufPtr, baseBufPtr + m_putBack + newBufferPos, baseBufPtr + m_isBuf.GetLength());
+                        size_t newBufferPos = index > seekTo ? chunkLength - (index - seekTo) : chunkLength;
+                        memset(m_dataStart - m_putBack, 0, m_putBack);
+                        char* baseBufPtr = reinterpret_cast<char*>(m_dataStart - m_putBack);
+                        setg(baseBufPtr, baseBufPtr + m_putBack + newBufferPos, baseBufPtr + m_putBack + chunkLength);
 
                         return pos_type(seekTo);
                     }
                     else if (seekTo == 0)
                     {
-                        m_isBuf = CryptoBuffer(m_putBack);
-                        char* end = reinterpret_cast<char*>(m_isBuf.GetUnderlyingData() + m_isBuf.GetLength());
+                        char* end = reinterpret_cast<char*>(m_dataStart);
                         setg(end, end, end);
                         return pos_type(seekTo);
                     }
@@ -143,57 +161,28 @@ namespace Aws
                     return traits_type::to_int_type(*gptr());
                 }
 
-                char* baseBufPtr = reinterpret_cast<char*>(m_isBuf.GetUnderlyingData());
-                CryptoBuffer putBackArea(m_putBack);
+                char* baseBufPtr = reinterpret_cast<char*>(m_dataStart - m_putBack);
 
                 //eback is properly set after the first fill. So this guarantees we are on the second or later fill.
                 if (eback() == baseBufPtr)
                 {
                     //just fill in the last bit of the previous buffer into the put back area so that it has some data in it
-                    memcpy(putBackArea.GetUnderlyingData(), egptr() - m_putBack, m_putBack);
+                    memmove(baseBufPtr, egptr() - m_putBack, m_putBack);
                 }
-
-                CryptoBuffer newDataBuf;
-
-                while(!newDataBuf.GetLength() && !m_isFinalized)
+                else
                 {
-                    Aws::Utils::Array<char> buf(m_bufferSize);
-                    m_stream.read(buf.GetUnderlyingData(), m_bufferSize);
-                    size_t readSize = static_cast<size_t>(m_stream.gcount());
-
-                    if (readSize > 0)
-                    {
-                        if (m_cipherMode == CipherMode::Encrypt)
-                        {
-                            newDataBuf = m_cipher.EncryptBuffer(CryptoBuffer(reinterpret_cast<unsigned char*>(buf.GetUnderlyingData()), readSize));
-                        }
-                        else
-                        {
-                            newDataBuf = m_cipher.DecryptBuffer(CryptoBuffer(reinterpret_cast<unsigned char*>(buf.GetUnderlyingData()), readSize));
-                        }
-                    }
-                    else
-                    {
-                        if (m_cipherMode == CipherMode::Encrypt)
-                        {
-                            newDataBuf = m_cipher.FinalizeEncryption();
-                        }
-                        else
-                        {
-                            newDataBuf = m_cipher.FinalizeDecryption();
-                        }
-
-                        m_isFinalized = true;
-                    }
+                    memset(baseBufPtr, 0, m_putBack);
                 }
 
-
-                if(newDataBuf.GetLength() > 0)
+                size_t newDataLength = 0;
+                while(m_cipher && !newDataLength && !m_isFinalized)
                 {
-                    m_isBuf = CryptoBuffer({&putBackArea, &newDataBuf});
+                    newDataLength = TransformNextChunk(m_bufferSize);
+                }
 
-                    baseBufPtr = reinterpret_cast<char*>(m_isBuf.GetUnderlyingData());
-                    setg(baseBufPtr, baseBufPtr + m_putBack, baseBufPtr + m_isBuf.GetLength());
+                if(m_cipher && newDataLength > 0)
+                {
+                    setg(baseBufPtr, baseBufPtr + m_putBack, baseBufPtr + m_putBack + newDataLength);
 
                     return traits_type::to_int_type(*gptr());
                 }
@@ -238,16 +227,23 @@ namespace Aws
 
             SymmetricCryptoBufSink::SymmetricCryptoBufSink(Aws::OStream& stream, SymmetricCipher& cipher, CipherMode cipherMode, size_t bufferSize, int16_t blockOffset)
                     :
-                    m_osBuf(bufferSize), m_cipher(cipher), m_stream(stream), m_cipherMode(cipherMode), m_isFinalized(false), m_blockOffset(blockOffset)
+                    m_osBuf(bufferSize + CRYPTO_BUF_ALIGNMENT), m_cipherOutBuf(bufferSize + 2 * MAX_SYMMETRIC_BLOCK_SIZE + CRYPTO_BUF_ALIGNMENT),
+                    m_cipher(cipher), m_stream(stream), m_cipherMode(cipherMode), m_isFinalized(false), m_blockOffset(blockOffset),
+                    m_cipherOut(nullptr), m_cipherOutCapacity(0), m_bytesUsed(0)
             {
                 assert(m_blockOffset < 16 && m_blockOffset >= 0);
-                char* outputBase = reinterpret_cast<char*>(m_osBuf.GetUnderlyingData());
+                char* outputBase = reinterpret_cast<char*>(AlignUp(m_osBuf.GetUnderlyingData(), CRYPTO_BUF_ALIGNMENT));
                 setp(outputBase, outputBase + bufferSize - 1);
+                m_cipherOut = AlignUp(m_cipherOutBuf.GetUnderlyingData(), CRYPTO_BUF_ALIGNMENT);
+                m_cipherOutCapacity = static_cast<size_t>(m_cipherOutBuf.GetUnderlyingData() + m_cipherOutBuf.GetLength() - m_cipherOut);
             }
 
             SymmetricCryptoBufSink::~SymmetricCryptoBufSink()
             {
                 FinalizeCiphersAndFlushSink();
+                //same as the src, wipe the plain text but only as far as we ever wrote.
+                Aws::Security::SecureMemClear(reinterpret_cast<unsigned char*>(pbase()), std::min(m_bytesUsed, static_cast<size_t>(epptr() - pbase()) + 1));
+                Aws::Security::SecureMemClear(m_cipherOut, std::min(m_bytesUsed, m_cipherOutCapacity));
             }
 
             void SymmetricCryptoBufSink::FinalizeCiphersAndFlushSink()
@@ -262,16 +258,19 @@ namespace Aws
             {
                 if(!m_isFinalized)
                 {
-                    CryptoBuffer cryptoBuf;
+                    size_t outputLength = 0;
                     if (pptr() > pbase())
                     {
+                        const unsigned char* input = reinterpret_cast<const unsigned char*>(pbase());
+                        size_t inputLength = static_cast<size_t>(pptr() - pbase());
+                        m_bytesUsed = std::max(m_bytesUsed, inputLength);
                         if (m_cipherMode == CipherMode::Encrypt)
                         {
-                            cryptoBuf = m_cipher.EncryptBuffer(CryptoBuffer(reinterpret_cast<unsigned char*>(pbase()), pptr() - pbase()));
+                            outputLength = m_cipher.EncryptBufferInto(input, inputLength, m_cipherOut, m_cipherOutCapacity);
                         }
                         else
                         {
-                            cryptoBuf = m_cipher.DecryptBuffer(CryptoBuffer(reinterpret_cast<unsigned char*>(pbase()), pptr() - pbase()));
+                            outputLength = m_cipher.DecryptBufferInto(input, inputLength, m_cipherOut, m_cipherOutCapacity);
                         }
 
                         pbump(-(static_cast<int>(pptr() - pbase())));
@@ -287,27 +286,28 @@ namespace Aws
                         {
                             finalBuffer = m_cipher.FinalizeDecryption();
                         }
-                        if(cryptoBuf.GetLength())
-                        {
-                            cryptoBuf = CryptoBuffer({&cryptoBuf, &finalBuffer});
-                        }
-                        else
+
+                        //the cipher out buffer keeps a block of slack past the largest update output for this.
+                        assert(outputLength + finalBuffer.GetLength() <= m_cipherOutCapacity);
+                        if(finalBuffer.GetLength() && outputLength + finalBuffer.GetLength() <= m_cipherOutCapacity)
                         {
-                            cryptoBuf = std::move(finalBuffer);
+                            memcpy(m_cipherOut + outputLength, finalBuffer.GetUnderlyingData(), finalBuffer.GetLength());
+                            outputLength += finalBuffer.GetLength();
                         }
 
                         m_isFinalized = true;
                     }
+                    m_bytesUsed = std::max(m_bytesUsed, outputLength);
 
                     if (m_cipher)
                     {
-                        if(cryptoBuf.GetLength())
+                        if(outputLength)
                         {
                             //allow mid block decryption. We have to decrypt it, but we don't have to write it to the stream.
                             //the assumption here is that tellp() will always be 0 or >= 16 bytes. The block offset should only 
                             //be the offset of the first block read.
                             auto blockOffset = m_stream.tellp() > m_blockOffset ? 0 : m_blockOffset;
-                            m_stream.write(reinterpret_cast<char*>(cryptoBuf.GetUnderlyingData() + blockOffset), cryptoBuf.GetLength() - blockOffset);
+                            m_stream.write(reinterpret_cast<char*>(m_cipherOut + blockOffset), outputLength - blockOffset);
                         }
                         return true;
                     }
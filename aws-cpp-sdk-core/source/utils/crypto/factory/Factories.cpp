@@ -17,6 +17,8 @@
 #include <aws/core/utils/crypto/Factories.h>
 #include <aws/core/utils/crypto/Hash.h>
 #include <aws/core/utils/crypto/HMAC.h>
+#include <aws/core/utils/UnreferencedParam.h>
+#include <atomic>
 
 #if ENABLE_BCRYPT_ENCRYPTION
     #include <aws/core/utils/crypto/bcrypt/CryptoImpl.h>
@@ -53,6 +55,35 @@ static std::shared_ptr<SecureRandomBytes> s_SecureRandom(nullptr);
 
 static bool s_InitCleanupOpenSSLFlag(false);
 
+// bumped whenever the hash factories may have changed, so threads drop the providers they made with the old ones
+static std::atomic<unsigned> s_factoryGeneration(1);
+
+struct ThreadHashImplementations
+{
+    ThreadHashImplementations() : generation(0) {}
+
+    unsigned generation;
+    std::shared_ptr<Hash> md5;
+    std::shared_ptr<Hash> sha256;
+    std::shared_ptr<Aws::Utils::Crypto::HMAC> sha256HMAC;
+};
+
+static thread_local ThreadHashImplementations s_threadHashImplementations;
+
+static ThreadHashImplementations& GetThreadHashImplementations()
+{
+    ThreadHashImplementations& implementations = s_threadHashImplementations;
+    unsigned generation = s_factoryGeneration.load(std::memory_order_acquire);
+    if (implementations.generation != generation)
+    {
+        implementations.md5 = nullptr;
+        implementations.sha256 = nullptr;
+        implementations.sha256HMAC = nullptr;
+        implementations.generation = generation;
+    }
+    return implementations;
+}
+
 class DefaultMD5Factory : public HashFactory
 {
 public:
@@ -569,6 +600,7 @@ void Aws::Utils::Crypto::SetInitCleanupOpenSSLFlag(bool initCleanupFlag)
 
 void Aws::Utils::Crypto::InitCrypto()
 {
+    ++s_factoryGeneration;
     if(s_MD5Factory)
     {
         s_MD5Factory->InitStaticState();
@@ -650,6 +682,14 @@ void Aws::Utils::Crypto::InitCrypto()
 
 void Aws::Utils::Crypto::CleanupCrypto()
 {
+    // the calling thread's providers and pooled contexts go now, before OpenSSL is cleaned up; other threads' providers go when
+    // they next ask for one, and their contexts when they exit
+    ++s_factoryGeneration;
+    GetThreadHashImplementations();
+#if ENABLE_OPENSSL_ENCRYPTION
+    OpenSSL::FreeThreadContextPools();
+#endif
+
     if(s_MD5Factory)
     {
         s_MD5Factory->CleanupStaticState();
@@ -703,16 +743,19 @@ void Aws::Utils::Crypto::CleanupCrypto()
 void Aws::Utils::Crypto::SetMD5Factory(const std::shared_ptr<HashFactory>& factory)
 {
     s_MD5Factory = factory;
+    ++s_factoryGeneration;
 }
 
 void Aws::Utils::Crypto::SetSha256Factory(const std::shared_ptr<HashFactory>& factory)
 {
     s_Sha256Factory = factory;
+    ++s_factoryGeneration;
 }
 
 void Aws::Utils::Crypto::SetSha256HMACFactory(const std::shared_ptr<HMACFactory>& factory)
 {
     s_Sha256HMACFactory = factory;
+    ++s_factoryGeneration;
 }
 
 void Aws::Utils::Crypto::SetAES_CBCFactory(const std::shared_ptr<SymmetricCipherFactory>& factory)
@@ -755,6 +798,56 @@ std::shared_ptr<Aws::Utils::Crypto::HMAC> Aws::Utils::Crypto::CreateSha256HMACIm
     return s_Sha256HMACFactory->CreateImplementation();
 }
 
+std::shared_ptr<Hash> Aws::Utils::Crypto::GetThreadMD5Implementation()
+{
+    ThreadHashImplementations& implementations = GetThreadHashImplementations();
+    if (!implementations.md5)
+    {
+        implementations.md5 = CreateMD5Implementation();
+    }
+    return implementations.md5;
+}
+
+std::shared_ptr<Hash> Aws::Utils::Crypto::GetThreadSha256Implementation()
+{
+    ThreadHashImplementations& implementations = GetThreadHashImplementations();
+    if (!implementations.sha256)
+    {
+        implementations.sha256 = CreateSha256Implementation();
+    }
+    return implementations.sha256;
+}
+
+std::shared_ptr<Aws::Utils::Crypto::HMAC> Aws::Utils::Crypto::GetThreadSha256HMACImplementation()
+{
+    ThreadHashImplementations& implementations = GetThreadHashImplementations();
+    if (!implementations.sha256HMAC)
+    {
+        implementations.sha256HMAC = CreateSha256HMACImplementation();
+    }
+    return implementations.sha256HMAC;
+}
+
+void Aws::Utils::Crypto::SetCryptoContextPoolSize(size_t contextsPerThread)
+{
+#if ENABLE_OPENSSL_ENCRYPTION
+    OpenSSL::SetContextPoolSize(contextsPerThread);
+#else
+    AWS_UNREFERENCED_PARAM(contextsPerThread);
+#endif
+}
+
+CryptoContextPoolStats Aws::Utils::Crypto::GetThreadCryptoContextPoolStats()
+{
+    CryptoContextPoolStats stats;
+    stats.contextsCreated = 0;
+    stats.contextsReused = 0;
+#if ENABLE_OPENSSL_ENCRYPTION
+    OpenSSL::GetContextPoolStats(stats.contextsCreated, stats.contextsReused);
+#endif
+    return stats;
+}
+
 #ifdef _WIN32
 #pragma warning( push )
 #pragma warning( disable : 4702 )
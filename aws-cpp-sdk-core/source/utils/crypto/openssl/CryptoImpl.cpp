@@ -14,6 +14,7 @@
   */
 
 #include <cstring>
+#include <algorithm>
 
 #include <aws/core/utils/memory/AWSMemory.h>
 #include <aws/core/utils/crypto/openssl/CryptoImpl.h>
@@ -111,6 +112,193 @@ namespace Aws
                     return static_cast<unsigned long>(std::hash<std::thread::id>()(std::this_thread::get_id()));
                 }
 #endif
+
+                static std::atomic<size_t> s_contextPoolSize(8);
+
+                template<typename CTX>
+                struct ContextPool
+                {
+                    CTX* contexts[MAX_POOLED_CONTEXTS];
+                    size_t count;
+                };
+
+                /**
+                 * Plain data, so that it stays usable while the thread's other thread_local objects are destroyed, and contexts
+                 * released from their destructors after the pools are closed are freed instead.
+                 */
+                struct ThreadContextPools
+                {
+                    ContextPool<EVP_MD_CTX> md;
+                    ContextPool<HMAC_CTX> hmac;
+                    ContextPool<EVP_CIPHER_CTX> cipher;
+                    size_t created;
+                    size_t reused;
+                    bool closed;
+                    bool watched;
+                };
+
+                static thread_local ThreadContextPools s_threadContextPools;
+
+                static EVP_MD_CTX* NewMDContext()
+                {
+                    return EVP_MD_CTX_create();
+                }
+
+                static void FreeMDContext(EVP_MD_CTX* ctx)
+                {
+                    EVP_MD_CTX_destroy(ctx);
+                }
+
+                static HMAC_CTX* NewHMACContext()
+                {
+#if OPENSSL_VERSION_LESS_1_1
+                    return Aws::New<HMAC_CTX>("AllocSha256HAMCOpenSSLContext");
+#else
+                    return HMAC_CTX_new();
+#endif
+                }
+
+                static void FreeHMACContext(HMAC_CTX* ctx)
+                {
+#if OPENSSL_VERSION_LESS_1_1
+                    Aws::Delete<HMAC_CTX>(ctx);
+#else
+                    HMAC_CTX_free(ctx);
+#endif
+                }
+
+                static EVP_CIPHER_CTX* NewCipherContext()
+                {
+                    // EVP_CIPHER_CTX_init() will be called inside EVP_CIPHER_CTX_new().
+                    return EVP_CIPHER_CTX_new();
+                }
+
+                static void FreeCipherContext(EVP_CIPHER_CTX* ctx)
+                {
+                    EVP_CIPHER_CTX_free(ctx);
+                }
+
+                template<typename CTX>
+                static void FreeContexts(ContextPool<CTX>& pool, void (*freeContext)(CTX*))
+                {
+                    while (pool.count > 0)
+                    {
+                        freeContext(pool.contexts[--pool.count]);
+                    }
+                }
+
+                /**
+                 * Frees the thread's pooled contexts when the thread exits.
+                 */
+                class ThreadContextPoolsCleaner
+                {
+                public:
+                    ThreadContextPoolsCleaner() : m_pools(nullptr) {}
+
+                    ~ThreadContextPoolsCleaner()
+                    {
+                        if (m_pools)
+                        {
+                            m_pools->closed = true;
+                            FreeContexts(m_pools->md, &FreeMDContext);
+                            FreeContexts(m_pools->hmac, &FreeHMACContext);
+                            FreeContexts(m_pools->cipher, &FreeCipherContext);
+                        }
+                    }
+
+                    void Watch(ThreadContextPools* pools)
+                    {
+                        m_pools = pools;
+                    }
+
+                private:
+                    ThreadContextPools* m_pools;
+                };
+
+                static thread_local ThreadContextPoolsCleaner s_threadContextPoolsCleaner;
+
+                template<typename CTX>
+                static CTX* AcquireContext(ContextPool<CTX> ThreadContextPools::*pool, CTX* (*newContext)())
+                {
+                    ThreadContextPools& pools = s_threadContextPools;
+                    ContextPool<CTX>& contexts = pools.*pool;
+                    if (contexts.count > 0)
+                    {
+                        ++pools.reused;
+                        return contexts.contexts[--contexts.count];
+                    }
+                    ++pools.created;
+                    CTX* ctx = newContext();
+                    assert(ctx != nullptr);
+                    return ctx;
+                }
+
+                template<typename CTX>
+                static void ReleaseContext(ContextPool<CTX> ThreadContextPools::*pool, CTX* ctx, void (*freeContext)(CTX*))
+                {
+                    ThreadContextPools& pools = s_threadContextPools;
+                    ContextPool<CTX>& contexts = pools.*pool;
+                    if (!pools.closed && contexts.count < (std::min)(s_contextPoolSize.load(std::memory_order_relaxed), MAX_POOLED_CONTEXTS))
+                    {
+                        if (!pools.watched)
+                        {
+                            pools.watched = true;
+                            s_threadContextPoolsCleaner.Watch(&pools);
+                        }
+                        contexts.contexts[contexts.count++] = ctx;
+                        return;
+                    }
+                    freeContext(ctx);
+                }
+
+                EVP_MD_CTX* AcquireMDContext()
+                {
+                    return AcquireContext(&ThreadContextPools::md, &NewMDContext);
+                }
+
+                void ReleaseMDContext(EVP_MD_CTX* ctx)
+                {
+                    ReleaseContext(&ThreadContextPools::md, ctx, &FreeMDContext);
+                }
+
+                HMAC_CTX* AcquireHMACContext()
+                {
+                    return AcquireContext(&ThreadContextPools::hmac, &NewHMACContext);
+                }
+
+                void ReleaseHMACContext(HMAC_CTX* ctx)
+                {
+                    ReleaseContext(&ThreadContextPools::hmac, ctx, &FreeHMACContext);
+                }
+
+                EVP_CIPHER_CTX* AcquireCipherContext()
+                {
+                    return AcquireContext(&ThreadContextPools::cipher, &NewCipherContext);
+                }
+
+                void ReleaseCipherContext(EVP_CIPHER_CTX* ctx)
+                {
+                    ReleaseContext(&ThreadContextPools::cipher, ctx, &FreeCipherContext);
+                }
+
+                void SetContextPoolSize(size_t contextsPerThread)
+                {
+                    s_contextPoolSize = (std::min)(contextsPerThread, MAX_POOLED_CONTEXTS);
+                }
+
+                void GetContextPoolStats(size_t& created, size_t& reused)
+                {
+                    created = s_threadContextPools.created;
+                    reused = s_threadContextPools.reused;
+                }
+
+                void FreeThreadContextPools()
+                {
+                    ThreadContextPools& pools = s_threadContextPools;
+                    FreeContexts(pools.md, &FreeMDContext);
+                    FreeContexts(pools.hmac, &FreeHMACContext);
+                    FreeContexts(pools.cipher, &FreeCipherContext);
+                }
             }
 
             void SecureRandomBytes_OpenSSLImpl::GetBytes(unsigned char* buffer, size_t bufferSize)
@@ -129,13 +317,12 @@ namespace Aws
                 public:
                 OpensslCtxRAIIGuard() 
                 {
-                    m_ctx = EVP_MD_CTX_create();
-                    assert(m_ctx != nullptr);
+                    m_ctx = OpenSSL::AcquireMDContext();
                 }
 
                 ~OpensslCtxRAIIGuard() 
                 {
-                    EVP_MD_CTX_destroy(m_ctx);
+                    OpenSSL::ReleaseMDContext(m_ctx);
                     m_ctx = nullptr;
                 }
 
@@ -156,7 +343,7 @@ namespace Aws
                 EVP_DigestUpdate(ctx, str.c_str(), str.size());
 
                 ByteBuffer hash(EVP_MD_size(EVP_md5()));
-                EVP_DigestFinal(ctx, hash.GetUnderlyingData(), nullptr);
+                EVP_DigestFinal_ex(ctx, hash.GetUnderlyingData(), nullptr);
 
                 return HashResult(std::move(hash));
             }
@@ -192,7 +379,7 @@ namespace Aws
                 stream.seekg(currentPos, stream.beg);
 
                 ByteBuffer hash(EVP_MD_size(EVP_md5()));
-                EVP_DigestFinal(ctx, hash.GetUnderlyingData(), nullptr);
+                EVP_DigestFinal_ex(ctx, hash.GetUnderlyingData(), nullptr);
 
                 return HashResult(std::move(hash));
             }
@@ -205,7 +392,7 @@ namespace Aws
                 EVP_DigestUpdate(ctx, str.c_str(), str.size());
 
                 ByteBuffer hash(EVP_MD_size(EVP_sha256()));
-                EVP_DigestFinal(ctx, hash.GetUnderlyingData(), nullptr);
+                EVP_DigestFinal_ex(ctx, hash.GetUnderlyingData(), nullptr);
 
                 return HashResult(std::move(hash));
             }
@@ -242,7 +429,7 @@ namespace Aws
                 stream.seekg(currentPos, stream.beg);
 
                 ByteBuffer hash(EVP_MD_size(EVP_sha256()));
-                EVP_DigestFinal(ctx, hash.GetUnderlyingData(), nullptr);
+                EVP_DigestFinal_ex(ctx, hash.GetUnderlyingData(), nullptr);
 
                 return HashResult(std::move(hash));
             }
@@ -250,20 +437,11 @@ namespace Aws
             class HMACRAIIGuard {
             public:
                 HMACRAIIGuard() {
-#if OPENSSL_VERSION_LESS_1_1
-                    m_ctx = Aws::New<HMAC_CTX>("AllocSha256HAMCOpenSSLContext");
-#else
-                    m_ctx = HMAC_CTX_new();
-#endif
-                    assert(m_ctx != nullptr);
+                    m_ctx = OpenSSL::AcquireHMACContext();
                 }
 
                 ~HMACRAIIGuard() {
-#if OPENSSL_VERSION_LESS_1_1
-                    Aws::Delete<HMAC_CTX>(m_ctx);
-#else
-                    HMAC_CTX_free(m_ctx);
-#endif
+                    OpenSSL::ReleaseHMACContext(m_ctx);
                     m_ctx = nullptr;
                 }
 
@@ -346,12 +524,12 @@ namespace Aws
                 Cleanup();
                 if (m_encryptor_ctx)
                 {
-                    EVP_CIPHER_CTX_free(m_encryptor_ctx);
+                    OpenSSL::ReleaseCipherContext(m_encryptor_ctx);
                     m_encryptor_ctx = nullptr;
                 }
                 if (m_decryptor_ctx)
                 {
-                    EVP_CIPHER_CTX_free(m_decryptor_ctx);
+                    OpenSSL::ReleaseCipherContext(m_decryptor_ctx);
                     m_decryptor_ctx = nullptr;
                 }
             }
@@ -360,9 +538,8 @@ namespace Aws
             {
                 if (!m_encryptor_ctx)
                 {
-                    // EVP_CIPHER_CTX_init() will be called inside EVP_CIPHER_CTX_new().
-                    m_encryptor_ctx = EVP_CIPHER_CTX_new();
-                    assert(m_encryptor_ctx != nullptr);
+                    // pooled contexts were cleaned up when they were released
+                    m_encryptor_ctx = OpenSSL::AcquireCipherContext();
                 }
                 else
                 {   // _init is the same as _reset after openssl 1.1
@@ -370,9 +547,8 @@ namespace Aws
                 }
                 if (!m_decryptor_ctx)
                 {
-                    // EVP_CIPHER_CTX_init() will be called inside EVP_CIPHER_CTX_new().
-                    m_decryptor_ctx = EVP_CIPHER_CTX_new();
-                    assert(m_decryptor_ctx != nullptr);
+                    // pooled contexts were cleaned up when they were released
+                    m_decryptor_ctx = OpenSSL::AcquireCipherContext();
                 }
                 else
                 {   // _init is the same as _reset after openssl 1.1
@@ -476,6 +652,64 @@ namespace Aws
                 return CryptoBuffer(finalBlock.GetUnderlyingData(), static_cast<size_t>(writtenSize));
             }
 
+            typedef int (*EVPUpdateFunction)(EVP_CIPHER_CTX*, unsigned char*, int*, const unsigned char*, int);
+
+            //EVP takes int lengths, so feed it at most this much at a time.
+            static const size_t MAX_EVP_UPDATE_LENGTH = 1 << 30;
+
+            static size_t UpdateInto(EVPUpdateFunction update, EVP_CIPHER_CTX* ctx, size_t blockSizeBytes, const unsigned char* input,
+                                     size_t length, unsigned char* output, size_t outputCapacity, bool& failure)
+            {
+                if (outputCapacity < length + blockSizeBytes)
+                {
+                    failure = true;
+                    AWS_LOGSTREAM_ERROR(OPENSSL_LOG_TAG, "Output buffer of " << outputCapacity << " bytes is too small for " << length
+                                        << " bytes of input");
+                    return 0;
+                }
+
+                size_t totalWritten = 0;
+                while (length > 0)
+                {
+                    size_t toProcess = std::min(length, MAX_EVP_UPDATE_LENGTH);
+                    int lengthWritten = 0;
+                    if (!update(ctx, output + totalWritten, &lengthWritten, input, static_cast<int>(toProcess)))
+                    {
+                        failure = true;
+                        LogErrors();
+                        return 0;
+                    }
+
+                    totalWritten += static_cast<size_t>(lengthWritten);
+                    input += toProcess;
+                    length -= toProcess;
+                }
+
+                return totalWritten;
+            }
+
+            size_t OpenSSLCipher::EncryptBufferInto(const unsigned char* unEncryptedData, size_t length, unsigned char* output, size_t outputCapacity)
+            {
+                if (m_failure)
+                {
+                    AWS_LOGSTREAM_FATAL(OPENSSL_LOG_TAG, "Cipher not properly initialized for encryption. Aborting");
+                    return 0;
+                }
+
+                return UpdateInto(EVP_EncryptUpdate, m_encryptor_ctx, GetBlockSizeBytes(), unEncryptedData, length, output, outputCapacity, m_failure);
+            }
+
+            size_t OpenSSLCipher::DecryptBufferInto(const unsigned char* encryptedData, size_t length, unsigned char* output, size_t outputCapacity)
+            {
+                if (m_failure)
+                {
+                    AWS_LOGSTREAM_FATAL(OPENSSL_LOG_TAG, "Cipher not properly initialized for decryption. Aborting");
+                    return 0;
+                }
+
+                return UpdateInto(EVP_DecryptUpdate, m_decryptor_ctx, GetBlockSizeBytes(), encryptedData, length, output, outputCapacity, m_failure);
+            }
+
             void OpenSSLCipher::Reset()
             {
                 Cleanup();
@@ -713,6 +947,11 @@ namespace Aws
                 return CryptoBuffer();
             }
 
+            size_t AES_KeyWrap_Cipher_OpenSSL::EncryptBufferInto(const unsigned char* unEncryptedData, size_t length, unsigned char* output, size_t outputCapacity)
+            {
+                return SymmetricCipher::EncryptBufferInto(unEncryptedData, length, output, outputCapacity);
+            }
+
             CryptoBuffer AES_KeyWrap_Cipher_OpenSSL::FinalizeEncryption()
             {
                 if (m_failure)
@@ -794,6 +1033,11 @@ namespace Aws
                 return CryptoBuffer();
             }
 
+            size_t AES_KeyWrap_Cipher_OpenSSL::DecryptBufferInto(const unsigned char* encryptedData, size_t length, unsigned char* output, size_t outputCapacity)
+            {
+                return SymmetricCipher::DecryptBufferInto(encryptedData, length, output, outputCapacity);
+            }
+
             CryptoBuffer AES_KeyWrap_Cipher_OpenSSL::FinalizeDecryption()
             {
                 if (m_failure)
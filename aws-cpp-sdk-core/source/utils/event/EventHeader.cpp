@@ -33,6 +33,56 @@ namespace Aws
             static const int HASH_TIMESTAMP = HashingUtils::HashString("TIMESTAMP");
             static const int HASH_UUID = HashingUtils::HashString("UUID");
 
+            static uint64_t ReadBigEndian(const unsigned char* value, size_t valueLength)
+            {
+                uint64_t result = 0;
+                for (size_t i = 0; i < valueLength; ++i)
+                {
+                    result = (result << 8) | value[i];
+                }
+                return result;
+            }
+
+            EventHeaderValue::EventHeaderValue(EventHeaderType type, const unsigned char* value, size_t valueLength) :
+                m_eventHeaderType(type)
+            {
+                switch (m_eventHeaderType)
+                {
+                case EventHeaderType::BOOL_TRUE:
+                case EventHeaderType::BOOL_FALSE:
+                    m_eventHeaderStaticValue.boolValue = m_eventHeaderType == EventHeaderType::BOOL_TRUE;
+                    break;
+                case EventHeaderType::BYTE:
+                    assert(valueLength == 1u);
+                    m_eventHeaderStaticValue.byteValue = value[0];
+                    break;
+                case EventHeaderType::INT16:
+                    assert(valueLength == 2u);
+                    m_eventHeaderStaticValue.int16Value = static_cast<int16_t>(ReadBigEndian(value, valueLength));
+                    break;
+                case EventHeaderType::INT32:
+                    assert(valueLength == 4u);
+                    m_eventHeaderStaticValue.int32Value = static_cast<int32_t>(ReadBigEndian(value, valueLength));
+                    break;
+                case EventHeaderType::INT64:
+                    assert(valueLength == 8u);
+                    m_eventHeaderStaticValue.int64Value = static_cast<int64_t>(ReadBigEndian(value, valueLength));
+                    break;
+                case EventHeaderType::TIMESTAMP:
+                    assert(valueLength == 8u);
+                    m_eventHeaderStaticValue.timestampValue = static_cast<int64_t>(ReadBigEndian(value, valueLength));
+                    break;
+                case EventHeaderType::BYTE_BUF:
+                case EventHeaderType::STRING:
+                case EventHeaderType::UUID:
+                    m_eventHeaderVariableLengthValue = ByteBuffer(value, valueLength);
+                    break;
+                default:
+                    AWS_LOG_ERROR(CLASS_TAG, "Encountered unknown type of header.");
+                    break;
+                }
+            }
+
             EventHeaderValue::EventHeaderType EventHeaderValue::GetEventHeaderTypeForName(const Aws::String& name)
             {
                 int hashCode = Aws::Utils::HashingUtils::HashString(name.c_str());
@@ -38,6 +38,8 @@ namespace Aws
                 {
                     writeToDecoder();
                 }
+                // the response is over once its stream goes, so whoever made the request may rely on its events having been handled
+                m_decoder.WaitForDispatchedMessages();
             }
 
             void EventStreamBuf::writeToDecoder()
@@ -139,6 +141,26 @@ namespace Aws
                 return eof;
             }
 
+            std::streamsize EventStreamBuf::xsputn(const char* s, std::streamsize n)
+            {
+                if (!m_decoder || n < static_cast<std::streamsize>(m_bufferLength))
+                {
+                    return std::streambuf::xsputn(s, n);
+                }
+
+                // keep the stream in order: what's buffered goes first
+                writeToDecoder();
+                if (m_decoder)
+                {
+                    m_decoder.Pump(reinterpret_cast<const unsigned char*>(s), static_cast<size_t>(n));
+                }
+                if (!m_decoder)
+                {
+                    m_err.write(s, n);
+                }
+                return n;
+            }
+
             int EventStreamBuf::sync()
             {
                 if (m_decoder)
@@ -17,8 +17,16 @@
 #include <aws/core/utils/event/EventHeader.h>
 #include <aws/core/utils/event/EventMessage.h>
 #include <aws/core/utils/event/EventStreamDecoder.h>
+#include <aws/core/utils/HashingUtils.h>
 #include <aws/core/utils/logging/LogMacros.h>
 #include <aws/core/utils/UnreferencedParam.h>
+#include <aws/core/utils/memory/stl/AWSQueue.h>
+#include <aws/core/utils/threading/Executor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace Aws
 {
@@ -28,7 +36,248 @@ namespace Aws
         {
             static const char EVENT_STREAM_DECODER_CLASS_TAG[] = "Aws::Utils::Event::EventStreamDecoder";
 
-            EventStreamDecoder::EventStreamDecoder(EventStreamHandler* handler) : m_eventStreamHandler(handler)
+            // total byte-length, headers byte-length and prelude crc
+            static const uint32_t PRELUDE_LENGTH = 12;
+            static const uint32_t MESSAGE_CRC_LENGTH = 4;
+            // the same limits aws-c-event-stream enforces
+            static const uint32_t MAX_MESSAGE_LENGTH = 16 * 1024 * 1024;
+            static const uint32_t MAX_HEADERS_LENGTH = 128 * 1024;
+
+            static uint32_t ReadUInt32(const unsigned char* data)
+            {
+                return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 | static_cast<uint32_t>(data[2]) << 8 | data[3];
+            }
+
+            static void ReportDecodingError(EventStreamHandler* handler, EventStreamErrors error, const char* message)
+            {
+                handler->SetFailure();
+                handler->SetInternalError(static_cast<int>(error));
+                handler->WriteMessageEventPayload(reinterpret_cast<const unsigned char*>(message), strlen(message));
+                handler->OnEvent();
+            }
+
+            /**
+             * Decode a complete message whose prelude has been checked, and hand it to the handler.
+             */
+            static void DecodeMessage(EventStreamHandler* handler, Aws::Vector<EventHeaderView>& headerViews,
+                const unsigned char* message, uint32_t totalLength, uint32_t headersLength)
+            {
+                if (HashingUtils::CalculateCRC32(message, totalLength - MESSAGE_CRC_LENGTH) != ReadUInt32(message + totalLength - MESSAGE_CRC_LENGTH))
+                {
+                    ReportDecodingError(handler, EventStreamErrors::EVENT_STREAM_MESSAGE_CHECKSUM_FAILURE, "CRC Mismatch. The checksum of the message is wrong.");
+                    return;
+                }
+
+                // A header is 1 byte of name length, the name, 1 byte of value type, then the value: fixed length for the booleans,
+                // integers, timestamps and UUIDs, and 2 bytes of length followed by the bytes for byte buffers and strings.
+                headerViews.clear();
+                const unsigned char* header = message + PRELUDE_LENGTH;
+                const unsigned char* headersEnd = header + headersLength;
+                while (header < headersEnd)
+                {
+                    size_t nameLength = header[0];
+                    if (static_cast<size_t>(headersEnd - header) < nameLength + 2)
+                    {
+                        ReportDecodingError(handler, EventStreamErrors::EVENT_STREAM_MESSAGE_INVALID_HEADERS_LEN, "A header runs past the end of the headers.");
+                        return;
+                    }
+                    auto type = static_cast<EventHeaderValue::EventHeaderType>(header[nameLength + 1]);
+                    const unsigned char* value = header + nameLength + 2;
+                    size_t valueLength = 0;
+                    switch (type)
+                    {
+                    case EventHeaderValue::EventHeaderType::BOOL_TRUE:
+                    case EventHeaderValue::EventHeaderType::BOOL_FALSE:
+                        break;
+                    case EventHeaderValue::EventHeaderType::BYTE:
+                        valueLength = 1;
+                        break;
+                    case EventHeaderValue::EventHeaderType::INT16:
+                        valueLength = 2;
+                        break;
+                    case EventHeaderValue::EventHeaderType::INT32:
+                        valueLength = 4;
+                        break;
+                    case EventHeaderValue::EventHeaderType::INT64:
+                    case EventHeaderValue::EventHeaderType::TIMESTAMP:
+                        valueLength = 8;
+                        break;
+                    case EventHeaderValue::EventHeaderType::UUID:
+                        valueLength = 16;
+                        break;
+                    case EventHeaderValue::EventHeaderType::BYTE_BUF:
+                    case EventHeaderValue::EventHeaderType::STRING:
+                        if (headersEnd - value < 2)
+                        {
+                            ReportDecodingError(handler, EventStreamErrors::EVENT_STREAM_MESSAGE_INVALID_HEADERS_LEN, "A header runs past the end of the headers.");
+                            return;
+                        }
+                        valueLength = static_cast<size_t>(value[0]) << 8 | value[1];
+                        value += 2;
+                        break;
+                    default:
+                        ReportDecodingError(handler, EventStreamErrors::EVENT_STREAM_MESSAGE_UNKNOWN_HEADER_TYPE, "Encountered unknown type of header.");
+                        return;
+                    }
+                    if (static_cast<size_t>(headersEnd - value) < valueLength)
+                    {
+                        ReportDecodingError(handler, EventStreamErrors::EVENT_STREAM_MESSAGE_INVALID_HEADERS_LEN, "A header runs past the end of the headers.");
+                        return;
+                    }
+                    headerViews.emplace_back(reinterpret_cast<const char*>(header + 1), nameLength, type, value, valueLength);
+                    header = value + valueLength;
+                }
+
+                size_t payloadLength = totalLength - headersLength - PRELUDE_LENGTH - MESSAGE_CRC_LENGTH;
+                EventMessageView messageView(headerViews.data(), headerViews.size(), headersEnd, payloadLength, totalLength, headersLength);
+                if (handler->OnMessageView(messageView))
+                {
+                    return;
+                }
+
+                // the handler wants the message copied out, as in MESSAGES mode
+                handler->Reset();
+                handler->SetMessageMetadata(totalLength, headersLength, payloadLength);
+                for (const auto& headerView : headerViews)
+                {
+                    bool variableLength = headerView.GetType() == EventHeaderValue::EventHeaderType::BYTE_BUF ||
+                        headerView.GetType() == EventHeaderValue::EventHeaderType::STRING;
+                    handler->InsertMessageEventHeader(Aws::String(headerView.GetName(), headerView.GetNameLength()),
+                        1 + headerView.GetNameLength() + 1 + (variableLength ? 2 : 0) + headerView.GetValueLength(), headerView.ToEventHeaderValue());
+                }
+                handler->WriteMessageEventPayload(headersEnd, payloadLength);
+                assert(handler->IsMessageCompleted());
+                handler->OnEvent();
+                handler->Reset();
+            }
+
+            struct EventStreamDecoder::DispatchQueue
+            {
+                // a copy of a message, or an error found in the stream before it was queued, waiting for the handler
+                struct QueuedMessage
+                {
+                    Aws::Vector<unsigned char> bytes;
+                    uint32_t headersLength;
+                    EventStreamErrors error;
+                    const char* errorMessage;
+                };
+
+                DispatchQueue(const std::shared_ptr<Threading::Executor>& dispatchExecutor, size_t high, size_t low, EventStreamHandler* eventStreamHandler) :
+                    executor(dispatchExecutor), highWatermark(high), lowWatermark((std::min)(low, high)), handler(eventStreamHandler),
+                    queuedBytes(0), draining(false), full(false), corrupt(false), failed(false)
+                {}
+
+                std::shared_ptr<Threading::Executor> executor;
+                size_t highWatermark;
+                size_t lowWatermark;
+                EventStreamHandler* handler;
+                // only touched by the one task draining the queue
+                Aws::Vector<EventHeaderView> headerViews;
+
+                std::mutex lock;
+                std::condition_variable signal;
+                Aws::Queue<QueuedMessage> messages;
+                size_t queuedBytes;
+                // whether a task is draining the queue
+                bool draining;
+                // set at the high watermark and cleared at the low one, so the sender isn't paused and resumed for every message
+                bool full;
+                // set by the pumping thread once it finds the stream corrupt, and only used there; nothing after that is queued
+                bool corrupt;
+                // set once the handler fails; the messages queued after that are dropped
+                std::atomic<bool> failed;
+
+                /**
+                 * Queue a message, waiting while the queue is over its high watermark, and start a task draining the queue if none is.
+                 */
+                static void Enqueue(const std::shared_ptr<DispatchQueue>& queue, QueuedMessage&& message);
+                /**
+                 * Hand the queued messages to the handler one at a time, in order, until none are left.
+                 */
+                static void Drain(const std::shared_ptr<DispatchQueue>& queue);
+                static bool WaitUntilReadyForData(const std::shared_ptr<DispatchQueue>& queue, std::chrono::milliseconds timeout);
+                static void WaitUntilDrained(const std::shared_ptr<DispatchQueue>& queue);
+            };
+
+            void EventStreamDecoder::DispatchQueue::Enqueue(const std::shared_ptr<DispatchQueue>& queue, QueuedMessage&& message)
+            {
+                std::unique_lock<std::mutex> locker(queue->lock);
+                // with a response that is flow controlled this rarely waits; without, it is what keeps the queue bounded
+                queue->signal.wait(locker, [&queue]() { return queue->queuedBytes < queue->highWatermark || queue->failed; });
+                queue->queuedBytes += message.bytes.size();
+                queue->messages.push(std::move(message));
+                if (queue->queuedBytes >= queue->highWatermark)
+                {
+                    queue->full = true;
+                }
+                if (queue->draining)
+                {
+                    return;
+                }
+                queue->draining = true;
+                locker.unlock();
+
+                if (!queue->executor->Submit([queue]() { Drain(queue); }))
+                {
+                    AWS_LOGSTREAM_WARN(EVENT_STREAM_DECODER_CLASS_TAG, "Failed to submit event stream messages to the executor, handling them on this thread.");
+                    Drain(queue);
+                }
+            }
+
+            void EventStreamDecoder::DispatchQueue::Drain(const std::shared_ptr<DispatchQueue>& queue)
+            {
+                std::unique_lock<std::mutex> locker(queue->lock);
+                while (!queue->messages.empty())
+                {
+                    QueuedMessage message = std::move(queue->messages.front());
+                    queue->messages.pop();
+                    locker.unlock();
+
+                    bool failed = queue->failed;
+                    if (!failed)
+                    {
+                        if (message.errorMessage)
+                        {
+                            ReportDecodingError(queue->handler, message.error, message.errorMessage);
+                        }
+                        else
+                        {
+                            DecodeMessage(queue->handler, queue->headerViews, message.bytes.data(), static_cast<uint32_t>(message.bytes.size()), message.headersLength);
+                        }
+                        failed = !*queue->handler;
+                    }
+
+                    locker.lock();
+                    queue->queuedBytes -= message.bytes.size();
+                    if (queue->full && queue->queuedBytes <= queue->lowWatermark)
+                    {
+                        queue->full = false;
+                    }
+                    if (failed)
+                    {
+                        queue->failed = true;
+                    }
+                    queue->signal.notify_all();
+                }
+                queue->draining = false;
+                queue->signal.notify_all();
+            }
+
+            bool EventStreamDecoder::DispatchQueue::WaitUntilReadyForData(const std::shared_ptr<DispatchQueue>& queue, std::chrono::milliseconds timeout)
+            {
+                // data after a failure is dropped, so there is no need to hold it off
+                std::unique_lock<std::mutex> locker(queue->lock);
+                return queue->signal.wait_for(locker, timeout, [&queue]() { return !queue->full || queue->failed; });
+            }
+
+            void EventStreamDecoder::DispatchQueue::WaitUntilDrained(const std::shared_ptr<DispatchQueue>& queue)
+            {
+                std::unique_lock<std::mutex> locker(queue->lock);
+                queue->signal.wait(locker, [&queue]() { return queue->messages.empty() && !queue->draining; });
+            }
+
+            EventStreamDecoder::EventStreamDecoder(EventStreamHandler* handler, EventStreamDecodingMode mode) :
+                m_eventStreamHandler(handler), m_mode(mode), m_pendingMessageLength(0)
             {
                 aws_event_stream_streaming_decoder_init(&m_decoder, aws_default_allocator(),
                     onPayloadSegment,
@@ -40,9 +289,54 @@ namespace Aws
 
             EventStreamDecoder::~EventStreamDecoder()
             {
+                WaitForDispatchedMessages();
                 aws_event_stream_streaming_decoder_clean_up(&m_decoder);
             }
 
+            EventStreamDecoder::operator bool() const
+            {
+                if (m_dispatchQueue)
+                {
+                    return !m_dispatchQueue->corrupt && !m_dispatchQueue->failed;
+                }
+                return *m_eventStreamHandler;
+            }
+
+            void EventStreamDecoder::SetDispatchExecutor(const std::shared_ptr<Threading::Executor>& executor, size_t highWatermark, size_t lowWatermark)
+            {
+                WaitForDispatchedMessages();
+                m_mode = EventStreamDecodingMode::VIEWS;
+                m_dispatchQueue = executor ? Aws::MakeShared<DispatchQueue>(EVENT_STREAM_DECODER_CLASS_TAG, executor, highWatermark, lowWatermark, m_eventStreamHandler) : nullptr;
+            }
+
+            bool EventStreamDecoder::IsReadyForData() const
+            {
+                if (!m_dispatchQueue)
+                {
+                    return true;
+                }
+                std::lock_guard<std::mutex> locker(m_dispatchQueue->lock);
+                return !m_dispatchQueue->full || m_dispatchQueue->failed;
+            }
+
+            Aws::Http::ResponseFlowControlHandler EventStreamDecoder::GetResponseFlowControlHandler() const
+            {
+                if (!m_dispatchQueue)
+                {
+                    return Aws::Http::ResponseFlowControlHandler();
+                }
+                std::shared_ptr<DispatchQueue> queue = m_dispatchQueue;
+                return [queue](const Aws::Http::HttpRequest*, std::chrono::milliseconds timeout) { return DispatchQueue::WaitUntilReadyForData(queue, timeout); };
+            }
+
+            void EventStreamDecoder::WaitForDispatchedMessages()
+            {
+                if (m_dispatchQueue)
+                {
+                    DispatchQueue::WaitUntilDrained(m_dispatchQueue);
+                }
+            }
+
             void EventStreamDecoder::Pump(const ByteBuffer& data)
             {
                 Pump(data, data.GetLength());
@@ -50,17 +344,43 @@ namespace Aws
 
             void EventStreamDecoder::Pump(const ByteBuffer& data, size_t length)
             {
-                aws_byte_buf dataBuf = aws_byte_buf_from_array(static_cast<uint8_t*>(data.GetUnderlyingData()), length);
+                Pump(data.GetUnderlyingData(), length);
+            }
+
+            void EventStreamDecoder::Pump(const unsigned char* data, size_t length)
+            {
+                if (m_mode == EventStreamDecodingMode::VIEWS)
+                {
+                    PumpViews(data, length);
+                    return;
+                }
+                aws_byte_buf dataBuf = aws_byte_buf_from_array(const_cast<uint8_t*>(data), length);
                 aws_event_stream_streaming_decoder_pump(&m_decoder, &dataBuf);
             }
 
             void EventStreamDecoder::Reset()
             {
+                WaitForDispatchedMessages();
+                if (m_dispatchQueue)
+                {
+                    m_dispatchQueue->corrupt = false;
+                    m_dispatchQueue->failed = false;
+                }
+                m_pendingMessage.clear();
+                m_pendingMessageLength = 0;
                 m_eventStreamHandler->Reset();
             }
 
             void EventStreamDecoder::ResetEventStreamHandler(EventStreamHandler* handler)
             {
+                WaitForDispatchedMessages();
+                if (m_dispatchQueue)
+                {
+                    m_dispatchQueue->handler = handler;
+                }
+                m_eventStreamHandler = handler;
+                m_pendingMessage.clear();
+                m_pendingMessageLength = 0;
                 aws_event_stream_streaming_decoder_init(&m_decoder, aws_default_allocator(),
                     onPayloadSegment,
                     onPreludeReceived,
@@ -69,6 +389,122 @@ namespace Aws
                     reinterpret_cast<void *>(handler));
             }
 
+            void EventStreamDecoder::PumpViews(const unsigned char* data, size_t length)
+            {
+                while (length > 0 && *this)
+                {
+                    if (m_pendingMessage.empty())
+                    {
+                        // decode straight from the caller's buffer whatever messages it holds whole
+                        uint32_t totalLength = 0;
+                        uint32_t headersLength = 0;
+                        if (length >= PRELUDE_LENGTH)
+                        {
+                            if (!ReadPrelude(data, totalLength, headersLength))
+                            {
+                                return;
+                            }
+                            if (length >= totalLength)
+                            {
+                                OnMessage(data, totalLength, headersLength);
+                                data += totalLength;
+                                length -= totalLength;
+                                continue;
+                            }
+                        }
+                        m_pendingMessageLength = totalLength;
+                        m_pendingMessage.assign(data, data + length);
+                        return;
+                    }
+
+                    // gather the rest of the prelude, then the rest of the message
+                    size_t wanted = (m_pendingMessageLength ? m_pendingMessageLength : PRELUDE_LENGTH) - m_pendingMessage.size();
+                    size_t taken = (std::min)(wanted, length);
+                    m_pendingMessage.insert(m_pendingMessage.end(), data, data + taken);
+                    data += taken;
+                    length -= taken;
+                    if (taken < wanted)
+                    {
+                        return;
+                    }
+
+                    if (!m_pendingMessageLength)
+                    {
+                        uint32_t headersLength = 0;
+                        if (!ReadPrelude(m_pendingMessage.data(), m_pendingMessageLength, headersLength))
+                        {
+                            return;
+                        }
+                        continue;
+                    }
+
+                    uint32_t headersLength = ReadUInt32(m_pendingMessage.data() + 4);
+                    if (m_dispatchQueue)
+                    {
+                        // the gathered message is already a copy, so the queue can have it
+                        DispatchQueue::QueuedMessage message = { std::move(m_pendingMessage), headersLength, EventStreamErrors::EVENT_STREAM_NO_ERROR, nullptr };
+                        DispatchQueue::Enqueue(m_dispatchQueue, std::move(message));
+                    }
+                    else
+                    {
+                        DecodeMessage(m_eventStreamHandler, m_headerViews, m_pendingMessage.data(), m_pendingMessageLength, headersLength);
+                    }
+                    m_pendingMessage.clear();
+                    m_pendingMessageLength = 0;
+                }
+            }
+
+            bool EventStreamDecoder::ReadPrelude(const unsigned char* prelude, uint32_t& totalLength, uint32_t& headersLength)
+            {
+                totalLength = ReadUInt32(prelude);
+                headersLength = ReadUInt32(prelude + 4);
+                if (HashingUtils::CalculateCRC32(prelude, 8) != ReadUInt32(prelude + 8))
+                {
+                    OnDecodingError(EventStreamErrors::EVENT_STREAM_PRELUDE_CHECKSUM_FAILURE, "CRC Mismatch. The prelude checksum of the message is wrong.");
+                    return false;
+                }
+                if (totalLength > MAX_MESSAGE_LENGTH || headersLength > MAX_HEADERS_LENGTH)
+                {
+                    OnDecodingError(EventStreamErrors::EVENT_STREAM_MESSAGE_FIELD_SIZE_EXCEEDED, "The message or its headers are longer than allowed.");
+                    return false;
+                }
+                if (totalLength < headersLength + PRELUDE_LENGTH + MESSAGE_CRC_LENGTH)
+                {
+                    OnDecodingError(EventStreamErrors::EVENT_STREAM_MESSAGE_INVALID_HEADERS_LEN, "The headers of the message are longer than the message.");
+                    return false;
+                }
+                AWS_LOGSTREAM_TRACE(EVENT_STREAM_DECODER_CLASS_TAG, "Message received, the expected length of the message is: " << totalLength <<
+                                                                    " bytes, and the expected length of the header is: " << headersLength << " bytes");
+                return true;
+            }
+
+            void EventStreamDecoder::OnMessage(const unsigned char* message, uint32_t totalLength, uint32_t headersLength)
+            {
+                if (m_dispatchQueue)
+                {
+                    DispatchQueue::QueuedMessage queuedMessage = { Aws::Vector<unsigned char>(message, message + totalLength), headersLength,
+                        EventStreamErrors::EVENT_STREAM_NO_ERROR, nullptr };
+                    DispatchQueue::Enqueue(m_dispatchQueue, std::move(queuedMessage));
+                    return;
+                }
+                DecodeMessage(m_eventStreamHandler, m_headerViews, message, totalLength, headersLength);
+            }
+
+            void EventStreamDecoder::OnDecodingError(EventStreamErrors error, const char* message)
+            {
+                m_pendingMessage.clear();
+                m_pendingMessageLength = 0;
+                if (m_dispatchQueue)
+                {
+                    // reported after the messages ahead of it, in the order the handler would have seen them
+                    m_dispatchQueue->corrupt = true;
+                    DispatchQueue::QueuedMessage queuedMessage = { Aws::Vector<unsigned char>(), 0, error, message };
+                    DispatchQueue::Enqueue(m_dispatchQueue, std::move(queuedMessage));
+                    return;
+                }
+                ReportDecodingError(m_eventStreamHandler, error, message);
+            }
+
             void EventStreamDecoder::onPayloadSegment(
                 aws_event_stream_streaming_decoder* decoder,
                 aws_byte_buf* payload,
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/core/utils/threading/CancellationToken.h>
+#include <algorithm>
+#include <limits>
+
+using namespace Aws::Utils::Threading;
+
+static const std::chrono::steady_clock::rep NO_DEADLINE = (std::numeric_limits<std::chrono::steady_clock::rep>::max)();
+
+CancellationToken::CancellationToken() :
+    m_cancelled(false), m_deadline(NO_DEADLINE), m_nextCancelCallbackId(0)
+{
+}
+
+CancellationToken::CancellationToken(std::chrono::milliseconds timeout) :
+    m_cancelled(false), m_deadline((std::chrono::steady_clock::now() + timeout).time_since_epoch().count()), m_nextCancelCallbackId(0)
+{
+}
+
+void CancellationToken::Cancel()
+{
+    Aws::Map<size_t, std::function<void()>> callbacks;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_cancelled = true;
+        m_syncPoint.notify_all();
+        callbacks.swap(m_cancelCallbacks);
+    }
+
+    // called without the lock so that callbacks may take locks of their own that are also held around AddCancelCallback()
+    for (auto& callback : callbacks)
+    {
+        callback.second();
+    }
+}
+
+void CancellationToken::SetDeadline(std::chrono::steady_clock::time_point deadline)
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+    m_deadline = deadline.time_since_epoch().count();
+    // waiters recompute how long they may sleep
+    m_syncPoint.notify_all();
+}
+
+bool CancellationToken::IsCancelled() const
+{
+    if (m_cancelled.load(std::memory_order_relaxed))
+    {
+        return true;
+    }
+
+    auto deadline = m_deadline.load(std::memory_order_relaxed);
+    return deadline != NO_DEADLINE && std::chrono::steady_clock::now().time_since_epoch().count() >= deadline;
+}
+
+std::chrono::milliseconds CancellationToken::GetRemainingTime() const
+{
+    if (m_cancelled.load(std::memory_order_relaxed))
+    {
+        return std::chrono::milliseconds(0);
+    }
+
+    auto deadline = m_deadline.load(std::memory_order_relaxed);
+    if (deadline == NO_DEADLINE)
+    {
+        return (std::chrono::milliseconds::max)();
+    }
+
+    auto remaining = std::chrono::steady_clock::duration(deadline) - std::chrono::steady_clock::now().time_since_epoch();
+    return (std::max)(std::chrono::milliseconds(0), std::chrono::duration_cast<std::chrono::milliseconds>(remaining));
+}
+
+bool CancellationToken::WaitFor(std::chrono::milliseconds duration) const
+{
+    auto wakeUp = std::chrono::steady_clock::now() + duration;
+    std::unique_lock<std::mutex> locker(m_mutex);
+    while (!IsCancelled())
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= wakeUp)
+        {
+            return false;
+        }
+
+        auto remaining = GetRemainingTime();
+        auto sleep = std::chrono::duration_cast<std::chrono::milliseconds>(wakeUp - now);
+        // round up so we don't spin on sub-millisecond remainders
+        m_syncPoint.wait_for(locker, (std::min)(sleep, remaining) + std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+size_t CancellationToken::AddCancelCallback(std::function<void()>&& callback)
+{
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        if (!m_cancelled)
+        {
+            m_cancelCallbacks.emplace(m_nextCancelCallbackId, std::move(callback));
+            return m_nextCancelCallbackId++;
+        }
+    }
+
+    callback();
+    // nothing was registered, so there is nothing to remove
+    return (std::numeric_limits<size_t>::max)();
+}
+
+void CancellationToken::RemoveCancelCallback(size_t callbackId)
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+    m_cancelCallbacks.erase(callbackId);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <aws/core/utils/threading/TimerQueue.h>
+
+using namespace Aws::Utils::Threading;
+
+TimerQueue::TimerQueue() : m_running(false)
+{
+}
+
+TimerQueue::~TimerQueue()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_running = false;
+        m_tasks.clear();
+    }
+    m_signal.notify_one();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void TimerQueue::Schedule(std::chrono::milliseconds delay, std::function<void()>&& task)
+{
+    std::lock_guard<std::mutex> locker(m_lock);
+    bool earliest = m_tasks.empty() || std::chrono::steady_clock::now() + delay < m_tasks.begin()->first;
+    m_tasks.emplace(std::chrono::steady_clock::now() + delay, std::move(task));
+
+    if (!m_thread.joinable())
+    {
+        m_running = true;
+        m_thread = std::thread(&TimerQueue::Run, this);
+    }
+    else if (earliest)
+    {
+        m_signal.notify_one();
+    }
+}
+
+void TimerQueue::Run()
+{
+    std::unique_lock<std::mutex> locker(m_lock);
+    while (m_running)
+    {
+        if (m_tasks.empty())
+        {
+            m_signal.wait(locker);
+            continue;
+        }
+
+        auto next = m_tasks.begin();
+        if (next->first > std::chrono::steady_clock::now())
+        {
+            m_signal.wait_until(locker, next->first);
+            continue;
+        }
+
+        std::function<void()> task = std::move(next->second);
+        m_tasks.erase(next);
+
+        locker.unlock();
+        task();
+        locker.lock();
+    }
+}
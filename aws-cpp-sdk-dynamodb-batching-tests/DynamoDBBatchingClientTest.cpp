@@ -0,0 +1,584 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/external/gtest.h>
+#include <aws/dynamodb-batching/DynamoDBBatchingClient.h>
+#include <aws/dynamodb/model/DescribeTableRequest.h>
+#include <aws/dynamodb/model/DescribeTableResult.h>
+#include <aws/dynamodb/model/KeySchemaElement.h>
+#include <aws/dynamodb/model/WriteRequest.h>
+#include <aws/core/auth/AWSCredentialsProvider.h>
+#include <aws/core/utils/Outcome.h>
+#include <aws/core/utils/StringUtils.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace Aws::DynamoDBBatching;
+using namespace Aws::DynamoDB;
+using namespace Aws::DynamoDB::Model;
+
+static const char* ALLOC_TAG = "DynamoDBBatchingClientTest";
+static const char* TABLE_NAME = "BatchingTestTable";
+static const char* KEY_NAME = "id";
+static const char* VALUE_NAME = "value";
+
+typedef Aws::Map<Aws::String, AttributeValue> AttributeMap;
+
+static AttributeMap BuildKey(const Aws::String& id)
+{
+    AttributeMap key;
+    key[KEY_NAME] = AttributeValue(id);
+    return key;
+}
+
+static AttributeMap BuildItem(const Aws::String& id, const Aws::String& value)
+{
+    AttributeMap item = BuildKey(id);
+    item[VALUE_NAME] = AttributeValue(value);
+    return item;
+}
+
+static GetItemRequest BuildGetItemRequest(const Aws::String& id)
+{
+    GetItemRequest request;
+    request.SetTableName(TABLE_NAME);
+    request.SetKey(BuildKey(id));
+    return request;
+}
+
+static PutItemRequest BuildPutItemRequest(const Aws::String& id, const Aws::String& value)
+{
+    PutItemRequest request;
+    request.SetTableName(TABLE_NAME);
+    request.SetItem(BuildItem(id, value));
+    return request;
+}
+
+/**
+ * In-memory table with a single string hash key. Batch calls can be made to leave items unprocessed or to fail validation.
+ */
+class MockDynamoDBClient : public DynamoDBClient
+{
+public:
+    MockDynamoDBClient() : DynamoDBClient(Aws::Auth::AWSCredentials("", "")),
+        m_unprocessedRounds(0), m_describeTableFailures(0), m_failBatchValidation(false), m_batchGetCalls(0), m_batchWriteCalls(0), m_getItemCalls(0), m_putItemCalls(0), m_describeTableCalls(0)
+    {
+    }
+
+    void AddItem(const AttributeMap& item)
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_items[item.find(KEY_NAME)->second.GetS()] = item;
+    }
+
+    AttributeMap FindItem(const Aws::String& id)
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        auto item = m_items.find(id);
+        return item == m_items.end() ? AttributeMap() : item->second;
+    }
+
+    /**
+     * For the next rounds batch calls, only the first key or item of the batch is processed.
+     */
+    void LeaveUnprocessed(int rounds) { m_unprocessedRounds = rounds; }
+    void FailDescribeTable(int times) { m_describeTableFailures = times; }
+    void FailBatchValidation() { m_failBatchValidation = true; }
+
+    BatchGetItemOutcome BatchGetItem(const BatchGetItemRequest& request) const override
+    {
+        ++m_batchGetCalls;
+        if (m_failBatchValidation)
+        {
+            return BatchGetItemOutcome(Aws::Client::AWSError<DynamoDBErrors>(DynamoDBErrors::VALIDATION, "ValidationException", "Bad batch", false));
+        }
+
+        std::lock_guard<std::mutex> locker(m_lock);
+        const KeysAndAttributes& keys = request.GetRequestItems().find(TABLE_NAME)->second;
+        m_batchGetKeyCounts.push_back(keys.GetKeys().size());
+        m_capturedKeysAndAttributes = keys;
+
+        bool leaveUnprocessed = m_unprocessedRounds > 0;
+        if (leaveUnprocessed)
+        {
+            --m_unprocessedRounds;
+        }
+
+        BatchGetItemResult result;
+        Aws::Vector<AttributeMap> responses;
+        KeysAndAttributes unprocessed;
+        for (const auto& key : keys.GetKeys())
+        {
+            if (leaveUnprocessed && &key != &keys.GetKeys().front())
+            {
+                unprocessed.AddKeys(key);
+                continue;
+            }
+
+            auto item = m_items.find(key.find(KEY_NAME)->second.GetS());
+            if (item != m_items.end())
+            {
+                responses.push_back(Project(item->second, keys));
+            }
+        }
+        result.AddResponses(TABLE_NAME, responses);
+        if (!unprocessed.GetKeys().empty())
+        {
+            result.AddUnprocessedKeys(TABLE_NAME, unprocessed);
+        }
+        return result;
+    }
+
+    BatchWriteItemOutcome BatchWriteItem(const BatchWriteItemRequest& request) const override
+    {
+        ++m_batchWriteCalls;
+        if (m_failBatchValidation)
+        {
+            return BatchWriteItemOutcome(Aws::Client::AWSError<DynamoDBErrors>(DynamoDBErrors::VALIDATION, "ValidationException", "Bad batch", false));
+        }
+
+        std::lock_guard<std::mutex> locker(m_lock);
+        const Aws::Vector<WriteRequest>& writes = request.GetRequestItems().find(TABLE_NAME)->second;
+        m_batchWriteItemCounts.push_back(writes.size());
+
+        bool leaveUnprocessed = m_unprocessedRounds > 0;
+        if (leaveUnprocessed)
+        {
+            --m_unprocessedRounds;
+        }
+
+        BatchWriteItemResult result;
+        Aws::Vector<WriteRequest> unprocessed;
+        for (const auto& write : writes)
+        {
+            if (leaveUnprocessed && &write != &writes.front())
+            {
+                unprocessed.push_back(write);
+                continue;
+            }
+
+            const AttributeMap& item = write.GetPutRequest().GetItem();
+            m_items[item.find(KEY_NAME)->second.GetS()] = item;
+        }
+        if (!unprocessed.empty())
+        {
+            result.AddUnprocessedItems(TABLE_NAME, unprocessed);
+        }
+        return result;
+    }
+
+    GetItemOutcome GetItem(const GetItemRequest& request) const override
+    {
+        ++m_getItemCalls;
+        std::lock_guard<std::mutex> locker(m_lock);
+        GetItemResult result;
+        auto item = m_items.find(request.GetKey().find(KEY_NAME)->second.GetS());
+        if (item != m_items.end())
+        {
+            result.SetItem(item->second);
+        }
+        return result;
+    }
+
+    PutItemOutcome PutItem(const PutItemRequest& request) const override
+    {
+        ++m_putItemCalls;
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_items[request.GetItem().find(KEY_NAME)->second.GetS()] = request.GetItem();
+        return PutItemResult();
+    }
+
+    DescribeTableOutcome DescribeTable(const DescribeTableRequest& request) const override
+    {
+        ++m_describeTableCalls;
+        if (m_describeTableFailures > 0)
+        {
+            --m_describeTableFailures;
+            return DescribeTableOutcome(Aws::Client::AWSError<DynamoDBErrors>(DynamoDBErrors::THROTTLING, "ThrottlingException", "Slow down", true));
+        }
+
+        DescribeTableResult result;
+        result.SetTable(TableDescription().WithTableName(request.GetTableName())
+            .AddKeySchema(KeySchemaElement().WithAttributeName(KEY_NAME).WithKeyType(KeyType::HASH)));
+        return result;
+    }
+
+    Aws::Vector<size_t> GetBatchGetKeyCounts() const { std::lock_guard<std::mutex> locker(m_lock); return m_batchGetKeyCounts; }
+    Aws::Vector<size_t> GetBatchWriteItemCounts() const { std::lock_guard<std::mutex> locker(m_lock); return m_batchWriteItemCounts; }
+    KeysAndAttributes GetCapturedKeysAndAttributes() const { std::lock_guard<std::mutex> locker(m_lock); return m_capturedKeysAndAttributes; }
+
+    mutable std::atomic<int> m_unprocessedRounds;
+    mutable std::atomic<int> m_describeTableFailures;
+    std::atomic<bool> m_failBatchValidation;
+    mutable std::atomic<int> m_batchGetCalls;
+    mutable std::atomic<int> m_batchWriteCalls;
+    mutable std::atomic<int> m_getItemCalls;
+    mutable std::atomic<int> m_putItemCalls;
+    mutable std::atomic<int> m_describeTableCalls;
+
+private:
+    /**
+     * Applies a projection expression made of top level names and expression attribute names.
+     */
+    static AttributeMap Project(const AttributeMap& item, const KeysAndAttributes& keys)
+    {
+        if (!keys.ProjectionExpressionHasBeenSet())
+        {
+            return item;
+        }
+
+        AttributeMap projected;
+        for (const auto& path : Aws::Utils::StringUtils::Split(keys.GetProjectionExpression(), ','))
+        {
+            Aws::String name = Aws::Utils::StringUtils::Trim(path.c_str());
+            auto alias = keys.GetExpressionAttributeNames().find(name);
+            if (alias != keys.GetExpressionAttributeNames().end())
+            {
+                name = alias->second;
+            }
+            auto attribute = item.find(name);
+            if (attribute != item.end())
+            {
+                projected[name] = attribute->second;
+            }
+        }
+        return projected;
+    }
+
+    mutable std::mutex m_lock;
+    mutable Aws::Map<Aws::String, AttributeMap> m_items;
+    mutable Aws::Vector<size_t> m_batchGetKeyCounts;
+    mutable Aws::Vector<size_t> m_batchWriteItemCounts;
+    mutable KeysAndAttributes m_capturedKeysAndAttributes;
+};
+
+class DynamoDBBatchingClientTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_mockClient = Aws::MakeShared<MockDynamoDBClient>(ALLOC_TAG);
+        m_config.dynamoDBClient = m_mockClient;
+        // long enough that batches in these tests are only sent when full or flushed, unless a test shortens it
+        m_config.maxBatchDelay = std::chrono::seconds(10);
+        m_config.unprocessedRetryBaseDelayMs = 1;
+    }
+
+    std::shared_ptr<MockDynamoDBClient> m_mockClient;
+    DynamoDBBatchingConfiguration m_config;
+};
+
+TEST_F(DynamoDBBatchingClientTest, TestFullBatchOfGetsIsSentAsOneCall)
+{
+    m_config.maxGetBatchSize = 10;
+    for (int i = 0; i < 5; ++i)
+    {
+        m_mockClient->AddItem(BuildItem("key" + Aws::Utils::StringUtils::to_string(i), "value" + Aws::Utils::StringUtils::to_string(i)));
+    }
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    Aws::Vector<GetItemOutcomeCallable> futures;
+    for (int i = 0; i < 10; ++i)
+    {
+        futures.push_back(batchingClient.GetItemCallable(BuildGetItemRequest("key" + Aws::Utils::StringUtils::to_string(i))));
+    }
+
+    for (int i = 0; i < 10; ++i)
+    {
+        auto outcome = futures[i].get();
+        ASSERT_TRUE(outcome.IsSuccess());
+        if (i < 5)
+        {
+            ASSERT_EQ("value" + Aws::Utils::StringUtils::to_string(i), outcome.GetResult().GetItem().find(VALUE_NAME)->second.GetS());
+        }
+        else
+        {
+            ASSERT_TRUE(outcome.GetResult().GetItem().empty());
+        }
+    }
+
+    ASSERT_EQ(1, m_mockClient->m_batchGetCalls.load());
+    auto keyCounts = m_mockClient->GetBatchGetKeyCounts();
+    ASSERT_EQ(10u, keyCounts[0]);
+    ASSERT_EQ(0, m_mockClient->m_getItemCalls.load());
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestPartialBatchIsSentAfterDelay)
+{
+    m_config.maxBatchDelay = std::chrono::milliseconds(20);
+    m_mockClient->AddItem(BuildItem("key", "value"));
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    auto first = batchingClient.GetItemCallable(BuildGetItemRequest("key"));
+    auto second = batchingClient.GetItemCallable(BuildGetItemRequest("missing"));
+
+    ASSERT_EQ("value", first.get().GetResult().GetItem().find(VALUE_NAME)->second.GetS());
+    ASSERT_TRUE(second.get().GetResult().GetItem().empty());
+    ASSERT_EQ(1, m_mockClient->m_batchGetCalls.load());
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestDuplicateKeysShareOneRead)
+{
+    m_mockClient->AddItem(BuildItem("key", "value"));
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    Aws::Vector<GetItemOutcomeCallable> futures;
+    for (int i = 0; i < 3; ++i)
+    {
+        futures.push_back(batchingClient.GetItemCallable(BuildGetItemRequest("key")));
+    }
+    batchingClient.Flush();
+
+    for (auto& future : futures)
+    {
+        ASSERT_EQ("value", future.get().GetResult().GetItem().find(VALUE_NAME)->second.GetS());
+    }
+    auto keyCounts = m_mockClient->GetBatchGetKeyCounts();
+    ASSERT_EQ(1u, keyCounts[0]);
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestGetsWithDifferentOptionsAreNotMixed)
+{
+    m_mockClient->AddItem(BuildItem("key", "value"));
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    auto eventual = batchingClient.GetItemCallable(BuildGetItemRequest("key"));
+    auto consistent = batchingClient.GetItemCallable(BuildGetItemRequest("key").WithConsistentRead(true));
+    batchingClient.Flush();
+
+    ASSERT_TRUE(eventual.get().IsSuccess());
+    ASSERT_TRUE(consistent.get().IsSuccess());
+    ASSERT_EQ(2, m_mockClient->m_batchGetCalls.load());
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestProjectionIsExtendedWithKeyAndStripped)
+{
+    m_mockClient->AddItem(BuildItem("key", "value"));
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    auto future = batchingClient.GetItemCallable(BuildGetItemRequest("key").WithProjectionExpression(VALUE_NAME));
+    batchingClient.Flush();
+
+    auto outcome = future.get();
+    ASSERT_TRUE(outcome.IsSuccess());
+    ASSERT_EQ(1u, outcome.GetResult().GetItem().size());
+    ASSERT_EQ("value", outcome.GetResult().GetItem().find(VALUE_NAME)->second.GetS());
+
+    auto keysAndAttributes = m_mockClient->GetCapturedKeysAndAttributes();
+    ASSERT_NE(Aws::String::npos, keysAndAttributes.GetProjectionExpression().find("#batchKey0"));
+    ASSERT_EQ(KEY_NAME, keysAndAttributes.GetExpressionAttributeNames().find("#batchKey0")->second);
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestUnprocessedKeysAreRetried)
+{
+    m_config.maxGetBatchSize = 4;
+    for (int i = 0; i < 4; ++i)
+    {
+        m_mockClient->AddItem(BuildItem("key" + Aws::Utils::StringUtils::to_string(i), "value"));
+    }
+    m_mockClient->LeaveUnprocessed(2);
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    Aws::Vector<GetItemOutcomeCallable> futures;
+    for (int i = 0; i < 4; ++i)
+    {
+        futures.push_back(batchingClient.GetItemCallable(BuildGetItemRequest("key" + Aws::Utils::StringUtils::to_string(i))));
+    }
+
+    for (auto& future : futures)
+    {
+        auto outcome = future.get();
+        ASSERT_TRUE(outcome.IsSuccess());
+        ASSERT_EQ("value", outcome.GetResult().GetItem().find(VALUE_NAME)->second.GetS());
+    }
+
+    auto keyCounts = m_mockClient->GetBatchGetKeyCounts();
+    ASSERT_EQ(3u, keyCounts.size());
+    ASSERT_EQ(4u, keyCounts[0]);
+    ASSERT_EQ(3u, keyCounts[1]);
+    ASSERT_EQ(2u, keyCounts[2]);
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestUnprocessedKeysFailAfterMaxRetries)
+{
+    m_config.maxUnprocessedRetries = 1;
+    m_mockClient->LeaveUnprocessed(100);
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    auto first = batchingClient.GetItemCallable(BuildGetItemRequest("key0"));
+    auto second = batchingClient.GetItemCallable(BuildGetItemRequest("key1"));
+    auto third = batchingClient.GetItemCallable(BuildGetItemRequest("key2"));
+    batchingClient.Flush();
+
+    ASSERT_TRUE(first.get().IsSuccess());
+    ASSERT_TRUE(second.get().IsSuccess());
+    auto outcome = third.get();
+    ASSERT_FALSE(outcome.IsSuccess());
+    ASSERT_EQ(DynamoDBErrors::PROVISIONED_THROUGHPUT_EXCEEDED, outcome.GetError().GetErrorType());
+    ASSERT_EQ(2, m_mockClient->m_batchGetCalls.load());
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestValidationFailureFallsBackToSingleGets)
+{
+    m_mockClient->AddItem(BuildItem("key", "value"));
+    m_mockClient->FailBatchValidation();
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    auto first = batchingClient.GetItemCallable(BuildGetItemRequest("key"));
+    auto second = batchingClient.GetItemCallable(BuildGetItemRequest("missing"));
+    batchingClient.Flush();
+
+    ASSERT_EQ("value", first.get().GetResult().GetItem().find(VALUE_NAME)->second.GetS());
+    ASSERT_TRUE(second.get().GetResult().GetItem().empty());
+    ASSERT_EQ(1, m_mockClient->m_batchGetCalls.load());
+    ASSERT_EQ(2, m_mockClient->m_getItemCalls.load());
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestFullBatchOfPutsIsSentAsOneCall)
+{
+    DynamoDBBatchingClient batchingClient(m_config);
+    Aws::Vector<PutItemOutcomeCallable> futures;
+    for (int i = 0; i < 25; ++i)
+    {
+        futures.push_back(batchingClient.PutItemCallable(BuildPutItemRequest("key" + Aws::Utils::StringUtils::to_string(i), "value")));
+    }
+
+    for (auto& future : futures)
+    {
+        ASSERT_TRUE(future.get().IsSuccess());
+    }
+
+    ASSERT_EQ(1, m_mockClient->m_describeTableCalls.load());
+    ASSERT_EQ(1, m_mockClient->m_batchWriteCalls.load());
+    auto itemCounts = m_mockClient->GetBatchWriteItemCounts();
+    ASSERT_EQ(25u, itemCounts[0]);
+    ASSERT_EQ("value", m_mockClient->FindItem("key24").find(VALUE_NAME)->second.GetS());
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestDuplicatePutKeySendsOpenBatchFirst)
+{
+    DynamoDBBatchingClient batchingClient(m_config);
+    auto first = batchingClient.PutItemCallable(BuildPutItemRequest("key", "first"));
+    auto other = batchingClient.PutItemCallable(BuildPutItemRequest("other", "value"));
+    auto second = batchingClient.PutItemCallable(BuildPutItemRequest("key", "second"));
+    batchingClient.Flush();
+
+    ASSERT_TRUE(first.get().IsSuccess());
+    ASSERT_TRUE(other.get().IsSuccess());
+    ASSERT_TRUE(second.get().IsSuccess());
+
+    auto itemCounts = m_mockClient->GetBatchWriteItemCounts();
+    ASSERT_EQ(2u, itemCounts.size());
+    ASSERT_EQ(3u, itemCounts[0] + itemCounts[1]);
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestSamePutKeyKeepsOrderAcrossRetries)
+{
+    m_config.maxBatchDelay = std::chrono::milliseconds(20);
+    m_config.unprocessedRetryBaseDelayMs = 50;
+    // "a" sorts first in the batch, so it's processed and "key" is left for the retry
+    m_mockClient->LeaveUnprocessed(1);
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    auto other = batchingClient.PutItemCallable(BuildPutItemRequest("a", "value"));
+    auto first = batchingClient.PutItemCallable(BuildPutItemRequest("key", "first"));
+    batchingClient.Flush();
+    auto second = batchingClient.PutItemCallable(BuildPutItemRequest("key", "second"));
+
+    ASSERT_TRUE(other.get().IsSuccess());
+    ASSERT_TRUE(first.get().IsSuccess());
+    ASSERT_TRUE(second.get().IsSuccess());
+    ASSERT_EQ("second", m_mockClient->FindItem("key").find(VALUE_NAME)->second.GetS());
+
+    auto itemCounts = m_mockClient->GetBatchWriteItemCounts();
+    ASSERT_EQ(3u, itemCounts.size());
+    ASSERT_EQ(1u, itemCounts[1]);
+    ASSERT_EQ(1u, itemCounts[2]);
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestUnprocessedItemsAreRetried)
+{
+    m_config.maxWriteBatchSize = 3;
+    m_mockClient->LeaveUnprocessed(1);
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    Aws::Vector<PutItemOutcomeCallable> futures;
+    for (int i = 0; i < 3; ++i)
+    {
+        futures.push_back(batchingClient.PutItemCallable(BuildPutItemRequest("key" + Aws::Utils::StringUtils::to_string(i), "value")));
+    }
+
+    for (auto& future : futures)
+    {
+        ASSERT_TRUE(future.get().IsSuccess());
+    }
+
+    auto itemCounts = m_mockClient->GetBatchWriteItemCounts();
+    ASSERT_EQ(2u, itemCounts.size());
+    ASSERT_EQ(2u, itemCounts[1]);
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_FALSE(m_mockClient->FindItem("key" + Aws::Utils::StringUtils::to_string(i)).empty());
+    }
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestConditionalPutIsSentDirectly)
+{
+    DynamoDBBatchingClient batchingClient(m_config);
+    auto future = batchingClient.PutItemCallable(BuildPutItemRequest("key", "value").WithConditionExpression("attribute_not_exists(id)"));
+
+    ASSERT_TRUE(future.get().IsSuccess());
+    ASSERT_EQ(1, m_mockClient->m_putItemCalls.load());
+    ASSERT_EQ(0, m_mockClient->m_batchWriteCalls.load());
+    ASSERT_EQ(0, m_mockClient->m_describeTableCalls.load());
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestFailedKeySchemaLookupIsRetried)
+{
+    m_config.unprocessedRetryBaseDelayMs = 10;
+    m_mockClient->FailDescribeTable(1);
+
+    DynamoDBBatchingClient batchingClient(m_config);
+    ASSERT_TRUE(batchingClient.PutItemCallable(BuildPutItemRequest("key0", "value")).get().IsSuccess());
+    ASSERT_EQ(1, m_mockClient->m_putItemCalls.load());
+
+    // within the backoff the table isn't described again
+    ASSERT_TRUE(batchingClient.PutItemCallable(BuildPutItemRequest("key1", "value")).get().IsSuccess());
+    ASSERT_EQ(1, m_mockClient->m_describeTableCalls.load());
+    ASSERT_EQ(2, m_mockClient->m_putItemCalls.load());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto future = batchingClient.PutItemCallable(BuildPutItemRequest("key2", "value"));
+    batchingClient.Flush();
+    ASSERT_TRUE(future.get().IsSuccess());
+    ASSERT_EQ(2, m_mockClient->m_describeTableCalls.load());
+    ASSERT_EQ(2, m_mockClient->m_putItemCalls.load());
+    ASSERT_EQ(1, m_mockClient->m_batchWriteCalls.load());
+}
+
+TEST_F(DynamoDBBatchingClientTest, TestDestructorSendsOpenBatches)
+{
+    PutItemOutcomeCallable future;
+    {
+        DynamoDBBatchingClient batchingClient(m_config);
+        future = batchingClient.PutItemCallable(BuildPutItemRequest("key", "value"));
+    }
+
+    ASSERT_TRUE(future.get().IsSuccess());
+    ASSERT_EQ(1, m_mockClient->m_batchWriteCalls.load());
+}
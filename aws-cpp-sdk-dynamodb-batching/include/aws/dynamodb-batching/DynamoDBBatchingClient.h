@@ -0,0 +1,212 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#pragma once
+
+#include <aws/dynamodb-batching/DynamoDBBatching_EXPORTS.h>
+#include <aws/dynamodb/DynamoDBClient.h>
+#include <aws/core/utils/Outcome.h>
+#include <aws/dynamodb/model/GetItemRequest.h>
+#include <aws/dynamodb/model/PutItemRequest.h>
+#include <aws/dynamodb/model/BatchGetItemRequest.h>
+#include <aws/dynamodb/model/BatchWriteItemRequest.h>
+#include <aws/core/utils/memory/stl/AWSDeque.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSString.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Aws
+{
+    namespace DynamoDBBatching
+    {
+        /**
+         * Configuration for use with DynamoDBBatchingClient. The data here will be copied directly to the client.
+         */
+        struct DynamoDBBatchingConfiguration
+        {
+            DynamoDBBatchingConfiguration() : maxGetBatchSize(100), maxWriteBatchSize(25), maxBatchDelay(std::chrono::microseconds(2000)),
+                unprocessedRetryBaseDelayMs(25), maxUnprocessedRetries(8)
+            {
+            }
+
+            /**
+             * DynamoDB client used for the batch calls. You are responsible for setting this.
+             * Batches are sent with the client's async operations, so they run on the executor of the client's configuration.
+             */
+            std::shared_ptr<Aws::DynamoDB::DynamoDBClient> dynamoDBClient;
+            /**
+             * Maximum number of distinct keys sent in one BatchGetItem call. Defaults to 100, which is also the service limit.
+             */
+            size_t maxGetBatchSize;
+            /**
+             * Maximum number of items sent in one BatchWriteItem call. Defaults to 25, which is also the service limit.
+             */
+            size_t maxWriteBatchSize;
+            /**
+             * How long the first call of a batch waits for more calls to join it before the batch is sent anyway. Defaults to 2ms.
+             */
+            std::chrono::microseconds maxBatchDelay;
+            /**
+             * Delay before unprocessed keys or items of a batch are sent again. It doubles with each attempt. Defaults to 25ms.
+             */
+            long unprocessedRetryBaseDelayMs;
+            /**
+             * Number of times unprocessed keys or items are sent again before their callers receive a PROVISIONED_THROUGHPUT_EXCEEDED error. Defaults to 8.
+             */
+            unsigned maxUnprocessedRetries;
+        };
+
+        /**
+         * Collects single-item GetItem and PutItem calls made from any number of threads and sends them as BatchGetItem and BatchWriteItem calls.
+         * A batch is sent once it holds the configured maximum number of items or once maxBatchDelay has passed since its first call, whichever comes first.
+         * Each caller receives its own GetItem or PutItem outcome through the returned future; unprocessed keys and items are sent again with exponential backoff.
+         *
+         * Gets are only batched with gets for the same table using the same read options (consistent read and projection), and a key requested by several
+         * callers while a batch is open is only read once. Calls that cannot be expressed in a batch (conditional puts, puts with ReturnValues, calls asking for
+         * consumed capacity or item collection metrics) are sent directly. Batching puts needs the key schema of the table, which is looked up once per table
+         * with DescribeTable; while the lookup fails, puts for the table are sent directly and the lookup is tried again with exponential backoff.
+         * Puts for the same key are written in the order they were made, even when one of them has to be retried.
+         *
+         * None of the public methods block on the network, except for puts to a table whose key schema is being looked up. The destructor sends any open
+         * batches and waits for all of them to complete.
+         */
+        class AWS_DYNAMODB_BATCHING_API DynamoDBBatchingClient
+        {
+        public:
+            DynamoDBBatchingClient(const DynamoDBBatchingConfiguration& config);
+
+            ~DynamoDBBatchingClient();
+
+            DynamoDBBatchingClient(const DynamoDBBatchingClient&) = delete;
+            DynamoDBBatchingClient& operator=(const DynamoDBBatchingClient&) = delete;
+
+            /**
+             * Queues the get in a batch for its table. The future receives the item exactly as GetItem would return it, or an empty item if there is none.
+             */
+            Aws::DynamoDB::Model::GetItemOutcomeCallable GetItemCallable(const Aws::DynamoDB::Model::GetItemRequest& request);
+
+            /**
+             * Queues the put in a batch for its table. If a put for the same key is already waiting in the open batch, that batch is sent first.
+             * A put for a key whose earlier put hasn't completed yet is held back until it has, so that it can't be overwritten by a retry of the earlier one.
+             */
+            Aws::DynamoDB::Model::PutItemOutcomeCallable PutItemCallable(const Aws::DynamoDB::Model::PutItemRequest& request);
+
+            /**
+             * Sends all open batches now instead of waiting for them to fill up or for maxBatchDelay to pass. Does not wait for the results.
+             */
+            void Flush();
+
+            inline const DynamoDBBatchingConfiguration& GetConfig() const { return m_config; }
+
+        private:
+            typedef std::shared_ptr<std::promise<Aws::DynamoDB::Model::GetItemOutcome>> GetItemPromise;
+            typedef std::shared_ptr<std::promise<Aws::DynamoDB::Model::PutItemOutcome>> PutItemPromise;
+
+            /// One distinct key of a get batch, along with everyone waiting for it
+            struct GetEntry
+            {
+                Aws::DynamoDB::Model::GetItemRequest request;
+                Aws::Vector<GetItemPromise> promises;
+            };
+
+            struct GetBatch
+            {
+                Aws::String groupKey;
+                Aws::DynamoDB::Model::GetItemRequest options;
+                Aws::Vector<Aws::String> keyAttributes;
+                /// Key attributes added to the caller's projection so that returned items can be matched to keys; removed again before the items are handed out
+                Aws::Vector<Aws::String> addedAttributes;
+                Aws::Map<Aws::String, GetEntry> entries;
+                std::chrono::steady_clock::time_point sendBy;
+                unsigned attempt = 0;
+            };
+
+            struct PutEntry
+            {
+                Aws::DynamoDB::Model::PutItemRequest request;
+                PutItemPromise promise;
+            };
+
+            struct PutBatch
+            {
+                Aws::String tableName;
+                Aws::Vector<Aws::String> keyAttributes;
+                Aws::Map<Aws::String, PutEntry> entries;
+                std::chrono::steady_clock::time_point sendBy;
+                unsigned attempt = 0;
+            };
+
+            /// Key schema lookup state for a table; until it is resolved, puts for the table are sent directly
+            struct TableKeySchema
+            {
+                bool resolved = false;
+                /// A DescribeTable call for the table is in flight; other callers wait for it rather than sending their own
+                bool describing = false;
+                unsigned failures = 0;
+                std::chrono::steady_clock::time_point retryAfter;
+                Aws::Vector<Aws::String> keyAttributes;
+            };
+
+            Aws::Vector<Aws::String> GetKeyAttributes(const Aws::String& tableName);
+
+            void SendGetBatch(const std::shared_ptr<GetBatch>& batch);
+            void SendPutBatch(const std::shared_ptr<PutBatch>& batch);
+            void OnBatchGetItemOutcome(const std::shared_ptr<GetBatch>& batch, const Aws::DynamoDB::Model::BatchGetItemOutcome& outcome);
+            void OnBatchWriteItemOutcome(const std::shared_ptr<PutBatch>& batch, const Aws::DynamoDB::Model::BatchWriteItemOutcome& outcome);
+
+            void SendGetsIndividually(const std::shared_ptr<GetBatch>& batch);
+            void SendPutsIndividually(const std::shared_ptr<PutBatch>& batch);
+            void ScheduleRetry(const std::shared_ptr<GetBatch>& batch);
+            void ScheduleRetry(const std::shared_ptr<PutBatch>& batch);
+            std::chrono::steady_clock::time_point GetRetryTime(unsigned attempt) const;
+
+            std::shared_ptr<PutBatch> AddToOpenPutBatch(const Aws::String& tableName, const Aws::Vector<Aws::String>& keyAttributes, const Aws::String& itemKey,
+                                                        PutEntry&& entry);
+            void FinishPuts(const Aws::String& tableName, const Aws::Vector<Aws::String>& keyAttributes, const Aws::Vector<Aws::String>& itemKeys);
+            void BatchFinished();
+            void FlushLoop();
+
+            DynamoDBBatchingConfiguration m_config;
+            std::shared_ptr<Aws::DynamoDB::DynamoDBClient> m_client;
+
+            std::mutex m_batchLock;
+            std::condition_variable m_batchSignal;
+            /// Open batches, keyed by table and read options for gets and by table for puts
+            Aws::Map<Aws::String, std::shared_ptr<GetBatch>> m_openGets;
+            Aws::Map<Aws::String, std::shared_ptr<PutBatch>> m_openPuts;
+            /// Batches waiting to send their unprocessed keys or items again
+            Aws::Vector<std::shared_ptr<GetBatch>> m_getRetries;
+            Aws::Vector<std::shared_ptr<PutBatch>> m_putRetries;
+            /// Keys, by table, with a put in an open or sent batch, along with the later puts for the same key that wait for it to complete
+            Aws::Map<Aws::String, Aws::Deque<PutEntry>> m_pendingPuts;
+            /// Batches that have been sent or are waiting to be retried
+            size_t m_outstandingBatches;
+            bool m_shutdown;
+
+            std::mutex m_keySchemaLock;
+            std::condition_variable m_keySchemaSignal;
+            Aws::Map<Aws::String, TableKeySchema> m_keySchemas;
+
+            std::thread m_flushThread;
+        };
+    }
+}
@@ -0,0 +1,931 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/dynamodb-batching/DynamoDBBatchingClient.h>
+#include <aws/dynamodb/model/DescribeTableRequest.h>
+#include <aws/dynamodb/model/WriteRequest.h>
+#include <aws/dynamodb/model/PutRequest.h>
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/logging/LogMacros.h>
+#include <aws/core/utils/memory/stl/AWSSet.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+using namespace Aws::DynamoDB;
+using namespace Aws::DynamoDB::Model;
+using namespace Aws::Utils;
+
+namespace Aws
+{
+    namespace DynamoDBBatching
+    {
+        static const char* CLASS_TAG = "DynamoDBBatchingClient";
+
+        typedef Aws::Map<Aws::String, AttributeValue> AttributeMap;
+
+        static void AppendField(Aws::String& out, const Aws::String& value)
+        {
+            out.append(StringUtils::to_string(value.size()));
+            out.push_back(':');
+            out.append(value);
+        }
+
+        /**
+         * Numbers come back from the service in canonical form, which need not be how the caller wrote them in the key (e.g. "1.50" is returned as "1.5").
+         * Reduces a number to its significant digits and a decimal exponent so that both spellings produce the same key.
+         */
+        static Aws::String NormalizeNumber(const Aws::String& number)
+        {
+            size_t pos = 0;
+            bool negative = false;
+            if (pos < number.size() && (number[pos] == '-' || number[pos] == '+'))
+            {
+                negative = number[pos] == '-';
+                ++pos;
+            }
+
+            Aws::String digits;
+            long exponent = 0;
+            bool seenPoint = false;
+            for (; pos < number.size(); ++pos)
+            {
+                char c = number[pos];
+                if (isdigit(static_cast<unsigned char>(c)))
+                {
+                    if (seenPoint)
+                    {
+                        --exponent;
+                    }
+                    if (!digits.empty() || c != '0')
+                    {
+                        digits.push_back(c);
+                    }
+                }
+                else if (c == '.' && !seenPoint)
+                {
+                    seenPoint = true;
+                }
+                else if (c == 'e' || c == 'E')
+                {
+                    exponent += strtol(number.c_str() + pos + 1, nullptr, 10);
+                    break;
+                }
+                else
+                {
+                    return number;
+                }
+            }
+
+            while (!digits.empty() && digits.back() == '0')
+            {
+                digits.pop_back();
+                ++exponent;
+            }
+
+            if (digits.empty())
+            {
+                return "0";
+            }
+
+            return (negative ? "-" : "") + digits + "e" + StringUtils::to_string(exponent);
+        }
+
+        /**
+         * Builds a string identifying the item by its key attributes. Returns false if an attribute is missing or is not a valid key type.
+         */
+        static bool BuildItemKey(const AttributeMap& item, const Aws::Vector<Aws::String>& keyAttributes, Aws::String& key)
+        {
+            for (const auto& name : keyAttributes)
+            {
+                auto attribute = item.find(name);
+                if (attribute == item.end())
+                {
+                    return false;
+                }
+
+                AppendField(key, name);
+                switch (attribute->second.GetType())
+                {
+                    case ValueType::STRING:
+                        key.push_back('S');
+                        AppendField(key, attribute->second.GetS());
+                        break;
+                    case ValueType::NUMBER:
+                        key.push_back('N');
+                        AppendField(key, NormalizeNumber(attribute->second.GetN()));
+                        break;
+                    case ValueType::BYTEBUFFER:
+                        key.push_back('B');
+                        AppendField(key, HashingUtils::Base64Encode(attribute->second.GetB()));
+                        break;
+                    default:
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        static Aws::Vector<Aws::String> GetAttributeNames(const AttributeMap& item)
+        {
+            Aws::Vector<Aws::String> names;
+            names.reserve(item.size());
+            for (const auto& attribute : item)
+            {
+                names.push_back(attribute.first);
+            }
+            return names;
+        }
+
+        /**
+         * Gets can only share a BatchGetItem call if they read the same table with the same options.
+         */
+        static Aws::String BuildGetGroupKey(const GetItemRequest& request)
+        {
+            Aws::String groupKey;
+            AppendField(groupKey, request.GetTableName());
+            groupKey.push_back(request.ConsistentReadHasBeenSet() ? (request.GetConsistentRead() ? 'C' : 'E') : '-');
+
+            groupKey.push_back(request.AttributesToGetHasBeenSet() ? 'A' : '-');
+            for (const auto& attribute : request.GetAttributesToGet())
+            {
+                AppendField(groupKey, attribute);
+            }
+
+            groupKey.push_back(request.ProjectionExpressionHasBeenSet() ? 'P' : '-');
+            AppendField(groupKey, request.GetProjectionExpression());
+
+            groupKey.push_back(request.ExpressionAttributeNamesHasBeenSet() ? 'N' : '-');
+            for (const auto& name : request.GetExpressionAttributeNames())
+            {
+                AppendField(groupKey, name.first);
+                AppendField(groupKey, name.second);
+            }
+
+            return groupKey;
+        }
+
+        /**
+         * Whether the top level attribute is one of the paths of the projection expression, either by name or through an expression attribute name.
+         */
+        static bool IsProjected(const Aws::String& expression, const Aws::Map<Aws::String, Aws::String>& names, const Aws::String& attribute)
+        {
+            for (const auto& path : StringUtils::Split(expression, ','))
+            {
+                Aws::String trimmed = StringUtils::Trim(path.c_str());
+                if (trimmed == attribute)
+                {
+                    return true;
+                }
+
+                auto alias = names.find(trimmed);
+                if (alias != names.end() && alias->second == attribute)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        static Aws::String BuildPendingPutKey(const Aws::String& tableName, const Aws::String& itemKey)
+        {
+            Aws::String pendingKey;
+            AppendField(pendingKey, tableName);
+            pendingKey.append(itemKey);
+            return pendingKey;
+        }
+
+        static Aws::Client::AWSError<DynamoDBErrors> BuildUnprocessedError(unsigned attempts)
+        {
+            return Aws::Client::AWSError<DynamoDBErrors>(DynamoDBErrors::PROVISIONED_THROUGHPUT_EXCEEDED, "ProvisionedThroughputExceededException",
+                "Item was still unprocessed after " + StringUtils::to_string(attempts) + " batch retries", true);
+        }
+
+        DynamoDBBatchingClient::DynamoDBBatchingClient(const DynamoDBBatchingConfiguration& config) :
+            m_config(config),
+            m_client(config.dynamoDBClient),
+            m_outstandingBatches(0),
+            m_shutdown(false)
+        {
+            m_config.maxGetBatchSize = (std::max)(static_cast<size_t>(1), m_config.maxGetBatchSize);
+            m_config.maxWriteBatchSize = (std::max)(static_cast<size_t>(1), m_config.maxWriteBatchSize);
+            m_flushThread = std::thread(&DynamoDBBatchingClient::FlushLoop, this);
+        }
+
+        DynamoDBBatchingClient::~DynamoDBBatchingClient()
+        {
+            Flush();
+
+            {
+                std::lock_guard<std::mutex> locker(m_batchLock);
+                m_shutdown = true;
+            }
+            m_batchSignal.notify_all();
+            m_flushThread.join();
+        }
+
+        GetItemOutcomeCallable DynamoDBBatchingClient::GetItemCallable(const GetItemRequest& request)
+        {
+            Aws::String itemKey;
+            Aws::Vector<Aws::String> keyAttributes = GetAttributeNames(request.GetKey());
+            if (request.ReturnConsumedCapacityHasBeenSet() || keyAttributes.empty() || !BuildItemKey(request.GetKey(), keyAttributes, itemKey))
+            {
+                return m_client->GetItemCallable(request);
+            }
+
+            Aws::String groupKey = BuildGetGroupKey(request);
+            auto promise = Aws::MakeShared<std::promise<GetItemOutcome>>(CLASS_TAG);
+            auto future = promise->get_future();
+
+            std::shared_ptr<GetBatch> fullBatch;
+            {
+                std::lock_guard<std::mutex> locker(m_batchLock);
+                auto& batch = m_openGets[groupKey];
+                if (!batch)
+                {
+                    batch = Aws::MakeShared<GetBatch>(CLASS_TAG);
+                    batch->groupKey = groupKey;
+                    batch->options = request;
+                    batch->keyAttributes = keyAttributes;
+                    batch->sendBy = std::chrono::steady_clock::now() + m_config.maxBatchDelay;
+                    m_batchSignal.notify_all();
+                }
+
+                // the same key can't appear twice in one BatchGetItem call, so later callers share the first caller's read
+                auto& entry = batch->entries[itemKey];
+                if (entry.promises.empty())
+                {
+                    entry.request = request;
+                }
+                entry.promises.push_back(promise);
+
+                if (batch->entries.size() >= m_config.maxGetBatchSize)
+                {
+                    fullBatch = batch;
+                    m_openGets.erase(groupKey);
+                    ++m_outstandingBatches;
+                }
+            }
+
+            if (fullBatch)
+            {
+                SendGetBatch(fullBatch);
+            }
+
+            return future;
+        }
+
+        PutItemOutcomeCallable DynamoDBBatchingClient::PutItemCallable(const PutItemRequest& request)
+        {
+            // BatchWriteItem has no conditions, return values or consumed capacity, so these have to go through PutItem
+            if (request.ExpectedHasBeenSet() || request.ConditionExpressionHasBeenSet() || request.ConditionalOperatorHasBeenSet() ||
+                request.ExpressionAttributeNamesHasBeenSet() || request.ExpressionAttributeValuesHasBeenSet() || request.ReturnValuesHasBeenSet() ||
+                request.ReturnConsumedCapacityHasBeenSet() || request.ReturnItemCollectionMetricsHasBeenSet())
+            {
+                return m_client->PutItemCallable(request);
+            }
+
+            Aws::String itemKey;
+            Aws::Vector<Aws::String> keyAttributes = GetKeyAttributes(request.GetTableName());
+            if (keyAttributes.empty() || !BuildItemKey(request.GetItem(), keyAttributes, itemKey))
+            {
+                return m_client->PutItemCallable(request);
+            }
+
+            PutEntry entry;
+            entry.request = request;
+            entry.promise = Aws::MakeShared<std::promise<PutItemOutcome>>(CLASS_TAG);
+            auto future = entry.promise->get_future();
+
+            Aws::Vector<std::shared_ptr<PutBatch>> readyBatches;
+            {
+                std::lock_guard<std::mutex> locker(m_batchLock);
+                auto pending = m_pendingPuts.find(BuildPendingPutKey(request.GetTableName(), itemKey));
+                if (pending != m_pendingPuts.end())
+                {
+                    // the same key can't appear twice in one BatchWriteItem call, and a retry of the earlier put must not land after this one;
+                    // send the earlier put now and hold this one back until the earlier one has completed
+                    auto batch = m_openPuts.find(request.GetTableName());
+                    if (batch != m_openPuts.end() && batch->second->entries.find(itemKey) != batch->second->entries.end())
+                    {
+                        readyBatches.push_back(batch->second);
+                        m_openPuts.erase(batch);
+                        ++m_outstandingBatches;
+                    }
+                    pending->second.push_back(std::move(entry));
+                }
+                else
+                {
+                    m_pendingPuts[BuildPendingPutKey(request.GetTableName(), itemKey)];
+                    auto fullBatch = AddToOpenPutBatch(request.GetTableName(), keyAttributes, itemKey, std::move(entry));
+                    if (fullBatch)
+                    {
+                        readyBatches.push_back(fullBatch);
+                    }
+                }
+            }
+
+            for (const auto& batch : readyBatches)
+            {
+                SendPutBatch(batch);
+            }
+
+            return future;
+        }
+
+        void DynamoDBBatchingClient::Flush()
+        {
+            Aws::Vector<std::shared_ptr<GetBatch>> gets;
+            Aws::Vector<std::shared_ptr<PutBatch>> puts;
+            {
+                std::lock_guard<std::mutex> locker(m_batchLock);
+                for (const auto& batch : m_openGets)
+                {
+                    gets.push_back(batch.second);
+                }
+                for (const auto& batch : m_openPuts)
+                {
+                    puts.push_back(batch.second);
+                }
+                m_outstandingBatches += gets.size() + puts.size();
+                m_openGets.clear();
+                m_openPuts.clear();
+            }
+
+            for (const auto& batch : gets)
+            {
+                SendGetBatch(batch);
+            }
+            for (const auto& batch : puts)
+            {
+                SendPutBatch(batch);
+            }
+        }
+
+        std::shared_ptr<DynamoDBBatchingClient::PutBatch> DynamoDBBatchingClient::AddToOpenPutBatch(const Aws::String& tableName,
+            const Aws::Vector<Aws::String>& keyAttributes, const Aws::String& itemKey, PutEntry&& entry)
+        {
+            // m_batchLock must be held
+            auto& batch = m_openPuts[tableName];
+            if (!batch)
+            {
+                batch = Aws::MakeShared<PutBatch>(CLASS_TAG);
+                batch->tableName = tableName;
+                batch->keyAttributes = keyAttributes;
+                batch->sendBy = std::chrono::steady_clock::now() + m_config.maxBatchDelay;
+                m_batchSignal.notify_all();
+            }
+
+            batch->entries[itemKey] = std::move(entry);
+            if (batch->entries.size() < m_config.maxWriteBatchSize)
+            {
+                return nullptr;
+            }
+
+            auto fullBatch = batch;
+            m_openPuts.erase(tableName);
+            ++m_outstandingBatches;
+            return fullBatch;
+        }
+
+        void DynamoDBBatchingClient::FinishPuts(const Aws::String& tableName, const Aws::Vector<Aws::String>& keyAttributes,
+                                                const Aws::Vector<Aws::String>& itemKeys)
+        {
+            Aws::Vector<std::shared_ptr<PutBatch>> readyBatches;
+            {
+                std::lock_guard<std::mutex> locker(m_batchLock);
+                for (const auto& itemKey : itemKeys)
+                {
+                    auto pending = m_pendingPuts.find(BuildPendingPutKey(tableName, itemKey));
+                    if (pending == m_pendingPuts.end())
+                    {
+                        continue;
+                    }
+                    if (pending->second.empty())
+                    {
+                        m_pendingPuts.erase(pending);
+                        continue;
+                    }
+
+                    // the next put for the key goes out now; the ones after it keep waiting
+                    PutEntry next = std::move(pending->second.front());
+                    pending->second.pop_front();
+                    auto fullBatch = AddToOpenPutBatch(tableName, keyAttributes, itemKey, std::move(next));
+                    if (fullBatch)
+                    {
+                        readyBatches.push_back(fullBatch);
+                    }
+                }
+            }
+
+            for (const auto& batch : readyBatches)
+            {
+                SendPutBatch(batch);
+            }
+        }
+
+        Aws::Vector<Aws::String> DynamoDBBatchingClient::GetKeyAttributes(const Aws::String& tableName)
+        {
+            std::unique_lock<std::mutex> locker(m_keySchemaLock);
+            TableKeySchema& schema = m_keySchemas[tableName];
+            m_keySchemaSignal.wait(locker, [&schema]() { return !schema.describing; });
+            if (schema.resolved || std::chrono::steady_clock::now() < schema.retryAfter)
+            {
+                return schema.keyAttributes;
+            }
+
+            // puts for other tables go on while this one is looked up
+            schema.describing = true;
+            locker.unlock();
+            auto outcome = m_client->DescribeTable(DescribeTableRequest().WithTableName(tableName));
+            locker.lock();
+            schema.describing = false;
+
+            if (outcome.IsSuccess())
+            {
+                for (const auto& element : outcome.GetResult().GetTable().GetKeySchema())
+                {
+                    schema.keyAttributes.push_back(element.GetAttributeName());
+                }
+                schema.resolved = true;
+            }
+            else
+            {
+                schema.retryAfter = GetRetryTime(schema.failures++);
+                AWS_LOGSTREAM_WARN(CLASS_TAG, "Unable to describe table " << tableName << ", puts to it will not be batched until it can be. "
+                    << outcome.GetError().GetExceptionName() << ": " << outcome.GetError().GetMessage());
+            }
+            m_keySchemaSignal.notify_all();
+
+            return schema.keyAttributes;
+        }
+
+        void DynamoDBBatchingClient::SendGetBatch(const std::shared_ptr<GetBatch>& batch)
+        {
+            const GetItemRequest& options = batch->options;
+            KeysAndAttributes keys;
+            if (options.ConsistentReadHasBeenSet())
+            {
+                keys.SetConsistentRead(options.GetConsistentRead());
+            }
+
+            // returned items are matched to callers by their key, so the key attributes have to be part of any projection
+            batch->addedAttributes.clear();
+            if (options.AttributesToGetHasBeenSet())
+            {
+                Aws::Vector<Aws::String> attributes = options.GetAttributesToGet();
+                for (const auto& name : batch->keyAttributes)
+                {
+                    if (std::find(attributes.begin(), attributes.end(), name) == attributes.end())
+                    {
+                        attributes.push_back(name);
+                        batch->addedAttributes.push_back(name);
+                    }
+                }
+                keys.SetAttributesToGet(attributes);
+            }
+
+            if (options.ProjectionExpressionHasBeenSet())
+            {
+                Aws::String expression = options.GetProjectionExpression();
+                Aws::Map<Aws::String, Aws::String> names = options.GetExpressionAttributeNames();
+                for (size_t i = 0; i < batch->keyAttributes.size(); ++i)
+                {
+                    const Aws::String& name = batch->keyAttributes[i];
+                    if (!IsProjected(expression, names, name))
+                    {
+                        Aws::String placeholder = "#batchKey" + StringUtils::to_string(i);
+                        names[placeholder] = name;
+                        expression += ", " + placeholder;
+                        batch->addedAttributes.push_back(name);
+                    }
+                }
+                keys.SetProjectionExpression(expression);
+                if (!names.empty())
+                {
+                    keys.SetExpressionAttributeNames(names);
+                }
+            }
+            else if (options.ExpressionAttributeNamesHasBeenSet())
+            {
+                keys.SetExpressionAttributeNames(options.GetExpressionAttributeNames());
+            }
+
+            for (const auto& entry : batch->entries)
+            {
+                keys.AddKeys(entry.second.request.GetKey());
+            }
+
+            BatchGetItemRequest request;
+            request.AddRequestItems(options.GetTableName(), keys);
+
+            AWS_LOGSTREAM_TRACE(CLASS_TAG, "Sending BatchGetItem for " << batch->entries.size() << " keys of table " << options.GetTableName()
+                << " (attempt " << batch->attempt + 1 << ")");
+            m_client->BatchGetItemAsync(request, [this, batch](const DynamoDBClient*, const BatchGetItemRequest&, const BatchGetItemOutcome& outcome,
+                                                               const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+            {
+                OnBatchGetItemOutcome(batch, outcome);
+            });
+        }
+
+        void DynamoDBBatchingClient::OnBatchGetItemOutcome(const std::shared_ptr<GetBatch>& batch, const BatchGetItemOutcome& outcome)
+        {
+            const Aws::String& tableName = batch->options.GetTableName();
+            if (!outcome.IsSuccess())
+            {
+                // a single bad key fails the whole batch, so give every caller the outcome GetItem would have given them
+                if (outcome.GetError().GetErrorType() == DynamoDBErrors::VALIDATION && batch->entries.size() > 1)
+                {
+                    AWS_LOGSTREAM_DEBUG(CLASS_TAG, "BatchGetItem for table " << tableName << " failed validation, sending its keys individually.");
+                    SendGetsIndividually(batch);
+                }
+                else
+                {
+                    for (const auto& entry : batch->entries)
+                    {
+                        for (const auto& promise : entry.second.promises)
+                        {
+                            promise->set_value(GetItemOutcome(outcome.GetError()));
+                        }
+                    }
+                }
+                BatchFinished();
+                return;
+            }
+
+            auto responses = outcome.GetResult().GetResponses().find(tableName);
+            if (responses != outcome.GetResult().GetResponses().end())
+            {
+                for (const auto& item : responses->second)
+                {
+                    Aws::String itemKey;
+                    if (!BuildItemKey(item, batch->keyAttributes, itemKey))
+                    {
+                        continue;
+                    }
+
+                    auto entry = batch->entries.find(itemKey);
+                    if (entry == batch->entries.end())
+                    {
+                        continue;
+                    }
+
+                    AttributeMap projected = item;
+                    for (const auto& name : batch->addedAttributes)
+                    {
+                        projected.erase(name);
+                    }
+                    GetItemResult result;
+                    result.SetItem(std::move(projected));
+
+                    for (const auto& promise : entry->second.promises)
+                    {
+                        promise->set_value(GetItemOutcome(result));
+                    }
+                    batch->entries.erase(entry);
+                }
+            }
+
+            Aws::Set<Aws::String> unprocessed;
+            auto unprocessedKeys = outcome.GetResult().GetUnprocessedKeys().find(tableName);
+            if (unprocessedKeys != outcome.GetResult().GetUnprocessedKeys().end())
+            {
+                for (const auto& key : unprocessedKeys->second.GetKeys())
+                {
+                    Aws::String itemKey;
+                    if (BuildItemKey(key, batch->keyAttributes, itemKey))
+                    {
+                        unprocessed.insert(itemKey);
+                    }
+                }
+            }
+
+            // whatever was neither returned nor left unprocessed does not exist
+            for (auto entry = batch->entries.begin(); entry != batch->entries.end();)
+            {
+                if (unprocessed.find(entry->first) != unprocessed.end())
+                {
+                    ++entry;
+                    continue;
+                }
+
+                for (const auto& promise : entry->second.promises)
+                {
+                    promise->set_value(GetItemOutcome(GetItemResult()));
+                }
+                entry = batch->entries.erase(entry);
+            }
+
+            if (!batch->entries.empty())
+            {
+                if (batch->attempt < m_config.maxUnprocessedRetries)
+                {
+                    ScheduleRetry(batch);
+                }
+                else
+                {
+                    for (const auto& entry : batch->entries)
+                    {
+                        for (const auto& promise : entry.second.promises)
+                        {
+                            promise->set_value(GetItemOutcome(BuildUnprocessedError(batch->attempt)));
+                        }
+                    }
+                }
+            }
+
+            BatchFinished();
+        }
+
+        void DynamoDBBatchingClient::SendPutBatch(const std::shared_ptr<PutBatch>& batch)
+        {
+            Aws::Vector<WriteRequest> writes;
+            writes.reserve(batch->entries.size());
+            for (const auto& entry : batch->entries)
+            {
+                WriteRequest write;
+                write.SetPutRequest(PutRequest().WithItem(entry.second.request.GetItem()));
+                writes.push_back(std::move(write));
+            }
+
+            BatchWriteItemRequest request;
+            request.AddRequestItems(batch->tableName, writes);
+
+            AWS_LOGSTREAM_TRACE(CLASS_TAG, "Sending BatchWriteItem for " << writes.size() << " items of table " << batch->tableName
+                << " (attempt " << batch->attempt + 1 << ")");
+            m_client->BatchWriteItemAsync(request, [this, batch](const DynamoDBClient*, const BatchWriteItemRequest&, const BatchWriteItemOutcome& outcome,
+                                                                 const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+            {
+                OnBatchWriteItemOutcome(batch, outcome);
+            });
+        }
+
+        void DynamoDBBatchingClient::OnBatchWriteItemOutcome(const std::shared_ptr<PutBatch>& batch, const BatchWriteItemOutcome& outcome)
+        {
+            if (!outcome.IsSuccess())
+            {
+                if (outcome.GetError().GetErrorType() == DynamoDBErrors::VALIDATION && batch->entries.size() > 1)
+                {
+                    AWS_LOGSTREAM_DEBUG(CLASS_TAG, "BatchWriteItem for table " << batch->tableName << " failed validation, sending its items individually.");
+                    SendPutsIndividually(batch);
+                }
+                else
+                {
+                    Aws::Vector<Aws::String> finished;
+                    for (const auto& entry : batch->entries)
+                    {
+                        entry.second.promise->set_value(PutItemOutcome(outcome.GetError()));
+                        finished.push_back(entry.first);
+                    }
+                    FinishPuts(batch->tableName, batch->keyAttributes, finished);
+                }
+                BatchFinished();
+                return;
+            }
+
+            Aws::Set<Aws::String> unprocessed;
+            auto unprocessedItems = outcome.GetResult().GetUnprocessedItems().find(batch->tableName);
+            if (unprocessedItems != outcome.GetResult().GetUnprocessedItems().end())
+            {
+                for (const auto& write : unprocessedItems->second)
+                {
+                    Aws::String itemKey;
+                    if (BuildItemKey(write.GetPutRequest().GetItem(), batch->keyAttributes, itemKey))
+                    {
+                        unprocessed.insert(itemKey);
+                    }
+                }
+            }
+
+            // unprocessed items stay pending, so later puts for their keys keep waiting for the retry
+            Aws::Vector<Aws::String> finished;
+            for (auto entry = batch->entries.begin(); entry != batch->entries.end();)
+            {
+                if (unprocessed.find(entry->first) != unprocessed.end())
+                {
+                    ++entry;
+                    continue;
+                }
+
+                entry->second.promise->set_value(PutItemOutcome(PutItemResult()));
+                finished.push_back(entry->first);
+                entry = batch->entries.erase(entry);
+            }
+
+            if (!batch->entries.empty())
+            {
+                if (batch->attempt < m_config.maxUnprocessedRetries)
+                {
+                    ScheduleRetry(batch);
+                }
+                else
+                {
+                    for (const auto& entry : batch->entries)
+                    {
+                        entry.second.promise->set_value(PutItemOutcome(BuildUnprocessedError(batch->attempt)));
+                        finished.push_back(entry.first);
+                    }
+                }
+            }
+
+            FinishPuts(batch->tableName, batch->keyAttributes, finished);
+            BatchFinished();
+        }
+
+        void DynamoDBBatchingClient::SendGetsIndividually(const std::shared_ptr<GetBatch>& batch)
+        {
+            {
+                std::lock_guard<std::mutex> locker(m_batchLock);
+                m_outstandingBatches += batch->entries.size();
+            }
+
+            for (const auto& entry : batch->entries)
+            {
+                auto promises = entry.second.promises;
+                m_client->GetItemAsync(entry.second.request, [this, promises](const DynamoDBClient*, const GetItemRequest&, const GetItemOutcome& outcome,
+                                                                              const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+                {
+                    for (const auto& promise : promises)
+                    {
+                        promise->set_value(outcome);
+                    }
+                    BatchFinished();
+                });
+            }
+        }
+
+        void DynamoDBBatchingClient::SendPutsIndividually(const std::shared_ptr<PutBatch>& batch)
+        {
+            {
+                std::lock_guard<std::mutex> locker(m_batchLock);
+                m_outstandingBatches += batch->entries.size();
+            }
+
+            for (const auto& entry : batch->entries)
+            {
+                auto promise = entry.second.promise;
+                Aws::String itemKey = entry.first;
+                m_client->PutItemAsync(entry.second.request, [this, batch, promise, itemKey](const DynamoDBClient*, const PutItemRequest&,
+                                       const PutItemOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+                {
+                    promise->set_value(outcome);
+                    FinishPuts(batch->tableName, batch->keyAttributes, Aws::Vector<Aws::String>(1, itemKey));
+                    BatchFinished();
+                });
+            }
+        }
+
+        std::chrono::steady_clock::time_point DynamoDBBatchingClient::GetRetryTime(unsigned attempt) const
+        {
+            // same curve as DefaultRetryStrategy, capped so that the shift can't overflow
+            long delayMs = m_config.unprocessedRetryBaseDelayMs * (1L << (std::min)(attempt, 16u));
+            return std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+        }
+
+        void DynamoDBBatchingClient::ScheduleRetry(const std::shared_ptr<GetBatch>& batch)
+        {
+            batch->sendBy = GetRetryTime(batch->attempt++);
+            AWS_LOGSTREAM_DEBUG(CLASS_TAG, batch->entries.size() << " keys of table " << batch->options.GetTableName() << " were unprocessed, retrying.");
+
+            std::lock_guard<std::mutex> locker(m_batchLock);
+            m_getRetries.push_back(batch);
+            ++m_outstandingBatches;
+            m_batchSignal.notify_all();
+        }
+
+        void DynamoDBBatchingClient::ScheduleRetry(const std::shared_ptr<PutBatch>& batch)
+        {
+            batch->sendBy = GetRetryTime(batch->attempt++);
+            AWS_LOGSTREAM_DEBUG(CLASS_TAG, batch->entries.size() << " items of table " << batch->tableName << " were unprocessed, retrying.");
+
+            std::lock_guard<std::mutex> locker(m_batchLock);
+            m_putRetries.push_back(batch);
+            ++m_outstandingBatches;
+            m_batchSignal.notify_all();
+        }
+
+        void DynamoDBBatchingClient::BatchFinished()
+        {
+            std::lock_guard<std::mutex> locker(m_batchLock);
+            --m_outstandingBatches;
+            m_batchSignal.notify_all();
+        }
+
+        void DynamoDBBatchingClient::FlushLoop()
+        {
+            std::unique_lock<std::mutex> locker(m_batchLock);
+            for (;;)
+            {
+                auto now = std::chrono::steady_clock::now();
+                auto wakeUp = std::chrono::steady_clock::time_point::max();
+                Aws::Vector<std::shared_ptr<GetBatch>> gets;
+                Aws::Vector<std::shared_ptr<PutBatch>> puts;
+
+                // puts held back for an earlier put of the same key can open new batches while shutting down, so those go out right away
+                for (auto batch = m_openGets.begin(); batch != m_openGets.end();)
+                {
+                    if (batch->second->sendBy <= now || m_shutdown)
+                    {
+                        gets.push_back(batch->second);
+                        ++m_outstandingBatches;
+                        batch = m_openGets.erase(batch);
+                    }
+                    else
+                    {
+                        wakeUp = (std::min)(wakeUp, batch->second->sendBy);
+                        ++batch;
+                    }
+                }
+
+                for (auto batch = m_openPuts.begin(); batch != m_openPuts.end();)
+                {
+                    if (batch->second->sendBy <= now || m_shutdown)
+                    {
+                        puts.push_back(batch->second);
+                        ++m_outstandingBatches;
+                        batch = m_openPuts.erase(batch);
+                    }
+                    else
+                    {
+                        wakeUp = (std::min)(wakeUp, batch->second->sendBy);
+                        ++batch;
+                    }
+                }
+
+                // retries were already counted as outstanding when they were scheduled
+                for (auto batch = m_getRetries.begin(); batch != m_getRetries.end();)
+                {
+                    if ((*batch)->sendBy <= now)
+                    {
+                        gets.push_back(*batch);
+                        batch = m_getRetries.erase(batch);
+                    }
+                    else
+                    {
+                        wakeUp = (std::min)(wakeUp, (*batch)->sendBy);
+                        ++batch;
+                    }
+                }
+
+                for (auto batch = m_putRetries.begin(); batch != m_putRetries.end();)
+                {
+                    if ((*batch)->sendBy <= now)
+                    {
+                        puts.push_back(*batch);
+                        batch = m_putRetries.erase(batch);
+                    }
+                    else
+                    {
+                        wakeUp = (std::min)(wakeUp, (*batch)->sendBy);
+                        ++batch;
+                    }
+                }
+
+                if (!gets.empty() || !puts.empty())
+                {
+                    locker.unlock();
+                    for (const auto& batch : gets)
+                    {
+                        SendGetBatch(batch);
+                    }
+                    for (const auto& batch : puts)
+                    {
+                        SendPutBatch(batch);
+                    }
+                    locker.lock();
+                    continue;
+                }
+
+                if (m_shutdown && m_outstandingBatches == 0)
+                {
+                    break;
+                }
+
+                if (wakeUp == std::chrono::steady_clock::time_point::max())
+                {
+                    m_batchSignal.wait(locker);
+                }
+                else
+                {
+                    m_batchSignal.wait_until(locker, wakeUp);
+                }
+            }
+        }
+    }
+}
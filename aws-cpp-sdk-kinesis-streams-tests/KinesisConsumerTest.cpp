@@ -0,0 +1,556 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/external/gtest.h>
+#include <aws/kinesis-streams/KinesisConsumer.h>
+#include <aws/kinesis-streams/AggregatedRecord.h>
+#include <aws/kinesis/model/GetRecordsRequest.h>
+#include <aws/kinesis/model/GetShardIteratorRequest.h>
+#include <aws/kinesis/model/GetShardIteratorResult.h>
+#include <aws/kinesis/model/ListShardsRequest.h>
+#include <aws/kinesis/model/ListShardsResult.h>
+#include <aws/core/auth/AWSCredentialsProvider.h>
+#include <aws/core/utils/StringUtils.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace Aws::KinesisStreams;
+using namespace Aws::Kinesis;
+using namespace Aws::Kinesis::Model;
+using namespace Aws::Utils;
+
+static const char* ALLOC_TAG = "KinesisConsumerTest";
+static const char* STREAM_NAME = "ConsumerTestStream";
+
+static ByteBuffer ToBuffer(const Aws::String& value)
+{
+    return ByteBuffer(reinterpret_cast<const unsigned char*>(value.c_str()), value.size());
+}
+
+static Aws::String FromBuffer(const ByteBuffer& buffer)
+{
+    return Aws::String(reinterpret_cast<const char*>(buffer.GetUnderlyingData()), buffer.GetLength());
+}
+
+/**
+ * A stream held in memory. Shard iterators are "<shard id>/<position>", GetRecords reports a shard 1 second behind while it has records
+ * left after those returned, and shards are listed two per page.
+ */
+class MockKinesisStreamClient : public KinesisClient
+{
+public:
+    MockKinesisStreamClient() : KinesisClient(Aws::Auth::AWSCredentials("", "")), m_expireIterators(0), m_throttleReads(0), m_sequenceNumber(0)
+    {
+    }
+
+    void AddShard(const Aws::String& shardId, const Aws::String& parentShardId = "", const Aws::String& adjacentParentShardId = "")
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        Shard shard;
+        shard.SetShardId(shardId);
+        if (!parentShardId.empty())
+        {
+            shard.SetParentShardId(parentShardId);
+        }
+        if (!adjacentParentShardId.empty())
+        {
+            shard.SetAdjacentParentShardId(adjacentParentShardId);
+        }
+        shard.SetSequenceNumberRange(SequenceNumberRange().WithStartingSequenceNumber("1"));
+        m_shardOrder.push_back(shardId);
+        m_shards[shardId].shard = shard;
+    }
+
+    void CloseShard(const Aws::String& shardId)
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        auto range = m_shards[shardId].shard.GetSequenceNumberRange();
+        m_shards[shardId].shard.SetSequenceNumberRange(range.WithEndingSequenceNumber(StringUtils::to_string(m_sequenceNumber)));
+    }
+
+    Aws::String PutRecord(const Aws::String& shardId, const ByteBuffer& data)
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        Record record;
+        record.SetSequenceNumber(StringUtils::to_string(++m_sequenceNumber));
+        record.SetPartitionKey("key-" + StringUtils::to_string(m_sequenceNumber));
+        record.SetData(data);
+        m_shards[shardId].records.push_back(record);
+        return record.GetSequenceNumber();
+    }
+
+    Aws::String PutRecord(const Aws::String& shardId, const Aws::String& data)
+    {
+        return PutRecord(shardId, ToBuffer(data));
+    }
+
+    ListShardsOutcome ListShards(const ListShardsRequest& request) const override
+    {
+        EXPECT_NE(request.StreamNameHasBeenSet(), request.NextTokenHasBeenSet());
+        std::lock_guard<std::mutex> locker(m_lock);
+        size_t first = request.NextTokenHasBeenSet() ? static_cast<size_t>(StringUtils::ConvertToInt32(request.GetNextToken().c_str())) : 0;
+        ListShardsResult result;
+        for (size_t i = first; i < first + 2 && i < m_shardOrder.size(); ++i)
+        {
+            result.AddShards(m_shards.at(m_shardOrder[i]).shard);
+        }
+        if (first + 2 < m_shardOrder.size())
+        {
+            result.SetNextToken(StringUtils::to_string(first + 2));
+        }
+        return result;
+    }
+
+    GetShardIteratorOutcome GetShardIterator(const GetShardIteratorRequest& request) const override
+    {
+        EXPECT_EQ(STREAM_NAME, request.GetStreamName());
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_iteratorRequests.push_back(request);
+        const auto& shard = m_shards.at(request.GetShardId());
+        size_t position = 0;
+        switch (request.GetShardIteratorType())
+        {
+        case ShardIteratorType::LATEST:
+            position = shard.records.size();
+            break;
+        case ShardIteratorType::AFTER_SEQUENCE_NUMBER:
+            while (position < shard.records.size() && shard.records[position].GetSequenceNumber() != request.GetStartingSequenceNumber())
+            {
+                ++position;
+            }
+            EXPECT_LT(position, shard.records.size());
+            ++position;
+            break;
+        default:
+            break;
+        }
+        GetShardIteratorResult result;
+        if (position < shard.records.size() || !IsClosed(shard))
+        {
+            result.SetShardIterator(request.GetShardId() + "/" + StringUtils::to_string(position));
+        }
+        return result;
+    }
+
+    GetRecordsOutcome GetRecords(const GetRecordsRequest& request) const override
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        auto separator = request.GetShardIterator().find('/');
+        Aws::String shardId = request.GetShardIterator().substr(0, separator);
+        ++m_getRecordsCalls[shardId];
+        m_callTimes[shardId].push_back(std::chrono::steady_clock::now());
+        m_callSignal.notify_all();
+        if (m_throttleReads > 0)
+        {
+            --m_throttleReads;
+            return GetRecordsOutcome(Aws::Client::AWSError<KinesisErrors>(KinesisErrors::PROVISIONED_THROUGHPUT_EXCEEDED, "ProvisionedThroughputExceededException",
+                "Rate exceeded", true));
+        }
+
+        const auto& shard = m_shards.at(shardId);
+        size_t position = static_cast<size_t>(StringUtils::ConvertToInt32(request.GetShardIterator().substr(separator + 1).c_str()));
+        // iterators expire after the first batch
+        if (m_expireIterators > 0 && position > 0)
+        {
+            --m_expireIterators;
+            return GetRecordsOutcome(Aws::Client::AWSError<KinesisErrors>(KinesisErrors::EXPIRED_ITERATOR, "ExpiredIteratorException", "Iterator expired", false));
+        }
+        size_t end = (std::min)(shard.records.size(), position + static_cast<size_t>(request.GetLimit()));
+        GetRecordsResult result;
+        for (size_t i = position; i < end; ++i)
+        {
+            result.AddRecords(shard.records[i]);
+        }
+        result.SetMillisBehindLatest(end < shard.records.size() ? 1000 : 0);
+        if (end < shard.records.size() || !IsClosed(shard))
+        {
+            result.SetNextShardIterator(shardId + "/" + StringUtils::to_string(end));
+        }
+        return result;
+    }
+
+    int GetRecordsCalls(const Aws::String& shardId) const
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        return m_getRecordsCalls[shardId];
+    }
+
+    bool WaitForRecordsCalls(const Aws::String& shardId, int calls) const
+    {
+        std::unique_lock<std::mutex> locker(m_lock);
+        return m_callSignal.wait_for(locker, std::chrono::seconds(5), [&]() { return m_getRecordsCalls[shardId] >= calls; });
+    }
+
+    /**
+     * When each GetRecords call on the shard was made.
+     */
+    Aws::Vector<std::chrono::steady_clock::time_point> GetRecordsCallTimes(const Aws::String& shardId) const
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        return m_callTimes[shardId];
+    }
+
+    Aws::Vector<GetShardIteratorRequest> GetIteratorRequests() const
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        return m_iteratorRequests;
+    }
+
+    mutable int m_expireIterators;
+    mutable int m_throttleReads;
+
+private:
+    struct MockShard
+    {
+        Shard shard;
+        Aws::Vector<Record> records;
+    };
+
+    static bool IsClosed(const MockShard& shard)
+    {
+        return !shard.shard.GetSequenceNumberRange().GetEndingSequenceNumber().empty();
+    }
+
+    mutable std::mutex m_lock;
+    mutable std::condition_variable m_callSignal;
+    Aws::Vector<Aws::String> m_shardOrder;
+    Aws::Map<Aws::String, MockShard> m_shards;
+    long m_sequenceNumber;
+    mutable Aws::Map<Aws::String, int> m_getRecordsCalls;
+    mutable Aws::Map<Aws::String, Aws::Vector<std::chrono::steady_clock::time_point>> m_callTimes;
+    mutable Aws::Vector<GetShardIteratorRequest> m_iteratorRequests;
+};
+
+/**
+ * Lets a test wait for a checkpoint to be written.
+ */
+class WaitableCheckpointer : public InMemoryCheckpointer
+{
+public:
+    void Checkpoint(const Aws::String& shardId, const Aws::String& sequenceNumber) override
+    {
+        InMemoryCheckpointer::Checkpoint(shardId, sequenceNumber);
+        std::lock_guard<std::mutex> locker(m_waitLock);
+        m_checkpointSignal.notify_all();
+    }
+
+    bool WaitForCheckpoint(const Aws::String& shardId, const Aws::String& expected)
+    {
+        std::unique_lock<std::mutex> locker(m_waitLock);
+        return m_checkpointSignal.wait_for(locker, std::chrono::seconds(5), [&]()
+        {
+            Aws::String checkpoint;
+            return GetCheckpoint(shardId, checkpoint) && checkpoint == expected;
+        });
+    }
+
+private:
+    std::mutex m_waitLock;
+    std::condition_variable m_checkpointSignal;
+};
+
+class KinesisConsumerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_mockClient = Aws::MakeShared<MockKinesisStreamClient>(ALLOC_TAG);
+        m_checkpointer = Aws::MakeShared<WaitableCheckpointer>(ALLOC_TAG);
+        m_config.kinesisClient = m_mockClient;
+        m_config.streamName = STREAM_NAME;
+        m_config.checkpointer = m_checkpointer;
+        m_config.initialPosition = InitialPosition::TRIM_HORIZON;
+        m_config.minPollInterval = std::chrono::milliseconds(10);
+        m_config.maxPollInterval = std::chrono::milliseconds(50);
+        m_config.handler = [this](const RecordBatch& batch)
+        {
+            if (m_onBatch)
+            {
+                m_onBatch(batch);
+            }
+            std::lock_guard<std::mutex> locker(m_consumedLock);
+            for (const auto& record : batch.records)
+            {
+                m_consumed.push_back(std::make_pair(batch.shardId, record));
+            }
+            m_consumedSignal.notify_all();
+        };
+    }
+
+    Aws::Vector<std::pair<Aws::String, ConsumedRecord>> WaitForRecords(size_t count)
+    {
+        std::unique_lock<std::mutex> locker(m_consumedLock);
+        m_consumedSignal.wait_for(locker, std::chrono::seconds(5), [this, count]() { return m_consumed.size() >= count; });
+        return m_consumed;
+    }
+
+    /**
+     * Data of the records consumed from shardId, in the order they were handled.
+     */
+    static Aws::Vector<Aws::String> RecordsOf(const Aws::Vector<std::pair<Aws::String, ConsumedRecord>>& consumed, const Aws::String& shardId)
+    {
+        Aws::Vector<Aws::String> data;
+        for (const auto& record : consumed)
+        {
+            if (record.first == shardId)
+            {
+                data.push_back(FromBuffer(record.second.data));
+            }
+        }
+        return data;
+    }
+
+    /**
+     * Position in consumed of the first or last record handled from shardId.
+     */
+    static size_t PositionOf(const Aws::Vector<std::pair<Aws::String, ConsumedRecord>>& consumed, const Aws::String& shardId, bool last)
+    {
+        size_t position = consumed.size();
+        for (size_t i = 0; i < consumed.size(); ++i)
+        {
+            if (consumed[i].first == shardId && (last || position == consumed.size()))
+            {
+                position = i;
+            }
+        }
+        return position;
+    }
+
+    static Aws::Vector<Aws::String> Expected(const Aws::String& prefix, int first, int count)
+    {
+        Aws::Vector<Aws::String> data;
+        for (int i = first; i < first + count; ++i)
+        {
+            data.push_back(prefix + StringUtils::to_string(i));
+        }
+        return data;
+    }
+
+    std::shared_ptr<MockKinesisStreamClient> m_mockClient;
+    std::shared_ptr<WaitableCheckpointer> m_checkpointer;
+    KinesisConsumerConfiguration m_config;
+    std::function<void(const RecordBatch&)> m_onBatch;
+    std::mutex m_consumedLock;
+    std::condition_variable m_consumedSignal;
+    Aws::Vector<std::pair<Aws::String, ConsumedRecord>> m_consumed;
+};
+
+TEST_F(KinesisConsumerTest, TestReadsEveryShardInOrder)
+{
+    m_config.maxRecordsPerFetch = 5;
+    Aws::String lastSequenceNumbers[3];
+    for (int shard = 0; shard < 3; ++shard)
+    {
+        m_mockClient->AddShard("shard-" + StringUtils::to_string(shard));
+        for (int i = 0; i < 12; ++i)
+        {
+            lastSequenceNumbers[shard] = m_mockClient->PutRecord("shard-" + StringUtils::to_string(shard), "s" + StringUtils::to_string(shard) + "-" + StringUtils::to_string(i));
+        }
+    }
+    RecordAggregator aggregator;
+    for (int i = 12; i < 15; ++i)
+    {
+        UserRecord userRecord;
+        userRecord.partitionKey = "aggregated";
+        userRecord.data = ToBuffer("s2-" + StringUtils::to_string(i));
+        aggregator.Add(userRecord);
+    }
+    lastSequenceNumbers[2] = m_mockClient->PutRecord("shard-2", aggregator.Build());
+
+    KinesisConsumer consumer(m_config);
+    auto consumed = WaitForRecords(39);
+    ASSERT_EQ(39u, consumed.size());
+    ASSERT_EQ(Expected("s0-", 0, 12), RecordsOf(consumed, "shard-0"));
+    ASSERT_EQ(Expected("s1-", 0, 12), RecordsOf(consumed, "shard-1"));
+    ASSERT_EQ(Expected("s2-", 0, 15), RecordsOf(consumed, "shard-2"));
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const ConsumedRecord& unpacked = consumed[PositionOf(consumed, "shard-2", true) - 2 + i].second;
+        ASSERT_EQ(lastSequenceNumbers[2], unpacked.sequenceNumber);
+        ASSERT_EQ(i, unpacked.subSequenceNumber);
+        ASSERT_EQ("aggregated", unpacked.partitionKey);
+    }
+
+    // records put later are picked up by the readers polling the open shards
+    Aws::String sequenceNumber = m_mockClient->PutRecord("shard-1", "s1-12");
+    consumed = WaitForRecords(40);
+    ASSERT_EQ(Expected("s1-", 0, 13), RecordsOf(consumed, "shard-1"));
+    ASSERT_EQ(sequenceNumber, consumed.back().second.sequenceNumber);
+    ASSERT_EQ("key-" + sequenceNumber, consumed.back().second.partitionKey);
+
+    ASSERT_TRUE(m_checkpointer->WaitForCheckpoint("shard-0", lastSequenceNumbers[0]));
+    ASSERT_TRUE(m_checkpointer->WaitForCheckpoint("shard-1", sequenceNumber));
+    ASSERT_TRUE(m_checkpointer->WaitForCheckpoint("shard-2", lastSequenceNumbers[2]));
+}
+
+TEST_F(KinesisConsumerTest, TestChildShardsAreReadAfterTheirParents)
+{
+    // shard-0 was split into shard-1 and shard-2, which were merged into shard-3
+    m_mockClient->AddShard("shard-3", "shard-1", "shard-2");
+    m_mockClient->AddShard("shard-1", "shard-0");
+    m_mockClient->AddShard("shard-2", "shard-0");
+    m_mockClient->AddShard("shard-0");
+    for (int i = 0; i < 10; ++i)
+    {
+        m_mockClient->PutRecord("shard-0", "a" + StringUtils::to_string(i));
+    }
+    m_mockClient->CloseShard("shard-0");
+    for (int i = 0; i < 5; ++i)
+    {
+        m_mockClient->PutRecord("shard-1", "b" + StringUtils::to_string(i));
+        m_mockClient->PutRecord("shard-2", "c" + StringUtils::to_string(i));
+    }
+    m_mockClient->CloseShard("shard-1");
+    m_mockClient->CloseShard("shard-2");
+    m_mockClient->PutRecord("shard-3", "d0");
+    m_config.maxRecordsPerFetch = 3;
+
+    KinesisConsumer consumer(m_config);
+    auto consumed = WaitForRecords(21);
+    ASSERT_EQ(21u, consumed.size());
+    ASSERT_EQ(Expected("a", 0, 10), RecordsOf(consumed, "shard-0"));
+    ASSERT_EQ(Expected("b", 0, 5), RecordsOf(consumed, "shard-1"));
+    ASSERT_EQ(Expected("c", 0, 5), RecordsOf(consumed, "shard-2"));
+    ASSERT_EQ(Expected("d", 0, 1), RecordsOf(consumed, "shard-3"));
+    ASSERT_LT(PositionOf(consumed, "shard-0", true), PositionOf(consumed, "shard-1", false));
+    ASSERT_LT(PositionOf(consumed, "shard-0", true), PositionOf(consumed, "shard-2", false));
+    ASSERT_LT(PositionOf(consumed, "shard-1", true), PositionOf(consumed, "shard-3", false));
+    ASSERT_LT(PositionOf(consumed, "shard-2", true), PositionOf(consumed, "shard-3", false));
+
+    // a split while reading is found once the parent ends, without waiting for the next listing of the shards
+    m_mockClient->PutRecord("shard-3", "d1");
+    m_mockClient->AddShard("shard-4", "shard-3");
+    m_mockClient->PutRecord("shard-4", "e0");
+    m_mockClient->CloseShard("shard-3");
+    consumed = WaitForRecords(23);
+    ASSERT_EQ(Expected("d", 0, 2), RecordsOf(consumed, "shard-3"));
+    ASSERT_EQ(Expected("e", 0, 1), RecordsOf(consumed, "shard-4"));
+
+    for (int shard = 0; shard < 4; ++shard)
+    {
+        ASSERT_TRUE(m_checkpointer->WaitForCheckpoint("shard-" + StringUtils::to_string(shard), SHARD_END_CHECKPOINT));
+    }
+}
+
+TEST_F(KinesisConsumerTest, TestReadingStartsFromCheckpointsOrLatest)
+{
+    m_config.initialPosition = InitialPosition::LATEST;
+    m_mockClient->AddShard("shard-0");
+    m_mockClient->AddShard("shard-1", "shard-0");
+    m_mockClient->AddShard("shard-2");
+    m_mockClient->AddShard("shard-3");
+    for (int i = 0; i < 4; ++i)
+    {
+        m_mockClient->PutRecord("shard-0", "old" + StringUtils::to_string(i));
+        m_mockClient->PutRecord("shard-1", "old" + StringUtils::to_string(i));
+        Aws::String sequenceNumber = m_mockClient->PutRecord("shard-2", "b" + StringUtils::to_string(i));
+        if (i == 1)
+        {
+            m_checkpointer->Checkpoint("shard-2", sequenceNumber);
+        }
+        m_mockClient->PutRecord("shard-3", "old" + StringUtils::to_string(i));
+    }
+    m_mockClient->CloseShard("shard-0");
+    m_checkpointer->Checkpoint("shard-3", SHARD_END_CHECKPOINT);
+
+    KinesisConsumer consumer(m_config);
+    ASSERT_TRUE(m_mockClient->WaitForRecordsCalls("shard-1", 1));
+    m_mockClient->PutRecord("shard-1", "a0");
+    auto consumed = WaitForRecords(3);
+    ASSERT_EQ(3u, consumed.size());
+    ASSERT_EQ(Expected("a", 0, 1), RecordsOf(consumed, "shard-1"));
+    ASSERT_EQ(Expected("b", 2, 2), RecordsOf(consumed, "shard-2"));
+
+    // the closed shard has nothing at its latest record and the finished one is not read again
+    auto iteratorRequests = m_mockClient->GetIteratorRequests();
+    ASSERT_EQ(2u, iteratorRequests.size());
+    for (const auto& request : iteratorRequests)
+    {
+        ASSERT_EQ(request.GetShardId() == "shard-1" ? ShardIteratorType::LATEST : ShardIteratorType::AFTER_SEQUENCE_NUMBER, request.GetShardIteratorType());
+    }
+    ASSERT_EQ(0, m_mockClient->GetRecordsCalls("shard-0"));
+    ASSERT_EQ(0, m_mockClient->GetRecordsCalls("shard-3"));
+}
+
+TEST_F(KinesisConsumerTest, TestNextBatchIsFetchedWhileOneIsHandled)
+{
+    m_mockClient->AddShard("shard-0");
+    for (int i = 0; i < 30; ++i)
+    {
+        m_mockClient->PutRecord("shard-0", "r" + StringUtils::to_string(i));
+    }
+    m_config.maxRecordsPerFetch = 10;
+    m_config.maxPollInterval = std::chrono::milliseconds(80);
+    std::atomic<bool> fetchedAhead(false);
+    std::atomic<int> callsWhileHandling(0);
+    std::atomic<int> batches(0);
+    m_onBatch = [&](const RecordBatch& batch)
+    {
+        if (batches++ == 0)
+        {
+            fetchedAhead = m_mockClient->WaitForRecordsCalls(batch.shardId, 2);
+            // time for the reader to read further ahead, which it must not
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            callsWhileHandling = m_mockClient->GetRecordsCalls(batch.shardId);
+        }
+    };
+
+    KinesisConsumer consumer(m_config);
+    auto consumed = WaitForRecords(30);
+    ASSERT_TRUE(fetchedAhead);
+    ASSERT_EQ(2, callsWhileHandling.load());
+    ASSERT_EQ(Expected("r", 0, 30), RecordsOf(consumed, "shard-0"));
+    ASSERT_EQ(3, batches.load());
+
+    // three calls read the records, and each empty read after them doubles the interval before the next one, up to maxPollInterval;
+    // without the cap, ten empty reads would take over 20 seconds
+    ASSERT_TRUE(m_mockClient->WaitForRecordsCalls("shard-0", 3 + 10));
+    auto callTimes = m_mockClient->GetRecordsCallTimes("shard-0");
+    for (size_t emptyReads = 1; emptyReads < 10; ++emptyReads)
+    {
+        auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(callTimes[2 + emptyReads + 1] - callTimes[2 + emptyReads]);
+        long long expectedInterval = emptyReads < 3 ? 10LL << emptyReads : 80LL;
+        ASSERT_GE(interval.count(), expectedInterval);
+    }
+}
+
+TEST_F(KinesisConsumerTest, TestReadsRecoverFromExpiredIteratorsAndThrottling)
+{
+    m_mockClient->AddShard("shard-0");
+    Aws::String lastSequenceNumber;
+    for (int i = 0; i < 20; ++i)
+    {
+        lastSequenceNumber = m_mockClient->PutRecord("shard-0", "r" + StringUtils::to_string(i));
+    }
+    m_config.maxRecordsPerFetch = 5;
+    m_mockClient->m_expireIterators = 1;
+    m_mockClient->m_throttleReads = 2;
+
+    KinesisConsumer consumer(m_config);
+    auto consumed = WaitForRecords(20);
+    ASSERT_EQ(Expected("r", 0, 20), RecordsOf(consumed, "shard-0"));
+
+    auto iteratorRequests = m_mockClient->GetIteratorRequests();
+    ASSERT_EQ(2u, iteratorRequests.size());
+    ASSERT_EQ(ShardIteratorType::TRIM_HORIZON, iteratorRequests[0].GetShardIteratorType());
+    ASSERT_EQ(ShardIteratorType::AFTER_SEQUENCE_NUMBER, iteratorRequests[1].GetShardIteratorType());
+    ASSERT_EQ(consumed[4].second.sequenceNumber, iteratorRequests[1].GetStartingSequenceNumber());
+
+    ASSERT_TRUE(m_checkpointer->WaitForCheckpoint("shard-0", lastSequenceNumber));
+}
@@ -0,0 +1,527 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/external/gtest.h>
+#include <aws/kinesis-streams/KinesisProducer.h>
+#include <aws/kinesis/model/ListShardsRequest.h>
+#include <aws/kinesis/model/ListShardsResult.h>
+#include <aws/kinesis/model/PutRecordsResult.h>
+#include <aws/kinesis/model/Shard.h>
+#include <aws/core/auth/AWSCredentialsProvider.h>
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/memory/stl/AWSSet.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace Aws::KinesisStreams;
+using namespace Aws::Kinesis;
+using namespace Aws::Kinesis::Model;
+using namespace Aws::Utils;
+
+static const char* ALLOC_TAG = "KinesisProducerTest";
+static const char* STREAM_NAME = "ProducerTestStream";
+
+// quarters of the 128 bit hash key space
+static const char* HASH_KEY_QUARTERS[] = { "0", "85070591730234615865843651857942052864", "170141183460469231731687303715884105728",
+    "255211775190703847597530955573826158592" };
+static const char* MAX_HASH_KEY = "340282366920938463463374607431768211455";
+
+static bool DecimalLess(const Aws::String& left, const Aws::String& right)
+{
+    return left.size() != right.size() ? left.size() < right.size() : left < right;
+}
+
+static Aws::String Predecessor(const Aws::String& decimal)
+{
+    Aws::String result = decimal;
+    size_t position = result.size() - 1;
+    while (result[position] == '0')
+    {
+        result[position--] = '9';
+    }
+    --result[position];
+    return result.size() > 1 && result[0] == '0' ? result.substr(1) : result;
+}
+
+static ByteBuffer ToBuffer(const Aws::String& value)
+{
+    return ByteBuffer(reinterpret_cast<const unsigned char*>(value.c_str()), value.size());
+}
+
+static Aws::String FromBuffer(const ByteBuffer& buffer)
+{
+    return Aws::String(reinterpret_cast<const char*>(buffer.GetUnderlyingData()), buffer.GetLength());
+}
+
+/**
+ * A stream of two shards, one per half of the hash key space, that can be split into four. Records put are unpacked and kept by the shard they
+ * landed on. Shards are listed two per page.
+ */
+class MockKinesisClient : public KinesisClient
+{
+public:
+    MockKinesisClient() : KinesisClient(Aws::Auth::AWSCredentials("", "")),
+        m_failListShards(false), m_failRecords(0), m_listShardsCalls(0), m_putRecordsCalls(0), m_recordsSent(0), m_misplacedRecords(0), m_split(false),
+        m_sequenceNumber(0)
+    {
+    }
+
+    void SplitShards() { std::lock_guard<std::mutex> locker(m_lock); m_split = true; }
+
+    /**
+     * The next count Kinesis records sent fail with errorCode.
+     */
+    void FailRecords(int count, const Aws::String& errorCode)
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_failRecords = count;
+        m_recordErrorCode = errorCode;
+    }
+
+    ListShardsOutcome ListShards(const ListShardsRequest& request) const override
+    {
+        if (m_failListShards)
+        {
+            return ListShardsOutcome(Aws::Client::AWSError<KinesisErrors>(KinesisErrors::ACCESS_DENIED, "AccessDeniedException", "Not allowed", false));
+        }
+        EXPECT_NE(request.StreamNameHasBeenSet(), request.NextTokenHasBeenSet());
+        if (!request.NextTokenHasBeenSet())
+        {
+            ++m_listShardsCalls;
+        }
+
+        std::lock_guard<std::mutex> locker(m_lock);
+        Aws::Vector<Shard> shards;
+        shards.push_back(BuildShard(0, HASH_KEY_QUARTERS[0], Predecessor(HASH_KEY_QUARTERS[2]), m_split));
+        shards.push_back(BuildShard(1, HASH_KEY_QUARTERS[2], MAX_HASH_KEY, m_split));
+        if (m_split)
+        {
+            for (int quarter = 0; quarter < 4; ++quarter)
+            {
+                shards.push_back(BuildShard(quarter + 2, HASH_KEY_QUARTERS[quarter], quarter < 3 ? Predecessor(HASH_KEY_QUARTERS[quarter + 1]) : MAX_HASH_KEY, false));
+            }
+        }
+
+        size_t first = request.NextTokenHasBeenSet() ? static_cast<size_t>(StringUtils::ConvertToInt32(request.GetNextToken().c_str())) : 0;
+        ListShardsResult result;
+        for (size_t i = first; i < first + 2 && i < shards.size(); ++i)
+        {
+            result.AddShards(shards[i]);
+        }
+        if (first + 2 < shards.size())
+        {
+            result.SetNextToken(StringUtils::to_string(first + 2));
+        }
+        return result;
+    }
+
+    PutRecordsOutcome PutRecords(const PutRecordsRequest& request) const override
+    {
+        ++m_putRecordsCalls;
+        EXPECT_EQ(STREAM_NAME, request.GetStreamName());
+        std::lock_guard<std::mutex> locker(m_lock);
+        PutRecordsResult result;
+        int failed = 0;
+        for (const auto& record : request.GetRecords())
+        {
+            ++m_recordsSent;
+            PutRecordsResultEntry resultEntry;
+            if (m_failRecords > 0)
+            {
+                --m_failRecords;
+                ++failed;
+                result.AddRecords(resultEntry.WithErrorCode(m_recordErrorCode).WithErrorMessage("Failed by the test"));
+                continue;
+            }
+
+            Aws::String shardId = FindShard(record.GetExplicitHashKey().empty() ? HashPartitionKey(record.GetPartitionKey()) : record.GetExplicitHashKey());
+            Aws::Vector<UserRecord> userRecords;
+            if (!Deaggregate(record.GetData(), userRecords))
+            {
+                UserRecord userRecord;
+                userRecord.partitionKey = record.GetPartitionKey();
+                userRecord.data = record.GetData();
+                userRecords.push_back(userRecord);
+            }
+            for (const auto& userRecord : userRecords)
+            {
+                m_misplacedRecords += FindShard(HashPartitionKey(userRecord.partitionKey)) != shardId ? 1 : 0;
+                m_received.push_back(FromBuffer(userRecord.data));
+            }
+            resultEntry.SetShardId(shardId);
+            resultEntry.SetSequenceNumber(StringUtils::to_string(++m_sequenceNumber));
+            result.AddRecords(resultEntry);
+        }
+        result.SetFailedRecordCount(failed);
+        return result;
+    }
+
+    Aws::Vector<Aws::String> GetReceived() const { std::lock_guard<std::mutex> locker(m_lock); return m_received; }
+
+    std::atomic<bool> m_failListShards;
+    mutable int m_failRecords;
+    Aws::String m_recordErrorCode;
+    mutable std::atomic<int> m_listShardsCalls;
+    mutable std::atomic<int> m_putRecordsCalls;
+    mutable int m_recordsSent;
+    mutable int m_misplacedRecords;
+
+private:
+    static Shard BuildShard(int index, const Aws::String& startingHashKey, const Aws::String& endingHashKey, bool closed)
+    {
+        Shard shard;
+        shard.SetShardId("shardId-00000000000" + StringUtils::to_string(index));
+        shard.SetHashKeyRange(HashKeyRange().WithStartingHashKey(startingHashKey).WithEndingHashKey(endingHashKey));
+        SequenceNumberRange sequenceNumbers;
+        sequenceNumbers.SetStartingSequenceNumber("1");
+        if (closed)
+        {
+            sequenceNumbers.SetEndingSequenceNumber("100");
+        }
+        shard.SetSequenceNumberRange(sequenceNumbers);
+        return shard;
+    }
+
+    /**
+     * The hash key of a partition key, in decimal.
+     */
+    static Aws::String HashPartitionKey(const Aws::String& partitionKey)
+    {
+        ByteBuffer md5 = HashingUtils::CalculateMD5(partitionKey);
+        Aws::Vector<unsigned> digits(1, 0);
+        for (size_t i = 0; i < md5.GetLength(); ++i)
+        {
+            unsigned carry = md5[i];
+            for (auto& digit : digits)
+            {
+                unsigned value = digit * 256 + carry;
+                digit = value % 10;
+                carry = value / 10;
+            }
+            for (; carry > 0; carry /= 10)
+            {
+                digits.push_back(carry % 10);
+            }
+        }
+        Aws::String decimal;
+        for (auto digit = digits.rbegin(); digit != digits.rend(); ++digit)
+        {
+            decimal.push_back(static_cast<char>('0' + *digit));
+        }
+        return decimal;
+    }
+
+    Aws::String FindShard(const Aws::String& hashKey) const
+    {
+        int half = DecimalLess(hashKey, HASH_KEY_QUARTERS[2]) ? 0 : 1;
+        if (!m_split)
+        {
+            return "shardId-00000000000" + StringUtils::to_string(half);
+        }
+        int quarter = 3;
+        while (DecimalLess(hashKey, HASH_KEY_QUARTERS[quarter]))
+        {
+            --quarter;
+        }
+        return "shardId-00000000000" + StringUtils::to_string(quarter + 2);
+    }
+
+    mutable std::mutex m_lock;
+    mutable Aws::Vector<Aws::String> m_received;
+    bool m_split;
+    mutable long m_sequenceNumber;
+};
+
+class KinesisProducerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_mockClient = Aws::MakeShared<MockKinesisClient>(ALLOC_TAG);
+        m_config.kinesisClient = m_mockClient;
+        m_config.streamName = STREAM_NAME;
+        // long enough that records in these tests are only sent when a request fills up or on a flush, unless a test shortens it
+        m_config.recordMaxBufferedTime = std::chrono::seconds(10);
+        m_config.retryBaseDelayMs = 1;
+    }
+
+    /**
+     * Adds count user records, "record-<n>" with one of keyCount partition keys, and collects their outcomes.
+     */
+    void AddRecords(KinesisProducer& producer, int first, int count, int keyCount)
+    {
+        for (int i = first; i < first + count; ++i)
+        {
+            producer.AddUserRecord("key-" + StringUtils::to_string(i % keyCount), ToBuffer("record-" + StringUtils::to_string(i)),
+                [this](const UserRecordOutcome& outcome)
+                {
+                    std::lock_guard<std::mutex> locker(m_outcomesLock);
+                    m_outcomes.push_back(outcome);
+                });
+        }
+    }
+
+    Aws::Vector<UserRecordOutcome> GetOutcomes()
+    {
+        std::lock_guard<std::mutex> locker(m_outcomesLock);
+        return m_outcomes;
+    }
+
+    static void ExpectEachRecordOnce(const Aws::Vector<Aws::String>& received, int count)
+    {
+        Aws::Set<Aws::String> unique(received.begin(), received.end());
+        ASSERT_EQ(static_cast<size_t>(count), received.size());
+        ASSERT_EQ(static_cast<size_t>(count), unique.size());
+        for (int i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(1u, unique.count("record-" + StringUtils::to_string(i)));
+        }
+    }
+
+    std::shared_ptr<MockKinesisClient> m_mockClient;
+    KinesisProducerConfiguration m_config;
+    std::mutex m_outcomesLock;
+    Aws::Vector<UserRecordOutcome> m_outcomes;
+};
+
+TEST_F(KinesisProducerTest, TestAggregatedRecordRoundTrip)
+{
+    Aws::Vector<UserRecord> userRecords(3);
+    userRecords[0].partitionKey = "first";
+    userRecords[0].data = ToBuffer("one");
+    userRecords[1].partitionKey = "second";
+    userRecords[1].explicitHashKey = HASH_KEY_QUARTERS[1];
+    userRecords[1].data = ToBuffer(Aws::String(300, 'x'));
+    userRecords[2].partitionKey = "first";
+    userRecords[2].data = ToBuffer("");
+
+    RecordAggregator aggregator;
+    for (const auto& userRecord : userRecords)
+    {
+        size_t expectedSize = aggregator.GetSizeWith(userRecord);
+        aggregator.Add(userRecord);
+        ASSERT_EQ(expectedSize, aggregator.GetSize());
+    }
+    ASSERT_EQ(3u, aggregator.GetRecordCount());
+    ASSERT_EQ("first", aggregator.GetPartitionKey());
+    size_t size = aggregator.GetSize();
+    ByteBuffer data = aggregator.Build();
+    ASSERT_EQ(size, data.GetLength() + strlen("first"));
+    ASSERT_EQ(0u, aggregator.GetRecordCount());
+
+    Aws::Vector<UserRecord> unpacked;
+    ASSERT_TRUE(Deaggregate(data, unpacked));
+    ASSERT_EQ(3u, unpacked.size());
+    for (size_t i = 0; i < unpacked.size(); ++i)
+    {
+        ASSERT_EQ(userRecords[i].partitionKey, unpacked[i].partitionKey);
+        ASSERT_EQ(userRecords[i].explicitHashKey, unpacked[i].explicitHashKey);
+        ASSERT_EQ(userRecords[i].data, unpacked[i].data);
+    }
+
+    // a changed byte no longer matches the MD5, and plain data is not an aggregated record
+    data[10] ^= 1;
+    ASSERT_FALSE(Deaggregate(data, unpacked));
+    ASSERT_FALSE(Deaggregate(ToBuffer("plain record data"), unpacked));
+    ASSERT_EQ(3u, unpacked.size());
+}
+
+TEST_F(KinesisProducerTest, TestRecordsAreAggregatedByShardAndBatched)
+{
+    m_config.maxAggregatedRecordSize = 4096;
+    const int recordCount = 2000;
+    {
+        KinesisProducer producer(m_config);
+        AddRecords(producer, 0, recordCount, 200);
+        producer.FlushSync();
+        ASSERT_EQ(0u, producer.GetOutstandingRecordCount());
+    }
+
+    auto outcomes = GetOutcomes();
+    ASSERT_EQ(static_cast<size_t>(recordCount), outcomes.size());
+    Aws::Set<Aws::String> positions;
+    for (const auto& outcome : outcomes)
+    {
+        ASSERT_TRUE(outcome.IsSuccess());
+        ASSERT_EQ(1u, outcome.GetResult().attempts);
+        positions.insert(outcome.GetResult().sequenceNumber + "." + StringUtils::to_string(outcome.GetResult().subSequenceNumber));
+    }
+    ASSERT_EQ(static_cast<size_t>(recordCount), positions.size());
+
+    // about 30KB of user records in 4KB aggregates for two shards: a few Kinesis records, all in one PutRecords call
+    ASSERT_EQ(1, m_mockClient->m_putRecordsCalls.load());
+    ASSERT_GT(m_mockClient->m_recordsSent, 2);
+    ASSERT_LT(m_mockClient->m_recordsSent, 20);
+    ASSERT_EQ(1, m_mockClient->m_listShardsCalls.load());
+    ASSERT_EQ(0, m_mockClient->m_misplacedRecords);
+    ExpectEachRecordOnce(m_mockClient->GetReceived(), recordCount);
+}
+
+TEST_F(KinesisProducerTest, TestRecordsAreSentAfterMaxBufferedTime)
+{
+    m_config.recordMaxBufferedTime = std::chrono::milliseconds(20);
+    KinesisProducer producer(m_config);
+    AddRecords(producer, 0, 10, 10);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    ASSERT_EQ(10u, GetOutcomes().size());
+    ASSERT_EQ(0u, producer.GetOutstandingRecordCount());
+    ExpectEachRecordOnce(m_mockClient->GetReceived(), 10);
+}
+
+TEST_F(KinesisProducerTest, TestOnlyFailedRecordsAreSentAgain)
+{
+    m_config.aggregationEnabled = false;
+    m_mockClient->FailRecords(5, "ProvisionedThroughputExceededException");
+    {
+        KinesisProducer producer(m_config);
+        AddRecords(producer, 0, 20, 20);
+        producer.FlushSync();
+    }
+
+    auto outcomes = GetOutcomes();
+    ASSERT_EQ(20u, outcomes.size());
+    size_t retried = 0;
+    for (const auto& outcome : outcomes)
+    {
+        ASSERT_TRUE(outcome.IsSuccess());
+        ASSERT_EQ(0u, outcome.GetResult().subSequenceNumber);
+        retried += outcome.GetResult().attempts == 2 ? 1 : 0;
+    }
+    ASSERT_EQ(5u, retried);
+    // retries fall due at slightly different times, so they may take more than one call
+    ASSERT_GE(m_mockClient->m_putRecordsCalls.load(), 2);
+    ASSERT_EQ(25, m_mockClient->m_recordsSent);
+    ExpectEachRecordOnce(m_mockClient->GetReceived(), 20);
+}
+
+TEST_F(KinesisProducerTest, TestRecordsFailOnFinalErrors)
+{
+    m_config.maxRetries = 2;
+    KinesisProducer producer(m_config);
+
+    m_mockClient->FailRecords(1000, "KMSAccessDeniedException");
+    AddRecords(producer, 0, 10, 10);
+    producer.FlushSync();
+    auto outcomes = GetOutcomes();
+    ASSERT_EQ(10u, outcomes.size());
+    for (const auto& outcome : outcomes)
+    {
+        ASSERT_FALSE(outcome.IsSuccess());
+        ASSERT_EQ(KinesisErrors::K_M_S_ACCESS_DENIED, outcome.GetError().GetErrorType());
+    }
+    int sent = m_mockClient->m_recordsSent;
+
+    // retryable errors fail the records once they have been sent maxRetries more times
+    m_mockClient->FailRecords(1000, "ProvisionedThroughputExceededException");
+    AddRecords(producer, 10, 1, 10);
+    producer.FlushSync();
+    outcomes = GetOutcomes();
+    ASSERT_EQ(11u, outcomes.size());
+    ASSERT_EQ(KinesisErrors::PROVISIONED_THROUGHPUT_EXCEEDED, outcomes.back().GetError().GetErrorType());
+    ASSERT_EQ(sent + 3, m_mockClient->m_recordsSent);
+
+    UserRecord noPartitionKey;
+    noPartitionKey.data = ToBuffer("data");
+    bool rejected = false;
+    producer.AddUserRecord(std::move(noPartitionKey), [&rejected](const UserRecordOutcome& outcome)
+    {
+        rejected = !outcome.IsSuccess() && outcome.GetError().GetErrorType() == KinesisErrors::INVALID_ARGUMENT;
+    });
+    ASSERT_TRUE(rejected);
+    ASSERT_EQ(0u, producer.GetOutstandingRecordCount());
+}
+
+TEST_F(KinesisProducerTest, TestCallbacksCanAddRecordsWhenTheBufferIsFull)
+{
+    m_config.aggregationEnabled = false;
+    m_config.recordMaxBufferedTime = std::chrono::milliseconds(10);
+    m_config.maxBufferedBytes = strlen("key-0") + strlen("record-0");
+    m_mockClient->FailRecords(1, "KMSAccessDeniedException");
+    KinesisProducer producer(m_config);
+
+    std::atomic<int> attempts(0);
+    std::atomic<bool> putAgain(false);
+    UserRecordCallback onResult = [&](const UserRecordOutcome& outcome)
+    {
+        ++attempts;
+        if (!outcome.IsSuccess())
+        {
+            // the record failing is the one filling the buffer
+            producer.AddUserRecord("key-0", ToBuffer("record-0"), [&](const UserRecordOutcome& retried) { putAgain = retried.IsSuccess(); });
+        }
+    };
+    producer.AddUserRecord("key-0", ToBuffer("record-0"), onResult);
+    producer.FlushSync();
+
+    ASSERT_EQ(1, attempts.load());
+    ASSERT_TRUE(putAgain);
+    ASSERT_EQ(0u, producer.GetOutstandingRecordCount());
+    ExpectEachRecordOnce(m_mockClient->GetReceived(), 1);
+}
+
+TEST_F(KinesisProducerTest, TestShardsAreListedAgainAfterASplit)
+{
+    m_config.maxAggregatedRecordSize = 4096;
+    KinesisProducer producer(m_config);
+    AddRecords(producer, 0, 400, 100);
+    producer.FlushSync();
+    ASSERT_EQ(1, m_mockClient->m_listShardsCalls.load());
+    ASSERT_EQ(0, m_mockClient->m_misplacedRecords);
+
+    // aggregates built for the two old shards land on the quarters their first records hash to, and take others with them
+    m_mockClient->SplitShards();
+    AddRecords(producer, 400, 400, 100);
+    producer.FlushSync();
+    int misplaced = m_mockClient->m_misplacedRecords;
+    ASSERT_GT(misplaced, 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    ASSERT_EQ(2, m_mockClient->m_listShardsCalls.load());
+    AddRecords(producer, 800, 400, 100);
+    producer.FlushSync();
+    ASSERT_EQ(misplaced, m_mockClient->m_misplacedRecords);
+    ASSERT_EQ(2, m_mockClient->m_listShardsCalls.load());
+
+    for (const auto& outcome : GetOutcomes())
+    {
+        ASSERT_TRUE(outcome.IsSuccess());
+    }
+    ExpectEachRecordOnce(m_mockClient->GetReceived(), 1200);
+}
+
+TEST_F(KinesisProducerTest, TestRecordsAreNotAggregatedWithoutShards)
+{
+    m_mockClient->m_failListShards = true;
+    {
+        KinesisProducer producer(m_config);
+        AddRecords(producer, 0, 50, 5);
+        producer.FlushSync();
+    }
+
+    auto outcomes = GetOutcomes();
+    ASSERT_EQ(50u, outcomes.size());
+    for (const auto& outcome : outcomes)
+    {
+        ASSERT_TRUE(outcome.IsSuccess());
+    }
+    ASSERT_EQ(50, m_mockClient->m_recordsSent);
+    ASSERT_EQ(1, m_mockClient->m_putRecordsCalls.load());
+    ExpectEachRecordOnce(m_mockClient->GetReceived(), 50);
+}
@@ -0,0 +1,102 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#pragma once
+
+#include <aws/kinesis-streams/KinesisStreams_EXPORTS.h>
+#include <aws/core/utils/Array.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSString.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <cstdint>
+
+namespace Aws
+{
+    namespace KinesisStreams
+    {
+        /**
+         * A record as the application puts it, before aggregation, or as it gets it back after deaggregation.
+         */
+        struct UserRecord
+        {
+            Aws::String partitionKey;
+            /**
+             * Decimal 128 bit hash key that picks the shard in place of the hash of the partition key. Empty if not set.
+             */
+            Aws::String explicitHashKey;
+            Aws::Utils::ByteBuffer data;
+        };
+
+        /**
+         * Packs user records into the data of a single Kinesis record, in the aggregated record format of the Kinesis Producer Library, which
+         * the Kinesis Client Library and Deaggregate unpack again: a 4 byte magic number, the records as an AggregatedRecord protobuf
+         * message, and the MD5 of that message.
+         *
+         * The Kinesis record is sent with the partition key of the first user record added. All the user records must map to the same shard,
+         * or readers of the shard they end up in will see records that belong to another.
+         */
+        class AWS_KINESIS_STREAMS_API RecordAggregator
+        {
+        public:
+            RecordAggregator();
+
+            /**
+             * Size the Kinesis record would count against the stream's limits, its data plus its partition key, with record added.
+             */
+            size_t GetSizeWith(const UserRecord& record) const;
+
+            void Add(const UserRecord& record);
+
+            inline size_t GetRecordCount() const { return m_recordCount; }
+
+            /**
+             * Size the Kinesis record counts against the stream's limits, its data plus its partition key.
+             */
+            size_t GetSize() const;
+
+            /**
+             * Partition key the Kinesis record is sent with.
+             */
+            inline const Aws::String& GetPartitionKey() const { return m_partitionKey; }
+
+            /**
+             * Builds the data of the Kinesis record and empties the aggregator.
+             */
+            Aws::Utils::ByteBuffer Build();
+
+            void Clear();
+
+        private:
+            size_t GetMessageSizeWith(const UserRecord& record) const;
+
+            Aws::String m_partitionKey;
+            Aws::Map<Aws::String, uint64_t> m_partitionKeyIndexes;
+            Aws::Map<Aws::String, uint64_t> m_explicitHashKeyIndexes;
+            /// The encoded partition key table, explicit hash key table and records fields of the message
+            Aws::String m_partitionKeyTable;
+            Aws::String m_explicitHashKeyTable;
+            Aws::String m_records;
+            size_t m_recordCount;
+        };
+
+        /**
+         * Unpacks the user records of a Kinesis record made by RecordAggregator or the Kinesis Producer Library and appends them to records.
+         * Returns false and leaves records alone if data is not an aggregated record, or is one whose MD5 does not match; such data is a
+         * single user record, sent as is.
+         */
+        AWS_KINESIS_STREAMS_API bool Deaggregate(const Aws::Utils::ByteBuffer& data, Aws::Vector<UserRecord>& records);
+    }
+}
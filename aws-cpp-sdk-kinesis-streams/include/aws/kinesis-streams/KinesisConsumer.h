@@ -0,0 +1,276 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#pragma once
+
+#include <aws/kinesis-streams/KinesisStreams_EXPORTS.h>
+#include <aws/kinesis/KinesisClient.h>
+#include <aws/kinesis/KinesisErrors.h>
+#include <aws/kinesis/model/GetRecordsResult.h>
+#include <aws/kinesis/model/Shard.h>
+#include <aws/kinesis/model/ShardIteratorType.h>
+#include <aws/core/client/AWSError.h>
+#include <aws/core/utils/Array.h>
+#include <aws/core/utils/DateTime.h>
+#include <aws/core/utils/Outcome.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSString.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+#include <aws/core/utils/threading/Executor.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Aws
+{
+    namespace KinesisStreams
+    {
+        /**
+         * Checkpoint a shard is given once all of its records have been handled.
+         */
+        AWS_KINESIS_STREAMS_API extern const char SHARD_END_CHECKPOINT[];
+
+        /**
+         * Stores how far each shard has been handled, so that a consumer started again carries on from there.
+         */
+        class AWS_KINESIS_STREAMS_API Checkpointer
+        {
+        public:
+            virtual ~Checkpointer() = default;
+
+            /**
+             * Gets the sequence number of the last record handled from the shard, or SHARD_END_CHECKPOINT. Returns false if the shard has
+             * no checkpoint.
+             */
+            virtual bool GetCheckpoint(const Aws::String& shardId, Aws::String& sequenceNumber) = 0;
+
+            /**
+             * Called after every batch handled, and with SHARD_END_CHECKPOINT once the shard is closed and fully handled. Implementations
+             * that write to remote storage may keep only the latest sequence number and write it now and then; records handled after the
+             * last checkpoint written are handled again after a restart.
+             */
+            virtual void Checkpoint(const Aws::String& shardId, const Aws::String& sequenceNumber) = 0;
+        };
+
+        /**
+         * Keeps checkpoints for the life of the process only.
+         */
+        class AWS_KINESIS_STREAMS_API InMemoryCheckpointer : public Checkpointer
+        {
+        public:
+            bool GetCheckpoint(const Aws::String& shardId, Aws::String& sequenceNumber) override;
+            void Checkpoint(const Aws::String& shardId, const Aws::String& sequenceNumber) override;
+
+        private:
+            std::mutex m_lock;
+            Aws::Map<Aws::String, Aws::String> m_checkpoints;
+        };
+
+        /**
+         * A user record read from a shard, unpacked from its aggregated record if it was sent in one.
+         */
+        struct ConsumedRecord
+        {
+            Aws::String sequenceNumber;
+            /**
+             * Position of the user record within its aggregated record; 0 for a record that was not aggregated.
+             */
+            size_t subSequenceNumber = 0;
+            Aws::String partitionKey;
+            Aws::String explicitHashKey;
+            Aws::Utils::ByteBuffer data;
+            Aws::Utils::DateTime approximateArrivalTimestamp;
+        };
+
+        /**
+         * The records of one GetRecords call.
+         */
+        struct RecordBatch
+        {
+            Aws::String shardId;
+            Aws::Vector<ConsumedRecord> records;
+            /**
+             * How far the last record of the batch is behind the tip of the shard.
+             */
+            long long millisBehindLatest = 0;
+        };
+
+        typedef std::function<void(const RecordBatch&)> RecordBatchHandler;
+
+        /**
+         * Where reading starts in a shard that has no checkpoint.
+         */
+        enum class InitialPosition
+        {
+            /// Only records put after the consumer started
+            LATEST,
+            /// The oldest record the stream still holds
+            TRIM_HORIZON
+        };
+
+        /**
+         * Configuration for use with KinesisConsumer. The data here will be copied directly to the consumer.
+         */
+        struct KinesisConsumerConfiguration
+        {
+            KinesisConsumerConfiguration() : initialPosition(InitialPosition::LATEST), maxRecordsPerFetch(10000), minPollInterval(std::chrono::milliseconds(200)),
+                maxPollInterval(std::chrono::milliseconds(1000)), shardSyncInterval(std::chrono::seconds(60))
+            {
+            }
+
+            /**
+             * Kinesis client used for the ListShards, GetShardIterator and GetRecords calls. You are responsible for setting this.
+             * GetShardIterator and GetRecords calls are made with the Async methods, so they run on the executor of the client's configuration.
+             */
+            std::shared_ptr<Aws::Kinesis::KinesisClient> kinesisClient;
+            /**
+             * Stream the records are read from. You are responsible for setting this.
+             */
+            Aws::String streamName;
+            /**
+             * Called with every non-empty batch read. You are responsible for setting this. Batches of a shard are handled one at a time, in
+             * order; batches of different shards are handled concurrently.
+             */
+            RecordBatchHandler handler;
+            /**
+             * Where progress through each shard is kept. Defaults to an InMemoryCheckpointer.
+             */
+            std::shared_ptr<Checkpointer> checkpointer;
+            /**
+             * Executor the handler and the checkpointer run on, shared by the readers of all shards. Defaults to a PooledThreadExecutor of
+             * 4 threads.
+             */
+            std::shared_ptr<Aws::Utils::Threading::Executor> executor;
+            /**
+             * Where reading starts in a shard that has no checkpoint and whose parents, if any, were not read. Defaults to LATEST.
+             */
+            InitialPosition initialPosition;
+            /**
+             * Most records asked for in one GetRecords call. Defaults to 10000, which is also the service limit.
+             */
+            int maxRecordsPerFetch;
+            /**
+             * Time between GetRecords calls on a shard while it is behind. Defaults to 200ms, which keeps a reader within the limit of five
+             * reads per second per shard.
+             */
+            std::chrono::milliseconds minPollInterval;
+            /**
+             * Time between GetRecords calls on a shard that has nothing to read, which the interval doubles towards from minPollInterval.
+             * Defaults to 1 second.
+             */
+            std::chrono::milliseconds maxPollInterval;
+            /**
+             * Time between two listings of the shards, to find new ones. Shards are also listed whenever a shard ends. Defaults to 60 seconds.
+             */
+            std::chrono::milliseconds shardSyncInterval;
+        };
+
+        /**
+         * Reads every shard of a Kinesis stream and hands the records to a handler, in the manner of the Kinesis Client Library.
+         *
+         * The shards are listed with ListShards. A shard created by a split or merge is only read once its parents have been read to the end,
+         * so the records of a partition key are handled in order across resharding. Instead of a thread blocked in GetRecords for each shard,
+         * one thread schedules the GetRecords calls of all shards, which run on the client's executor, and the batches they return are
+         * handled on a shared executor. The next GetRecords call of a shard is made while its current batch is being handled, so one batch
+         * per shard is read ahead. A shard is polled every minPollInterval while it is behind, and less often, down to every maxPollInterval,
+         * while it has nothing to read or reads are throttled.
+         *
+         * Aggregated records are unpacked into their user records. Progress is checkpointed after each batch; the records of a batch may be
+         * handled again after a restart if the consumer stops before its checkpoint. One consumer reads all of the stream's shards: sharing
+         * a stream's shards between several consumers is left to the application.
+         *
+         * The consumer starts reading when constructed. The destructor waits for the batches being handled to complete; batches read ahead
+         * are dropped, and read again from the checkpoints the next time.
+         */
+        class AWS_KINESIS_STREAMS_API KinesisConsumer
+        {
+        public:
+            KinesisConsumer(const KinesisConsumerConfiguration& config);
+
+            ~KinesisConsumer();
+
+            KinesisConsumer(const KinesisConsumer&) = delete;
+            KinesisConsumer& operator=(const KinesisConsumer&) = delete;
+
+            inline const KinesisConsumerConfiguration& GetConfig() const { return m_config; }
+
+        private:
+            enum class ShardStatus
+            {
+                /// Waiting for its parents to be read to the end
+                WAITING,
+                READING,
+                FINISHED
+            };
+
+            struct ShardReader
+            {
+                Aws::Kinesis::Model::Shard shard;
+                ShardStatus status = ShardStatus::WAITING;
+                /// Whether records were read from the shard, now or before a restart, so that its children are read from their start
+                bool read = false;
+                /// Where the first iterator starts if no record has been read yet
+                Aws::Kinesis::Model::ShardIteratorType startingPosition = Aws::Kinesis::Model::ShardIteratorType::TRIM_HORIZON;
+                /// Last record read, or the checkpoint reading started from; a new iterator starts after it
+                Aws::String lastSequenceNumber;
+                /// Empty until an iterator is got, or after it expired
+                Aws::String iterator;
+                /// The shard is closed and all of its records have been read
+                bool ended = false;
+                bool fetching = false;
+                /// A batch, or the end of the shard, is being handled
+                bool processing = false;
+                /// Batch read ahead, waiting for the one being handled
+                std::shared_ptr<Aws::Kinesis::Model::GetRecordsResult> pending;
+                std::chrono::milliseconds pollInterval;
+                std::chrono::steady_clock::time_point nextFetch;
+            };
+
+            bool ListShards(Aws::Vector<Aws::Kinesis::Model::Shard>& shards) const;
+            void SyncShards(std::unique_lock<std::mutex>& locker);
+            void StartReadyShards();
+
+            void Fetch(const Aws::String& shardId, ShardReader& reader);
+            void OnShardIteratorOutcome(const Aws::String& shardId, const Aws::Kinesis::Model::GetShardIteratorOutcome& outcome);
+            void OnGetRecordsOutcome(const Aws::String& shardId, const Aws::Kinesis::Model::GetRecordsOutcome& outcome);
+            void BackOff(ShardReader& reader, const Aws::Client::AWSError<Aws::Kinesis::KinesisErrors>& error);
+
+            bool SubmitTask(ShardReader& reader, std::function<void()>&& task);
+            void ProcessBatch(const Aws::String& shardId, const Aws::Kinesis::Model::GetRecordsResult& batch);
+            void EndShard(const Aws::String& shardId);
+            void PollLoop();
+
+            KinesisConsumerConfiguration m_config;
+            std::shared_ptr<Aws::Kinesis::KinesisClient> m_client;
+
+            mutable std::mutex m_lock;
+            /// Wakes the poll thread, and the destructor while it waits for calls and tasks to complete
+            std::condition_variable m_signal;
+
+            Aws::Map<Aws::String, ShardReader> m_shards;
+            std::chrono::steady_clock::time_point m_nextShardSync;
+            bool m_shardSyncRequested;
+            size_t m_callsInFlight;
+            size_t m_tasksRunning;
+            bool m_shutdown;
+
+            std::thread m_pollThread;
+        };
+    }
+}
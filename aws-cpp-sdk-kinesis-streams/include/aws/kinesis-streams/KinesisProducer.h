@@ -0,0 +1,284 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#pragma once
+
+#include <aws/kinesis-streams/KinesisStreams_EXPORTS.h>
+#include <aws/kinesis-streams/AggregatedRecord.h>
+#include <aws/kinesis/KinesisClient.h>
+#include <aws/kinesis/KinesisErrors.h>
+#include <aws/kinesis/model/PutRecordsRequest.h>
+#include <aws/kinesis/model/PutRecordsRequestEntry.h>
+#include <aws/core/client/AWSError.h>
+#include <aws/core/utils/Outcome.h>
+#include <aws/core/utils/memory/stl/AWSDeque.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSString.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Aws
+{
+    namespace KinesisStreams
+    {
+        /**
+         * Configuration for use with KinesisProducer. The data here will be copied directly to the producer.
+         */
+        struct KinesisProducerConfiguration
+        {
+            KinesisProducerConfiguration() : aggregationEnabled(true), maxAggregatedRecordSize(50 * 1024), maxRecordsPerRequest(500),
+                maxRequestSize(5 * 1024 * 1024), recordMaxBufferedTime(std::chrono::milliseconds(100)), maxRequestsInFlight(8),
+                maxBufferedBytes(64 * 1024 * 1024), retryBaseDelayMs(100), maxRetries(8)
+            {
+            }
+
+            /**
+             * Kinesis client used for the ListShards and PutRecords calls. You are responsible for setting this.
+             * PutRecords calls are made with PutRecordsAsync, so they run on the executor of the client's configuration.
+             */
+            std::shared_ptr<Aws::Kinesis::KinesisClient> kinesisClient;
+            /**
+             * Stream the records are put to. You are responsible for setting this.
+             */
+            Aws::String streamName;
+            /**
+             * Whether user records bound for the same shard are packed into aggregated records. Defaults to true.
+             */
+            bool aggregationEnabled;
+            /**
+             * Largest aggregated record, data and partition key, that user records are packed into. Defaults to 50KB; at most 1MB.
+             */
+            size_t maxAggregatedRecordSize;
+            /**
+             * Most Kinesis records sent in one PutRecords call. Defaults to 500, which is also the service limit.
+             */
+            size_t maxRecordsPerRequest;
+            /**
+             * Most bytes, data and partition keys, sent in one PutRecords call. Defaults to 5MB, which is also the service limit.
+             */
+            size_t maxRequestSize;
+            /**
+             * How long a user record waits for others to be aggregated and batched with before it is sent anyway. Defaults to 100ms.
+             */
+            std::chrono::milliseconds recordMaxBufferedTime;
+            /**
+             * Most PutRecords calls in flight at once. Defaults to 8.
+             */
+            size_t maxRequestsInFlight;
+            /**
+             * AddUserRecord blocks while user records of this many bytes, data and partition keys, have not completed yet. Defaults to 64MB.
+             */
+            size_t maxBufferedBytes;
+            /**
+             * Delay before a failed Kinesis record is sent again. It doubles with each attempt. Defaults to 100ms.
+             */
+            long retryBaseDelayMs;
+            /**
+             * Number of times a Kinesis record that failed with a retryable error is sent again before its user records fail. Defaults to 8.
+             */
+            unsigned maxRetries;
+        };
+
+        /**
+         * Where a user record was put.
+         */
+        struct UserRecordResult
+        {
+            Aws::String shardId;
+            Aws::String sequenceNumber;
+            /**
+             * Position of the user record within its aggregated record; 0 for a user record that was sent on its own.
+             */
+            size_t subSequenceNumber = 0;
+            /**
+             * Number of PutRecords calls the user record was sent in.
+             */
+            unsigned attempts = 0;
+        };
+
+        typedef Aws::Utils::Outcome<UserRecordResult, Aws::Client::AWSError<Aws::Kinesis::KinesisErrors>> UserRecordOutcome;
+        typedef std::function<void(const UserRecordOutcome&)> UserRecordCallback;
+
+        /**
+         * Puts user records to a Kinesis stream with as few PutRecords calls as it can, in the manner of the Kinesis Producer Library.
+         *
+         * The shards of the stream are listed with ListShards, so that the shard each user record hashes to can be predicted. User records
+         * bound for the same shard are packed into aggregated records of up to maxAggregatedRecordSize, and aggregated records for any shard
+         * share PutRecords calls of up to maxRecordsPerRequest records and maxRequestSize bytes. A user record is sent at the latest
+         * recordMaxBufferedTime after it was added, and up to maxRequestsInFlight calls run at once. Only the Kinesis records a call failed
+         * to put are sent again, with exponential backoff. When a record lands on another shard than predicted, as it does after a shard
+         * split or merge, the shards are listed again. Until the shards are known, or while they can't be listed, user records are sent
+         * without aggregation.
+         *
+         * Readers get the user records back out of aggregated records with Deaggregate, or with the Kinesis Client Library. Retries can put
+         * user records out of order, and a PutRecords call that fails after reaching the stream can put records twice.
+         *
+         * The destructor sends all buffered records and waits for them to complete.
+         */
+        class AWS_KINESIS_STREAMS_API KinesisProducer
+        {
+        public:
+            KinesisProducer(const KinesisProducerConfiguration& config);
+
+            ~KinesisProducer();
+
+            KinesisProducer(const KinesisProducer&) = delete;
+            KinesisProducer& operator=(const KinesisProducer&) = delete;
+
+            /**
+             * Buffers the user record to be put. onResult is called once it has been put or has failed, on one of the client executor's
+             * threads, or on the calling thread for a record that can't be put at all: one without a partition key, with an explicit hash key
+             * that isn't a 128 bit decimal, or larger than 1MB. onResult may add records itself, for instance to put a failed one again. Blocks
+             * while maxBufferedBytes of user records are outstanding.
+             */
+            void AddUserRecord(UserRecord&& record, const UserRecordCallback& onResult = nullptr);
+            void AddUserRecord(const Aws::String& partitionKey, const Aws::Utils::ByteBuffer& data, const UserRecordCallback& onResult = nullptr);
+
+            /**
+             * Sends all buffered records now instead of waiting for recordMaxBufferedTime to pass. Does not wait for the results.
+             */
+            void Flush();
+
+            /**
+             * Sends all buffered records now and waits until every user record added so far, and any added meanwhile, has completed.
+             */
+            void FlushSync();
+
+            /**
+             * Number of user records added that have not completed yet.
+             */
+            size_t GetOutstandingRecordCount() const;
+
+            inline const KinesisProducerConfiguration& GetConfig() const { return m_config; }
+
+        private:
+            /// A 128 bit hash key, as the stream maps partition keys to shards with
+            struct HashKey
+            {
+                uint64_t high = 0;
+                uint64_t low = 0;
+
+                inline bool operator<(const HashKey& other) const { return high < other.high || (high == other.high && low < other.low); }
+
+                static HashKey FromPartitionKey(const Aws::String& partitionKey);
+                /// Reads a decimal hash key; false if it isn't one, or is 2^128 or more
+                static bool FromDecimal(const Aws::String& decimal, HashKey& hashKey);
+                Aws::String ToDecimal() const;
+            };
+
+            struct ShardRange
+            {
+                HashKey startingHashKey;
+                HashKey endingHashKey;
+                Aws::String shardId;
+            };
+
+            struct PendingRecord
+            {
+                UserRecordCallback onResult;
+                size_t size;
+            };
+
+            /// One Kinesis record of a PutRecords call, holding one user record or an aggregate of several. The record moves into the
+            /// request while it is sent, and is taken back from the request if it has to be sent again
+            struct Entry
+            {
+                Aws::Kinesis::Model::PutRecordsRequestEntry record;
+                Aws::Vector<PendingRecord> userRecords;
+                size_t size = 0;
+                /// Shard the record is expected to land on, and the shard map that was predicted with; empty without a shard map
+                Aws::String predictedShardId;
+                unsigned shardMapVersion = 0;
+                /// When the record has to be sent by, or when it is to be sent again after a failure
+                std::chrono::steady_clock::time_point sendBy;
+                unsigned attempts = 0;
+            };
+
+            /// User records waiting to be aggregated for a shard. The first user record is kept as is until a second one joins it, so
+            /// that a user record with nothing to aggregate with is sent on its own
+            struct ShardBuffer
+            {
+                UserRecord firstRecord;
+                HashKey firstHashKey;
+                RecordAggregator aggregator;
+                Aws::Vector<PendingRecord> userRecords;
+                size_t size = 0;
+                std::chrono::steady_clock::time_point sendBy;
+            };
+
+            struct UnroutedRecord
+            {
+                UserRecord record;
+                HashKey hashKey;
+                PendingRecord pending;
+            };
+
+            typedef Aws::Vector<std::pair<PendingRecord, UserRecordOutcome>> Results;
+
+            void Route(UserRecord&& record, const HashKey& hashKey, PendingRecord&& pending);
+            void AddToReady(Entry&& entry);
+            void CloseShardBuffer(const Aws::String& shardId, ShardBuffer& buffer);
+            const ShardRange* FindShard(const HashKey& hashKey) const;
+            bool ListShards(Aws::Vector<ShardRange>& shards) const;
+            void RefreshShardMap(std::unique_lock<std::mutex>& locker);
+
+            void SendBatch(const std::shared_ptr<Aws::Vector<Entry>>& batch);
+            void OnPutRecordsOutcome(const std::shared_ptr<Aws::Vector<Entry>>& batch, const Aws::Kinesis::Model::PutRecordsRequest& request,
+                                     const Aws::Kinesis::Model::PutRecordsOutcome& outcome);
+            void RetryOrFail(Entry&& entry, const Aws::Client::AWSError<Aws::Kinesis::KinesisErrors>& error, Results& results);
+            void FlushLoop();
+
+            KinesisProducerConfiguration m_config;
+            std::shared_ptr<Aws::Kinesis::KinesisClient> m_client;
+
+            mutable std::mutex m_lock;
+            /// Wakes the flush thread
+            std::condition_variable m_flushSignal;
+            /// Wakes callers of AddUserRecord and FlushSync as records complete
+            std::condition_variable m_completedSignal;
+
+            /// Open shards of the stream, by starting hash key; empty until they are listed, or while they can't be
+            Aws::Vector<ShardRange> m_shards;
+            unsigned m_shardMapVersion;
+            bool m_shardMapLoaded;
+            bool m_shardMapStale;
+            std::chrono::steady_clock::time_point m_shardMapListedAt;
+            /// Records added before the shards were first listed
+            Aws::Vector<UnroutedRecord> m_unrouted;
+
+            Aws::Map<Aws::String, ShardBuffer> m_shardBuffers;
+            /// Kinesis records waiting to be sent, and the bytes they add up to
+            Aws::Deque<Entry> m_ready;
+            size_t m_readyBytes;
+            /// Kinesis records waiting to be sent again after a failure
+            Aws::Vector<Entry> m_retries;
+            size_t m_requestsInFlight;
+            size_t m_outstandingRecords;
+            size_t m_outstandingBytes;
+            bool m_flushRequested;
+            bool m_shutdown;
+            /// When the flush thread wakes up next if nothing wakes it sooner; records due before then wake it
+            std::chrono::steady_clock::time_point m_flushWakeUp;
+
+            std::thread m_flushThread;
+        };
+    }
+}
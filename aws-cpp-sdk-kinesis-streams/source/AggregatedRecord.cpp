@@ -0,0 +1,361 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/kinesis-streams/AggregatedRecord.h>
+#include <aws/core/utils/HashingUtils.h>
+
+#include <cstring>
+
+using namespace Aws::Utils;
+
+namespace Aws
+{
+    namespace KinesisStreams
+    {
+        static const unsigned char AGGREGATED_RECORD_MAGIC[] = { 0xF3, 0x89, 0x9A, 0xC2 };
+        static const size_t MAGIC_SIZE = sizeof(AGGREGATED_RECORD_MAGIC);
+        static const size_t MD5_SIZE = 16;
+
+        // protobuf keys, (field number << 3) | wire type, of the AggregatedRecord and Record messages
+        static const unsigned char PARTITION_KEY_TABLE_KEY = (1 << 3) | 2;
+        static const unsigned char EXPLICIT_HASH_KEY_TABLE_KEY = (2 << 3) | 2;
+        static const unsigned char RECORDS_KEY = (3 << 3) | 2;
+        static const unsigned char PARTITION_KEY_INDEX_KEY = (1 << 3) | 0;
+        static const unsigned char EXPLICIT_HASH_KEY_INDEX_KEY = (2 << 3) | 0;
+        static const unsigned char DATA_KEY = (3 << 3) | 2;
+
+        static const unsigned WIRE_TYPE_VARINT = 0;
+        static const unsigned WIRE_TYPE_FIXED64 = 1;
+        static const unsigned WIRE_TYPE_LENGTH_DELIMITED = 2;
+        static const unsigned WIRE_TYPE_FIXED32 = 5;
+
+        static size_t GetVarintSize(uint64_t value)
+        {
+            size_t size = 1;
+            while (value >= 0x80)
+            {
+                value >>= 7;
+                ++size;
+            }
+            return size;
+        }
+
+        static void AppendVarint(Aws::String& out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        /**
+         * Size of a length delimited field, key included, whose content is length bytes long.
+         */
+        static size_t GetFieldSize(size_t length)
+        {
+            return 1 + GetVarintSize(length) + length;
+        }
+
+        static void AppendField(Aws::String& out, unsigned char key, const char* content, size_t length)
+        {
+            out.push_back(static_cast<char>(key));
+            AppendVarint(out, length);
+            out.append(content, length);
+        }
+
+        /**
+         * Index of key in the table, and whether it has to be added.
+         */
+        static uint64_t GetTableIndex(const Aws::Map<Aws::String, uint64_t>& indexes, const Aws::String& key, bool& added)
+        {
+            auto index = indexes.find(key);
+            added = index == indexes.end();
+            return added ? indexes.size() : index->second;
+        }
+
+        static size_t GetRecordMessageSize(uint64_t partitionKeyIndex, bool hasExplicitHashKey, uint64_t explicitHashKeyIndex, size_t dataLength)
+        {
+            size_t size = 1 + GetVarintSize(partitionKeyIndex) + GetFieldSize(dataLength);
+            if (hasExplicitHashKey)
+            {
+                size += 1 + GetVarintSize(explicitHashKeyIndex);
+            }
+            return size;
+        }
+
+        RecordAggregator::RecordAggregator() : m_recordCount(0)
+        {
+        }
+
+        size_t RecordAggregator::GetMessageSizeWith(const UserRecord& record) const
+        {
+            size_t size = m_partitionKeyTable.size() + m_explicitHashKeyTable.size() + m_records.size();
+            bool added = false;
+            uint64_t partitionKeyIndex = GetTableIndex(m_partitionKeyIndexes, record.partitionKey, added);
+            if (added)
+            {
+                size += GetFieldSize(record.partitionKey.size());
+            }
+            bool hasExplicitHashKey = !record.explicitHashKey.empty();
+            uint64_t explicitHashKeyIndex = 0;
+            if (hasExplicitHashKey)
+            {
+                explicitHashKeyIndex = GetTableIndex(m_explicitHashKeyIndexes, record.explicitHashKey, added);
+                if (added)
+                {
+                    size += GetFieldSize(record.explicitHashKey.size());
+                }
+            }
+            return size + GetFieldSize(GetRecordMessageSize(partitionKeyIndex, hasExplicitHashKey, explicitHashKeyIndex, record.data.GetLength()));
+        }
+
+        size_t RecordAggregator::GetSizeWith(const UserRecord& record) const
+        {
+            return MAGIC_SIZE + GetMessageSizeWith(record) + MD5_SIZE + (m_recordCount == 0 ? record.partitionKey : m_partitionKey).size();
+        }
+
+        size_t RecordAggregator::GetSize() const
+        {
+            return MAGIC_SIZE + m_partitionKeyTable.size() + m_explicitHashKeyTable.size() + m_records.size() + MD5_SIZE + m_partitionKey.size();
+        }
+
+        void RecordAggregator::Add(const UserRecord& record)
+        {
+            bool added = false;
+            uint64_t partitionKeyIndex = GetTableIndex(m_partitionKeyIndexes, record.partitionKey, added);
+            if (m_recordCount == 0)
+            {
+                m_partitionKey = record.partitionKey;
+            }
+            if (added)
+            {
+                m_partitionKeyIndexes[record.partitionKey] = partitionKeyIndex;
+                AppendField(m_partitionKeyTable, PARTITION_KEY_TABLE_KEY, record.partitionKey.c_str(), record.partitionKey.size());
+            }
+            bool hasExplicitHashKey = !record.explicitHashKey.empty();
+            uint64_t explicitHashKeyIndex = 0;
+            if (hasExplicitHashKey)
+            {
+                explicitHashKeyIndex = GetTableIndex(m_explicitHashKeyIndexes, record.explicitHashKey, added);
+                if (added)
+                {
+                    m_explicitHashKeyIndexes[record.explicitHashKey] = explicitHashKeyIndex;
+                    AppendField(m_explicitHashKeyTable, EXPLICIT_HASH_KEY_TABLE_KEY, record.explicitHashKey.c_str(), record.explicitHashKey.size());
+                }
+            }
+
+            size_t dataLength = record.data.GetLength();
+            m_records.push_back(static_cast<char>(RECORDS_KEY));
+            AppendVarint(m_records, GetRecordMessageSize(partitionKeyIndex, hasExplicitHashKey, explicitHashKeyIndex, dataLength));
+            m_records.push_back(static_cast<char>(PARTITION_KEY_INDEX_KEY));
+            AppendVarint(m_records, partitionKeyIndex);
+            if (hasExplicitHashKey)
+            {
+                m_records.push_back(static_cast<char>(EXPLICIT_HASH_KEY_INDEX_KEY));
+                AppendVarint(m_records, explicitHashKeyIndex);
+            }
+            AppendField(m_records, DATA_KEY, reinterpret_cast<const char*>(record.data.GetUnderlyingData()), dataLength);
+            ++m_recordCount;
+        }
+
+        ByteBuffer RecordAggregator::Build()
+        {
+            Aws::String message;
+            message.reserve(m_partitionKeyTable.size() + m_explicitHashKeyTable.size() + m_records.size());
+            message.append(m_partitionKeyTable).append(m_explicitHashKeyTable).append(m_records);
+            ByteBuffer md5 = HashingUtils::CalculateMD5(message);
+
+            ByteBuffer data(MAGIC_SIZE + message.size() + MD5_SIZE);
+            memcpy(data.GetUnderlyingData(), AGGREGATED_RECORD_MAGIC, MAGIC_SIZE);
+            memcpy(data.GetUnderlyingData() + MAGIC_SIZE, message.c_str(), message.size());
+            memcpy(data.GetUnderlyingData() + MAGIC_SIZE + message.size(), md5.GetUnderlyingData(), MD5_SIZE);
+            Clear();
+            return data;
+        }
+
+        void RecordAggregator::Clear()
+        {
+            m_partitionKey.clear();
+            m_partitionKeyIndexes.clear();
+            m_explicitHashKeyIndexes.clear();
+            m_partitionKeyTable.clear();
+            m_explicitHashKeyTable.clear();
+            m_records.clear();
+            m_recordCount = 0;
+        }
+
+        static bool ReadVarint(const unsigned char*& position, const unsigned char* end, uint64_t& value)
+        {
+            value = 0;
+            for (unsigned shift = 0; shift < 64 && position < end; shift += 7)
+            {
+                unsigned char byte = *position++;
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Reads the next field: its key, and its value if it is a varint, or its length and content if it is length delimited. Fixed size
+         * fields are skipped over.
+         */
+        static bool ReadField(const unsigned char*& position, const unsigned char* end, uint64_t& key, uint64_t& value, const unsigned char*& content)
+        {
+            if (!ReadVarint(position, end, key))
+            {
+                return false;
+            }
+            content = position;
+            value = 0;
+            switch (key & 0x7)
+            {
+                case WIRE_TYPE_VARINT:
+                    return ReadVarint(position, end, value);
+                case WIRE_TYPE_FIXED64:
+                    if (end - position < 8)
+                    {
+                        return false;
+                    }
+                    position += 8;
+                    return true;
+                case WIRE_TYPE_LENGTH_DELIMITED:
+                    if (!ReadVarint(position, end, value) || value > static_cast<uint64_t>(end - position))
+                    {
+                        return false;
+                    }
+                    content = position;
+                    position += value;
+                    return true;
+                case WIRE_TYPE_FIXED32:
+                    if (end - position < 4)
+                    {
+                        return false;
+                    }
+                    position += 4;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool Deaggregate(const ByteBuffer& data, Aws::Vector<UserRecord>& records)
+        {
+            size_t dataLength = data.GetLength();
+            if (dataLength < MAGIC_SIZE + MD5_SIZE || memcmp(data.GetUnderlyingData(), AGGREGATED_RECORD_MAGIC, MAGIC_SIZE) != 0)
+            {
+                return false;
+            }
+            const unsigned char* position = data.GetUnderlyingData() + MAGIC_SIZE;
+            const unsigned char* end = data.GetUnderlyingData() + dataLength - MD5_SIZE;
+            ByteBuffer md5 = HashingUtils::CalculateMD5(Aws::String(reinterpret_cast<const char*>(position), end - position));
+            if (memcmp(md5.GetUnderlyingData(), end, MD5_SIZE) != 0)
+            {
+                return false;
+            }
+
+            Aws::Vector<Aws::String> partitionKeys;
+            Aws::Vector<Aws::String> explicitHashKeys;
+            // records refer to the tables by index, and the tables may come after them
+            Aws::Vector<uint64_t> partitionKeyIndexes;
+            Aws::Vector<uint64_t> explicitHashKeyIndexes;
+            Aws::Vector<UserRecord> userRecords;
+            while (position < end)
+            {
+                uint64_t key = 0;
+                uint64_t length = 0;
+                const unsigned char* content = nullptr;
+                if (!ReadField(position, end, key, length, content))
+                {
+                    return false;
+                }
+                if (key == PARTITION_KEY_TABLE_KEY)
+                {
+                    partitionKeys.emplace_back(reinterpret_cast<const char*>(content), static_cast<size_t>(length));
+                }
+                else if (key == EXPLICIT_HASH_KEY_TABLE_KEY)
+                {
+                    explicitHashKeys.emplace_back(reinterpret_cast<const char*>(content), static_cast<size_t>(length));
+                }
+                else if (key == RECORDS_KEY)
+                {
+                    uint64_t partitionKeyIndex = 0;
+                    uint64_t explicitHashKeyIndex = UINT64_MAX;
+                    bool hasPartitionKeyIndex = false;
+                    bool hasData = false;
+                    UserRecord userRecord;
+                    const unsigned char* recordPosition = content;
+                    const unsigned char* recordEnd = content + length;
+                    while (recordPosition < recordEnd)
+                    {
+                        uint64_t recordKey = 0;
+                        uint64_t value = 0;
+                        const unsigned char* fieldContent = nullptr;
+                        if (!ReadField(recordPosition, recordEnd, recordKey, value, fieldContent))
+                        {
+                            return false;
+                        }
+                        if (recordKey == PARTITION_KEY_INDEX_KEY)
+                        {
+                            partitionKeyIndex = value;
+                            hasPartitionKeyIndex = true;
+                        }
+                        else if (recordKey == EXPLICIT_HASH_KEY_INDEX_KEY)
+                        {
+                            explicitHashKeyIndex = value;
+                        }
+                        else if (recordKey == DATA_KEY)
+                        {
+                            userRecord.data = ByteBuffer(fieldContent, static_cast<size_t>(value));
+                            hasData = true;
+                        }
+                    }
+                    if (!hasPartitionKeyIndex || !hasData)
+                    {
+                        return false;
+                    }
+                    partitionKeyIndexes.push_back(partitionKeyIndex);
+                    explicitHashKeyIndexes.push_back(explicitHashKeyIndex);
+                    userRecords.push_back(std::move(userRecord));
+                }
+            }
+
+            for (size_t i = 0; i < userRecords.size(); ++i)
+            {
+                if (partitionKeyIndexes[i] >= partitionKeys.size() ||
+                    (explicitHashKeyIndexes[i] != UINT64_MAX && explicitHashKeyIndexes[i] >= explicitHashKeys.size()))
+                {
+                    return false;
+                }
+                userRecords[i].partitionKey = partitionKeys[static_cast<size_t>(partitionKeyIndexes[i])];
+                if (explicitHashKeyIndexes[i] != UINT64_MAX)
+                {
+                    userRecords[i].explicitHashKey = explicitHashKeys[static_cast<size_t>(explicitHashKeyIndexes[i])];
+                }
+            }
+            records.reserve(records.size() + userRecords.size());
+            for (auto& userRecord : userRecords)
+            {
+                records.push_back(std::move(userRecord));
+            }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,475 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/kinesis-streams/KinesisConsumer.h>
+#include <aws/kinesis-streams/AggregatedRecord.h>
+#include <aws/kinesis/model/GetRecordsRequest.h>
+#include <aws/kinesis/model/GetShardIteratorRequest.h>
+#include <aws/kinesis/model/ListShardsRequest.h>
+#include <aws/core/utils/logging/LogMacros.h>
+#include <aws/core/utils/memory/stl/AWSSet.h>
+
+#include <algorithm>
+
+using namespace Aws::Kinesis;
+using namespace Aws::Kinesis::Model;
+using namespace Aws::Utils;
+
+namespace Aws
+{
+    namespace KinesisStreams
+    {
+        static const char* CLASS_TAG = "KinesisConsumer";
+
+        static const size_t DEFAULT_EXECUTOR_THREADS = 4;
+        /// Time before a failed listing of the shards is tried again
+        static const std::chrono::seconds SHARD_SYNC_RETRY_INTERVAL(1);
+
+        const char SHARD_END_CHECKPOINT[] = "SHARD_END";
+
+        bool InMemoryCheckpointer::GetCheckpoint(const Aws::String& shardId, Aws::String& sequenceNumber)
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            auto checkpoint = m_checkpoints.find(shardId);
+            if (checkpoint == m_checkpoints.end())
+            {
+                return false;
+            }
+            sequenceNumber = checkpoint->second;
+            return true;
+        }
+
+        void InMemoryCheckpointer::Checkpoint(const Aws::String& shardId, const Aws::String& sequenceNumber)
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_checkpoints[shardId] = sequenceNumber;
+        }
+
+        KinesisConsumer::KinesisConsumer(const KinesisConsumerConfiguration& config) :
+            m_config(config),
+            m_client(config.kinesisClient),
+            m_nextShardSync(std::chrono::steady_clock::time_point::min()),
+            m_shardSyncRequested(false),
+            m_callsInFlight(0),
+            m_tasksRunning(0),
+            m_shutdown(false)
+        {
+            if (!m_config.checkpointer)
+            {
+                m_config.checkpointer = Aws::MakeShared<InMemoryCheckpointer>(CLASS_TAG);
+            }
+            if (!m_config.executor)
+            {
+                m_config.executor = Aws::MakeShared<Threading::PooledThreadExecutor>(CLASS_TAG, DEFAULT_EXECUTOR_THREADS);
+            }
+            m_config.maxRecordsPerFetch = (std::max)(1, m_config.maxRecordsPerFetch);
+            m_config.maxPollInterval = (std::max)(m_config.minPollInterval, m_config.maxPollInterval);
+            m_pollThread = std::thread(&KinesisConsumer::PollLoop, this);
+        }
+
+        KinesisConsumer::~KinesisConsumer()
+        {
+            {
+                std::lock_guard<std::mutex> locker(m_lock);
+                m_shutdown = true;
+            }
+            m_signal.notify_all();
+            m_pollThread.join();
+        }
+
+        bool KinesisConsumer::ListShards(Aws::Vector<Shard>& shards) const
+        {
+            ListShardsRequest request;
+            request.SetStreamName(m_config.streamName);
+            for (;;)
+            {
+                auto outcome = m_client->ListShards(request);
+                if (!outcome.IsSuccess())
+                {
+                    AWS_LOGSTREAM_WARN(CLASS_TAG, "Failed to list the shards of stream " << m_config.streamName << ". "
+                            << outcome.GetError().GetExceptionName() << ": " << outcome.GetError().GetMessage());
+                    return false;
+                }
+                shards.insert(shards.end(), outcome.GetResult().GetShards().begin(), outcome.GetResult().GetShards().end());
+                if (outcome.GetResult().GetNextToken().empty())
+                {
+                    return true;
+                }
+                // pages after the first are asked for by token alone
+                request = ListShardsRequest();
+                request.SetNextToken(outcome.GetResult().GetNextToken());
+            }
+        }
+
+        void KinesisConsumer::SyncShards(std::unique_lock<std::mutex>& locker)
+        {
+            m_shardSyncRequested = false;
+            Aws::Set<Aws::String> knownShards;
+            for (const auto& shard : m_shards)
+            {
+                knownShards.insert(shard.first);
+            }
+
+            // the checkpointer may well be remote storage, so new shards are looked up without holding the lock
+            locker.unlock();
+            Aws::Vector<Shard> shards;
+            bool listed = ListShards(shards);
+            Aws::Vector<ShardReader> newShards;
+            for (auto& shard : shards)
+            {
+                if (knownShards.count(shard.GetShardId()))
+                {
+                    continue;
+                }
+                ShardReader reader;
+                Aws::String checkpoint;
+                if (m_config.checkpointer->GetCheckpoint(shard.GetShardId(), checkpoint))
+                {
+                    reader.read = true;
+                    if (checkpoint == SHARD_END_CHECKPOINT)
+                    {
+                        reader.status = ShardStatus::FINISHED;
+                    }
+                    else
+                    {
+                        reader.lastSequenceNumber = checkpoint;
+                    }
+                }
+                reader.shard = std::move(shard);
+                newShards.push_back(std::move(reader));
+            }
+            locker.lock();
+
+            auto now = std::chrono::steady_clock::now();
+            if (!listed)
+            {
+                m_nextShardSync = now + SHARD_SYNC_RETRY_INTERVAL;
+                return;
+            }
+            m_nextShardSync = now + m_config.shardSyncInterval;
+            for (auto& reader : newShards)
+            {
+                AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Found shard " << reader.shard.GetShardId() << " of stream " << m_config.streamName
+                        << (reader.lastSequenceNumber.empty() ? "" : " with checkpoint ") << reader.lastSequenceNumber << ".");
+                Aws::String shardId = reader.shard.GetShardId();
+                m_shards.emplace(std::move(shardId), std::move(reader));
+            }
+            StartReadyShards();
+        }
+
+        void KinesisConsumer::StartReadyShards()
+        {
+            auto now = std::chrono::steady_clock::now();
+            // skipping a shard can make its children ready in turn
+            for (bool started = true; started;)
+            {
+                started = false;
+                for (auto& entry : m_shards)
+                {
+                    ShardReader& reader = entry.second;
+                    if (reader.status != ShardStatus::WAITING)
+                    {
+                        continue;
+                    }
+                    bool parentsFinished = true;
+                    bool parentsRead = false;
+                    for (const auto& parentId : { reader.shard.GetParentShardId(), reader.shard.GetAdjacentParentShardId() })
+                    {
+                        // parents that are no longer listed have been trimmed from the stream
+                        auto parent = m_shards.find(parentId);
+                        if (!parentId.empty() && parent != m_shards.end())
+                        {
+                            parentsFinished &= parent->second.status == ShardStatus::FINISHED;
+                            parentsRead |= parent->second.read;
+                        }
+                    }
+                    if (!parentsFinished)
+                    {
+                        continue;
+                    }
+
+                    started = true;
+                    if (reader.lastSequenceNumber.empty())
+                    {
+                        // the records of a shard follow on from those of its parents; without parents read, reading starts at the initial position,
+                        // and a closed shard has nothing to read at the latest record
+                        bool closed = !reader.shard.GetSequenceNumberRange().GetEndingSequenceNumber().empty();
+                        if (!parentsRead && m_config.initialPosition == InitialPosition::LATEST && closed)
+                        {
+                            reader.status = ShardStatus::FINISHED;
+                            continue;
+                        }
+                        reader.startingPosition = parentsRead || m_config.initialPosition == InitialPosition::TRIM_HORIZON ?
+                            ShardIteratorType::TRIM_HORIZON : ShardIteratorType::LATEST;
+                    }
+                    AWS_LOGSTREAM_INFO(CLASS_TAG, "Reading shard " << entry.first << " of stream " << m_config.streamName << ".");
+                    reader.status = ShardStatus::READING;
+                    reader.pollInterval = m_config.minPollInterval;
+                    reader.nextFetch = now;
+                }
+            }
+        }
+
+        void KinesisConsumer::Fetch(const Aws::String& shardId, ShardReader& reader)
+        {
+            reader.fetching = true;
+            ++m_callsInFlight;
+            if (reader.iterator.empty())
+            {
+                GetShardIteratorRequest request;
+                request.SetStreamName(m_config.streamName);
+                request.SetShardId(shardId);
+                if (reader.lastSequenceNumber.empty())
+                {
+                    request.SetShardIteratorType(reader.startingPosition);
+                }
+                else
+                {
+                    request.SetShardIteratorType(ShardIteratorType::AFTER_SEQUENCE_NUMBER);
+                    request.SetStartingSequenceNumber(reader.lastSequenceNumber);
+                }
+                m_client->GetShardIteratorAsync(request, [this, shardId](const KinesisClient*, const GetShardIteratorRequest&, const GetShardIteratorOutcome& outcome,
+                    const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+                {
+                    OnShardIteratorOutcome(shardId, outcome);
+                });
+                return;
+            }
+
+            GetRecordsRequest request;
+            request.SetShardIterator(reader.iterator);
+            request.SetLimit(m_config.maxRecordsPerFetch);
+            m_client->GetRecordsAsync(request, [this, shardId](const KinesisClient*, const GetRecordsRequest&, const GetRecordsOutcome& outcome,
+                const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+            {
+                OnGetRecordsOutcome(shardId, outcome);
+            });
+        }
+
+        void KinesisConsumer::OnShardIteratorOutcome(const Aws::String& shardId, const GetShardIteratorOutcome& outcome)
+        {
+            // the consumer may be destroyed as soon as the lock is released with nothing in flight, so the poll thread is woken while it is held
+            std::lock_guard<std::mutex> locker(m_lock);
+            --m_callsInFlight;
+            ShardReader& reader = m_shards[shardId];
+            reader.fetching = false;
+            if (!outcome.IsSuccess())
+            {
+                BackOff(reader, outcome.GetError());
+            }
+            else if (outcome.GetResult().GetShardIterator().empty())
+            {
+                // a closed shard read up to its last record before a restart
+                reader.ended = true;
+            }
+            else
+            {
+                reader.iterator = outcome.GetResult().GetShardIterator();
+                reader.nextFetch = std::chrono::steady_clock::now();
+            }
+            m_signal.notify_all();
+        }
+
+        void KinesisConsumer::OnGetRecordsOutcome(const Aws::String& shardId, const GetRecordsOutcome& outcome)
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            --m_callsInFlight;
+            ShardReader& reader = m_shards[shardId];
+            reader.fetching = false;
+            if (!outcome.IsSuccess())
+            {
+                if (outcome.GetError().GetErrorType() == KinesisErrors::EXPIRED_ITERATOR)
+                {
+                    AWS_LOGSTREAM_DEBUG(CLASS_TAG, "The iterator of shard " << shardId << " of stream " << m_config.streamName << " expired; getting a new one.");
+                    reader.iterator.clear();
+                    reader.nextFetch = std::chrono::steady_clock::now();
+                }
+                else
+                {
+                    BackOff(reader, outcome.GetError());
+                }
+                m_signal.notify_all();
+                return;
+            }
+
+            const auto& result = outcome.GetResult();
+            reader.iterator = result.GetNextShardIterator();
+            reader.ended = reader.iterator.empty();
+            if (!result.GetRecords().empty())
+            {
+                reader.lastSequenceNumber = result.GetRecords().back().GetSequenceNumber();
+                reader.read = true;
+                reader.pending = Aws::MakeShared<GetRecordsResult>(CLASS_TAG, result);
+            }
+            // a shard that is behind is read as fast as the read limit allows; an idle one is polled less and less often
+            if (!result.GetRecords().empty() && result.GetMillisBehindLatest() > 0)
+            {
+                reader.pollInterval = m_config.minPollInterval;
+            }
+            else if (result.GetRecords().empty())
+            {
+                reader.pollInterval = (std::min)(reader.pollInterval * 2, m_config.maxPollInterval);
+            }
+            reader.nextFetch = std::chrono::steady_clock::now() + reader.pollInterval;
+            m_signal.notify_all();
+        }
+
+        void KinesisConsumer::BackOff(ShardReader& reader, const Aws::Client::AWSError<KinesisErrors>& error)
+        {
+            AWS_LOGSTREAM_WARN(CLASS_TAG, "Reading shard " << reader.shard.GetShardId() << " of stream " << m_config.streamName << " failed; trying again. "
+                    << error.GetExceptionName() << ": " << error.GetMessage());
+            bool throttled = error.GetErrorType() == KinesisErrors::PROVISIONED_THROUGHPUT_EXCEEDED || error.GetErrorType() == KinesisErrors::THROTTLING ||
+                error.GetErrorType() == KinesisErrors::LIMIT_EXCEEDED || error.GetErrorType() == KinesisErrors::K_M_S_THROTTLING;
+            reader.pollInterval = throttled ? (std::min)(reader.pollInterval * 2, m_config.maxPollInterval) : m_config.maxPollInterval;
+            reader.nextFetch = std::chrono::steady_clock::now() + reader.pollInterval;
+        }
+
+        bool KinesisConsumer::SubmitTask(ShardReader& reader, std::function<void()>&& task)
+        {
+            if (!m_config.executor->Submit(std::move(task)))
+            {
+                return false;
+            }
+            reader.processing = true;
+            ++m_tasksRunning;
+            return true;
+        }
+
+        void KinesisConsumer::ProcessBatch(const Aws::String& shardId, const GetRecordsResult& batch)
+        {
+            RecordBatch records;
+            records.shardId = shardId;
+            records.millisBehindLatest = batch.GetMillisBehindLatest();
+            Aws::Vector<UserRecord> userRecords;
+            for (const auto& record : batch.GetRecords())
+            {
+                userRecords.clear();
+                if (!Deaggregate(record.GetData(), userRecords))
+                {
+                    UserRecord userRecord;
+                    userRecord.partitionKey = record.GetPartitionKey();
+                    userRecord.data = record.GetData();
+                    userRecords.push_back(std::move(userRecord));
+                }
+                for (size_t i = 0; i < userRecords.size(); ++i)
+                {
+                    ConsumedRecord consumed;
+                    consumed.sequenceNumber = record.GetSequenceNumber();
+                    consumed.subSequenceNumber = userRecords.size() > 1 ? i : 0;
+                    consumed.partitionKey = std::move(userRecords[i].partitionKey);
+                    consumed.explicitHashKey = std::move(userRecords[i].explicitHashKey);
+                    consumed.data = std::move(userRecords[i].data);
+                    consumed.approximateArrivalTimestamp = record.GetApproximateArrivalTimestamp();
+                    records.records.push_back(std::move(consumed));
+                }
+            }
+            if (!records.records.empty())
+            {
+                m_config.handler(records);
+            }
+            m_config.checkpointer->Checkpoint(shardId, batch.GetRecords().back().GetSequenceNumber());
+
+            std::lock_guard<std::mutex> locker(m_lock);
+            --m_tasksRunning;
+            m_shards[shardId].processing = false;
+            m_signal.notify_all();
+        }
+
+        void KinesisConsumer::EndShard(const Aws::String& shardId)
+        {
+            m_config.checkpointer->Checkpoint(shardId, SHARD_END_CHECKPOINT);
+
+            std::lock_guard<std::mutex> locker(m_lock);
+            --m_tasksRunning;
+            AWS_LOGSTREAM_INFO(CLASS_TAG, "Finished reading shard " << shardId << " of stream " << m_config.streamName << ".");
+            ShardReader& reader = m_shards[shardId];
+            reader.processing = false;
+            reader.status = ShardStatus::FINISHED;
+            reader.read = true;
+            StartReadyShards();
+            // the shards that replaced this one may not have been listed yet
+            m_shardSyncRequested = true;
+            m_signal.notify_all();
+        }
+
+        void KinesisConsumer::PollLoop()
+        {
+            std::unique_lock<std::mutex> locker(m_lock);
+            for (;;)
+            {
+                if (m_shutdown)
+                {
+                    m_signal.wait(locker, [this]() { return m_callsInFlight == 0 && m_tasksRunning == 0; });
+                    return;
+                }
+
+                auto now = std::chrono::steady_clock::now();
+                if (m_shardSyncRequested || now >= m_nextShardSync)
+                {
+                    SyncShards(locker);
+                    continue;
+                }
+
+                auto wakeUp = m_nextShardSync;
+                for (auto& entry : m_shards)
+                {
+                    const Aws::String& shardId = entry.first;
+                    ShardReader& reader = entry.second;
+                    if (reader.status != ShardStatus::READING)
+                    {
+                        continue;
+                    }
+
+                    if (!reader.processing && reader.pending)
+                    {
+                        auto batch = reader.pending;
+                        if (SubmitTask(reader, [this, shardId, batch]() { ProcessBatch(shardId, *batch); }))
+                        {
+                            reader.pending = nullptr;
+                        }
+                        else
+                        {
+                            wakeUp = (std::min)(wakeUp, now + m_config.minPollInterval);
+                        }
+                    }
+                    else if (!reader.processing && reader.ended && !reader.fetching)
+                    {
+                        if (!SubmitTask(reader, [this, shardId]() { EndShard(shardId); }))
+                        {
+                            wakeUp = (std::min)(wakeUp, now + m_config.minPollInterval);
+                        }
+                        continue;
+                    }
+
+                    // the next batch is fetched while the current one is handled, but no further ahead
+                    if (reader.fetching || reader.ended || reader.pending)
+                    {
+                        continue;
+                    }
+                    if (reader.nextFetch <= now)
+                    {
+                        Fetch(shardId, reader);
+                    }
+                    else
+                    {
+                        wakeUp = (std::min)(wakeUp, reader.nextFetch);
+                    }
+                }
+
+                m_signal.wait_until(locker, wakeUp);
+            }
+        }
+    }
+}
@@ -0,0 +1,597 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/kinesis-streams/KinesisProducer.h>
+#include <aws/kinesis/model/ListShardsRequest.h>
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/core/utils/logging/LogMacros.h>
+
+#include <algorithm>
+
+using namespace Aws::Kinesis;
+using namespace Aws::Kinesis::Model;
+using namespace Aws::Utils;
+
+namespace Aws
+{
+    namespace KinesisStreams
+    {
+        static const char* CLASS_TAG = "KinesisProducer";
+
+        /// Most a Kinesis record, data and partition key, may hold
+        static const size_t MAX_RECORD_SIZE = 1024 * 1024;
+        /// Least time between two listings of the shards
+        static const std::chrono::seconds SHARD_MAP_REFRESH_INTERVAL(1);
+
+        static Aws::Client::AWSError<KinesisErrors> BuildRecordError(const Aws::String& errorCode, const Aws::String& errorMessage)
+        {
+            // the errors PutRecords reports for single records; anything else is taken as final
+            if (errorCode == "ProvisionedThroughputExceededException")
+            {
+                return Aws::Client::AWSError<KinesisErrors>(KinesisErrors::PROVISIONED_THROUGHPUT_EXCEEDED, errorCode, errorMessage, true);
+            }
+            if (errorCode == "InternalFailure")
+            {
+                return Aws::Client::AWSError<KinesisErrors>(KinesisErrors::INTERNAL_FAILURE, errorCode, errorMessage, true);
+            }
+            Aws::Client::AWSError<KinesisErrors> error(KinesisErrorMapper::GetErrorForName(errorCode.c_str()));
+            return Aws::Client::AWSError<KinesisErrors>(error.GetErrorType(), errorCode, errorMessage, false);
+        }
+
+        KinesisProducer::HashKey KinesisProducer::HashKey::FromPartitionKey(const Aws::String& partitionKey)
+        {
+            ByteBuffer md5 = HashingUtils::CalculateMD5(partitionKey);
+            HashKey hashKey;
+            for (size_t i = 0; i < 8; ++i)
+            {
+                hashKey.high = (hashKey.high << 8) | md5[i];
+                hashKey.low = (hashKey.low << 8) | md5[i + 8];
+            }
+            return hashKey;
+        }
+
+        bool KinesisProducer::HashKey::FromDecimal(const Aws::String& decimal, HashKey& hashKey)
+        {
+            if (decimal.empty())
+            {
+                return false;
+            }
+            HashKey value;
+            for (char c : decimal)
+            {
+                if (c < '0' || c > '9')
+                {
+                    return false;
+                }
+                // value * 10 + digit, with the low half worked out in 32 bit pieces to catch its carry
+                uint64_t lowerPiece = (value.low & 0xFFFFFFFF) * 10 + static_cast<uint64_t>(c - '0');
+                uint64_t upperPiece = (value.low >> 32) * 10 + (lowerPiece >> 32);
+                uint64_t carry = upperPiece >> 32;
+                if (value.high > (UINT64_MAX - carry) / 10)
+                {
+                    return false;
+                }
+                value.high = value.high * 10 + carry;
+                value.low = (upperPiece << 32) | (lowerPiece & 0xFFFFFFFF);
+            }
+            hashKey = value;
+            return true;
+        }
+
+        Aws::String KinesisProducer::HashKey::ToDecimal() const
+        {
+            uint32_t pieces[4] = { static_cast<uint32_t>(high >> 32), static_cast<uint32_t>(high), static_cast<uint32_t>(low >> 32), static_cast<uint32_t>(low) };
+            Aws::String decimal;
+            bool remaining = true;
+            while (remaining)
+            {
+                uint64_t remainder = 0;
+                remaining = false;
+                for (auto& piece : pieces)
+                {
+                    uint64_t dividend = (remainder << 32) | piece;
+                    piece = static_cast<uint32_t>(dividend / 10);
+                    remainder = dividend % 10;
+                    remaining |= piece != 0;
+                }
+                decimal.push_back(static_cast<char>('0' + remainder));
+            }
+            std::reverse(decimal.begin(), decimal.end());
+            return decimal;
+        }
+
+        KinesisProducer::KinesisProducer(const KinesisProducerConfiguration& config) :
+            m_config(config),
+            m_client(config.kinesisClient),
+            m_shardMapVersion(0),
+            m_shardMapLoaded(false),
+            m_shardMapStale(false),
+            m_readyBytes(0),
+            m_requestsInFlight(0),
+            m_outstandingRecords(0),
+            m_outstandingBytes(0),
+            m_flushRequested(false),
+            m_shutdown(false),
+            m_flushWakeUp(std::chrono::steady_clock::time_point::min())
+        {
+            m_config.maxAggregatedRecordSize = (std::min)(m_config.maxAggregatedRecordSize, MAX_RECORD_SIZE);
+            m_config.maxRecordsPerRequest = (std::max)(static_cast<size_t>(1), m_config.maxRecordsPerRequest);
+            m_config.maxRequestsInFlight = (std::max)(static_cast<size_t>(1), m_config.maxRequestsInFlight);
+            m_flushThread = std::thread(&KinesisProducer::FlushLoop, this);
+        }
+
+        KinesisProducer::~KinesisProducer()
+        {
+            {
+                std::lock_guard<std::mutex> locker(m_lock);
+                m_shutdown = true;
+            }
+            m_flushSignal.notify_all();
+            m_flushThread.join();
+        }
+
+        void KinesisProducer::AddUserRecord(UserRecord&& record, const UserRecordCallback& onResult)
+        {
+            size_t size = record.data.GetLength() + record.partitionKey.size();
+            HashKey hashKey;
+            bool validHashKey = record.explicitHashKey.empty() ? !record.partitionKey.empty() : HashKey::FromDecimal(record.explicitHashKey, hashKey);
+            if (record.partitionKey.empty() || !validHashKey || size > MAX_RECORD_SIZE)
+            {
+                AWS_LOGSTREAM_ERROR(CLASS_TAG, "Rejected a user record for stream " << m_config.streamName << " with partition key [" << record.partitionKey
+                        << "], explicit hash key [" << record.explicitHashKey << "] and " << record.data.GetLength() << " bytes of data.");
+                if (onResult)
+                {
+                    onResult(UserRecordOutcome(Aws::Client::AWSError<KinesisErrors>(KinesisErrors::INVALID_ARGUMENT, "InvalidArgumentException",
+                        "User records need a partition key, an explicit hash key below 2^128 if any, and at most 1MB of data and partition key", false)));
+                }
+                return;
+            }
+            if (record.explicitHashKey.empty())
+            {
+                hashKey = HashKey::FromPartitionKey(record.partitionKey);
+            }
+
+            PendingRecord pending;
+            pending.onResult = onResult;
+            pending.size = size;
+            std::unique_lock<std::mutex> locker(m_lock);
+            m_completedSignal.wait(locker, [this, size]() { return m_outstandingBytes == 0 || m_outstandingBytes + size <= m_config.maxBufferedBytes; });
+            ++m_outstandingRecords;
+            m_outstandingBytes += size;
+            if (!m_shardMapLoaded)
+            {
+                UnroutedRecord unrouted;
+                unrouted.record = std::move(record);
+                unrouted.hashKey = hashKey;
+                unrouted.pending = std::move(pending);
+                m_unrouted.push_back(std::move(unrouted));
+                return;
+            }
+            Route(std::move(record), hashKey, std::move(pending));
+        }
+
+        void KinesisProducer::AddUserRecord(const Aws::String& partitionKey, const ByteBuffer& data, const UserRecordCallback& onResult)
+        {
+            UserRecord record;
+            record.partitionKey = partitionKey;
+            record.data = data;
+            AddUserRecord(std::move(record), onResult);
+        }
+
+        void KinesisProducer::Flush()
+        {
+            {
+                std::lock_guard<std::mutex> locker(m_lock);
+                m_flushRequested = true;
+            }
+            m_flushSignal.notify_one();
+        }
+
+        void KinesisProducer::FlushSync()
+        {
+            Flush();
+            std::unique_lock<std::mutex> locker(m_lock);
+            m_completedSignal.wait(locker, [this]() { return m_outstandingRecords == 0; });
+        }
+
+        size_t KinesisProducer::GetOutstandingRecordCount() const
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            return m_outstandingRecords;
+        }
+
+        void KinesisProducer::Route(UserRecord&& record, const HashKey& hashKey, PendingRecord&& pending)
+        {
+            const ShardRange* shard = m_config.aggregationEnabled ? FindShard(hashKey) : nullptr;
+            if (!shard)
+            {
+                Entry entry;
+                entry.record.SetPartitionKey(std::move(record.partitionKey));
+                if (!record.explicitHashKey.empty())
+                {
+                    entry.record.SetExplicitHashKey(std::move(record.explicitHashKey));
+                }
+                entry.record.SetData(std::move(record.data));
+                entry.size = pending.size;
+                entry.sendBy = std::chrono::steady_clock::now() + m_config.recordMaxBufferedTime;
+                entry.userRecords.push_back(std::move(pending));
+                AddToReady(std::move(entry));
+                return;
+            }
+
+            ShardBuffer& buffer = m_shardBuffers[shard->shardId];
+            if (buffer.userRecords.size() == 1)
+            {
+                buffer.aggregator.Add(buffer.firstRecord);
+            }
+            if (!buffer.userRecords.empty() && buffer.aggregator.GetSizeWith(record) > m_config.maxAggregatedRecordSize)
+            {
+                CloseShardBuffer(shard->shardId, buffer);
+            }
+            if (buffer.userRecords.empty())
+            {
+                buffer.firstHashKey = hashKey;
+                buffer.sendBy = std::chrono::steady_clock::now() + m_config.recordMaxBufferedTime;
+                buffer.firstRecord = std::move(record);
+                if (buffer.sendBy < m_flushWakeUp)
+                {
+                    m_flushSignal.notify_one();
+                }
+            }
+            else
+            {
+                buffer.aggregator.Add(record);
+            }
+            buffer.userRecords.push_back(std::move(pending));
+        }
+
+        void KinesisProducer::CloseShardBuffer(const Aws::String& shardId, ShardBuffer& buffer)
+        {
+            Entry entry;
+            if (buffer.userRecords.size() == 1)
+            {
+                entry.record.SetPartitionKey(std::move(buffer.firstRecord.partitionKey));
+                if (!buffer.firstRecord.explicitHashKey.empty())
+                {
+                    entry.record.SetExplicitHashKey(std::move(buffer.firstRecord.explicitHashKey));
+                }
+                entry.record.SetData(std::move(buffer.firstRecord.data));
+                entry.size = buffer.userRecords.front().size;
+                buffer.aggregator.Clear();
+            }
+            else
+            {
+                // the hash key of the first user record keeps the aggregate on the shard it was built for, whatever its partition key hashes to
+                entry.record.SetPartitionKey(buffer.aggregator.GetPartitionKey());
+                entry.record.SetExplicitHashKey(buffer.firstHashKey.ToDecimal());
+                entry.size = buffer.aggregator.GetSize();
+                entry.record.SetData(buffer.aggregator.Build());
+            }
+            entry.userRecords.swap(buffer.userRecords);
+            entry.predictedShardId = shardId;
+            entry.shardMapVersion = m_shardMapVersion;
+            entry.sendBy = buffer.sendBy;
+            buffer.firstRecord = UserRecord();
+            AddToReady(std::move(entry));
+        }
+
+        void KinesisProducer::AddToReady(Entry&& entry)
+        {
+            bool wakeFlushThread = entry.sendBy < m_flushWakeUp;
+            m_readyBytes += entry.size;
+            m_ready.push_back(std::move(entry));
+            if (wakeFlushThread || m_ready.size() == m_config.maxRecordsPerRequest || m_readyBytes >= m_config.maxRequestSize)
+            {
+                m_flushSignal.notify_one();
+            }
+        }
+
+        const KinesisProducer::ShardRange* KinesisProducer::FindShard(const HashKey& hashKey) const
+        {
+            auto shard = std::upper_bound(m_shards.begin(), m_shards.end(), hashKey,
+                [](const HashKey& key, const ShardRange& range) { return key < range.startingHashKey; });
+            if (shard == m_shards.begin())
+            {
+                return nullptr;
+            }
+            --shard;
+            return shard->endingHashKey < hashKey ? nullptr : &*shard;
+        }
+
+        bool KinesisProducer::ListShards(Aws::Vector<ShardRange>& shards) const
+        {
+            ListShardsRequest request;
+            request.SetStreamName(m_config.streamName);
+            for (;;)
+            {
+                auto outcome = m_client->ListShards(request);
+                if (!outcome.IsSuccess())
+                {
+                    AWS_LOGSTREAM_WARN(CLASS_TAG, "Failed to list the shards of stream " << m_config.streamName << "; records are sent without aggregation until they can be. "
+                            << outcome.GetError().GetExceptionName() << ": " << outcome.GetError().GetMessage());
+                    return false;
+                }
+                for (const auto& shard : outcome.GetResult().GetShards())
+                {
+                    // closed shards keep their hash key ranges, which the shards that replaced them cover now
+                    if (!shard.GetSequenceNumberRange().GetEndingSequenceNumber().empty())
+                    {
+                        continue;
+                    }
+                    ShardRange range;
+                    range.shardId = shard.GetShardId();
+                    if (HashKey::FromDecimal(shard.GetHashKeyRange().GetStartingHashKey(), range.startingHashKey) &&
+                        HashKey::FromDecimal(shard.GetHashKeyRange().GetEndingHashKey(), range.endingHashKey))
+                    {
+                        shards.push_back(std::move(range));
+                    }
+                }
+                if (outcome.GetResult().GetNextToken().empty())
+                {
+                    break;
+                }
+                // pages after the first are asked for by token alone
+                request = ListShardsRequest();
+                request.SetNextToken(outcome.GetResult().GetNextToken());
+            }
+            std::sort(shards.begin(), shards.end(), [](const ShardRange& left, const ShardRange& right) { return left.startingHashKey < right.startingHashKey; });
+            return true;
+        }
+
+        void KinesisProducer::RefreshShardMap(std::unique_lock<std::mutex>& locker)
+        {
+            m_shardMapStale = false;
+            m_shardMapListedAt = std::chrono::steady_clock::now();
+            Aws::Vector<ShardRange> shards;
+            locker.unlock();
+            bool listed = ListShards(shards);
+            locker.lock();
+
+            if (listed)
+            {
+                AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Stream " << m_config.streamName << " has " << shards.size() << " open shards.");
+                m_shards.swap(shards);
+                ++m_shardMapVersion;
+            }
+            else
+            {
+                m_shardMapStale = true;
+            }
+            if (!m_shardMapLoaded)
+            {
+                m_shardMapLoaded = true;
+                for (auto& unrouted : m_unrouted)
+                {
+                    Route(std::move(unrouted.record), unrouted.hashKey, std::move(unrouted.pending));
+                }
+                Aws::Vector<UnroutedRecord>().swap(m_unrouted);
+            }
+        }
+
+        void KinesisProducer::SendBatch(const std::shared_ptr<Aws::Vector<Entry>>& batch)
+        {
+            PutRecordsRequest request;
+            request.SetStreamName(m_config.streamName);
+            for (auto& entry : *batch)
+            {
+                ++entry.attempts;
+                request.AddRecords(std::move(entry.record));
+            }
+            m_client->PutRecordsAsync(request, [this, batch](const KinesisClient*, const PutRecordsRequest& sentRequest, const PutRecordsOutcome& outcome,
+                const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+            {
+                OnPutRecordsOutcome(batch, sentRequest, outcome);
+            });
+        }
+
+        void KinesisProducer::OnPutRecordsOutcome(const std::shared_ptr<Aws::Vector<Entry>>& batch, const PutRecordsRequest& request, const PutRecordsOutcome& outcome)
+        {
+            Results results;
+            {
+                std::lock_guard<std::mutex> locker(m_lock);
+                --m_requestsInFlight;
+                const auto& sentRecords = request.GetRecords();
+                const auto& putRecords = outcome.GetResult().GetRecords();
+                for (size_t i = 0; i < batch->size(); ++i)
+                {
+                    Entry& entry = (*batch)[i];
+                    if (!outcome.IsSuccess() || i >= putRecords.size() || !putRecords[i].GetErrorCode().empty())
+                    {
+                        entry.record = sentRecords[i];
+                        if (!outcome.IsSuccess())
+                        {
+                            RetryOrFail(std::move(entry), outcome.GetError(), results);
+                        }
+                        else if (i >= putRecords.size())
+                        {
+                            RetryOrFail(std::move(entry), Aws::Client::AWSError<KinesisErrors>(KinesisErrors::INTERNAL_FAILURE, "MissingRecordResult",
+                                "PutRecords returned fewer results than records sent", true), results);
+                        }
+                        else
+                        {
+                            RetryOrFail(std::move(entry), BuildRecordError(putRecords[i].GetErrorCode(), putRecords[i].GetErrorMessage()), results);
+                        }
+                        continue;
+                    }
+
+                    const auto& putRecord = putRecords[i];
+                    if (!entry.predictedShardId.empty() && putRecord.GetShardId() != entry.predictedShardId && entry.shardMapVersion == m_shardMapVersion)
+                    {
+                        AWS_LOGSTREAM_DEBUG(CLASS_TAG, "A record for shard " << entry.predictedShardId << " of stream " << m_config.streamName << " went to shard "
+                                << putRecord.GetShardId() << "; listing the shards again.");
+                        m_shardMapStale = true;
+                    }
+                    bool aggregated = entry.userRecords.size() > 1;
+                    for (size_t j = 0; j < entry.userRecords.size(); ++j)
+                    {
+                        UserRecordResult result;
+                        result.shardId = putRecord.GetShardId();
+                        result.sequenceNumber = putRecord.GetSequenceNumber();
+                        result.subSequenceNumber = aggregated ? j : 0;
+                        result.attempts = entry.attempts;
+                        results.emplace_back(std::move(entry.userRecords[j]), UserRecordOutcome(std::move(result)));
+                    }
+                }
+
+                // the bytes are released before the callbacks run, so that a callback can add records without waiting on itself
+                for (const auto& result : results)
+                {
+                    m_outstandingBytes -= result.first.size;
+                }
+                m_completedSignal.notify_all();
+            }
+            m_flushSignal.notify_one();
+
+            for (const auto& result : results)
+            {
+                if (result.first.onResult)
+                {
+                    result.first.onResult(result.second);
+                }
+            }
+
+            // the producer may be destroyed as soon as the lock is released with nothing outstanding
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_outstandingRecords -= results.size();
+            m_completedSignal.notify_all();
+            m_flushSignal.notify_one();
+        }
+
+        void KinesisProducer::RetryOrFail(Entry&& entry, const Aws::Client::AWSError<KinesisErrors>& error, Results& results)
+        {
+            if (error.ShouldRetry() && entry.attempts <= m_config.maxRetries)
+            {
+                AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Putting a record of " << entry.userRecords.size() << " user records to stream " << m_config.streamName
+                        << " failed on attempt " << entry.attempts << "; it will be sent again. " << error.GetExceptionName() << ": " << error.GetMessage());
+                entry.sendBy = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_config.retryBaseDelayMs << (std::min)(entry.attempts - 1, 16u));
+                m_retries.push_back(std::move(entry));
+                return;
+            }
+
+            AWS_LOGSTREAM_ERROR(CLASS_TAG, "Failed to put a record of " << entry.userRecords.size() << " user records to stream " << m_config.streamName
+                    << " after " << entry.attempts << " attempts. " << error.GetExceptionName() << ": " << error.GetMessage());
+            for (auto& pending : entry.userRecords)
+            {
+                results.emplace_back(std::move(pending), UserRecordOutcome(error));
+            }
+        }
+
+        void KinesisProducer::FlushLoop()
+        {
+            std::unique_lock<std::mutex> locker(m_lock);
+            for (;;)
+            {
+                auto now = std::chrono::steady_clock::now();
+                if (!m_shardMapLoaded || (m_shardMapStale && now - m_shardMapListedAt >= SHARD_MAP_REFRESH_INTERVAL))
+                {
+                    RefreshShardMap(locker);
+                    continue;
+                }
+
+                auto wakeUp = std::chrono::steady_clock::time_point::max();
+                if (m_shardMapStale)
+                {
+                    wakeUp = m_shardMapListedAt + SHARD_MAP_REFRESH_INTERVAL;
+                }
+                bool flushing = m_flushRequested || m_shutdown;
+
+                for (auto buffer = m_shardBuffers.begin(); buffer != m_shardBuffers.end();)
+                {
+                    if (buffer->second.sendBy <= now || flushing)
+                    {
+                        CloseShardBuffer(buffer->first, buffer->second);
+                        buffer = m_shardBuffers.erase(buffer);
+                    }
+                    else
+                    {
+                        wakeUp = (std::min)(wakeUp, buffer->second.sendBy);
+                        ++buffer;
+                    }
+                }
+
+                // records sent again go ahead of those waiting for their first attempt
+                for (auto retry = m_retries.begin(); retry != m_retries.end();)
+                {
+                    if (retry->sendBy <= now)
+                    {
+                        m_readyBytes += retry->size;
+                        m_ready.push_front(std::move(*retry));
+                        retry = m_retries.erase(retry);
+                    }
+                    else
+                    {
+                        wakeUp = (std::min)(wakeUp, retry->sendBy);
+                        ++retry;
+                    }
+                }
+
+                Aws::Vector<std::shared_ptr<Aws::Vector<Entry>>> batches;
+                while (m_requestsInFlight < m_config.maxRequestsInFlight && !m_ready.empty())
+                {
+                    if (!flushing && m_ready.front().sendBy > now && m_ready.size() < m_config.maxRecordsPerRequest && m_readyBytes < m_config.maxRequestSize)
+                    {
+                        wakeUp = (std::min)(wakeUp, m_ready.front().sendBy);
+                        break;
+                    }
+
+                    auto batch = Aws::MakeShared<Aws::Vector<Entry>>(CLASS_TAG);
+                    size_t batchBytes = 0;
+                    while (!m_ready.empty() && batch->size() < m_config.maxRecordsPerRequest &&
+                        (batch->empty() || batchBytes + m_ready.front().size <= m_config.maxRequestSize))
+                    {
+                        batchBytes += m_ready.front().size;
+                        m_readyBytes -= m_ready.front().size;
+                        batch->push_back(std::move(m_ready.front()));
+                        m_ready.pop_front();
+                    }
+                    ++m_requestsInFlight;
+                    batches.push_back(batch);
+                }
+
+                if (m_flushRequested && m_shardBuffers.empty() && m_ready.empty())
+                {
+                    m_flushRequested = false;
+                }
+
+                if (!batches.empty())
+                {
+                    locker.unlock();
+                    for (const auto& batch : batches)
+                    {
+                        SendBatch(batch);
+                    }
+                    locker.lock();
+                    continue;
+                }
+
+                if (m_shutdown && m_outstandingRecords == 0)
+                {
+                    return;
+                }
+
+                m_flushWakeUp = wakeUp;
+                if (wakeUp == std::chrono::steady_clock::time_point::max())
+                {
+                    m_flushSignal.wait(locker);
+                }
+                else
+                {
+                    m_flushSignal.wait_until(locker, wakeUp);
+                }
+                m_flushWakeUp = std::chrono::steady_clock::time_point::min();
+            }
+        }
+    }
+}
@@ -0,0 +1,575 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/external/gtest.h>
+#include <aws/queues/sqs/SQSBatchedQueue.h>
+#include <aws/sqs/model/ChangeMessageVisibilityBatchRequest.h>
+#include <aws/sqs/model/ChangeMessageVisibilityBatchResult.h>
+#include <aws/sqs/model/DeleteMessageBatchRequest.h>
+#include <aws/sqs/model/DeleteMessageBatchResult.h>
+#include <aws/sqs/model/GetQueueUrlRequest.h>
+#include <aws/sqs/model/GetQueueUrlResult.h>
+#include <aws/sqs/model/ReceiveMessageRequest.h>
+#include <aws/sqs/model/ReceiveMessageResult.h>
+#include <aws/sqs/model/SendMessageBatchRequest.h>
+#include <aws/sqs/model/SendMessageBatchResult.h>
+#include <aws/core/auth/AWSCredentialsProvider.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/memory/stl/AWSDeque.h>
+#include <aws/core/utils/memory/stl/AWSSet.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+using namespace Aws::Queues::Sqs;
+using namespace Aws::SQS;
+using namespace Aws::SQS::Model;
+using namespace Aws::Utils;
+
+static const char* ALLOC_TAG = "SQSBatchedQueueTest";
+static const char* QUEUE_NAME = "BatchedTestQueue";
+static const char* QUEUE_URL = "https://sqs.us-east-1.amazonaws.com/123456789012/BatchedTestQueue";
+// entries whose receipt handle or body starts with this fail in their batch
+static const char* FAILING_PREFIX = "bad";
+
+static Message BuildMessage(const Aws::String& name)
+{
+    return Message().WithMessageId("id-" + name).WithReceiptHandle(name).WithBody(name);
+}
+
+static bool StartsWith(const Aws::String& value, const char* prefix)
+{
+    return value.compare(0, strlen(prefix), prefix) == 0;
+}
+
+static BatchResultErrorEntry FailedEntry(const Aws::String& id)
+{
+    return BatchResultErrorEntry().WithId(id).WithCode("InternalError").WithMessage("Failed by the test").WithSenderFault(false);
+}
+
+/**
+ * A queue that hands out the messages added to it, and keeps the entries of every batch request made. ReceiveMessage waits up to 100ms for
+ * messages like a short long poll. Batch requests can be held until released, to keep them in flight.
+ */
+class MockSQSClient : public SQSClient
+{
+public:
+    MockSQSClient() : SQSClient(Aws::Auth::AWSCredentials("", "")),
+        m_prefetchCapacity(0), m_requested(0), m_receiveCalls(0), m_holdBatches(false), m_heldBatches(0), m_failBatches(false)
+    {
+    }
+
+    void AddMessages(const Aws::String& prefix, int count)
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        for (int i = 0; i < count; ++i)
+        {
+            m_available.push_back(BuildMessage(prefix + StringUtils::to_string(i)));
+        }
+        m_signal.notify_all();
+    }
+
+    /**
+     * Fails the test if a ReceiveMessage could take the messages received and not yet deleted or made visible again past capacity; 0 turns
+     * the check off.
+     */
+    void ExpectPrefetchBound(size_t capacity) { std::lock_guard<std::mutex> locker(m_lock); m_prefetchCapacity = capacity; }
+
+    /**
+     * Batch requests wait in the client until released.
+     */
+    void HoldBatches() { std::lock_guard<std::mutex> locker(m_lock); m_holdBatches = true; }
+    void ReleaseBatches() { std::lock_guard<std::mutex> locker(m_lock); m_holdBatches = false; m_signal.notify_all(); }
+
+    /**
+     * Whole batch requests fail instead of the entries with FAILING_PREFIX only.
+     */
+    void FailBatches() { std::lock_guard<std::mutex> locker(m_lock); m_failBatches = true; }
+
+    template<typename PREDICATE>
+    bool WaitFor(PREDICATE predicate) const
+    {
+        std::unique_lock<std::mutex> locker(m_lock);
+        return m_signal.wait_for(locker, std::chrono::seconds(5), predicate);
+    }
+
+    GetQueueUrlOutcome GetQueueUrl(const GetQueueUrlRequest& request) const override
+    {
+        EXPECT_EQ(QUEUE_NAME, request.GetQueueName());
+        return GetQueueUrlResult().WithQueueUrl(QUEUE_URL);
+    }
+
+    ReceiveMessageOutcome ReceiveMessage(const ReceiveMessageRequest& request) const override
+    {
+        EXPECT_EQ(QUEUE_URL, request.GetQueueUrl());
+        EXPECT_LE(request.GetMaxNumberOfMessages(), 10);
+        std::unique_lock<std::mutex> locker(m_lock);
+        ++m_receiveCalls;
+        size_t maxMessages = static_cast<size_t>(request.GetMaxNumberOfMessages());
+        if (m_prefetchCapacity > 0)
+        {
+            EXPECT_LE(m_outstanding.size() + m_requested + maxMessages, m_prefetchCapacity);
+        }
+        m_requested += maxMessages;
+        m_signal.wait_for(locker, std::chrono::milliseconds(100), [this]() { return !m_available.empty(); });
+
+        ReceiveMessageResult result;
+        while (!m_available.empty() && result.GetMessages().size() < maxMessages)
+        {
+            result.AddMessages(m_available.front());
+            m_outstanding.insert(m_available.front().GetReceiptHandle());
+            m_available.pop_front();
+        }
+        m_requested -= maxMessages;
+        m_signal.notify_all();
+        return result;
+    }
+
+    DeleteMessageBatchOutcome DeleteMessageBatch(const DeleteMessageBatchRequest& request) const override
+    {
+        EXPECT_EQ(QUEUE_URL, request.GetQueueUrl());
+        std::unique_lock<std::mutex> locker(m_lock);
+        Aws::Vector<Aws::String> handles;
+        for (const auto& entry : request.GetEntries())
+        {
+            handles.push_back(entry.GetReceiptHandle());
+        }
+        m_deleteBatches.push_back(handles);
+        if (HoldBatch(locker))
+        {
+            return DeleteMessageBatchOutcome(Aws::Client::AWSError<SQSErrors>(SQSErrors::SERVICE_UNAVAILABLE, false));
+        }
+
+        DeleteMessageBatchResult result;
+        for (const auto& entry : request.GetEntries())
+        {
+            if (StartsWith(entry.GetReceiptHandle(), FAILING_PREFIX))
+            {
+                result.AddFailed(FailedEntry(entry.GetId()));
+            }
+            else
+            {
+                result.AddSuccessful(DeleteMessageBatchResultEntry().WithId(entry.GetId()));
+                m_outstanding.erase(entry.GetReceiptHandle());
+            }
+        }
+        return result;
+    }
+
+    ChangeMessageVisibilityBatchOutcome ChangeMessageVisibilityBatch(const ChangeMessageVisibilityBatchRequest& request) const override
+    {
+        EXPECT_EQ(QUEUE_URL, request.GetQueueUrl());
+        std::unique_lock<std::mutex> locker(m_lock);
+        Aws::Vector<std::pair<Aws::String, int>> changes;
+        for (const auto& entry : request.GetEntries())
+        {
+            changes.emplace_back(entry.GetReceiptHandle(), entry.GetVisibilityTimeout());
+        }
+        m_visibilityBatches.push_back(changes);
+        if (HoldBatch(locker))
+        {
+            return ChangeMessageVisibilityBatchOutcome(Aws::Client::AWSError<SQSErrors>(SQSErrors::SERVICE_UNAVAILABLE, false));
+        }
+
+        ChangeMessageVisibilityBatchResult result;
+        for (const auto& entry : request.GetEntries())
+        {
+            result.AddSuccessful(ChangeMessageVisibilityBatchResultEntry().WithId(entry.GetId()));
+            if (entry.GetVisibilityTimeout() == 0)
+            {
+                m_outstanding.erase(entry.GetReceiptHandle());
+            }
+        }
+        return result;
+    }
+
+    SendMessageBatchOutcome SendMessageBatch(const SendMessageBatchRequest& request) const override
+    {
+        EXPECT_EQ(QUEUE_URL, request.GetQueueUrl());
+        std::unique_lock<std::mutex> locker(m_lock);
+        Aws::Vector<Aws::String> bodies;
+        for (const auto& entry : request.GetEntries())
+        {
+            bodies.push_back(entry.GetMessageBody());
+        }
+        m_sendBatches.push_back(bodies);
+        if (HoldBatch(locker))
+        {
+            return SendMessageBatchOutcome(Aws::Client::AWSError<SQSErrors>(SQSErrors::SERVICE_UNAVAILABLE, false));
+        }
+
+        SendMessageBatchResult result;
+        for (const auto& entry : request.GetEntries())
+        {
+            if (StartsWith(entry.GetMessageBody(), FAILING_PREFIX))
+            {
+                result.AddFailed(FailedEntry(entry.GetId()));
+            }
+            else
+            {
+                result.AddSuccessful(SendMessageBatchResultEntry().WithId(entry.GetId()).WithMessageId("sent-" + entry.GetId()));
+            }
+        }
+        return result;
+    }
+
+    mutable std::mutex m_lock;
+    mutable std::condition_variable m_signal;
+    mutable Aws::Deque<Message> m_available;
+    size_t m_prefetchCapacity;
+    /// Receipt handles of the messages received and neither deleted nor made visible again
+    mutable Aws::Set<Aws::String> m_outstanding;
+    /// Messages asked for by the ReceiveMessage calls in progress
+    mutable size_t m_requested;
+    mutable size_t m_receiveCalls;
+    mutable Aws::Vector<Aws::Vector<Aws::String>> m_deleteBatches;
+    mutable Aws::Vector<Aws::Vector<std::pair<Aws::String, int>>> m_visibilityBatches;
+    mutable Aws::Vector<Aws::Vector<Aws::String>> m_sendBatches;
+    bool m_holdBatches;
+    mutable size_t m_heldBatches;
+    bool m_failBatches;
+
+private:
+    /**
+     * Waits while batches are held, and returns whether the whole batch fails.
+     */
+    bool HoldBatch(std::unique_lock<std::mutex>& locker) const
+    {
+        ++m_heldBatches;
+        m_signal.notify_all();
+        m_signal.wait(locker, [this]() { return !m_holdBatches; });
+        --m_heldBatches;
+        m_signal.notify_all();
+        return m_failBatches;
+    }
+};
+
+class SQSBatchedQueueTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_mockClient = Aws::MakeShared<MockSQSClient>(ALLOC_TAG);
+        // long enough that only full batches and Flush send anything, unless a test lowers it
+        m_config.batchLinger = std::chrono::seconds(60);
+        m_config.waitTimeSeconds = 1;
+    }
+
+    std::shared_ptr<SQSBatchedQueue> MakeQueue()
+    {
+        auto queue = Aws::MakeShared<SQSBatchedQueue>(ALLOC_TAG, m_mockClient, QUEUE_NAME, 30, m_config);
+        queue->EnsureQueueIsInitialized();
+        EXPECT_TRUE(queue->IsInitialized());
+
+        queue->SetMessageDeleteSuccessEventHandler([this](const Aws::Queues::Queue<Message>*, const Message& message)
+            { Record(m_deleted, message.GetReceiptHandle()); });
+        queue->SetMessageDeleteFailedEventHandler([this](const Aws::Queues::Queue<Message>*, const Message& message)
+            { Record(m_deleteFailed, message.GetReceiptHandle()); });
+        queue->SetMessageSendSuccessEventHandler([this](const Aws::Queues::Queue<Message>*, const Message& message)
+            { Record(m_sent, message.GetBody()); });
+        queue->SetMessageSendFailedEventHandler([this](const Aws::Queues::Queue<Message>*, const Message& message)
+            { Record(m_sendFailed, message.GetBody()); });
+        return queue;
+    }
+
+    void Record(Aws::Set<Aws::String>& names, const Aws::String& name)
+    {
+        std::lock_guard<std::mutex> locker(m_handledLock);
+        names.insert(name);
+        m_handledSignal.notify_all();
+    }
+
+    bool WaitForReceived(size_t count)
+    {
+        std::unique_lock<std::mutex> locker(m_handledLock);
+        return m_handledSignal.wait_for(locker, std::chrono::seconds(5), [this, count]() { return m_received.size() >= count; });
+    }
+
+    Aws::Set<Aws::String> Recorded(const Aws::Set<Aws::String>& names)
+    {
+        std::lock_guard<std::mutex> locker(m_handledLock);
+        return names;
+    }
+
+    static Aws::Set<Aws::String> Names(const Aws::String& prefix, int first, int count)
+    {
+        Aws::Set<Aws::String> names;
+        for (int i = first; i < first + count; ++i)
+        {
+            names.insert(prefix + StringUtils::to_string(i));
+        }
+        return names;
+    }
+
+    std::shared_ptr<MockSQSClient> m_mockClient;
+    SQSBatchedQueueConfiguration m_config;
+    std::mutex m_handledLock;
+    std::condition_variable m_handledSignal;
+    Aws::Set<Aws::String> m_received;
+    Aws::Set<Aws::String> m_deleted;
+    Aws::Set<Aws::String> m_deleteFailed;
+    Aws::Set<Aws::String> m_sent;
+    Aws::Set<Aws::String> m_sendFailed;
+};
+
+TEST_F(SQSBatchedQueueTest, TestFullBatchesOfTenAreSentRightAway)
+{
+    auto queue = MakeQueue();
+    for (int i = 0; i < 25; ++i)
+    {
+        queue->Delete(BuildMessage("delete-" + StringUtils::to_string(i)));
+        queue->ChangeVisibility(BuildMessage("change-" + StringUtils::to_string(i)), 5);
+        queue->Push(BuildMessage("push-" + StringUtils::to_string(i)));
+    }
+
+    // the two full batches of each kind go out without waiting for batchLinger
+    ASSERT_TRUE(m_mockClient->WaitFor([this]()
+    {
+        return m_mockClient->m_deleteBatches.size() == 2 && m_mockClient->m_visibilityBatches.size() == 2 && m_mockClient->m_sendBatches.size() == 2;
+    }));
+
+    queue->Flush();
+    std::lock_guard<std::mutex> locker(m_mockClient->m_lock);
+    ASSERT_EQ(3u, m_mockClient->m_deleteBatches.size());
+    ASSERT_EQ(3u, m_mockClient->m_visibilityBatches.size());
+    ASSERT_EQ(3u, m_mockClient->m_sendBatches.size());
+    for (size_t batch = 0; batch < 3; ++batch)
+    {
+        size_t expectedSize = batch < 2 ? 10 : 5;
+        ASSERT_EQ(expectedSize, m_mockClient->m_deleteBatches[batch].size());
+        ASSERT_EQ(expectedSize, m_mockClient->m_visibilityBatches[batch].size());
+        ASSERT_EQ(expectedSize, m_mockClient->m_sendBatches[batch].size());
+        for (size_t entry = 0; entry < expectedSize; ++entry)
+        {
+            ASSERT_EQ(5, m_mockClient->m_visibilityBatches[batch][entry].second);
+        }
+    }
+    ASSERT_EQ(Names("delete-", 0, 25), Recorded(m_deleted));
+    ASSERT_EQ(Names("push-", 0, 25), Recorded(m_sent));
+}
+
+TEST_F(SQSBatchedQueueTest, TestPushBatchesStayUnderTheByteLimit)
+{
+    m_config.maxSendBatchBytes = 1000;
+    auto queue = MakeQueue();
+    for (int i = 0; i < 5; ++i)
+    {
+        // 400 bytes of body: two messages fit in a batch, a third would take it over the limit
+        Aws::String body = "push-" + StringUtils::to_string(i);
+        body.resize(400, '.');
+        queue->Push(Message().WithBody(body));
+    }
+    Aws::Map<Aws::String, MessageAttributeValue> attributes;
+    attributes["attribute"] = MessageAttributeValue().WithDataType("String").WithStringValue(Aws::String(190, 'a'));
+    // 400 bytes of body and 205 of attribute don't fit with the last message pushed
+    Aws::String body = "push-5";
+    body.resize(400, '.');
+    queue->Push(Message().WithBody(body).WithMessageAttributes(attributes));
+    queue->Flush();
+
+    std::lock_guard<std::mutex> locker(m_mockClient->m_lock);
+    ASSERT_EQ(4u, m_mockClient->m_sendBatches.size());
+    ASSERT_EQ(2u, m_mockClient->m_sendBatches[0].size());
+    ASSERT_EQ(2u, m_mockClient->m_sendBatches[1].size());
+    ASSERT_EQ(1u, m_mockClient->m_sendBatches[2].size());
+    ASSERT_EQ(1u, m_mockClient->m_sendBatches[3].size());
+    ASSERT_EQ(6u, Recorded(m_sent).size());
+}
+
+TEST_F(SQSBatchedQueueTest, TestPartialBatchesAreSentAfterTheyLinger)
+{
+    m_config.batchLinger = std::chrono::milliseconds(100);
+    auto queue = MakeQueue();
+    auto start = std::chrono::steady_clock::now();
+    queue->Push(BuildMessage("push-0"));
+    queue->Delete(BuildMessage("delete-0"));
+    queue->Push(BuildMessage("push-1"));
+    queue->ChangeVisibility(BuildMessage("change-0"), 0);
+
+    ASSERT_TRUE(m_mockClient->WaitFor([this]()
+    {
+        return m_mockClient->m_deleteBatches.size() == 1 && m_mockClient->m_visibilityBatches.size() == 1 && m_mockClient->m_sendBatches.size() == 1;
+    }));
+    ASSERT_GE(std::chrono::steady_clock::now() - start, m_config.batchLinger);
+
+    std::lock_guard<std::mutex> locker(m_mockClient->m_lock);
+    ASSERT_EQ(2u, m_mockClient->m_sendBatches[0].size());
+    ASSERT_EQ(1u, m_mockClient->m_deleteBatches[0].size());
+    ASSERT_EQ(1u, m_mockClient->m_visibilityBatches[0].size());
+}
+
+TEST_F(SQSBatchedQueueTest, TestFailedEntriesAreReportedForTheirMessages)
+{
+    auto queue = MakeQueue();
+    for (int i = 0; i < 6; ++i)
+    {
+        Aws::String name = StringUtils::to_string(i);
+        // the entries of the odd messages fail, leaving the ids of the failed entries out of step with the successful ones
+        queue->Delete(BuildMessage(i % 2 ? FAILING_PREFIX + name : "delete-" + name));
+        queue->Push(BuildMessage(i % 2 ? FAILING_PREFIX + name : "push-" + name));
+    }
+    queue->Flush();
+
+    Aws::Set<Aws::String> failed = { "bad1", "bad3", "bad5" };
+    ASSERT_EQ(failed, Recorded(m_deleteFailed));
+    ASSERT_EQ(failed, Recorded(m_sendFailed));
+    Aws::Set<Aws::String> deleted = { "delete-0", "delete-2", "delete-4" };
+    Aws::Set<Aws::String> sent = { "push-0", "push-2", "push-4" };
+    ASSERT_EQ(deleted, Recorded(m_deleted));
+    ASSERT_EQ(sent, Recorded(m_sent));
+}
+
+TEST_F(SQSBatchedQueueTest, TestFailedBatchesReportEveryMessage)
+{
+    m_mockClient->FailBatches();
+    auto queue = MakeQueue();
+    for (int i = 0; i < 3; ++i)
+    {
+        queue->Delete(BuildMessage("delete-" + StringUtils::to_string(i)));
+        queue->Push(BuildMessage("push-" + StringUtils::to_string(i)));
+    }
+    queue->Flush();
+
+    ASSERT_EQ(Names("delete-", 0, 3), Recorded(m_deleteFailed));
+    ASSERT_EQ(Names("push-", 0, 3), Recorded(m_sendFailed));
+    ASSERT_TRUE(Recorded(m_deleted).empty());
+    ASSERT_TRUE(Recorded(m_sent).empty());
+}
+
+TEST_F(SQSBatchedQueueTest, TestPollersStayWithinThePrefetchCapacity)
+{
+    m_config.pollerCount = 4;
+    m_config.prefetchCapacity = 25;
+    m_config.handlerThreads = 0;
+    m_mockClient->ExpectPrefetchBound(25);
+    m_mockClient->AddMessages("message-", 100);
+    auto queue = MakeQueue();
+    queue->StartConsuming();
+
+    // receives of 10 fill the buffer to 20, and a third would not fit
+    ASSERT_TRUE(m_mockClient->WaitFor([this]() { return m_mockClient->m_outstanding.size() == 20; }));
+    size_t receiveCalls = 0;
+    {
+        std::lock_guard<std::mutex> locker(m_mockClient->m_lock);
+        receiveCalls = m_mockClient->m_receiveCalls;
+    }
+
+    // taking messages makes room for further receives; messages waiting in a delete batch are no longer the queue's to count
+    m_mockClient->ExpectPrefetchBound(0);
+    Aws::Set<Aws::String> taken;
+    for (int i = 0; i < 30; ++i)
+    {
+        Message message = queue->Top();
+        taken.insert(message.GetReceiptHandle());
+        queue->Delete(message);
+    }
+    ASSERT_EQ(30u, taken.size());
+    ASSERT_TRUE(m_mockClient->WaitFor([this, receiveCalls]() { return m_mockClient->m_receiveCalls > receiveCalls; }));
+    ASSERT_LE(queue->GetPrefetchedCount(), 25u);
+
+    queue->StopConsuming();
+    queue->Flush();
+    std::lock_guard<std::mutex> locker(m_mockClient->m_lock);
+    ASSERT_TRUE(m_mockClient->m_outstanding.empty());
+}
+
+TEST_F(SQSBatchedQueueTest, TestStopConsumingReturnsBufferedMessages)
+{
+    m_config.pollerCount = 2;
+    m_config.prefetchCapacity = 30;
+    m_config.handlerThreads = 0;
+    m_mockClient->AddMessages("message-", 30);
+    auto queue = MakeQueue();
+    queue->StartConsuming();
+    ASSERT_TRUE(m_mockClient->WaitFor([this]() { return m_mockClient->m_outstanding.size() == 30; }));
+
+    queue->StopConsuming();
+    ASSERT_EQ(0u, queue->GetPrefetchedCount());
+    queue->Flush();
+
+    std::lock_guard<std::mutex> locker(m_mockClient->m_lock);
+    Aws::Set<Aws::String> returned;
+    for (const auto& batch : m_mockClient->m_visibilityBatches)
+    {
+        for (const auto& change : batch)
+        {
+            ASSERT_EQ(0, change.second);
+            returned.insert(change.first);
+        }
+    }
+    ASSERT_EQ(Names("message-", 0, 30), returned);
+    ASSERT_TRUE(m_mockClient->m_outstanding.empty());
+    ASSERT_TRUE(m_mockClient->m_deleteBatches.empty());
+}
+
+TEST_F(SQSBatchedQueueTest, TestHandlersDeleteTheMessagesTheyAskTo)
+{
+    m_config.handlerThreads = 3;
+    m_mockClient->AddMessages("message-", 40);
+    auto queue = MakeQueue();
+    queue->SetMessageReceivedEventHandler([this](const Aws::Queues::Queue<Message>*, const Message& message, bool& deleteMessage)
+    {
+        // the messages with odd numbers are left to become visible again
+        deleteMessage = (message.GetReceiptHandle().back() - '0') % 2 == 0;
+        Record(m_received, message.GetReceiptHandle());
+    });
+    queue->StartConsuming();
+
+    ASSERT_TRUE(WaitForReceived(40));
+    queue->StopConsuming();
+    queue->Flush();
+
+    Aws::Set<Aws::String> expected;
+    for (int i = 0; i < 40; i += 2)
+    {
+        expected.insert("message-" + StringUtils::to_string(i));
+    }
+    ASSERT_EQ(expected, Recorded(m_deleted));
+    std::lock_guard<std::mutex> locker(m_mockClient->m_lock);
+    ASSERT_EQ(20u, m_mockClient->m_outstanding.size());
+    ASSERT_EQ(2u, m_mockClient->m_deleteBatches.size());
+}
+
+TEST_F(SQSBatchedQueueTest, TestDestructorWaitsForBatchesInFlight)
+{
+    m_mockClient->HoldBatches();
+    auto queue = MakeQueue();
+    for (int i = 0; i < 12; ++i)
+    {
+        queue->Push(BuildMessage("push-" + StringUtils::to_string(i)));
+    }
+    queue->Delete(BuildMessage("delete-0"));
+    // the first 10 messages went out in a full batch, which is now held by the client
+    ASSERT_TRUE(m_mockClient->WaitFor([this]() { return m_mockClient->m_heldBatches == 1; }));
+
+    std::atomic<bool> destroyed(false);
+    std::thread destroyer([&queue, &destroyed]()
+    {
+        queue = nullptr;
+        destroyed = true;
+    });
+    // the destructor sends the pending push and delete batches and waits for all three
+    ASSERT_TRUE(m_mockClient->WaitFor([this]() { return m_mockClient->m_heldBatches == 3; }));
+    ASSERT_FALSE(destroyed.load());
+
+    m_mockClient->ReleaseBatches();
+    destroyer.join();
+    ASSERT_EQ(Names("push-", 0, 12), Recorded(m_sent));
+    ASSERT_EQ(Names("delete-", 0, 1), Recorded(m_deleted));
+}
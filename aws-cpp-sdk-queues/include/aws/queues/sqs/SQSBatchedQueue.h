@@ -0,0 +1,185 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+#pragma once
+
+#include <aws/queues/sqs/SQSQueue.h>
+#include <aws/core/utils/memory/stl/AWSDeque.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Aws
+{
+    namespace Queues
+    {
+        namespace Sqs
+        {
+            /**
+             * Settings of an SQSBatchedQueue.
+             */
+            struct AWS_QUEUES_API SQSBatchedQueueConfiguration
+            {
+                SQSBatchedQueueConfiguration() :
+                    pollerCount(4), waitTimeSeconds(20), prefetchCapacity(100), handlerThreads(8),
+                    batchLinger(std::chrono::milliseconds(50)), maxSendBatchBytes(256 * 1024), extendVisibility(true)
+                {
+                }
+
+                /**
+                 * Number of ReceiveMessage long polls kept going at once by StartConsuming, each asking for up to 10 messages. Defaults to 4.
+                 */
+                size_t pollerCount;
+                /**
+                 * How long each ReceiveMessage waits for messages to arrive, at most 20 seconds. StopConsuming waits for the polls in progress,
+                 * so this is also how long it may take. Defaults to 20.
+                 */
+                unsigned waitTimeSeconds;
+                /**
+                 * Most messages received and not yet handed to a handler. Pollers only ask for as many messages as fit. Defaults to 100.
+                 */
+                size_t prefetchCapacity;
+                /**
+                 * Number of threads StartConsuming calls the message received handler on. Defaults to 8.
+                 */
+                size_t handlerThreads;
+                /**
+                 * Longest a Delete, ChangeVisibility or Push waits for 9 more of its kind to fill a batch before the batch is sent anyway.
+                 * Defaults to 50ms.
+                 */
+                std::chrono::milliseconds batchLinger;
+                /**
+                 * Most bytes of message bodies and attributes in one SendMessageBatch; SQS allows 256KB. Defaults to 256KB.
+                 */
+                size_t maxSendBatchBytes;
+                /**
+                 * When true, messages that are waiting in the prefetch buffer or being handled by StartConsuming's handlers have their visibility
+                 * timeout extended by the queue's visibility timeout whenever less than half of it is left, so that they don't go back to the queue
+                 * while this consumer still has them. Needs a non-zero visibility timeout. Defaults to true.
+                 */
+                bool extendVisibility;
+            };
+
+            /**
+             * An SQSQueue that moves messages in batches, for consumers and producers that need more than one message per request.
+             *
+             * StartConsuming keeps pollerCount long polls for 10 messages at a time going, into a prefetch buffer of prefetchCapacity
+             * messages, and calls the message received handler for them on handlerThreads threads, deleting the messages the handler asks
+             * to. Top() takes messages from the same buffer, and fills it 10 messages at a time itself when StartConsuming isn't running.
+             *
+             * Delete, ChangeVisibility and Push don't send a request per message: messages are collected into DeleteMessageBatch,
+             * ChangeMessageVisibilityBatch and SendMessageBatch requests of up to 10 entries, which are sent when full or batchLinger
+             * after their first message. The delete and send handlers are called per message as the batches complete.
+             */
+            class AWS_QUEUES_API SQSBatchedQueue : public SQSQueue
+            {
+            public:
+                SQSBatchedQueue(const std::shared_ptr<SQS::SQSClient>& client, const char* queueName, unsigned visibilityTimeout,
+                                const SQSBatchedQueueConfiguration& configuration = SQSBatchedQueueConfiguration());
+
+                /**
+                 * Stops polling and consuming, and sends the batches that are still pending.
+                 */
+                ~SQSBatchedQueue();
+
+                /**
+                 * Takes the next message from the prefetch buffer. Will continue polling until a message is received or StopPolling is called.
+                 */
+                Aws::SQS::Model::Message Top() const override;
+
+                /**
+                 * Does not block. The message is deleted in the next DeleteMessageBatch.
+                 */
+                void Delete(const Aws::SQS::Model::Message&) override;
+
+                /**
+                 * Does not block. The message is sent in the next SendMessageBatch.
+                 */
+                void Push(const Aws::SQS::Model::Message&) override;
+
+                /**
+                 * Does not block. Changes how long until the message is visible again, in the next ChangeMessageVisibilityBatch.
+                 */
+                void ChangeVisibility(const Aws::SQS::Model::Message&, unsigned visibilityTimeout);
+
+                /**
+                 * Starts the pollers and the handler threads. Register OnMessageReceived first.
+                 */
+                void StartConsuming();
+
+                /**
+                 * Stops the pollers and the handler threads, waiting for the polls and handlers in progress. Messages left in the prefetch buffer
+                 * are made visible again right away. StartConsuming may be called again afterwards.
+                 */
+                void StopConsuming();
+
+                /**
+                 * Sends the pending batches without waiting for them to fill, and waits for all batches sent so far to complete.
+                 */
+                void Flush();
+
+                /**
+                 * The number of messages in the prefetch buffer.
+                 */
+                size_t GetPrefetchedCount() const;
+
+            private:
+                typedef std::chrono::steady_clock Clock;
+
+                void Poll();
+                void Handle();
+                void RunBatcher();
+
+                /// Sends a ReceiveMessage for up to maxMessages and adds what arrives to the prefetch buffer; locker is unlocked meanwhile
+                void ReceiveIntoBuffer(std::unique_lock<std::mutex>& locker, size_t maxMessages) const;
+                void StopTracking(const Aws::SQS::Model::Message&) const;
+                void ExtendDueVisibilities();
+
+                void SendDeleteBatch(Aws::Vector<Aws::SQS::Model::Message>&& messages);
+                void SendVisibilityBatch(Aws::Vector<std::pair<Aws::SQS::Model::Message, unsigned>>&& changes);
+                void SendPushBatch(Aws::Vector<Aws::SQS::Model::Message>&& messages);
+                void FinishBatch();
+
+                SQSBatchedQueueConfiguration m_configuration;
+
+                /// Prefetch buffer, and the deadlines of the messages held by this consumer, by receipt handle
+                mutable std::mutex m_bufferLock;
+                mutable std::condition_variable m_bufferChanged;
+                mutable Aws::Deque<Aws::SQS::Model::Message> m_prefetched;
+                mutable Aws::Map<Aws::String, std::pair<Aws::SQS::Model::Message, Clock::time_point>> m_held;
+                mutable size_t m_receivesInFlight;
+                bool m_consuming;
+                Aws::Vector<std::thread> m_pollers;
+                Aws::Vector<std::thread> m_handlers;
+
+                /// Pending batches, sent by the batcher thread once they have lingered for batchLinger
+                std::mutex m_batchLock;
+                std::condition_variable m_batchChanged;
+                Aws::Vector<Aws::SQS::Model::Message> m_pendingDeletes;
+                Clock::time_point m_pendingDeletesSince;
+                Aws::Vector<std::pair<Aws::SQS::Model::Message, unsigned>> m_pendingVisibilityChanges;
+                Clock::time_point m_pendingVisibilityChangesSince;
+                Aws::Vector<Aws::SQS::Model::Message> m_pendingPushes;
+                size_t m_pendingPushBytes;
+                Clock::time_point m_pendingPushesSince;
+                size_t m_batchesInFlight;
+                bool m_stopBatcher;
+                std::thread m_batcher;
+            };
+        }
+    }
+}
@@ -0,0 +1,619 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+#include <aws/queues/sqs/SQSBatchedQueue.h>
+#include <aws/sqs/model/ReceiveMessageRequest.h>
+#include <aws/sqs/model/DeleteMessageBatchRequest.h>
+#include <aws/sqs/model/ChangeMessageVisibilityBatchRequest.h>
+#include <aws/sqs/model/SendMessageBatchRequest.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/logging/LogMacros.h>
+
+#include <algorithm>
+
+using namespace Aws::SQS;
+using namespace Aws::SQS::Model;
+using namespace Aws::Queues::Sqs;
+using namespace Aws::Client;
+
+static const char* CLASS_TAG = "Aws::Queues::Sqs::SQSBatchedQueue";
+// the most messages SQS takes or gives in one batch request or receive
+static const size_t MAX_BATCH_ENTRIES = 10;
+
+/**
+ * Bytes a message counts for against the 256KB limit of a SendMessageBatch: its body and its attributes' names, types and values.
+ */
+static size_t GetMessageSize(const Message& message)
+{
+    size_t size = message.GetBody().size();
+    for (const auto& attribute : message.GetMessageAttributes())
+    {
+        size += attribute.first.size() + attribute.second.GetDataType().size() + attribute.second.GetStringValue().size() +
+                attribute.second.GetBinaryValue().GetLength();
+    }
+    return size;
+}
+
+SQSBatchedQueue::SQSBatchedQueue(const std::shared_ptr<SQSClient>& client, const char* queueName, unsigned visibilityTimeout,
+                                 const SQSBatchedQueueConfiguration& configuration) :
+    SQSQueue(client, queueName, visibilityTimeout),
+    m_configuration(configuration),
+    m_receivesInFlight(0),
+    m_consuming(false),
+    m_pendingPushBytes(0),
+    m_batchesInFlight(0),
+    m_stopBatcher(false)
+{
+    m_configuration.waitTimeSeconds = (std::min)(m_configuration.waitTimeSeconds, 20u);
+    m_configuration.prefetchCapacity = (std::max)(m_configuration.prefetchCapacity, static_cast<size_t>(1));
+    m_batcher = std::thread(&SQSBatchedQueue::RunBatcher, this);
+}
+
+SQSBatchedQueue::~SQSBatchedQueue()
+{
+    // the polling thread of Queue calls Top and Delete, which must not outlive this class
+    StopPolling();
+    StopConsuming();
+    Flush();
+    {
+        std::lock_guard<std::mutex> locker(m_batchLock);
+        m_stopBatcher = true;
+    }
+    m_batchChanged.notify_all();
+    m_batcher.join();
+}
+
+Message SQSBatchedQueue::Top() const
+{
+    if (!IsInitialized())
+    {
+        AWS_LOGSTREAM_ERROR(CLASS_TAG, "Queue is not initialized, not polling. Call EnsureQueueIsInitialized before calling this method.");
+        return Message();
+    }
+
+    std::unique_lock<std::mutex> locker(m_bufferLock);
+    while (m_continue)
+    {
+        if (!m_prefetched.empty())
+        {
+            Message message = m_prefetched.front();
+            m_prefetched.pop_front();
+            // the caller decides what happens to the message from here on
+            m_held.erase(message.GetReceiptHandle());
+            m_bufferChanged.notify_all();
+            return message;
+        }
+
+        if (m_consuming)
+        {
+            m_bufferChanged.wait_for(locker, std::chrono::seconds(1));
+        }
+        else
+        {
+            ReceiveIntoBuffer(locker, (std::min)(m_configuration.prefetchCapacity, MAX_BATCH_ENTRIES));
+        }
+    }
+
+    return Message();
+}
+
+void SQSBatchedQueue::Delete(const Message& message)
+{
+    if (!IsInitialized())
+    {
+        AWS_LOGSTREAM_ERROR(CLASS_TAG, "Queue is not initialized, not deleting. Call EnsureQueueIsInitialized before calling this method.");
+        return;
+    }
+
+    StopTracking(message);
+    Aws::Vector<Message> batch;
+    {
+        std::lock_guard<std::mutex> locker(m_batchLock);
+        if (m_pendingDeletes.empty())
+        {
+            m_pendingDeletesSince = Clock::now();
+            m_batchChanged.notify_all();
+        }
+        m_pendingDeletes.push_back(message);
+        if (m_pendingDeletes.size() == MAX_BATCH_ENTRIES)
+        {
+            batch.swap(m_pendingDeletes);
+            ++m_batchesInFlight;
+        }
+    }
+
+    if (!batch.empty())
+    {
+        SendDeleteBatch(std::move(batch));
+    }
+}
+
+void SQSBatchedQueue::ChangeVisibility(const Message& message, unsigned visibilityTimeout)
+{
+    if (!IsInitialized())
+    {
+        AWS_LOGSTREAM_ERROR(CLASS_TAG, "Queue is not initialized, not changing visibility. Call EnsureQueueIsInitialized before calling this method.");
+        return;
+    }
+
+    Aws::Vector<std::pair<Message, unsigned>> batch;
+    {
+        std::lock_guard<std::mutex> locker(m_batchLock);
+        if (m_pendingVisibilityChanges.empty())
+        {
+            m_pendingVisibilityChangesSince = Clock::now();
+            m_batchChanged.notify_all();
+        }
+        m_pendingVisibilityChanges.emplace_back(message, visibilityTimeout);
+        if (m_pendingVisibilityChanges.size() == MAX_BATCH_ENTRIES)
+        {
+            batch.swap(m_pendingVisibilityChanges);
+            ++m_batchesInFlight;
+        }
+    }
+
+    if (!batch.empty())
+    {
+        SendVisibilityBatch(std::move(batch));
+    }
+}
+
+void SQSBatchedQueue::Push(const Message& message)
+{
+    if (!IsInitialized())
+    {
+        AWS_LOGSTREAM_ERROR(CLASS_TAG, "Queue is not initialized, not pushing. Call EnsureQueueIsInitialized before calling this method.");
+        return;
+    }
+
+    size_t messageSize = GetMessageSize(message);
+    Aws::Vector<Message> batch;
+    {
+        std::lock_guard<std::mutex> locker(m_batchLock);
+        // a message that would take the batch over the size limit goes out in the next one
+        if (!m_pendingPushes.empty() && m_pendingPushBytes + messageSize > m_configuration.maxSendBatchBytes)
+        {
+            batch.swap(m_pendingPushes);
+            m_pendingPushBytes = 0;
+            ++m_batchesInFlight;
+        }
+        if (m_pendingPushes.empty())
+        {
+            m_pendingPushesSince = Clock::now();
+            m_batchChanged.notify_all();
+        }
+        m_pendingPushes.push_back(message);
+        m_pendingPushBytes += messageSize;
+        if (batch.empty() && m_pendingPushes.size() == MAX_BATCH_ENTRIES)
+        {
+            batch.swap(m_pendingPushes);
+            m_pendingPushBytes = 0;
+            ++m_batchesInFlight;
+        }
+    }
+
+    if (!batch.empty())
+    {
+        SendPushBatch(std::move(batch));
+    }
+}
+
+void SQSBatchedQueue::StartConsuming()
+{
+    std::lock_guard<std::mutex> locker(m_bufferLock);
+    if (m_consuming)
+    {
+        return;
+    }
+
+    m_consuming = true;
+    for (size_t i = 0; i < m_configuration.pollerCount; ++i)
+    {
+        m_pollers.emplace_back(&SQSBatchedQueue::Poll, this);
+    }
+    for (size_t i = 0; i < m_configuration.handlerThreads; ++i)
+    {
+        m_handlers.emplace_back(&SQSBatchedQueue::Handle, this);
+    }
+}
+
+void SQSBatchedQueue::StopConsuming()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_bufferLock);
+        if (!m_consuming)
+        {
+            return;
+        }
+        m_consuming = false;
+    }
+    m_bufferChanged.notify_all();
+
+    for (auto& thread : m_pollers)
+    {
+        thread.join();
+    }
+    for (auto& thread : m_handlers)
+    {
+        thread.join();
+    }
+    m_pollers.clear();
+    m_handlers.clear();
+
+    Aws::Deque<Message> prefetched;
+    {
+        std::lock_guard<std::mutex> locker(m_bufferLock);
+        prefetched.swap(m_prefetched);
+        for (const auto& message : prefetched)
+        {
+            m_held.erase(message.GetReceiptHandle());
+        }
+    }
+    AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Returning " << prefetched.size() << " prefetched messages to " << m_queueUrl);
+    for (const auto& message : prefetched)
+    {
+        ChangeVisibility(message, 0);
+    }
+}
+
+void SQSBatchedQueue::Flush()
+{
+    Aws::Vector<Message> deletes;
+    Aws::Vector<std::pair<Message, unsigned>> visibilityChanges;
+    Aws::Vector<Message> pushes;
+    {
+        std::lock_guard<std::mutex> locker(m_batchLock);
+        deletes.swap(m_pendingDeletes);
+        visibilityChanges.swap(m_pendingVisibilityChanges);
+        pushes.swap(m_pendingPushes);
+        m_pendingPushBytes = 0;
+        m_batchesInFlight += !deletes.empty() + !visibilityChanges.empty() + !pushes.empty();
+    }
+
+    if (!deletes.empty())
+    {
+        SendDeleteBatch(std::move(deletes));
+    }
+    if (!visibilityChanges.empty())
+    {
+        SendVisibilityBatch(std::move(visibilityChanges));
+    }
+    if (!pushes.empty())
+    {
+        SendPushBatch(std::move(pushes));
+    }
+
+    std::unique_lock<std::mutex> locker(m_batchLock);
+    m_batchChanged.wait(locker, [this]() { return m_batchesInFlight == 0; });
+}
+
+size_t SQSBatchedQueue::GetPrefetchedCount() const
+{
+    std::lock_guard<std::mutex> locker(m_bufferLock);
+    return m_prefetched.size();
+}
+
+void SQSBatchedQueue::Poll()
+{
+    std::unique_lock<std::mutex> locker(m_bufferLock);
+    while (m_consuming)
+    {
+        // ask only for as many messages as the buffer has room for, counting those that polls in progress may bring
+        size_t maxMessages = (std::min)(m_configuration.prefetchCapacity, MAX_BATCH_ENTRIES);
+        if (m_prefetched.size() + (m_receivesInFlight + 1) * maxMessages > m_configuration.prefetchCapacity)
+        {
+            m_bufferChanged.wait(locker);
+            continue;
+        }
+
+        ReceiveIntoBuffer(locker, maxMessages);
+    }
+}
+
+void SQSBatchedQueue::ReceiveIntoBuffer(std::unique_lock<std::mutex>& locker, size_t maxMessages) const
+{
+    ++m_receivesInFlight;
+    locker.unlock();
+
+    AWS_LOGSTREAM_TRACE(CLASS_TAG, "Polling for up to " << maxMessages << " messages with a timeout of " << m_configuration.waitTimeSeconds << " seconds.");
+    ReceiveMessageRequest receiveMessageRequest;
+    receiveMessageRequest.SetMaxNumberOfMessages(static_cast<int>(maxMessages));
+    receiveMessageRequest.SetQueueUrl(m_queueUrl);
+    receiveMessageRequest.SetVisibilityTimeout(m_visibilityTimeout);
+    receiveMessageRequest.SetWaitTimeSeconds(static_cast<int>(m_configuration.waitTimeSeconds));
+    auto receiveTime = Clock::now();
+    ReceiveMessageOutcome receiveMessageOutcome = m_client->ReceiveMessage(receiveMessageRequest);
+
+    if (!receiveMessageOutcome.IsSuccess())
+    {
+        AWS_LOGSTREAM_ERROR(CLASS_TAG, "Receive message failed with error: " << receiveMessageOutcome.GetError().GetExceptionName() <<
+                                                                              " and message: " << receiveMessageOutcome.GetError().GetMessage());
+        // don't spin on a queue that keeps failing
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    locker.lock();
+    --m_receivesInFlight;
+    if (receiveMessageOutcome.IsSuccess())
+    {
+        auto visibleAgain = receiveTime + std::chrono::seconds(m_visibilityTimeout);
+        for (const auto& message : receiveMessageOutcome.GetResult().GetMessages())
+        {
+            m_prefetched.push_back(message);
+            m_held[message.GetReceiptHandle()] = std::make_pair(message, visibleAgain);
+        }
+    }
+    m_bufferChanged.notify_all();
+}
+
+void SQSBatchedQueue::Handle()
+{
+    while (true)
+    {
+        Message message;
+        {
+            std::unique_lock<std::mutex> locker(m_bufferLock);
+            m_bufferChanged.wait(locker, [this]() { return !m_consuming || !m_prefetched.empty(); });
+            if (!m_consuming)
+            {
+                return;
+            }
+            message = m_prefetched.front();
+            m_prefetched.pop_front();
+        }
+        m_bufferChanged.notify_all();
+
+        bool deleteMessage = false;
+        auto& receivedHandler = GetMessageReceivedEventHandler();
+        if (receivedHandler)
+        {
+            receivedHandler(this, message, deleteMessage);
+        }
+
+        if (deleteMessage)
+        {
+            Delete(message);
+        }
+        else
+        {
+            StopTracking(message);
+        }
+    }
+}
+
+void SQSBatchedQueue::StopTracking(const Message& message) const
+{
+    std::lock_guard<std::mutex> locker(m_bufferLock);
+    m_held.erase(message.GetReceiptHandle());
+}
+
+void SQSBatchedQueue::ExtendDueVisibilities()
+{
+    if (!m_configuration.extendVisibility || m_visibilityTimeout == 0)
+    {
+        return;
+    }
+
+    Aws::Vector<Message> due;
+    {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> locker(m_bufferLock);
+        for (auto& held : m_held)
+        {
+            if (held.second.second - now < std::chrono::seconds(m_visibilityTimeout) / 2)
+            {
+                due.push_back(held.second.first);
+                held.second.second = now + std::chrono::seconds(m_visibilityTimeout);
+            }
+        }
+    }
+
+    for (const auto& message : due)
+    {
+        ChangeVisibility(message, m_visibilityTimeout);
+    }
+}
+
+void SQSBatchedQueue::RunBatcher()
+{
+    auto nextVisibilityCheck = Clock::now();
+    std::unique_lock<std::mutex> locker(m_batchLock);
+    while (!m_stopBatcher)
+    {
+        auto now = Clock::now();
+        if (now >= nextVisibilityCheck)
+        {
+            locker.unlock();
+            ExtendDueVisibilities();
+            locker.lock();
+            nextVisibilityCheck = now + std::chrono::seconds(1);
+        }
+
+        Aws::Vector<Message> deletes;
+        Aws::Vector<std::pair<Message, unsigned>> visibilityChanges;
+        Aws::Vector<Message> pushes;
+        if (!m_pendingDeletes.empty() && now - m_pendingDeletesSince >= m_configuration.batchLinger)
+        {
+            deletes.swap(m_pendingDeletes);
+            ++m_batchesInFlight;
+        }
+        if (!m_pendingVisibilityChanges.empty() && now - m_pendingVisibilityChangesSince >= m_configuration.batchLinger)
+        {
+            visibilityChanges.swap(m_pendingVisibilityChanges);
+            ++m_batchesInFlight;
+        }
+        if (!m_pendingPushes.empty() && now - m_pendingPushesSince >= m_configuration.batchLinger)
+        {
+            pushes.swap(m_pendingPushes);
+            m_pendingPushBytes = 0;
+            ++m_batchesInFlight;
+        }
+
+        if (!deletes.empty() || !visibilityChanges.empty() || !pushes.empty())
+        {
+            locker.unlock();
+            if (!deletes.empty())
+            {
+                SendDeleteBatch(std::move(deletes));
+            }
+            if (!visibilityChanges.empty())
+            {
+                SendVisibilityBatch(std::move(visibilityChanges));
+            }
+            if (!pushes.empty())
+            {
+                SendPushBatch(std::move(pushes));
+            }
+            locker.lock();
+            continue;
+        }
+
+        auto wakeUp = nextVisibilityCheck;
+        if (!m_pendingDeletes.empty())
+        {
+            wakeUp = (std::min)(wakeUp, m_pendingDeletesSince + m_configuration.batchLinger);
+        }
+        if (!m_pendingVisibilityChanges.empty())
+        {
+            wakeUp = (std::min)(wakeUp, m_pendingVisibilityChangesSince + m_configuration.batchLinger);
+        }
+        if (!m_pendingPushes.empty())
+        {
+            wakeUp = (std::min)(wakeUp, m_pendingPushesSince + m_configuration.batchLinger);
+        }
+        m_batchChanged.wait_until(locker, wakeUp);
+    }
+}
+
+void SQSBatchedQueue::SendDeleteBatch(Aws::Vector<Message>&& messages)
+{
+    AWS_LOGSTREAM_TRACE(CLASS_TAG, "Deleting " << messages.size() << " messages from queue " << m_queueUrl);
+    DeleteMessageBatchRequest request;
+    request.SetQueueUrl(m_queueUrl);
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        request.AddEntries(DeleteMessageBatchRequestEntry().WithId(Aws::Utils::StringUtils::to_string(i)).WithReceiptHandle(messages[i].GetReceiptHandle()));
+    }
+
+    auto batch = Aws::MakeShared<Aws::Vector<Message>>(CLASS_TAG, std::move(messages));
+    m_client->DeleteMessageBatchAsync(request, [this, batch](const SQSClient*, const DeleteMessageBatchRequest&,
+                                                             const DeleteMessageBatchOutcome& outcome, const std::shared_ptr<const AsyncCallerContext>&)
+    {
+        Aws::Vector<bool> failed(batch->size(), !outcome.IsSuccess());
+        if (!outcome.IsSuccess())
+        {
+            AWS_LOGSTREAM_ERROR(CLASS_TAG, "Delete message batch failed with error: " << outcome.GetError().GetExceptionName() <<
+                                         " and message: " << outcome.GetError().GetMessage());
+        }
+        else
+        {
+            for (const auto& entry : outcome.GetResult().GetFailed())
+            {
+                AWS_LOGSTREAM_ERROR(CLASS_TAG, "Delete message failed with error: " << entry.GetCode() << " and message: " << entry.GetMessage());
+                failed[static_cast<size_t>(Aws::Utils::StringUtils::ConvertToInt32(entry.GetId().c_str()))] = true;
+            }
+        }
+
+        for (size_t i = 0; i < batch->size(); ++i)
+        {
+            auto& handler = failed[i] ? GetMessageDeleteFailedEventHandler() : GetMessageDeleteSuccessEventHandler();
+            if (handler)
+            {
+                handler(this, (*batch)[i]);
+            }
+        }
+        FinishBatch();
+    });
+}
+
+void SQSBatchedQueue::SendVisibilityBatch(Aws::Vector<std::pair<Message, unsigned>>&& changes)
+{
+    AWS_LOGSTREAM_TRACE(CLASS_TAG, "Changing the visibility of " << changes.size() << " messages in queue " << m_queueUrl);
+    ChangeMessageVisibilityBatchRequest request;
+    request.SetQueueUrl(m_queueUrl);
+    for (size_t i = 0; i < changes.size(); ++i)
+    {
+        request.AddEntries(ChangeMessageVisibilityBatchRequestEntry().WithId(Aws::Utils::StringUtils::to_string(i))
+                               .WithReceiptHandle(changes[i].first.GetReceiptHandle())
+                               .WithVisibilityTimeout(static_cast<int>(changes[i].second)));
+    }
+
+    m_client->ChangeMessageVisibilityBatchAsync(request, [this](const SQSClient*, const ChangeMessageVisibilityBatchRequest&,
+                                                                const ChangeMessageVisibilityBatchOutcome& outcome, const std::shared_ptr<const AsyncCallerContext>&)
+    {
+        if (!outcome.IsSuccess())
+        {
+            AWS_LOGSTREAM_ERROR(CLASS_TAG, "Change message visibility batch failed with error: " << outcome.GetError().GetExceptionName() <<
+                                         " and message: " << outcome.GetError().GetMessage());
+        }
+        else
+        {
+            for (const auto& entry : outcome.GetResult().GetFailed())
+            {
+                AWS_LOGSTREAM_WARN(CLASS_TAG, "Change message visibility failed with error: " << entry.GetCode() << " and message: " << entry.GetMessage());
+            }
+        }
+        FinishBatch();
+    });
+}
+
+void SQSBatchedQueue::SendPushBatch(Aws::Vector<Message>&& messages)
+{
+    AWS_LOGSTREAM_TRACE(CLASS_TAG, "Sending " << messages.size() << " messages to " << m_queueUrl);
+    SendMessageBatchRequest request;
+    request.SetQueueUrl(m_queueUrl);
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        request.AddEntries(SendMessageBatchRequestEntry().WithId(Aws::Utils::StringUtils::to_string(i))
+                               .WithMessageBody(messages[i].GetBody())
+                               .WithMessageAttributes(messages[i].GetMessageAttributes()));
+    }
+
+    auto batch = Aws::MakeShared<Aws::Vector<Message>>(CLASS_TAG, std::move(messages));
+    m_client->SendMessageBatchAsync(request, [this, batch](const SQSClient*, const SendMessageBatchRequest&,
+                                                           const SendMessageBatchOutcome& outcome, const std::shared_ptr<const AsyncCallerContext>&)
+    {
+        Aws::Vector<bool> failed(batch->size(), !outcome.IsSuccess());
+        if (!outcome.IsSuccess())
+        {
+            AWS_LOGSTREAM_ERROR(CLASS_TAG, "Send message batch failed with error: " << outcome.GetError().GetExceptionName() <<
+                                         " and message: " << outcome.GetError().GetMessage());
+        }
+        else
+        {
+            for (const auto& entry : outcome.GetResult().GetFailed())
+            {
+                AWS_LOGSTREAM_ERROR(CLASS_TAG, "Send message failed with error: " << entry.GetCode() << " and message: " << entry.GetMessage());
+                failed[static_cast<size_t>(Aws::Utils::StringUtils::ConvertToInt32(entry.GetId().c_str()))] = true;
+            }
+        }
+
+        for (size_t i = 0; i < batch->size(); ++i)
+        {
+            auto& handler = failed[i] ? GetMessageSendFailedEventHandler() : GetMessageSendSuccessEventHandler();
+            if (handler)
+            {
+                handler(this, (*batch)[i]);
+            }
+        }
+        FinishBatch();
+    });
+}
+
+void SQSBatchedQueue::FinishBatch()
+{
+    std::lock_guard<std::mutex> locker(m_batchLock);
+    --m_batchesInFlight;
+    m_batchChanged.notify_all();
+}
@@ -246,6 +246,105 @@ namespace
             ASSERT_TRUE(metadataMap[KEY_WRAP_ALGORITHM].size() > 0u);
             ASSERT_TRUE(metadataMap[MATERIALS_DESCRIPTION_HEADER].size() > 0u);
         }
+
+        /*
+        * Function to upload an object encrypted part by part, check a retried part comes out the same, read it back whole with GetObjectSecurely,
+        * then decrypt it again part by part, the way TransferManager does.
+        */
+        static void EncryptAndDecryptInParts(CryptoMode mode)
+        {
+            static const size_t PART_SIZE = 32u;
+            static const size_t PART_OVERHEAD = 48u;
+            Aws::String plaintext;
+            for (size_t i = 0; i < 100u; ++i)
+            {
+                plaintext.push_back(static_cast<char>('a' + i % 26));
+            }
+
+            SimpleEncryptionMaterials materials(Aws::Utils::Crypto::SymmetricCipher::GenerateKey());
+            CryptoConfiguration cryptoConfig(StorageMethod::METADATA, mode);
+            MockS3Client s3Client;
+            CryptoModuleFactory factory;
+            auto module = factory.FetchCryptoModule(Aws::MakeShared<SimpleEncryptionMaterials>(ALLOCATION_TAG, materials), cryptoConfig);
+
+            PutObjectRequest putRequest;
+            putRequest.SetBucket(BUCKET_TEST_NAME);
+            putRequest.SetKey(KEY_TEST_NAME);
+            auto putObjectFunction = [&s3Client](Aws::S3::Model::PutObjectRequest putRequest) -> Aws::S3::Model::PutObjectOutcome { return s3Client.PutObject(putRequest); };
+            ASSERT_TRUE(module->InitPartEncryption(putRequest, putObjectFunction).IsSuccess());
+            MetadataFilled(putRequest.GetMetadata());
+            ASSERT_EQ(s3Client.m_putObjectCalled, 0u);
+
+            // the upload's parts: two whole ones, then the rest
+            Aws::String ciphertext;
+            Aws::String secondPart;
+            for (size_t offset = 0, partNumber = 1; offset < plaintext.size(); offset += PART_SIZE, ++partNumber)
+            {
+                bool lastPart = plaintext.size() - offset < 2 * PART_SIZE;
+                size_t length = lastPart ? plaintext.size() - offset : PART_SIZE;
+                Aws::Utils::CryptoBuffer buffer(length + PART_OVERHEAD);
+                memcpy(buffer.GetUnderlyingData(), plaintext.c_str() + offset, length);
+                size_t written = module->EncryptPart(static_cast<int>(partNumber), buffer.GetUnderlyingData(), length, buffer.GetLength(), lastPart);
+                ASSERT_TRUE(written >= length);
+                if (!lastPart)
+                {
+                    ASSERT_EQ(length, written);
+                }
+                if (partNumber == 2)
+                {
+                    secondPart = Aws::String(reinterpret_cast<const char*>(buffer.GetUnderlyingData()), written);
+                }
+                ciphertext.append(reinterpret_cast<const char*>(buffer.GetUnderlyingData()), written);
+                if (lastPart)
+                {
+                    break;
+                }
+            }
+
+            Aws::Utils::CryptoBuffer retried(PART_SIZE + PART_OVERHEAD);
+            memcpy(retried.GetUnderlyingData(), plaintext.c_str() + PART_SIZE, PART_SIZE);
+            ASSERT_EQ(PART_SIZE, module->EncryptPart(2, retried.GetUnderlyingData(), PART_SIZE, retried.GetLength(), false));
+            ASSERT_EQ(secondPart, Aws::String(reinterpret_cast<const char*>(retried.GetUnderlyingData()), PART_SIZE));
+
+            s3Client.bodyString = ciphertext;
+            s3Client.m_requestContentLength = ciphertext.size();
+            s3Client.m_metadata = putRequest.GetMetadata();
+
+            HeadObjectRequest headObject;
+            headObject.WithBucket(BUCKET_TEST_NAME);
+            headObject.WithKey(KEY_TEST_NAME);
+            HeadObjectOutcome headOutcome = s3Client.HeadObject(headObject);
+            Aws::S3Encryption::Handlers::MetadataHandler handler;
+            ContentCryptoMaterial contentCryptoMaterial = handler.ReadContentCryptoMaterial(headOutcome.GetResult());
+            auto getObjectFunction = [&s3Client](Aws::S3::Model::GetObjectRequest getRequest) -> Aws::S3::Model::GetObjectOutcome { return s3Client.GetObject(getRequest); };
+
+            GetObjectRequest getRequest;
+            getRequest.SetBucket(BUCKET_TEST_NAME);
+            getRequest.SetKey(KEY_TEST_NAME);
+            auto wholeModule = factory.FetchCryptoModule(Aws::MakeShared<SimpleEncryptionMaterials>(ALLOCATION_TAG, materials), cryptoConfig);
+            auto getOutcome = wholeModule->GetObjectSecurely(getRequest, headOutcome.GetResult(), contentCryptoMaterial, getObjectFunction);
+            ASSERT_TRUE(getOutcome.IsSuccess());
+            Aws::OStringStream ss;
+            ss << getOutcome.GetResult().GetBody().rdbuf();
+            ASSERT_EQ(plaintext, ss.str());
+
+            auto partsModule = factory.FetchCryptoModule(Aws::MakeShared<SimpleEncryptionMaterials>(ALLOCATION_TAG, materials), cryptoConfig);
+            ASSERT_TRUE(partsModule->InitPartDecryption(getRequest, headOutcome.GetResult(), contentCryptoMaterial, getObjectFunction).IsSuccess());
+            ASSERT_EQ(plaintext.size(), partsModule->GetPlaintextLength());
+
+            // the download's parts, decrypted last to first to show they don't depend on one another
+            for (size_t offset = (plaintext.size() - 1) / PART_SIZE * PART_SIZE; offset < plaintext.size(); offset -= PART_SIZE)
+            {
+                size_t length = (std::min)(PART_SIZE, plaintext.size() - offset);
+                auto range = partsModule->GetPartCiphertextRange(offset, length);
+                size_t ciphertextLength = static_cast<size_t>(range.second - range.first + 1);
+                ASSERT_TRUE(ciphertextLength <= length + PART_OVERHEAD);
+                Aws::Utils::CryptoBuffer buffer(length + PART_OVERHEAD);
+                memcpy(buffer.GetUnderlyingData(), ciphertext.c_str() + range.first, ciphertextLength);
+                ASSERT_TRUE(partsModule->DecryptPart(offset, length, buffer.GetUnderlyingData(), ciphertextLength, buffer.GetLength()));
+                ASSERT_EQ(plaintext.substr(offset, length), Aws::String(reinterpret_cast<const char*>(buffer.GetUnderlyingData()), length));
+            }
+        }
     };
 
     TEST_F(CryptoModulesTest, EncryptionOnlyOperationsTestWithSimpleEncryptionMaterials)
@@ -834,6 +933,54 @@ namespace
 #endif // !defined(NDEBUG) && defined(GTEST_HAS_DEATH_TEST)
 #endif
 
+    TEST_F(CryptoModulesTest, EncryptionOnlyPartsTest)
+    {
+        EncryptAndDecryptInParts(CryptoMode::ENCRYPTION_ONLY);
+    }
+
+#ifndef ENABLE_COMMONCRYPTO_ENCRYPTION
+    TEST_F(CryptoModulesTest, AuthenticatedEncryptionPartsTest)
+    {
+        EncryptAndDecryptInParts(CryptoMode::AUTHENTICATED_ENCRYPTION);
+    }
+
+    TEST_F(CryptoModulesTest, StrictAEPartDecryptionFailure)
+    {
+        SimpleEncryptionMaterials materials(Aws::Utils::Crypto::SymmetricCipher::GenerateKey());
+        CryptoConfiguration strictAEConfig(StorageMethod::METADATA, CryptoMode::STRICT_AUTHENTICATED_ENCRYPTION);
+        MockS3Client s3Client;
+        CryptoModuleFactory factory;
+        auto module = factory.FetchCryptoModule(Aws::MakeShared<SimpleEncryptionMaterials>(ALLOCATION_TAG, materials), strictAEConfig);
+
+        PutObjectRequest putRequest;
+        putRequest.SetBucket(BUCKET_TEST_NAME);
+        std::shared_ptr<Aws::IOStream> objectStream = Aws::MakeShared<Aws::StringStream>(ALLOCATION_TAG);
+        *objectStream << BODY_STREAM_TEST;
+        objectStream->flush();
+        putRequest.SetBody(objectStream);
+        putRequest.SetKey(KEY_TEST_NAME);
+        auto putObjectFunction = [&s3Client](Aws::S3::Model::PutObjectRequest putRequest) -> Aws::S3::Model::PutObjectOutcome { return s3Client.PutObject(putRequest); };
+        ASSERT_TRUE(module->PutObjectSecurely(putRequest, putObjectFunction).IsSuccess());
+
+        GetObjectRequest getRequest;
+        getRequest.SetBucket(BUCKET_TEST_NAME);
+        getRequest.SetKey(KEY_TEST_NAME);
+        HeadObjectRequest headObject;
+        headObject.WithBucket(BUCKET_TEST_NAME);
+        headObject.WithKey(KEY_TEST_NAME);
+        HeadObjectOutcome headOutcome = s3Client.HeadObject(headObject);
+        Aws::S3Encryption::Handlers::MetadataHandler handler;
+        ContentCryptoMaterial contentCryptoMaterial = handler.ReadContentCryptoMaterial(headOutcome.GetResult());
+        auto getObjectFunction = [&s3Client](Aws::S3::Model::GetObjectRequest getRequest) -> Aws::S3::Model::GetObjectOutcome { return s3Client.GetObject(getRequest); };
+
+        auto decryptionModule = factory.FetchCryptoModule(Aws::MakeShared<SimpleEncryptionMaterials>(ALLOCATION_TAG, materials), strictAEConfig);
+        auto initOutcome = decryptionModule->InitPartDecryption(getRequest, headOutcome.GetResult(), contentCryptoMaterial, getObjectFunction);
+        ASSERT_FALSE(initOutcome.IsSuccess());
+        ASSERT_EQ(S3Errors::INVALID_ACTION, initOutcome.GetError().GetErrorType().s3Error);
+        ASSERT_EQ(s3Client.m_getObjectCalled, 0u);
+    }
+#endif
+
     TEST_F(CryptoModulesTest, RangeParserSuccess)
     {
         SimpleEncryptionMaterials materials(Aws::Utils::Crypto::SymmetricCipher::GenerateKey());
@@ -23,10 +23,12 @@
 #include <aws/core/utils/crypto/ContentCryptoMaterial.h>
 #include <aws/s3-encryption/materials/SimpleEncryptionMaterials.h>
 #include <aws/s3-encryption/materials/KMSEncryptionMaterials.h>
+#include <aws/s3-encryption/materials/CachingEncryptionMaterials.h>
 #include <aws/kms/KMSClient.h>
 #include <aws/core/auth/AWSCredentialsProvider.h>
 #include <aws/core/utils/Outcome.h>
 #include <aws/core/client/ClientConfiguration.h>
+#include <thread>
 
 using namespace Aws::Client;
 using namespace Aws::Utils::Crypto;
@@ -103,6 +105,7 @@ namespace
     //No current functions.
     class SimpleEncryptionMaterialsTest : public ::testing::Test {};
     class KMSEncryptionMaterialsTest : public ::testing::Test {};
+    class CachingEncryptionMaterialsTest : public ::testing::Test {};
 
     //This is a simple encryption materials encrypt test using a generated symmetric master key with the same encryption materials.
     TEST_F(SimpleEncryptionMaterialsTest, EncryptDecryptSuccessTest)
@@ -393,6 +396,119 @@ namespace
         ASSERT_EQ(myClient->m_decryptCalledCount, 0u);
         ASSERT_EQ(myClient->m_encryptCalledCount, 0u);
     }
+
+    static ContentCryptoMaterial EncryptWithLength(EncryptionMaterials& encryptionMaterials, int64_t contentLength)
+    {
+        ContentCryptoMaterial contentCryptoMaterial(ContentCryptoScheme::GCM);
+        contentCryptoMaterial.SetUnencryptedContentLength(contentLength);
+        EXPECT_TRUE(encryptionMaterials.EncryptCEK(contentCryptoMaterial).IsSuccess());
+        return contentCryptoMaterial;
+    }
+
+    //This tests that a cached data key is handed out again, with its encrypted form, until it has encrypted the most messages it may.
+    TEST_F(CachingEncryptionMaterialsTest, TestEncryptReusesKeyUpToMessageLimit)
+    {
+        auto myClient = Aws::MakeShared<MockKMSClient>(AllocationTag, ClientConfiguration());
+        InitMockKMSClient(myClient);
+        auto kmsMaterials = Aws::MakeShared<KMSEncryptionMaterials>(AllocationTag, TEST_CMK_ID, myClient);
+        CachingEncryptionMaterials cachingMaterials(kmsMaterials, std::chrono::minutes(5), 3);
+
+        auto first = EncryptWithLength(cachingMaterials, 100);
+        auto second = EncryptWithLength(cachingMaterials, 100);
+        auto third = EncryptWithLength(cachingMaterials, 100);
+        ASSERT_EQ(myClient->m_encryptCalledCount, 1u);
+        ASSERT_EQ(first.GetContentEncryptionKey(), second.GetContentEncryptionKey());
+        ASSERT_EQ(first.GetContentEncryptionKey(), third.GetContentEncryptionKey());
+        ASSERT_EQ(first.GetEncryptedContentEncryptionKey(), third.GetEncryptedContentEncryptionKey());
+        ASSERT_EQ(KeyWrapAlgorithm::KMS, third.GetKeyWrapAlgorithm());
+        ASSERT_EQ(TEST_CMK_ID, third.GetMaterialsDescription().at(cmkID_Identifier));
+
+        auto fourth = EncryptWithLength(cachingMaterials, 100);
+        ASSERT_EQ(myClient->m_encryptCalledCount, 2u);
+        ASSERT_NE(first.GetContentEncryptionKey(), fourth.GetContentEncryptionKey());
+        ASSERT_EQ(cachingMaterials.GetCachedKeyCount(), 1u);
+    }
+
+    //This tests that a key is not reused past its byte limit, and that content of unknown length always gets a key of its own.
+    TEST_F(CachingEncryptionMaterialsTest, TestEncryptByteLimitAndUnknownLength)
+    {
+        auto myClient = Aws::MakeShared<MockKMSClient>(AllocationTag, ClientConfiguration());
+        InitMockKMSClient(myClient);
+        auto kmsMaterials = Aws::MakeShared<KMSEncryptionMaterials>(AllocationTag, TEST_CMK_ID, myClient);
+        CachingEncryptionMaterials cachingMaterials(kmsMaterials, std::chrono::minutes(5), 1000, 250);
+
+        auto first = EncryptWithLength(cachingMaterials, 100);
+        auto second = EncryptWithLength(cachingMaterials, 100);
+        ASSERT_EQ(first.GetContentEncryptionKey(), second.GetContentEncryptionKey());
+        auto third = EncryptWithLength(cachingMaterials, 100);
+        ASSERT_NE(first.GetContentEncryptionKey(), third.GetContentEncryptionKey());
+        ASSERT_EQ(myClient->m_encryptCalledCount, 2u);
+
+        auto tooLarge = EncryptWithLength(cachingMaterials, 300);
+        auto unknownLength = EncryptWithLength(cachingMaterials, -1);
+        ASSERT_EQ(myClient->m_encryptCalledCount, 4u);
+        ASSERT_NE(third.GetContentEncryptionKey(), tooLarge.GetContentEncryptionKey());
+        ASSERT_NE(third.GetContentEncryptionKey(), unknownLength.GetContentEncryptionKey());
+        ASSERT_EQ(cachingMaterials.GetCachedKeyCount(), 1u);
+    }
+
+    //This tests that cached keys expire after their maximum age.
+    TEST_F(CachingEncryptionMaterialsTest, TestCachedKeysExpire)
+    {
+        auto myClient = Aws::MakeShared<MockKMSClient>(AllocationTag, ClientConfiguration());
+        InitMockKMSClient(myClient);
+        auto kmsMaterials = Aws::MakeShared<KMSEncryptionMaterials>(AllocationTag, TEST_CMK_ID, myClient);
+        CachingEncryptionMaterials cachingMaterials(kmsMaterials, std::chrono::milliseconds(50));
+
+        auto first = EncryptWithLength(cachingMaterials, 100);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto second = EncryptWithLength(cachingMaterials, 100);
+        ASSERT_EQ(myClient->m_encryptCalledCount, 2u);
+        ASSERT_NE(first.GetContentEncryptionKey(), second.GetContentEncryptionKey());
+    }
+
+    //This tests that decrypted keys are cached by their encrypted form, and that the least recently used key leaves a full cache.
+    TEST_F(CachingEncryptionMaterialsTest, TestDecryptCacheAndCapacity)
+    {
+        auto myClient = Aws::MakeShared<MockKMSClient>(AllocationTag, ClientConfiguration());
+        InitMockKMSClient(myClient);
+        auto kmsMaterials = Aws::MakeShared<KMSEncryptionMaterials>(AllocationTag, TEST_CMK_ID, myClient);
+        CachingEncryptionMaterials cachingMaterials(kmsMaterials, std::chrono::minutes(5), 1000, 1ULL << 36, 2);
+
+        auto decrypt = [&](const CryptoBuffer& encryptedKey)
+        {
+            ContentCryptoMaterial contentCryptoMaterial;
+            contentCryptoMaterial.SetKeyWrapAlgorithm(KeyWrapAlgorithm::KMS);
+            contentCryptoMaterial.AddMaterialsDescription(cmkID_Identifier, TEST_CMK_ID);
+            contentCryptoMaterial.SetEncryptedContentEncryptionKey(encryptedKey);
+            EXPECT_TRUE(cachingMaterials.DecryptCEK(contentCryptoMaterial).IsSuccess());
+            return contentCryptoMaterial.GetContentEncryptionKey();
+        };
+
+        auto firstEncryptedKey = SymmetricCipher::GenerateKey();
+        auto secondEncryptedKey = SymmetricCipher::GenerateKey();
+        auto thirdEncryptedKey = SymmetricCipher::GenerateKey();
+        ASSERT_EQ(myClient->m_decryptedKey, decrypt(firstEncryptedKey));
+        ASSERT_EQ(myClient->m_decryptedKey, decrypt(firstEncryptedKey));
+        ASSERT_EQ(myClient->m_decryptCalledCount, 1u);
+
+        decrypt(secondEncryptedKey);
+        decrypt(firstEncryptedKey);
+        ASSERT_EQ(myClient->m_decryptCalledCount, 2u);
+
+        //the second key was used least recently, so it makes room for the third
+        decrypt(thirdEncryptedKey);
+        ASSERT_EQ(cachingMaterials.GetCachedKeyCount(), 2u);
+        decrypt(firstEncryptedKey);
+        ASSERT_EQ(myClient->m_decryptCalledCount, 3u);
+        decrypt(secondEncryptedKey);
+        ASSERT_EQ(myClient->m_decryptCalledCount, 4u);
+
+        cachingMaterials.Clear();
+        ASSERT_EQ(cachingMaterials.GetCachedKeyCount(), 0u);
+        decrypt(firstEncryptedKey);
+        ASSERT_EQ(myClient->m_decryptCalledCount, 5u);
+    }
 }
 
 #endif
\ No newline at end of file
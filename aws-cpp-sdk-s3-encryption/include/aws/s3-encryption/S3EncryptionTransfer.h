@@ -0,0 +1,68 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+#pragma once
+
+#include <aws/s3-encryption/s3Encryption_EXPORTS.h>
+#include <aws/s3-encryption/S3EncryptionClient.h>
+#include <aws/s3-encryption/modules/CryptoModuleFactory.h>
+#include <aws/transfer/TransferEncryption.h>
+#include <aws/s3/S3Client.h>
+
+namespace Aws
+{
+    namespace S3Encryption
+    {
+        /*
+        * Client-side encryption for TransferManager, compatible with S3EncryptionClient: objects uploaded through it can be read back with
+        * S3EncryptionClient::GetObject, and objects S3EncryptionClient put can be downloaded through it. Set it in TransferManagerConfiguration::encryption.
+        * Uploads are encrypted part by part with one content key. Downloads are decrypted part by part, which for objects encrypted with
+        * AES-GCM means in CTR mode without checking the tag, as S3EncryptionClient does for ranged gets; Strict Authenticated Encryption
+        * mode refuses such downloads. The S3 client is the one the crypto material, metadata aside, is read and written with.
+        */
+        class AWS_S3ENCRYPTION_API S3EncryptionTransfer : public Aws::Transfer::TransferEncryption
+        {
+        public:
+            S3EncryptionTransfer(const std::shared_ptr<Aws::Utils::Crypto::EncryptionMaterials>& encryptionMaterials, const Aws::S3Encryption::CryptoConfiguration& cryptoConfig,
+                const std::shared_ptr<Aws::S3::S3Client>& s3Client);
+
+            /*
+            * AES block size.
+            */
+            size_t GetBlockSize() const override;
+
+            /*
+            * Three blocks: the IV block before a ranged CBC part, the block after it, and the room the cipher needs to decrypt in place.
+            */
+            size_t GetMaxPartOverhead() const override;
+
+            Aws::Transfer::PartEncryptorOutcome BeginUpload(Aws::S3::Model::CreateMultipartUploadRequest& request) override;
+
+            Aws::Transfer::PartEncryptorOutcome BeginUpload(Aws::S3::Model::PutObjectRequest& request) override;
+
+            Aws::Transfer::PartDecryptorOutcome BeginDownload(const Aws::S3::Model::HeadObjectRequest& request, const Aws::S3::Model::HeadObjectResult& result) override;
+
+        private:
+            /*
+            * Function to get the instruction file object of an encrypted object from S3.
+            */
+            Aws::S3::Model::GetObjectOutcome GetInstructionFileObject(const Aws::S3::Model::HeadObjectRequest& headRequest) const;
+
+            std::shared_ptr<Aws::S3::S3Client> m_s3Client;
+            Aws::S3Encryption::Modules::CryptoModuleFactory m_cryptoModuleFactory;
+            std::shared_ptr<Aws::Utils::Crypto::EncryptionMaterials> m_encryptionMaterials;
+            const Aws::S3Encryption::CryptoConfiguration m_cryptoConfig;
+        };
+    }
+}
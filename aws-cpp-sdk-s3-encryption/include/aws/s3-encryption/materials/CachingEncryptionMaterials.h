@@ -0,0 +1,122 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+#pragma once
+#include <aws/core/utils/crypto/EncryptionMaterials.h>
+#include <aws/core/utils/crypto/ContentCryptoMaterial.h>
+#include <aws/core/utils/memory/stl/AWSList.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSString.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+#include <aws/s3-encryption/s3Encryption_EXPORTS.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+using namespace Aws::Utils::Crypto;
+
+namespace Aws
+{
+    namespace S3Encryption
+    {
+        namespace Materials
+        {
+            /*
+            * Caching Encryption Materials wraps other encryption materials, typically KMS Encryption Materials, and caches the content
+            * encryption keys they encrypt and decrypt, so that putting and getting many objects doesn't take a call to KMS for each.
+            * A data key encrypted for one object is reused for the next objects with the same materials description and content crypto
+            * scheme, until it is maxAge old or has encrypted maxMessagesPerKey objects or maxBytesPerKey bytes. Objects of unknown length,
+            * such as multipart uploads, always get a key of their own. Decrypted keys are cached by their encrypted form, materials
+            * description and key wrap algorithm, until they are maxAge old.
+            * At most capacity keys are cached, least recently used first out. Cached keys are kept in memory that is locked out of swap
+            * and core dumps where the platform allows, and zeroed when they leave the cache. Thread safe.
+            */
+            class AWS_S3ENCRYPTION_API CachingEncryptionMaterials : public Aws::Utils::Crypto::EncryptionMaterials
+            {
+            public:
+                /*
+                Initialize with the encryption materials to cache and the limits on cached keys.
+                */
+                CachingEncryptionMaterials(const std::shared_ptr<Aws::Utils::Crypto::EncryptionMaterials>& encryptionMaterials, std::chrono::milliseconds maxAge,
+                    uint64_t maxMessagesPerKey = 1000, uint64_t maxBytesPerKey = 1ULL << 36, size_t capacity = 1000);
+
+                ~CachingEncryptionMaterials();
+
+                CachingEncryptionMaterials(const CachingEncryptionMaterials&) = delete;
+                CachingEncryptionMaterials& operator=(const CachingEncryptionMaterials&) = delete;
+
+                /*
+                * This will replace the cek with a cached data key and its encrypted form if one is still good for the content, and
+                * otherwise encrypt the cek with the wrapped materials and cache it.
+                */
+                CryptoOutcome EncryptCEK(Aws::Utils::Crypto::ContentCryptoMaterial& contentCryptoMaterial) override;
+
+                /*
+                * This will decrypt the cek from the cache if it was decrypted before, and otherwise with the wrapped materials.
+                */
+                CryptoOutcome DecryptCEK(Aws::Utils::Crypto::ContentCryptoMaterial& contentCryptoMaterial) override;
+
+                /*
+                * Number of keys in the cache, encrypting and decrypting ones together.
+                */
+                size_t GetCachedKeyCount() const;
+
+                /*
+                * Removes all keys from the cache.
+                */
+                void Clear();
+
+            private:
+                struct CachedKey
+                {
+                    size_t slot;
+                    Aws::Utils::CryptoBuffer encryptedKey;
+                    Aws::Utils::Crypto::KeyWrapAlgorithm keyWrapAlgorithm;
+                    Aws::Map<Aws::String, Aws::String> materialsDescription;
+                    std::chrono::steady_clock::time_point created;
+                    uint64_t messages;
+                    uint64_t bytes;
+                    Aws::List<Aws::String>::iterator lruPosition;
+                };
+
+                /*
+                * Caches contentKey under cacheKey, evicting the least recently used key if the cache is full. Called with m_cacheLock held.
+                */
+                CachedKey& Insert(const Aws::String& cacheKey, const Aws::Utils::CryptoBuffer& contentKey);
+
+                /*
+                * Zeroes the key's slot and removes it from the cache. Called with m_cacheLock held.
+                */
+                void Evict(Aws::Map<Aws::String, CachedKey>::iterator entry);
+
+                inline unsigned char* GetSlot(size_t slot) const { return m_keySlots + slot * KEY_SLOT_SIZE; }
+
+                static const size_t KEY_SLOT_SIZE = 32;
+
+                std::shared_ptr<Aws::Utils::Crypto::EncryptionMaterials> m_encryptionMaterials;
+                std::chrono::milliseconds m_maxAge;
+                uint64_t m_maxMessagesPerKey;
+                uint64_t m_maxBytesPerKey;
+                size_t m_capacity;
+                mutable std::mutex m_cacheLock;
+                Aws::Map<Aws::String, CachedKey> m_cachedKeys;
+                Aws::List<Aws::String> m_leastRecentlyUsed;
+                Aws::Vector<size_t> m_freeSlots;
+                unsigned char* m_keySlots;
+                size_t m_mappedSize;
+            };
+        }//namespace Materials
+    }//namespace S3Encryption
+}//namespace Aws
@@ -30,6 +30,10 @@
 #include <aws/s3/model/GetObjectResult.h>
 #include <aws/s3/model/GetObjectRequest.h>
 #include <aws/s3/model/HeadObjectRequest.h>
+#include <aws/core/NoResult.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <mutex>
 
 namespace Aws
 {
@@ -39,6 +43,7 @@ namespace Aws
         {
             typedef std::function <Aws::S3::Model::PutObjectOutcome(const Aws::S3::Model::PutObjectRequest&)> PutObjectFunction;
             typedef std::function <Aws::S3::Model::GetObjectOutcome(const Aws::S3::Model::GetObjectRequest&)> GetObjectFunction;
+            typedef Aws::Utils::Outcome<Aws::NoResult, AWSError<S3EncryptionErrors>> S3EncryptionPartsOutcome;
 
             class AWS_S3ENCRYPTION_API CryptoModule
             {
@@ -70,7 +75,48 @@ namespace Aws
                 */
                 static std::pair<int64_t, int64_t> ParseGetObjectRequestRange(const Aws::String& range, int64_t contentLength);
 
+                /*
+                * Function to start encrypting an object part by part, for a multipart upload. Generates the content key and stores the crypto material
+                * in the request's metadata or in an instruction file, like PutObjectSecurely. The body is not sent; the parts are encrypted with EncryptPart.
+                */
+                S3EncryptionPartsOutcome InitPartEncryption(Aws::S3::Model::PutObjectRequest& request, const PutObjectFunction& putObjectFunction);
+
+                /*
+                * Function to encrypt a part in place, returning the length of its ciphertext or 0 on failure. The first time through, parts must come in order.
+                * Parts other than the last must be whole cipher blocks and come out as long as they went in; the last comes out with the CBC padding
+                * or GCM tag appended, so capacity must leave room for another 2 blocks. A part encrypted before, for a retry, comes out the same again.
+                */
+                size_t EncryptPart(int partNumber, unsigned char* buffer, size_t length, size_t capacity, bool lastPart);
+
+                /*
+                * Function to start decrypting an object part by part, for parallel ranged gets. Decrypts the content key and works out the length of the
+                * plain text, which for CBC takes a get of the last 2 blocks. Fails in Strict AE mode, which doesn't allow ranged gets.
+                */
+                S3EncryptionPartsOutcome InitPartDecryption(const Aws::S3::Model::GetObjectRequest& request, const Aws::S3::Model::HeadObjectResult& headObjectResult,
+                    const Aws::Utils::Crypto::ContentCryptoMaterial& contentCryptoMaterial, const GetObjectFunction& getObjectFunction);
+
+                /*
+                * The length of the decrypted object, once InitPartDecryption succeeded.
+                */
+                inline uint64_t GetPlaintextLength() const { return m_plaintextLength; }
+
+                /*
+                * Function returning the first and last bytes of ciphertext needed to decrypt length bytes of plain text from offset, a multiple of the block size.
+                */
+                virtual std::pair<uint64_t, uint64_t> GetPartCiphertextRange(uint64_t offset, size_t length) const = 0;
+
+                /*
+                * Function to decrypt, in place, the ciphertext fetched from GetPartCiphertextRange(offset, length), leaving the plain text at the start of buffer.
+                * Thread safe. In AE mode parts are decrypted in CTR mode, like other ranged gets, so the GCM tag is not checked.
+                */
+                virtual bool DecryptPart(uint64_t offset, size_t length, unsigned char* buffer, size_t ciphertextLength, size_t capacity) const = 0;
+
             private:
+                /*
+                * This function generates the content key, initializes the encryption cipher and stores the crypto material in the request's metadata or in an instruction file.
+                */
+                S3EncryptionPutObjectOutcome InitEncryptionMaterial(Aws::S3::Model::PutObjectRequest& request, const PutObjectFunction& putObjectFunction);
+
                 /*
                 * This function is used to encrypt the given S3 PutObjectRequest.
                 */
@@ -117,10 +163,39 @@ namespace Aws
                 */
                 virtual std::pair<int64_t, int64_t> AdjustRange(Aws::S3::Model::GetObjectRequest& getObjectRequest, const Aws::S3::Model::HeadObjectResult& headObjectResult) = 0;
 
+                /*
+                * This function creates a cipher that picks the content up at offset, a multiple of the block size, given the ciphertext block before it (the IV at offset 0).
+                */
+                virtual std::shared_ptr<Aws::Utils::Crypto::SymmetricCipher> CreatePartCipher(uint64_t offset, const Aws::Utils::CryptoBuffer& previousBlock) const = 0;
+
+                /*
+                * This function works out the length of the plain text for InitPartDecryption, or fails if the module can't decrypt parts.
+                */
+                virtual S3EncryptionPartsOutcome ComputePlaintextLength(const Aws::S3::Model::GetObjectRequest& request, const Aws::S3::Model::HeadObjectResult& headObjectResult,
+                    const GetObjectFunction& getObjectFunction) = 0;
+
                 std::shared_ptr<Aws::Utils::Crypto::EncryptionMaterials> m_encryptionMaterials;
                 Aws::Utils::Crypto::ContentCryptoMaterial m_contentCryptoMaterial;
                 CryptoConfiguration m_cryptoConfig;
                 std::shared_ptr<Aws::Utils::Crypto::SymmetricCipher> m_cipher;
+                uint64_t m_plaintextLength;
+
+            private:
+                /*
+                * Where an encrypted part starts in the plain text, and the ciphertext block before it.
+                */
+                struct EncryptedPart
+                {
+                    uint64_t offset;
+                    Aws::Utils::CryptoBuffer previousBlock;
+                };
+
+                std::mutex m_partsLock;
+                Aws::Vector<EncryptedPart> m_encryptedParts;
+                Aws::Utils::CryptoBuffer m_previousBlock;
+                Aws::Utils::CryptoBuffer m_finalBlocks;
+                uint64_t m_nextPartOffset;
+                bool m_partsFinalized;
             };
 
             class AWS_S3ENCRYPTION_API CryptoModuleEO : public CryptoModule
@@ -131,6 +206,16 @@ namespace Aws
                 */
                 CryptoModuleEO(const std::shared_ptr<Aws::Utils::Crypto::EncryptionMaterials>& encryptionMaterials, const CryptoConfiguration & cryptoConfig);
 
+                /*
+                * Function returning the ciphertext range to fetch for a part of the plain text.
+                */
+                std::pair<uint64_t, uint64_t> GetPartCiphertextRange(uint64_t offset, size_t length) const override;
+
+                /*
+                * Function to decrypt a part of the object in place.
+                */
+                bool DecryptPart(uint64_t offset, size_t length, unsigned char* buffer, size_t ciphertextLength, size_t capacity) const override;
+
             private:
                 /*
                 * Function to set content length of request which accounts for CBC padding.
@@ -166,6 +251,17 @@ namespace Aws
                 * Function to adjust getObjectRequest range to only specify the encrypted body.
                 */
                 std::pair<int64_t, int64_t> AdjustRange(Aws::S3::Model::GetObjectRequest& getObjectRequest, const Aws::S3::Model::HeadObjectResult& headObjectResult) override;
+
+                /*
+                * Function to create a cipher for a part, in CBC mode chained from the block before it.
+                */
+                std::shared_ptr<Aws::Utils::Crypto::SymmetricCipher> CreatePartCipher(uint64_t offset, const Aws::Utils::CryptoBuffer& previousBlock) const override;
+
+                /*
+                * Function to work out the length of the plain text, from the padding of the last block.
+                */
+                S3EncryptionPartsOutcome ComputePlaintextLength(const Aws::S3::Model::GetObjectRequest& request, const Aws::S3::Model::HeadObjectResult& headObjectResult,
+                    const GetObjectFunction& getObjectFunction) override;
             };
 
             class AWS_S3ENCRYPTION_API CryptoModuleAE : public CryptoModule
@@ -176,6 +272,16 @@ namespace Aws
                 */
                 CryptoModuleAE(const std::shared_ptr<Aws::Utils::Crypto::EncryptionMaterials>& encryptionMaterials, const CryptoConfiguration & cryptoConfig);
 
+                /*
+                * Function returning the ciphertext range to fetch for a part of the plain text.
+                */
+                std::pair<uint64_t, uint64_t> GetPartCiphertextRange(uint64_t offset, size_t length) const override;
+
+                /*
+                * Function to decrypt a part of the object in place.
+                */
+                bool DecryptPart(uint64_t offset, size_t length, unsigned char* buffer, size_t ciphertextLength, size_t capacity) const override;
+
             private:
                 /*
                 * Function to set content length of request which accounts for the GCM tag appended to the body of the request.
@@ -210,6 +316,17 @@ namespace Aws
                 * Function adjust getObjectRequest range to only specify the encrypted body.
                 */
                 std::pair<int64_t, int64_t> AdjustRange(Aws::S3::Model::GetObjectRequest& getObjectRequest, const Aws::S3::Model::HeadObjectResult& headObjectResult) override;
+
+                /*
+                * Function to create a cipher for a part, in CTR mode with the GCM counter for its offset.
+                */
+                std::shared_ptr<Aws::Utils::Crypto::SymmetricCipher> CreatePartCipher(uint64_t offset, const Aws::Utils::CryptoBuffer& previousBlock) const override;
+
+                /*
+                * Function to work out the length of the plain text, which is the ciphertext without its tag.
+                */
+                S3EncryptionPartsOutcome ComputePlaintextLength(const Aws::S3::Model::GetObjectRequest& request, const Aws::S3::Model::HeadObjectResult& headObjectResult,
+                    const GetObjectFunction& getObjectFunction) override;
             };
 
             class AWS_S3ENCRYPTION_API CryptoModuleStrictAE : public CryptoModule
@@ -220,6 +337,16 @@ namespace Aws
                 */
                 CryptoModuleStrictAE(const std::shared_ptr<Aws::Utils::Crypto::EncryptionMaterials>& encryptionMaterials, const CryptoConfiguration & cryptoConfig);
 
+                /*
+                * Function returning the ciphertext range to fetch for a part of the plain text.
+                */
+                std::pair<uint64_t, uint64_t> GetPartCiphertextRange(uint64_t offset, size_t length) const override;
+
+                /*
+                * Parts can't be decrypted in Strict AE mode; always fails.
+                */
+                bool DecryptPart(uint64_t offset, size_t length, unsigned char* buffer, size_t ciphertextLength, size_t capacity) const override;
+
             private:
                 /*
                 * Function to set content length of request which accounts for the GCM tag appended to the body of the request.
@@ -254,6 +381,17 @@ namespace Aws
                 * Function adjust getObjectRequest range to only specify the encrypted body.
                 */
                 std::pair<int64_t, int64_t> AdjustRange(Aws::S3::Model::GetObjectRequest& getObjectRequest, const Aws::S3::Model::HeadObjectResult& headObjectResult) override;
+
+                /*
+                * Function to create a cipher for a part, in CTR mode with the GCM counter for its offset.
+                */
+                std::shared_ptr<Aws::Utils::Crypto::SymmetricCipher> CreatePartCipher(uint64_t offset, const Aws::Utils::CryptoBuffer& previousBlock) const override;
+
+                /*
+                * Function to work out the length of the plain text; fails, since Strict AE doesn't allow ranged gets.
+                */
+                S3EncryptionPartsOutcome ComputePlaintextLength(const Aws::S3::Model::GetObjectRequest& request, const Aws::S3::Model::HeadObjectResult& headObjectResult,
+                    const GetObjectFunction& getObjectFunction) override;
             };
 
             /**
@@ -275,6 +413,11 @@ namespace Aws
                  */
                 Aws::Utils::CryptoBuffer EncryptBuffer(const Aws::Utils::CryptoBuffer& unEncryptedData) override;
 
+                /**
+                 * Calls straight through to internal cipher, which encrypts in place.
+                 */
+                size_t EncryptBufferInto(const unsigned char* unEncryptedData, size_t length, unsigned char* output, size_t outputCapacity) override;
+
                 /**
                  * Finalize Encryption, returns whatever is left in the cipher, computes the tag, and appends the tag to the output.
                  *  Calls FinalizeEncryption on the underlying cipher first.
@@ -0,0 +1,207 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+#include <aws/s3-encryption/S3EncryptionTransfer.h>
+#include <aws/s3-encryption/modules/CryptoModule.h>
+#include <aws/s3-encryption/handlers/InstructionFileHandler.h>
+#include <aws/s3-encryption/handlers/MetadataHandler.h>
+#include <aws/core/utils/memory/stl/AWSAllocator.h>
+#include <aws/core/utils/logging/LogMacros.h>
+
+using namespace Aws::Utils::Crypto;
+using namespace Aws::Transfer;
+namespace Aws
+{
+    namespace S3Encryption
+    {
+        static const char* const ALLOCATION_TAG = "S3EncryptionTransfer";
+        static const size_t AES_BLOCK_SIZE = 16u;
+        static const size_t MAX_PART_OVERHEAD_BLOCKS = 3u;
+        using namespace Aws::S3;
+        using namespace Aws::S3::Model;
+        using namespace Aws::S3Encryption::Modules;
+
+        /*
+        * Encrypts the parts of an upload with the module InitPartEncryption was called on.
+        */
+        class ModulePartEncryptor : public PartEncryptor
+        {
+        public:
+            ModulePartEncryptor(const std::shared_ptr<CryptoModule>& module) : m_module(module) {}
+
+            size_t EncryptPart(int partNumber, unsigned char* buffer, size_t length, size_t capacity, bool lastPart) override
+            {
+                return m_module->EncryptPart(partNumber, buffer, length, capacity, lastPart);
+            }
+
+        private:
+            std::shared_ptr<CryptoModule> m_module;
+        };
+
+        /*
+        * Decrypts the parts of a download with the module InitPartDecryption was called on.
+        */
+        class ModulePartDecryptor : public PartDecryptor
+        {
+        public:
+            ModulePartDecryptor(const std::shared_ptr<CryptoModule>& module) : m_module(module) {}
+
+            uint64_t GetPlaintextLength() const override
+            {
+                return m_module->GetPlaintextLength();
+            }
+
+            std::pair<uint64_t, uint64_t> GetCiphertextRange(uint64_t offset, size_t length) const override
+            {
+                return m_module->GetPartCiphertextRange(offset, length);
+            }
+
+            bool DecryptPart(uint64_t offset, size_t length, unsigned char* buffer, size_t ciphertextLength, size_t capacity) const override
+            {
+                return m_module->DecryptPart(offset, length, buffer, ciphertextLength, capacity);
+            }
+
+        private:
+            std::shared_ptr<CryptoModule> m_module;
+        };
+
+        static AWSError<S3Errors> BuildTransferError(const AWSError<S3EncryptionErrors>& error)
+        {
+            S3Errors errorType = error.GetErrorType().IsS3Error() ? error.GetErrorType().s3Error : S3Errors::INTERNAL_FAILURE;
+            AWSError<S3Errors> transferError(errorType, error.GetExceptionName(), error.GetMessage(), error.ShouldRetry());
+            transferError.SetResponseCode(error.GetResponseCode());
+            transferError.SetResponseHeaders(error.GetResponseHeaders());
+            return transferError;
+        }
+
+        S3EncryptionTransfer::S3EncryptionTransfer(const std::shared_ptr<EncryptionMaterials>& encryptionMaterials, const Aws::S3Encryption::CryptoConfiguration& cryptoConfig,
+            const std::shared_ptr<S3Client>& s3Client) :
+            m_s3Client(s3Client), m_cryptoModuleFactory(), m_encryptionMaterials(encryptionMaterials), m_cryptoConfig(cryptoConfig)
+        {
+        }
+
+        size_t S3EncryptionTransfer::GetBlockSize() const
+        {
+            return AES_BLOCK_SIZE;
+        }
+
+        size_t S3EncryptionTransfer::GetMaxPartOverhead() const
+        {
+            return MAX_PART_OVERHEAD_BLOCKS * AES_BLOCK_SIZE;
+        }
+
+        PartEncryptorOutcome S3EncryptionTransfer::BeginUpload(CreateMultipartUploadRequest& request)
+        {
+            // the crypto material is stored the way a PutObject would store it, then carried over to the multi-part upload
+            PutObjectRequest putObjectRequest;
+            putObjectRequest.WithBucket(request.GetBucket());
+            putObjectRequest.WithKey(request.GetKey());
+            putObjectRequest.SetMetadata(request.GetMetadata());
+            auto encryptorOutcome = BeginUpload(putObjectRequest);
+            if (encryptorOutcome.IsSuccess())
+            {
+                for (const auto& metadata : putObjectRequest.GetMetadata())
+                {
+                    request.AddMetadata(metadata.first, metadata.second);
+                }
+            }
+            return encryptorOutcome;
+        }
+
+        PartEncryptorOutcome S3EncryptionTransfer::BeginUpload(PutObjectRequest& request)
+        {
+            auto module = m_cryptoModuleFactory.FetchCryptoModule(m_encryptionMaterials, m_cryptoConfig);
+            auto putObjectFunction = [this](const PutObjectRequest& putRequest) { return m_s3Client->PutObject(putRequest); };
+            auto initOutcome = module->InitPartEncryption(request, putObjectFunction);
+            if (!initOutcome.IsSuccess())
+            {
+                return PartEncryptorOutcome(BuildTransferError(initOutcome.GetError()));
+            }
+            return PartEncryptorOutcome(std::static_pointer_cast<PartEncryptor>(Aws::MakeShared<ModulePartEncryptor>(ALLOCATION_TAG, module)));
+        }
+
+        PartDecryptorOutcome S3EncryptionTransfer::BeginDownload(const HeadObjectRequest& request, const HeadObjectResult& result)
+        {
+            auto headMetadata = result.GetMetadata();
+            auto metadataEnd = headMetadata.end();
+            CryptoConfiguration decryptionCryptoConfig;
+            headMetadata.find(CONTENT_KEY_HEADER) != metadataEnd && headMetadata.find(IV_HEADER) != metadataEnd
+                ? decryptionCryptoConfig.SetStorageMethod(StorageMethod::METADATA)
+                : decryptionCryptoConfig.SetStorageMethod(StorageMethod::INSTRUCTION_FILE);
+
+            ContentCryptoMaterial contentCryptoMaterial;
+            if (decryptionCryptoConfig.GetStorageMethod() == StorageMethod::INSTRUCTION_FILE)
+            {
+                GetObjectOutcome instructionOutcome = GetInstructionFileObject(request);
+                if (!instructionOutcome.IsSuccess())
+                {
+                    return PartDecryptorOutcome(instructionOutcome.GetError());
+                }
+                Handlers::InstructionFileHandler handler;
+                contentCryptoMaterial = handler.ReadContentCryptoMaterial(instructionOutcome.GetResult());
+            }
+            else
+            {
+                Handlers::MetadataHandler handler;
+                contentCryptoMaterial = handler.ReadContentCryptoMaterial(result);
+            }
+
+            if (contentCryptoMaterial.GetContentCryptoScheme() == ContentCryptoScheme::CBC)
+            {
+                decryptionCryptoConfig.SetCryptoMode(CryptoMode::ENCRYPTION_ONLY);
+            }
+            else if (m_cryptoConfig.GetCryptoMode() != CryptoMode::STRICT_AUTHENTICATED_ENCRYPTION &&
+                contentCryptoMaterial.GetContentCryptoScheme() == ContentCryptoScheme::GCM)
+            {
+                decryptionCryptoConfig.SetCryptoMode(CryptoMode::AUTHENTICATED_ENCRYPTION);
+            }
+            else
+            {
+                decryptionCryptoConfig.SetCryptoMode(CryptoMode::STRICT_AUTHENTICATED_ENCRYPTION);
+            }
+
+            GetObjectRequest getObjectRequest;
+            getObjectRequest.WithBucket(request.GetBucket());
+            getObjectRequest.WithKey(request.GetKey());
+            if (!request.GetVersionId().empty())
+            {
+                getObjectRequest.SetVersionId(request.GetVersionId());
+            }
+
+            auto module = m_cryptoModuleFactory.FetchCryptoModule(m_encryptionMaterials, decryptionCryptoConfig);
+            auto getObjectFunction = [this](const GetObjectRequest& getRequest) { return m_s3Client->GetObject(getRequest); };
+            auto initOutcome = module->InitPartDecryption(getObjectRequest, result, contentCryptoMaterial, getObjectFunction);
+            if (!initOutcome.IsSuccess())
+            {
+                return PartDecryptorOutcome(BuildTransferError(initOutcome.GetError()));
+            }
+            return PartDecryptorOutcome(std::static_pointer_cast<PartDecryptor>(Aws::MakeShared<ModulePartDecryptor>(ALLOCATION_TAG, module)));
+        }
+
+        GetObjectOutcome S3EncryptionTransfer::GetInstructionFileObject(const HeadObjectRequest& headRequest) const
+        {
+            GetObjectRequest instructionFileRequest;
+            instructionFileRequest.SetKey(headRequest.GetKey() + Handlers::DEFAULT_INSTRUCTION_FILE_SUFFIX);
+            instructionFileRequest.SetBucket(headRequest.GetBucket());
+            GetObjectOutcome instructionOutcome = m_s3Client->GetObject(instructionFileRequest);
+            if (!instructionOutcome.IsSuccess())
+            {
+                AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Instruction file get operation not successful: "
+                    << instructionOutcome.GetError().GetExceptionName() << " : "
+                    << instructionOutcome.GetError().GetMessage());
+            }
+            return instructionOutcome;
+        }
+    }
+}
@@ -0,0 +1,239 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+#include <aws/s3-encryption/materials/CachingEncryptionMaterials.h>
+#include <aws/core/platform/Security.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/memory/AWSMemory.h>
+#include <aws/core/utils/logging/LogMacros.h>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace Aws::Utils;
+using namespace Aws::Utils::Crypto;
+
+namespace Aws
+{
+    namespace S3Encryption
+    {
+        namespace Materials
+        {
+            static const char* const ALLOCATION_TAG = "CachingEncryptionMaterials";
+
+            /*
+            * The part of a cache key that says which materials description it is for; lengths keep descriptions from running together.
+            */
+            static Aws::String SerializeMaterialsDescription(const Aws::Map<Aws::String, Aws::String>& materialsDescription)
+            {
+                Aws::String serialized;
+                for (const auto& entry : materialsDescription)
+                {
+                    serialized += StringUtils::to_string(entry.first.size()) + ":" + entry.first + StringUtils::to_string(entry.second.size()) + ":" + entry.second;
+                }
+                return serialized;
+            }
+
+            CachingEncryptionMaterials::CachingEncryptionMaterials(const std::shared_ptr<EncryptionMaterials>& encryptionMaterials, std::chrono::milliseconds maxAge,
+                uint64_t maxMessagesPerKey, uint64_t maxBytesPerKey, size_t capacity) :
+                m_encryptionMaterials(encryptionMaterials), m_maxAge(maxAge), m_maxMessagesPerKey(maxMessagesPerKey), m_maxBytesPerKey(maxBytesPerKey),
+                m_capacity(capacity), m_keySlots(nullptr), m_mappedSize(0)
+            {
+                size_t slotsSize = (std::max)(m_capacity, static_cast<size_t>(1)) * KEY_SLOT_SIZE;
+#ifdef __linux__
+                // the keys get pages of their own, kept out of swap and core dumps
+                size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+                size_t mappedSize = (slotsSize + pageSize - 1) / pageSize * pageSize;
+                void* pages = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (pages != MAP_FAILED)
+                {
+                    if (mlock(pages, mappedSize) != 0)
+                    {
+                        AWS_LOGSTREAM_WARN(ALLOCATION_TAG, "Failed to lock " << mappedSize << " bytes of memory for cached keys; they may be swapped out.");
+                    }
+#ifdef MADV_DONTDUMP
+                    madvise(pages, mappedSize, MADV_DONTDUMP);
+#endif
+                    m_keySlots = static_cast<unsigned char*>(pages);
+                    m_mappedSize = mappedSize;
+                }
+#endif
+                if (!m_keySlots)
+                {
+                    m_keySlots = static_cast<unsigned char*>(Aws::Malloc(ALLOCATION_TAG, slotsSize));
+                }
+                memset(m_keySlots, 0, slotsSize);
+
+                m_freeSlots.reserve(m_capacity);
+                for (size_t slot = m_capacity; slot > 0; --slot)
+                {
+                    m_freeSlots.push_back(slot - 1);
+                }
+            }
+
+            CachingEncryptionMaterials::~CachingEncryptionMaterials()
+            {
+                Clear();
+#ifdef __linux__
+                if (m_mappedSize)
+                {
+                    munlock(m_keySlots, m_mappedSize);
+                    munmap(m_keySlots, m_mappedSize);
+                    return;
+                }
+#endif
+                Aws::Free(m_keySlots);
+            }
+
+            CryptoOutcome CachingEncryptionMaterials::EncryptCEK(ContentCryptoMaterial& contentCryptoMaterial)
+            {
+                int64_t contentLength = contentCryptoMaterial.GetUnencryptedContentLength();
+                bool cacheable = m_capacity > 0 && contentLength >= 0 && static_cast<uint64_t>(contentLength) <= m_maxBytesPerKey && m_maxMessagesPerKey > 0 &&
+                    contentCryptoMaterial.GetContentEncryptionKey().GetLength() == KEY_SLOT_SIZE;
+                if (!cacheable)
+                {
+                    return m_encryptionMaterials->EncryptCEK(contentCryptoMaterial);
+                }
+
+                Aws::String cacheKey = "E" + ContentCryptoSchemeMapper::GetNameForContentCryptoScheme(contentCryptoMaterial.GetContentCryptoScheme()) + "|" +
+                    SerializeMaterialsDescription(contentCryptoMaterial.GetMaterialsDescription());
+                {
+                    std::lock_guard<std::mutex> locker(m_cacheLock);
+                    auto entry = m_cachedKeys.find(cacheKey);
+                    if (entry != m_cachedKeys.end())
+                    {
+                        CachedKey& cachedKey = entry->second;
+                        if (std::chrono::steady_clock::now() - cachedKey.created < m_maxAge && cachedKey.messages < m_maxMessagesPerKey &&
+                            cachedKey.bytes + static_cast<uint64_t>(contentLength) <= m_maxBytesPerKey)
+                        {
+                            ++cachedKey.messages;
+                            cachedKey.bytes += static_cast<uint64_t>(contentLength);
+                            m_leastRecentlyUsed.splice(m_leastRecentlyUsed.end(), m_leastRecentlyUsed, cachedKey.lruPosition);
+                            contentCryptoMaterial.SetContentEncryptionKey(CryptoBuffer(GetSlot(cachedKey.slot), KEY_SLOT_SIZE));
+                            contentCryptoMaterial.SetEncryptedContentEncryptionKey(cachedKey.encryptedKey);
+                            contentCryptoMaterial.SetKeyWrapAlgorithm(cachedKey.keyWrapAlgorithm);
+                            contentCryptoMaterial.SetMaterialsDescription(cachedKey.materialsDescription);
+                            return CryptoOutcome(Aws::NoResult());
+                        }
+                        // used up; the key encrypted next replaces it
+                        Evict(entry);
+                    }
+                }
+
+                auto outcome = m_encryptionMaterials->EncryptCEK(contentCryptoMaterial);
+                if (!outcome.IsSuccess())
+                {
+                    return outcome;
+                }
+
+                std::lock_guard<std::mutex> locker(m_cacheLock);
+                CachedKey& cachedKey = Insert(cacheKey, contentCryptoMaterial.GetContentEncryptionKey());
+                cachedKey.encryptedKey = contentCryptoMaterial.GetEncryptedContentEncryptionKey();
+                cachedKey.keyWrapAlgorithm = contentCryptoMaterial.GetKeyWrapAlgorithm();
+                cachedKey.materialsDescription = contentCryptoMaterial.GetMaterialsDescription();
+                cachedKey.messages = 1;
+                cachedKey.bytes = static_cast<uint64_t>(contentLength);
+                return outcome;
+            }
+
+            CryptoOutcome CachingEncryptionMaterials::DecryptCEK(ContentCryptoMaterial& contentCryptoMaterial)
+            {
+                const CryptoBuffer& encryptedKey = contentCryptoMaterial.GetEncryptedContentEncryptionKey();
+                if (m_capacity == 0 || encryptedKey.GetLength() == 0)
+                {
+                    return m_encryptionMaterials->DecryptCEK(contentCryptoMaterial);
+                }
+
+                Aws::String cacheKey = "D" + KeyWrapAlgorithmMapper::GetNameForKeyWrapAlgorithm(contentCryptoMaterial.GetKeyWrapAlgorithm()) + "|" +
+                    SerializeMaterialsDescription(contentCryptoMaterial.GetMaterialsDescription()) + "|" +
+                    Aws::String(reinterpret_cast<const char*>(encryptedKey.GetUnderlyingData()), encryptedKey.GetLength());
+                {
+                    std::lock_guard<std::mutex> locker(m_cacheLock);
+                    auto entry = m_cachedKeys.find(cacheKey);
+                    if (entry != m_cachedKeys.end())
+                    {
+                        CachedKey& cachedKey = entry->second;
+                        if (std::chrono::steady_clock::now() - cachedKey.created < m_maxAge)
+                        {
+                            m_leastRecentlyUsed.splice(m_leastRecentlyUsed.end(), m_leastRecentlyUsed, cachedKey.lruPosition);
+                            contentCryptoMaterial.SetContentEncryptionKey(CryptoBuffer(GetSlot(cachedKey.slot), KEY_SLOT_SIZE));
+                            return CryptoOutcome(Aws::NoResult());
+                        }
+                        Evict(entry);
+                    }
+                }
+
+                auto outcome = m_encryptionMaterials->DecryptCEK(contentCryptoMaterial);
+                if (outcome.IsSuccess() && contentCryptoMaterial.GetContentEncryptionKey().GetLength() == KEY_SLOT_SIZE)
+                {
+                    std::lock_guard<std::mutex> locker(m_cacheLock);
+                    Insert(cacheKey, contentCryptoMaterial.GetContentEncryptionKey());
+                }
+                return outcome;
+            }
+
+            size_t CachingEncryptionMaterials::GetCachedKeyCount() const
+            {
+                std::lock_guard<std::mutex> locker(m_cacheLock);
+                return m_cachedKeys.size();
+            }
+
+            void CachingEncryptionMaterials::Clear()
+            {
+                std::lock_guard<std::mutex> locker(m_cacheLock);
+                while (!m_cachedKeys.empty())
+                {
+                    Evict(m_cachedKeys.begin());
+                }
+            }
+
+            CachingEncryptionMaterials::CachedKey& CachingEncryptionMaterials::Insert(const Aws::String& cacheKey, const CryptoBuffer& contentKey)
+            {
+                auto existing = m_cachedKeys.find(cacheKey);
+                if (existing != m_cachedKeys.end())
+                {
+                    Evict(existing);
+                }
+                if (m_freeSlots.empty())
+                {
+                    Evict(m_cachedKeys.find(m_leastRecentlyUsed.front()));
+                }
+
+                CachedKey& cachedKey = m_cachedKeys[cacheKey];
+                cachedKey.slot = m_freeSlots.back();
+                m_freeSlots.pop_back();
+                memcpy(GetSlot(cachedKey.slot), contentKey.GetUnderlyingData(), KEY_SLOT_SIZE);
+                cachedKey.keyWrapAlgorithm = KeyWrapAlgorithm::NONE;
+                cachedKey.created = std::chrono::steady_clock::now();
+                cachedKey.messages = 0;
+                cachedKey.bytes = 0;
+                cachedKey.lruPosition = m_leastRecentlyUsed.insert(m_leastRecentlyUsed.end(), cacheKey);
+                return cachedKey;
+            }
+
+            void CachingEncryptionMaterials::Evict(Aws::Map<Aws::String, CachedKey>::iterator entry)
+            {
+                Aws::Security::SecureMemClear(GetSlot(entry->second.slot), KEY_SLOT_SIZE);
+                m_freeSlots.push_back(entry->second.slot);
+                m_leastRecentlyUsed.erase(entry->second.lruPosition);
+                m_cachedKeys.erase(entry);
+            }
+        }//namespace Materials
+    }//namespace S3Encryption
+}//namespace Aws
@@ -20,6 +20,8 @@
 #include <aws/core/client/AWSError.h>
 #include <aws/s3-encryption/S3EncryptionClient.h>
 
+#include <cstring>
+
 using namespace Aws::S3::Model;
 using namespace Aws::Utils;
 using namespace Aws::Utils::Crypto;
@@ -39,29 +41,70 @@ namespace Aws
             static const size_t AES_BLOCK_SIZE = 16u;
             static const size_t BITS_IN_BYTE = 8u;
 
+            /*
+            * The CTR cipher that decrypts, or encrypts, GCM content from offset on. See http://csrc.nist.gov/publications/nistpubs/800-38D/SP-800-38D.pdf
+            */
+            static std::shared_ptr<SymmetricCipher> CreateGCMPartCipher(const ContentCryptoMaterial& contentCryptoMaterial, uint64_t offset)
+            {
+                assert(contentCryptoMaterial.GetIV().GetLength() == GCM_IV_SIZE);
+                CryptoBuffer counter(4);
+                counter.Zero();
+                //start at 0x01, but that is for the Hash, this message should begin at 0x02
+                counter[3] = 0x02;
+                CryptoBuffer gcmToCtrIv({ (ByteBuffer*)&contentCryptoMaterial.GetIV(), (ByteBuffer*)&counter });
+                return CreateAES_CTRImplementation(contentCryptoMaterial.GetContentEncryptionKey(),
+                    IncrementCTRCounter(gcmToCtrIv, static_cast<uint32_t>(offset / AES_BLOCK_SIZE)));
+            }
+
+            static AWSError<S3EncryptionErrors> BuildPartDecryptionError(const char* message)
+            {
+                return BuildS3EncryptionError(AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INTERNAL_FAILURE, "DecryptionFailed", message, false));
+            }
+
             CryptoModule::CryptoModule(const std::shared_ptr<EncryptionMaterials>& encryptionMaterials, const CryptoConfiguration & cryptoConfig) :
-                m_encryptionMaterials(encryptionMaterials), m_contentCryptoMaterial(ContentCryptoMaterial()), m_cryptoConfig(cryptoConfig), m_cipher(nullptr)
+                m_encryptionMaterials(encryptionMaterials), m_contentCryptoMaterial(ContentCryptoMaterial()), m_cryptoConfig(cryptoConfig), m_cipher(nullptr),
+                m_plaintextLength(0), m_nextPartOffset(0), m_partsFinalized(false)
             {
             }
 
             S3EncryptionPutObjectOutcome CryptoModule::PutObjectSecurely(const Aws::S3::Model::PutObjectRequest& request, const PutObjectFunction& putObjectFunction)
             {
                 PutObjectRequest copyRequest(request);
-                PopulateCryptoContentMaterial();
-                InitEncryptionCipher();
+                auto initOutcome = InitEncryptionMaterial(copyRequest, putObjectFunction);
+                if (!initOutcome.IsSuccess())
+                {
+                    return initOutcome;
+                }
                 SetContentLength(copyRequest);
+                return WrapAndMakeRequestWithCipher(copyRequest, putObjectFunction);
+            }
+
+            S3EncryptionPutObjectOutcome CryptoModule::InitEncryptionMaterial(Aws::S3::Model::PutObjectRequest& request, const PutObjectFunction& putObjectFunction)
+            {
+                PopulateCryptoContentMaterial();
+                int64_t unencryptedContentLength = -1;
+                if (request.GetBody())
+                {
+                    request.GetBody()->seekg(0, std::ios_base::end);
+                    unencryptedContentLength = static_cast<int64_t>(request.GetBody()->tellg());
+                    request.GetBody()->seekg(0, std::ios_base::beg);
+                }
+                m_contentCryptoMaterial.SetUnencryptedContentLength(unencryptedContentLength);
+
+                // the materials may hand back a content key of their own, such as a cached data key, so the cipher is set up after
                 auto encryptOutcome = m_encryptionMaterials->EncryptCEK(m_contentCryptoMaterial);
                 if (!encryptOutcome.IsSuccess())
                 {
                     return S3EncryptionPutObjectOutcome(BuildS3EncryptionError(encryptOutcome.GetError()));
                 }
-                
+                InitEncryptionCipher();
+
                 if (m_cryptoConfig.GetStorageMethod() == StorageMethod::INSTRUCTION_FILE)
                 {
                     Handlers::InstructionFileHandler handler;
                     PutObjectRequest instructionFileRequest;
-                    instructionFileRequest.WithBucket(copyRequest.GetBucket());
-                    instructionFileRequest.WithKey(copyRequest.GetKey());
+                    instructionFileRequest.WithBucket(request.GetBucket());
+                    instructionFileRequest.WithKey(request.GetKey());
                     handler.PopulateRequest(instructionFileRequest, m_contentCryptoMaterial);
                     PutObjectOutcome instructionOutcome = putObjectFunction(instructionFileRequest);
                     if (!instructionOutcome.IsSuccess())
@@ -75,9 +118,115 @@ namespace Aws
                 else
                 {
                     Handlers::MetadataHandler handler;
-                    handler.PopulateRequest(copyRequest, m_contentCryptoMaterial);
+                    handler.PopulateRequest(request, m_contentCryptoMaterial);
                 }
-                return WrapAndMakeRequestWithCipher(copyRequest, putObjectFunction);
+                return S3EncryptionPutObjectOutcome(PutObjectResult());
+            }
+
+            S3EncryptionPartsOutcome CryptoModule::InitPartEncryption(Aws::S3::Model::PutObjectRequest& request, const PutObjectFunction& putObjectFunction)
+            {
+                auto initOutcome = InitEncryptionMaterial(request, putObjectFunction);
+                if (!initOutcome.IsSuccess())
+                {
+                    return S3EncryptionPartsOutcome(initOutcome.GetError());
+                }
+
+                std::lock_guard<std::mutex> locker(m_partsLock);
+                m_encryptedParts.clear();
+                m_previousBlock = m_contentCryptoMaterial.GetIV();
+                m_finalBlocks = CryptoBuffer();
+                m_nextPartOffset = 0;
+                m_partsFinalized = false;
+                return S3EncryptionPartsOutcome(Aws::NoResult());
+            }
+
+            size_t CryptoModule::EncryptPart(int partNumber, unsigned char* buffer, size_t length, size_t capacity, bool lastPart)
+            {
+                std::shared_ptr<SymmetricCipher> cipher;
+                CryptoBuffer finalBlocks;
+                {
+                    std::lock_guard<std::mutex> locker(m_partsLock);
+                    if (!m_cipher || partNumber < 1 || static_cast<size_t>(partNumber) > m_encryptedParts.size() + 1 ||
+                        (static_cast<size_t>(partNumber) == m_encryptedParts.size() + 1 && m_partsFinalized))
+                    {
+                        AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Part " << partNumber << " can't be encrypted yet; parts are encrypted in order the first time through. "
+                            << m_encryptedParts.size() << " part(s) encrypted so far.");
+                        return 0;
+                    }
+
+                    if (static_cast<size_t>(partNumber) == m_encryptedParts.size() + 1)
+                    {
+                        // the next part carries on with the cipher the parts before it went through
+                        EncryptedPart part;
+                        part.offset = m_nextPartOffset;
+                        part.previousBlock = m_previousBlock;
+                        size_t written = m_cipher->EncryptBufferInto(buffer, length, buffer, capacity);
+                        if (!*m_cipher || (!lastPart && written != length))
+                        {
+                            AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Encryption of part " << partNumber << " failed.");
+                            return 0;
+                        }
+                        if (lastPart)
+                        {
+                            m_finalBlocks = m_cipher->FinalizeEncryption();
+                            if (!*m_cipher || written + m_finalBlocks.GetLength() > capacity)
+                            {
+                                AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Finalizing the encryption of part " << partNumber << " failed.");
+                                return 0;
+                            }
+                            memcpy(buffer + written, m_finalBlocks.GetUnderlyingData(), m_finalBlocks.GetLength());
+                            written += m_finalBlocks.GetLength();
+                            m_partsFinalized = true;
+                        }
+                        else if (written >= AES_BLOCK_SIZE)
+                        {
+                            m_previousBlock = CryptoBuffer(buffer + written - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+                        }
+                        m_encryptedParts.push_back(part);
+                        m_nextPartOffset += length;
+                        return written;
+                    }
+
+                    // a part encrypted before; the cipher is set up again where the part started
+                    const EncryptedPart& part = m_encryptedParts[partNumber - 1];
+                    if (lastPart && (!m_partsFinalized || static_cast<size_t>(partNumber) != m_encryptedParts.size()))
+                    {
+                        AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Part " << partNumber << " wasn't encrypted as the last part.");
+                        return 0;
+                    }
+                    cipher = CreatePartCipher(part.offset, part.previousBlock);
+                    finalBlocks = m_finalBlocks;
+                }
+
+                size_t written = cipher ? cipher->EncryptBufferInto(buffer, length, buffer, capacity) : 0;
+                if (!cipher || !*cipher || (!lastPart && written != length))
+                {
+                    AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Encryption of part " << partNumber << " failed.");
+                    return 0;
+                }
+                if (lastPart)
+                {
+                    // whatever the cipher holds back is in the blocks finalized the first time, GCM tag included
+                    if (written + finalBlocks.GetLength() > capacity)
+                    {
+                        return 0;
+                    }
+                    memcpy(buffer + written, finalBlocks.GetUnderlyingData(), finalBlocks.GetLength());
+                    written += finalBlocks.GetLength();
+                }
+                return written;
+            }
+
+            S3EncryptionPartsOutcome CryptoModule::InitPartDecryption(const Aws::S3::Model::GetObjectRequest& request, const Aws::S3::Model::HeadObjectResult& headObjectResult,
+                const ContentCryptoMaterial& contentCryptoMaterial, const GetObjectFunction& getObjectFunction)
+            {
+                m_contentCryptoMaterial = contentCryptoMaterial;
+                auto decryptOutcome = m_encryptionMaterials->DecryptCEK(m_contentCryptoMaterial);
+                if (!decryptOutcome.IsSuccess())
+                {
+                    return S3EncryptionPartsOutcome(BuildS3EncryptionError(decryptOutcome.GetError()));
+                }
+                return ComputePlaintextLength(request, headObjectResult, getObjectFunction);
             }
 
             S3EncryptionGetObjectOutcome CryptoModule::GetObjectSecurely(const Aws::S3::Model::GetObjectRequest& request,
@@ -120,7 +269,7 @@ namespace Aws
             S3EncryptionPutObjectOutcome CryptoModule::WrapAndMakeRequestWithCipher(Aws::S3::Model::PutObjectRequest & request, const PutObjectFunction& putObjectFunction)
             {
                 std::shared_ptr<Aws::IOStream> iostream = request.GetBody();
-                request.SetBody(Aws::MakeShared<Aws::Utils::Crypto::SymmetricCryptoStream>(ALLOCATION_TAG, (Aws::IStream&)*iostream, CipherMode::Encrypt, (*m_cipher)));
+                request.SetBody(Aws::MakeShared<Aws::Utils::Crypto::SymmetricCryptoStream>(ALLOCATION_TAG, (Aws::IStream&)*iostream, CipherMode::Encrypt, (*m_cipher), HIGH_THROUGHPUT_BUF_SIZE));
                 iostream->clear();
                 iostream->seekg(0, std::ios_base::beg);
 
@@ -142,7 +291,7 @@ namespace Aws
                 auto userSuppliedStream = userSuppliedStreamFactory();
 
                 request.SetResponseStreamFactory(
-                    [&] { return Aws::New<SymmetricCryptoStream>(ALLOCATION_TAG, (Aws::OStream&)*userSuppliedStream, CipherMode::Decrypt, *m_cipher, DEFAULT_BUF_SIZE, firstBlockOffset); }
+                    [&] { return Aws::New<SymmetricCryptoStream>(ALLOCATION_TAG, (Aws::OStream&)*userSuppliedStream, CipherMode::Decrypt, *m_cipher, HIGH_THROUGHPUT_BUF_SIZE, firstBlockOffset); }
                 );
                 GetObjectOutcome outcome = getObjectFunction(request);
                 if (!outcome.IsSuccess())
@@ -252,6 +401,99 @@ namespace Aws
                 return newRange;
             }
 
+            std::shared_ptr<SymmetricCipher> CryptoModuleEO::CreatePartCipher(uint64_t, const Aws::Utils::CryptoBuffer& previousBlock) const
+            {
+                return CreateAES_CBCImplementation(m_contentCryptoMaterial.GetContentEncryptionKey(), previousBlock);
+            }
+
+            S3EncryptionPartsOutcome CryptoModuleEO::ComputePlaintextLength(const Aws::S3::Model::GetObjectRequest& request, const Aws::S3::Model::HeadObjectResult& headObjectResult,
+                const GetObjectFunction& getObjectFunction)
+            {
+                DecryptionConditionCheck(request.GetRange());
+                uint64_t ciphertextLength = static_cast<uint64_t>(headObjectResult.GetContentLength());
+                if (ciphertextLength < AES_BLOCK_SIZE || ciphertextLength % AES_BLOCK_SIZE != 0)
+                {
+                    return S3EncryptionPartsOutcome(BuildPartDecryptionError("CBC ciphertext is not a whole number of blocks."));
+                }
+
+                // the padding is in the last block, which decrypts with the block before it, or the IV, as its IV
+                GetObjectRequest lastBlocksRequest;
+                lastBlocksRequest.WithBucket(request.GetBucket());
+                lastBlocksRequest.WithKey(request.GetKey());
+                if (!request.GetVersionId().empty())
+                {
+                    lastBlocksRequest.SetVersionId(request.GetVersionId());
+                }
+                uint64_t firstByte = ciphertextLength > AES_BLOCK_SIZE ? ciphertextLength - 2 * AES_BLOCK_SIZE : 0;
+                lastBlocksRequest.SetRange("bytes=" + StringUtils::to_string(firstByte) + "-" + StringUtils::to_string(ciphertextLength - 1));
+                GetObjectOutcome lastBlocksOutcome = getObjectFunction(lastBlocksRequest);
+                if (!lastBlocksOutcome.IsSuccess())
+                {
+                    AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Get operation for the last blocks not successful: "
+                        << lastBlocksOutcome.GetError().GetExceptionName() << " : "
+                        << lastBlocksOutcome.GetError().GetMessage());
+                    return S3EncryptionPartsOutcome(BuildS3EncryptionError(lastBlocksOutcome.GetError()));
+                }
+
+                Aws::OStringStream ss;
+                ss << lastBlocksOutcome.GetResult().GetBody().rdbuf();
+                Aws::String lastBlocks = ss.str();
+                if (lastBlocks.size() != ciphertextLength - firstByte)
+                {
+                    return S3EncryptionPartsOutcome(BuildPartDecryptionError("Get operation for the last blocks returned the wrong number of bytes."));
+                }
+
+                const unsigned char* lastBlock = reinterpret_cast<const unsigned char*>(lastBlocks.c_str()) + lastBlocks.size() - AES_BLOCK_SIZE;
+                auto cipher = CreatePartCipher(ciphertextLength - AES_BLOCK_SIZE,
+                    firstByte == ciphertextLength - AES_BLOCK_SIZE ? m_contentCryptoMaterial.GetIV() : CryptoBuffer(lastBlock - AES_BLOCK_SIZE, AES_BLOCK_SIZE));
+                CryptoBuffer decrypted = cipher->DecryptBuffer(CryptoBuffer(lastBlock, AES_BLOCK_SIZE));
+                CryptoBuffer finalBlock = cipher->FinalizeDecryption();
+                if (!*cipher)
+                {
+                    return S3EncryptionPartsOutcome(BuildPartDecryptionError("The last CBC block does not decrypt."));
+                }
+                m_plaintextLength = ciphertextLength - AES_BLOCK_SIZE + decrypted.GetLength() + finalBlock.GetLength();
+                return S3EncryptionPartsOutcome(Aws::NoResult());
+            }
+
+            std::pair<uint64_t, uint64_t> CryptoModuleEO::GetPartCiphertextRange(uint64_t offset, size_t length) const
+            {
+                // the block before the part is its IV, and the cipher only lets go of a block once it has the next one, or the padding
+                uint64_t ciphertextLength = (m_plaintextLength / AES_BLOCK_SIZE + 1) * AES_BLOCK_SIZE;
+                uint64_t firstByte = offset == 0 ? 0 : offset - AES_BLOCK_SIZE;
+                uint64_t lastByte = (std::min)(offset + length + AES_BLOCK_SIZE, ciphertextLength) - 1;
+                return std::make_pair(firstByte, lastByte);
+            }
+
+            bool CryptoModuleEO::DecryptPart(uint64_t offset, size_t length, unsigned char* buffer, size_t ciphertextLength, size_t capacity) const
+            {
+                size_t ivLength = offset == 0 ? 0 : AES_BLOCK_SIZE;
+                if (ciphertextLength < ivLength + AES_BLOCK_SIZE || ciphertextLength > capacity)
+                {
+                    return false;
+                }
+
+                auto cipher = CreatePartCipher(offset, offset == 0 ? m_contentCryptoMaterial.GetIV() : CryptoBuffer(buffer, AES_BLOCK_SIZE));
+                unsigned char* ciphertext = buffer + ivLength;
+                size_t written = cipher->DecryptBufferInto(ciphertext, ciphertextLength - ivLength, ciphertext, capacity - ivLength);
+                if (*cipher && offset + length == m_plaintextLength)
+                {
+                    CryptoBuffer finalBlock = cipher->FinalizeDecryption();
+                    if (*cipher && written + finalBlock.GetLength() <= capacity - ivLength)
+                    {
+                        memcpy(ciphertext + written, finalBlock.GetUnderlyingData(), finalBlock.GetLength());
+                        written += finalBlock.GetLength();
+                    }
+                }
+                if (!*cipher || written != length)
+                {
+                    AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Decryption of the part at offset " << offset << " failed.");
+                    return false;
+                }
+                memmove(buffer, ciphertext, length);
+                return true;
+            }
+
 
             CryptoModuleAE::CryptoModuleAE(const std::shared_ptr<EncryptionMaterials>& encryptionMaterials, const CryptoConfiguration & cryptoConfig) :
                 CryptoModule(encryptionMaterials, cryptoConfig)
@@ -381,6 +623,44 @@ namespace Aws
                 return newRange;
             }
 
+            std::shared_ptr<SymmetricCipher> CryptoModuleAE::CreatePartCipher(uint64_t offset, const Aws::Utils::CryptoBuffer&) const
+            {
+                return CreateGCMPartCipher(m_contentCryptoMaterial, offset);
+            }
+
+            S3EncryptionPartsOutcome CryptoModuleAE::ComputePlaintextLength(const Aws::S3::Model::GetObjectRequest&, const Aws::S3::Model::HeadObjectResult& headObjectResult,
+                const GetObjectFunction&)
+            {
+                uint64_t tagLength = m_contentCryptoMaterial.GetCryptoTagLength() / BITS_IN_BYTE;
+                if (static_cast<uint64_t>(headObjectResult.GetContentLength()) < tagLength)
+                {
+                    return S3EncryptionPartsOutcome(BuildPartDecryptionError("GCM ciphertext is shorter than its tag."));
+                }
+                m_plaintextLength = static_cast<uint64_t>(headObjectResult.GetContentLength()) - tagLength;
+                return S3EncryptionPartsOutcome(Aws::NoResult());
+            }
+
+            std::pair<uint64_t, uint64_t> CryptoModuleAE::GetPartCiphertextRange(uint64_t offset, size_t length) const
+            {
+                return std::make_pair(offset, offset + length - 1);
+            }
+
+            bool CryptoModuleAE::DecryptPart(uint64_t offset, size_t length, unsigned char* buffer, size_t ciphertextLength, size_t capacity) const
+            {
+                if (ciphertextLength != length)
+                {
+                    return false;
+                }
+                auto cipher = CreatePartCipher(offset, CryptoBuffer());
+                size_t written = cipher->DecryptBufferInto(buffer, length, buffer, capacity);
+                if (!*cipher || written != length)
+                {
+                    AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Decryption of the part at offset " << offset << " failed.");
+                    return false;
+                }
+                return true;
+            }
+
 
 
 
@@ -458,6 +738,29 @@ namespace Aws
                 return std::pair<int64_t, int64_t>(0, adjustedRange);
             }
 
+            std::shared_ptr<SymmetricCipher> CryptoModuleStrictAE::CreatePartCipher(uint64_t offset, const Aws::Utils::CryptoBuffer&) const
+            {
+                return CreateGCMPartCipher(m_contentCryptoMaterial, offset);
+            }
+
+            S3EncryptionPartsOutcome CryptoModuleStrictAE::ComputePlaintextLength(const Aws::S3::Model::GetObjectRequest&, const Aws::S3::Model::HeadObjectResult&,
+                const GetObjectFunction&)
+            {
+                AWS_LOGSTREAM_ERROR(ALLOCATION_TAG, "Range-Get Operations are not allowed with Strict Authenticated Encryption mode.");
+                return S3EncryptionPartsOutcome(BuildS3EncryptionError(AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INVALID_ACTION, "RangedDecryptionNotAllowed",
+                    "Objects can't be decrypted in parts with Strict Authenticated Encryption mode.", false)));
+            }
+
+            std::pair<uint64_t, uint64_t> CryptoModuleStrictAE::GetPartCiphertextRange(uint64_t offset, size_t length) const
+            {
+                return std::make_pair(offset, offset + length - 1);
+            }
+
+            bool CryptoModuleStrictAE::DecryptPart(uint64_t, size_t, unsigned char*, size_t, size_t) const
+            {
+                return false;
+            }
+
 
 
             AES_GCM_AppendedTag::AES_GCM_AppendedTag(const CryptoBuffer& key) : Aws::Utils::Crypto::SymmetricCipher(),
@@ -477,6 +780,11 @@ namespace Aws
                 return m_cipher->EncryptBuffer(unEncryptedData);
             }
 
+            size_t AES_GCM_AppendedTag::EncryptBufferInto(const unsigned char* unEncryptedData, size_t length, unsigned char* output, size_t outputCapacity)
+            {
+                return m_cipher->EncryptBufferInto(unEncryptedData, length, output, outputCapacity);
+            }
+
             CryptoBuffer AES_GCM_AppendedTag::FinalizeEncryption()
             {
                 CryptoBuffer&& finalizeBuffer = m_cipher->FinalizeEncryption();
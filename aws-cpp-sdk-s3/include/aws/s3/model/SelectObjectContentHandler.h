@@ -43,6 +43,7 @@ namespace Model
     class AWS_S3_API SelectObjectContentHandler : public Aws::Utils::Event::EventStreamHandler
     {
         typedef std::function<void(RecordsEvent&)> RecordsEventCallback;
+        typedef std::function<void(const unsigned char* payload, size_t length)> RecordsPayloadCallback;
         typedef std::function<void(const StatsEvent&)> StatsEventCallback;
         typedef std::function<void(const ProgressEvent&)> ProgressEventCallback;
         typedef std::function<void()> ContinuationEventCallback;
@@ -54,6 +55,7 @@ namespace Model
         SelectObjectContentHandler& operator=(const SelectObjectContentHandler& handler)
         {
             m_onRecordsEvent = handler.m_onRecordsEvent;
+            m_onRecordsPayload = handler.m_onRecordsPayload;
             m_onStatsEvent = handler.m_onStatsEvent;
             m_onProgressEvent = handler.m_onProgressEvent;
             m_onContinuationEvent = handler.m_onContinuationEvent;
@@ -64,8 +66,18 @@ namespace Model
 
 
         virtual void OnEvent() override;
+        /**
+         * Handles records, continuation and end events straight from the receive buffer, so they cost no copies or allocations;
+         * anything else is left to OnEvent.
+         */
+        virtual bool OnMessageView(const Aws::Utils::Event::EventMessageView& message) override;
 
         inline void SetRecordsEventCallback(const RecordsEventCallback& callback) { m_onRecordsEvent = callback; }
+        /**
+         * Called instead of the records event callback with each records payload where it lies in the receive buffer,
+         * valid only during the call, so no RecordsEvent has to be built for it.
+         */
+        inline void SetRecordsPayloadCallback(const RecordsPayloadCallback& callback) { m_onRecordsPayload = callback; }
         inline void SetStatsEventCallback(const StatsEventCallback& callback) { m_onStatsEvent = callback; }
         inline void SetProgressEventCallback(const ProgressEventCallback& callback) { m_onProgressEvent = callback; }
         inline void SetContinuationEventCallback(const ContinuationEventCallback& callback) { m_onContinuationEvent = callback; }
@@ -77,6 +89,7 @@ namespace Model
         void HandleErrorInMessage();
 
         RecordsEventCallback m_onRecordsEvent;
+        RecordsPayloadCallback m_onRecordsPayload;
         StatsEventCallback m_onStatsEvent;
         ProgressEventCallback m_onProgressEvent;
         ContinuationEventCallback m_onContinuationEvent;
@@ -23,6 +23,7 @@
 #include <aws/s3/model/RequestProgress.h>
 #include <aws/s3/model/InputSerialization.h>
 #include <aws/s3/model/OutputSerialization.h>
+#include <aws/s3/model/ScanRange.h>
 #include <aws/core/utils/memory/stl/AWSMap.h>
 #include <utility>
 
@@ -86,6 +87,29 @@ namespace Model
      */
     inline SelectObjectContentRequest& WithEventStreamHandler(const SelectObjectContentHandler& value) { SetEventStreamHandler(value); return *this; }
 
+    /**
+     * Run the event stream handler's callbacks on the executor, in the order the events arrive, rather than on the thread receiving
+     * the response. Once highWatermark bytes of events are waiting for the callbacks, the response is held off until they are down
+     * to lowWatermark; the curl http client stops reading it meanwhile. The executor must not be the one making the request.
+     * SelectObjectContent returns once every callback has run.
+     */
+    inline void SetEventStreamExecutor(const std::shared_ptr<Aws::Utils::Threading::Executor>& executor,
+        size_t highWatermark = Aws::Utils::Event::DEFAULT_DISPATCH_HIGH_WATERMARK, size_t lowWatermark = Aws::Utils::Event::DEFAULT_DISPATCH_LOW_WATERMARK)
+    {
+        m_decoder.SetDispatchExecutor(executor, highWatermark, lowWatermark);
+        SetResponseFlowControlHandler(m_decoder.GetResponseFlowControlHandler());
+    }
+
+    /**
+     * Run the event stream handler's callbacks on the executor, in the order the events arrive, rather than on the thread receiving
+     * the response. Once highWatermark bytes of events are waiting for the callbacks, the response is held off until they are down
+     * to lowWatermark; the curl http client stops reading it meanwhile. The executor must not be the one making the request.
+     * SelectObjectContent returns once every callback has run.
+     */
+    inline SelectObjectContentRequest& WithEventStreamExecutor(const std::shared_ptr<Aws::Utils::Threading::Executor>& executor,
+        size_t highWatermark = Aws::Utils::Event::DEFAULT_DISPATCH_HIGH_WATERMARK, size_t lowWatermark = Aws::Utils::Event::DEFAULT_DISPATCH_LOW_WATERMARK)
+    { SetEventStreamExecutor(executor, highWatermark, lowWatermark); return *this; }
+
 
     /**
      * <p>The S3 bucket.</p>
@@ -511,6 +535,55 @@ namespace Model
     inline SelectObjectContentRequest& WithOutputSerialization(OutputSerialization&& value) { SetOutputSerialization(std::move(value)); return *this;}
 
 
+    /**
+     * <p>Specifies the byte range of the object to get the records from. A record is
+     * processed when its first byte is contained by the range, so the records of
+     * ranges that follow each other are neither missed nor repeated. ScanRange isn't
+     * supported for compressed objects.</p>
+     */
+    inline const ScanRange& GetScanRange() const{ return m_scanRange; }
+
+    /**
+     * <p>Specifies the byte range of the object to get the records from. A record is
+     * processed when its first byte is contained by the range, so the records of
+     * ranges that follow each other are neither missed nor repeated. ScanRange isn't
+     * supported for compressed objects.</p>
+     */
+    inline bool ScanRangeHasBeenSet() const { return m_scanRangeHasBeenSet; }
+
+    /**
+     * <p>Specifies the byte range of the object to get the records from. A record is
+     * processed when its first byte is contained by the range, so the records of
+     * ranges that follow each other are neither missed nor repeated. ScanRange isn't
+     * supported for compressed objects.</p>
+     */
+    inline void SetScanRange(const ScanRange& value) { m_scanRangeHasBeenSet = true; m_scanRange = value; }
+
+    /**
+     * <p>Specifies the byte range of the object to get the records from. A record is
+     * processed when its first byte is contained by the range, so the records of
+     * ranges that follow each other are neither missed nor repeated. ScanRange isn't
+     * supported for compressed objects.</p>
+     */
+    inline void SetScanRange(ScanRange&& value) { m_scanRangeHasBeenSet = true; m_scanRange = std::move(value); }
+
+    /**
+     * <p>Specifies the byte range of the object to get the records from. A record is
+     * processed when its first byte is contained by the range, so the records of
+     * ranges that follow each other are neither missed nor repeated. ScanRange isn't
+     * supported for compressed objects.</p>
+     */
+    inline SelectObjectContentRequest& WithScanRange(const ScanRange& value) { SetScanRange(value); return *this;}
+
+    /**
+     * <p>Specifies the byte range of the object to get the records from. A record is
+     * processed when its first byte is contained by the range, so the records of
+     * ranges that follow each other are neither missed nor repeated. ScanRange isn't
+     * supported for compressed objects.</p>
+     */
+    inline SelectObjectContentRequest& WithScanRange(ScanRange&& value) { SetScanRange(std::move(value)); return *this;}
+
+
     
     inline const Aws::Map<Aws::String, Aws::String>& GetCustomizedAccessLogTag() const{ return m_customizedAccessLogTag; }
 
@@ -582,6 +655,9 @@ namespace Model
     OutputSerialization m_outputSerialization;
     bool m_outputSerializationHasBeenSet;
 
+    ScanRange m_scanRange;
+    bool m_scanRangeHasBeenSet;
+
     Aws::Map<Aws::String, Aws::String> m_customizedAccessLogTag;
     bool m_customizedAccessLogTagHasBeenSet;
     Aws::Utils::Event::EventStreamDecoder m_decoder;
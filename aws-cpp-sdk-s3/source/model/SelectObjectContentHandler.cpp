@@ -105,6 +105,33 @@ namespace Model
         }
     }
 
+    bool SelectObjectContentHandler::OnMessageView(const EventMessageView& message)
+    {
+        const EventHeaderView* messageTypeHeader = message.FindHeader(MESSAGE_TYPE_HEADER);
+        const EventHeaderView* eventTypeHeader = message.FindHeader(EVENT_TYPE_HEADER);
+        if (!messageTypeHeader || !eventTypeHeader || !messageTypeHeader->ValueEquals("event"))
+        {
+            return false;
+        }
+
+        if (m_onRecordsPayload && eventTypeHeader->ValueEquals("Records"))
+        {
+            m_onRecordsPayload(message.GetPayload(), message.GetPayloadLength());
+            return true;
+        }
+        if (eventTypeHeader->ValueEquals("Cont"))
+        {
+            m_onContinuationEvent();
+            return true;
+        }
+        if (eventTypeHeader->ValueEquals("End"))
+        {
+            m_onEndEvent();
+            return true;
+        }
+        return false;
+    }
+
     void SelectObjectContentHandler::HandleEventInMessage()
     {
         auto headers = GetEventHeaders();
@@ -38,8 +38,9 @@ SelectObjectContentRequest::SelectObjectContentRequest() :
     m_requestProgressHasBeenSet(false),
     m_inputSerializationHasBeenSet(false),
     m_outputSerializationHasBeenSet(false),
+    m_scanRangeHasBeenSet(false),
     m_customizedAccessLogTagHasBeenSet(false),
-    m_decoder(Aws::Utils::Event::EventStreamDecoder(&m_handler))
+    m_decoder(Aws::Utils::Event::EventStreamDecoder(&m_handler, Aws::Utils::Event::EventStreamDecodingMode::VIEWS))
 {
 }
 
@@ -81,6 +82,12 @@ Aws::String SelectObjectContentRequest::SerializePayload() const
    m_outputSerialization.AddToNode(outputSerializationNode);
   }
 
+  if(m_scanRangeHasBeenSet)
+  {
+   XmlNode scanRangeNode = parentNode.CreateChildElement("ScanRange");
+   m_scanRange.AddToNode(scanRangeNode);
+  }
+
   return payloadDoc.ConvertToString();
 }
 
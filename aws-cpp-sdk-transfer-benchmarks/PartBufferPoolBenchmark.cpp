@@ -0,0 +1,87 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/testing/Benchmark.h>
+
+#include <aws/transfer/PartBufferPool.h>
+#include <aws/core/utils/Array.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+using namespace Aws::Transfer;
+
+static const size_t MB = 1024 * 1024;
+static const char* ALLOCATION_TAG = "PartBufferPoolBenchmark";
+
+/**
+ * Copies into bufferCount buffers from pool, or from the heap if pool is null, rounds times and returns the bytes copied per second.
+ */
+static double CopyThroughput(PartBufferPool* pool, size_t bufferSize, size_t bufferCount, size_t rounds)
+{
+    Aws::Utils::Array<uint8_t> source(bufferSize);
+    memset(source.GetUnderlyingData(), 'x', bufferSize);
+
+    Aws::Vector<Aws::Utils::Array<uint8_t>*> buffers;
+    for (size_t i = 0; i < bufferCount; ++i)
+    {
+        buffers.push_back(pool ? pool->Acquire(bufferSize) : Aws::New<Aws::Utils::Array<uint8_t>>(ALLOCATION_TAG, bufferSize));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        for (auto buffer : buffers)
+        {
+            memcpy(buffer->GetUnderlyingData(), source.GetUnderlyingData(), bufferSize);
+        }
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto buffer : buffers)
+    {
+        if (pool)
+        {
+            pool->Release(buffer);
+        }
+        else
+        {
+            Aws::Delete(buffer);
+        }
+    }
+    return static_cast<double>(bufferSize) * bufferCount * rounds / seconds;
+}
+
+/**
+ * Copying into 8MB part buffers from the heap and from a HugePagePartBufferPool, which fewer TLB misses should make faster.
+ */
+AWS_BENCHMARK(PartBufferPoolCopyThroughput)
+{
+    const size_t bufferSize = 8 * MB;
+    const size_t bufferCount = 16;
+    const size_t rounds = 8;
+
+    HugePagePartBufferPool pool(bufferSize * bufferCount);
+    // the first pass faults the pages in for both, the second is measured
+    CopyThroughput(nullptr, bufferSize, bufferCount, 1);
+    CopyThroughput(&pool, bufferSize, bufferCount, 1);
+    double heapThroughput = CopyThroughput(nullptr, bufferSize, bufferCount, rounds);
+    double poolThroughput = CopyThroughput(&pool, bufferSize, bufferCount, rounds);
+
+    std::cout << "Copying into " << bufferCount << " " << bufferSize / MB << "MB part buffers: heap " << static_cast<int64_t>(heapThroughput / MB)
+              << "MB/s, huge page pool " << static_cast<int64_t>(poolThroughput / MB) << "MB/s" << std::endl;
+}
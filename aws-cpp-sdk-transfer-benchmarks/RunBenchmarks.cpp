@@ -0,0 +1,38 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  * 
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  * 
+  *  http://aws.amazon.com/apache2.0
+  * 
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/core/Aws.h>
+#include <aws/testing/Benchmark.h>
+
+#include <iostream>
+
+/**
+ * Runs the benchmarks whose name contains the first argument, or all of them.
+ */
+int main(int argc, char** argv)
+{
+    Aws::SDKOptions options;
+    Aws::InitAPI(options);
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    size_t run = Aws::Testing::RunBenchmarks(filter);
+    Aws::ShutdownAPI(options);
+
+    if (run == 0)
+    {
+        std::cerr << "No benchmark matches " << (filter ? filter : "") << std::endl;
+        return 1;
+    }
+    return 0;
+}
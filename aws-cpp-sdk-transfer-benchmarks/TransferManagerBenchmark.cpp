@@ -0,0 +1,239 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  *
+  *  http://aws.amazon.com/apache2.0
+  *
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/testing/Benchmark.h>
+
+#include "InMemoryS3Client.h"
+
+#include <aws/transfer/TransferManager.h>
+#include <aws/transfer/PartBufferPool.h>
+#include <aws/core/platform/FileSystem.h>
+#include <aws/core/utils/Array.h>
+#include <aws/core/utils/stream/PreallocatedStreamBuf.h>
+#include <aws/core/utils/threading/Executor.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+using namespace Aws::Transfer;
+
+static const char* ALLOCATION_TAG = "TransferManagerBenchmark";
+
+/**
+ * An InMemoryS3Client with executors of its own, set up as the transfer tests set it up.
+ */
+class InMemoryTransfers
+{
+public:
+    InMemoryTransfers() :
+        m_clientExecutor(Aws::MakeShared<Aws::Utils::Threading::PooledThreadExecutor>(ALLOCATION_TAG, 8)),
+        m_transferExecutor(Aws::MakeShared<Aws::Utils::Threading::PooledThreadExecutor>(ALLOCATION_TAG, 2))
+    {
+        Aws::Client::ClientConfiguration config;
+        config.executor = m_clientExecutor;
+        m_s3Client = Aws::MakeShared<InMemoryS3Client>(ALLOCATION_TAG, config);
+    }
+
+    ~InMemoryTransfers()
+    {
+        // a callback that is still returning holds its TransferManager, and with it the client and the client's executor
+        while (m_s3Client.use_count() > 1)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    TransferManagerConfiguration CreateTransferManagerConfiguration()
+    {
+        TransferManagerConfiguration transferManagerConfig(m_transferExecutor.get());
+        transferManagerConfig.s3Client = m_s3Client;
+        transferManagerConfig.bufferSize = PART_SIZE;
+        transferManagerConfig.transferBufferMaxHeapSize = 64 * PART_SIZE;
+        return transferManagerConfig;
+    }
+
+private:
+    std::shared_ptr<Aws::Utils::Threading::PooledThreadExecutor> m_clientExecutor;
+    std::shared_ptr<Aws::Utils::Threading::PooledThreadExecutor> m_transferExecutor;
+    std::shared_ptr<InMemoryS3Client> m_s3Client;
+};
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Uploads data from a stream, then downloads it into memory; returns false if either transfer fails.
+ */
+static bool UploadAndDownload(TransferManager& transferManager, const Aws::String& data)
+{
+    auto uploadHandle = transferManager.UploadFile(Aws::MakeShared<Aws::StringStream>(ALLOCATION_TAG, data), TEST_BUCKET, TEST_KEY,
+                                                   "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+    if (uploadHandle->GetStatus() != TransferStatus::COMPLETED)
+    {
+        return false;
+    }
+
+    Aws::Utils::Array<uint8_t> downloadBuffer(data.size());
+    CreateDownloadStreamCallback createStream = [&downloadBuffer]()
+    {
+        return Aws::New<Aws::Utils::Stream::DefaultUnderlyingStream>(ALLOCATION_TAG,
+                Aws::MakeUnique<Aws::Utils::Stream::PreallocatedStreamBuf>(ALLOCATION_TAG, &downloadBuffer, downloadBuffer.GetLength()));
+    };
+    auto downloadHandle = transferManager.DownloadFile(TEST_BUCKET, TEST_KEY, createStream);
+    downloadHandle->WaitUntilFinished();
+    return downloadHandle->GetStatus() == TransferStatus::COMPLETED;
+}
+
+/**
+ * What tracking the states of many parts costs: 10,000 parts of 1KB up and down, where the data itself takes next to no time.
+ */
+AWS_BENCHMARK(TransferManagerManyPartTransfers)
+{
+    InMemoryTransfers transfers;
+    auto transferManager = TransferManager::Create(transfers.CreateTransferManagerConfiguration());
+    const Aws::String objectData = MakeObjectData();
+
+    auto start = std::chrono::steady_clock::now();
+    if (!UploadAndDownload(*transferManager, objectData))
+    {
+        std::cout << "Transfer failed." << std::endl;
+        return;
+    }
+    std::cout << PART_COUNT << " part upload and download took " << static_cast<int64_t>(SecondsSince(start) * 1000) << "ms" << std::endl;
+}
+
+/**
+ * Multipart file uploads with the parts read on one thread and on several.
+ */
+AWS_BENCHMARK(TransferManagerFileUploadReadThreads)
+{
+    const Aws::String objectData = MakeObjectData();
+    const Aws::String fileName = Aws::FileSystem::CreateTempFilePath();
+    {
+        Aws::OFStream file(fileName.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        file.write(objectData.data(), static_cast<std::streamsize>(objectData.size()));
+    }
+
+    for (size_t readThreads : {1, 4})
+    {
+        InMemoryTransfers transfers;
+        auto transferManagerConfig = transfers.CreateTransferManagerConfiguration();
+        transferManagerConfig.uploadReadThreads = readThreads;
+        auto transferManager = TransferManager::Create(transferManagerConfig);
+
+        auto start = std::chrono::steady_clock::now();
+        auto uploadHandle = transferManager->UploadFile(fileName, TEST_BUCKET, TEST_KEY, "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+        uploadHandle->WaitUntilFinished();
+        double seconds = SecondsSince(start);
+        if (uploadHandle->GetStatus() != TransferStatus::COMPLETED)
+        {
+            std::cout << "Upload failed." << std::endl;
+            break;
+        }
+        std::cout << PART_COUNT << " part file upload with " << readThreads << " read thread(s) took " << static_cast<int64_t>(seconds * 1000) << "ms"
+                  << std::endl;
+    }
+
+    Aws::FileSystem::RemoveFileIfExists(fileName.c_str());
+}
+
+/**
+ * Bulk transfers of a tree of 2,000 small files, 100 to a directory.
+ */
+AWS_BENCHMARK(TransferManagerBulkDirectoryTransfers)
+{
+    const size_t fileCount = 2000;
+    const size_t fileSize = 4 * PART_SIZE;
+    const Aws::String sourceDirectory = Aws::FileSystem::CreateTempFilePath();
+    const Aws::String targetDirectory = sourceDirectory + "-target";
+    for (size_t i = 0; i < fileCount; ++i)
+    {
+        Aws::String subDirectory = Aws::FileSystem::Join(sourceDirectory, "dir" + Aws::Utils::StringUtils::to_string(i / 100));
+        Aws::FileSystem::CreateDirectoryIfNotExists(subDirectory.c_str(), true);
+        Aws::String data = MakeObjectData(fileSize);
+        Aws::OFStream file(Aws::FileSystem::Join(subDirectory, "file" + Aws::Utils::StringUtils::to_string(i)).c_str(),
+                           std::ios_base::out | std::ios_base::binary);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    InMemoryTransfers transfers;
+    auto transferManagerConfig = transfers.CreateTransferManagerConfiguration();
+    transferManagerConfig.directoryMaxInFlight = 16;
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+
+    auto start = std::chrono::steady_clock::now();
+    auto uploadHandle = transferManager->BulkUploadDirectory(sourceDirectory, TEST_BUCKET, "prefix", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+    double uploadSeconds = SecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    auto downloadHandle = transferManager->BulkDownloadToDirectory(targetDirectory, TEST_BUCKET, "prefix");
+    downloadHandle->WaitUntilFinished();
+    double downloadSeconds = SecondsSince(start);
+
+    if (uploadHandle->GetStatus() != TransferStatus::COMPLETED || downloadHandle->GetStatus() != TransferStatus::COMPLETED)
+    {
+        std::cout << "Directory transfer failed." << std::endl;
+    }
+    else
+    {
+        std::cout << fileCount << " file directory upload: " << static_cast<int64_t>(fileCount / uploadSeconds) << " objects/s, "
+                  << static_cast<int64_t>(fileCount * fileSize / uploadSeconds / 1024) << "KB/s; download: "
+                  << static_cast<int64_t>(fileCount / downloadSeconds) << " objects/s, "
+                  << static_cast<int64_t>(fileCount * fileSize / downloadSeconds / 1024) << "KB/s" << std::endl;
+    }
+
+    Aws::FileSystem::DeepDeleteDirectory(sourceDirectory.c_str());
+    Aws::FileSystem::DeepDeleteDirectory(targetDirectory.c_str());
+}
+
+/**
+ * Transfers of 2MB parts with buffers from the heap and from a HugePagePartBufferPool.
+ */
+AWS_BENCHMARK(TransferManagerBufferPoolTransfers)
+{
+    const size_t partSize = 2 * 1024 * 1024;
+    const size_t partCount = 32;
+    const size_t maxBuffers = 8;
+    const Aws::String objectData = MakeObjectData(partSize * partCount);
+    auto bufferPool = Aws::MakeShared<HugePagePartBufferPool>(ALLOCATION_TAG, maxBuffers * partSize);
+
+    for (bool usePool : {false, true})
+    {
+        InMemoryTransfers transfers;
+        auto transferManagerConfig = transfers.CreateTransferManagerConfiguration();
+        transferManagerConfig.bufferSize = partSize;
+        transferManagerConfig.transferBufferMaxHeapSize = maxBuffers * partSize;
+        if (usePool)
+        {
+            transferManagerConfig.bufferPool = bufferPool;
+        }
+        auto transferManager = TransferManager::Create(transferManagerConfig);
+
+        auto start = std::chrono::steady_clock::now();
+        if (!UploadAndDownload(*transferManager, objectData))
+        {
+            std::cout << "Transfer failed." << std::endl;
+            return;
+        }
+        std::cout << partCount << " " << partSize / 1024 << "KB part upload and download with " << (usePool ? "the huge page pool" : "heap buffers")
+                  << " took " << static_cast<int64_t>(SecondsSince(start) * 1000) << "ms" << std::endl;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/transfer/DirectoryTransferHandle.h>
+#include <aws/core/platform/FileSystem.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+
+#include <atomic>
+#include <fstream>
+
+using namespace Aws::Transfer;
+using namespace Aws::Utils;
+
+namespace
+{
+static const char* ALLOCATION_TAG = "DirectoryTransferTest";
+
+class DirectoryTransferTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(DirectoryTransferTest, BulkDirectoryUploadAndDownload)
+{
+    // 4KB files, 100 to a directory
+    const size_t fileCount = 2000;
+    const size_t fileSize = 4 * PART_SIZE;
+    const Aws::String sourceDirectory = Aws::FileSystem::CreateTempFilePath();
+    const Aws::String targetDirectory = sourceDirectory + "-target";
+    Aws::Map<Aws::String, Aws::String> expectedObjects;
+    for (size_t i = 0; i < fileCount; ++i)
+    {
+        Aws::String subDirectory = "dir" + StringUtils::to_string(i / 100);
+        Aws::String fileName = "file" + StringUtils::to_string(i);
+        Aws::FileSystem::CreateDirectoryIfNotExists(Aws::FileSystem::Join(sourceDirectory, subDirectory).c_str(), true);
+        Aws::String data = MakeObjectData(fileSize);
+        data[0] = static_cast<char>('a' + i % 26);
+        Aws::OFStream file(Aws::FileSystem::Join(Aws::FileSystem::Join(sourceDirectory, subDirectory), fileName).c_str(), std::ios_base::out | std::ios_base::binary);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        expectedObjects["prefix/" + subDirectory + "/" + fileName] = data;
+    }
+
+    auto transferManagerConfig = CreateTransferManagerConfiguration();
+    transferManagerConfig.directoryMaxInFlight = 16;
+    std::atomic<size_t> progressCalls(0);
+    transferManagerConfig.directoryProgressCallback = [&progressCalls](const TransferManager*, const std::shared_ptr<const DirectoryTransferHandle>&) { ++progressCalls; };
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+    m_s3Client->SetListPageSize(300);
+
+    auto uploadHandle = transferManager->BulkUploadDirectory(sourceDirectory, TEST_BUCKET, "prefix", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+
+    ASSERT_EQ(TransferStatus::COMPLETED, uploadHandle->GetStatus());
+    ASSERT_EQ(fileCount, uploadHandle->GetObjectsTransferred());
+    ASSERT_EQ(0u, uploadHandle->GetObjectsFailed());
+    ASSERT_EQ(fileCount * fileSize, uploadHandle->GetBytesTransferred());
+    ASSERT_EQ(fileCount, m_s3Client->GetObjectCount());
+    for (const auto& object : expectedObjects)
+    {
+        ASSERT_EQ(object.second, m_s3Client->GetObjectData(object.first));
+    }
+    // batched, not one call per object
+    ASSERT_TRUE(progressCalls.load() >= 1);
+    ASSERT_TRUE(progressCalls.load() < fileCount / 10);
+
+    auto downloadHandle = transferManager->BulkDownloadToDirectory(targetDirectory, TEST_BUCKET, "prefix");
+    downloadHandle->WaitUntilFinished();
+
+    ASSERT_EQ(TransferStatus::COMPLETED, downloadHandle->GetStatus());
+    ASSERT_EQ(fileCount, downloadHandle->GetObjectsTransferred());
+    ASSERT_EQ(fileCount * fileSize, downloadHandle->GetBytesTransferred());
+    for (const auto& object : expectedObjects)
+    {
+        Aws::String relativePath = object.first.substr(sizeof("prefix/") - 1);
+        char delimiter[] = { Aws::FileSystem::PATH_DELIM, 0 };
+        StringUtils::Replace(relativePath, "/", delimiter);
+        Aws::IFStream file(Aws::FileSystem::Join(targetDirectory, relativePath).c_str(), std::ios_base::in | std::ios_base::binary);
+        Aws::StringStream contents;
+        contents << file.rdbuf();
+        ASSERT_EQ(object.second, contents.str());
+    }
+
+    Aws::FileSystem::DeepDeleteDirectory(sourceDirectory.c_str());
+    Aws::FileSystem::DeepDeleteDirectory(targetDirectory.c_str());
+}
+}
@@ -0,0 +1,444 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <aws/s3/S3Client.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
+#include <aws/s3/model/UploadPartCopyRequest.h>
+#include <aws/s3/model/CopyObjectRequest.h>
+#include <aws/s3/model/HeadObjectRequest.h>
+#include <aws/s3/model/GetObjectRequest.h>
+#include <aws/s3/model/PutObjectRequest.h>
+#include <aws/s3/model/ListObjectsV2Request.h>
+#include <aws/s3/model/ListPartsRequest.h>
+#include <aws/s3/model/SelectObjectContentRequest.h>
+#include <aws/core/auth/AWSCredentialsProvider.h>
+#include <aws/core/client/ClientConfiguration.h>
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/event/EventStream.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+static const char* const TEST_BUCKET = "bucket";
+static const char* const TEST_KEY = "manyParts";
+static const size_t PART_SIZE = 1024;
+static const size_t PART_COUNT = 10000;
+
+/**
+ * S3 client that keeps a single bucket in memory, just enough of it for TransferManager's multipart upload and download paths.
+ * The Async operations of S3Client call these on the client executor, so TransferManager runs exactly as it would against the service.
+ */
+class InMemoryS3Client : public Aws::S3::S3Client
+{
+public:
+    InMemoryS3Client(const Aws::Client::ClientConfiguration& clientConfiguration) :
+        Aws::S3::S3Client(Aws::Auth::AWSCredentials("access", "secret"), clientConfiguration)
+    {}
+
+    Aws::S3::Model::CreateMultipartUploadOutcome CreateMultipartUpload(const Aws::S3::Model::CreateMultipartUploadRequest& request) const override
+    {
+        ++m_createMultipartUploadCount;
+        Aws::S3::Model::CreateMultipartUploadResult result;
+        result.SetUploadId(request.GetKey() + "-upload");
+        return Aws::S3::Model::CreateMultipartUploadOutcome(std::move(result));
+    }
+
+    Aws::S3::Model::UploadPartOutcome UploadPart(const Aws::S3::Model::UploadPartRequest& request) const override
+    {
+        ++m_transferredPartCount;
+        if (m_failPartsFrom > 0 && static_cast<size_t>(request.GetPartNumber()) >= m_failPartsFrom)
+        {
+            return Aws::S3::Model::UploadPartOutcome(Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INTERNAL_FAILURE, false));
+        }
+        std::this_thread::sleep_for(m_partLatency);
+        Aws::StringStream body;
+        body << request.GetBody()->rdbuf();
+        Aws::String data = body.str();
+        request.GetDataSentEventHandler()(nullptr, static_cast<long long>(data.size()));
+        if (request.ContentMD5HasBeenSet() &&
+            request.GetContentMD5() != Aws::Utils::HashingUtils::Base64Encode(Aws::Utils::HashingUtils::CalculateMD5(data)))
+        {
+            return Aws::S3::Model::UploadPartOutcome(Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INVALID_PARAMETER_VALUE, "BadDigest",
+                    "Content-MD5 does not match", false));
+        }
+        if (static_cast<size_t>(request.GetPartNumber()) == m_corruptPart)
+        {
+            data[0] ^= 1;
+        }
+
+        Aws::S3::Model::UploadPartResult result;
+        result.SetETag("\"" + Aws::Utils::StringUtils::to_string(request.GetPartNumber()) + "\"");
+
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_uploadedParts[request.GetPartNumber()] = data;
+        return Aws::S3::Model::UploadPartOutcome(std::move(result));
+    }
+
+    Aws::S3::Model::UploadPartCopyOutcome UploadPartCopy(const Aws::S3::Model::UploadPartCopyRequest& request) const override
+    {
+        ++m_transferredPartCount;
+        ++m_copiedPartCount;
+        if (m_failPartsFrom > 0 && static_cast<size_t>(request.GetPartNumber()) >= m_failPartsFrom)
+        {
+            return Aws::S3::Model::UploadPartCopyOutcome(Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INTERNAL_FAILURE, false));
+        }
+        std::this_thread::sleep_for(m_partLatency);
+        Aws::String range = request.GetCopySourceRange().substr(sizeof("bytes=") - 1);
+        auto dash = range.find('-');
+        size_t first = static_cast<size_t>(Aws::Utils::StringUtils::ConvertToInt64(range.substr(0, dash).c_str()));
+        size_t length = static_cast<size_t>(Aws::Utils::StringUtils::ConvertToInt64(range.substr(dash + 1).c_str())) - first + 1;
+
+        Aws::S3::Model::UploadPartCopyResult result;
+        result.SetCopyPartResult(
+                Aws::S3::Model::CopyPartResult().WithETag("\"" + Aws::Utils::StringUtils::to_string(request.GetPartNumber()) + "\""));
+
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_uploadedParts[request.GetPartNumber()] = m_objects[GetCopySourceKey(request.GetCopySource())].substr(first, length);
+        return Aws::S3::Model::UploadPartCopyOutcome(std::move(result));
+    }
+
+    Aws::S3::Model::CopyObjectOutcome CopyObject(const Aws::S3::Model::CopyObjectRequest& request) const override
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_objects[request.GetKey()] = m_objects[GetCopySourceKey(request.GetCopySource())];
+        return Aws::S3::Model::CopyObjectOutcome(Aws::S3::Model::CopyObjectResult());
+    }
+
+    Aws::S3::Model::ListPartsOutcome ListParts(const Aws::S3::Model::ListPartsRequest&) const override
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        Aws::S3::Model::ListPartsResult result;
+        for (const auto& part : m_uploadedParts)
+        {
+            result.AddParts(Aws::S3::Model::Part().WithPartNumber(part.first).WithETag("\"" + Aws::Utils::StringUtils::to_string(part.first) + "\"")
+                    .WithSize(static_cast<long long>(part.second.size())));
+        }
+        return Aws::S3::Model::ListPartsOutcome(std::move(result));
+    }
+
+    Aws::S3::Model::CompleteMultipartUploadOutcome CompleteMultipartUpload(const Aws::S3::Model::CompleteMultipartUploadRequest& request) const override
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        Aws::String object;
+        Aws::String partMD5s;
+        for (const auto& part : request.GetMultipartUpload().GetParts())
+        {
+            object += m_uploadedParts[part.GetPartNumber()];
+            auto partMD5 = Aws::Utils::HashingUtils::CalculateMD5(m_uploadedParts[part.GetPartNumber()]);
+            partMD5s.append(reinterpret_cast<const char*>(partMD5.GetUnderlyingData()), partMD5.GetLength());
+        }
+        m_completedPartCount = request.GetMultipartUpload().GetParts().size();
+        m_objects[request.GetKey()] = object;
+        m_uploadedParts.clear();
+        Aws::S3::Model::CompleteMultipartUploadResult result;
+        result.SetETag("\"" + Aws::Utils::HashingUtils::HexEncode(Aws::Utils::HashingUtils::CalculateMD5(partMD5s)) + "-" +
+                Aws::Utils::StringUtils::to_string(m_completedPartCount) + "\"");
+        return Aws::S3::Model::CompleteMultipartUploadOutcome(std::move(result));
+    }
+
+    Aws::S3::Model::HeadObjectOutcome HeadObject(const Aws::S3::Model::HeadObjectRequest& request) const override
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        Aws::S3::Model::HeadObjectResult result;
+        result.SetContentLength(static_cast<long long>(m_objects[request.GetKey()].size()));
+        return Aws::S3::Model::HeadObjectOutcome(std::move(result));
+    }
+
+    Aws::S3::Model::GetObjectOutcome GetObject(const Aws::S3::Model::GetObjectRequest& request) const override
+    {
+        std::this_thread::sleep_for(m_partLatency);
+        // TransferManager asks for "bytes=first-last" when it downloads in parts
+        size_t first = 0;
+        size_t length = Aws::String::npos;
+        if (!request.GetRange().empty())
+        {
+            Aws::String range = request.GetRange().substr(sizeof("bytes=") - 1);
+            auto dash = range.find('-');
+            first = static_cast<size_t>(Aws::Utils::StringUtils::ConvertToInt64(range.substr(0, dash).c_str()));
+            length = static_cast<size_t>(Aws::Utils::StringUtils::ConvertToInt64(range.substr(dash + 1).c_str())) - first + 1;
+        }
+        ++m_transferredPartCount;
+        if (m_failPartsFrom > 0 && first / PART_SIZE + 1 >= m_failPartsFrom)
+        {
+            return Aws::S3::Model::GetObjectOutcome(Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INTERNAL_FAILURE, false));
+        }
+
+        Aws::String slice;
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            slice = m_objects[request.GetKey()].substr(first, length);
+        }
+
+        Aws::IOStream* body = request.GetResponseStreamFactory()();
+        body->write(slice.c_str(), static_cast<std::streamsize>(slice.size()));
+        if (request.GetDataReceivedEventHandler())
+        {
+            request.GetDataReceivedEventHandler()(nullptr, nullptr, static_cast<long long>(slice.size()));
+        }
+
+        Aws::AmazonWebServiceResult<Aws::Utils::Stream::ResponseStream> rawResult(Aws::Utils::Stream::ResponseStream(body),
+                Aws::Http::HeaderValueCollection(), request.GetRange().empty() ? Aws::Http::HttpResponseCode::OK : Aws::Http::HttpResponseCode::PARTIAL_CONTENT);
+        Aws::S3::Model::GetObjectResult result(std::move(rawResult));
+        result.SetContentLength(static_cast<long long>(slice.size()));
+        return Aws::S3::Model::GetObjectOutcome(std::move(result));
+    }
+
+    /**
+     * Runs "SELECT * FROM S3Object" over newline separated records: returns the records that start in the scan range, as S3 Select does,
+     * in two Records events, followed by Progress, Stats and End events.
+     */
+    Aws::S3::Model::SelectObjectContentOutcome SelectObjectContent(Aws::S3::Model::SelectObjectContentRequest& request) const override
+    {
+        Aws::String data;
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            data = m_objects[request.GetKey()];
+        }
+        size_t first = 0;
+        size_t last = data.size() - 1;
+        if (request.ScanRangeHasBeenSet())
+        {
+            first = static_cast<size_t>(request.GetScanRange().GetStart());
+            last = (std::min)(static_cast<size_t>(request.GetScanRange().GetEnd()), last);
+        }
+        ++m_selectCount;
+        if (m_failPartsFrom > 0 && first / PART_SIZE + 1 >= m_failPartsFrom)
+        {
+            return Aws::S3::Model::SelectObjectContentOutcome(Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INTERNAL_FAILURE, false));
+        }
+
+        size_t recordsStart = first == 0 ? 0 : (std::min)(data.find('\n', first - 1), data.size() - 1) + 1;
+        size_t recordsEnd = (std::min)(data.find('\n', last), data.size() - 1) + 1;
+        Aws::String records = recordsStart < recordsEnd ? data.substr(recordsStart, recordsEnd - recordsStart) : Aws::String();
+        Aws::String scanned = Aws::Utils::StringUtils::to_string(last - first + 1);
+        Aws::String counts = "<BytesScanned>" + scanned + "</BytesScanned><BytesProcessed>" + scanned + "</BytesProcessed><BytesReturned>" +
+            Aws::Utils::StringUtils::to_string(records.size()) + "</BytesReturned>";
+
+        request.GetEventStreamDecoder().Reset();
+        // the response body Aws::S3::S3Client hands the events to, which waits for the dispatched ones when it goes
+        Aws::Utils::Event::EventStream eventStream(request.GetEventStreamDecoder());
+        Aws::String stream;
+        AppendSelectEvent(stream, "Records", records.substr(0, records.size() / 2));
+        eventStream.write(stream.data(), static_cast<std::streamsize>(stream.size()));
+        eventStream.flush();
+        // ranges that start later take less time, so they finish out of order
+        std::this_thread::sleep_for(std::chrono::milliseconds(5 - (first / PART_SIZE) % 6));
+        stream.clear();
+        AppendSelectEvent(stream, "Records", records.substr(records.size() / 2));
+        if (request.GetRequestProgress().GetEnabled())
+        {
+            AppendSelectEvent(stream, "Progress", "<Progress>" + counts + "</Progress>");
+        }
+        AppendSelectEvent(stream, "Stats", "<Stats>" + counts + "</Stats>");
+        AppendSelectEvent(stream, "End", "");
+        eventStream.write(stream.data(), static_cast<std::streamsize>(stream.size()));
+        return Aws::S3::Model::SelectObjectContentOutcome(Aws::NoResult());
+    }
+
+    Aws::S3::Model::PutObjectOutcome PutObject(const Aws::S3::Model::PutObjectRequest& request) const override
+    {
+        std::this_thread::sleep_for(m_partLatency);
+        Aws::StringStream body;
+        body << request.GetBody()->rdbuf();
+
+        Aws::String data = body.str();
+        if (request.ContentMD5HasBeenSet() &&
+            request.GetContentMD5() != Aws::Utils::HashingUtils::Base64Encode(Aws::Utils::HashingUtils::CalculateMD5(data)))
+        {
+            return Aws::S3::Model::PutObjectOutcome(Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INVALID_PARAMETER_VALUE, "BadDigest",
+                    "Content-MD5 does not match", false));
+        }
+
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_objects[request.GetKey()] = data;
+        Aws::S3::Model::PutObjectResult result;
+        result.SetETag("\"" + Aws::Utils::HashingUtils::HexEncode(Aws::Utils::HashingUtils::CalculateMD5(data)) + "\"");
+        return Aws::S3::Model::PutObjectOutcome(std::move(result));
+    }
+
+    Aws::S3::Model::ListObjectsV2Outcome ListObjectsV2(const Aws::S3::Model::ListObjectsV2Request& request) const override
+    {
+        // the continuation token is the last key of the previous page
+        std::lock_guard<std::mutex> locker(m_lock);
+        Aws::S3::Model::ListObjectsV2Result result;
+        auto iter = request.GetContinuationToken().empty() ? m_objects.lower_bound(request.GetPrefix()) : m_objects.upper_bound(request.GetContinuationToken());
+        for (; iter != m_objects.end() && iter->first.compare(0, request.GetPrefix().size(), request.GetPrefix()) == 0; ++iter)
+        {
+            if (result.GetContents().size() == m_listPageSize)
+            {
+                result.SetIsTruncated(true);
+                result.SetNextContinuationToken(result.GetContents().back().GetKey());
+                break;
+            }
+            result.AddContents(Aws::S3::Model::Object().WithKey(iter->first).WithSize(static_cast<long long>(iter->second.size())));
+        }
+        return Aws::S3::Model::ListObjectsV2Outcome(std::move(result));
+    }
+
+    void SetListPageSize(size_t listPageSize)
+    {
+        m_listPageSize = listPageSize;
+    }
+
+    size_t GetObjectCount() const
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        return m_objects.size();
+    }
+
+    /**
+     * Time every part takes to transfer, on top of copying the data; parts transferred concurrently don't slow each other down.
+     */
+    void SetPartLatency(std::chrono::milliseconds latency)
+    {
+        m_partLatency = latency;
+    }
+
+    /**
+     * Fails the parts from partNumber on, in uploads and downloads of PART_SIZE parts. 0 fails none.
+     */
+    void SetFailPartsFrom(size_t partNumber)
+    {
+        m_failPartsFrom = partNumber;
+    }
+
+    /**
+     * Flips a bit of the given part once it has been checked against its Content-MD5, as if it went bad at rest. 0 corrupts none.
+     */
+    void SetCorruptPart(size_t partNumber)
+    {
+        m_corruptPart = partNumber;
+    }
+
+    /**
+     * UploadPart and GetObject calls, failed ones included.
+     */
+    size_t GetTransferredPartCount() const
+    {
+        return m_transferredPartCount;
+    }
+
+    size_t GetCopiedPartCount() const
+    {
+        return m_copiedPartCount;
+    }
+
+    size_t GetSelectCount() const
+    {
+        return m_selectCount;
+    }
+
+    size_t GetCreateMultipartUploadCount() const
+    {
+        return m_createMultipartUploadCount;
+    }
+
+    void PutObjectData(const Aws::String& key, const Aws::String& data)
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_objects[key] = data;
+    }
+
+    size_t GetCompletedPartCount() const
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        return m_completedPartCount;
+    }
+
+    Aws::String GetObjectData(const Aws::String& key) const
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        return m_objects[key];
+    }
+
+private:
+    static void AppendUInt32(Aws::String& bytes, uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            bytes.push_back(static_cast<char>(value >> shift));
+        }
+    }
+
+    /**
+     * Appends an S3 Select event to an event stream, encoded as the service encodes it.
+     */
+    static void AppendSelectEvent(Aws::String& stream, const Aws::String& eventType, const Aws::String& payload)
+    {
+        Aws::String headers;
+        const std::pair<Aws::String, Aws::String> headerValues[] = { { ":message-type", "event" }, { ":event-type", eventType } };
+        for (const auto& header : headerValues)
+        {
+            headers.push_back(static_cast<char>(header.first.size()));
+            headers += header.first;
+            headers.push_back(7); // string
+            headers.push_back(static_cast<char>(header.second.size() >> 8));
+            headers.push_back(static_cast<char>(header.second.size()));
+            headers += header.second;
+        }
+
+        size_t start = stream.size();
+        AppendUInt32(stream, static_cast<uint32_t>(12 + headers.size() + payload.size() + 4));
+        AppendUInt32(stream, static_cast<uint32_t>(headers.size()));
+        AppendUInt32(stream, Aws::Utils::HashingUtils::CalculateCRC32(reinterpret_cast<const unsigned char*>(stream.data() + start), 8));
+        stream += headers;
+        stream += payload;
+        AppendUInt32(stream,
+                Aws::Utils::HashingUtils::CalculateCRC32(reinterpret_cast<const unsigned char*>(stream.data() + start), stream.size() - start));
+    }
+
+    /// Copy sources are "bucket/key", with the key URL encoded
+    static Aws::String GetCopySourceKey(const Aws::String& copySource)
+    {
+        return Aws::Utils::StringUtils::URLDecode(copySource.substr(copySource.find('/') + 1).c_str());
+    }
+
+    mutable std::mutex m_lock;
+    mutable Aws::Map<int, Aws::String> m_uploadedParts;
+    mutable Aws::Map<Aws::String, Aws::String> m_objects;
+    mutable size_t m_completedPartCount = 0;
+    std::chrono::milliseconds m_partLatency = std::chrono::milliseconds(0);
+    size_t m_listPageSize = 1000;
+    std::atomic<size_t> m_failPartsFrom{0};
+    std::atomic<size_t> m_corruptPart{0};
+    mutable std::atomic<size_t> m_transferredPartCount{0};
+    mutable std::atomic<size_t> m_createMultipartUploadCount{0};
+    mutable std::atomic<size_t> m_copiedPartCount{0};
+    mutable std::atomic<size_t> m_selectCount{0};
+};
+
+/**
+ * Object data of the given size, different in every part of PART_SIZE.
+ */
+inline Aws::String MakeObjectData(size_t size = PART_SIZE * PART_COUNT)
+{
+    Aws::String data;
+    data.reserve(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        data.push_back(static_cast<char>('a' + (i * 7 + i / PART_SIZE) % 26));
+    }
+    return data;
+}
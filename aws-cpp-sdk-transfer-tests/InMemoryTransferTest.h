@@ -0,0 +1,72 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include "InMemoryS3Client.h"
+
+#include <aws/external/gtest.h>
+#include <aws/core/utils/threading/Executor.h>
+#include <aws/transfer/TransferManager.h>
+
+static const char* const IN_MEMORY_TRANSFER_TEST_TAG = "InMemoryTransferTest";
+
+/**
+ * Runs TransferManager against an InMemoryS3Client, with a client executor of 8 threads and a transfer executor of 2.
+ */
+class InMemoryTransferTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        m_clientExecutor = Aws::MakeShared<Aws::Utils::Threading::PooledThreadExecutor>(IN_MEMORY_TRANSFER_TEST_TAG, 8);
+        m_transferExecutor = Aws::MakeShared<Aws::Utils::Threading::PooledThreadExecutor>(IN_MEMORY_TRANSFER_TEST_TAG, 2);
+
+        Aws::Client::ClientConfiguration config;
+        config.executor = m_clientExecutor;
+        m_s3Client = Aws::MakeShared<InMemoryS3Client>(IN_MEMORY_TRANSFER_TEST_TAG, config);
+    }
+
+    void TearDown()
+    {
+        // a callback that is still returning holds its TransferManager, and with it the client and the client's executor,
+        // which must not be destroyed on one of its own threads
+        while (m_s3Client.use_count() > 1)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        m_s3Client = nullptr;
+        m_clientExecutor = nullptr;
+        m_transferExecutor = nullptr;
+    }
+
+    Aws::Transfer::TransferManagerConfiguration CreateTransferManagerConfiguration()
+    {
+        Aws::Transfer::TransferManagerConfiguration transferManagerConfig(m_transferExecutor.get());
+        transferManagerConfig.s3Client = m_s3Client;
+        transferManagerConfig.bufferSize = PART_SIZE;
+        transferManagerConfig.transferBufferMaxHeapSize = 64 * PART_SIZE;
+        return transferManagerConfig;
+    }
+
+    std::shared_ptr<Aws::Transfer::TransferManager> CreateTransferManager()
+    {
+        return Aws::Transfer::TransferManager::Create(CreateTransferManagerConfiguration());
+    }
+
+    std::shared_ptr<Aws::Utils::Threading::PooledThreadExecutor> m_clientExecutor;
+    std::shared_ptr<Aws::Utils::Threading::PooledThreadExecutor> m_transferExecutor;
+    std::shared_ptr<InMemoryS3Client> m_s3Client;
+};
@@ -0,0 +1,59 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/core/platform/FileSystem.h>
+#include <aws/core/utils/memory/stl/AWSStreamFwd.h>
+
+#include <fstream>
+
+using namespace Aws::Transfer;
+
+namespace
+{
+static const char* ALLOCATION_TAG = "ParallelFileUploadTest";
+
+class ParallelFileUploadTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(ParallelFileUploadTest, FileUploadReadsPartsInParallel)
+{
+    const Aws::String objectData = MakeObjectData();
+    const Aws::String fileName = Aws::FileSystem::CreateTempFilePath();
+    {
+        Aws::OFStream file(fileName.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        file.write(objectData.data(), static_cast<std::streamsize>(objectData.size()));
+    }
+
+    for (size_t readThreads : {static_cast<size_t>(1), static_cast<size_t>(4)})
+    {
+        auto transferManagerConfig = CreateTransferManagerConfiguration();
+        transferManagerConfig.uploadReadThreads = readThreads;
+        auto transferManager = TransferManager::Create(transferManagerConfig);
+
+        auto uploadHandle = transferManager->UploadFile(fileName, TEST_BUCKET, TEST_KEY, "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+        uploadHandle->WaitUntilFinished();
+
+        ASSERT_EQ(TransferStatus::COMPLETED, uploadHandle->GetStatus());
+        ASSERT_EQ(PART_COUNT, uploadHandle->GetCompletedParts().size());
+        ASSERT_EQ(objectData, m_s3Client->GetObjectData(TEST_KEY));
+    }
+
+    Aws::FileSystem::RemoveFileIfExists(fileName.c_str());
+}
+}
@@ -0,0 +1,114 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/transfer/ParallelObjectSelector.h>
+#include <aws/core/utils/StringUtils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+using namespace Aws::S3;
+using namespace Aws::S3::Model;
+using namespace Aws::Transfer;
+using namespace Aws::Utils;
+
+namespace
+{
+static const char* ALLOCATION_TAG = "ParallelObjectSelectorTest";
+
+class ParallelObjectSelectorTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(ParallelObjectSelectorTest, ParallelSelectMergesScanRanges)
+{
+    Aws::String objectData;
+    for (size_t i = 0; objectData.size() < 200 * PART_SIZE; ++i)
+    {
+        objectData += StringUtils::to_string(i) + "," + Aws::String(i % 37, 'x') + "\n";
+    }
+    m_s3Client->PutObjectData(TEST_KEY, objectData);
+    const size_t rangeCount = (objectData.size() + 4 * PART_SIZE - 1) / (4 * PART_SIZE);
+
+    SelectObjectContentRequest request;
+    request.WithBucket(TEST_BUCKET).WithKey(TEST_KEY).WithExpression("SELECT * FROM S3Object").WithExpressionType(ExpressionType::SQL);
+    request.SetInputSerialization(InputSerialization().WithCSV(CSVInput()));
+    request.SetOutputSerialization(OutputSerialization().WithCSV(CSVOutput()));
+    request.SetRequestProgress(RequestProgress().WithEnabled(true));
+
+    ParallelObjectSelectorConfiguration selectorConfig;
+    selectorConfig.s3Client = m_s3Client;
+    selectorConfig.scanRangeSize = 4 * PART_SIZE;
+    selectorConfig.maxConcurrentRanges = 6;
+    for (auto recordsOrder : { SelectRecordsOrder::OBJECT_ORDER, SelectRecordsOrder::ARRIVAL_ORDER })
+    {
+        selectorConfig.recordsOrder = recordsOrder;
+        ParallelObjectSelector selector(selectorConfig);
+        Aws::String records;
+        std::atomic<int> callbacksInside(0);
+        bool concurrentCallbacks = false;
+        Progress lastProgress;
+        auto selectsBefore = m_s3Client->GetSelectCount();
+        auto outcome = selector.Select(request, [&](const unsigned char* payload, size_t length)
+        {
+            concurrentCallbacks |= ++callbacksInside > 1;
+            records.append(reinterpret_cast<const char*>(payload), length);
+            --callbacksInside;
+        }, [&](const Progress& progress) { lastProgress = progress; });
+
+        ASSERT_TRUE(outcome.IsSuccess());
+        ASSERT_FALSE(concurrentCallbacks);
+        ASSERT_EQ(rangeCount, m_s3Client->GetSelectCount() - selectsBefore);
+        ASSERT_EQ(static_cast<long long>(objectData.size()), outcome.GetResult().GetBytesScanned());
+        ASSERT_EQ(static_cast<long long>(objectData.size()), outcome.GetResult().GetBytesReturned());
+        ASSERT_EQ(static_cast<long long>(objectData.size()), lastProgress.GetBytesScanned());
+        if (recordsOrder == SelectRecordsOrder::OBJECT_ORDER)
+        {
+            ASSERT_EQ(objectData, records);
+        }
+        else
+        {
+            // every record once, in whatever order the ranges returned them
+            auto expectedRecords = StringUtils::Split(objectData, '\n');
+            auto returnedRecords = StringUtils::Split(records, '\n');
+            std::sort(expectedRecords.begin(), expectedRecords.end());
+            std::sort(returnedRecords.begin(), returnedRecords.end());
+            ASSERT_EQ(expectedRecords, returnedRecords);
+        }
+    }
+
+    // compressed objects can't be scanned by range, so they are selected whole
+    ParallelObjectSelector selector(selectorConfig);
+    request.SetInputSerialization(InputSerialization().WithCSV(CSVInput()).WithCompressionType(CompressionType::GZIP));
+    Aws::String records;
+    auto selectsBefore = m_s3Client->GetSelectCount();
+    auto outcome = selector.Select(request, [&](const unsigned char* payload, size_t length) { records.append(reinterpret_cast<const char*>(payload), length); });
+    ASSERT_TRUE(outcome.IsSuccess());
+    ASSERT_EQ(1u, m_s3Client->GetSelectCount() - selectsBefore);
+    ASSERT_EQ(objectData, records);
+
+    // a failed range fails the select
+    request.SetInputSerialization(InputSerialization().WithCSV(CSVInput()));
+    m_s3Client->SetFailPartsFrom(100);
+    outcome = selector.Select(request, [](const unsigned char*, size_t) {});
+    m_s3Client->SetFailPartsFrom(0);
+    ASSERT_FALSE(outcome.IsSuccess());
+    ASSERT_EQ(S3Errors::INTERNAL_FAILURE, outcome.GetError().GetErrorType());
+}
+}
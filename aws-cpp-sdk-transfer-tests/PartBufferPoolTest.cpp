@@ -0,0 +1,141 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/transfer/PartBufferPool.h>
+#include <aws/core/utils/Array.h>
+#include <aws/core/utils/stream/PreallocatedStreamBuf.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <cstring>
+
+using namespace Aws::Transfer;
+
+namespace
+{
+static const size_t MB = 1024 * 1024;
+static const char* ALLOCATION_TAG = "PartBufferPoolTest";
+
+TEST(HugePagePartBufferPoolTest, GrowsLazilyAndReusesReleasedBuffers)
+{
+    HugePagePartBufferPool pool(2 * 4 * MB);
+    ASSERT_LE(1u, pool.GetNodeCount());
+    ASSERT_EQ(0u, pool.GetAllocatedBufferCount());
+
+    Aws::Vector<Aws::Utils::Array<uint8_t>*> buffers;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        auto buffer = pool.Acquire(4 * MB);
+        ASSERT_EQ(4 * MB, buffer->GetLength());
+        memset(buffer->GetUnderlyingData(), static_cast<int>(i), buffer->GetLength());
+        buffers.push_back(buffer);
+    }
+    ASSERT_EQ(3u, pool.GetAllocatedBufferCount());
+#ifdef __linux__
+    ASSERT_EQ(3u, pool.GetMappedBufferCount());
+#endif
+
+    // only two fit under the idle limit, the third is freed
+    for (auto buffer : buffers)
+    {
+        pool.Release(buffer);
+    }
+    ASSERT_EQ(2u, pool.GetAllocatedBufferCount());
+
+    auto first = pool.Acquire(4 * MB);
+    auto second = pool.Acquire(4 * MB);
+    ASSERT_EQ(2u, pool.GetAllocatedBufferCount());
+    auto third = pool.Acquire(4 * MB);
+    ASSERT_EQ(3u, pool.GetAllocatedBufferCount());
+
+    // buffers smaller than a huge page come from the heap, and are pooled by size all the same
+    auto small = pool.Acquire(1024);
+    ASSERT_EQ(1024u, small->GetLength());
+    ASSERT_EQ(4u, pool.GetAllocatedBufferCount());
+#ifdef __linux__
+    ASSERT_EQ(3u, pool.GetMappedBufferCount());
+#endif
+
+    pool.Release(small);
+    ASSERT_EQ(small, pool.Acquire(1024));
+    pool.Release(small);
+    pool.Release(first);
+    pool.Release(second);
+    pool.Release(third);
+}
+
+class TransferManagerBufferPoolTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(TransferManagerBufferPoolTest, PartsGoThroughTheBufferPool)
+{
+    const size_t partSize = 2 * 1024 * 1024;
+    const size_t partCount = 32;
+    const size_t maxBuffers = 8;
+    const Aws::String objectData = MakeObjectData(partSize * partCount);
+    auto bufferPool = Aws::MakeShared<HugePagePartBufferPool>(ALLOCATION_TAG, maxBuffers * partSize);
+
+    for (bool usePool : {false, true})
+    {
+        auto transferManagerConfig = CreateTransferManagerConfiguration();
+        transferManagerConfig.bufferSize = partSize;
+        transferManagerConfig.transferBufferMaxHeapSize = maxBuffers * partSize;
+        if (usePool)
+        {
+            transferManagerConfig.bufferPool = bufferPool;
+        }
+        auto transferManager = TransferManager::Create(transferManagerConfig);
+
+        auto uploadHandle = transferManager->UploadFile(Aws::MakeShared<Aws::StringStream>(ALLOCATION_TAG, objectData), TEST_BUCKET, TEST_KEY,
+                                                        "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+        uploadHandle->WaitUntilFinished();
+        ASSERT_EQ(TransferStatus::COMPLETED, uploadHandle->GetStatus());
+        ASSERT_EQ(partCount, uploadHandle->GetCompletedParts().size());
+
+        Aws::Utils::Array<uint8_t> downloadBuffer(objectData.size());
+        CreateDownloadStreamCallback createStream = [&downloadBuffer]()
+        {
+            return Aws::New<Aws::Utils::Stream::DefaultUnderlyingStream>(ALLOCATION_TAG,
+                    Aws::MakeUnique<Aws::Utils::Stream::PreallocatedStreamBuf>(ALLOCATION_TAG, &downloadBuffer, downloadBuffer.GetLength()));
+        };
+        auto downloadHandle = transferManager->DownloadFile(TEST_BUCKET, TEST_KEY, createStream);
+        downloadHandle->WaitUntilFinished();
+        ASSERT_EQ(TransferStatus::COMPLETED, downloadHandle->GetStatus());
+        ASSERT_EQ(objectData, Aws::String(reinterpret_cast<const char*>(downloadBuffer.GetUnderlyingData()), downloadBuffer.GetLength()));
+    }
+
+    // buffers were allocated as parts needed them, and never more than the parts allowed in flight
+    ASSERT_LE(bufferPool->GetAllocatedBufferCount(), maxBuffers);
+    ASSERT_LT(0u, bufferPool->GetAllocatedBufferCount());
+
+    // auto tuning takes its buffers from the pool as well
+    auto transferManagerConfig = CreateTransferManagerConfiguration();
+    transferManagerConfig.enableAutoTuning = true;
+    transferManagerConfig.bufferSize = partSize;
+    transferManagerConfig.maxInFlightParts = maxBuffers;
+    transferManagerConfig.bufferPool = bufferPool;
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+    auto uploadHandle = transferManager->UploadFile(Aws::MakeShared<Aws::StringStream>(ALLOCATION_TAG, objectData), TEST_BUCKET, TEST_KEY,
+                                                    "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, uploadHandle->GetStatus());
+    ASSERT_EQ(objectData, m_s3Client->GetObjectData(TEST_KEY));
+    ASSERT_LE(bufferPool->GetAllocatedBufferCount(), maxBuffers);
+}
+}
@@ -0,0 +1,206 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/transfer/PartConcurrencyTuner.h>
+#include <aws/core/utils/Array.h>
+#include <aws/core/utils/stream/PreallocatedStreamBuf.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace Aws::Transfer;
+
+namespace
+{
+static const uint64_t MB = 1024 * 1024;
+static const char* ALLOCATION_TAG = "PartConcurrencyTunerTest";
+
+typedef std::chrono::steady_clock Clock;
+
+static Clock::duration ToDuration(double seconds)
+{
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+struct LinkResult
+{
+    double throughput;
+    double averageInFlight;
+};
+
+/**
+ * Simulates transferring parts over a link with the given aggregate bandwidth, per-connection bandwidth and round trip time.
+ * Parts are started whenever the tuner allows it, and each part takes the round trip time plus its size over its share of the bandwidth.
+ * Returns the average throughput, in bytes per second, and the average number of parts in flight over the last quarter of the parts.
+ */
+static LinkResult SimulateLink(PartConcurrencyTuner& tuner, size_t partCount, uint64_t partSize, double linkBytesPerSecond,
+                               double connectionBytesPerSecond, double roundTripSeconds)
+{
+    const Clock::time_point base = Clock::now();
+    double now = 0;
+    // start and finish time of each part in flight
+    Aws::Vector<std::pair<double, double>> inFlight;
+    size_t started = 0;
+    size_t finished = 0;
+    double measureStart = 0;
+    uint64_t measuredBytes = 0;
+    double measuredPartSeconds = 0;
+
+    while (finished < partCount)
+    {
+        while (started < partCount && inFlight.size() < tuner.GetInFlightLimit())
+        {
+            tuner.AcquirePart(partSize);
+            double share = (std::min)(connectionBytesPerSecond, linkBytesPerSecond / static_cast<double>(inFlight.size() + 1));
+            inFlight.push_back(std::make_pair(now, now + roundTripSeconds + static_cast<double>(partSize) / share));
+            ++started;
+        }
+
+        auto next = std::min_element(inFlight.begin(), inFlight.end(),
+                [](const std::pair<double, double>& a, const std::pair<double, double>& b) { return a.second < b.second; });
+        if (finished >= partCount * 3 / 4)
+        {
+            measuredPartSeconds += static_cast<double>(inFlight.size()) * (next->second - now);
+        }
+        now = next->second;
+        tuner.RecordPart(partSize, ToDuration(next->second - next->first), true, base + ToDuration(now));
+        tuner.ReleasePart(partSize);
+        inFlight.erase(next);
+
+        if (++finished == partCount * 3 / 4)
+        {
+            measureStart = now;
+        }
+        else if (finished > partCount * 3 / 4)
+        {
+            measuredBytes += partSize;
+        }
+    }
+
+    LinkResult result;
+    result.throughput = static_cast<double>(measuredBytes) / (now - measureStart);
+    result.averageInFlight = measuredPartSeconds / (now - measureStart);
+    return result;
+}
+
+TEST(PartConcurrencyTunerTest, ComputePartSize)
+{
+    // small objects keep the minimum part size
+    ASSERT_EQ(5 * MB, PartConcurrencyTuner::ComputePartSize(100 * MB, 5 * MB, 10000));
+    ASSERT_EQ(5 * MB, PartConcurrencyTuner::ComputePartSize(0, 5 * MB, 10000));
+    // 50,000MB is exactly 10,000 parts of 5MB
+    ASSERT_EQ(5 * MB, PartConcurrencyTuner::ComputePartSize(50000 * MB, 5 * MB, 10000));
+    // one byte more needs the next multiple
+    ASSERT_EQ(10 * MB, PartConcurrencyTuner::ComputePartSize(50000 * MB + 1, 5 * MB, 10000));
+    // a 5TB object, the largest S3 stores
+    uint64_t partSize = PartConcurrencyTuner::ComputePartSize(5 * 1024 * 1024 * MB, 5 * MB, 10000);
+    ASSERT_EQ(0u, partSize % (5 * MB));
+    ASSERT_TRUE((5 * 1024 * 1024 * MB + partSize - 1) / partSize <= 10000);
+    // never more than 5GB per part
+    ASSERT_EQ(5 * 1024 * MB, PartConcurrencyTuner::ComputePartSize(1024 * 1024 * 1024 * MB, 5 * MB, 10000));
+}
+
+TEST(PartConcurrencyTunerTest, ConvergesTowardBandwidthDelayProduct)
+{
+    // 1GB/s link, 50MB/s per connection, 20ms round trip and 8MB parts: one part takes 180ms on its own, so about 23 parts fill the link
+    const uint64_t partSize = 8 * MB;
+    const double linkBytesPerSecond = 1024.0 * MB;
+    PartConcurrencyTuner tuner(4, 256, 1024 * MB);
+
+    LinkResult result = SimulateLink(tuner, 4000, partSize, linkBytesPerSecond, 50.0 * MB, 0.02);
+
+    ASSERT_TRUE(result.throughput >= 0.9 * linkBytesPerSecond);
+    ASSERT_TRUE(result.averageInFlight >= 20);
+    ASSERT_TRUE(result.averageInFlight <= 40);
+    ASSERT_TRUE(tuner.GetInFlightLimit() <= 64);
+}
+
+TEST(PartConcurrencyTunerTest, StaysWithinBounds)
+{
+    PartConcurrencyTuner bounded(2, 8, 1024 * MB);
+    SimulateLink(bounded, 1000, 8 * MB, 1024.0 * MB, 50.0 * MB, 0.02);
+    ASSERT_EQ(8u, bounded.GetInFlightLimit());
+
+    // a slow link needs no more than a few parts
+    PartConcurrencyTuner slowLink(1, 256, 1024 * MB);
+    LinkResult result = SimulateLink(slowLink, 1000, 8 * MB, 20.0 * MB, 50.0 * MB, 0.02);
+    ASSERT_TRUE(result.averageInFlight <= 4);
+    ASSERT_TRUE(slowLink.GetInFlightLimit() <= 4);
+}
+
+TEST(PartConcurrencyTunerTest, FailuresShrinkTheLimit)
+{
+    PartConcurrencyTuner tuner(4, 256, 1024 * MB);
+    SimulateLink(tuner, 2000, 8 * MB, 1024.0 * MB, 50.0 * MB, 0.02);
+    size_t limit = tuner.GetInFlightLimit();
+
+    tuner.AcquirePart(8 * MB);
+    tuner.RecordPart(8 * MB, std::chrono::milliseconds(100), false);
+    tuner.ReleasePart(8 * MB);
+    ASSERT_TRUE(tuner.GetInFlightLimit() < limit);
+}
+
+class TransferManagerAutoTuningTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(TransferManagerAutoTuningTest, AutoTuningSizesAndParallelizesParts)
+{
+    // scaled down from S3's limits: a 1KB minimum part and 1,000 parts at most, where S3 has 5MB and 10,000
+    const size_t maxPartCount = 1000;
+    const Aws::String objectData = MakeObjectData(10 * maxPartCount * PART_SIZE + 1);
+    const uint64_t expectedPartSize = 11 * PART_SIZE;
+
+    auto transferManagerConfig = CreateTransferManagerConfiguration();
+    transferManagerConfig.enableAutoTuning = true;
+    transferManagerConfig.maxPartCount = maxPartCount;
+    transferManagerConfig.minInFlightParts = 2;
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+    // the client executor runs 8 parts at a time, so throughput keeps growing with the limit up to 8 parts in flight
+    m_s3Client->SetPartLatency(std::chrono::milliseconds(2));
+
+    auto uploadStream = Aws::MakeShared<Aws::StringStream>(ALLOCATION_TAG, objectData);
+    auto uploadHandle = transferManager->UploadFile(uploadStream, TEST_BUCKET, TEST_KEY, "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+
+    ASSERT_EQ(TransferStatus::COMPLETED, uploadHandle->GetStatus());
+    ASSERT_EQ(expectedPartSize, uploadHandle->GetPartSize());
+    ASSERT_TRUE(uploadHandle->GetCompletedParts().size() <= maxPartCount);
+    ASSERT_EQ((objectData.size() + expectedPartSize - 1) / expectedPartSize, m_s3Client->GetCompletedPartCount());
+    ASSERT_EQ(objectData, m_s3Client->GetObjectData(TEST_KEY));
+    ASSERT_TRUE(uploadHandle->GetInFlightPartLimit() > transferManagerConfig.minInFlightParts);
+
+    Aws::Utils::Array<uint8_t> downloadBuffer(objectData.size());
+    CreateDownloadStreamCallback createStream = [&downloadBuffer]()
+    {
+        return Aws::New<Aws::Utils::Stream::DefaultUnderlyingStream>(ALLOCATION_TAG,
+                Aws::MakeUnique<Aws::Utils::Stream::PreallocatedStreamBuf>(ALLOCATION_TAG, &downloadBuffer, downloadBuffer.GetLength()));
+    };
+
+    auto downloadHandle = transferManager->DownloadFile(TEST_BUCKET, TEST_KEY, createStream);
+    downloadHandle->WaitUntilFinished();
+
+    ASSERT_EQ(TransferStatus::COMPLETED, downloadHandle->GetStatus());
+    ASSERT_EQ(expectedPartSize, downloadHandle->GetPartSize());
+    ASSERT_TRUE(downloadHandle->GetCompletedParts().size() <= maxPartCount);
+    ASSERT_TRUE(downloadHandle->GetInFlightPartLimit() > transferManagerConfig.minInFlightParts);
+    ASSERT_EQ(objectData, Aws::String(reinterpret_cast<const char*>(downloadBuffer.GetUnderlyingData()), downloadBuffer.GetLength()));
+}
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/transfer/RangedObjectReader.h>
+
+using namespace Aws::S3;
+using namespace Aws::Transfer;
+
+namespace
+{
+static const char* ALLOCATION_TAG = "RangedObjectReaderTest";
+
+class RangedObjectReaderTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(RangedObjectReaderTest, RangedReaderSplitsAndCoalescesRanges)
+{
+    const Aws::String objectData = MakeObjectData(1000 * PART_SIZE);
+    m_s3Client->PutObjectData(TEST_KEY, objectData);
+
+    RangedObjectReaderConfiguration readerConfig;
+    readerConfig.s3Client = m_s3Client;
+    readerConfig.subRangeSize = 16 * PART_SIZE;
+    readerConfig.maxInFlightRequests = 4;
+    readerConfig.coalesceGap = 2 * PART_SIZE;
+    RangedObjectReader reader(readerConfig);
+
+    // a long range is split into even pieces of at most subRangeSize
+    const size_t longOffset = 1234;
+    const size_t longLength = 300 * PART_SIZE;
+    Aws::String longRange(longLength, '\0');
+    auto requestsBefore = m_s3Client->GetTransferredPartCount();
+    ASSERT_TRUE(reader.Read(TEST_BUCKET, TEST_KEY, longOffset, longLength, reinterpret_cast<uint8_t*>(&longRange[0])).IsSuccess());
+    ASSERT_EQ(19u, m_s3Client->GetTransferredPartCount() - requestsBefore);
+    ASSERT_EQ(objectData.substr(longOffset, longLength), longRange);
+
+    // 100 small ranges a little apart are read together, an overlapping one with them, and a distant one on its own
+    Aws::Vector<Aws::String> buffers;
+    Aws::Vector<RangeRead> ranges;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        ranges.emplace_back(10 * PART_SIZE + i * 1000, 100, nullptr);
+    }
+    ranges.emplace_back(10 * PART_SIZE + 50 * 1000 + 50, 2000, nullptr);
+    ranges.emplace_back(900 * PART_SIZE, 3 * PART_SIZE, nullptr);
+    std::reverse(ranges.begin(), ranges.end());
+    buffers.resize(ranges.size());
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        buffers[i].resize(static_cast<size_t>(ranges[i].length));
+        ranges[i].buffer = reinterpret_cast<uint8_t*>(&buffers[i][0]);
+    }
+
+    requestsBefore = m_s3Client->GetTransferredPartCount();
+    ASSERT_TRUE(reader.Read(TEST_BUCKET, TEST_KEY, ranges).IsSuccess());
+    // 99,100 bytes from the first range to the end of the last close one make 7 requests, and the distant range one more
+    ASSERT_EQ(8u, m_s3Client->GetTransferredPartCount() - requestsBefore);
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        ASSERT_EQ(objectData.substr(static_cast<size_t>(ranges[i].offset), static_cast<size_t>(ranges[i].length)), buffers[i]);
+    }
+
+    // a failed request fails the read
+    m_s3Client->SetFailPartsFrom(500);
+    auto outcome = reader.Read(TEST_BUCKET, TEST_KEY, 400 * PART_SIZE, 200 * PART_SIZE, reinterpret_cast<uint8_t*>(&longRange[0]));
+    m_s3Client->SetFailPartsFrom(0);
+    ASSERT_FALSE(outcome.IsSuccess());
+    ASSERT_EQ(S3Errors::INTERNAL_FAILURE, outcome.GetError().GetErrorType());
+}
+}
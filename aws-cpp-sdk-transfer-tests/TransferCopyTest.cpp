@@ -0,0 +1,71 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+
+using namespace Aws::Transfer;
+
+namespace
+{
+static const char* ALLOCATION_TAG = "TransferCopyTest";
+
+class TransferCopyTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(TransferCopyTest, CopyObjectCopiesPartsServerSide)
+{
+    const size_t partCount = 100;
+    const Aws::String sourceKey = "source object";
+    const Aws::String objectData = MakeObjectData(partCount * PART_SIZE - 10);
+    m_s3Client->PutObjectData(sourceKey, objectData);
+
+    auto transferManagerConfig = CreateTransferManagerConfiguration();
+    std::atomic<size_t> progressCallbacks(0);
+    transferManagerConfig.uploadProgressCallback = [&progressCallbacks](const TransferManager*, const std::shared_ptr<const TransferHandle>&) { ++progressCallbacks; };
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+
+    // the first attempt copies 60 parts before the rest fail, and the retry copies only those
+    m_s3Client->SetFailPartsFrom(61);
+    auto copyHandle = transferManager->CopyObject(TEST_BUCKET, sourceKey, TEST_BUCKET, TEST_KEY);
+    copyHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::FAILED, copyHandle->GetStatus());
+    ASSERT_TRUE(copyHandle->IsMultipart());
+    ASSERT_EQ(partCount, m_s3Client->GetCopiedPartCount());
+
+    m_s3Client->SetFailPartsFrom(0);
+    copyHandle = transferManager->RetryCopy(copyHandle);
+    copyHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, copyHandle->GetStatus());
+    ASSERT_EQ(partCount + 40, m_s3Client->GetCopiedPartCount());
+    ASSERT_EQ(1u, m_s3Client->GetCreateMultipartUploadCount());
+    ASSERT_EQ(partCount, m_s3Client->GetCompletedPartCount());
+    ASSERT_EQ(objectData.size(), copyHandle->GetBytesTransferred());
+    ASSERT_EQ(objectData, m_s3Client->GetObjectData(TEST_KEY));
+    ASSERT_TRUE(progressCallbacks >= partCount);
+
+    // an object that fits in one part is copied whole
+    const Aws::String smallData = MakeObjectData(PART_SIZE / 2);
+    m_s3Client->PutObjectData(sourceKey, smallData);
+    copyHandle = transferManager->CopyObject(TEST_BUCKET, sourceKey, TEST_BUCKET, "small copy");
+    copyHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, copyHandle->GetStatus());
+    ASSERT_FALSE(copyHandle->IsMultipart());
+    ASSERT_EQ(partCount + 40, m_s3Client->GetCopiedPartCount());
+    ASSERT_EQ(smallData, m_s3Client->GetObjectData("small copy"));
+}
+}
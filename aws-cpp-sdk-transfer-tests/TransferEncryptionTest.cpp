@@ -0,0 +1,236 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/transfer/TransferEncryption.h>
+#include <aws/core/platform/FileSystem.h>
+#include <aws/core/utils/Array.h>
+#include <aws/core/utils/stream/PreallocatedStreamBuf.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+
+using namespace Aws::S3;
+using namespace Aws::S3::Model;
+using namespace Aws::Transfer;
+using namespace Aws::Client;
+
+namespace
+{
+static const char* ALLOCATION_TAG = "TransferEncryptionTest";
+
+/**
+ * Stand-in for client-side encryption: bytes are XORed with a pad that depends on their offset in the object, and the last part gets a
+ * block of trailer, so parts encrypt and decrypt independently and the ciphertext is longer than the plain text, as it is with AES.
+ */
+class OffsetXorEncryption : public TransferEncryption
+{
+public:
+    static const size_t BLOCK_SIZE = 16;
+
+    static unsigned char Pad(uint64_t offset)
+    {
+        return static_cast<unsigned char>(offset * 31 + 7);
+    }
+
+    static Aws::String Encrypt(const Aws::String& plaintext)
+    {
+        Aws::String ciphertext(plaintext);
+        for (size_t i = 0; i < ciphertext.size(); ++i)
+        {
+            ciphertext[i] = static_cast<char>(ciphertext[i] ^ Pad(i));
+        }
+        return ciphertext + Aws::String(BLOCK_SIZE, 'T');
+    }
+
+    class Encryptor : public PartEncryptor
+    {
+    public:
+        size_t EncryptPart(int partNumber, unsigned char* buffer, size_t length, size_t capacity, bool lastPart) override
+        {
+            if (partNumber == 1)
+            {
+                m_partSize = length;
+            }
+            if (length + (lastPart ? BLOCK_SIZE : 0) > capacity || (!lastPart && length % BLOCK_SIZE != 0))
+            {
+                return 0;
+            }
+            uint64_t offset = static_cast<uint64_t>(partNumber - 1) * m_partSize;
+            for (size_t i = 0; i < length; ++i)
+            {
+                buffer[i] ^= Pad(offset + i);
+            }
+            if (!lastPart)
+            {
+                return length;
+            }
+            memset(buffer + length, 'T', BLOCK_SIZE);
+            return length + BLOCK_SIZE;
+        }
+
+    private:
+        size_t m_partSize = 0;
+    };
+
+    class Decryptor : public PartDecryptor
+    {
+    public:
+        Decryptor(uint64_t plaintextLength) : m_plaintextLength(plaintextLength) {}
+
+        uint64_t GetPlaintextLength() const override
+        {
+            return m_plaintextLength;
+        }
+
+        std::pair<uint64_t, uint64_t> GetCiphertextRange(uint64_t offset, size_t length) const override
+        {
+            return std::make_pair(offset, offset + length - 1);
+        }
+
+        bool DecryptPart(uint64_t offset, size_t length, unsigned char* buffer, size_t ciphertextLength, size_t capacity) const override
+        {
+            if (offset % BLOCK_SIZE != 0 || ciphertextLength != length || capacity < length)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < length; ++i)
+            {
+                buffer[i] ^= Pad(offset + i);
+            }
+            return true;
+        }
+
+    private:
+        uint64_t m_plaintextLength;
+    };
+
+    size_t GetBlockSize() const override
+    {
+        return BLOCK_SIZE;
+    }
+
+    size_t GetMaxPartOverhead() const override
+    {
+        return BLOCK_SIZE;
+    }
+
+    PartEncryptorOutcome BeginUpload(CreateMultipartUploadRequest&) override
+    {
+        ++m_uploadCount;
+        return PartEncryptorOutcome(std::static_pointer_cast<PartEncryptor>(Aws::MakeShared<Encryptor>(ALLOCATION_TAG)));
+    }
+
+    PartEncryptorOutcome BeginUpload(PutObjectRequest&) override
+    {
+        ++m_uploadCount;
+        return PartEncryptorOutcome(std::static_pointer_cast<PartEncryptor>(Aws::MakeShared<Encryptor>(ALLOCATION_TAG)));
+    }
+
+    PartDecryptorOutcome BeginDownload(const HeadObjectRequest&, const HeadObjectResult& result) override
+    {
+        if (static_cast<size_t>(result.GetContentLength()) < BLOCK_SIZE)
+        {
+            return PartDecryptorOutcome(AWSError<S3Errors>(S3Errors::INTERNAL_FAILURE, "DecryptionFailed", "No trailer.", false));
+        }
+        return PartDecryptorOutcome(std::static_pointer_cast<PartDecryptor>(
+                Aws::MakeShared<Decryptor>(ALLOCATION_TAG, static_cast<uint64_t>(result.GetContentLength()) - BLOCK_SIZE)));
+    }
+
+    std::atomic<size_t> m_uploadCount{0};
+};
+
+class TransferEncryptionTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(TransferEncryptionTest, EncryptedTransfersGoInParallelParts)
+{
+    const size_t partCount = 100;
+    const Aws::String objectData = MakeObjectData(partCount * PART_SIZE + 5);
+    auto encryption = Aws::MakeShared<OffsetXorEncryption>(ALLOCATION_TAG);
+    auto transferManagerConfig = CreateTransferManagerConfiguration();
+    transferManagerConfig.encryption = encryption;
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+
+    // parts that fail are encrypted again when they are retried
+    m_s3Client->SetFailPartsFrom(61);
+    auto uploadStream = Aws::MakeShared<Aws::StringStream>(ALLOCATION_TAG, objectData);
+    auto uploadHandle = transferManager->UploadFile(uploadStream, TEST_BUCKET, TEST_KEY, "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::FAILED, uploadHandle->GetStatus());
+    m_s3Client->SetFailPartsFrom(0);
+    uploadHandle = transferManager->RetryUpload(uploadStream, uploadHandle);
+    uploadHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, uploadHandle->GetStatus());
+    ASSERT_EQ(partCount + 1, uploadHandle->GetCompletedParts().size());
+    ASSERT_EQ(objectData.size(), uploadHandle->GetBytesTransferred());
+    ASSERT_EQ(1u, encryption->m_uploadCount.load());
+    ASSERT_EQ(OffsetXorEncryption::Encrypt(objectData), m_s3Client->GetObjectData(TEST_KEY));
+
+    Aws::Utils::Array<uint8_t> downloadBuffer(objectData.size());
+    CreateDownloadStreamCallback createStream = [&downloadBuffer]()
+    {
+        return Aws::New<Aws::Utils::Stream::DefaultUnderlyingStream>(ALLOCATION_TAG,
+                Aws::MakeUnique<Aws::Utils::Stream::PreallocatedStreamBuf>(ALLOCATION_TAG, &downloadBuffer, downloadBuffer.GetLength()));
+    };
+    auto downloadHandle = transferManager->DownloadFile(TEST_BUCKET, TEST_KEY, createStream);
+    downloadHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, downloadHandle->GetStatus());
+    ASSERT_EQ(partCount + 1, downloadHandle->GetCompletedParts().size());
+    ASSERT_EQ(objectData.size(), downloadHandle->GetBytesTotalSize());
+    ASSERT_EQ(objectData, Aws::String(reinterpret_cast<const char*>(downloadBuffer.GetUnderlyingData()), downloadBuffer.GetLength()));
+
+    // parts handed over as they arrive are decrypted first
+    Aws::String downloadedData(objectData.size(), '\0');
+    auto onPart = [&downloadedData](const std::shared_ptr<const TransferHandle>&, const std::shared_ptr<DownloadedPart>& part)
+    {
+        std::copy(part->GetData(), part->GetData() + part->GetSize(), &downloadedData[static_cast<size_t>(part->GetOffset())]);
+    };
+    downloadHandle = transferManager->DownloadParts(TEST_BUCKET, TEST_KEY, onPart);
+    downloadHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, downloadHandle->GetStatus());
+    ASSERT_EQ(objectData, downloadedData);
+
+    // an object that fits in one part goes in a single PutObject, and still comes back in parts
+    const Aws::String smallData = MakeObjectData(PART_SIZE / 2);
+    auto smallHandle = transferManager->UploadFile(Aws::MakeShared<Aws::StringStream>(ALLOCATION_TAG, smallData), TEST_BUCKET, "small",
+                                                   "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    smallHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, smallHandle->GetStatus());
+    ASSERT_FALSE(smallHandle->IsMultipart());
+    ASSERT_EQ(OffsetXorEncryption::Encrypt(smallData), m_s3Client->GetObjectData("small"));
+
+    Aws::Utils::Array<uint8_t> smallBuffer(smallData.size());
+    smallHandle = transferManager->DownloadFile(TEST_BUCKET, "small", [&smallBuffer]()
+    {
+        return Aws::New<Aws::Utils::Stream::DefaultUnderlyingStream>(ALLOCATION_TAG,
+                Aws::MakeUnique<Aws::Utils::Stream::PreallocatedStreamBuf>(ALLOCATION_TAG, &smallBuffer, smallBuffer.GetLength()));
+    });
+    smallHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, smallHandle->GetStatus());
+    ASSERT_EQ(smallData, Aws::String(reinterpret_cast<const char*>(smallBuffer.GetUnderlyingData()), smallBuffer.GetLength()));
+
+    // bulk directory transfers aren't encrypted, so they refuse to run
+    auto directoryHandle = transferManager->BulkUploadDirectory(Aws::FileSystem::CreateTempFilePath(), TEST_BUCKET, "prefix", Aws::Map<Aws::String, Aws::String>());
+    directoryHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::FAILED, directoryHandle->GetStatus());
+    ASSERT_EQ(2u, encryption->m_uploadCount.load());
+}
+}
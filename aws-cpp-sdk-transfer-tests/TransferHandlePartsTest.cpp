@@ -0,0 +1,117 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/transfer/TransferHandle.h>
+#include <aws/core/utils/Array.h>
+#include <aws/core/utils/stream/PreallocatedStreamBuf.h>
+
+using namespace Aws::Transfer;
+
+namespace
+{
+static const char* ALLOCATION_TAG = "TransferHandlePartsTest";
+
+class TransferHandlePartsTest : public InMemoryTransferTest
+{
+};
+
+TEST(TransferHandlePartsCountTest, CountsFollowPartStates)
+{
+    TransferHandle handle(TEST_BUCKET, TEST_KEY, 3 * PART_SIZE);
+    ASSERT_FALSE(handle.HasParts());
+
+    auto first = Aws::MakeShared<PartState>(ALLOCATION_TAG, 1, 0, PART_SIZE);
+    auto second = Aws::MakeShared<PartState>(ALLOCATION_TAG, 2, 0, PART_SIZE);
+    auto third = Aws::MakeShared<PartState>(ALLOCATION_TAG, 3, 0, PART_SIZE, true);
+    handle.AddQueuedPart(third);
+    handle.AddQueuedPart(first);
+    handle.AddQueuedPart(second);
+    ASSERT_TRUE(handle.HasParts());
+    ASSERT_TRUE(handle.HasQueuedParts());
+
+    handle.AddPendingPart(first);
+    handle.AddPendingPart(second);
+    handle.ChangePartToCompleted(first, "etag1");
+    handle.ChangePartToFailed(second);
+
+    size_t queued = 0, pending = 0, failed = 0, completed = 0;
+    handle.GetPartCountsTransactional(queued, pending, failed, completed);
+    ASSERT_EQ(1u, queued);
+    ASSERT_EQ(0u, pending);
+    ASSERT_EQ(1u, failed);
+    ASSERT_EQ(1u, completed);
+    ASSERT_FALSE(handle.HasPendingParts());
+    ASSERT_TRUE(handle.HasFailedParts());
+
+    // a failed part that is queued again leaves the failed state
+    handle.AddQueuedPart(second);
+    ASSERT_FALSE(handle.HasFailedParts());
+
+    auto queuedParts = handle.GetQueuedParts();
+    ASSERT_EQ(2u, queuedParts.size());
+    ASSERT_EQ(2, queuedParts.begin()->first);
+    ASSERT_EQ(3, queuedParts.rbegin()->first);
+
+    auto completedParts = handle.GetCompletedParts();
+    ASSERT_EQ(1u, completedParts.size());
+    auto firstETag = completedParts[1]->GetETag();
+    ASSERT_STREQ("etag1", firstETag.c_str());
+
+    handle.AddPendingPart(second);
+    handle.AddPendingPart(third);
+    handle.ChangePartToCompleted(second, "etag2");
+    handle.ChangePartToCompleted(third, "etag3");
+
+    PartStateMap queuedMap, pendingMap, failedMap, completedMap;
+    handle.GetAllPartsTransactional(queuedMap, pendingMap, failedMap, completedMap);
+    ASSERT_TRUE(queuedMap.empty());
+    ASSERT_TRUE(pendingMap.empty());
+    ASSERT_TRUE(failedMap.empty());
+    ASSERT_EQ(3u, completedMap.size());
+    ASSERT_FALSE(handle.HasQueuedParts());
+}
+
+TEST_F(TransferHandlePartsTest, TenThousandPartUploadAndDownload)
+{
+    const Aws::String objectData = MakeObjectData();
+    auto transferManager = CreateTransferManager();
+
+    auto uploadStream = Aws::MakeShared<Aws::StringStream>(ALLOCATION_TAG, objectData);
+    auto uploadHandle = transferManager->UploadFile(uploadStream, TEST_BUCKET, TEST_KEY, "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+
+    ASSERT_EQ(TransferStatus::COMPLETED, uploadHandle->GetStatus());
+    ASSERT_EQ(PART_COUNT, uploadHandle->GetCompletedParts().size());
+    ASSERT_EQ(PART_COUNT, m_s3Client->GetCompletedPartCount());
+    ASSERT_EQ(objectData, m_s3Client->GetObjectData(TEST_KEY));
+
+    Aws::Utils::Array<uint8_t> downloadBuffer(objectData.size());
+    CreateDownloadStreamCallback createStream = [&downloadBuffer]()
+    {
+        return Aws::New<Aws::Utils::Stream::DefaultUnderlyingStream>(ALLOCATION_TAG,
+                Aws::MakeUnique<Aws::Utils::Stream::PreallocatedStreamBuf>(ALLOCATION_TAG, &downloadBuffer, downloadBuffer.GetLength()));
+    };
+
+    auto downloadHandle = transferManager->DownloadFile(TEST_BUCKET, TEST_KEY, createStream);
+    downloadHandle->WaitUntilFinished();
+
+    ASSERT_EQ(TransferStatus::COMPLETED, downloadHandle->GetStatus());
+    ASSERT_EQ(PART_COUNT, downloadHandle->GetCompletedParts().size());
+    ASSERT_EQ(objectData, Aws::String(reinterpret_cast<const char*>(downloadBuffer.GetUnderlyingData()), downloadBuffer.GetLength()));
+}
+}
@@ -0,0 +1,162 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/transfer/TransferJournal.h>
+#include <aws/core/platform/FileSystem.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+
+#include <fstream>
+
+using namespace Aws::Transfer;
+
+namespace
+{
+static const char* ALLOCATION_TAG = "TransferJournalTest";
+
+class TransferJournalTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(TransferJournalTest, UploadResumesFromJournal)
+{
+    const size_t partCount = 100;
+    const Aws::String objectData = MakeObjectData(partCount * PART_SIZE - 10);
+    const Aws::String fileName = Aws::FileSystem::CreateTempFilePath();
+    const Aws::String journalDirectory = fileName + "-journals";
+    Aws::FileSystem::CreateDirectoryIfNotExists(journalDirectory.c_str());
+    {
+        Aws::OFStream file(fileName.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        file.write(objectData.data(), static_cast<std::streamsize>(objectData.size()));
+    }
+    const Aws::String journalPath = TransferJournal::GetJournalPath(journalDirectory, TransferDirection::UPLOAD, TEST_BUCKET, TEST_KEY, fileName);
+
+    auto transferManagerConfig = CreateTransferManagerConfiguration();
+    transferManagerConfig.journalDirectory = journalDirectory;
+    transferManagerConfig.uploadReadThreads = 1;
+
+    // the first run gets 60 parts out before it fails
+    m_s3Client->SetFailPartsFrom(61);
+    {
+        auto transferManager = TransferManager::Create(transferManagerConfig);
+        auto uploadHandle = transferManager->UploadFile(fileName, TEST_BUCKET, TEST_KEY, "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+        uploadHandle->WaitUntilFinished();
+        ASSERT_EQ(TransferStatus::FAILED, uploadHandle->GetStatus());
+    }
+    ASSERT_TRUE(Aws::IFStream(journalPath.c_str()).good());
+
+    // a new TransferManager, as after a restart, only sends the rest
+    m_s3Client->SetFailPartsFrom(0);
+    size_t partsBefore = m_s3Client->GetTransferredPartCount();
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+    auto uploadHandle = transferManager->UploadFile(fileName, TEST_BUCKET, TEST_KEY, "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+
+    ASSERT_EQ(TransferStatus::COMPLETED, uploadHandle->GetStatus());
+    ASSERT_EQ(40u, m_s3Client->GetTransferredPartCount() - partsBefore);
+    ASSERT_EQ(1u, m_s3Client->GetCreateMultipartUploadCount());
+    ASSERT_EQ(partCount, uploadHandle->GetCompletedParts().size());
+    ASSERT_EQ(objectData, m_s3Client->GetObjectData(TEST_KEY));
+    ASSERT_FALSE(Aws::IFStream(journalPath.c_str()).good());
+
+    Aws::FileSystem::RemoveFileIfExists(fileName.c_str());
+    Aws::FileSystem::DeepDeleteDirectory(journalDirectory.c_str());
+}
+
+TEST_F(TransferJournalTest, DownloadResumesFromJournal)
+{
+    const size_t partCount = 100;
+    const Aws::String objectData = MakeObjectData(partCount * PART_SIZE - 10);
+    const Aws::String fileName = Aws::FileSystem::CreateTempFilePath();
+    const Aws::String journalDirectory = fileName + "-journals";
+    Aws::FileSystem::CreateDirectoryIfNotExists(journalDirectory.c_str());
+    m_s3Client->PutObjectData(TEST_KEY, objectData);
+    const Aws::String journalPath = TransferJournal::GetJournalPath(journalDirectory, TransferDirection::DOWNLOAD, TEST_BUCKET, TEST_KEY, fileName);
+
+    auto transferManagerConfig = CreateTransferManagerConfiguration();
+    transferManagerConfig.journalDirectory = journalDirectory;
+
+    m_s3Client->SetFailPartsFrom(71);
+    {
+        auto transferManager = TransferManager::Create(transferManagerConfig);
+        auto downloadHandle = transferManager->DownloadFile(TEST_BUCKET, TEST_KEY, fileName);
+        downloadHandle->WaitUntilFinished();
+        ASSERT_EQ(TransferStatus::FAILED, downloadHandle->GetStatus());
+    }
+    ASSERT_TRUE(Aws::IFStream(journalPath.c_str()).good());
+
+    m_s3Client->SetFailPartsFrom(0);
+    size_t partsBefore = m_s3Client->GetTransferredPartCount();
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+    auto downloadHandle = transferManager->DownloadFile(TEST_BUCKET, TEST_KEY, fileName);
+    downloadHandle->WaitUntilFinished();
+
+    ASSERT_EQ(TransferStatus::COMPLETED, downloadHandle->GetStatus());
+    ASSERT_EQ(30u, m_s3Client->GetTransferredPartCount() - partsBefore);
+    ASSERT_FALSE(Aws::IFStream(journalPath.c_str()).good());
+    // the handle owns the file until it goes away
+    downloadHandle = nullptr;
+    {
+        Aws::IFStream file(fileName.c_str(), std::ios_base::in | std::ios_base::binary);
+        Aws::StringStream contents;
+        contents << file.rdbuf();
+        ASSERT_EQ(objectData, contents.str());
+    }
+
+    Aws::FileSystem::RemoveFileIfExists(fileName.c_str());
+    Aws::FileSystem::DeepDeleteDirectory(journalDirectory.c_str());
+}
+
+TEST_F(TransferJournalTest, DownloadWithJournalTruncatesALargerFile)
+{
+    // a single part object, downloaded over a file that holds more than it, and a journal left by an earlier multi-part download
+    const Aws::String objectData = MakeObjectData(PART_SIZE / 2);
+    const Aws::String fileName = Aws::FileSystem::CreateTempFilePath();
+    const Aws::String journalDirectory = fileName + "-journals";
+    Aws::FileSystem::CreateDirectoryIfNotExists(journalDirectory.c_str());
+    m_s3Client->PutObjectData(TEST_KEY, objectData);
+    {
+        Aws::OFStream file(fileName.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        Aws::String oldData(10 * PART_SIZE, 'x');
+        file.write(oldData.data(), static_cast<std::streamsize>(oldData.size()));
+    }
+    const Aws::String journalPath = TransferJournal::GetJournalPath(journalDirectory, TransferDirection::DOWNLOAD, TEST_BUCKET, TEST_KEY, fileName);
+    {
+        Aws::OFStream journal(journalPath.c_str(), std::ios_base::out | std::ios_base::trunc);
+        journal << "stale\n";
+    }
+
+    auto transferManagerConfig = CreateTransferManagerConfiguration();
+    transferManagerConfig.journalDirectory = journalDirectory;
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+    auto downloadHandle = transferManager->DownloadFile(TEST_BUCKET, TEST_KEY, fileName);
+    downloadHandle->WaitUntilFinished();
+
+    ASSERT_EQ(TransferStatus::COMPLETED, downloadHandle->GetStatus());
+    ASSERT_FALSE(Aws::IFStream(journalPath.c_str()).good());
+    downloadHandle = nullptr;
+    {
+        Aws::IFStream file(fileName.c_str(), std::ios_base::in | std::ios_base::binary);
+        Aws::StringStream contents;
+        contents << file.rdbuf();
+        ASSERT_EQ(objectData, contents.str());
+    }
+
+    Aws::FileSystem::RemoveFileIfExists(fileName.c_str());
+    Aws::FileSystem::DeepDeleteDirectory(journalDirectory.c_str());
+}
+}
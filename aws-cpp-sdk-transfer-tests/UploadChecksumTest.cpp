@@ -0,0 +1,82 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include "InMemoryTransferTest.h"
+
+#include <aws/external/gtest.h>
+#include <aws/core/platform/FileSystem.h>
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+
+#include <fstream>
+
+using namespace Aws::Transfer;
+using namespace Aws::Utils;
+
+namespace
+{
+static const char* ALLOCATION_TAG = "UploadChecksumTest";
+
+class UploadChecksumTest : public InMemoryTransferTest
+{
+};
+
+TEST_F(UploadChecksumTest, UploadChecksPartMD5sAndObjectETag)
+{
+    const size_t partCount = 100;
+    const Aws::String objectData = MakeObjectData(partCount * PART_SIZE);
+    const Aws::String fileName = Aws::FileSystem::CreateTempFilePath();
+    {
+        Aws::OFStream file(fileName.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        file.write(objectData.data(), static_cast<std::streamsize>(objectData.size()));
+    }
+
+    auto transferManagerConfig = CreateTransferManagerConfiguration();
+    transferManagerConfig.computeContentMD5 = true;
+    auto transferManager = TransferManager::Create(transferManagerConfig);
+
+    auto uploadHandle = transferManager->UploadFile(fileName, TEST_BUCKET, TEST_KEY, "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, uploadHandle->GetStatus());
+    ASSERT_EQ(objectData, m_s3Client->GetObjectData(TEST_KEY));
+    auto expectedETag = uploadHandle->GetExpectedETag();
+    ASSERT_EQ('"', expectedETag.front());
+    ASSERT_NE(Aws::String::npos, expectedETag.find("-100\""));
+    for (const auto& part : uploadHandle->GetCompletedParts())
+    {
+        ASSERT_EQ(HashingUtils::Base64Encode(HashingUtils::CalculateMD5(objectData.substr((part.first - 1) * PART_SIZE, PART_SIZE))),
+                  part.second->GetContentMD5());
+    }
+
+    // a part that goes bad after S3 took it changes the object's ETag
+    m_s3Client->SetCorruptPart(42);
+    uploadHandle = transferManager->UploadFile(fileName, TEST_BUCKET, TEST_KEY, "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    uploadHandle->WaitUntilFinished();
+    m_s3Client->SetCorruptPart(0);
+    ASSERT_EQ(TransferStatus::FAILED, uploadHandle->GetStatus());
+    ASSERT_EQ("ETagMismatch", uploadHandle->GetLastError().GetExceptionName());
+
+    // a single PutObject is checked the same way
+    const Aws::String smallData = MakeObjectData(PART_SIZE / 2);
+    auto smallHandle = transferManager->UploadFile(Aws::MakeShared<Aws::StringStream>(ALLOCATION_TAG, smallData), TEST_BUCKET, "small",
+                                                   "binary/octet-stream", Aws::Map<Aws::String, Aws::String>());
+    smallHandle->WaitUntilFinished();
+    ASSERT_EQ(TransferStatus::COMPLETED, smallHandle->GetStatus());
+    ASSERT_EQ("\"" + HashingUtils::HexEncode(HashingUtils::CalculateMD5(smallData)) + "\"", smallHandle->GetExpectedETag());
+    ASSERT_EQ(smallData, m_s3Client->GetObjectData("small"));
+
+    Aws::FileSystem::RemoveFileIfExists(fileName.c_str());
+}
+}
@@ -0,0 +1,141 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <aws/transfer/Transfer_EXPORTS.h>
+#include <aws/transfer/TransferHandle.h>
+#include <aws/core/utils/memory/stl/AWSString.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        /**
+         * Tracks a whole directory transfer started with TransferManager::BulkUploadDirectory or TransferManager::BulkDownloadToDirectory.
+         * There is no TransferHandle per object in these transfers; this handle counts the objects and bytes transferred so far, and
+         * keeps the keys of the objects that failed so that they can be transferred again.
+         *
+         * The methods for starting and completing requests are for TransferManager's use. It is thread safe.
+         */
+        class AWS_TRANSFER_API DirectoryTransferHandle
+        {
+        public:
+            DirectoryTransferHandle(TransferDirection direction, const Aws::String& directory, const Aws::String& bucketName, const Aws::String& prefix);
+
+            DirectoryTransferHandle(const DirectoryTransferHandle&) = delete;
+            DirectoryTransferHandle& operator=(const DirectoryTransferHandle&) = delete;
+
+            inline TransferDirection GetTransferDirection() const { return m_direction; }
+            inline const Aws::String& GetDirectory() const { return m_directory; }
+            inline const Aws::String& GetBucketName() const { return m_bucketName; }
+            inline const Aws::String& GetPrefix() const { return m_prefix; }
+
+            /**
+             * Objects transferred successfully so far.
+             */
+            inline size_t GetObjectsTransferred() const { return m_objectsTransferred.load(); }
+            /**
+             * Objects that failed so far. See GetFailedKeys.
+             */
+            inline size_t GetObjectsFailed() const { return m_objectsFailed.load(); }
+            /**
+             * Bytes of the objects transferred successfully so far.
+             */
+            inline uint64_t GetBytesTransferred() const { return m_bytesTransferred.load(); }
+            /**
+             * Keys of the objects that failed, in the order they failed.
+             */
+            Aws::Vector<Aws::String> GetFailedKeys() const;
+            /**
+             * The error of the last failure, if any.
+             */
+            Aws::Client::AWSError<Aws::S3::S3Errors> GetLastError() const;
+
+            /**
+             * IN_PROGRESS until the directory or listing is exhausted and the last request has finished. Then COMPLETED if every object was
+             * transferred, CANCELED if Cancel() was called and FAILED otherwise.
+             */
+            TransferStatus GetStatus() const;
+
+            /**
+             * Stops starting requests and cancels the ones in flight.
+             */
+            void Cancel();
+            bool ShouldContinue() const;
+
+            /**
+             * Blocks until the status is no longer IN_PROGRESS and the final progress callback has returned.
+             */
+            void WaitUntilFinished() const;
+
+            /**
+             * Blocks until fewer than maxInFlight requests are in flight and takes a slot for another one. Returns false, without taking a slot,
+             * if the transfer was canceled.
+             */
+            bool AcquireRequestSlot(size_t maxInFlight);
+
+            /**
+             * Releases the slot of a finished request and counts its object. Returns true if this finished the transfer.
+             */
+            bool CompleteRequest(const Aws::String& key, uint64_t bytes, bool succeeded, const Aws::Client::AWSError<Aws::S3::S3Errors>& error = Aws::Client::AWSError<Aws::S3::S3Errors>());
+
+            /**
+             * Records that no more requests will be started, because the directory or listing was exhausted, failed or the transfer was canceled.
+             * Returns true if this finished the transfer.
+             */
+            bool FinishListing(bool succeeded, const Aws::Client::AWSError<Aws::S3::S3Errors>& error = Aws::Client::AWSError<Aws::S3::S3Errors>());
+
+            /**
+             * Returns true, at most once per interval, when progress should be reported.
+             */
+            bool IsProgressReportDue(std::chrono::milliseconds interval);
+
+            /**
+             * Releases WaitUntilFinished once the transfer has finished and its final progress has been reported.
+             */
+            void NotifyFinished();
+
+        private:
+            bool FinishIfDone();
+
+            const TransferDirection m_direction;
+            const Aws::String m_directory;
+            const Aws::String m_bucketName;
+            const Aws::String m_prefix;
+
+            std::atomic<size_t> m_objectsTransferred;
+            std::atomic<size_t> m_objectsFailed;
+            std::atomic<uint64_t> m_bytesTransferred;
+            std::atomic<bool> m_cancel;
+
+            mutable std::mutex m_lock;
+            mutable std::condition_variable m_signal;
+            size_t m_requestsInFlight;
+            bool m_listingFinished;
+            bool m_listingFailed;
+            TransferStatus m_status;
+            bool m_finishNotified;
+            Aws::Vector<Aws::String> m_failedKeys;
+            Aws::Client::AWSError<Aws::S3::S3Errors> m_lastError;
+            std::chrono::steady_clock::time_point m_lastProgressReport;
+        };
+    }
+}
@@ -0,0 +1,76 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <aws/transfer/Transfer_EXPORTS.h>
+#include <aws/core/utils/Array.h>
+#include <memory>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        class TransferManager;
+
+        /**
+         * A completed part of a download started with TransferManager::DownloadParts: the bytes of the object from GetOffset() to
+         * GetOffset() + GetSize(), in the buffer the part was downloaded into. The buffer belongs to TransferManager's buffer pool, and goes
+         * back to it when the last reference to the part is dropped or Release() is called. Until then, the buffer counts against the pool
+         * like a part in flight, so a consumer that holds on to parts slows the download down, and one that holds on to as many parts as the
+         * pool has buffers stops it.
+         *
+         * Created by TransferManager. Not thread safe; hand a part over to one thread at a time.
+         */
+        class AWS_TRANSFER_API DownloadedPart
+        {
+        public:
+            DownloadedPart(const std::shared_ptr<TransferManager>& transferManager, Aws::Utils::Array<uint8_t>* buffer, uint64_t offset, size_t size, int partNumber);
+            ~DownloadedPart();
+
+            DownloadedPart(const DownloadedPart&) = delete;
+            DownloadedPart& operator=(const DownloadedPart&) = delete;
+
+            /**
+             * Where the part starts in the object.
+             */
+            inline uint64_t GetOffset() const { return m_offset; }
+            /**
+             * The number of bytes in the part.
+             */
+            inline size_t GetSize() const { return m_size; }
+            /**
+             * The part number, counting from 1.
+             */
+            inline int GetPartNumber() const { return m_partNumber; }
+            /**
+             * The bytes of the part, or nullptr once the part has been released.
+             */
+            inline const uint8_t* GetData() const { return m_buffer ? m_buffer->GetUnderlyingData() : nullptr; }
+
+            /**
+             * Returns the buffer to TransferManager before the part itself goes away. GetData() returns nullptr afterwards.
+             */
+            void Release();
+
+        private:
+            std::shared_ptr<TransferManager> m_transferManager;
+            Aws::Utils::Array<uint8_t>* m_buffer;
+            uint64_t m_offset;
+            size_t m_size;
+            int m_partNumber;
+        };
+    }
+}
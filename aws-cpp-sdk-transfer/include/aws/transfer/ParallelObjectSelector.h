@@ -0,0 +1,120 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <aws/transfer/Transfer_EXPORTS.h>
+#include <aws/core/client/AWSError.h>
+#include <aws/core/utils/Outcome.h>
+#include <aws/s3/S3Errors.h>
+#include <aws/s3/model/Progress.h>
+#include <aws/s3/model/SelectObjectContentRequest.h>
+#include <aws/s3/model/Stats.h>
+
+#include <functional>
+#include <memory>
+
+namespace Aws
+{
+    namespace S3
+    {
+        class S3Client;
+    }
+
+    namespace Transfer
+    {
+        /**
+         * The totals of the Stats events of all the scan ranges.
+         */
+        typedef Aws::Utils::Outcome<Aws::S3::Model::Stats, Aws::Client::AWSError<Aws::S3::S3Errors>> ParallelSelectOutcome;
+
+        /**
+         * The order the records of the scan ranges are handed over in.
+         */
+        enum class SelectRecordsOrder
+        {
+            /**
+             * As a single select would return them: the records of each range follow those of the ranges before it. The records of a range
+             * are held in memory until the ranges before it are done.
+             */
+            OBJECT_ORDER,
+            /**
+             * As they arrive, from whichever range, whole records at a time: only the start of a record whose end has not arrived yet is held.
+             */
+            ARRIVAL_ORDER
+        };
+
+        struct AWS_TRANSFER_API ParallelObjectSelectorConfiguration
+        {
+            ParallelObjectSelectorConfiguration() :
+                scanRangeSize(64 * 1024 * 1024), maxConcurrentRanges(16), recordsOrder(SelectRecordsOrder::OBJECT_ORDER)
+            {
+            }
+
+            /**
+             * S3 Client to select with. You are responsible for setting this. Ranges are selected with SelectObjectContentAsync, so they run on
+             * the client's executor over its connection pool; both should allow maxConcurrentRanges at once.
+             */
+            std::shared_ptr<Aws::S3::S3Client> s3Client;
+            /**
+             * Bytes of the object each SelectObjectContent scans. Defaults to 64MB.
+             */
+            uint64_t scanRangeSize;
+            /**
+             * Most ranges selected at once. Defaults to 16.
+             */
+            size_t maxConcurrentRanges;
+            /**
+             * Defaults to OBJECT_ORDER.
+             */
+            SelectRecordsOrder recordsOrder;
+        };
+
+        /**
+         * Runs an S3 Select query over a large object as concurrent SelectObjectContents, each over its own scan range of the object, and
+         * merges their events as if they came from one.
+         *
+         * S3 Select hands a record to the range its first byte falls in, so the ranges return every record once. Scan ranges work for
+         * uncompressed CSV, JSON lines and Parquet objects; compressed objects are selected whole, with a single SelectObjectContent.
+         *
+         * A selector holds no state between calls, and several threads may Select through one at once.
+         */
+        class AWS_TRANSFER_API ParallelObjectSelector
+        {
+        public:
+            /**
+             * Records returned by the query, in the order the configuration asks for. Calls are never concurrent.
+             */
+            typedef std::function<void(const unsigned char* records, size_t length)> RecordsCallback;
+            /**
+             * The totals of the latest Progress events of all the ranges, called whenever a range reports progress. Calls are never concurrent.
+             */
+            typedef std::function<void(const Aws::S3::Model::Progress& progress)> ProgressCallback;
+
+            ParallelObjectSelector(const ParallelObjectSelectorConfiguration& configuration);
+
+            /**
+             * Runs the query of request over its object, blocking until every range is done or one of them fails. The bucket, key, expression,
+             * serializations, customer encryption key and request progress are taken from request; its scan range and event stream handler
+             * are not used. On failure, the ranges still running are cancelled, and some records may have been handed over already.
+             */
+            ParallelSelectOutcome Select(const Aws::S3::Model::SelectObjectContentRequest& request, const RecordsCallback& onRecords,
+                const ProgressCallback& onProgress = nullptr) const;
+
+        private:
+            ParallelObjectSelectorConfiguration m_configuration;
+        };
+    }
+}
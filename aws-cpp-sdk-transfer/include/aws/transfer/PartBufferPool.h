@@ -0,0 +1,112 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <aws/transfer/Transfer_EXPORTS.h>
+#include <aws/core/utils/Array.h>
+#include <aws/core/utils/memory/AWSMemory.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        /**
+         * Supplies the buffers TransferManager reads, sends and receives parts in. Set one in TransferManagerConfiguration::bufferPool to choose
+         * where that memory comes from. TransferManager still decides how many parts are in flight, and so how many buffers are out at once.
+         * Acquire and Release are called concurrently, from the transfer executor and from the client's threads.
+         */
+        class AWS_TRANSFER_API PartBufferPool
+        {
+        public:
+            virtual ~PartBufferPool() = default;
+
+            /**
+             * Returns a buffer whose GetLength() is bufferSize. It stays with the caller until it is passed to Release.
+             */
+            virtual Aws::Utils::Array<uint8_t>* Acquire(size_t bufferSize) = 0;
+
+            /**
+             * Takes back a buffer returned by Acquire, possibly on another thread.
+             */
+            virtual void Release(Aws::Utils::Array<uint8_t>* buffer) = 0;
+        };
+
+        /**
+         * A PartBufferPool for large parts on large machines.
+         *
+         * Buffers of at least a huge page (2MB) are mapped on their own, from explicit huge pages where the system has some reserved
+         * (MAP_HUGETLB), and otherwise from ordinary pages marked for transparent huge pages (MADV_HUGEPAGE), so that copying and encrypting
+         * a part walks few TLB entries. Smaller buffers, and all buffers on systems other than Linux, come from the heap.
+         *
+         * Buffers are allocated the first time they are needed rather than up front, on the NUMA node of the thread that asks for them:
+         * the pages are touched by that thread, and the kernel places them on its node. Released buffers go back to the free list of their
+         * node, and a thread reuses buffers from its own node's list. Each node keeps up to maxIdleBytesPerNode of idle buffers; buffers
+         * released beyond that are freed.
+         */
+        class AWS_TRANSFER_API HugePagePartBufferPool : public PartBufferPool
+        {
+        public:
+            HugePagePartBufferPool(uint64_t maxIdleBytesPerNode = 256 * 1024 * 1024);
+            ~HugePagePartBufferPool();
+
+            HugePagePartBufferPool(const HugePagePartBufferPool&) = delete;
+            HugePagePartBufferPool& operator=(const HugePagePartBufferPool&) = delete;
+
+            Aws::Utils::Array<uint8_t>* Acquire(size_t bufferSize) override;
+            void Release(Aws::Utils::Array<uint8_t>* buffer) override;
+
+            /**
+             * The number of NUMA nodes free lists are kept for; 1 where the system doesn't tell.
+             */
+            inline size_t GetNodeCount() const { return m_nodeCount; }
+
+            /**
+             * The number of buffers currently allocated, idle or not.
+             */
+            inline size_t GetAllocatedBufferCount() const { return m_allocatedBuffers.load(); }
+
+            /**
+             * The number of buffers currently allocated that are mapped on their own, whether from explicit or transparent huge pages.
+             */
+            inline size_t GetMappedBufferCount() const { return m_mappedBuffers.load(); }
+
+        private:
+            struct NodeFreeList
+            {
+                NodeFreeList() : idleBytes(0) {}
+
+                std::mutex lock;
+                Aws::Map<size_t, Aws::Vector<Aws::Utils::Array<uint8_t>*>> idleBuffers;
+                uint64_t idleBytes;
+            };
+
+            size_t GetCurrentNode() const;
+            Aws::Utils::Array<uint8_t>* Allocate(size_t bufferSize, size_t node);
+            void Free(Aws::Utils::Array<uint8_t>* buffer);
+
+            const uint64_t m_maxIdleBytesPerNode;
+            size_t m_nodeCount;
+            Aws::UniqueArrayPtr<NodeFreeList> m_nodes;
+            std::atomic<size_t> m_allocatedBuffers;
+            std::atomic<size_t> m_mappedBuffers;
+        };
+    }
+}
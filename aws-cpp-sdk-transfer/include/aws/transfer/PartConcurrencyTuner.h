@@ -0,0 +1,115 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <aws/transfer/Transfer_EXPORTS.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        /**
+         * Decides how many parts TransferManager keeps in flight when auto tuning is enabled, and how large those parts are.
+         *
+         * The limit starts at minInFlightParts and doubles with every round of completed parts for as long as the measured throughput keeps growing.
+         * Once it stops growing, the limit is set from the bandwidth-delay product: the best recent throughput times the shortest recent part
+         * transfer time, divided by the part size, plus some headroom. Every few rounds the limit is raised briefly to find out whether the link has
+         * more to give, and now and then it is lowered for two rounds so that parts run without queueing and the shortest transfer time stays honest.
+         * Failed parts (usually throttling) shrink the limit. The limit never exceeds maxInFlightParts, and the parts in flight never
+         * take more than memoryBudget bytes, except that a single part is always let through. A memoryBudget of 0 leaves the bytes in flight
+         * bounded only by maxInFlightParts parts.
+         *
+         * One tuner is shared by all the transfers of a TransferManager, since they share the link; the limit applies to their parts together.
+         */
+        class AWS_TRANSFER_API PartConcurrencyTuner
+        {
+        public:
+            PartConcurrencyTuner(size_t minInFlightParts, size_t maxInFlightParts, uint64_t memoryBudget);
+
+            PartConcurrencyTuner(const PartConcurrencyTuner&) = delete;
+            PartConcurrencyTuner& operator=(const PartConcurrencyTuner&) = delete;
+
+            /**
+             * Blocks until a part of partSize bytes fits under the in-flight limit and the memory budget.
+             */
+            void AcquirePart(uint64_t partSize);
+
+            /**
+             * Returns the slot taken by AcquirePart. Call RecordPart first if the part was actually transferred.
+             */
+            void ReleasePart(uint64_t partSize);
+
+            /**
+             * Feeds the outcome of a transferred part into the limit. elapsed is the time from sending the request to receiving the response.
+             */
+            void RecordPart(uint64_t partSize, std::chrono::steady_clock::duration elapsed, bool succeeded,
+                            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+            /**
+             * The number of parts that may currently be in flight.
+             */
+            size_t GetInFlightLimit() const;
+
+            /**
+             * Picks the part size for an object: the smallest multiple of minPartSize that splits the object into at most maxPartCount parts.
+             * The result is capped at 5GB, the largest part S3 accepts.
+             */
+            static uint64_t ComputePartSize(uint64_t objectSize, uint64_t minPartSize, size_t maxPartCount);
+
+        private:
+            static const size_t THROUGHPUT_FILTER_LENGTH = 10;
+            static const size_t PART_SECONDS_FILTER_LENGTH = 40;
+
+            void EndRound(std::chrono::steady_clock::time_point now);
+            size_t ClampLimit(double limit) const;
+
+            const size_t m_minInFlightParts;
+            const size_t m_maxInFlightParts;
+            const uint64_t m_memoryBudget;
+
+            mutable std::mutex m_lock;
+            std::condition_variable m_partReleased;
+            size_t m_inFlightLimit;
+            size_t m_partsInFlight;
+            uint64_t m_bytesInFlight;
+
+            /// Growing the limit exponentially until throughput stops following
+            bool m_startup;
+            size_t m_roundsWithoutGrowth;
+            size_t m_roundsSinceProbe;
+            size_t m_roundsSinceDrain;
+            size_t m_drainRoundsLeft;
+
+            /// The current round ends once as many parts have completed as were allowed in flight when it started
+            std::chrono::steady_clock::time_point m_roundStart;
+            size_t m_roundTarget;
+            size_t m_roundParts;
+            uint64_t m_roundBytes;
+            double m_roundMinSeconds;
+
+            /// Windowed max of the per-round throughput and windowed min of the part transfer time, in bytes per second and seconds
+            double m_throughputs[THROUGHPUT_FILTER_LENGTH];
+            double m_partSeconds[PART_SECONDS_FILTER_LENGTH];
+            size_t m_rounds;
+            double m_bestThroughput;
+            double m_averagePartSize;
+        };
+    }
+}
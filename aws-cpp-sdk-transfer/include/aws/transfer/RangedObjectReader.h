@@ -0,0 +1,117 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <aws/transfer/Transfer_EXPORTS.h>
+#include <aws/core/NoResult.h>
+#include <aws/core/client/AWSError.h>
+#include <aws/core/utils/Outcome.h>
+#include <aws/core/utils/memory/stl/AWSString.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
+#include <aws/s3/S3Errors.h>
+#include <aws/s3/model/GetObjectRequest.h>
+
+#include <memory>
+
+namespace Aws
+{
+    namespace S3
+    {
+        class S3Client;
+    }
+
+    namespace Transfer
+    {
+        /**
+         * A byte range of an object to read, and where to put it: length bytes from offset go to buffer, which must hold them.
+         */
+        struct RangeRead
+        {
+            RangeRead() : offset(0), length(0), buffer(nullptr) {}
+            RangeRead(uint64_t rangeOffset, uint64_t rangeLength, uint8_t* rangeBuffer) : offset(rangeOffset), length(rangeLength), buffer(rangeBuffer) {}
+
+            uint64_t offset;
+            uint64_t length;
+            uint8_t* buffer;
+        };
+
+        typedef Aws::Utils::Outcome<Aws::NoResult, Aws::Client::AWSError<Aws::S3::S3Errors>> RangedReadOutcome;
+
+        struct AWS_TRANSFER_API RangedObjectReaderConfiguration
+        {
+            RangedObjectReaderConfiguration() :
+                subRangeSize(8 * 1024 * 1024), maxInFlightRequests(16), coalesceGap(512 * 1024)
+            {
+            }
+
+            /**
+             * S3 Client to read with. You are responsible for setting this. Requests are sent with GetObjectAsync, so they run on the client's
+             * executor over its connection pool; both should allow maxInFlightRequests at once.
+             */
+            std::shared_ptr<Aws::S3::S3Client> s3Client;
+            /**
+             * If you have special arguments you want passed to the GetObject calls, such as customer encryption keys or an IfMatch ETag, put them
+             * here. The template is copied for each call, overriding the bucket, key, range and response stream.
+             */
+            Aws::S3::Model::GetObjectRequest getObjectTemplate;
+            /**
+             * Largest range fetched by a single GetObject. Longer ranges are split evenly into as few GetObjects as keep each within it, which
+             * are fetched concurrently. Defaults to 8MB.
+             */
+            uint64_t subRangeSize;
+            /**
+             * Most GetObjects in flight at once for a single Read call. Defaults to 16.
+             */
+            size_t maxInFlightRequests;
+            /**
+             * Ranges with at most this many bytes between them are fetched together, and the bytes in between are read and dropped; a request
+             * costs about as much time as this many bytes take to arrive. 0 merges only ranges that touch or overlap. Defaults to 512KB.
+             */
+            uint64_t coalesceGap;
+        };
+
+        /**
+         * Reads byte ranges of a single object into caller buffers with concurrent GetObjects, for readers such as columnar file scanners that
+         * want specific ranges of large objects rather than whole objects.
+         *
+         * Each Read call sorts its ranges, merges those that are close together (see coalesceGap), splits the merged ranges into pieces of up
+         * to subRangeSize, and fetches the pieces concurrently. Response bodies are written straight into the caller buffers as they arrive,
+         * with the bytes between ranges dropped; nothing is buffered on the way. All responses must carry the same ETag, so a Read never
+         * mixes two versions of an object.
+         *
+         * A reader holds no state between calls, and several threads may Read through one at once.
+         */
+        class AWS_TRANSFER_API RangedObjectReader
+        {
+        public:
+            RangedObjectReader(const RangedObjectReaderConfiguration& configuration);
+
+            /**
+             * Fills the buffers of ranges from the object, blocking until all of them are read or one of the GetObjects fails. On failure the
+             * buffers may be partly written. Ranges may overlap, and need not be sorted.
+             */
+            RangedReadOutcome Read(const Aws::String& bucketName, const Aws::String& keyName, const Aws::Vector<RangeRead>& ranges) const;
+
+            /**
+             * Reads length bytes from offset into buffer; Read with a single range.
+             */
+            RangedReadOutcome Read(const Aws::String& bucketName, const Aws::String& keyName, uint64_t offset, uint64_t length, uint8_t* buffer) const;
+
+        private:
+            RangedObjectReaderConfiguration m_configuration;
+        };
+    }
+}
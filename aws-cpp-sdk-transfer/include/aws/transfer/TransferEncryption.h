@@ -0,0 +1,118 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <aws/transfer/Transfer_EXPORTS.h>
+#include <aws/core/utils/Outcome.h>
+#include <aws/core/client/AWSError.h>
+#include <aws/s3/S3Errors.h>
+#include <aws/s3/model/PutObjectRequest.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
+#include <aws/s3/model/HeadObjectRequest.h>
+#include <aws/s3/model/HeadObjectResult.h>
+
+#include <memory>
+#include <utility>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        /**
+         * Encrypts the parts of one upload, in place, in the buffers TransferManager read them into. Created by TransferEncryption::BeginUpload.
+         */
+        class AWS_TRANSFER_API PartEncryptor
+        {
+        public:
+            virtual ~PartEncryptor() = default;
+
+            /**
+             * Encrypts the length bytes of part partNumber at buffer, in place, and returns the length of the ciphertext, or 0 on failure.
+             * Parts other than the last must be a multiple of TransferEncryption::GetBlockSize() long; their ciphertext is as long as they are.
+             * The last part comes out up to TransferEncryption::GetMaxPartOverhead() bytes longer, which capacity must leave room for.
+             * The first time through, parts must come in order, starting with part 1. A part already encrypted may be encrypted again, say
+             * to send it again after a failure, and comes out the same.
+             */
+            virtual size_t EncryptPart(int partNumber, unsigned char* buffer, size_t length, size_t capacity, bool lastPart) = 0;
+        };
+
+        /**
+         * Decrypts the parts of one download, each on its own, in the buffers TransferManager downloaded their ciphertext into.
+         * Created by TransferEncryption::BeginDownload. Thread safe: parts are decrypted on whichever threads their responses arrive on.
+         */
+        class AWS_TRANSFER_API PartDecryptor
+        {
+        public:
+            virtual ~PartDecryptor() = default;
+
+            /**
+             * The length of the object once decrypted, which is what the download splits into parts.
+             */
+            virtual uint64_t GetPlaintextLength() const = 0;
+
+            /**
+             * The first and last bytes of the object to fetch to decrypt the length bytes of plain text starting at offset, a multiple of
+             * TransferEncryption::GetBlockSize(). The range is up to TransferEncryption::GetMaxPartOverhead() bytes longer than length.
+             */
+            virtual std::pair<uint64_t, uint64_t> GetCiphertextRange(uint64_t offset, size_t length) const = 0;
+
+            /**
+             * Decrypts the ciphertextLength bytes at buffer, fetched from GetCiphertextRange(offset, length), in place, and leaves the length bytes
+             * of plain text at the start of buffer. Returns false if the ciphertext doesn't decrypt.
+             */
+            virtual bool DecryptPart(uint64_t offset, size_t length, unsigned char* buffer, size_t ciphertextLength, size_t capacity) const = 0;
+        };
+
+        typedef Aws::Utils::Outcome<std::shared_ptr<PartEncryptor>, Aws::Client::AWSError<Aws::S3::S3Errors>> PartEncryptorOutcome;
+        typedef Aws::Utils::Outcome<std::shared_ptr<PartDecryptor>, Aws::Client::AWSError<Aws::S3::S3Errors>> PartDecryptorOutcome;
+
+        /**
+         * Client-side encryption for TransferManager. Set one in TransferManagerConfiguration::encryption to have uploads encrypted part by part
+         * as they are read, and downloads decrypted part by part as they arrive, so that encrypted objects are transferred in parallel parts like
+         * any other. Aws::S3Encryption::S3EncryptionTransfer encrypts the way S3EncryptionClient does.
+         */
+        class AWS_TRANSFER_API TransferEncryption
+        {
+        public:
+            virtual ~TransferEncryption() = default;
+
+            /**
+             * Parts of an upload other than the last, and the offsets parts of a download start at, are multiples of this.
+             */
+            virtual size_t GetBlockSize() const = 0;
+
+            /**
+             * Most bytes the ciphertext of a part, uploaded or downloaded, is longer than its plain text. Part buffers are this much larger than parts.
+             */
+            virtual size_t GetMaxPartOverhead() const = 0;
+
+            /**
+             * Starts the encryption of a multi-part upload, adding what decryption will need to the request's metadata or storing it elsewhere.
+             */
+            virtual PartEncryptorOutcome BeginUpload(Aws::S3::Model::CreateMultipartUploadRequest& request) = 0;
+
+            /**
+             * Starts the encryption of an upload in a single PutObject, whose body is then encrypted as its only part.
+             */
+            virtual PartEncryptorOutcome BeginUpload(Aws::S3::Model::PutObjectRequest& request) = 0;
+
+            /**
+             * Starts the decryption of a download, given the HeadObject request made for it and its result.
+             */
+            virtual PartDecryptorOutcome BeginDownload(const Aws::S3::Model::HeadObjectRequest& request, const Aws::S3::Model::HeadObjectResult& result) = 0;
+        };
+    }
+}
@@ -19,6 +19,7 @@
 #include <aws/core/utils/memory/stl/AWSString.h>
 #include <aws/core/utils/memory/stl/AWSSet.h>
 #include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSVector.h>
 #include <aws/core/utils/UUID.h>
 #include <aws/core/client/AWSError.h>
 #include <aws/core/client/AsyncCallerContext.h>
@@ -38,8 +39,13 @@ namespace Aws
     namespace Transfer
     {
         class TransferHandle;
+        class TransferJournal;
+        class DownloadedPart;
+        class PartEncryptor;
+        class PartDecryptor;
 
         typedef std::function<Aws::IOStream*(void)> CreateDownloadStreamCallback;
+        typedef std::function<void(const std::shared_ptr<const TransferHandle>&, const std::shared_ptr<DownloadedPart>&)> DownloadedPartCallback;
 
         static const char CLASS_TAG[] = "TransferManager";
 
@@ -75,6 +81,12 @@ namespace Aws
                 void SetETag(const Aws::String& eTag) { m_eTag = eTag; }
                 const Aws::String& GetETag() const { return m_eTag; }
 
+                /**
+                 * The base64 encoded MD5 of the part as it was read, if TransferManagerConfiguration::computeContentMD5 is set.
+                 */
+                void SetContentMD5(const Aws::String& contentMD5) { m_contentMD5 = contentMD5; }
+                const Aws::String& GetContentMD5() const { return m_contentMD5; }
+
                 Aws::IOStream *GetDownloadPartStream() const { return m_downloadPartStream; }
                 void SetDownloadPartStream(Aws::IOStream *downloadPartStream) { m_downloadPartStream = downloadPartStream; }
 
@@ -92,6 +104,7 @@ namespace Aws
                 int m_partId;
 
                 Aws::String m_eTag;
+                Aws::String m_contentMD5;
                 size_t m_currentProgressInBytes;
                 size_t m_bestProgressInBytes;
                 size_t m_sizeInBytes;
@@ -172,6 +185,18 @@ namespace Aws
             * If this is a multi-part transfer, this is the ID of it. e.g. UploadId for UploadPart
             */
             inline void SetMultipartId(const Aws::String& value) { std::lock_guard<std::mutex> locker(m_getterSetterLock); m_multipartId = value; }
+            /**
+             * The size of the parts this transfer is split into, 0 until the parts have been created. This is the configured bufferSize unless
+             * auto tuning chose a larger part size for the object.
+             */
+            inline uint64_t GetPartSize() const { return m_partSize.load(); }
+            inline void SetPartSize(uint64_t value) { m_partSize.store(value); }
+            /**
+             * The number of parts TransferManager allowed in flight when it last sent a part of this transfer. This is a limit for the TransferManager as a whole,
+             * shared by all of its transfers, not for this transfer alone. Changes as the transfer goes when auto tuning is enabled.
+             */
+            inline size_t GetInFlightPartLimit() const { return m_inFlightPartLimit.load(); }
+            inline void SetInFlightPartLimit(size_t value) { m_inFlightPartLimit.store(value); }
             /**
              * Returns a copy of the completed parts, in the structure of <partId, ETag>. Used for all transfers.
              */
@@ -217,10 +242,15 @@ namespace Aws
              */
             void ChangePartToFailed(const PartPointer& partState);
             /**
-             * Get the parts transactionally, mostly for internal purposes.
+             * Get the parts transactionally, mostly for internal purposes. This copies every part of the transfer, so it is meant for
+             * resuming and reporting; use GetPartCountsTransactional to check progress.
              */
             void GetAllPartsTransactional(PartStateMap& queuedParts, PartStateMap& pendingParts,
                     PartStateMap& failedParts, PartStateMap& completedParts);
+            /**
+             * Get the number of parts in each state transactionally, mostly for internal purposes. Takes constant time regardless of the part count.
+             */
+            void GetPartCountsTransactional(size_t& queuedParts, size_t& pendingParts, size_t& failedParts, size_t& completedParts) const;
             /**
              * Returns true or false if any parts have been created for this transfer
              */
@@ -321,6 +351,74 @@ namespace Aws
              */
             inline std::shared_ptr<const Aws::Client::AsyncCallerContext> GetContext() const { std::lock_guard<std::mutex> locker(m_getterSetterLock); return m_context; }
 
+            /**
+             * The journal recording the progress of this transfer, if TransferManagerConfiguration::journalDirectory is set and this is a multi-part transfer of a file.
+             */
+            inline void SetJournal(const std::shared_ptr<TransferJournal>& value) { std::lock_guard<std::mutex> locker(m_getterSetterLock); m_journal = value; }
+            /**
+             * The journal recording the progress of this transfer, if any.
+             */
+            inline std::shared_ptr<TransferJournal> GetJournal() const { std::lock_guard<std::mutex> locker(m_getterSetterLock); return m_journal; }
+
+            /**
+             * Encrypts the parts of this upload, if TransferManagerConfiguration::encryption is set. Kept for the life of the handle so that
+             * parts sent again by a retry come out as they did the first time.
+             */
+            inline void SetPartEncryptor(const std::shared_ptr<PartEncryptor>& value) { std::lock_guard<std::mutex> locker(m_getterSetterLock); m_partEncryptor = value; }
+            inline std::shared_ptr<PartEncryptor> GetPartEncryptor() const { std::lock_guard<std::mutex> locker(m_getterSetterLock); return m_partEncryptor; }
+
+            /**
+             * Decrypts the parts of this download, if TransferManagerConfiguration::encryption is set.
+             */
+            inline void SetPartDecryptor(const std::shared_ptr<PartDecryptor>& value) { std::lock_guard<std::mutex> locker(m_getterSetterLock); m_partDecryptor = value; }
+            inline std::shared_ptr<PartDecryptor> GetPartDecryptor() const { std::lock_guard<std::mutex> locker(m_getterSetterLock); return m_partDecryptor; }
+
+            /**
+             * The ETag S3 should give the uploaded object, as worked out from the MD5s of its parts when TransferManagerConfiguration::computeContentMD5
+             * is set. Empty until the upload has all its parts, or if some part was sent by an earlier process and its MD5 is unknown.
+             */
+            inline void SetExpectedETag(const Aws::String& value) { std::lock_guard<std::mutex> locker(m_getterSetterLock); m_expectedETag = value; }
+            /**
+             * The ETag S3 should give the uploaded object, or empty if it is not known.
+             */
+            inline const Aws::String GetExpectedETag() const { std::lock_guard<std::mutex> locker(m_getterSetterLock); return m_expectedETag; }
+
+            /**
+             * The object a copy started with TransferManager::CopyObject copies from. A copy is an upload to GetBucketName()/GetKey() whose
+             * parts S3 copies from this object instead of receiving them from the client.
+             */
+            inline void SetCopySource(const Aws::String& bucketName, const Aws::String& keyName) { std::lock_guard<std::mutex> locker(m_getterSetterLock); m_copySourceBucket = bucketName; m_copySourceKey = keyName; }
+            /**
+             * The bucket a copy copies from, empty unless this handle belongs to a copy.
+             */
+            inline const Aws::String GetCopySourceBucketName() const { std::lock_guard<std::mutex> locker(m_getterSetterLock); return m_copySourceBucket; }
+            /**
+             * The key a copy copies from, empty unless this handle belongs to a copy.
+             */
+            inline const Aws::String GetCopySourceKey() const { std::lock_guard<std::mutex> locker(m_getterSetterLock); return m_copySourceKey; }
+            /**
+             * Whether this handle belongs to a copy started with TransferManager::CopyObject.
+             */
+            inline bool IsCopy() const { return !GetCopySourceKey().empty(); }
+            /**
+             * The ETag the copy source had when the copy started. Every part is copied only if the source still has it, so that a source
+             * overwritten during the copy fails the copy instead of mixing two versions.
+             */
+            inline void SetCopySourceETag(const Aws::String& value) { std::lock_guard<std::mutex> locker(m_getterSetterLock); m_copySourceETag = value; }
+            /**
+             * The ETag the copy source had when the copy started.
+             */
+            inline const Aws::String GetCopySourceETag() const { std::lock_guard<std::mutex> locker(m_getterSetterLock); return m_copySourceETag; }
+
+            /**
+             * The callback that receives the parts of this download as they arrive, if it was started with TransferManager::DownloadParts.
+             */
+            inline void SetDownloadedPartCallback(const DownloadedPartCallback& value) { std::lock_guard<std::mutex> locker(m_getterSetterLock); m_downloadedPartCallback = value; }
+            /**
+             * The callback that receives the parts of this download as they arrive, or an empty function if the parts are written to a stream.
+             */
+            inline DownloadedPartCallback GetDownloadedPartCallback() const { std::lock_guard<std::mutex> locker(m_getterSetterLock); return m_downloadedPartCallback; }
+
             /**
              * The current status of the operation
              */
@@ -364,15 +462,43 @@ namespace Aws
 
         private:
 
+            enum class PartSlotState : uint8_t
+            {
+                NONE,
+                QUEUED,
+                PENDING,
+                FAILED,
+                COMPLETED
+            };
+
+            /// A part and the state it is in, stored at index partId - 1
+            struct PartSlot
+            {
+                PartSlot() : state(PartSlotState::NONE) {}
+
+                PartPointer part;
+                PartSlotState state;
+            };
+
             void CleanupDownloadStream();
 
+            /// Moves the part to the given state and keeps the per-state counts in step; m_partsLock must be held
+            void MovePart(const PartPointer& partState, PartSlotState nextState);
+            /// Copies out the parts in the given state, ordered by part id; m_partsLock must be held
+            PartStateMap CollectParts(PartSlotState state) const;
+            std::atomic<size_t>& GetPartCount(PartSlotState state);
+
             std::atomic<bool> m_isMultipart;
             Aws::String m_multipartId;
             TransferDirection m_direction;
-            PartStateMap m_completedParts;
-            PartStateMap m_pendingParts;
-            PartStateMap m_queuedParts;
-            PartStateMap m_failedParts;
+            Aws::Vector<PartSlot> m_parts;
+            // Only changed under m_partsLock, but read without it by the Has*Parts() checks
+            std::atomic<size_t> m_queuedPartCount;
+            std::atomic<size_t> m_pendingPartCount;
+            std::atomic<size_t> m_failedPartCount;
+            std::atomic<size_t> m_completedPartCount;
+            std::atomic<uint64_t> m_partSize;
+            std::atomic<size_t> m_inFlightPartLimit;
             std::atomic<uint64_t> m_bytesTransferred;
             std::atomic<bool> m_lastPart;
             std::atomic<uint64_t> m_bytesTotalSize;
@@ -386,6 +512,14 @@ namespace Aws
             Aws::Client::AWSError<Aws::S3::S3Errors> m_lastError;
             std::atomic<bool> m_cancel;
             std::shared_ptr<const Aws::Client::AsyncCallerContext> m_context;
+            std::shared_ptr<TransferJournal> m_journal;
+            std::shared_ptr<PartEncryptor> m_partEncryptor;
+            std::shared_ptr<PartDecryptor> m_partDecryptor;
+            DownloadedPartCallback m_downloadedPartCallback;
+            Aws::String m_copySourceBucket;
+            Aws::String m_copySourceKey;
+            Aws::String m_copySourceETag;
+            Aws::String m_expectedETag;
             const Utils::UUID m_handleId;
 
             CreateDownloadStreamCallback m_createDownloadStreamFn;
@@ -0,0 +1,135 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <aws/transfer/Transfer_EXPORTS.h>
+#include <aws/transfer/TransferHandle.h>
+#include <aws/core/utils/memory/stl/AWSString.h>
+#include <aws/core/utils/memory/stl/AWSMap.h>
+#include <aws/core/utils/memory/stl/AWSStreamFwd.h>
+#include <fstream>
+#include <chrono>
+#include <mutex>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        /**
+         * What a journal is about. A journal is only resumed from if all of it matches the transfer being started.
+         */
+        struct TransferJournalHeader
+        {
+            TransferJournalHeader() : direction(TransferDirection::UPLOAD), totalSize(0), partSize(0) {}
+
+            bool operator==(const TransferJournalHeader& other) const;
+            bool operator!=(const TransferJournalHeader& other) const { return !(*this == other); }
+
+            TransferDirection direction;
+            Aws::String bucketName;
+            Aws::String keyName;
+            Aws::String filePath;
+            uint64_t totalSize;
+            uint64_t partSize;
+            /**
+             * The upload ID of an upload, or the ETag of the object being downloaded.
+             */
+            Aws::String transferId;
+        };
+
+        /**
+         * An append-only file recording the progress of a multi-part transfer, so that TransferManager can pick the transfer up where it
+         * left off after the process restarts. The first line describes the transfer (see TransferJournalHeader); every further line is a
+         * completed part with its ETag.
+         *
+         * Completed parts are written in batches, once batchSize parts are waiting or a second has passed since the last write, so a crash
+         * can lose up to a batch of parts; those are simply transferred again. A line cut short by a crash is ignored when the journal is read.
+         *
+         * It is thread safe.
+         */
+        class AWS_TRANSFER_API TransferJournal
+        {
+        public:
+            /**
+             * Reads the journal at path, if there is one. Nothing is written until Start() or Resume() is called.
+             */
+            TransferJournal(const Aws::String& path, size_t batchSize);
+            ~TransferJournal();
+
+            TransferJournal(const TransferJournal&) = delete;
+            TransferJournal& operator=(const TransferJournal&) = delete;
+
+            /**
+             * Where the journal of the transfer between the file and bucketName/keyName is kept in journalDirectory.
+             */
+            static Aws::String GetJournalPath(const Aws::String& journalDirectory, TransferDirection direction, const Aws::String& bucketName,
+                                              const Aws::String& keyName, const Aws::String& filePath);
+
+            /**
+             * True if a journal was read from disk.
+             */
+            bool HasHeader() const { return m_hasHeader; }
+            /**
+             * The header read from disk.
+             */
+            const TransferJournalHeader& GetHeader() const { return m_header; }
+            /**
+             * The completed parts read from disk, by part number, with their ETags.
+             */
+            const Aws::Map<int, Aws::String>& GetCompletedParts() const { return m_completedParts; }
+
+            /**
+             * Throws away whatever was read and starts a new journal for the transfer described by header. Returns false if it can't be written.
+             */
+            bool Start(const TransferJournalHeader& header);
+            /**
+             * Keeps what was read and appends to it. Returns false if it can't be written.
+             */
+            bool Resume();
+
+            /**
+             * Records a completed part. It is written with the next batch.
+             */
+            void RecordPart(int partNumber, const Aws::String& eTag);
+            /**
+             * Writes the parts recorded so far.
+             */
+            void Flush();
+            /**
+             * Deletes the journal, once the transfer has completed or been aborted.
+             */
+            void Remove();
+
+        private:
+            void Read();
+            bool Open(std::ios_base::openmode mode);
+            void FlushLocked();
+
+            const Aws::String m_path;
+            const size_t m_batchSize;
+
+            TransferJournalHeader m_header;
+            bool m_hasHeader;
+            Aws::Map<int, Aws::String> m_completedParts;
+
+            std::mutex m_lock;
+            Aws::OFStream m_file;
+            Aws::String m_pendingLines;
+            size_t m_pendingParts;
+            std::chrono::steady_clock::time_point m_lastFlush;
+        };
+    }
+}
@@ -16,16 +16,26 @@
 #pragma once
 
 #include <aws/transfer/TransferHandle.h>
+#include <aws/transfer/PartConcurrencyTuner.h>
+#include <aws/transfer/DirectoryTransferHandle.h>
+#include <aws/transfer/TransferJournal.h>
+#include <aws/transfer/DownloadedPart.h>
+#include <aws/transfer/PartBufferPool.h>
+#include <aws/transfer/TransferEncryption.h>
 #include <aws/s3/S3Client.h>
 #include <aws/s3/model/PutObjectRequest.h>
 #include <aws/s3/model/CreateMultipartUploadRequest.h>
 #include <aws/s3/model/UploadPartRequest.h>
+#include <aws/s3/model/UploadPartCopyRequest.h>
 #include <aws/core/utils/threading/Executor.h>
 #include <aws/core/utils/memory/stl/AWSStreamFwd.h>
+#include <aws/core/utils/memory/stl/AWSList.h>
 #include <aws/core/utils/ResourceManager.h>
 #include <aws/core/client/AsyncCallerContext.h>
 
 #include <memory>
+#include <atomic>
+#include <condition_variable>
 
 namespace Aws
 {    
@@ -38,6 +48,7 @@ namespace Aws
         typedef std::function<void(const TransferManager*, const std::shared_ptr<const TransferHandle>&)> TransferStatusUpdatedCallback;
         typedef std::function<void(const TransferManager*, const std::shared_ptr<const TransferHandle>&, const Aws::Client::AWSError<Aws::S3::S3Errors>&)> ErrorCallback;
         typedef std::function<void(const TransferManager*, const std::shared_ptr<const TransferHandle>&)> TransferInitiatedCallback;
+        typedef std::function<void(const TransferManager*, const std::shared_ptr<const DirectoryTransferHandle>&)> DirectoryProgressCallback;
 
         const uint64_t MB5 = 5 * 1024 * 1024;
 
@@ -46,7 +57,10 @@ namespace Aws
          */
         struct TransferManagerConfiguration
         {
-            TransferManagerConfiguration(Aws::Utils::Threading::Executor* executor) : s3Client(nullptr), transferExecutor(executor), transferBufferMaxHeapSize(10 * MB5), bufferSize(MB5)
+            TransferManagerConfiguration(Aws::Utils::Threading::Executor* executor) : s3Client(nullptr), transferExecutor(executor), transferBufferMaxHeapSize(10 * MB5), bufferSize(MB5),
+                enableAutoTuning(false), maxPartCount(10000), minInFlightParts(4), maxInFlightParts(256), autoTuningMaxHeapSize(0),
+                uploadReadThreads(4), computeContentMD5(false), directoryMaxInFlight(64), directoryProgressInterval(100),
+                journalBatchSize(16)
             {
             }
 
@@ -79,13 +93,90 @@ namespace Aws
              * Maximum size of the working buffers to use. This is not the same thing as max heap size for your process. This is the maximum amount of memory we will
              * allocate for all transfer buffers. default is 50MB.
              * If you are using Aws::Utils::Threading::PooledThreadExecutor for transferExecutor, this size should be greater than bufferSize * poolSize.
+             * Not used with enableAutoTuning, see autoTuningMaxHeapSize.
              */
             uint64_t transferBufferMaxHeapSize;
             /**
              * Defaults to 5MB. If you are uploading large files,  (larger than 50GB, this needs to be specified to be something larger than 5MB. Also keep in mind that you may need
              * to increase your max heap size if this is something you plan on increasing.
+             * With enableAutoTuning, this is the smallest part size, and also the size up to which objects are uploaded in a single PutObject.
              */
             uint64_t bufferSize;
+            /**
+             * When true, the part size and the number of parts in flight are tuned rather than fixed. Each object is split into parts of the smallest multiple
+             * of bufferSize that keeps it within maxPartCount parts, and the number of parts in flight follows the throughput and latency measured for
+             * completed parts, staying between minInFlightParts and maxInFlightParts and within autoTuningMaxHeapSize. See PartConcurrencyTuner.
+             * The number of parts in flight is shared by all transfers of the TransferManager.
+             * The chosen values are reported by TransferHandle::GetPartSize() and TransferHandle::GetInFlightPartLimit(). Defaults to false.
+             */
+            bool enableAutoTuning;
+            /**
+             * Most parts an object is split into with enableAutoTuning. Defaults to 10,000, the limit S3 places on multipart uploads.
+             */
+            size_t maxPartCount;
+            /**
+             * Fewest parts kept in flight with enableAutoTuning; also where tuning starts. Defaults to 4.
+             */
+            size_t minInFlightParts;
+            /**
+             * Most parts kept in flight with enableAutoTuning. Defaults to 256.
+             */
+            size_t maxInFlightParts;
+            /**
+             * Most memory used for the buffers of the parts in flight with enableAutoTuning. Defaults to 0, which leaves them bounded by
+             * maxInFlightParts parts only. Parts of large objects are larger than bufferSize, so this is separate from transferBufferMaxHeapSize.
+             */
+            uint64_t autoTuningMaxHeapSize;
+            /**
+             * Where part buffers come from, see PartBufferPool and HugePagePartBufferPool. The number of parts in flight, and so of buffers out
+             * at once, is still limited by transferBufferMaxHeapSize / bufferSize, or by the auto tuning settings, but buffers are taken from the
+             * pool as parts need them instead of being allocated up front. By default buffers come from the heap.
+             */
+            std::shared_ptr<PartBufferPool> bufferPool;
+            /**
+             * Most threads reading the parts of a file upload at once. Each reads whole parts at their offsets in the file and sends them as soon
+             * as they are read, so disk reads overlap each other and the network. Every upload reads on its own thread, and the manager keeps a
+             * pool of uploadReadThreads - 1 more, shared by all of its uploads, so concurrent uploads add no threads beyond that pool. Uploads from
+             * a stream read their parts in order on a single thread. Defaults to 4.
+             */
+            size_t uploadReadThreads;
+            /**
+             * When true, the MD5 of every uploaded part, or of the whole object for a single PutObject, is computed on the thread that read it, right
+             * after reading, and sent as its Content-MD5 so that S3 rejects data that changed on the way. This replaces computeContentMD5 on the request
+             * templates, which hashes each part again while it is sent. The part MD5s make up the ETag S3 should give the object, which is kept in
+             * TransferHandle::GetExpectedETag(); an upload whose object comes back with another ETag fails. Objects encrypted with a KMS or customer
+             * key have other ETags, and are not checked. Defaults to false.
+             */
+            bool computeContentMD5;
+            /**
+             * Most requests BulkUploadDirectory and BulkDownloadToDirectory keep in flight for each directory, and so the most files each keeps open.
+             * Defaults to 64.
+             */
+            size_t directoryMaxInFlight;
+            /**
+             * Shortest time between two calls to directoryProgressCallback for the same directory transfer. Defaults to 100ms.
+             */
+            std::chrono::milliseconds directoryProgressInterval;
+            /**
+             * When set, multi-part uploads and downloads of files keep a journal of their progress in this directory, named after the bucket, key
+             * and file. If the process stops mid-way, calling UploadFile or DownloadFile again with the same bucket, key and file, and a
+             * TransferManager with the same part size settings, picks the transfer up from the journal instead of starting it over. For uploads,
+             * only parts S3 still lists for the upload with the journaled ETag are kept; downloads start over if the object's ETag changed.
+             * The journal is deleted once the transfer completes or is aborted. Uploads and downloads of streams are not journaled. Empty by default.
+             */
+            Aws::String journalDirectory;
+            /**
+             * Number of completed parts written to a journal at once, see TransferJournal. Parts are also written at least once a second. Defaults to 16.
+             */
+            size_t journalBatchSize;
+            /**
+             * When set, uploads are encrypted and downloads decrypted on the client, part by part, see TransferEncryption. Uploads read their
+             * parts in order on a single thread, since each part is encrypted after the one before it, but still send them in parallel;
+             * downloads fetch and decrypt their parts in parallel. Part buffers are TransferEncryption::GetMaxPartOverhead() bytes larger than
+             * bufferSize. Encrypted uploads are not journaled. BulkUploadDirectory and BulkDownloadToDirectory, which stream objects as they
+             * are, fail, and CopyObject copies objects without decrypting them. Not set by default.
+             */
+            std::shared_ptr<TransferEncryption> encryption;
 
             /**
              * Callback to receive progress updates for uploads.
@@ -107,6 +198,11 @@ namespace Aws
              * Callback to receive all errors that are thrown over the course of a transfer.
              */
             ErrorCallback errorCallback;
+            /**
+             * Callback to receive progress updates for BulkUploadDirectory and BulkDownloadToDirectory, at most once per directoryProgressInterval
+             * and once more when the transfer finishes.
+             */
+            DirectoryProgressCallback directoryProgressCallback;
             /**
              * To support Customer Access Log Information when access S3. 
              * https://docs.aws.amazon.com/AmazonS3/latest/dev/LogFormat.html
@@ -172,6 +268,20 @@ namespace Aws
                                                          const Aws::String& writeToFile = "",
                                                          const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context = nullptr);
 
+            /**
+             * Downloads the contents of bucketName/keyName in S3 and hands each part to onPart as soon as it arrives, in whatever order the parts
+             * complete, instead of writing it to a stream. Nothing is copied: the part carries the buffer it was downloaded into, and the buffer
+             * goes back to the pool when the part is dropped, so the consumer can work on any part while the others are still downloading.
+             * onPart is called on the S3 client's executor threads, possibly on several at once, and before the part counts as completed, so
+             * every part has been handed over by the time the handle's status is COMPLETED. Parts kept past onPart hold on to their buffers;
+             * see DownloadedPart.
+             */
+            std::shared_ptr<TransferHandle> DownloadParts(const Aws::String& bucketName,
+                                                          const Aws::String& keyName,
+                                                          const DownloadedPartCallback& onPart,
+                                                          const DownloadConfiguration& downloadConfig = DownloadConfiguration(),
+                                                          const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context = nullptr);
+
             /**
              * Retry an download that failed from a previous DownloadFile operation. If a multi-part download was used, only the failed parts will be re-fetched.
              */
@@ -186,6 +296,24 @@ namespace Aws
              */
             std::shared_ptr<TransferHandle> RetryUpload(const std::shared_ptr<Aws::IOStream>& stream, const std::shared_ptr<TransferHandle>& retryHandle);
             
+            /**
+             * Copies sourceBucketName/sourceKeyName to bucketName/keyName in S3 without the data passing through the client. Objects up to the
+             * configured bufferSize are copied with a single CopyObject. Larger ones are copied as a multi-part upload whose parts S3 copies with
+             * UploadPartCopy, in parallel, in parts of bufferSize or, for objects that would need more than maxPartCount parts, the next multiple
+             * of it. The copy keeps the source's content type and metadata. The returned handle reports progress like an upload, as parts finish;
+             * a copy that fails or is canceled can be retried with RetryCopy or aborted with AbortMultipartUpload like an upload.
+             */
+            std::shared_ptr<TransferHandle> CopyObject(const Aws::String& sourceBucketName,
+                                                       const Aws::String& sourceKeyName,
+                                                       const Aws::String& bucketName,
+                                                       const Aws::String& keyName,
+                                                       const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context = nullptr);
+
+            /**
+             * Retry a copy that failed from a previous CopyObject operation. If the copy was done in parts, only the failed parts will be copied again.
+             */
+            std::shared_ptr<TransferHandle> RetryCopy(const std::shared_ptr<TransferHandle>& retryHandle);
+
             /**
              * By default, multi-part uploads will remain in a FAILED state if they fail, or a CANCELED state if they were canceled. Leaving failed uploads around
              * still costs the owner of the bucket money. If you know you will not be retrying the request, abort the request after canceling it or if it fails and you don't
@@ -215,7 +343,35 @@ namespace Aws
             */
             void DownloadToDirectory(const Aws::String& directory, const Aws::String& bucketName, const Aws::String& prefix = Aws::String());
 
+            /**
+             * Uploads entire contents of directory like UploadDirectory, but without a TransferHandle per file, for trees of many small files.
+             * Each file is uploaded with a single PutObject streamed from disk, so no file may be larger than the 5GB PutObject accepts; use UploadFile
+             * for large files, which splits them into parts. The directory is walked as the uploads go, at most directoryMaxInFlight uploads are in
+             * flight, and a file is only opened when its upload starts. Progress is reported through directoryProgressCallback and the returned handle.
+             * This is an asynchronous method.
+             *
+             * directory: the absolute directory on disk to upload
+             * bucketName: the name of the S3 bucket to upload to
+             * prefix: the prefix to put on all objects uploaded (e.g. put them in x directory in the bucket).
+             */
+            std::shared_ptr<DirectoryTransferHandle> BulkUploadDirectory(const Aws::String& directory, const Aws::String& bucketName, const Aws::String& prefix,
+                                                                         const Aws::Map<Aws::String, Aws::String>& metadata);
+
+            /**
+             * Downloads entire contents of an Amazon S3 bucket starting at prefix like DownloadToDirectory, but without a TransferHandle per object,
+             * for prefixes of many small objects. Each object is downloaded with a single GetObject streamed to disk. Listing pages are consumed as the
+             * downloads go, at most directoryMaxInFlight downloads are in flight, and a file is only created when its response arrives. Progress is
+             * reported through directoryProgressCallback and the returned handle. This is an asynchronous method.
+             *
+             * directory: the absolute directory on disk to download to
+             * bucketName: the name of the S3 bucket to download from
+             * prefix: the prefix in the bucket to use as the root directory.
+             */
+            std::shared_ptr<DirectoryTransferHandle> BulkDownloadToDirectory(const Aws::String& directory, const Aws::String& bucketName, const Aws::String& prefix = Aws::String());
+
         private:
+            friend class DownloadedPart;
+
             /**
              * To ensure TransferManager is always created as a shared_ptr, since it inherits enable_shared_from_this.
              */
@@ -269,8 +425,26 @@ namespace Aws
             void DoSinglePartUpload(const std::shared_ptr<Aws::IOStream>& streamToPut, const std::shared_ptr<TransferHandle>& handle);
 
             void DoMultiPartUpload(const std::shared_ptr<TransferHandle>& handle);
+            bool InitializePartsForUpload(const std::shared_ptr<TransferHandle>& handle, uint64_t& sentBytes);
+            bool ResumeUploadFromJournal(const std::shared_ptr<TransferHandle>& handle, TransferJournal& journal, uint64_t& sentBytes);
+            TransferJournalHeader MakeJournalHeader(const TransferHandle& handle, TransferDirection direction, const Aws::String& transferId) const;
+            void CompleteMultiPartUploadIfDone(const std::shared_ptr<TransferHandle>& handle);
+            std::shared_ptr<TransferHandle> DownloadFileWithJournal(const Aws::String& bucketName,
+                                                                    const Aws::String& keyName,
+                                                                    const Aws::String& writeToFile,
+                                                                    const DownloadConfiguration& downloadConfig,
+                                                                    const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context);
+            void ReadAndUploadParts(const std::shared_ptr<TransferHandle>& handle, const Aws::Vector<PartPointer>& parts, std::atomic<size_t>& nextPart);
+            void UploadPart(const std::shared_ptr<TransferHandle>& handle, const PartPointer& part, Aws::Utils::Array<uint8_t>* buffer);
             void DoSinglePartUpload(const std::shared_ptr<TransferHandle>& handle);
 
+            void DoCopy(const std::shared_ptr<TransferHandle>& handle);
+            void DoSinglePartCopy(const std::shared_ptr<TransferHandle>& handle);
+            void CopyPart(const std::shared_ptr<TransferHandle>& handle, const PartPointer& part);
+            Aws::String GetCopySource(const TransferHandle& handle) const;
+            void AcquireCopyPart();
+            void ReleaseCopyPart();
+
             void DoDownload(const std::shared_ptr<TransferHandle>& handle);
             void DoSinglePartDownload(const std::shared_ptr<TransferHandle>& handle);
 
@@ -282,19 +456,49 @@ namespace Aws
             void WaitForCancellationAndAbortUpload(const std::shared_ptr<TransferHandle>& canceledHandle);
 
             void HandleUploadPartResponse(const Aws::S3::S3Client*, const Aws::S3::Model::UploadPartRequest&, const Aws::S3::Model::UploadPartOutcome&, const std::shared_ptr<const Aws::Client::AsyncCallerContext>&);
+            void HandleUploadPartCopyResponse(const Aws::S3::S3Client*, const Aws::S3::Model::UploadPartCopyRequest&, const Aws::S3::Model::UploadPartCopyOutcome&, const std::shared_ptr<const Aws::Client::AsyncCallerContext>&);
             void HandlePutObjectResponse(const Aws::S3::S3Client*, const Aws::S3::Model::PutObjectRequest&, const Aws::S3::Model::PutObjectOutcome&, const std::shared_ptr<const Aws::Client::AsyncCallerContext>&);
             void HandleListObjectsResponse(const Aws::S3::S3Client*, const Aws::S3::Model::ListObjectsV2Request&, const Aws::S3::Model::ListObjectsV2Outcome&, const std::shared_ptr<const Aws::Client::AsyncCallerContext>&);
 
             TransferStatus DetermineIfFailedOrCanceled(const TransferHandle&) const;
+            bool IsExpectedETag(const std::shared_ptr<TransferHandle>& handle, const Aws::String& eTag, Aws::S3::Model::ServerSideEncryption serverSideEncryption,
+                                bool customerKey) const;
             void TriggerUploadProgressCallback(const std::shared_ptr<const TransferHandle>&) const;
             void TriggerDownloadProgressCallback(const std::shared_ptr<const TransferHandle>&) const;
             void TriggerTransferStatusUpdatedCallback(const std::shared_ptr<const TransferHandle>&) const;
             void TriggerErrorCallback(const std::shared_ptr<const TransferHandle>&, const Aws::Client::AWSError<Aws::S3::S3Errors>& error)const;
 
             static Aws::String DetermineFilePath(const Aws::String& directory, const Aws::String& prefix, const Aws::String& keyName);
+            static Aws::String DetermineKeyName(const Aws::String& prefix, const Aws::String& relativePath);
+
+            void DoBulkUploadDirectory(const std::shared_ptr<DirectoryTransferHandle>& handle, const Aws::Map<Aws::String, Aws::String>& metadata);
+            void DoBulkDownloadToDirectory(const std::shared_ptr<DirectoryTransferHandle>& handle);
+            void TriggerDirectoryProgressCallback(const std::shared_ptr<DirectoryTransferHandle>& handle, bool finished) const;
+
+            uint64_t ComputePartSize(uint64_t objectSize) const;
+            Aws::Utils::Array<uint8_t>* AcquirePartBuffer(uint64_t partSize, const std::shared_ptr<TransferHandle>& handle);
+            void ReleasePartBuffer(Aws::Utils::Array<uint8_t>* buffer);
+            void RecordPartTransfer(uint64_t partSize, std::chrono::steady_clock::time_point startTime, bool succeeded);
 
             Aws::Utils::ExclusiveOwnershipResourceManager<Aws::Utils::Array<uint8_t>*> m_bufferManager;
+            std::shared_ptr<PartConcurrencyTuner> m_partTuner;
+            std::mutex m_idlePartBuffersLock;
+            /// Part buffers kept for reuse with enableAutoTuning, of any size, oldest released first
+            Aws::List<Aws::Utils::Array<uint8_t>*> m_idlePartBuffers;
+            uint64_t m_idlePartBufferBytes;
+            /// Copied parts take no buffers, but without auto tuning they are held to as many in flight as there are buffers
+            std::mutex m_copyPartsLock;
+            std::condition_variable m_copyPartReleased;
+            size_t m_copyPartsInFlight;
+            /// Without auto tuning, buffers from a bufferPool are held to as many as would have been allocated up front
+            std::mutex m_pooledBuffersLock;
+            std::condition_variable m_pooledBufferReleased;
+            size_t m_pooledBuffersInFlight;
             TransferManagerConfiguration m_transferConfig;
+            /// Room part buffers leave past the part for the ciphertext to grow into
+            size_t m_partBufferOverhead;
+            /// Extra readers for file uploads, shared by all of them; null when uploadReadThreads is 1
+            Aws::UniquePtr<Aws::Utils::Threading::PooledThreadExecutor> m_uploadReadExecutor;
         };
 
         
@@ -0,0 +1,163 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include <aws/transfer/DirectoryTransferHandle.h>
+
+#include <algorithm>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        DirectoryTransferHandle::DirectoryTransferHandle(TransferDirection direction, const Aws::String& directory, const Aws::String& bucketName, const Aws::String& prefix) :
+            m_direction(direction),
+            m_directory(directory),
+            m_bucketName(bucketName),
+            m_prefix(prefix),
+            m_objectsTransferred(0),
+            m_objectsFailed(0),
+            m_bytesTransferred(0),
+            m_cancel(false),
+            m_requestsInFlight(0),
+            m_listingFinished(false),
+            m_listingFailed(false),
+            m_status(TransferStatus::IN_PROGRESS),
+            m_finishNotified(false),
+            m_lastProgressReport(std::chrono::steady_clock::now())
+        {
+        }
+
+        Aws::Vector<Aws::String> DirectoryTransferHandle::GetFailedKeys() const
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            return m_failedKeys;
+        }
+
+        Aws::Client::AWSError<Aws::S3::S3Errors> DirectoryTransferHandle::GetLastError() const
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            return m_lastError;
+        }
+
+        TransferStatus DirectoryTransferHandle::GetStatus() const
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            return m_status;
+        }
+
+        void DirectoryTransferHandle::Cancel()
+        {
+            m_cancel.store(true);
+            // wake the thread waiting for a slot
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_signal.notify_all();
+        }
+
+        bool DirectoryTransferHandle::ShouldContinue() const
+        {
+            return !m_cancel.load();
+        }
+
+        void DirectoryTransferHandle::WaitUntilFinished() const
+        {
+            std::unique_lock<std::mutex> locker(m_lock);
+            m_signal.wait(locker, [this] { return m_finishNotified; });
+        }
+
+        bool DirectoryTransferHandle::AcquireRequestSlot(size_t maxInFlight)
+        {
+            std::unique_lock<std::mutex> locker(m_lock);
+            m_signal.wait(locker, [this, maxInFlight] { return m_cancel.load() || m_requestsInFlight < (std::max)(maxInFlight, static_cast<size_t>(1)); });
+            if (m_cancel.load())
+            {
+                return false;
+            }
+            ++m_requestsInFlight;
+            return true;
+        }
+
+        bool DirectoryTransferHandle::CompleteRequest(const Aws::String& key, uint64_t bytes, bool succeeded, const Aws::Client::AWSError<Aws::S3::S3Errors>& error)
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            if (succeeded)
+            {
+                m_bytesTransferred += bytes;
+                ++m_objectsTransferred;
+            }
+            else
+            {
+                m_failedKeys.push_back(key);
+                m_lastError = error;
+                ++m_objectsFailed;
+            }
+            --m_requestsInFlight;
+            m_signal.notify_all();
+            return FinishIfDone();
+        }
+
+        bool DirectoryTransferHandle::FinishListing(bool succeeded, const Aws::Client::AWSError<Aws::S3::S3Errors>& error)
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_listingFinished = true;
+            if (!succeeded)
+            {
+                m_listingFailed = true;
+                m_lastError = error;
+            }
+            return FinishIfDone();
+        }
+
+        bool DirectoryTransferHandle::IsProgressReportDue(std::chrono::milliseconds interval)
+        {
+            auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> locker(m_lock);
+            if (m_status != TransferStatus::IN_PROGRESS || now - m_lastProgressReport < interval)
+            {
+                return false;
+            }
+            m_lastProgressReport = now;
+            return true;
+        }
+
+        void DirectoryTransferHandle::NotifyFinished()
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_finishNotified = true;
+            m_signal.notify_all();
+        }
+
+        bool DirectoryTransferHandle::FinishIfDone()
+        {
+            if (!m_listingFinished || m_requestsInFlight > 0 || m_status != TransferStatus::IN_PROGRESS)
+            {
+                return false;
+            }
+
+            if (m_cancel.load())
+            {
+                m_status = TransferStatus::CANCELED;
+            }
+            else if (m_listingFailed || m_objectsFailed.load() > 0)
+            {
+                m_status = TransferStatus::FAILED;
+            }
+            else
+            {
+                m_status = TransferStatus::COMPLETED;
+            }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include <aws/transfer/DownloadedPart.h>
+#include <aws/transfer/TransferManager.h>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        DownloadedPart::DownloadedPart(const std::shared_ptr<TransferManager>& transferManager, Aws::Utils::Array<uint8_t>* buffer, uint64_t offset, size_t size, int partNumber) :
+            m_transferManager(transferManager),
+            m_buffer(buffer),
+            m_offset(offset),
+            m_size(size),
+            m_partNumber(partNumber)
+        {
+        }
+
+        DownloadedPart::~DownloadedPart()
+        {
+            Release();
+        }
+
+        void DownloadedPart::Release()
+        {
+            if (m_buffer)
+            {
+                m_transferManager->ReleasePartBuffer(m_buffer);
+                m_buffer = nullptr;
+                m_transferManager = nullptr;
+            }
+        }
+    }
+}
@@ -0,0 +1,339 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include <aws/transfer/ParallelObjectSelector.h>
+#include <aws/core/utils/memory/AWSMemory.h>
+#include <aws/core/utils/logging/LogMacros.h>
+#include <aws/s3/S3Client.h>
+#include <aws/s3/model/HeadObjectRequest.h>
+#include <aws/s3/model/SelectObjectContentHandler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+
+using namespace Aws::S3::Model;
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        static const char* PARALLEL_SELECTOR_TAG = "ParallelObjectSelector";
+
+        /**
+         * What the SelectObjectContents of one Select call share.
+         */
+        struct ParallelSelectState
+        {
+            struct Range
+            {
+                Range() : ended(false), done(false) {}
+
+                bool ended;
+                bool done;
+                // in OBJECT_ORDER, records that arrived while ranges before this one were still running; in ARRIVAL_ORDER, the start of a
+                // record whose end has not arrived yet
+                Aws::Vector<unsigned char> heldRecords;
+                Progress progress;
+            };
+
+            ParallelSelectState(size_t rangeCount) : inFlight(0), failed(false), ranges(rangeCount), firstUndelivered(0)
+            {
+                stats.WithBytesScanned(0).WithBytesProcessed(0).WithBytesReturned(0);
+            }
+
+            void Fail(const Aws::Client::AWSError<Aws::S3::S3Errors>& rangeError)
+            {
+                if (!failed)
+                {
+                    error = rangeError;
+                    failed = true;
+                }
+            }
+
+            std::mutex lock;
+            std::condition_variable rangeFinished;
+            size_t inFlight;
+            // read without the lock by the ranges still running, to cancel them
+            std::atomic<bool> failed;
+            Aws::Client::AWSError<Aws::S3::S3Errors> error;
+            Stats stats;
+            Aws::Vector<Range> ranges;
+            // in OBJECT_ORDER, the first range whose records have not all been handed over; its records are handed over as they arrive
+            size_t firstUndelivered;
+        };
+
+        ParallelObjectSelector::ParallelObjectSelector(const ParallelObjectSelectorConfiguration& configuration) : m_configuration(configuration)
+        {
+            assert(m_configuration.s3Client);
+            assert(m_configuration.scanRangeSize > 0);
+            assert(m_configuration.maxConcurrentRanges > 0);
+        }
+
+        /**
+         * Copies what a query is made of, leaving out the scan range and event stream handler.
+         */
+        static void CopyQuery(const SelectObjectContentRequest& from, SelectObjectContentRequest& to)
+        {
+            to.SetBucket(from.GetBucket());
+            to.SetKey(from.GetKey());
+            if (from.SSECustomerAlgorithmHasBeenSet())
+            {
+                to.SetSSECustomerAlgorithm(from.GetSSECustomerAlgorithm());
+            }
+            if (from.SSECustomerKeyHasBeenSet())
+            {
+                to.SetSSECustomerKey(from.GetSSECustomerKey());
+            }
+            if (from.SSECustomerKeyMD5HasBeenSet())
+            {
+                to.SetSSECustomerKeyMD5(from.GetSSECustomerKeyMD5());
+            }
+            if (from.ExpressionHasBeenSet())
+            {
+                to.SetExpression(from.GetExpression());
+            }
+            if (from.ExpressionTypeHasBeenSet())
+            {
+                to.SetExpressionType(from.GetExpressionType());
+            }
+            if (from.RequestProgressHasBeenSet())
+            {
+                to.SetRequestProgress(from.GetRequestProgress());
+            }
+            if (from.InputSerializationHasBeenSet())
+            {
+                to.SetInputSerialization(from.GetInputSerialization());
+            }
+            if (from.OutputSerializationHasBeenSet())
+            {
+                to.SetOutputSerialization(from.GetOutputSerialization());
+            }
+            if (from.CustomizedAccessLogTagHasBeenSet())
+            {
+                to.SetCustomizedAccessLogTag(from.GetCustomizedAccessLogTag());
+            }
+        }
+
+        /**
+         * Whether S3 Select can scan the object of request by ranges.
+         */
+        static bool SupportsScanRanges(const SelectObjectContentRequest& request)
+        {
+            const InputSerialization& input = request.GetInputSerialization();
+            if (input.GetCompressionType() == CompressionType::GZIP || input.GetCompressionType() == CompressionType::BZIP2)
+            {
+                return false;
+            }
+            // a record delimiter in quotes could be taken for the end of a record by the range it falls in
+            return !input.CSVHasBeenSet() || !input.GetCSV().GetAllowQuotedRecordDelimiter();
+        }
+
+        /**
+         * What ends each record the query returns.
+         */
+        static Aws::String GetRecordDelimiter(const SelectObjectContentRequest& request)
+        {
+            const OutputSerialization& output = request.GetOutputSerialization();
+            const Aws::String& recordDelimiter = output.JSONHasBeenSet() ? output.GetJSON().GetRecordDelimiter() : output.GetCSV().GetRecordDelimiter();
+            return recordDelimiter.empty() ? Aws::String("\n") : recordDelimiter;
+        }
+
+        ParallelSelectOutcome ParallelObjectSelector::Select(const SelectObjectContentRequest& request, const RecordsCallback& onRecords,
+            const ProgressCallback& onProgress) const
+        {
+            uint64_t objectSize = 0;
+            size_t rangeCount = 1;
+            if (SupportsScanRanges(request))
+            {
+                HeadObjectRequest headObjectRequest;
+                headObjectRequest.WithBucket(request.GetBucket()).WithKey(request.GetKey());
+                if (request.SSECustomerAlgorithmHasBeenSet())
+                {
+                    headObjectRequest.SetSSECustomerAlgorithm(request.GetSSECustomerAlgorithm());
+                }
+                if (request.SSECustomerKeyHasBeenSet())
+                {
+                    headObjectRequest.SetSSECustomerKey(request.GetSSECustomerKey());
+                }
+                if (request.SSECustomerKeyMD5HasBeenSet())
+                {
+                    headObjectRequest.SetSSECustomerKeyMD5(request.GetSSECustomerKeyMD5());
+                }
+                auto headObjectOutcome = m_configuration.s3Client->HeadObject(headObjectRequest);
+                if (!headObjectOutcome.IsSuccess())
+                {
+                    AWS_LOGSTREAM_ERROR(PARALLEL_SELECTOR_TAG, "Failed to get the size of Bucket: [" << request.GetBucket() << "] with Key: ["
+                            << request.GetKey() << "]. " << headObjectOutcome.GetError());
+                    return ParallelSelectOutcome(headObjectOutcome.GetError());
+                }
+                objectSize = static_cast<uint64_t>(headObjectOutcome.GetResult().GetContentLength());
+                rangeCount = static_cast<size_t>((std::max)((objectSize + m_configuration.scanRangeSize - 1) / m_configuration.scanRangeSize, static_cast<uint64_t>(1)));
+            }
+            AWS_LOGSTREAM_DEBUG(PARALLEL_SELECTOR_TAG, "Selecting from Bucket: [" << request.GetBucket() << "] with Key: [" << request.GetKey()
+                    << "] in " << rangeCount << " scan ranges.");
+
+            auto state = Aws::MakeShared<ParallelSelectState>(PARALLEL_SELECTOR_TAG, rangeCount);
+            bool inObjectOrder = m_configuration.recordsOrder == SelectRecordsOrder::OBJECT_ORDER;
+            Aws::String recordDelimiter = GetRecordDelimiter(request);
+            for (size_t rangeIndex = 0; rangeIndex < rangeCount; ++rangeIndex)
+            {
+                {
+                    std::unique_lock<std::mutex> locker(state->lock);
+                    state->rangeFinished.wait(locker, [this, &state]() { return state->failed || state->inFlight < m_configuration.maxConcurrentRanges; });
+                    if (state->failed)
+                    {
+                        break;
+                    }
+                    ++state->inFlight;
+                }
+
+                auto rangeRequest = Aws::MakeShared<SelectObjectContentRequest>(PARALLEL_SELECTOR_TAG);
+                CopyQuery(request, *rangeRequest);
+                if (rangeCount > 1)
+                {
+                    uint64_t start = rangeIndex * m_configuration.scanRangeSize;
+                    uint64_t end = (std::min)(start + m_configuration.scanRangeSize, objectSize) - 1;
+                    rangeRequest->SetScanRange(ScanRange().WithStart(static_cast<long long>(start)).WithEnd(static_cast<long long>(end)));
+                }
+                rangeRequest->SetContinueRequestHandler([state](const Aws::Http::HttpRequest*) { return !state->failed; });
+
+                SelectObjectContentHandler handler;
+                handler.SetRecordsPayloadCallback([state, rangeIndex, inObjectOrder, recordDelimiter, onRecords](const unsigned char* payload, size_t length)
+                {
+                    std::lock_guard<std::mutex> locker(state->lock);
+                    if (state->failed)
+                    {
+                        return;
+                    }
+                    if (inObjectOrder && rangeIndex == state->firstUndelivered)
+                    {
+                        onRecords(payload, length);
+                        return;
+                    }
+                    auto& heldRecords = state->ranges[rangeIndex].heldRecords;
+                    size_t searchFrom = heldRecords.size() < recordDelimiter.size() ? 0 : heldRecords.size() - recordDelimiter.size() + 1;
+                    heldRecords.insert(heldRecords.end(), payload, payload + length);
+                    if (inObjectOrder)
+                    {
+                        return;
+                    }
+                    // a Records event may end in the middle of a record, and another range's records must not land inside it
+                    auto lastDelimiter = std::find_end(heldRecords.begin() + searchFrom, heldRecords.end(), recordDelimiter.begin(), recordDelimiter.end());
+                    if (lastDelimiter != heldRecords.end())
+                    {
+                        size_t completeLength = static_cast<size_t>(lastDelimiter - heldRecords.begin()) + recordDelimiter.size();
+                        onRecords(heldRecords.data(), completeLength);
+                        heldRecords.erase(heldRecords.begin(), heldRecords.begin() + completeLength);
+                    }
+                });
+                handler.SetStatsEventCallback([state](const StatsEvent& event)
+                {
+                    std::lock_guard<std::mutex> locker(state->lock);
+                    Stats& stats = state->stats;
+                    stats.SetBytesScanned(stats.GetBytesScanned() + event.GetDetails().GetBytesScanned());
+                    stats.SetBytesProcessed(stats.GetBytesProcessed() + event.GetDetails().GetBytesProcessed());
+                    stats.SetBytesReturned(stats.GetBytesReturned() + event.GetDetails().GetBytesReturned());
+                });
+                handler.SetProgressEventCallback([state, rangeIndex, onProgress](const ProgressEvent& event)
+                {
+                    std::lock_guard<std::mutex> locker(state->lock);
+                    state->ranges[rangeIndex].progress = event.GetDetails();
+                    if (!onProgress || state->failed)
+                    {
+                        return;
+                    }
+                    Progress total;
+                    total.WithBytesScanned(0).WithBytesProcessed(0).WithBytesReturned(0);
+                    for (const auto& range : state->ranges)
+                    {
+                        total.SetBytesScanned(total.GetBytesScanned() + range.progress.GetBytesScanned());
+                        total.SetBytesProcessed(total.GetBytesProcessed() + range.progress.GetBytesProcessed());
+                        total.SetBytesReturned(total.GetBytesReturned() + range.progress.GetBytesReturned());
+                    }
+                    onProgress(total);
+                });
+                handler.SetEndEventCallback([state, rangeIndex]()
+                {
+                    std::lock_guard<std::mutex> locker(state->lock);
+                    state->ranges[rangeIndex].ended = true;
+                });
+                handler.SetOnErrorCallback([state](const Aws::Client::AWSError<Aws::S3::S3Errors>& error)
+                {
+                    std::lock_guard<std::mutex> locker(state->lock);
+                    state->Fail(error);
+                });
+                rangeRequest->SetEventStreamHandler(handler);
+
+                auto callback = [state, rangeIndex, rangeRequest, inObjectOrder, onRecords](const Aws::S3::S3Client*, const SelectObjectContentRequest& selectRequest,
+                    const SelectObjectContentOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+                {
+                    std::lock_guard<std::mutex> locker(state->lock);
+                    --state->inFlight;
+                    if (!outcome.IsSuccess())
+                    {
+                        AWS_LOGSTREAM_ERROR(PARALLEL_SELECTOR_TAG, "Failed to select scan range " << selectRequest.GetScanRange().GetStart() << "-"
+                                << selectRequest.GetScanRange().GetEnd() << " of Bucket: [" << selectRequest.GetBucket() << "] with Key: ["
+                                << selectRequest.GetKey() << "]. " << outcome.GetError());
+                        state->Fail(outcome.GetError());
+                    }
+                    else if (!state->ranges[rangeIndex].ended)
+                    {
+                        // the stream was cut off; S3 Select always ends a complete one with an End event
+                        state->Fail(Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::NETWORK_CONNECTION, "IncompleteSelect",
+                                "Select response ended without an End event", true));
+                    }
+                    else
+                    {
+                        state->ranges[rangeIndex].done = true;
+                        auto& heldRecords = state->ranges[rangeIndex].heldRecords;
+                        if (!inObjectOrder && !heldRecords.empty() && !state->failed)
+                        {
+                            // the last record of the object need not end with a delimiter
+                            onRecords(heldRecords.data(), heldRecords.size());
+                            Aws::Vector<unsigned char>().swap(heldRecords);
+                        }
+                        while (inObjectOrder && state->firstUndelivered < state->ranges.size() && state->ranges[state->firstUndelivered].done)
+                        {
+                            // the next range's records are up; hand over what it has held so far, and the rest as it arrives
+                            if (++state->firstUndelivered < state->ranges.size() && !state->failed)
+                            {
+                                auto& heldRecords = state->ranges[state->firstUndelivered].heldRecords;
+                                if (!heldRecords.empty())
+                                {
+                                    onRecords(heldRecords.data(), heldRecords.size());
+                                }
+                                Aws::Vector<unsigned char>().swap(heldRecords);
+                            }
+                        }
+                    }
+                    state->rangeFinished.notify_all();
+                };
+
+                m_configuration.s3Client->SelectObjectContentAsync(*rangeRequest, callback);
+            }
+
+            std::unique_lock<std::mutex> locker(state->lock);
+            state->rangeFinished.wait(locker, [&state]() { return state->inFlight == 0; });
+            if (state->failed)
+            {
+                return ParallelSelectOutcome(state->error);
+            }
+            return ParallelSelectOutcome(state->stats);
+        }
+    }
+}
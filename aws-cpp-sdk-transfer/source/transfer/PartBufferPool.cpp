@@ -0,0 +1,217 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include <aws/transfer/PartBufferPool.h>
+#include <aws/core/utils/memory/stl/AWSStreamFwd.h>
+#include <aws/core/utils/logging/LogMacros.h>
+
+#include <cstdlib>
+#include <fstream>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        static const char* BUFFER_POOL_TAG = "HugePagePartBufferPool";
+        static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+        /**
+         * A part buffer that remembers the node it was allocated for and, if it was mapped on its own, the mapping to undo.
+         */
+        class PoolBuffer : public Aws::Utils::Array<uint8_t>
+        {
+        public:
+            PoolBuffer(size_t size, size_t node) : Aws::Utils::Array<uint8_t>(size), m_node(node), m_mappedSize(0)
+            {
+            }
+
+            PoolBuffer(uint8_t* pages, size_t mappedSize, size_t size, size_t node) : m_node(node), m_mappedSize(mappedSize)
+            {
+                m_size = size;
+                m_data.reset(pages);
+            }
+
+            ~PoolBuffer()
+            {
+#ifdef __linux__
+                if (m_mappedSize)
+                {
+                    munmap(m_data.release(), m_mappedSize);
+                }
+#endif
+            }
+
+            inline size_t GetNode() const { return m_node; }
+            inline bool IsMapped() const { return m_mappedSize > 0; }
+
+        private:
+            size_t m_node;
+            size_t m_mappedSize;
+        };
+
+        /**
+         * Counts the nodes in /sys/devices/system/node/possible, which lists them as ranges such as "0-3".
+         */
+        static size_t CountNumaNodes()
+        {
+#ifdef __linux__
+            Aws::IFStream possible("/sys/devices/system/node/possible");
+            Aws::String nodes;
+            if (possible && std::getline(possible, nodes) && !nodes.empty())
+            {
+                auto last = nodes.find_last_of("-,");
+                auto highestNode = strtoul(nodes.c_str() + (last == Aws::String::npos ? 0 : last + 1), nullptr, 10);
+                return static_cast<size_t>(highestNode) + 1;
+            }
+#endif
+            return 1;
+        }
+
+        HugePagePartBufferPool::HugePagePartBufferPool(uint64_t maxIdleBytesPerNode) :
+            m_maxIdleBytesPerNode(maxIdleBytesPerNode),
+            m_nodeCount(CountNumaNodes()),
+            m_nodes(Aws::MakeUniqueArray<NodeFreeList>(m_nodeCount, BUFFER_POOL_TAG)),
+            m_allocatedBuffers(0),
+            m_mappedBuffers(0)
+        {
+        }
+
+        HugePagePartBufferPool::~HugePagePartBufferPool()
+        {
+            for (size_t node = 0; node < m_nodeCount; ++node)
+            {
+                for (auto& idleBuffers : m_nodes.get()[node].idleBuffers)
+                {
+                    for (auto buffer : idleBuffers.second)
+                    {
+                        Free(buffer);
+                    }
+                }
+            }
+        }
+
+        Aws::Utils::Array<uint8_t>* HugePagePartBufferPool::Acquire(size_t bufferSize)
+        {
+            auto node = GetCurrentNode();
+            auto& freeList = m_nodes.get()[node];
+            {
+                std::lock_guard<std::mutex> locker(freeList.lock);
+                auto idleBuffers = freeList.idleBuffers.find(bufferSize);
+                if (idleBuffers != freeList.idleBuffers.end() && !idleBuffers->second.empty())
+                {
+                    auto buffer = idleBuffers->second.back();
+                    idleBuffers->second.pop_back();
+                    freeList.idleBytes -= bufferSize;
+                    return buffer;
+                }
+            }
+            return Allocate(bufferSize, node);
+        }
+
+        void HugePagePartBufferPool::Release(Aws::Utils::Array<uint8_t>* buffer)
+        {
+            auto& freeList = m_nodes.get()[static_cast<PoolBuffer*>(buffer)->GetNode()];
+            {
+                std::lock_guard<std::mutex> locker(freeList.lock);
+                if (freeList.idleBytes + buffer->GetLength() <= m_maxIdleBytesPerNode)
+                {
+                    freeList.idleBuffers[buffer->GetLength()].push_back(buffer);
+                    freeList.idleBytes += buffer->GetLength();
+                    return;
+                }
+            }
+            Free(buffer);
+        }
+
+        size_t HugePagePartBufferPool::GetCurrentNode() const
+        {
+#ifdef __linux__
+            unsigned cpu = 0;
+            unsigned node = 0;
+            if (m_nodeCount > 1 && syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+            {
+                return static_cast<size_t>(node) % m_nodeCount;
+            }
+#endif
+            return 0;
+        }
+
+        Aws::Utils::Array<uint8_t>* HugePagePartBufferPool::Allocate(size_t bufferSize, size_t node)
+        {
+            ++m_allocatedBuffers;
+#ifdef __linux__
+            if (bufferSize >= HUGE_PAGE_SIZE)
+            {
+                size_t mappedSize = (bufferSize + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+                void* pages = MAP_FAILED;
+#ifdef MAP_HUGETLB
+                pages = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+                if (pages == MAP_FAILED)
+                {
+                    // no huge pages reserved; map ordinary pages and ask for transparent huge pages instead, aligned so that every 2MB of the
+                    // buffer can be one
+                    void* mapping = mmap(nullptr, mappedSize + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    if (mapping != MAP_FAILED)
+                    {
+                        auto start = reinterpret_cast<uintptr_t>(mapping);
+                        auto alignedStart = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+                        if (alignedStart > start)
+                        {
+                            munmap(mapping, alignedStart - start);
+                        }
+                        munmap(reinterpret_cast<void*>(alignedStart + mappedSize), start + HUGE_PAGE_SIZE - alignedStart);
+                        pages = reinterpret_cast<void*>(alignedStart);
+#ifdef MADV_HUGEPAGE
+                        madvise(pages, mappedSize, MADV_HUGEPAGE);
+#endif
+                    }
+                }
+
+                if (pages != MAP_FAILED)
+                {
+                    // the first write to a page places it on the node of the writing thread, which is the node the buffer is for
+                    auto bytes = static_cast<uint8_t*>(pages);
+                    for (size_t offset = 0; offset < mappedSize; offset += 4096)
+                    {
+                        bytes[offset] = 0;
+                    }
+                    ++m_mappedBuffers;
+                    return Aws::New<PoolBuffer>(BUFFER_POOL_TAG, bytes, mappedSize, bufferSize, node);
+                }
+                AWS_LOGSTREAM_WARN(BUFFER_POOL_TAG, "Failed to map " << mappedSize << " bytes for a part buffer, allocating it from the heap.");
+            }
+#endif
+            return Aws::New<PoolBuffer>(BUFFER_POOL_TAG, bufferSize, node);
+        }
+
+        void HugePagePartBufferPool::Free(Aws::Utils::Array<uint8_t>* buffer)
+        {
+            auto poolBuffer = static_cast<PoolBuffer*>(buffer);
+            if (poolBuffer->IsMapped())
+            {
+                --m_mappedBuffers;
+            }
+            --m_allocatedBuffers;
+            Aws::Delete(poolBuffer);
+        }
+    }
+}
@@ -0,0 +1,228 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include <aws/transfer/PartConcurrencyTuner.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        static const uint64_t MAX_PART_SIZE = 5ULL * 1024 * 1024 * 1024;
+
+        // during startup the limit keeps doubling while each round is at least 25% faster than the best one so far
+        static const double STARTUP_GROWTH = 1.25;
+        static const size_t STARTUP_ROUNDS_WITHOUT_GROWTH = 3;
+        // headroom over the bandwidth-delay product, so that a part finishing doesn't leave the link idle
+        static const double LIMIT_GAIN = 1.25;
+        static const size_t PROBE_INTERVAL_ROUNDS = 8;
+        static const double PROBE_GAIN = 1.25;
+        // a limit above the bandwidth-delay product queues parts and inflates their transfer time, which would in turn inflate the estimate
+        // once the real minimum drops out of the filter, so the limit is halved for two rounds well within the filter's length
+        static const size_t DRAIN_INTERVAL_ROUNDS = 30;
+        static const double DRAIN_GAIN = 0.5;
+        static const double FAILURE_BACKOFF = 0.75;
+
+        PartConcurrencyTuner::PartConcurrencyTuner(size_t minInFlightParts, size_t maxInFlightParts, uint64_t memoryBudget) :
+            m_minInFlightParts((std::max)(static_cast<size_t>(1), minInFlightParts)),
+            m_maxInFlightParts((std::max)(m_minInFlightParts, maxInFlightParts)),
+            m_memoryBudget(memoryBudget),
+            m_inFlightLimit(m_minInFlightParts),
+            m_partsInFlight(0),
+            m_bytesInFlight(0),
+            m_startup(true),
+            m_roundsWithoutGrowth(0),
+            m_roundsSinceProbe(0),
+            m_roundsSinceDrain(0),
+            m_drainRoundsLeft(0),
+            m_roundStart(std::chrono::steady_clock::now()),
+            m_roundTarget(m_minInFlightParts),
+            m_roundParts(0),
+            m_roundBytes(0),
+            m_roundMinSeconds(0),
+            m_rounds(0),
+            m_bestThroughput(0),
+            m_averagePartSize(0)
+        {
+            std::fill(m_throughputs, m_throughputs + THROUGHPUT_FILTER_LENGTH, 0.0);
+            std::fill(m_partSeconds, m_partSeconds + PART_SECONDS_FILTER_LENGTH, 0.0);
+        }
+
+        void PartConcurrencyTuner::AcquirePart(uint64_t partSize)
+        {
+            std::unique_lock<std::mutex> locker(m_lock);
+            m_partReleased.wait(locker, [this, partSize]()
+            {
+                return m_partsInFlight == 0 ||
+                    (m_partsInFlight < m_inFlightLimit && (m_memoryBudget == 0 || m_bytesInFlight + partSize <= m_memoryBudget));
+            });
+
+            // time spent idle between transfers says nothing about the link, so start the round over
+            if (m_partsInFlight == 0)
+            {
+                m_roundStart = std::chrono::steady_clock::now();
+                m_roundTarget = m_inFlightLimit;
+                m_roundParts = 0;
+                m_roundBytes = 0;
+                m_roundMinSeconds = 0;
+            }
+
+            ++m_partsInFlight;
+            m_bytesInFlight += partSize;
+        }
+
+        void PartConcurrencyTuner::ReleasePart(uint64_t partSize)
+        {
+            {
+                std::lock_guard<std::mutex> locker(m_lock);
+                assert(m_partsInFlight > 0);
+                --m_partsInFlight;
+                m_bytesInFlight -= (std::min)(partSize, m_bytesInFlight);
+            }
+            m_partReleased.notify_all();
+        }
+
+        void PartConcurrencyTuner::RecordPart(uint64_t partSize, std::chrono::steady_clock::duration elapsed, bool succeeded,
+                                              std::chrono::steady_clock::time_point now)
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            if (!succeeded)
+            {
+                m_inFlightLimit = ClampLimit(static_cast<double>(m_inFlightLimit) * FAILURE_BACKOFF);
+                m_startup = false;
+                return;
+            }
+
+            double seconds = std::chrono::duration<double>(elapsed).count();
+            if (m_roundMinSeconds <= 0 || seconds < m_roundMinSeconds)
+            {
+                m_roundMinSeconds = seconds;
+            }
+            m_averagePartSize = m_averagePartSize <= 0 ? static_cast<double>(partSize) : 0.9 * m_averagePartSize + 0.1 * static_cast<double>(partSize);
+            m_roundBytes += partSize;
+
+            if (++m_roundParts >= m_roundTarget)
+            {
+                EndRound(now);
+                // the limit may have grown
+                m_partReleased.notify_all();
+            }
+        }
+
+        void PartConcurrencyTuner::EndRound(std::chrono::steady_clock::time_point now)
+        {
+            // parts that were started late in the previous round can all finish at once, which says nothing about throughput,
+            // so a round never counts as shorter than its fastest part
+            double roundSeconds = (std::max)(std::chrono::duration<double>(now - m_roundStart).count(), m_roundMinSeconds);
+            double throughput = roundSeconds > 0 ? static_cast<double>(m_roundBytes) / roundSeconds : 0;
+
+            m_throughputs[m_rounds % THROUGHPUT_FILTER_LENGTH] = throughput;
+            m_partSeconds[m_rounds % PART_SECONDS_FILTER_LENGTH] = m_roundMinSeconds;
+            ++m_rounds;
+
+            double maxThroughput = *std::max_element(m_throughputs, m_throughputs + THROUGHPUT_FILTER_LENGTH);
+            double minPartSeconds = 0;
+            for (size_t i = 0; i < PART_SECONDS_FILTER_LENGTH; ++i)
+            {
+                if (m_partSeconds[i] > 0 && (minPartSeconds <= 0 || m_partSeconds[i] < minPartSeconds))
+                {
+                    minPartSeconds = m_partSeconds[i];
+                }
+            }
+
+            if (m_startup)
+            {
+                if (throughput >= m_bestThroughput * STARTUP_GROWTH)
+                {
+                    m_roundsWithoutGrowth = 0;
+                    m_inFlightLimit = ClampLimit(static_cast<double>(m_inFlightLimit) * 2);
+                }
+                else if (++m_roundsWithoutGrowth >= STARTUP_ROUNDS_WITHOUT_GROWTH)
+                {
+                    m_startup = false;
+                }
+                m_bestThroughput = (std::max)(m_bestThroughput, throughput);
+            }
+
+            if (!m_startup && m_averagePartSize > 0)
+            {
+                double bandwidthDelayProduct = maxThroughput * minPartSeconds / m_averagePartSize;
+                if (m_drainRoundsLeft > 0)
+                {
+                    --m_drainRoundsLeft;
+                    m_inFlightLimit = ClampLimit(bandwidthDelayProduct * DRAIN_GAIN);
+                }
+                else if (++m_roundsSinceDrain >= DRAIN_INTERVAL_ROUNDS)
+                {
+                    m_roundsSinceDrain = 0;
+                    m_drainRoundsLeft = 1;
+                    m_inFlightLimit = ClampLimit(bandwidthDelayProduct * DRAIN_GAIN);
+                }
+                else if (++m_roundsSinceProbe >= PROBE_INTERVAL_ROUNDS)
+                {
+                    // if the link has more to give, the probe round raises the max throughput and with it the next estimate
+                    m_roundsSinceProbe = 0;
+                    m_inFlightLimit = ClampLimit((std::max)(bandwidthDelayProduct * LIMIT_GAIN, static_cast<double>(m_inFlightLimit)) * PROBE_GAIN + 1);
+                }
+                else
+                {
+                    m_inFlightLimit = ClampLimit(bandwidthDelayProduct * LIMIT_GAIN);
+                }
+            }
+
+            m_roundStart = now;
+            m_roundTarget = m_inFlightLimit;
+            m_roundParts = 0;
+            m_roundBytes = 0;
+            m_roundMinSeconds = 0;
+        }
+
+        size_t PartConcurrencyTuner::ClampLimit(double limit) const
+        {
+            // a limit the memory budget can't back would only park parts in AcquirePart
+            double maxLimit = static_cast<double>(m_maxInFlightParts);
+            if (m_memoryBudget > 0 && m_averagePartSize > 0)
+            {
+                maxLimit = (std::min)(maxLimit, std::floor(static_cast<double>(m_memoryBudget) / m_averagePartSize));
+            }
+
+            double rounded = (std::min)(std::ceil(limit), maxLimit);
+            if (!(rounded >= static_cast<double>(m_minInFlightParts)))
+            {
+                return m_minInFlightParts;
+            }
+            return static_cast<size_t>(rounded);
+        }
+
+        size_t PartConcurrencyTuner::GetInFlightLimit() const
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            return m_inFlightLimit;
+        }
+
+        uint64_t PartConcurrencyTuner::ComputePartSize(uint64_t objectSize, uint64_t minPartSize, size_t maxPartCount)
+        {
+            minPartSize = (std::max)(static_cast<uint64_t>(1), minPartSize);
+            maxPartCount = (std::max)(static_cast<size_t>(1), maxPartCount);
+
+            uint64_t requiredPartSize = (objectSize + maxPartCount - 1) / maxPartCount;
+            uint64_t partSize = (std::max)(minPartSize, (requiredPartSize + minPartSize - 1) / minPartSize * minPartSize);
+            return (std::min)(partSize, (std::max)(minPartSize, MAX_PART_SIZE));
+        }
+    }
+}
@@ -0,0 +1,234 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include <aws/transfer/RangedObjectReader.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/memory/AWSMemory.h>
+#include <aws/core/utils/stream/ResponseStream.h>
+#include <aws/core/utils/logging/LogMacros.h>
+#include <aws/s3/S3Client.h>
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <streambuf>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        static const char* RANGED_READER_TAG = "RangedObjectReader";
+
+        /**
+         * Takes the response body of a GetObject for the bytes from start to end of the object, and copies each byte into every piece that
+         * covers it. Bytes no piece covers are dropped. Pieces are sorted by offset.
+         */
+        class RangeScatterStreamBuf : public std::streambuf
+        {
+        public:
+            RangeScatterStreamBuf(uint64_t start, uint64_t end, const std::shared_ptr<const Aws::Vector<RangeRead>>& pieces) :
+                m_position(start), m_end(end), m_pieces(pieces), m_firstPiece(0)
+            {
+            }
+
+        protected:
+            std::streamsize xsputn(const char* data, std::streamsize count) override
+            {
+                uint64_t writeEnd = m_position + (std::min)(static_cast<uint64_t>(count), m_end - m_position);
+                const auto& pieces = *m_pieces;
+                while (m_firstPiece < pieces.size() && pieces[m_firstPiece].offset + pieces[m_firstPiece].length <= m_position)
+                {
+                    ++m_firstPiece;
+                }
+
+                for (size_t i = m_firstPiece; i < pieces.size() && pieces[i].offset < writeEnd; ++i)
+                {
+                    uint64_t from = (std::max)(pieces[i].offset, m_position);
+                    uint64_t to = (std::min)(pieces[i].offset + pieces[i].length, writeEnd);
+                    if (from < to)
+                    {
+                        memcpy(pieces[i].buffer + (from - pieces[i].offset), data + (from - m_position), static_cast<size_t>(to - from));
+                    }
+                }
+
+                auto written = static_cast<std::streamsize>(writeEnd - m_position);
+                m_position = writeEnd;
+                return written;
+            }
+
+            int_type overflow(int_type c) override
+            {
+                if (traits_type::eq_int_type(c, traits_type::eof()))
+                {
+                    return traits_type::not_eof(c);
+                }
+                char byte = traits_type::to_char_type(c);
+                return xsputn(&byte, 1) == 1 ? c : traits_type::eof();
+            }
+
+        private:
+            uint64_t m_position;
+            const uint64_t m_end;
+            std::shared_ptr<const Aws::Vector<RangeRead>> m_pieces;
+            size_t m_firstPiece;
+        };
+
+        /**
+         * What the GetObjects of one Read call share.
+         */
+        struct RangedReadState
+        {
+            RangedReadState() : inFlight(0), failed(false) {}
+
+            std::mutex lock;
+            std::condition_variable requestFinished;
+            size_t inFlight;
+            bool failed;
+            Aws::Client::AWSError<Aws::S3::S3Errors> error;
+            Aws::String eTag;
+        };
+
+        RangedObjectReader::RangedObjectReader(const RangedObjectReaderConfiguration& configuration) : m_configuration(configuration)
+        {
+            assert(m_configuration.s3Client);
+            assert(m_configuration.subRangeSize > 0);
+            assert(m_configuration.maxInFlightRequests > 0);
+        }
+
+        RangedReadOutcome RangedObjectReader::Read(const Aws::String& bucketName, const Aws::String& keyName, uint64_t offset, uint64_t length, uint8_t* buffer) const
+        {
+            return Read(bucketName, keyName, Aws::Vector<RangeRead>(1, RangeRead(offset, length, buffer)));
+        }
+
+        RangedReadOutcome RangedObjectReader::Read(const Aws::String& bucketName, const Aws::String& keyName, const Aws::Vector<RangeRead>& ranges) const
+        {
+            Aws::Vector<RangeRead> sortedRanges;
+            for (const auto& range : ranges)
+            {
+                if (range.length > 0)
+                {
+                    sortedRanges.push_back(range);
+                }
+            }
+            std::sort(sortedRanges.begin(), sortedRanges.end(), [](const RangeRead& left, const RangeRead& right) { return left.offset < right.offset; });
+
+            auto state = Aws::MakeShared<RangedReadState>(RANGED_READER_TAG);
+            size_t spanBegin = 0;
+            bool stopped = false;
+            while (spanBegin < sortedRanges.size() && !stopped)
+            {
+                // ranges closer than coalesceGap to the span so far join it
+                uint64_t spanStart = sortedRanges[spanBegin].offset;
+                uint64_t spanEnd = spanStart + sortedRanges[spanBegin].length;
+                size_t spanFinish = spanBegin + 1;
+                while (spanFinish < sortedRanges.size() && sortedRanges[spanFinish].offset <= spanEnd + m_configuration.coalesceGap)
+                {
+                    spanEnd = (std::max)(spanEnd, sortedRanges[spanFinish].offset + sortedRanges[spanFinish].length);
+                    ++spanFinish;
+                }
+
+                uint64_t requestCount = (spanEnd - spanStart + m_configuration.subRangeSize - 1) / m_configuration.subRangeSize;
+                uint64_t requestSize = (spanEnd - spanStart + requestCount - 1) / requestCount;
+                for (uint64_t requestStart = spanStart; requestStart < spanEnd; requestStart += requestSize)
+                {
+                    uint64_t requestEnd = (std::min)(requestStart + requestSize, spanEnd);
+                    auto pieces = Aws::MakeShared<Aws::Vector<RangeRead>>(RANGED_READER_TAG);
+                    for (size_t i = spanBegin; i < spanFinish && sortedRanges[i].offset < requestEnd; ++i)
+                    {
+                        const auto& range = sortedRanges[i];
+                        uint64_t from = (std::max)(range.offset, requestStart);
+                        uint64_t to = (std::min)(range.offset + range.length, requestEnd);
+                        if (from < to)
+                        {
+                            pieces->emplace_back(from, to - from, range.buffer + (from - range.offset));
+                        }
+                    }
+                    if (pieces->empty())
+                    {
+                        // all of this request would fall between ranges
+                        continue;
+                    }
+
+                    {
+                        std::unique_lock<std::mutex> locker(state->lock);
+                        state->requestFinished.wait(locker, [this, &state]() { return state->failed || state->inFlight < m_configuration.maxInFlightRequests; });
+                        stopped = state->failed;
+                        if (stopped)
+                        {
+                            break;
+                        }
+                        ++state->inFlight;
+                    }
+
+                    Aws::S3::Model::GetObjectRequest request = m_configuration.getObjectTemplate;
+                    request.WithBucket(bucketName)
+                        .WithKey(keyName)
+                        .SetRange("bytes=" + Aws::Utils::StringUtils::to_string(requestStart) + "-" + Aws::Utils::StringUtils::to_string(requestEnd - 1));
+                    std::shared_ptr<const Aws::Vector<RangeRead>> requestPieces = pieces;
+                    request.SetResponseStreamFactory([requestStart, requestEnd, requestPieces]()
+                    {
+                        return Aws::New<Aws::Utils::Stream::DefaultUnderlyingStream>(RANGED_READER_TAG,
+                                Aws::MakeUnique<RangeScatterStreamBuf>(RANGED_READER_TAG, requestStart, requestEnd, requestPieces));
+                    });
+
+                    auto callback = [state, requestStart, requestEnd](const Aws::S3::S3Client*, const Aws::S3::Model::GetObjectRequest& request,
+                        const Aws::S3::Model::GetObjectOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+                    {
+                        std::lock_guard<std::mutex> locker(state->lock);
+                        --state->inFlight;
+                        if (!outcome.IsSuccess())
+                        {
+                            AWS_LOGSTREAM_ERROR(RANGED_READER_TAG, "Failed to read " << request.GetRange() << " of Bucket: [" << request.GetBucket()
+                                    << "] with Key: [" << request.GetKey() << "]. " << outcome.GetError());
+                            state->error = outcome.GetError();
+                            state->failed = true;
+                        }
+                        else if (outcome.GetResult().GetContentLength() != static_cast<long long>(requestEnd - requestStart))
+                        {
+                            state->error = Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INVALID_PARAMETER_VALUE, "InvalidRange",
+                                    "Got " + Aws::Utils::StringUtils::to_string(outcome.GetResult().GetContentLength()) + " bytes for " + request.GetRange(), false);
+                            state->failed = true;
+                        }
+                        else if (state->eTag.empty())
+                        {
+                            state->eTag = outcome.GetResult().GetETag();
+                        }
+                        else if (state->eTag != outcome.GetResult().GetETag())
+                        {
+                            // the object was replaced while it was being read
+                            state->error = Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INVALID_PARAMETER_VALUE, "PreconditionFailed",
+                                    "Object changed from ETag " + state->eTag + " to " + outcome.GetResult().GetETag() + " while it was read", false);
+                            state->failed = true;
+                        }
+                        state->requestFinished.notify_all();
+                    };
+
+                    m_configuration.s3Client->GetObjectAsync(request, callback);
+                }
+                spanBegin = spanFinish;
+            }
+
+            std::unique_lock<std::mutex> locker(state->lock);
+            state->requestFinished.wait(locker, [&state]() { return state->inFlight == 0; });
+            if (state->failed)
+            {
+                return RangedReadOutcome(state->error);
+            }
+            return RangedReadOutcome(Aws::NoResult());
+        }
+    }
+}
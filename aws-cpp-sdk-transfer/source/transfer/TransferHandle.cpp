@@ -16,6 +16,7 @@
 #include <aws/transfer/TransferHandle.h>
 #include <aws/core/utils/logging/LogMacros.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace Aws
@@ -56,24 +57,26 @@ namespace Aws
         void PartState::OnDataTransferred(long long amount, const std::shared_ptr<TransferHandle> &transferHandle)
         {
             m_currentProgressInBytes += static_cast<size_t>(amount);
-            if (m_currentProgressInBytes > m_bestProgressInBytes)
+            // an encrypted part sends or receives a little more than its own bytes, which is all the progress it makes
+            size_t progressInBytes = (std::min)(m_currentProgressInBytes, m_sizeInBytes);
+            if (progressInBytes > m_bestProgressInBytes)
             {
-                transferHandle->UpdateBytesTransferred(m_currentProgressInBytes - m_bestProgressInBytes);
-                m_bestProgressInBytes = m_currentProgressInBytes;
+                transferHandle->UpdateBytesTransferred(progressInBytes - m_bestProgressInBytes);
+                m_bestProgressInBytes = progressInBytes;
                 AWS_LOGSTREAM_TRACE(CLASS_TAG, "Transfer handle ID [" << transferHandle->GetId() << "] "
                         << m_bestProgressInBytes << " bytes transferred for part [" << m_partId << "].");
             }
         }
 
-        PartStateMap TransferHandle::GetCompletedParts() const
-        {
-            std::lock_guard<std::mutex> locker(m_partsLock);
-            return m_completedParts;
-        }
-
         TransferHandle::TransferHandle(const Aws::String& bucketName, const Aws::String& keyName, uint64_t totalSize, const Aws::String& targetFilePath) : 
             m_isMultipart(false), 
             m_direction(TransferDirection::UPLOAD), 
+            m_queuedPartCount(0),
+            m_pendingPartCount(0),
+            m_failedPartCount(0),
+            m_completedPartCount(0),
+            m_partSize(0),
+            m_inFlightPartLimit(0),
             m_bytesTransferred(0), 
             m_lastPart(false),
             m_bytesTotalSize(totalSize),
@@ -91,6 +94,12 @@ namespace Aws
         TransferHandle::TransferHandle(const Aws::String& bucketName, const Aws::String& keyName, const Aws::String& targetFilePath) :
             m_isMultipart(false), 
             m_direction(TransferDirection::DOWNLOAD), 
+            m_queuedPartCount(0),
+            m_pendingPartCount(0),
+            m_failedPartCount(0),
+            m_completedPartCount(0),
+            m_partSize(0),
+            m_inFlightPartLimit(0),
             m_bytesTransferred(0), 
             m_lastPart(false),
             m_bytesTotalSize(0),
@@ -108,6 +117,12 @@ namespace Aws
         TransferHandle::TransferHandle(const Aws::String& bucketName, const Aws::String& keyName, CreateDownloadStreamCallback createDownloadStreamFn, const Aws::String& targetFilePath) :
             m_isMultipart(false), 
             m_direction(TransferDirection::DOWNLOAD), 
+            m_queuedPartCount(0),
+            m_pendingPartCount(0),
+            m_failedPartCount(0),
+            m_completedPartCount(0),
+            m_partSize(0),
+            m_inFlightPartLimit(0),
             m_bytesTransferred(0), 
             m_lastPart(false),
             m_bytesTotalSize(0),
@@ -127,21 +142,73 @@ namespace Aws
             CleanupDownloadStream();
         }
 
-        void TransferHandle::ChangePartToCompleted(const PartPointer& partState, const Aws::String &eTag)
+        std::atomic<size_t>& TransferHandle::GetPartCount(PartSlotState state)
+        {
+            switch (state)
+            {
+                case PartSlotState::QUEUED:
+                    return m_queuedPartCount;
+                case PartSlotState::PENDING:
+                    return m_pendingPartCount;
+                case PartSlotState::FAILED:
+                    return m_failedPartCount;
+                default:
+                    assert(state == PartSlotState::COMPLETED);
+                    return m_completedPartCount;
+            }
+        }
+
+        void TransferHandle::MovePart(const PartPointer& partState, PartSlotState nextState)
         {
-            std::lock_guard<std::mutex> locker(m_partsLock);
             const auto partId = partState->GetPartId();
-            if (!m_pendingParts.erase(partId))
+            assert(partId > 0);
+            const auto index = static_cast<size_t>(partId - 1);
+            if (index >= m_parts.size())
+            {
+                m_parts.resize(index + 1);
+            }
+
+            PartSlot& slot = m_parts[index];
+            if (slot.state != PartSlotState::NONE)
             {
-                m_failedParts.erase(partId);
+                --GetPartCount(slot.state);
             }
+            slot.part = partState;
+            slot.state = nextState;
+            ++GetPartCount(nextState);
+        }
+
+        PartStateMap TransferHandle::CollectParts(PartSlotState state) const
+        {
+            PartStateMap parts;
+            for (size_t i = 0; i < m_parts.size(); ++i)
+            {
+                if (m_parts[i].state == state)
+                {
+                    // slots are in part id order, so every insert goes at the end
+                    parts.emplace_hint(parts.end(), static_cast<int>(i + 1), m_parts[i].part);
+                }
+            }
+            return parts;
+        }
+
+        PartStateMap TransferHandle::GetCompletedParts() const
+        {
+            std::lock_guard<std::mutex> locker(m_partsLock);
+            return CollectParts(PartSlotState::COMPLETED);
+        }
+
+        void TransferHandle::ChangePartToCompleted(const PartPointer& partState, const Aws::String &eTag)
+        {
+            std::lock_guard<std::mutex> locker(m_partsLock);
+            const auto partId = partState->GetPartId();
 
             partState->SetETag(eTag);
             if (partState->IsLastPart()) 
             {
                 AddMetadataEntry("ETag", eTag);
             }
-            m_completedParts[partId] = partState;
+            MovePart(partState, PartSlotState::COMPLETED);
             AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Transfer handle ID [" << GetId() << "] Setting part [" << partId
                     << "] to [" << TransferStatus::COMPLETED << "].");
         }
@@ -149,52 +216,47 @@ namespace Aws
         PartStateMap TransferHandle::GetQueuedParts() const
         {
             std::lock_guard<std::mutex> locker(m_partsLock);
-            return m_queuedParts;
+            return CollectParts(PartSlotState::QUEUED);
         }
 
         bool TransferHandle::HasQueuedParts() const
         {
-            std::lock_guard<std::mutex> locker(m_partsLock);
-            return m_queuedParts.size() > 0;
+            return m_queuedPartCount > 0;
         }
 
         void TransferHandle::AddQueuedPart(const PartPointer& partState)
         {            
             std::lock_guard<std::mutex> locker(m_partsLock);
             partState->Reset();
-            m_failedParts.erase(partState->GetPartId());          
-            m_queuedParts[partState->GetPartId()] = partState;
+            MovePart(partState, PartSlotState::QUEUED);
         }
 
         PartStateMap TransferHandle::GetPendingParts() const
         {
             std::lock_guard<std::mutex> locker(m_partsLock);
-            return m_pendingParts;
+            return CollectParts(PartSlotState::PENDING);
         }
 
         bool TransferHandle::HasPendingParts() const
         {
-            std::lock_guard<std::mutex> locker(m_partsLock);
-            return m_pendingParts.size() > 0;
+            return m_pendingPartCount > 0;
         }
 
         void TransferHandle::AddPendingPart(const PartPointer& partState)
         {            
             std::lock_guard<std::mutex> locker(m_partsLock);
-            m_queuedParts.erase(partState->GetPartId());           
-            m_pendingParts[partState->GetPartId()] = partState;
+            MovePart(partState, PartSlotState::PENDING);
         }
 
         PartStateMap TransferHandle::GetFailedParts() const
         {
             std::lock_guard<std::mutex> locker(m_partsLock);
-            return m_failedParts;
+            return CollectParts(PartSlotState::FAILED);
         }
 
         bool TransferHandle::HasFailedParts() const
         {
-            std::lock_guard<std::mutex> locker(m_partsLock);
-            return m_failedParts.size() > 0;
+            return m_failedPartCount > 0;
         }
 
         void TransferHandle::ChangePartToFailed(const PartPointer& partState)
@@ -203,9 +265,7 @@ namespace Aws
 
             std::lock_guard<std::mutex> locker(m_partsLock);
             partState->Reset();
-            m_pendingParts.erase(partId);
-            m_queuedParts.erase(partId);
-            m_failedParts[partId] = partState;
+            MovePart(partState, PartSlotState::FAILED);
             AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Transfer handle ID [" << GetId() << "] Setting part [" << partId
                     << "] to [" << TransferStatus::FAILED << "].");
         }
@@ -214,16 +274,25 @@ namespace Aws
             PartStateMap& failedParts, PartStateMap& completedParts)
         {
             std::lock_guard<std::mutex> locker(m_partsLock);
-            queuedParts = m_queuedParts;
-            pendingParts = m_pendingParts;
-            failedParts = m_failedParts;
-            completedParts = m_completedParts;
+            queuedParts = CollectParts(PartSlotState::QUEUED);
+            pendingParts = CollectParts(PartSlotState::PENDING);
+            failedParts = CollectParts(PartSlotState::FAILED);
+            completedParts = CollectParts(PartSlotState::COMPLETED);
+        }
+
+        void TransferHandle::GetPartCountsTransactional(size_t& queuedParts, size_t& pendingParts, size_t& failedParts, size_t& completedParts) const
+        {
+            std::lock_guard<std::mutex> locker(m_partsLock);
+            queuedParts = m_queuedPartCount;
+            pendingParts = m_pendingPartCount;
+            failedParts = m_failedPartCount;
+            completedParts = m_completedPartCount;
         }
 
         bool TransferHandle::HasParts() const
         {
             std::lock_guard<std::mutex> locker(m_partsLock);
-            return !m_queuedParts.empty() || !m_pendingParts.empty() || !m_failedParts.empty() || !m_completedParts.empty();
+            return !m_parts.empty();
         }
 
         static bool IsFinishedStatus(TransferStatus value)
@@ -0,0 +1,204 @@
+/*
+* Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+*  http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+#include <aws/transfer/TransferJournal.h>
+#include <aws/core/platform/FileSystem.h>
+#include <aws/core/utils/HashingUtils.h>
+#include <aws/core/utils/StringUtils.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+#include <aws/core/utils/logging/LogMacros.h>
+
+namespace Aws
+{
+    namespace Transfer
+    {
+        static const char* JOURNAL_VERSION = "transfer-journal-1";
+        static const char* UPLOAD_TAG = "upload";
+        static const char* DOWNLOAD_TAG = "download";
+        static const char* PART_TAG = "part";
+        static const std::chrono::seconds MAX_FLUSH_INTERVAL(1);
+
+        // fields are URL encoded so that keys and paths with spaces or newlines can't break the line format, behind a marker so that none is empty
+        static Aws::String Encode(const Aws::String& value)
+        {
+            return "=" + Aws::Utils::StringUtils::URLEncode(value.c_str());
+        }
+
+        static Aws::String Decode(const Aws::String& value)
+        {
+            return Aws::Utils::StringUtils::URLDecode(value.substr(1).c_str());
+        }
+
+        bool TransferJournalHeader::operator==(const TransferJournalHeader& other) const
+        {
+            return direction == other.direction && bucketName == other.bucketName && keyName == other.keyName && filePath == other.filePath &&
+                totalSize == other.totalSize && partSize == other.partSize && transferId == other.transferId;
+        }
+
+        TransferJournal::TransferJournal(const Aws::String& path, size_t batchSize) :
+            m_path(path),
+            m_batchSize(batchSize),
+            m_hasHeader(false),
+            m_pendingParts(0),
+            m_lastFlush(std::chrono::steady_clock::now())
+        {
+            Read();
+        }
+
+        TransferJournal::~TransferJournal()
+        {
+            Flush();
+        }
+
+        Aws::String TransferJournal::GetJournalPath(const Aws::String& journalDirectory, TransferDirection direction, const Aws::String& bucketName,
+                                                    const Aws::String& keyName, const Aws::String& filePath)
+        {
+            Aws::StringStream ss;
+            ss << (direction == TransferDirection::UPLOAD ? UPLOAD_TAG : DOWNLOAD_TAG) << '\n' << bucketName << '\n' << keyName << '\n' << filePath;
+            auto hash = Aws::Utils::HashingUtils::HexEncode(Aws::Utils::HashingUtils::CalculateMD5(ss.str()));
+            return Aws::FileSystem::Join(journalDirectory, hash + ".journal");
+        }
+
+        void TransferJournal::Read()
+        {
+            Aws::IFStream file(m_path.c_str(), std::ios_base::in | std::ios_base::binary);
+            if (!file.good())
+            {
+                return;
+            }
+
+            Aws::StringStream contents;
+            contents << file.rdbuf();
+            Aws::String text = contents.str();
+
+            size_t lineStart = 0;
+            for (size_t lineEnd = text.find('\n'); lineEnd != Aws::String::npos; lineStart = lineEnd + 1, lineEnd = text.find('\n', lineStart))
+            {
+                auto fields = Aws::Utils::StringUtils::Split(text.substr(lineStart, lineEnd - lineStart), ' ');
+                if (!m_hasHeader)
+                {
+                    if (fields.size() != 8 || fields[0] != JOURNAL_VERSION || (fields[1] != UPLOAD_TAG && fields[1] != DOWNLOAD_TAG))
+                    {
+                        AWS_LOGSTREAM_WARN(CLASS_TAG, "Ignoring unreadable transfer journal: " << m_path);
+                        return;
+                    }
+                    m_header.direction = fields[1] == UPLOAD_TAG ? TransferDirection::UPLOAD : TransferDirection::DOWNLOAD;
+                    m_header.bucketName = Decode(fields[2]);
+                    m_header.keyName = Decode(fields[3]);
+                    m_header.filePath = Decode(fields[4]);
+                    m_header.totalSize = static_cast<uint64_t>(Aws::Utils::StringUtils::ConvertToInt64(fields[5].c_str()));
+                    m_header.partSize = static_cast<uint64_t>(Aws::Utils::StringUtils::ConvertToInt64(fields[6].c_str()));
+                    m_header.transferId = Decode(fields[7]);
+                    m_hasHeader = true;
+                }
+                else if (fields.size() == 3 && fields[0] == PART_TAG)
+                {
+                    int partNumber = Aws::Utils::StringUtils::ConvertToInt32(fields[1].c_str());
+                    if (partNumber > 0)
+                    {
+                        m_completedParts[partNumber] = Decode(fields[2]);
+                    }
+                }
+            }
+        }
+
+        bool TransferJournal::Open(std::ios_base::openmode mode)
+        {
+#ifdef _MSC_VER
+            m_file.open(Aws::Utils::StringUtils::ToWString(m_path.c_str()).c_str(), mode | std::ios_base::binary);
+#else
+            m_file.open(m_path.c_str(), mode | std::ios_base::binary);
+#endif
+            if (!m_file.good())
+            {
+                AWS_LOGSTREAM_ERROR(CLASS_TAG, "Failed to open transfer journal: " << m_path);
+                return false;
+            }
+            return true;
+        }
+
+        bool TransferJournal::Start(const TransferJournalHeader& header)
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_header = header;
+            m_hasHeader = true;
+            m_completedParts.clear();
+            m_pendingLines.clear();
+            m_pendingParts = 0;
+            if (m_file.is_open())
+            {
+                m_file.close();
+            }
+            if (!Open(std::ios_base::out | std::ios_base::trunc))
+            {
+                return false;
+            }
+
+            m_file << JOURNAL_VERSION << ' ' << (header.direction == TransferDirection::UPLOAD ? UPLOAD_TAG : DOWNLOAD_TAG) << ' '
+                << Encode(header.bucketName) << ' ' << Encode(header.keyName) << ' ' << Encode(header.filePath) << ' '
+                << header.totalSize << ' ' << header.partSize << ' ' << Encode(header.transferId) << '\n';
+            m_file.flush();
+            return m_file.good();
+        }
+
+        bool TransferJournal::Resume()
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            return m_file.is_open() || Open(std::ios_base::out | std::ios_base::app);
+        }
+
+        void TransferJournal::RecordPart(int partNumber, const Aws::String& eTag)
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_completedParts[partNumber] = eTag;
+            m_pendingLines.append(PART_TAG).append(" ").append(Aws::Utils::StringUtils::to_string(partNumber)).append(" ").append(Encode(eTag)).append("\n");
+            if (++m_pendingParts >= m_batchSize || std::chrono::steady_clock::now() - m_lastFlush >= MAX_FLUSH_INTERVAL)
+            {
+                FlushLocked();
+            }
+        }
+
+        void TransferJournal::Flush()
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            FlushLocked();
+        }
+
+        void TransferJournal::FlushLocked()
+        {
+            m_lastFlush = std::chrono::steady_clock::now();
+            if (m_pendingLines.empty() || !m_file.is_open())
+            {
+                return;
+            }
+            m_file.write(m_pendingLines.c_str(), static_cast<std::streamsize>(m_pendingLines.size()));
+            m_file.flush();
+            m_pendingLines.clear();
+            m_pendingParts = 0;
+        }
+
+        void TransferJournal::Remove()
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_pendingLines.clear();
+            m_pendingParts = 0;
+            if (m_file.is_open())
+            {
+                m_file.close();
+            }
+            Aws::FileSystem::RemoveFileIfExists(m_path.c_str());
+        }
+    }
+}
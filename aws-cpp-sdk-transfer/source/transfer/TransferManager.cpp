@@ -14,6 +14,7 @@
 */
 
 #include <aws/transfer/TransferManager.h>
+#include <aws/transfer/TransferJournal.h>
 #include <aws/core/utils/memory/stl/AWSStreamFwd.h>
 #include <aws/core/utils/memory/AWSMemory.h>
 #include <aws/core/utils/stream/PreallocatedStreamBuf.h>
@@ -27,8 +28,18 @@
 #include <aws/s3/model/ListObjectsV2Request.h>
 #include <aws/s3/model/CompleteMultipartUploadRequest.h>
 #include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/ListPartsRequest.h>
+#include <aws/s3/model/CopyObjectRequest.h>
 #include <fstream>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
 
 #include <aws/core/utils/logging/LogMacros.h>
 
@@ -41,10 +52,114 @@ namespace Aws
             return (path.find_last_of('/') == path.size() - 1 || path.find_last_of('\\') == path.size() - 1);
         }
 
+        static Aws::String FormatRangeSpecifier(uint64_t rangeStart, uint64_t rangeEnd)
+        {
+            Aws::StringStream rangeStream;
+            rangeStream << "bytes=" << rangeStart << "-" << rangeEnd;
+            return rangeStream.str();
+        }
+
+        static Aws::Client::AWSError<Aws::S3::S3Errors> BulkEncryptionNotSupportedError()
+        {
+            return Aws::Client::AWSError<Aws::S3::S3Errors>(Aws::S3::S3Errors::INVALID_ACTION, "EncryptionNotSupported",
+                    "Bulk directory transfers stream objects as they are and can't encrypt or decrypt them.", false);
+        }
+
         struct TransferHandleAsyncContext : public Aws::Client::AsyncCallerContext
         {
             std::shared_ptr<TransferHandle> handle;
             PartPointer partState;
+            std::chrono::steady_clock::time_point startTime;
+        };
+
+        /**
+         * Reads byte ranges of a file at given offsets. On POSIX this is pread on a descriptor of its own, which leaves no file position to share;
+         * elsewhere each reader has its own stream, so readers on different threads don't seek each other's position either.
+         */
+        class PartFileReader
+        {
+        public:
+            PartFileReader(const Aws::String& fileName) :
+#ifdef _WIN32
+#ifdef _MSC_VER
+                m_stream(Aws::Utils::StringUtils::ToWString(fileName.c_str()).c_str(), std::ios_base::in | std::ios_base::binary)
+#else
+                m_stream(fileName.c_str(), std::ios_base::in | std::ios_base::binary)
+#endif
+#else
+                m_fd(open(fileName.c_str(), O_RDONLY))
+#endif
+            {
+            }
+
+            ~PartFileReader()
+            {
+#ifndef _WIN32
+                if (m_fd >= 0)
+                {
+                    close(m_fd);
+                }
+#endif
+            }
+
+            PartFileReader(const PartFileReader&) = delete;
+            PartFileReader& operator=(const PartFileReader&) = delete;
+
+            /**
+             * Reads exactly length bytes starting at offset into buffer. Returns false if the file couldn't be opened or ends early.
+             */
+            bool Read(uint64_t offset, uint8_t* buffer, size_t length)
+            {
+#ifdef _WIN32
+                m_stream.seekg(static_cast<std::streamoff>(offset));
+                m_stream.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(length));
+                return m_stream.good();
+#else
+                if (m_fd < 0)
+                {
+                    return false;
+                }
+                while (length > 0)
+                {
+                    ssize_t bytesRead = pread(m_fd, buffer, length, static_cast<off_t>(offset));
+                    if (bytesRead < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if (bytesRead <= 0)
+                    {
+                        return false;
+                    }
+                    buffer += bytesRead;
+                    offset += static_cast<uint64_t>(bytesRead);
+                    length -= static_cast<size_t>(bytesRead);
+                }
+                return true;
+#endif
+            }
+
+        private:
+#ifdef _WIN32
+            Aws::FStream m_stream;
+#else
+            int m_fd;
+#endif
+        };
+
+        /**
+         * Parts of one file upload, shared by the upload's thread and the helpers it submits to the read executor. A helper that only starts
+         * once the upload's thread has stopped waiting for helpers does nothing.
+         */
+        struct UploadReadState
+        {
+            UploadReadState() : nextPart(0), helpersRunning(0), closed(false) {}
+
+            Aws::Vector<PartPointer> parts;
+            std::atomic<size_t> nextPart;
+            std::mutex lock;
+            std::condition_variable helperFinished;
+            size_t helpersRunning;
+            bool closed;
         };
 
         struct DownloadDirectoryContext : public Aws::Client::AsyncCallerContext
@@ -65,24 +180,179 @@ namespace Aws
             return Aws::MakeShared<MakeSharedEnabler>(CLASS_TAG, config);
         }
 
-        TransferManager::TransferManager(const TransferManagerConfiguration& configuration) : m_transferConfig(configuration)
+        TransferManager::TransferManager(const TransferManagerConfiguration& configuration) :
+            m_idlePartBufferBytes(0), m_copyPartsInFlight(0), m_pooledBuffersInFlight(0), m_transferConfig(configuration),
+            m_partBufferOverhead(configuration.encryption ? configuration.encryption->GetMaxPartOverhead() : 0)
         {
             assert(m_transferConfig.s3Client);
             assert(m_transferConfig.transferExecutor);
+            if (m_transferConfig.uploadReadThreads > 1)
+            {
+                // each upload also reads on its own thread, so the pool only holds the extra readers, shared by all uploads
+                m_uploadReadExecutor = Aws::MakeUnique<Aws::Utils::Threading::PooledThreadExecutor>(CLASS_TAG, m_transferConfig.uploadReadThreads - 1);
+            }
+            if (m_transferConfig.enableAutoTuning)
+            {
+                // part sizes vary per object, so buffers are pooled per part size as they are used instead of up front
+                m_partTuner = Aws::MakeShared<PartConcurrencyTuner>(CLASS_TAG, m_transferConfig.minInFlightParts, m_transferConfig.maxInFlightParts,
+                        m_transferConfig.autoTuningMaxHeapSize);
+                return;
+            }
+
+            if (m_transferConfig.bufferPool)
+            {
+                return;
+            }
+
             for (uint64_t i = 0; i < m_transferConfig.transferBufferMaxHeapSize; i += m_transferConfig.bufferSize)
             {
-                m_bufferManager.PutResource(Aws::New<Aws::Utils::Array<uint8_t>>(CLASS_TAG, static_cast<size_t>(m_transferConfig.bufferSize)));
+                m_bufferManager.PutResource(Aws::New<Aws::Utils::Array<uint8_t>>(CLASS_TAG, static_cast<size_t>(m_transferConfig.bufferSize) + m_partBufferOverhead));
             }
         }
 
         TransferManager::~TransferManager()
         {
+            if (m_partTuner)
+            {
+                // every part holds a reference to this manager through its callback, so all part buffers are idle by now
+                for (auto buffer : m_idlePartBuffers)
+                {
+                    Aws::Delete(buffer);
+                }
+                return;
+            }
+
+            if (m_transferConfig.bufferPool)
+            {
+                return;
+            }
+
             for (auto buffer : m_bufferManager.ShutdownAndWait(static_cast<size_t>(m_transferConfig.transferBufferMaxHeapSize / m_transferConfig.bufferSize)))
             {
                 Aws::Delete(buffer);
             }
         }
 
+        uint64_t TransferManager::ComputePartSize(uint64_t objectSize) const
+        {
+            if (m_partTuner)
+            {
+                return PartConcurrencyTuner::ComputePartSize(objectSize, m_transferConfig.bufferSize, m_transferConfig.maxPartCount);
+            }
+            return m_transferConfig.bufferSize;
+        }
+
+        Aws::Utils::Array<uint8_t>* TransferManager::AcquirePartBuffer(uint64_t partSize, const std::shared_ptr<TransferHandle>& handle)
+        {
+            if (m_partTuner)
+            {
+                // all parts of an object, the smaller last one included, get a buffer of the object's part size so that they share one pool
+                uint64_t bufferSize = (std::max)((std::max)(m_transferConfig.bufferSize, handle->GetPartSize()), partSize) + m_partBufferOverhead;
+                m_partTuner->AcquirePart(bufferSize);
+                handle->SetInFlightPartLimit(m_partTuner->GetInFlightLimit());
+                if (m_transferConfig.bufferPool)
+                {
+                    return m_transferConfig.bufferPool->Acquire(static_cast<size_t>(bufferSize));
+                }
+
+                {
+                    // the buffer of the size released last is the likeliest to still be in cache
+                    std::lock_guard<std::mutex> locker(m_idlePartBuffersLock);
+                    for (auto iter = m_idlePartBuffers.rbegin(); iter != m_idlePartBuffers.rend(); ++iter)
+                    {
+                        if ((*iter)->GetLength() == bufferSize)
+                        {
+                            auto buffer = *iter;
+                            m_idlePartBuffers.erase(std::next(iter).base());
+                            m_idlePartBufferBytes -= bufferSize;
+                            return buffer;
+                        }
+                    }
+                }
+                return Aws::New<Aws::Utils::Array<uint8_t>>(CLASS_TAG, static_cast<size_t>(bufferSize));
+            }
+
+            handle->SetInFlightPartLimit(static_cast<size_t>(m_transferConfig.transferBufferMaxHeapSize / m_transferConfig.bufferSize));
+            if (m_transferConfig.bufferPool)
+            {
+                size_t maxBuffers = (std::max)(static_cast<size_t>(m_transferConfig.transferBufferMaxHeapSize / m_transferConfig.bufferSize), static_cast<size_t>(1));
+                {
+                    std::unique_lock<std::mutex> locker(m_pooledBuffersLock);
+                    m_pooledBufferReleased.wait(locker, [this, maxBuffers]() { return m_pooledBuffersInFlight < maxBuffers; });
+                    ++m_pooledBuffersInFlight;
+                }
+                return m_transferConfig.bufferPool->Acquire(static_cast<size_t>(m_transferConfig.bufferSize) + m_partBufferOverhead);
+            }
+            return m_bufferManager.Acquire();
+        }
+
+        void TransferManager::ReleasePartBuffer(Aws::Utils::Array<uint8_t>* buffer)
+        {
+            if (m_transferConfig.bufferPool)
+            {
+                uint64_t bufferSize = buffer->GetLength();
+                m_transferConfig.bufferPool->Release(buffer);
+                if (m_partTuner)
+                {
+                    m_partTuner->ReleasePart(bufferSize);
+                    return;
+                }
+
+                {
+                    std::lock_guard<std::mutex> locker(m_pooledBuffersLock);
+                    --m_pooledBuffersInFlight;
+                }
+                m_pooledBufferReleased.notify_one();
+                return;
+            }
+
+            if (m_partTuner)
+            {
+                uint64_t bufferSize = buffer->GetLength();
+                // keeping as many bytes idle as the parts in flight may hold lets a steady stream of parts run without allocating. The
+                // oldest buffers go first, so after a change of part size the buffers of the old size are freed as those of the new one
+                // take their place, and buffers of sizes still in use by other transfers are kept.
+                uint64_t maxIdleBytes = static_cast<uint64_t>(m_partTuner->GetInFlightLimit()) * bufferSize;
+                if (m_transferConfig.autoTuningMaxHeapSize > 0)
+                {
+                    maxIdleBytes = (std::min)(maxIdleBytes, m_transferConfig.autoTuningMaxHeapSize);
+                }
+                Aws::Vector<Aws::Utils::Array<uint8_t>*> evictedBuffers;
+                {
+                    std::lock_guard<std::mutex> locker(m_idlePartBuffersLock);
+                    if (bufferSize <= maxIdleBytes)
+                    {
+                        m_idlePartBuffers.push_back(buffer);
+                        m_idlePartBufferBytes += bufferSize;
+                        buffer = nullptr;
+                        while (m_idlePartBufferBytes > maxIdleBytes)
+                        {
+                            evictedBuffers.push_back(m_idlePartBuffers.front());
+                            m_idlePartBufferBytes -= m_idlePartBuffers.front()->GetLength();
+                            m_idlePartBuffers.pop_front();
+                        }
+                    }
+                }
+                Aws::Delete(buffer);
+                for (auto evictedBuffer : evictedBuffers)
+                {
+                    Aws::Delete(evictedBuffer);
+                }
+                m_partTuner->ReleasePart(bufferSize);
+                return;
+            }
+
+            m_bufferManager.Release(buffer);
+        }
+
+        void TransferManager::RecordPartTransfer(uint64_t partSize, std::chrono::steady_clock::time_point startTime, bool succeeded)
+        {
+            if (m_partTuner)
+            {
+                m_partTuner->RecordPart(partSize, std::chrono::steady_clock::now() - startTime, succeeded);
+            }
+        }
+
         std::shared_ptr<TransferHandle> TransferManager::UploadFile(const Aws::String& fileName,
                                                                     const Aws::String& bucketName,
                                                                     const Aws::String& keyName,
@@ -124,6 +394,11 @@ namespace Aws
                                                                       const DownloadConfiguration& downloadConfig,
                                                                       const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
         {
+            if (!m_transferConfig.journalDirectory.empty())
+            {
+                return DownloadFileWithJournal(bucketName, keyName, writeToFile, downloadConfig, context);
+            }
+
 #ifdef _MSC_VER
             auto createFileFn = [=]() { return Aws::New<Aws::FStream>(CLASS_TAG, Aws::Utils::StringUtils::ToWString(writeToFile.c_str()).c_str(),
                                                                      std::ios_base::out | std::ios_base::in | std::ios_base::binary | std::ios_base::trunc);};
@@ -135,6 +410,58 @@ namespace Aws
             return DownloadFile(bucketName, keyName, createFileFn, downloadConfig, writeToFile, context);
         }
 
+        std::shared_ptr<TransferHandle> TransferManager::DownloadParts(const Aws::String& bucketName,
+                                                                       const Aws::String& keyName,
+                                                                       const DownloadedPartCallback& onPart,
+                                                                       const DownloadConfiguration& downloadConfig,
+                                                                       const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
+        {
+            // parts skip the download stream; only an empty object, which has no part to hand over, is read into one
+            auto createEmptyStreamFn = []() { return Aws::New<Aws::StringStream>(CLASS_TAG); };
+            auto handle = Aws::MakeShared<TransferHandle>(CLASS_TAG, bucketName, keyName, createEmptyStreamFn);
+            handle->ApplyDownloadConfiguration(downloadConfig);
+            handle->SetContext(context);
+            handle->SetDownloadedPartCallback(onPart);
+
+            auto self = shared_from_this();
+            m_transferConfig.transferExecutor->Submit([self, handle] { self->DoDownload(handle); });
+            return handle;
+        }
+
+        std::shared_ptr<TransferHandle> TransferManager::DownloadFileWithJournal(const Aws::String& bucketName,
+                                                                                 const Aws::String& keyName,
+                                                                                 const Aws::String& writeToFile,
+                                                                                 const DownloadConfiguration& downloadConfig,
+                                                                                 const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
+        {
+            // a resumed download writes its remaining parts into the file as it is; InitializePartsForDownload truncates it when it starts over
+            auto createFileFn = [=]()
+            {
+#ifdef _MSC_VER
+                auto fileName = Aws::Utils::StringUtils::ToWString(writeToFile.c_str());
+#else
+                auto fileName = writeToFile;
+#endif
+                auto fileStream = Aws::New<Aws::FStream>(CLASS_TAG, fileName.c_str(), std::ios_base::out | std::ios_base::in | std::ios_base::binary);
+                if (!fileStream->good())
+                {
+                    fileStream->clear();
+                    fileStream->open(fileName.c_str(), std::ios_base::out | std::ios_base::in | std::ios_base::binary | std::ios_base::trunc);
+                }
+                return fileStream;
+            };
+
+            auto handle = Aws::MakeShared<TransferHandle>(CLASS_TAG, bucketName, keyName, createFileFn, writeToFile);
+            handle->ApplyDownloadConfiguration(downloadConfig);
+            handle->SetContext(context);
+            handle->SetJournal(Aws::MakeShared<TransferJournal>(CLASS_TAG, TransferJournal::GetJournalPath(m_transferConfig.journalDirectory,
+                    TransferDirection::DOWNLOAD, bucketName, keyName, writeToFile), m_transferConfig.journalBatchSize));
+
+            auto self = shared_from_this();
+            m_transferConfig.transferExecutor->Submit([self, handle] { self->DoDownload(handle); });
+            return handle;
+        }
+
         std::shared_ptr<TransferHandle> TransferManager::RetryUpload(const Aws::String& fileName, const std::shared_ptr<TransferHandle>& retryHandle)
         {
 #ifdef _MSC_VER
@@ -188,6 +515,49 @@ namespace Aws
             return retryHandle;
         }
 
+        std::shared_ptr<TransferHandle> TransferManager::CopyObject(const Aws::String& sourceBucketName,
+                                                                    const Aws::String& sourceKeyName,
+                                                                    const Aws::String& bucketName,
+                                                                    const Aws::String& keyName,
+                                                                    const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
+        {
+            // the size is only known once DoCopy has looked at the source
+            auto handle = Aws::MakeShared<TransferHandle>(CLASS_TAG, bucketName, keyName, 0);
+            handle->SetCopySource(sourceBucketName, sourceKeyName);
+            handle->SetContext(context);
+
+            auto self = shared_from_this();
+            m_transferConfig.transferExecutor->Submit([self, handle] { self->DoCopy(handle); });
+            return handle;
+        }
+
+        std::shared_ptr<TransferHandle> TransferManager::RetryCopy(const std::shared_ptr<TransferHandle>& retryHandle)
+        {
+            assert(retryHandle->IsCopy());
+            assert(retryHandle->GetStatus() != TransferStatus::IN_PROGRESS);
+            assert(retryHandle->GetStatus() != TransferStatus::COMPLETED);
+            assert(retryHandle->GetStatus() != TransferStatus::NOT_STARTED);
+
+            AWS_LOGSTREAM_INFO(CLASS_TAG, "Transfer handle [" << retryHandle->GetId()
+                    << "] Retrying copy to Bucket: [" << retryHandle->GetBucketName() << "] with Key: ["
+                    << retryHandle->GetKey() << "] with Upload ID: [" << retryHandle->GetMultiPartId()
+                    << "]. Current handle status: [" << retryHandle->GetStatus() << "].");
+
+            if (retryHandle->GetStatus() == TransferStatus::ABORTED)
+            {
+                return CopyObject(retryHandle->GetCopySourceBucketName(), retryHandle->GetCopySourceKey(), retryHandle->GetBucketName(),
+                                  retryHandle->GetKey(), retryHandle->GetContext());
+            }
+
+            retryHandle->UpdateStatus(TransferStatus::NOT_STARTED);
+            retryHandle->Restart();
+            TriggerTransferStatusUpdatedCallback(retryHandle);
+
+            auto self = shared_from_this();
+            m_transferConfig.transferExecutor->Submit([self, retryHandle] { self->DoCopy(retryHandle); });
+            return retryHandle;
+        }
+
         void TransferManager::AbortMultipartUpload(const std::shared_ptr<TransferHandle>& inProgressHandle)
         {
             assert(inProgressHandle->IsMultipart());
@@ -209,13 +579,7 @@ namespace Aws
             {
                 if (entry && entry.fileType == Aws::FileSystem::FileType::File)
                 {
-                    Aws::StringStream ssKey;
-                    Aws::String relativePath = entry.relativePath;
-                    char delimiter[] = { Aws::FileSystem::PATH_DELIM, 0 };
-                    Aws::Utils::StringUtils::Replace(relativePath, delimiter, "/");
-
-                    ssKey << prefix << "/" << relativePath;
-                    Aws::String keyName = ssKey.str();
+                    Aws::String keyName = DetermineKeyName(prefix, entry.relativePath);
                     AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Uploading file: " << entry.path
                             << " as part of directory upload to S3 Bucket: [" << bucketName << "] and Key: ["
                             << keyName << "].");
@@ -250,24 +614,620 @@ namespace Aws
             m_transferConfig.s3Client->ListObjectsV2Async(request, handler, context);
         }
 
-        void TransferManager::DoMultiPartUpload(const std::shared_ptr<TransferHandle>& handle)
+        std::shared_ptr<DirectoryTransferHandle> TransferManager::BulkUploadDirectory(const Aws::String& directory, const Aws::String& bucketName, const Aws::String& prefix,
+                                                                                      const Aws::Map<Aws::String, Aws::String>& metadata)
+        {
+            auto handle = Aws::MakeShared<DirectoryTransferHandle>(CLASS_TAG, TransferDirection::UPLOAD, directory, bucketName, prefix);
+            auto self = shared_from_this();
+            m_transferConfig.transferExecutor->Submit([self, handle, metadata] { self->DoBulkUploadDirectory(handle, metadata); });
+            return handle;
+        }
+
+        std::shared_ptr<DirectoryTransferHandle> TransferManager::BulkDownloadToDirectory(const Aws::String& directory, const Aws::String& bucketName, const Aws::String& prefix)
+        {
+            auto handle = Aws::MakeShared<DirectoryTransferHandle>(CLASS_TAG, TransferDirection::DOWNLOAD, directory, bucketName, prefix);
+            auto self = shared_from_this();
+            m_transferConfig.transferExecutor->Submit([self, handle] { self->DoBulkDownloadToDirectory(handle); });
+            return handle;
+        }
+
+        void TransferManager::DoBulkUploadDirectory(const std::shared_ptr<DirectoryTransferHandle>& handle, const Aws::Map<Aws::String, Aws::String>& metadata)
         {
+            if (m_transferConfig.encryption)
+            {
+                AWS_LOGSTREAM_ERROR(CLASS_TAG, "Directory upload of " << handle->GetDirectory() << " refused: BulkUploadDirectory can't encrypt; use UploadDirectory.");
+                handle->FinishListing(false, BulkEncryptionNotSupportedError());
+                TriggerDirectoryProgressCallback(handle, true);
+                return;
+            }
+
+            auto self = shared_from_this(); // keep transfer manager alive until all callbacks are finished.
+            auto visitor = [self, handle, &metadata](const Aws::FileSystem::DirectoryTree*, const Aws::FileSystem::DirectoryEntry& entry)
+            {
+                if (!entry || entry.fileType != Aws::FileSystem::FileType::File)
+                {
+                    return true;
+                }
+                if (!handle->AcquireRequestSlot(self->m_transferConfig.directoryMaxInFlight))
+                {
+                    return false;
+                }
+
+                Aws::String keyName = DetermineKeyName(handle->GetPrefix(), entry.relativePath);
+                uint64_t fileSize = static_cast<uint64_t>(entry.fileSize);
+
+                // the file is opened only now that its request can start, so no more files are open than requests are in flight
 #ifdef _MSC_VER
-            auto wide = Aws::Utils::StringUtils::ToWString(handle->GetTargetFilePath().c_str());
-            auto streamToPut = Aws::MakeShared<Aws::FStream>(CLASS_TAG, wide.c_str(), std::ios_base::in | std::ios_base::binary);
-            DoMultiPartUpload(streamToPut, handle);
+                auto fileStream = Aws::MakeShared<Aws::FStream>(CLASS_TAG, Aws::Utils::StringUtils::ToWString(entry.path.c_str()).c_str(), std::ios_base::in | std::ios_base::binary);
 #else
-            auto streamToPut = Aws::MakeShared<Aws::FStream>(CLASS_TAG, handle->GetTargetFilePath().c_str(), std::ios_base::in | std::ios_base::binary);
-            DoMultiPartUpload(streamToPut, handle);
+                auto fileStream = Aws::MakeShared<Aws::FStream>(CLASS_TAG, entry.path.c_str(), std::ios_base::in | std::ios_base::binary);
 #endif
+                if (!fileStream->good())
+                {
+                    AWS_LOGSTREAM_ERROR(CLASS_TAG, "Failed to open file: " << entry.path << " as part of directory upload to S3 Bucket: ["
+                            << handle->GetBucketName() << "] and Key: [" << keyName << "].");
+                    Aws::Client::AWSError<Aws::S3::S3Errors> error(static_cast<Aws::S3::S3Errors>(Aws::S3::S3Errors::NO_SUCH_UPLOAD), "NoSuchUpload", "The requested file could not be opened.", false);
+                    // the walk isn't finished yet, so this can't finish the transfer
+                    handle->CompleteRequest(keyName, 0, false, error);
+                    return true;
+                }
+
+                Aws::S3::Model::PutObjectRequest putObjectRequest = self->m_transferConfig.putObjectTemplate;
+                putObjectRequest.SetCustomizedAccessLogTag(self->m_transferConfig.customizedAccessLogTag);
+                putObjectRequest.SetContinueRequestHandler([handle](const Aws::Http::HttpRequest*) { return handle->ShouldContinue(); });
+                putObjectRequest.WithBucket(handle->GetBucketName())
+                    .WithKey(keyName)
+                    .WithContentLength(static_cast<long long>(fileSize))
+                    .WithMetadata(metadata);
+                putObjectRequest.SetContentType(DEFAULT_CONTENT_TYPE);
+                putObjectRequest.SetBody(fileStream);
+
+                auto callback = [self, handle, keyName, fileSize](const Aws::S3::S3Client*, const Aws::S3::Model::PutObjectRequest&,
+                    const Aws::S3::Model::PutObjectOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+                {
+                    if (!outcome.IsSuccess())
+                    {
+                        AWS_LOGSTREAM_ERROR(CLASS_TAG, "Failed to upload key: [" << keyName << "] as part of directory upload to S3 Bucket: ["
+                                << handle->GetBucketName() << "]. " << outcome.GetError());
+                    }
+                    self->TriggerDirectoryProgressCallback(handle, handle->CompleteRequest(keyName, fileSize, outcome.IsSuccess(), outcome.GetError()));
+                };
+
+                self->m_transferConfig.s3Client->PutObjectAsync(putObjectRequest, callback);
+                return true;
+            };
+
+            Aws::FileSystem::DirectoryTree dir(handle->GetDirectory());
+            bool finished = false;
+            if (dir)
+            {
+                dir.TraverseDepthFirst(visitor);
+                finished = handle->FinishListing(true);
+            }
+            else
+            {
+                AWS_LOGSTREAM_ERROR(CLASS_TAG, "Failed to open directory: " << handle->GetDirectory() << " for directory upload.");
+                finished = handle->FinishListing(false, Aws::Client::AWSError<Aws::S3::S3Errors>(static_cast<Aws::S3::S3Errors>(Aws::S3::S3Errors::NO_SUCH_UPLOAD),
+                        "NoSuchUpload", "The requested directory could not be opened.", false));
+            }
+
+            if (finished)
+            {
+                TriggerDirectoryProgressCallback(handle, true);
+            }
+        }
+
+        void TransferManager::DoBulkDownloadToDirectory(const std::shared_ptr<DirectoryTransferHandle>& handle)
+        {
+            if (m_transferConfig.encryption)
+            {
+                AWS_LOGSTREAM_ERROR(CLASS_TAG, "Directory download of " << handle->GetPrefix() << " refused: BulkDownloadToDirectory can't decrypt; use DownloadToDirectory.");
+                handle->FinishListing(false, BulkEncryptionNotSupportedError());
+                TriggerDirectoryProgressCallback(handle, true);
+                return;
+            }
+
+            auto self = shared_from_this(); // keep transfer manager alive until all callbacks are finished.
+            Aws::FileSystem::CreateDirectoryIfNotExists(handle->GetDirectory().c_str(), true/*create parent dirs*/);
+
+            Aws::S3::Model::ListObjectsV2Request listRequest;
+            listRequest.SetCustomizedAccessLogTag(m_transferConfig.customizedAccessLogTag);
+            listRequest.WithBucket(handle->GetBucketName())
+                .WithPrefix(handle->GetPrefix());
+
+            // objects under one prefix come out of the listing together, so remembering the last directory created saves a call per object
+            Aws::String lastCreatedDirectory;
+            bool listed = true;
+            Aws::Client::AWSError<Aws::S3::S3Errors> listError;
+            bool moreKeys = true;
+            while (moreKeys && handle->ShouldContinue())
+            {
+                auto listOutcome = m_transferConfig.s3Client->ListObjectsV2(listRequest);
+                if (!listOutcome.IsSuccess())
+                {
+                    AWS_LOGSTREAM_ERROR(CLASS_TAG, "Listing objects failed for bucket: " << handle->GetBucketName() << " with prefix: "
+                            << handle->GetPrefix() << ". Error message: " << listOutcome.GetError());
+                    listed = false;
+                    listError = listOutcome.GetError();
+                    break;
+                }
+
+                auto& result = listOutcome.GetResult();
+                moreKeys = result.GetIsTruncated();
+                listRequest.SetContinuationToken(result.GetNextContinuationToken());
+
+                for (auto& content : result.GetContents())
+                {
+                    if (IsS3KeyPrefix(content.GetKey()))
+                    {
+                        continue;
+                    }
+                    if (!handle->AcquireRequestSlot(m_transferConfig.directoryMaxInFlight))
+                    {
+                        break;
+                    }
+
+                    Aws::String fileName = DetermineFilePath(handle->GetDirectory(), handle->GetPrefix(), content.GetKey());
+                    auto lastDelimiter = fileName.find_last_of(Aws::FileSystem::PATH_DELIM);
+                    if (lastDelimiter != std::string::npos && fileName.compare(0, lastDelimiter, lastCreatedDirectory) != 0)
+                    {
+                        lastCreatedDirectory = fileName.substr(0, lastDelimiter);
+                        Aws::FileSystem::CreateDirectoryIfNotExists(lastCreatedDirectory.c_str(), true/*create parent dirs*/);
+                    }
+
+                    Aws::S3::Model::GetObjectRequest getObjectRequest;
+                    getObjectRequest.SetCustomizedAccessLogTag(m_transferConfig.customizedAccessLogTag);
+                    getObjectRequest.SetContinueRequestHandler([handle](const Aws::Http::HttpRequest*) { return handle->ShouldContinue(); });
+                    getObjectRequest.WithBucket(handle->GetBucketName())
+                        .WithKey(content.GetKey());
+                    // the file is created only once the response arrives
+                    getObjectRequest.SetResponseStreamFactory([fileName]
+                    {
+#ifdef _MSC_VER
+                        return Aws::New<Aws::FStream>(CLASS_TAG, Aws::Utils::StringUtils::ToWString(fileName.c_str()).c_str(),
+                                std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+#else
+                        return Aws::New<Aws::FStream>(CLASS_TAG, fileName.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+#endif
+                    });
+
+                    Aws::String keyName = content.GetKey();
+                    auto callback = [self, handle, keyName](const Aws::S3::S3Client*, const Aws::S3::Model::GetObjectRequest&,
+                        const Aws::S3::Model::GetObjectOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+                    {
+                        uint64_t bytes = 0;
+                        if (outcome.IsSuccess())
+                        {
+                            bytes = static_cast<uint64_t>(outcome.GetResult().GetContentLength());
+                        }
+                        else
+                        {
+                            AWS_LOGSTREAM_ERROR(CLASS_TAG, "Failed to download key: [" << keyName << "] as part of directory download from S3 Bucket: ["
+                                    << handle->GetBucketName() << "]. " << outcome.GetError());
+                        }
+                        self->TriggerDirectoryProgressCallback(handle, handle->CompleteRequest(keyName, bytes, outcome.IsSuccess(), outcome.GetError()));
+                    };
+
+                    m_transferConfig.s3Client->GetObjectAsync(getObjectRequest, callback);
+                }
+            }
+
+            if (handle->FinishListing(listed, listError))
+            {
+                TriggerDirectoryProgressCallback(handle, true);
+            }
+        }
+
+        void TransferManager::TriggerDirectoryProgressCallback(const std::shared_ptr<DirectoryTransferHandle>& handle, bool finished) const
+        {
+            if (m_transferConfig.directoryProgressCallback && (finished || handle->IsProgressReportDue(m_transferConfig.directoryProgressInterval)))
+            {
+                m_transferConfig.directoryProgressCallback(this, handle);
+            }
+            if (finished)
+            {
+                handle->NotifyFinished();
+            }
+        }
+
+        void TransferManager::DoMultiPartUpload(const std::shared_ptr<TransferHandle>& handle)
+        {
+            handle->SetIsMultipart(true);
+
+            // an encrypted upload can't be picked up by another process, which wouldn't have its cipher
+            if (!m_transferConfig.journalDirectory.empty() && !m_transferConfig.encryption && handle->GetMultiPartId().empty())
+            {
+                handle->SetJournal(Aws::MakeShared<TransferJournal>(CLASS_TAG, TransferJournal::GetJournalPath(m_transferConfig.journalDirectory,
+                        TransferDirection::UPLOAD, handle->GetBucketName(), handle->GetKey(), handle->GetTargetFilePath()), m_transferConfig.journalBatchSize));
+            }
+
+            uint64_t sentBytes = 0;
+            if (!InitializePartsForUpload(handle, sentBytes))
+            {
+                return;
+            }
+
+            //still consistent
+            PartStateMap queuedParts = handle->GetQueuedParts();
+            Aws::Vector<PartPointer> parts;
+            parts.reserve(queuedParts.size());
+            for (auto& queuedPart : queuedParts)
+            {
+                parts.push_back(queuedPart.second);
+            }
+
+            handle->UpdateStatus(TransferStatus::IN_PROGRESS);
+            TriggerTransferStatusUpdatedCallback(handle);
+
+            if (parts.empty())
+            {
+                // resumed from a journal with every part already uploaded
+                CompleteMultiPartUploadIfDone(handle);
+                return;
+            }
+
+            // parts of a file don't depend on each other, so helpers on the read executor read them alongside this thread, each at its part's
+            // offset. Helpers are only extra hands: this thread reads whatever they don't, so an upload still completes while other uploads
+            // keep the executor busy. Encrypted parts do depend on each other, and are read in order on this thread alone.
+            auto readState = Aws::MakeShared<UploadReadState>(CLASS_TAG);
+            readState->parts = std::move(parts);
+            size_t helperCount = 0;
+            if (m_uploadReadExecutor && !handle->GetPartEncryptor())
+            {
+                helperCount = (std::min)(m_transferConfig.uploadReadThreads, readState->parts.size()) - 1;
+            }
+            for (size_t i = 0; i < helperCount; ++i)
+            {
+                m_uploadReadExecutor->Submit([this, handle, readState]
+                {
+                    {
+                        std::lock_guard<std::mutex> locker(readState->lock);
+                        if (readState->closed)
+                        {
+                            return;
+                        }
+                        ++readState->helpersRunning;
+                    }
+                    ReadAndUploadParts(handle, readState->parts, readState->nextPart);
+                    std::lock_guard<std::mutex> locker(readState->lock);
+                    --readState->helpersRunning;
+                    readState->helperFinished.notify_all();
+                });
+            }
+            ReadAndUploadParts(handle, readState->parts, readState->nextPart);
+            {
+                std::unique_lock<std::mutex> locker(readState->lock);
+                readState->closed = true;
+                readState->helperFinished.wait(locker, [&readState] { return readState->helpersRunning == 0; });
+            }
+
+            for (size_t i = (std::min)(readState->nextPart.load(), readState->parts.size()); i < readState->parts.size(); ++i)
+            {
+                handle->ChangePartToFailed(readState->parts[i]);
+            }
+
+            if (handle->HasFailedParts())
+            {
+                handle->UpdateStatus(DetermineIfFailedOrCanceled(*handle));
+                TriggerTransferStatusUpdatedCallback(handle);
+            }
+        }
+
+        void TransferManager::ReadAndUploadParts(const std::shared_ptr<TransferHandle>& handle, const Aws::Vector<PartPointer>& parts, std::atomic<size_t>& nextPart)
+        {
+            PartFileReader reader(handle->GetTargetFilePath());
+
+            for (size_t i = nextPart++; i < parts.size(); i = nextPart++)
+            {
+                const PartPointer& part = parts[i];
+                auto buffer = AcquirePartBuffer(part->GetSizeInBytes(), handle);
+                if (!handle->ShouldContinue())
+                {
+                    ReleasePartBuffer(buffer);
+                    handle->ChangePartToFailed(part);
+                    break;
+                }
+
+                if (!reader.Read(static_cast<uint64_t>(part->GetPartId() - 1) * handle->GetPartSize(), buffer->GetUnderlyingData(), part->GetSizeInBytes()))
+                {
+                    AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Failed to read part [" << part->GetPartId()
+                            << "] from file: " << handle->GetTargetFilePath());
+                    ReleasePartBuffer(buffer);
+                    handle->ChangePartToFailed(part);
+                    continue;
+                }
+
+                UploadPart(handle, part, buffer);
+            }
+        }
+
+        void TransferManager::DoCopy(const std::shared_ptr<TransferHandle>& handle)
+        {
+            // a retried multi-part copy already knows its source and only copies its failed parts again
+            if (handle->GetMultiPartId().empty())
+            {
+                Aws::S3::Model::HeadObjectRequest headObjectRequest;
+                headObjectRequest.SetCustomizedAccessLogTag(m_transferConfig.customizedAccessLogTag);
+                headObjectRequest.WithBucket(handle->GetCopySourceBucketName())
+                                 .WithKey(handle->GetCopySourceKey());
+
+                auto headObjectOutcome = m_transferConfig.s3Client->HeadObject(headObjectRequest);
+                if (!headObjectOutcome.IsSuccess())
+                {
+                    AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId()
+                            << "] Failed to get the copy source object in Bucket: ["
+                            << handle->GetCopySourceBucketName() << "] with Key: [" << handle->GetCopySourceKey()
+                            << "] " << headObjectOutcome.GetError());
+                    handle->UpdateStatus(TransferStatus::FAILED);
+                    handle->SetError(headObjectOutcome.GetError());
+                    TriggerErrorCallback(handle, headObjectOutcome.GetError());
+                    TriggerTransferStatusUpdatedCallback(handle);
+                    return;
+                }
+
+                handle->SetBytesTotalSize(static_cast<uint64_t>(headObjectOutcome.GetResult().GetContentLength()));
+                handle->SetContentType(headObjectOutcome.GetResult().GetContentType());
+                handle->SetMetadata(headObjectOutcome.GetResult().GetMetadata());
+                handle->SetCopySourceETag(headObjectOutcome.GetResult().GetETag());
+            }
+
+            if (!handle->IsMultipart() && !MultipartUploadSupported(handle->GetBytesTotalSize()))
+            {
+                DoSinglePartCopy(handle);
+                return;
+            }
+
+            handle->SetIsMultipart(true);
+            uint64_t copiedBytes = 0;
+            if (!InitializePartsForUpload(handle, copiedBytes))
+            {
+                return;
+            }
+
+            //still consistent
+            PartStateMap queuedParts = handle->GetQueuedParts();
+            auto partsIter = queuedParts.begin();
+
+            handle->UpdateStatus(TransferStatus::IN_PROGRESS);
+            TriggerTransferStatusUpdatedCallback(handle);
+
+            while (handle->ShouldContinue() && partsIter != queuedParts.end())
+            {
+                AcquireCopyPart();
+                if (handle->ShouldContinue())
+                {
+                    CopyPart(handle, partsIter->second);
+                    ++partsIter;
+                }
+                else
+                {
+                    ReleaseCopyPart();
+                }
+            }
+            //parts get moved from queued to pending on this thread.
+            //still consistent.
+            for (; partsIter != queuedParts.end(); ++partsIter)
+            {
+                handle->ChangePartToFailed(partsIter->second);
+            }
+
+            if (handle->HasFailedParts())
+            {
+                handle->UpdateStatus(DetermineIfFailedOrCanceled(*handle));
+                TriggerTransferStatusUpdatedCallback(handle);
+            }
+        }
+
+        void TransferManager::DoSinglePartCopy(const std::shared_ptr<TransferHandle>& handle)
+        {
+            auto partState = Aws::MakeShared<PartState>(CLASS_TAG, 1, 0, static_cast<size_t>(handle->GetBytesTotalSize()), true);
+
+            handle->UpdateStatus(TransferStatus::IN_PROGRESS);
+            handle->SetIsMultipart(false);
+            handle->SetPartSize(handle->GetBytesTotalSize());
+            handle->AddPendingPart(partState);
+            TriggerTransferStatusUpdatedCallback(handle);
+
+            Aws::S3::Model::CopyObjectRequest copyObjectRequest;
+            copyObjectRequest.SetCustomizedAccessLogTag(m_transferConfig.customizedAccessLogTag);
+            copyObjectRequest.SetContinueRequestHandler([handle](const Aws::Http::HttpRequest*) { return handle->ShouldContinue(); });
+            copyObjectRequest.WithBucket(handle->GetBucketName())
+                .WithKey(handle->GetKey())
+                .WithCopySource(GetCopySource(*handle));
+            if (!handle->GetCopySourceETag().empty())
+            {
+                copyObjectRequest.SetCopySourceIfMatch(handle->GetCopySourceETag());
+            }
+
+            auto copyObjectOutcome = m_transferConfig.s3Client->CopyObject(copyObjectRequest);
+            if (copyObjectOutcome.IsSuccess())
+            {
+                AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Transfer handle [" << handle->GetId()
+                        << "] Successfully copied Bucket: [" << handle->GetCopySourceBucketName() << "] with Key: ["
+                        << handle->GetCopySourceKey() << "] to Bucket: [" << handle->GetBucketName() << "] with Key: ["
+                        << handle->GetKey() << "].");
+                partState->OnDataTransferred(static_cast<long long>(partState->GetSizeInBytes()), handle);
+                TriggerUploadProgressCallback(handle);
+                handle->ChangePartToCompleted(partState, copyObjectOutcome.GetResult().GetCopyObjectResultDetails().GetETag());
+                handle->UpdateStatus(TransferStatus::COMPLETED);
+            }
+            else
+            {
+                AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId()
+                        << "] Failed to copy Bucket: [" << handle->GetCopySourceBucketName() << "] with Key: ["
+                        << handle->GetCopySourceKey() << "] to Bucket: [" << handle->GetBucketName() << "] with Key: ["
+                        << handle->GetKey() << "]. " << copyObjectOutcome.GetError());
+                handle->ChangePartToFailed(partState);
+                handle->SetError(copyObjectOutcome.GetError());
+                handle->UpdateStatus(DetermineIfFailedOrCanceled(*handle));
+                TriggerErrorCallback(handle, copyObjectOutcome.GetError());
+            }
+            TriggerTransferStatusUpdatedCallback(handle);
+        }
+
+        void TransferManager::CopyPart(const std::shared_ptr<TransferHandle>& handle, const PartPointer& partPtr)
+        {
+            uint64_t rangeStart = static_cast<uint64_t>(partPtr->GetPartId() - 1) * handle->GetPartSize();
+            uint64_t rangeEnd = rangeStart + partPtr->GetSizeInBytes() - 1;
+
+            auto self = shared_from_this(); // keep transfer manager alive until all callbacks are finished.
+            Aws::S3::Model::UploadPartCopyRequest uploadPartCopyRequest;
+            uploadPartCopyRequest.SetCustomizedAccessLogTag(m_transferConfig.customizedAccessLogTag);
+            uploadPartCopyRequest.SetContinueRequestHandler([handle](const Aws::Http::HttpRequest*) { return handle->ShouldContinue(); });
+            uploadPartCopyRequest.WithBucket(handle->GetBucketName())
+                .WithKey(handle->GetKey())
+                .WithPartNumber(partPtr->GetPartId())
+                .WithUploadId(handle->GetMultiPartId())
+                .WithCopySource(GetCopySource(*handle))
+                .WithCopySourceRange(FormatRangeSpecifier(rangeStart, rangeEnd));
+            if (!handle->GetCopySourceETag().empty())
+            {
+                uploadPartCopyRequest.SetCopySourceIfMatch(handle->GetCopySourceETag());
+            }
+
+            handle->AddPendingPart(partPtr);
+
+            auto asyncContext = Aws::MakeShared<TransferHandleAsyncContext>(CLASS_TAG);
+            asyncContext->handle = handle;
+            asyncContext->partState = partPtr;
+            asyncContext->startTime = std::chrono::steady_clock::now();
+
+            auto callback = [self](const Aws::S3::S3Client* client, const Aws::S3::Model::UploadPartCopyRequest& request,
+                const Aws::S3::Model::UploadPartCopyOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
+            {
+                self->HandleUploadPartCopyResponse(client, request, outcome, context);
+            };
+
+            m_transferConfig.s3Client->UploadPartCopyAsync(uploadPartCopyRequest, callback, asyncContext);
+        }
+
+        Aws::String TransferManager::GetCopySource(const TransferHandle& handle) const
+        {
+            return handle.GetCopySourceBucketName() + "/" + Aws::Utils::StringUtils::URLEncode(handle.GetCopySourceKey().c_str());
+        }
+
+        void TransferManager::AcquireCopyPart()
+        {
+            if (m_partTuner)
+            {
+                // a copied part takes a slot under the in-flight limit but none of the memory budget. How fast S3 copies says
+                // nothing about the client's link, so copied parts are not fed back into the limit
+                m_partTuner->AcquirePart(0);
+                return;
+            }
+
+            size_t maxCopyParts = (std::max)(static_cast<size_t>(m_transferConfig.transferBufferMaxHeapSize / m_transferConfig.bufferSize), static_cast<size_t>(1));
+            std::unique_lock<std::mutex> locker(m_copyPartsLock);
+            m_copyPartReleased.wait(locker, [this, maxCopyParts]() { return m_copyPartsInFlight < maxCopyParts; });
+            ++m_copyPartsInFlight;
+        }
+
+        void TransferManager::ReleaseCopyPart()
+        {
+            if (m_partTuner)
+            {
+                m_partTuner->ReleasePart(0);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> locker(m_copyPartsLock);
+                --m_copyPartsInFlight;
+            }
+            m_copyPartReleased.notify_one();
+        }
+
+        TransferJournalHeader TransferManager::MakeJournalHeader(const TransferHandle& handle, TransferDirection direction, const Aws::String& transferId) const
+        {
+            TransferJournalHeader header;
+            header.direction = direction;
+            header.bucketName = handle.GetBucketName();
+            header.keyName = handle.GetKey();
+            header.filePath = handle.GetTargetFilePath();
+            header.totalSize = handle.GetBytesTotalSize();
+            header.partSize = handle.GetPartSize() > 0 ? handle.GetPartSize() : ComputePartSize(handle.GetBytesTotalSize());
+            header.transferId = transferId;
+            return header;
+        }
+
+        bool TransferManager::ResumeUploadFromJournal(const std::shared_ptr<TransferHandle>& handle, TransferJournal& journal, uint64_t& sentBytes)
+        {
+            if (!journal.HasHeader() || journal.GetHeader() != MakeJournalHeader(*handle, TransferDirection::UPLOAD, journal.GetHeader().transferId))
+            {
+                return false;
+            }
+
+            const Aws::String& uploadId = journal.GetHeader().transferId;
+            // a part counts as uploaded only if S3 still has it with the ETag the journal recorded
+            Aws::Map<int, Aws::S3::Model::Part> uploadedParts;
+            Aws::S3::Model::ListPartsRequest listPartsRequest;
+            listPartsRequest.SetCustomizedAccessLogTag(m_transferConfig.customizedAccessLogTag);
+            listPartsRequest.WithBucket(handle->GetBucketName())
+                .WithKey(handle->GetKey())
+                .WithUploadId(uploadId);
+            bool moreParts = true;
+            while (moreParts)
+            {
+                auto listPartsOutcome = m_transferConfig.s3Client->ListParts(listPartsRequest);
+                if (!listPartsOutcome.IsSuccess())
+                {
+                    AWS_LOGSTREAM_WARN(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Failed to list the parts of Upload ID: [" << uploadId
+                            << "] recorded in the transfer journal, starting the upload over. " << listPartsOutcome.GetError());
+                    return false;
+                }
+                for (const auto& part : listPartsOutcome.GetResult().GetParts())
+                {
+                    uploadedParts[part.GetPartNumber()] = part;
+                }
+                moreParts = listPartsOutcome.GetResult().GetIsTruncated();
+                listPartsRequest.SetPartNumberMarker(listPartsOutcome.GetResult().GetNextPartNumberMarker());
+            }
+
+            uint64_t totalSize = handle->GetBytesTotalSize();
+            uint64_t partSize = journal.GetHeader().partSize;
+            uint64_t partCount = (totalSize + partSize - 1) / partSize;
+            handle->SetMultipartId(uploadId);
+            handle->SetPartSize(partSize);
+            size_t resumedParts = 0;
+            for (uint64_t i = 0; i < partCount; ++i)
+            {
+                int partNumber = static_cast<int>(i + 1);
+                size_t sizeOfPart = static_cast<size_t>((std::min)(totalSize - i * partSize, partSize));
+                auto partState = Aws::MakeShared<PartState>(CLASS_TAG, partNumber, 0, sizeOfPart, i == partCount - 1);
+
+                auto journaledPart = journal.GetCompletedParts().find(partNumber);
+                auto uploadedPart = uploadedParts.find(partNumber);
+                if (journaledPart != journal.GetCompletedParts().end() && uploadedPart != uploadedParts.end() &&
+                    uploadedPart->second.GetETag() == journaledPart->second && static_cast<size_t>(uploadedPart->second.GetSize()) == sizeOfPart)
+                {
+                    partState->SetBestProgressInBytes(sizeOfPart);
+                    handle->ChangePartToCompleted(partState, journaledPart->second);
+                    handle->UpdateBytesTransferred(sizeOfPart);
+                    sentBytes += sizeOfPart;
+                    ++resumedParts;
+                }
+                else
+                {
+                    handle->AddQueuedPart(partState);
+                }
+            }
+
+            journal.Resume();
+            AWS_LOGSTREAM_INFO(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Resuming multi-part upload with Upload ID: [" << uploadId
+                    << "] from the transfer journal. " << resumedParts << " of " << partCount << " part(s) were already uploaded.");
+            return true;
         }
 
-        void TransferManager::DoMultiPartUpload(const std::shared_ptr<Aws::IOStream>& streamToPut, const std::shared_ptr<TransferHandle>& handle)
+        bool TransferManager::InitializePartsForUpload(const std::shared_ptr<TransferHandle>& handle, uint64_t& sentBytes)
         {
-            handle->SetIsMultipart(true);
-
             bool isRetry = !handle->GetMultiPartId().empty();
-            uint64_t sentBytes = 0;
+            sentBytes = 0;
+            auto journal = handle->GetJournal();
+
+            if (!isRetry && journal && ResumeUploadFromJournal(handle, *journal, sentBytes))
+            {
+                return true;
+            }
 
             if (!isRetry)
             {
@@ -278,22 +1238,55 @@ namespace Aws
                 createMultipartRequest.WithKey(handle->GetKey());
                 createMultipartRequest.WithMetadata(handle->GetMetadata());
 
+                if (m_transferConfig.encryption && !handle->IsCopy())
+                {
+                    auto encryptionOutcome = m_transferConfig.encryption->BeginUpload(createMultipartRequest);
+                    if (!encryptionOutcome.IsSuccess())
+                    {
+                        AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Failed to start the encryption of the "
+                                "multi-part upload to Bucket: [" << handle->GetBucketName() << "] with Key: [" << handle->GetKey() << "]. "
+                                << encryptionOutcome.GetError());
+                        handle->SetError(encryptionOutcome.GetError());
+                        handle->UpdateStatus(DetermineIfFailedOrCanceled(*handle));
+
+                        TriggerErrorCallback(handle, encryptionOutcome.GetError());
+                        TriggerTransferStatusUpdatedCallback(handle);
+                        return false;
+                    }
+                    handle->SetPartEncryptor(encryptionOutcome.GetResult());
+                }
+
                 auto createMultipartResponse = m_transferConfig.s3Client->CreateMultipartUpload(createMultipartRequest);
                 if (createMultipartResponse.IsSuccess())
                 {
                     handle->SetMultipartId(createMultipartResponse.GetResult().GetUploadId());
                     uint64_t totalSize = handle->GetBytesTotalSize();
-                    uint64_t partCount = ( totalSize + m_transferConfig.bufferSize - 1 ) / m_transferConfig.bufferSize;
+                    // a copied part takes no memory here, so only the part count limit makes it larger than bufferSize
+                    uint64_t partSize = handle->IsCopy() ? PartConcurrencyTuner::ComputePartSize(totalSize, m_transferConfig.bufferSize, m_transferConfig.maxPartCount)
+                                                         : ComputePartSize(totalSize);
+                    if (handle->GetPartEncryptor())
+                    {
+                        // parts other than the last are encrypted without padding, so they have to be whole cipher blocks
+                        uint64_t blockSize = m_transferConfig.encryption->GetBlockSize();
+                        partSize = (partSize + blockSize - 1) / blockSize * blockSize;
+                    }
+                    uint64_t partCount = ( totalSize + partSize - 1 ) / partSize;
+                    handle->SetPartSize(partSize);
                     AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Transfer handle [" << handle->GetId()
                             << "] Successfully created a multi-part upload request. Upload ID: ["
                             << createMultipartResponse.GetResult().GetUploadId()
-                            << "]. Splitting the multi-part upload to " << partCount << " part(s).");
+                            << "]. Splitting the multi-part upload to " << partCount << " part(s) of " << partSize << " bytes.");
 
                     for (uint64_t i = 0; i < partCount; ++i)
                     {
-                        uint64_t partSize = (std::min)(totalSize - i * m_transferConfig.bufferSize, m_transferConfig.bufferSize);
+                        uint64_t sizeOfPart = (std::min)(totalSize - i * partSize, partSize);
                         bool lastPart = (i == partCount - 1) ? true : false;
-                        handle->AddQueuedPart(Aws::MakeShared<PartState>(CLASS_TAG, static_cast<int>(i + 1), 0, static_cast<size_t>(partSize), lastPart));
+                        handle->AddQueuedPart(Aws::MakeShared<PartState>(CLASS_TAG, static_cast<int>(i + 1), 0, static_cast<size_t>(sizeOfPart), lastPart));
+                    }
+
+                    if (journal && !journal->Start(MakeJournalHeader(*handle, TransferDirection::UPLOAD, handle->GetMultiPartId())))
+                    {
+                        handle->SetJournal(nullptr);
                     }
                 }
                 else
@@ -306,7 +1299,7 @@ namespace Aws
 
                     TriggerErrorCallback(handle, createMultipartResponse.GetError());
                     TriggerTransferStatusUpdatedCallback(handle);
-                    return;
+                    return false;
                 }
             }
             else
@@ -327,6 +1320,18 @@ namespace Aws
                             << " failed parts of total size " << bytesLeft << " bytes. Upload ID ["
                             << handle->GetMultiPartId() << "].");
             }
+            return true;
+        }
+
+        void TransferManager::DoMultiPartUpload(const std::shared_ptr<Aws::IOStream>& streamToPut, const std::shared_ptr<TransferHandle>& handle)
+        {
+            handle->SetIsMultipart(true);
+
+            uint64_t sentBytes = 0;
+            if (!InitializePartsForUpload(handle, sentBytes))
+            {
+                return;
+            }
 
             //still consistent
             PartStateMap queuedParts = handle->GetQueuedParts();
@@ -338,51 +1343,21 @@ namespace Aws
 
             while (sentBytes < handle->GetBytesTotalSize() && handle->ShouldContinue() && partsIter != queuedParts.end())
             {
-                auto buffer = m_bufferManager.Acquire();
+                auto buffer = AcquirePartBuffer(partsIter->second->GetSizeInBytes(), handle);
                 if(handle->ShouldContinue())
                 {
                     auto lengthToWrite = partsIter->second->GetSizeInBytes();
-                    streamToPut->seekg((partsIter->first - 1) * m_transferConfig.bufferSize);
+                    streamToPut->seekg((partsIter->first - 1) * handle->GetPartSize());
                     streamToPut->read((char*)buffer->GetUnderlyingData(), lengthToWrite);
 
-                    auto streamBuf = Aws::New<Aws::Utils::Stream::PreallocatedStreamBuf>(CLASS_TAG, buffer, static_cast<size_t>(lengthToWrite));
-                    auto preallocatedStreamReader = Aws::MakeShared<Aws::IOStream>(CLASS_TAG, streamBuf);
-
-                    auto self = shared_from_this(); // keep transfer manager alive until all callbacks are finished.
-                    PartPointer partPtr = partsIter->second;
-                    Aws::S3::Model::UploadPartRequest uploadPartRequest = m_transferConfig.uploadPartTemplate;
-                    uploadPartRequest.SetCustomizedAccessLogTag(m_transferConfig.customizedAccessLogTag);
-                    uploadPartRequest.SetContinueRequestHandler([handle](const Aws::Http::HttpRequest*) { return handle->ShouldContinue(); });
-                    uploadPartRequest.SetDataSentEventHandler([self, handle, partPtr](const Aws::Http::HttpRequest*, long long amount){ partPtr->OnDataTransferred(amount, handle); self->TriggerUploadProgressCallback(handle); });
-                    uploadPartRequest.SetRequestRetryHandler([partPtr](const AmazonWebServiceRequest&){ partPtr->Reset(); });
-                    uploadPartRequest.WithBucket(handle->GetBucketName())
-                        .WithContentLength(static_cast<long long>(lengthToWrite))
-                        .WithKey(handle->GetKey())
-                        .WithPartNumber(partsIter->first)
-                        .WithUploadId(handle->GetMultiPartId());
-
-                    handle->AddPendingPart(partsIter->second);
-
-                    uploadPartRequest.SetBody(preallocatedStreamReader);
-                    uploadPartRequest.SetContentType(handle->GetContentType());
-                    auto asyncContext = Aws::MakeShared<TransferHandleAsyncContext>(CLASS_TAG);
-                    asyncContext->handle = handle;
-                    asyncContext->partState = partsIter->second;
-
-                    auto callback = [self](const Aws::S3::S3Client* client, const Aws::S3::Model::UploadPartRequest& request,
-                        const Aws::S3::Model::UploadPartOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
-                    {
-                        self->HandleUploadPartResponse(client, request, outcome, context);
-                    };
-
-                    m_transferConfig.s3Client->UploadPartAsync(uploadPartRequest, callback, asyncContext);
+                    UploadPart(handle, partsIter->second, buffer);
                     sentBytes += lengthToWrite;
 
                     ++partsIter;
                 }
                 else
                 {
-                    m_bufferManager.Release(buffer);
+                    ReleasePartBuffer(buffer);
                 }
             }
             //parts get moved from queued to pending on this thread.
@@ -399,6 +1374,67 @@ namespace Aws
             }
         }
 
+        void TransferManager::UploadPart(const std::shared_ptr<TransferHandle>& handle, const PartPointer& partPtr, Aws::Utils::Array<uint8_t>* buffer)
+        {
+            auto lengthToWrite = partPtr->GetSizeInBytes();
+            auto encryptor = handle->GetPartEncryptor();
+            if (encryptor)
+            {
+                lengthToWrite = encryptor->EncryptPart(partPtr->GetPartId(), buffer->GetUnderlyingData(), lengthToWrite, buffer->GetLength(), partPtr->IsLastPart());
+                if (lengthToWrite == 0)
+                {
+                    AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Failed to encrypt part [" << partPtr->GetPartId()
+                            << "] of the upload to Bucket: [" << handle->GetBucketName() << "] with Key: [" << handle->GetKey() << "].");
+                    ReleasePartBuffer(buffer);
+                    Aws::Client::AWSError<Aws::S3::S3Errors> error(Aws::S3::S3Errors::INTERNAL_FAILURE, "EncryptionFailed", "The part could not be encrypted.", false);
+                    handle->ChangePartToFailed(partPtr);
+                    handle->SetError(error);
+                    TriggerErrorCallback(handle, error);
+                    return;
+                }
+            }
+
+            auto streamBuf = Aws::New<Aws::Utils::Stream::PreallocatedStreamBuf>(CLASS_TAG, buffer, static_cast<size_t>(lengthToWrite));
+            auto preallocatedStreamReader = Aws::MakeShared<Aws::IOStream>(CLASS_TAG, streamBuf);
+
+            auto self = shared_from_this(); // keep transfer manager alive until all callbacks are finished.
+            Aws::S3::Model::UploadPartRequest uploadPartRequest = m_transferConfig.uploadPartTemplate;
+            uploadPartRequest.SetCustomizedAccessLogTag(m_transferConfig.customizedAccessLogTag);
+            uploadPartRequest.SetContinueRequestHandler([handle](const Aws::Http::HttpRequest*) { return handle->ShouldContinue(); });
+            uploadPartRequest.SetDataSentEventHandler([self, handle, partPtr](const Aws::Http::HttpRequest*, long long amount){ partPtr->OnDataTransferred(amount, handle); self->TriggerUploadProgressCallback(handle); });
+            uploadPartRequest.SetRequestRetryHandler([partPtr](const AmazonWebServiceRequest&){ partPtr->Reset(); });
+            uploadPartRequest.WithBucket(handle->GetBucketName())
+                .WithContentLength(static_cast<long long>(lengthToWrite))
+                .WithKey(handle->GetKey())
+                .WithPartNumber(partPtr->GetPartId())
+                .WithUploadId(handle->GetMultiPartId());
+
+            if (m_transferConfig.computeContentMD5)
+            {
+                // hashed here, on the thread that read the part, rather than by the client as it goes out
+                auto contentMD5 = Aws::Utils::HashingUtils::Base64Encode(Aws::Utils::HashingUtils::CalculateMD5(*preallocatedStreamReader));
+                partPtr->SetContentMD5(contentMD5);
+                uploadPartRequest.SetContentMD5(contentMD5);
+            }
+
+            handle->AddPendingPart(partPtr);
+
+            uploadPartRequest.SetBody(preallocatedStreamReader);
+            uploadPartRequest.SetContentType(handle->GetContentType());
+            auto asyncContext = Aws::MakeShared<TransferHandleAsyncContext>(CLASS_TAG);
+            asyncContext->handle = handle;
+            asyncContext->partState = partPtr;
+            asyncContext->startTime = std::chrono::steady_clock::now();
+
+            auto callback = [self](const Aws::S3::S3Client* client, const Aws::S3::Model::UploadPartRequest& request,
+                const Aws::S3::Model::UploadPartOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
+            {
+                self->HandleUploadPartResponse(client, request, outcome, context);
+            };
+
+            m_transferConfig.s3Client->UploadPartAsync(uploadPartRequest, callback, asyncContext);
+        }
+
         void TransferManager::DoSinglePartUpload(const std::shared_ptr<TransferHandle>& handle)
         {
 #ifdef _MSC_VER
@@ -430,13 +1466,59 @@ namespace Aws
 
             putObjectRequest.SetContentType(handle->GetContentType());
 
-            auto buffer = m_bufferManager.Acquire();
+            std::shared_ptr<PartEncryptor> encryptor;
+            if (m_transferConfig.encryption)
+            {
+                auto encryptionOutcome = m_transferConfig.encryption->BeginUpload(putObjectRequest);
+                if (!encryptionOutcome.IsSuccess())
+                {
+                    AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Failed to start the encryption of the "
+                            "upload to Bucket: [" << handle->GetBucketName() << "] with Key: [" << handle->GetKey() << "]. "
+                            << encryptionOutcome.GetError());
+                    handle->ChangePartToFailed(partState);
+                    handle->SetError(encryptionOutcome.GetError());
+                    handle->UpdateStatus(DetermineIfFailedOrCanceled(*handle));
+                    TriggerErrorCallback(handle, encryptionOutcome.GetError());
+                    TriggerTransferStatusUpdatedCallback(handle);
+                    return;
+                }
+                encryptor = encryptionOutcome.GetResult();
+            }
+
+            handle->SetPartSize(handle->GetBytesTotalSize());
+            auto buffer = AcquirePartBuffer(handle->GetBytesTotalSize(), handle);
 
-            auto lengthToWrite = (std::min)(static_cast<uint64_t>(buffer->GetLength()), handle->GetBytesTotalSize());
+            auto lengthToWrite = (std::min)(static_cast<uint64_t>(buffer->GetLength() - m_partBufferOverhead), handle->GetBytesTotalSize());
             streamToPut->read((char*)buffer->GetUnderlyingData(), lengthToWrite);
+            if (encryptor)
+            {
+                // the object is its own last part
+                lengthToWrite = encryptor->EncryptPart(1, buffer->GetUnderlyingData(), static_cast<size_t>(lengthToWrite), buffer->GetLength(), true);
+                if (lengthToWrite == 0)
+                {
+                    AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Failed to encrypt the upload to Bucket: ["
+                            << handle->GetBucketName() << "] with Key: [" << handle->GetKey() << "].");
+                    ReleasePartBuffer(buffer);
+                    Aws::Client::AWSError<Aws::S3::S3Errors> error(Aws::S3::S3Errors::INTERNAL_FAILURE, "EncryptionFailed", "The object could not be encrypted.", false);
+                    handle->ChangePartToFailed(partState);
+                    handle->SetError(error);
+                    handle->UpdateStatus(DetermineIfFailedOrCanceled(*handle));
+                    TriggerErrorCallback(handle, error);
+                    TriggerTransferStatusUpdatedCallback(handle);
+                    return;
+                }
+                putObjectRequest.SetContentLength(static_cast<long long>(lengthToWrite));
+            }
             auto streamBuf = Aws::New<Aws::Utils::Stream::PreallocatedStreamBuf>(CLASS_TAG, buffer, static_cast<size_t>(lengthToWrite));
             auto preallocatedStreamReader = Aws::MakeShared<Aws::IOStream>(CLASS_TAG, streamBuf);
 
+            if (m_transferConfig.computeContentMD5)
+            {
+                auto md5 = Aws::Utils::HashingUtils::CalculateMD5(*preallocatedStreamReader);
+                putObjectRequest.SetContentMD5(Aws::Utils::HashingUtils::Base64Encode(md5));
+                handle->SetExpectedETag("\"" + Aws::Utils::HashingUtils::HexEncode(md5) + "\"");
+            }
+
             putObjectRequest.SetBody(preallocatedStreamReader);
 
             auto self = shared_from_this(); // keep transfer manager alive until all callbacks are finished.
@@ -458,6 +1540,7 @@ namespace Aws
             auto asyncContext = Aws::MakeShared<TransferHandleAsyncContext>(CLASS_TAG);
             asyncContext->handle = handle;
             asyncContext->partState = partState;
+            asyncContext->startTime = std::chrono::steady_clock::now();
 
             auto callback = [self](const Aws::S3::S3Client* client, const Aws::S3::Model::PutObjectRequest& request,
                 const Aws::S3::Model::PutObjectOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
@@ -476,7 +1559,11 @@ namespace Aws
 
             auto originalStreamBuffer = (Aws::Utils::Stream::PreallocatedStreamBuf*)request.GetBody()->rdbuf();
 
-            m_bufferManager.Release(originalStreamBuffer->GetBuffer());
+            if (transferContext->handle->ShouldContinue())
+            {
+                RecordPartTransfer(transferContext->partState->GetSizeInBytes(), transferContext->startTime, outcome.IsSuccess());
+            }
+            ReleasePartBuffer(originalStreamBuffer->GetBuffer());
             Aws::Delete(originalStreamBuffer);
             const auto& handle = transferContext->handle;
             const auto& partState = transferContext->partState;
@@ -486,6 +1573,11 @@ namespace Aws
                 if (handle->ShouldContinue())
                 {
                     handle->ChangePartToCompleted(partState, outcome.GetResult().GetETag());
+                    auto journal = handle->GetJournal();
+                    if (journal)
+                    {
+                        journal->RecordPart(partState->GetPartId(), outcome.GetResult().GetETag());
+                    }
                     AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Transfer handle [" << handle->GetId()
                             << " successfully uploaded Part: [" << partState->GetPartId() << "] to Bucket: ["
                             << handle->GetBucketName() << "] with Key: [" << handle->GetKey() << "] with Upload ID: ["
@@ -518,21 +1610,48 @@ namespace Aws
 
             TriggerTransferStatusUpdatedCallback(handle);
 
-            PartStateMap pendingParts, queuedParts, failedParts, completedParts;
-            handle->GetAllPartsTransactional(queuedParts, pendingParts, failedParts, completedParts);
+            CompleteMultiPartUploadIfDone(handle);
+        }
+
+        void TransferManager::CompleteMultiPartUploadIfDone(const std::shared_ptr<TransferHandle>& handle)
+        {
+            size_t pendingParts, queuedParts, failedParts, completedParts;
+            handle->GetPartCountsTransactional(queuedParts, pendingParts, failedParts, completedParts);
 
-            if (pendingParts.size() == 0 && queuedParts.size() == 0 && handle->LockForCompletion())
+            if (pendingParts == 0 && queuedParts == 0 && handle->LockForCompletion())
             {
-                if (failedParts.size() == 0 && handle->GetBytesTransferred() == handle->GetBytesTotalSize())
+                // the journal is settled before the status changes, since anyone waiting on the handle may start over as soon as it does
+                auto journal = handle->GetJournal();
+                if (failedParts == 0 && handle->GetBytesTransferred() == handle->GetBytesTotalSize())
                 {
                     Aws::S3::Model::CompletedMultipartUpload completedUpload;
+                    // the ETag of a multi-part object is the MD5 of its parts' MD5s, followed by the number of parts
+                    Aws::String partMD5s;
+                    bool allPartMD5sKnown = m_transferConfig.computeContentMD5;
 
-                    for (auto& part : handle->GetCompletedParts())
+                    auto completedParts = handle->GetCompletedParts();
+                    for (auto& part : completedParts)
                     {
                         Aws::S3::Model::CompletedPart completedPart;
                         completedPart.WithPartNumber(part.first)
                             .WithETag(part.second->GetETag());
                         completedUpload.AddParts(completedPart);
+
+                        if (allPartMD5sKnown && !part.second->GetContentMD5().empty())
+                        {
+                            auto partMD5 = Aws::Utils::HashingUtils::Base64Decode(part.second->GetContentMD5());
+                            partMD5s.append(reinterpret_cast<const char*>(partMD5.GetUnderlyingData()), partMD5.GetLength());
+                        }
+                        else
+                        {
+                            allPartMD5sKnown = false;
+                        }
+                    }
+
+                    if (allPartMD5sKnown)
+                    {
+                        handle->SetExpectedETag("\"" + Aws::Utils::HashingUtils::HexEncode(Aws::Utils::HashingUtils::CalculateMD5(partMD5s)) + "-" +
+                                                Aws::Utils::StringUtils::to_string(completedParts.size()) + "\"");
                     }
 
                     Aws::S3::Model::CompleteMultipartUploadRequest completeMultipartUploadRequest;
@@ -545,12 +1664,26 @@ namespace Aws
 
                     auto completeUploadOutcome = m_transferConfig.s3Client->CompleteMultipartUpload(completeMultipartUploadRequest);
 
-                    if (completeUploadOutcome.IsSuccess())
+                    if (completeUploadOutcome.IsSuccess() &&
+                        !IsExpectedETag(handle, completeUploadOutcome.GetResult().GetETag(), completeUploadOutcome.GetResult().GetServerSideEncryption(),
+                                        m_transferConfig.uploadPartTemplate.SSECustomerAlgorithmHasBeenSet()))
+                    {
+                        if (journal)
+                        {
+                            journal->Remove();
+                        }
+                        handle->UpdateStatus(TransferStatus::FAILED);
+                    }
+                    else if (completeUploadOutcome.IsSuccess())
                     {
                         AWS_LOGSTREAM_INFO(CLASS_TAG, "Transfer handle [" << handle->GetId()
                                 << "] Multi-part upload completed successfully to Bucket: ["
                                 << handle->GetBucketName() << "] with Key: [" << handle->GetKey()
                                 << "] with Upload ID: [" << handle->GetMultiPartId() << "].");
+                        if (journal)
+                        {
+                            journal->Remove();
+                        }
                         handle->UpdateStatus(TransferStatus::COMPLETED);
                     }
                     else
@@ -561,20 +1694,77 @@ namespace Aws
                                 << "] with Upload ID: [" << handle->GetMultiPartId()
                                 << "]. " << completeUploadOutcome.GetError());
 
+                        if (journal)
+                        {
+                            journal->Flush();
+                        }
                         handle->UpdateStatus(DetermineIfFailedOrCanceled(*handle));
                     }
                 }
                 else
                 {
-                    AWS_LOGSTREAM_TRACE(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] " << failedParts.size()
+                    AWS_LOGSTREAM_TRACE(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] " << failedParts
                             << " Failed parts. " << handle->GetBytesTransferred() << " bytes transferred out of "
                             << handle->GetBytesTotalSize() << " total bytes.");
+                    if (journal)
+                    {
+                        journal->Flush();
+                    }
                     handle->UpdateStatus(DetermineIfFailedOrCanceled(*handle));
                 }
                 TriggerTransferStatusUpdatedCallback(handle);
             }
         }
 
+        void TransferManager::HandleUploadPartCopyResponse(const Aws::S3::S3Client*, const Aws::S3::Model::UploadPartCopyRequest&,
+            const Aws::S3::Model::UploadPartCopyOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
+        {
+            std::shared_ptr<TransferHandleAsyncContext> transferContext =
+                std::const_pointer_cast<TransferHandleAsyncContext>(std::static_pointer_cast<const TransferHandleAsyncContext>(context));
+            ReleaseCopyPart();
+            const auto& handle = transferContext->handle;
+            const auto& partState = transferContext->partState;
+
+            if (outcome.IsSuccess())
+            {
+                if (handle->ShouldContinue())
+                {
+                    // nothing passes through the client, so a part's bytes count as transferred once S3 has copied it
+                    partState->OnDataTransferred(static_cast<long long>(partState->GetSizeInBytes()), handle);
+                    handle->ChangePartToCompleted(partState, outcome.GetResult().GetCopyPartResult().GetETag());
+                    AWS_LOGSTREAM_DEBUG(CLASS_TAG, "Transfer handle [" << handle->GetId()
+                            << " successfully copied Part: [" << partState->GetPartId() << "] to Bucket: ["
+                            << handle->GetBucketName() << "] with Key: [" << handle->GetKey() << "] with Upload ID: ["
+                            << handle->GetMultiPartId() << "].");
+                    TriggerUploadProgressCallback(handle);
+                }
+                else
+                {
+                    // marked as failed so that the handle's status eventually becomes CANCELED, as for uploaded parts
+                    handle->ChangePartToFailed(partState);
+                    AWS_LOGSTREAM_WARN(CLASS_TAG, "Transfer handle [" << handle->GetId()
+                            << " successfully copied Part: [" << partState->GetPartId() << "] to Bucket: ["
+                            << handle->GetBucketName() << "] with Key: [" << handle->GetKey() << "] with Upload ID: ["
+                            << handle->GetMultiPartId() << "] but transfer has been cancelled meanwhile.");
+                }
+            }
+            else
+            {
+                AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Failed to copy part ["
+                        << partState->GetPartId() << "] to Bucket: [" << handle->GetBucketName()
+                        << "] with Key: [" << handle->GetKey() << "] with Upload ID: [" << handle->GetMultiPartId()
+                        << "]. " << outcome.GetError());
+
+                handle->ChangePartToFailed(partState);
+                handle->SetError(outcome.GetError());
+                TriggerErrorCallback(handle, outcome.GetError());
+            }
+
+            TriggerTransferStatusUpdatedCallback(handle);
+
+            CompleteMultiPartUploadIfDone(handle);
+        }
+
         void TransferManager::HandlePutObjectResponse(const Aws::S3::S3Client*, const Aws::S3::Model::PutObjectRequest& request,
             const Aws::S3::Model::PutObjectOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
         {
@@ -583,13 +1773,24 @@ namespace Aws
 
             auto originalStreamBuffer = (Aws::Utils::Stream::PreallocatedStreamBuf*)request.GetBody()->rdbuf();
 
-            m_bufferManager.Release(originalStreamBuffer->GetBuffer());
+            if (transferContext->handle->ShouldContinue())
+            {
+                RecordPartTransfer(transferContext->partState->GetSizeInBytes(), transferContext->startTime, outcome.IsSuccess());
+            }
+            ReleasePartBuffer(originalStreamBuffer->GetBuffer());
             Aws::Delete(originalStreamBuffer);
 
             const auto& handle = transferContext->handle;
             const auto& partState = transferContext->partState;
 
-            if (outcome.IsSuccess())
+            if (outcome.IsSuccess() &&
+                !IsExpectedETag(handle, outcome.GetResult().GetETag(), outcome.GetResult().GetServerSideEncryption(),
+                                !outcome.GetResult().GetSSECustomerAlgorithm().empty()))
+            {
+                handle->ChangePartToFailed(partState);
+                handle->UpdateStatus(TransferStatus::FAILED);
+            }
+            else if (outcome.IsSuccess())
             {
                 AWS_LOGSTREAM_INFO(CLASS_TAG, "Transfer handle [" << handle->GetId()
                         << "] PutObject completed successfully to Bucket: ["
@@ -612,6 +1813,26 @@ namespace Aws
             TriggerTransferStatusUpdatedCallback(handle);
         }
 
+        bool TransferManager::IsExpectedETag(const std::shared_ptr<TransferHandle>& handle, const Aws::String& eTag,
+                                             Aws::S3::Model::ServerSideEncryption serverSideEncryption, bool customerKey) const
+        {
+            auto expectedETag = handle->GetExpectedETag();
+            // S3 does not derive the ETag of an object encrypted with a KMS or customer provided key from its MD5
+            if (expectedETag.empty() || serverSideEncryption == Aws::S3::Model::ServerSideEncryption::aws_kms || customerKey || eTag == expectedETag)
+            {
+                return true;
+            }
+
+            AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Object uploaded to Bucket: ["
+                    << handle->GetBucketName() << "] with Key: [" << handle->GetKey() << "] has ETag " << eTag
+                    << " where its parts' MD5s give " << expectedETag << ".");
+            Aws::Client::AWSError<Aws::S3::S3Errors> error(Aws::S3::S3Errors::INVALID_PARAMETER_VALUE, "ETagMismatch",
+                    "Uploaded object has ETag " + eTag + ", expected " + expectedETag, false);
+            handle->SetError(error);
+            TriggerErrorCallback(handle, error);
+            return false;
+        }
+
         std::shared_ptr<TransferHandle> TransferManager::RetryDownload(const std::shared_ptr<TransferHandle>& retryHandle)
         {
             assert(retryHandle->GetStatus() != TransferStatus::IN_PROGRESS);
@@ -622,6 +1843,11 @@ namespace Aws
             {
                 DownloadConfiguration retryDownloadConfig;
                 retryDownloadConfig.versionId = retryHandle->GetVersionId();
+                auto onPart = retryHandle->GetDownloadedPartCallback();
+                if (onPart)
+                {
+                    return DownloadParts(retryHandle->GetBucketName(), retryHandle->GetKey(), onPart, retryDownloadConfig, retryHandle->GetContext());
+                }
                 return DownloadFile(retryHandle->GetBucketName(), retryHandle->GetKey(), retryHandle->GetCreateDownloadStreamFunction(), retryDownloadConfig, retryHandle->GetTargetFilePath());
             }
 
@@ -690,17 +1916,9 @@ namespace Aws
             TriggerTransferStatusUpdatedCallback(handle);
         }
 
-        static Aws::String FormatRangeSpecifier(std::size_t rangeStart, std::size_t rangeEnd)
-        {
-            Aws::StringStream rangeStream;
-            rangeStream << "bytes=" << rangeStart << "-" << rangeEnd;
-            return rangeStream.str();
-        }
-
         bool TransferManager::InitializePartsForDownload(const std::shared_ptr<TransferHandle>& handle)
         {
             bool isRetry = handle->HasParts();
-            size_t bufferSize = static_cast<size_t>(m_transferConfig.bufferSize);
             if (!isRetry)
             {
                 Aws::S3::Model::HeadObjectRequest headObjectRequest;
@@ -729,6 +1947,25 @@ namespace Aws
                 }
 
                 std::size_t downloadSize = static_cast<size_t>(headObjectOutcome.GetResult().GetContentLength());
+                if (m_transferConfig.encryption)
+                {
+                    auto decryptionOutcome = m_transferConfig.encryption->BeginDownload(headObjectRequest, headObjectOutcome.GetResult());
+                    if (!decryptionOutcome.IsSuccess())
+                    {
+                        AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId()
+                                << "] Failed to start the decryption of the object in Bucket: ["
+                                << handle->GetBucketName() << "] with Key: [" << handle->GetKey()
+                                << "] " << decryptionOutcome.GetError());
+                        handle->UpdateStatus(TransferStatus::FAILED);
+                        handle->SetError(decryptionOutcome.GetError());
+                        TriggerErrorCallback(handle, decryptionOutcome.GetError());
+                        TriggerTransferStatusUpdatedCallback(handle);
+                        return false;
+                    }
+                    handle->SetPartDecryptor(decryptionOutcome.GetResult());
+                    // the download is split up by what it decrypts to, and each part fetches the ciphertext it needs
+                    downloadSize = static_cast<size_t>(decryptionOutcome.GetResult()->GetPlaintextLength());
+                }
                 handle->SetBytesTotalSize(downloadSize);
                 handle->SetContentType(headObjectOutcome.GetResult().GetContentType());
                 handle->SetMetadata(headObjectOutcome.GetResult().GetMetadata());
@@ -737,17 +1974,69 @@ namespace Aws
                     handle->SetVersionId(headObjectOutcome.GetResult().GetVersionId());
                 }
 
+                size_t partSize = static_cast<size_t>(ComputePartSize(downloadSize));
+                if (handle->GetPartDecryptor())
+                {
+                    // parts are decrypted on their own, so each starts on a cipher block
+                    size_t blockSize = m_transferConfig.encryption->GetBlockSize();
+                    partSize = (std::max)(partSize / blockSize * blockSize, blockSize);
+                }
+                handle->SetPartSize(partSize);
+
                 // For empty file, we create 1 part here to make downloading behaviors consistent for files with different size.
-                std::size_t partCount = (std::max)((downloadSize + bufferSize - 1) / bufferSize, static_cast<std::size_t>(1));
+                std::size_t partCount = (std::max)((downloadSize + partSize - 1) / partSize, static_cast<std::size_t>(1));
                 handle->SetIsMultipart(partCount > 1);    // doesn't make a difference but let's be accurate
 
+                // only multi-part downloads have anything to resume
+                auto journal = handle->GetJournal();
+                auto journalHeader = MakeJournalHeader(*handle, TransferDirection::DOWNLOAD, headObjectOutcome.GetResult().GetETag());
+                bool resume = partCount > 1 && journal && journal->HasHeader() && journal->GetHeader() == journalHeader && journal->Resume();
+                if (journal && !resume)
+                {
+                    // the file is opened without truncating it so that a download can resume into it; whatever an earlier download left there,
+                    // parts of something else or the tail of a larger object, must not survive
+#ifdef _MSC_VER
+                    Aws::OFStream truncate(Aws::Utils::StringUtils::ToWString(handle->GetTargetFilePath().c_str()).c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+#else
+                    Aws::OFStream truncate(handle->GetTargetFilePath().c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+#endif
+                    if (partCount == 1)
+                    {
+                        // a journal left by an earlier multi-part download is of no use to a single part
+                        journal->Remove();
+                        journal = nullptr;
+                    }
+                    else if (!journal->Start(journalHeader))
+                    {
+                        journal = nullptr;
+                    }
+                }
+                handle->SetJournal(journal);
+
+                size_t resumedParts = 0;
                 for(std::size_t i = 0; i < partCount; ++i)
                 {
-                    std::size_t partSize = (i + 1 < partCount ) ? bufferSize : (downloadSize - bufferSize * (partCount - 1));
+                    std::size_t sizeOfPart = (i + 1 < partCount ) ? partSize : (downloadSize - partSize * (partCount - 1));
                     bool lastPart = (i == partCount - 1) ? true : false;
-                    auto partState = Aws::MakeShared<PartState>(CLASS_TAG, static_cast<int>(i + 1), 0, partSize, lastPart);
-                    partState->SetRangeBegin(i * bufferSize);
-                    handle->AddQueuedPart(partState);
+                    auto partState = Aws::MakeShared<PartState>(CLASS_TAG, static_cast<int>(i + 1), 0, sizeOfPart, lastPart);
+                    partState->SetRangeBegin(i * partSize);
+                    if (resume && journal->GetCompletedParts().count(static_cast<int>(i + 1)) > 0)
+                    {
+                        partState->SetBestProgressInBytes(sizeOfPart);
+                        handle->ChangePartToCompleted(partState, journal->GetCompletedParts().at(static_cast<int>(i + 1)));
+                        handle->UpdateBytesTransferred(sizeOfPart);
+                        ++resumedParts;
+                    }
+                    else
+                    {
+                        handle->AddQueuedPart(partState);
+                    }
+                }
+
+                if (resume)
+                {
+                    AWS_LOGSTREAM_INFO(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Resuming download from the transfer journal. "
+                            << resumedParts << " of " << partCount << " part(s) were already downloaded.");
                 }
             }
             else
@@ -771,23 +2060,58 @@ namespace Aws
             TriggerTransferStatusUpdatedCallback(handle);
 
             bool isMultipart = handle->IsMultipart();
-            size_t bufferSize = static_cast<size_t>(m_transferConfig.bufferSize);
+            size_t partSize = static_cast<size_t>(handle->GetPartSize());
+            auto decryptor = handle->GetPartDecryptor();
 
-            if(!isMultipart)
+            // a part handed to a DownloadedPartCallback needs a buffer of its own even if it is the only one, and so does a part to decrypt
+            if(!isMultipart && !decryptor && (!handle->GetDownloadedPartCallback() || handle->GetBytesTotalSize() == 0))
             {
                 // Special case this for performance (avoid the intermediate buffer write)
                 DoSinglePartDownload(handle);
                 return;
             }
 
+            if (decryptor && handle->GetBytesTotalSize() == 0)
+            {
+                // nothing to decrypt, so nothing to fetch; the download stream is still created, as for any other empty object
+                for (auto& queuedPart : handle->GetQueuedParts())
+                {
+                    handle->ChangePartToCompleted(queuedPart.second, "");
+                }
+                Aws::StringStream emptyStream;
+                handle->WritePartToDownloadStream(&emptyStream, 0);
+                handle->UpdateStatus(TransferStatus::COMPLETED);
+                TriggerTransferStatusUpdatedCallback(handle);
+                return;
+            }
+
             auto queuedParts = handle->GetQueuedParts();
+            if (queuedParts.empty() && !handle->HasPendingParts() && !handle->HasFailedParts())
+            {
+                // resumed from a journal with every part already downloaded
+                auto journal = handle->GetJournal();
+                if (journal)
+                {
+                    journal->Remove();
+                }
+                handle->UpdateStatus(TransferStatus::COMPLETED);
+                TriggerTransferStatusUpdatedCallback(handle);
+                return;
+            }
+
             auto queuedPartIter = queuedParts.begin();
             while(queuedPartIter != queuedParts.end() && handle->ShouldContinue())
             {
                 const auto& partState = queuedPartIter->second;
-                std::size_t rangeStart = ( partState->GetPartId() - 1 ) * bufferSize;
+                std::size_t rangeStart = ( partState->GetPartId() - 1 ) * partSize;
                 std::size_t rangeEnd = rangeStart + partState->GetSizeInBytes() - 1;
-                auto buffer = m_bufferManager.Acquire();
+                if (decryptor)
+                {
+                    auto ciphertextRange = decryptor->GetCiphertextRange(rangeStart, partState->GetSizeInBytes());
+                    rangeStart = static_cast<size_t>(ciphertextRange.first);
+                    rangeEnd = static_cast<size_t>(ciphertextRange.second);
+                }
+                auto buffer = AcquirePartBuffer(partState->GetSizeInBytes(), handle);
                 partState->SetDownloadBuffer(buffer);
 
                 CreateDownloadStreamCallback responseStreamFunction = [partState, buffer, rangeEnd, rangeStart]() 
@@ -831,6 +2155,7 @@ namespace Aws
                     auto asyncContext = Aws::MakeShared<TransferHandleAsyncContext>(CLASS_TAG);
                     asyncContext->handle = handle;
                     asyncContext->partState = partState;
+                    asyncContext->startTime = std::chrono::steady_clock::now();
 
                     auto callback = [self](const Aws::S3::S3Client* client, const Aws::S3::Model::GetObjectRequest& request,
                         const Aws::S3::Model::GetObjectOutcome& outcome, const std::shared_ptr<const Aws::Client::AsyncCallerContext>& context)
@@ -845,7 +2170,7 @@ namespace Aws
                 }
                 else if(buffer)
                 {
-                    m_bufferManager.Release(buffer);
+                    ReleasePartBuffer(buffer);
                     break;
                 }
             }
@@ -889,12 +2214,55 @@ namespace Aws
             }
             else
             {
-                if(handle->ShouldContinue())
+                auto decryptor = handle->GetPartDecryptor();
+                bool decrypted = true;
+                if (decryptor && handle->ShouldContinue())
+                {
+                    auto buffer = partState->GetDownloadBuffer();
+                    auto ciphertextRange = decryptor->GetCiphertextRange(partState->GetRangeBegin(), partState->GetSizeInBytes());
+                    decrypted = decryptor->DecryptPart(partState->GetRangeBegin(), partState->GetSizeInBytes(), buffer->GetUnderlyingData(),
+                            static_cast<size_t>(ciphertextRange.second - ciphertextRange.first + 1), buffer->GetLength());
+                }
+
+                if (!decrypted)
+                {
+                    AWS_LOGSTREAM_ERROR(CLASS_TAG, "Transfer handle [" << handle->GetId() << "] Failed to decrypt part [" << partState->GetPartId()
+                            << "] of the object in Bucket: [" << handle->GetBucketName() << "] with Key: [" << handle->GetKey() << "].");
+                    Aws::Client::AWSError<Aws::S3::S3Errors> error(Aws::S3::S3Errors::INTERNAL_FAILURE, "DecryptionFailed", "The part could not be decrypted.", false);
+                    handle->ChangePartToFailed(partState);
+                    handle->SetError(error);
+                    TriggerErrorCallback(handle, error);
+                }
+                else if(handle->ShouldContinue())
                 {
-                    Aws::IOStream* bufferStream = partState->GetDownloadPartStream();
-                    assert(bufferStream);
-                    handle->WritePartToDownloadStream(bufferStream, partState->GetRangeBegin());
+                    auto onPart = handle->GetDownloadedPartCallback();
+                    if (onPart)
+                    {
+                        // the consumer takes the buffer over, and returns it to the pool by dropping the part
+                        auto part = Aws::MakeShared<DownloadedPart>(CLASS_TAG, shared_from_this(), partState->GetDownloadBuffer(),
+                                partState->GetRangeBegin(), partState->GetSizeInBytes(), partState->GetPartId());
+                        partState->SetDownloadBuffer(nullptr);
+                        onPart(handle, part);
+                    }
+                    else if (decryptor)
+                    {
+                        // the part stream spans the ciphertext, of which only the plain text at the start of the buffer goes out
+                        Aws::Utils::Stream::PreallocatedStreamBuf plaintextBuf(partState->GetDownloadBuffer(), partState->GetSizeInBytes());
+                        Aws::IOStream plaintextStream(&plaintextBuf);
+                        handle->WritePartToDownloadStream(&plaintextStream, partState->GetRangeBegin());
+                    }
+                    else
+                    {
+                        Aws::IOStream* bufferStream = partState->GetDownloadPartStream();
+                        assert(bufferStream);
+                        handle->WritePartToDownloadStream(bufferStream, partState->GetRangeBegin());
+                    }
                     handle->ChangePartToCompleted(partState, outcome.GetResult().GetETag());
+                    auto journal = handle->GetJournal();
+                    if (journal)
+                    {
+                        journal->RecordPart(partState->GetPartId(), outcome.GetResult().GetETag());
+                    }
                 }
                 else
                 {
@@ -902,26 +2270,41 @@ namespace Aws
                 }
             }
 
+            if (handle->ShouldContinue())
+            {
+                RecordPartTransfer(partState->GetSizeInBytes(), transferContext->startTime, outcome.IsSuccess());
+            }
+
             // buffer cleanup
             if(partState->GetDownloadBuffer())
             {
-                m_bufferManager.Release(partState->GetDownloadBuffer());
+                ReleasePartBuffer(partState->GetDownloadBuffer());
                 partState->SetDownloadBuffer(nullptr);
             }
 
             TriggerTransferStatusUpdatedCallback(handle);
 
-            PartStateMap pendingParts, queuedParts, failedParts, completedParts;
-            handle->GetAllPartsTransactional(queuedParts, pendingParts, failedParts, completedParts);
+            size_t pendingParts, queuedParts, failedParts, completedParts;
+            handle->GetPartCountsTransactional(queuedParts, pendingParts, failedParts, completedParts);
 
-            if (pendingParts.size() == 0 && queuedParts.size() == 0)
+            if (pendingParts == 0 && queuedParts == 0)
             {
-                if (failedParts.size() == 0 && handle->GetBytesTransferred() == handle->GetBytesTotalSize())
+                // the journal is settled before the status changes, since anyone waiting on the handle may start over as soon as it does
+                auto journal = handle->GetJournal();
+                if (failedParts == 0 && handle->GetBytesTransferred() == handle->GetBytesTotalSize())
                 {
+                    if (journal)
+                    {
+                        journal->Remove();
+                    }
                     handle->UpdateStatus(TransferStatus::COMPLETED);
                 }
                 else
                 {
+                    if (journal)
+                    {
+                        journal->Flush();
+                    }
                     handle->UpdateStatus(DetermineIfFailedOrCanceled(*handle));
                 }
                 TriggerTransferStatusUpdatedCallback(handle);
@@ -956,6 +2339,11 @@ namespace Aws
                             "] Successfully aborted multi-part upload. In Bucket: ["
                             << canceledHandle->GetBucketName() << "] with Key: [" << canceledHandle->GetKey()
                             << "] with Upload ID: [" << canceledHandle->GetMultiPartId() << "].");
+                    auto journal = canceledHandle->GetJournal();
+                    if (journal)
+                    {
+                        journal->Remove();
+                    }
                     canceledHandle->UpdateStatus(TransferStatus::ABORTED);
                     TriggerTransferStatusUpdatedCallback(canceledHandle);
                 }
@@ -1041,6 +2429,17 @@ namespace Aws
             }
         }
 
+        Aws::String TransferManager::DetermineKeyName(const Aws::String& prefix, const Aws::String& relativePath)
+        {
+            Aws::StringStream ssKey;
+            Aws::String keyPath = relativePath;
+            char delimiter[] = { Aws::FileSystem::PATH_DELIM, 0 };
+            Aws::Utils::StringUtils::Replace(keyPath, delimiter, "/");
+
+            ssKey << prefix << "/" << keyPath;
+            return ssKey.str();
+        }
+
         Aws::String TransferManager::DetermineFilePath(const Aws::String& directory, const Aws::String& prefix, const Aws::String& keyName)
         {
             Aws::String shortenedFileName = keyName;
@@ -227,6 +227,16 @@ function(add_sdks)
                 endif()
              endforeach()
         endif()
+
+        # benchmarks are standalone programs, built on request and never run by the build
+        if(ENABLE_BENCHMARKS)
+            foreach(SDK IN LISTS SDK_BUILD_LIST)
+                get_benchmark_project_for_service(${SDK} BENCHMARK_PROJECT)
+                if(BENCHMARK_PROJECT)
+                    add_subdirectory(${BENCHMARK_PROJECT})
+                endif()
+            endforeach()
+        endif()
     endif()
 
     # the catch-all config needs to list all the targets in a dependency-sorted order
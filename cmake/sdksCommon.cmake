@@ -47,6 +47,11 @@ function(get_test_projects_for_service SERVICE_NAME TEST_PROJECT_NAME_VAR)
     set(${TEST_PROJECT_NAME_VAR} "${TEMP_VAR}" PARENT_SCOPE)
 endfunction()
 
+function(get_benchmark_project_for_service SERVICE_NAME BENCHMARK_PROJECT_NAME_VAR)
+    get_map_element(${SERVICE_NAME} TEMP_VAR ${SDK_BENCHMARK_PROJECT_LIST})
+    set(${BENCHMARK_PROJECT_NAME_VAR} "${TEMP_VAR}" PARENT_SCOPE)
+endfunction()
+
 function(get_dependencies_for_sdk PROJECT_NAME DEPENDENCY_LIST_VAR)
     get_map_element(${PROJECT_NAME} TEMP_VAR ${SDK_DEPENDENCY_LIST})
     # "core" is the default dependency for every sdk. 
@@ -126,6 +131,8 @@ list(APPEND HIGH_LEVEL_SDK_LIST "queues")
 list(APPEND HIGH_LEVEL_SDK_LIST "transfer") 
 list(APPEND HIGH_LEVEL_SDK_LIST "s3-encryption") 
 list(APPEND HIGH_LEVEL_SDK_LIST "text-to-speech") 
+list(APPEND HIGH_LEVEL_SDK_LIST "dynamodb-batching") 
+list(APPEND HIGH_LEVEL_SDK_LIST "kinesis-streams") 
 
 set(SDK_TEST_PROJECT_LIST "")
 list(APPEND SDK_TEST_PROJECT_LIST "cognito-identity:aws-cpp-sdk-cognitoidentity-integration-tests")
@@ -141,14 +148,23 @@ list(APPEND SDK_TEST_PROJECT_LIST "s3-encryption:aws-cpp-sdk-s3-encryption-tests
 list(APPEND SDK_TEST_PROJECT_LIST "ec2:aws-cpp-sdk-ec2-integration-tests")
 list(APPEND SDK_TEST_PROJECT_LIST "core:aws-cpp-sdk-core-tests")
 list(APPEND SDK_TEST_PROJECT_LIST "text-to-speech:aws-cpp-sdk-text-to-speech-tests,aws-cpp-sdk-polly-sample")
+list(APPEND SDK_TEST_PROJECT_LIST "dynamodb-batching:aws-cpp-sdk-dynamodb-batching-tests")
+list(APPEND SDK_TEST_PROJECT_LIST "kinesis-streams:aws-cpp-sdk-kinesis-streams-tests")
+list(APPEND SDK_TEST_PROJECT_LIST "queues:aws-cpp-sdk-queues-tests")
+
+set(SDK_BENCHMARK_PROJECT_LIST "")
+list(APPEND SDK_BENCHMARK_PROJECT_LIST "core:aws-cpp-sdk-core-benchmarks")
+list(APPEND SDK_BENCHMARK_PROJECT_LIST "transfer:aws-cpp-sdk-transfer-benchmarks")
 
 set(SDK_DEPENDENCY_LIST "")
 list(APPEND SDK_DEPENDENCY_LIST "access-management:iam,cognito-identity,core")
 list(APPEND SDK_DEPENDENCY_LIST "identity-management:cognito-identity,sts,core")
 list(APPEND SDK_DEPENDENCY_LIST "queues:sqs,core")
 list(APPEND SDK_DEPENDENCY_LIST "transfer:s3,core")
-list(APPEND SDK_DEPENDENCY_LIST "s3-encryption:s3,kms,core")
+list(APPEND SDK_DEPENDENCY_LIST "s3-encryption:transfer,s3,kms,core")
 list(APPEND SDK_DEPENDENCY_LIST "text-to-speech:polly,core")
+list(APPEND SDK_DEPENDENCY_LIST "dynamodb-batching:dynamodb,core")
+list(APPEND SDK_DEPENDENCY_LIST "kinesis-streams:kinesis,core")
 
 set(TEST_DEPENDENCY_LIST "")
 list(APPEND TEST_DEPENDENCY_LIST "cognito-identity:access-management,iam,core")
@@ -156,9 +172,12 @@ list(APPEND TEST_DEPENDENCY_LIST "identity-management:cognito-identity,sts,core"
 list(APPEND TEST_DEPENDENCY_LIST "lambda:access-management,cognito-identity,iam,kinesis,core")
 list(APPEND TEST_DEPENDENCY_LIST "sqs:access-management,cognito-identity,iam,core")
 list(APPEND TEST_DEPENDENCY_LIST "transfer:s3,core")
-list(APPEND TEST_DEPENDENCY_LIST "s3-encryption:s3,kms,core")
+list(APPEND TEST_DEPENDENCY_LIST "s3-encryption:transfer,s3,kms,core")
 list(APPEND TEST_DEPENDENCY_LIST "s3control:access-management,cognito-identity,iam,core")
 list(APPEND TEST_DEPENDENCY_LIST "text-to-speech:polly,core")
+list(APPEND TEST_DEPENDENCY_LIST "dynamodb-batching:dynamodb,core")
+list(APPEND TEST_DEPENDENCY_LIST "kinesis-streams:kinesis,core")
+list(APPEND TEST_DEPENDENCY_LIST "queues:sqs,core")
 
 build_sdk_list()
 
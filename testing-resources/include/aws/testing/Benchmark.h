@@ -0,0 +1,51 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  * 
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  * 
+  *  http://aws.amazon.com/apache2.0
+  * 
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#pragma once
+
+#include <aws/testing/Testing_EXPORTS.h>
+
+#include <cstddef>
+
+namespace Aws
+{
+    namespace Testing
+    {
+        typedef void (*BenchmarkFunction)();
+
+        /**
+         * Adds a benchmark to the ones RunBenchmarks runs. Declare benchmarks with AWS_BENCHMARK rather than using this directly.
+         */
+        class AWS_TESTING_API BenchmarkRegistration
+        {
+        public:
+            BenchmarkRegistration(const char* name, BenchmarkFunction function);
+        };
+
+        /**
+         * Runs, in the order they were registered, the benchmarks whose name contains filter, or all of them if filter is null.
+         * Benchmarks print their own results to stdout. Returns the number of benchmarks run.
+         */
+        AWS_TESTING_API size_t RunBenchmarks(const char* filter);
+    }
+}
+
+/**
+ * Defines a benchmark, a function run by RunBenchmarks rather than by the unit tests, for measurements that depend on the machine.
+ */
+#define AWS_BENCHMARK(NAME) \
+    static void NAME(); \
+    static Aws::Testing::BenchmarkRegistration NAME##Registration(#NAME, NAME); \
+    static void NAME()
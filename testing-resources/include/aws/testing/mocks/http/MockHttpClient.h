@@ -19,11 +19,17 @@
 #include <aws/core/http/HttpClient.h>
 #include <aws/core/http/URI.h>
 #include <aws/core/http/standard/StandardHttpRequest.h>
+#include <aws/core/http/standard/StandardHttpResponse.h>
 #include <aws/core/http/HttpClientFactory.h>
+#include <aws/core/utils/StringUtils.h>
 #include <aws/core/utils/UnreferencedParam.h>
 #include <aws/core/utils/memory/stl/AWSVector.h>
 #include <aws/core/utils/memory/stl/AWSQueue.h>
 
+#include <chrono>
+#include <mutex>
+#include <thread>
+
 static const char* MockHttpAllocationTag = "MockHttp";
 
 class MockHttpClient : public Aws::Http::HttpClient
@@ -115,3 +121,140 @@ public:
 private:
     std::shared_ptr<MockHttpClient> m_clientToUse;
 };
+
+/**
+ * Thread safe mock that answers the n-th request made with the n-th configured response after that response's latency.
+ * While waiting it keeps checking whether the request should be aborted, the way a real client does from its transfer callbacks.
+ */
+class LatencyInjectingHttpClient : public Aws::Http::HttpClient
+{
+public:
+    LatencyInjectingHttpClient() : m_requestsMade(0) {}
+
+    std::shared_ptr<Aws::Http::HttpResponse> MakeRequest(Aws::Http::HttpRequest& request,
+                                                         Aws::Utils::RateLimits::RateLimiterInterface* readLimiter = nullptr,
+                                                         Aws::Utils::RateLimits::RateLimiterInterface* writeLimiter = nullptr) const override
+    {
+        AWS_UNREFERENCED_PARAM(request);
+        AWS_UNREFERENCED_PARAM(readLimiter);
+        AWS_UNREFERENCED_PARAM(writeLimiter);
+        assert(false); // should not use this overload. It's deprecated
+        return nullptr;
+    }
+
+    std::shared_ptr<Aws::Http::HttpResponse> MakeRequest(const std::shared_ptr<Aws::Http::HttpRequest>& request,
+                                                         Aws::Utils::RateLimits::RateLimiterInterface* readLimiter = nullptr,
+                                                         Aws::Utils::RateLimits::RateLimiterInterface* writeLimiter = nullptr) const override
+    {
+        AWS_UNREFERENCED_PARAM(readLimiter);
+        AWS_UNREFERENCED_PARAM(writeLimiter);
+
+        MockResponse mockResponse;
+        size_t requestIndex = 0;
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            requestIndex = m_requestsMade++;
+            if (requestIndex < m_responses.size())
+            {
+                mockResponse = m_responses[requestIndex];
+            }
+        }
+        const std::chrono::milliseconds latency = mockResponse.latency;
+        const Aws::Http::HttpResponseCode responseCode = mockResponse.responseCode;
+
+        auto response = Aws::MakeShared<Aws::Http::Standard::StandardHttpResponse>(MockHttpAllocationTag, request);
+        response->AddHeader("x-mock-request-index", Aws::Utils::StringUtils::to_string(requestIndex));
+
+        // the first half of the body arrives at once, the rest after the latency
+        const size_t firstHalf = mockResponse.body.size() / 2;
+        WriteBody(*request, *response, mockResponse.body.substr(0, firstHalf));
+
+        auto deadline = std::chrono::steady_clock::now() + latency;
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            if (!ContinueRequest(*request) || !IsRequestProcessingEnabled())
+            {
+                response->SetResponseCode(Aws::Http::HttpResponseCode::REQUEST_NOT_MADE);
+                return response;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        WriteBody(*request, *response, mockResponse.body.substr(firstHalf));
+        response->SetResponseCode(responseCode);
+        return response;
+    }
+
+    void AddResponse(std::chrono::milliseconds latency, Aws::Http::HttpResponseCode responseCode = Aws::Http::HttpResponseCode::OK,
+                     const Aws::String& body = "")
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        MockResponse mockResponse;
+        mockResponse.latency = latency;
+        mockResponse.responseCode = responseCode;
+        mockResponse.body = body;
+        m_responses.push_back(mockResponse);
+    }
+
+    size_t GetRequestsMade() const
+    {
+        std::lock_guard<std::mutex> locker(m_lock);
+        return m_requestsMade;
+    }
+
+private:
+    struct MockResponse
+    {
+        MockResponse() : latency(0), responseCode(Aws::Http::HttpResponseCode::OK) {}
+
+        std::chrono::milliseconds latency;
+        Aws::Http::HttpResponseCode responseCode;
+        Aws::String body;
+    };
+
+    static void WriteBody(const Aws::Http::HttpRequest& request, Aws::Http::HttpResponse& response, const Aws::String& data)
+    {
+        if (data.empty())
+        {
+            return;
+        }
+        response.GetResponseBody().write(data.c_str(), static_cast<std::streamsize>(data.size()));
+        response.GetResponseBody().flush();
+        if (request.GetDataReceivedEventHandler())
+        {
+            request.GetDataReceivedEventHandler()(&request, &response, static_cast<long long>(data.size()));
+        }
+    }
+
+    mutable std::mutex m_lock;
+    mutable size_t m_requestsMade;
+    Aws::Vector<MockResponse> m_responses;
+};
+
+class LatencyInjectingHttpClientFactory : public Aws::Http::HttpClientFactory
+{
+public:
+    explicit LatencyInjectingHttpClientFactory(const std::shared_ptr<LatencyInjectingHttpClient>& client) : m_clientToUse(client) {}
+
+    std::shared_ptr<Aws::Http::HttpClient> CreateHttpClient(const Aws::Client::ClientConfiguration& clientConfiguration) const override
+    {
+        AWS_UNREFERENCED_PARAM(clientConfiguration);
+        return m_clientToUse;
+    }
+
+    std::shared_ptr<Aws::Http::HttpRequest> CreateHttpRequest(const Aws::String& uri, Aws::Http::HttpMethod method, const Aws::IOStreamFactory& streamFactory) const override
+    {
+        return CreateHttpRequest(Aws::Http::URI(uri), method, streamFactory);
+    }
+
+    std::shared_ptr<Aws::Http::HttpRequest> CreateHttpRequest(const Aws::Http::URI& uri, Aws::Http::HttpMethod method, const Aws::IOStreamFactory& streamFactory) const override
+    {
+        auto request = Aws::MakeShared<Aws::Http::Standard::StandardHttpRequest>(MockHttpAllocationTag, uri, method);
+        request->SetResponseStreamFactory(streamFactory);
+
+        return request;
+    }
+
+private:
+    std::shared_ptr<LatencyInjectingHttpClient> m_clientToUse;
+};
@@ -0,0 +1,61 @@
+/*
+  * Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+  * 
+  * Licensed under the Apache License, Version 2.0 (the "License").
+  * You may not use this file except in compliance with the License.
+  * A copy of the License is located at
+  * 
+  *  http://aws.amazon.com/apache2.0
+  * 
+  * or in the "license" file accompanying this file. This file is distributed
+  * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+  * express or implied. See the License for the specific language governing
+  * permissions and limitations under the License.
+  */
+
+#include <aws/testing/Benchmark.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace Aws::Testing;
+
+namespace
+{
+    typedef std::vector<std::pair<const char*, BenchmarkFunction>> BenchmarkList;
+
+    // benchmarks register themselves during static initialization, before InitAPI, so the list can't use the SDK's allocator
+    BenchmarkList& GetBenchmarks()
+    {
+        static BenchmarkList benchmarks;
+        return benchmarks;
+    }
+}
+
+BenchmarkRegistration::BenchmarkRegistration(const char* name, BenchmarkFunction function)
+{
+    GetBenchmarks().emplace_back(name, function);
+}
+
+size_t Aws::Testing::RunBenchmarks(const char* filter)
+{
+    size_t run = 0;
+    for (const auto& benchmark : GetBenchmarks())
+    {
+        if (filter && !strstr(benchmark.first, filter))
+        {
+            continue;
+        }
+
+        std::cout << "[ RUN  ] " << benchmark.first << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        benchmark.second();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "[ DONE ] " << benchmark.first << " (" << elapsed.count() << " ms)" << std::endl;
+        ++run;
+    }
+    return run;
+}